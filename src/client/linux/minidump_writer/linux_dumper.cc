@@ -286,6 +286,7 @@ LinuxDumper::LinuxDumper(pid_t pid, const char* root_prefix)
       crash_signal_code_(0),
       crash_thread_(pid),
       threads_(&allocator_, 8),
+      thread_names_(&allocator_, 8),
       mappings_(&allocator_),
       auxv_(&allocator_, AT_MAX + 1) {
   assert(root_prefix_ && my_strlen(root_prefix_) < PATH_MAX);
@@ -538,6 +539,30 @@ bool LinuxDumper::ReadAuxv() {
   return res;
 }
 
+void LinuxDumper::ReadThreadName(pid_t tid) {
+  char* name = NULL;
+  char comm_path[NAME_MAX];
+  if (BuildProcPath(comm_path, tid, "comm")) {
+    const int fd = sys_open(comm_path, O_RDONLY, 0);
+    if (fd >= 0) {
+      // The kernel limits thread names to 15 characters, which comm
+      // follows with a newline.
+      char buffer[32];
+      const ssize_t bytes_read = sys_read(fd, buffer, sizeof(buffer));
+      sys_close(fd);
+      if (bytes_read > 0) {
+        size_t length = bytes_read;
+        if (buffer[length - 1] == '\n')
+          --length;
+        name = reinterpret_cast<char*>(allocator_.Alloc(length + 1));
+        my_memcpy(name, buffer, length);
+        name[length] = '\0';
+      }
+    }
+  }
+  thread_names_.push_back(name);
+}
+
 bool LinuxDumper::EnumerateMappings() {
   char maps_path[NAME_MAX];
   if (!BuildProcPath(maps_path, pid_, "maps"))
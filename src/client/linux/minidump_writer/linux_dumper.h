@@ -109,6 +109,12 @@ class LinuxDumper {
     return -1u;
   }
 
+  // Returns the name of the |index|-th thread of |threads_|, from
+  // /proc/<pid>/task/<tid>/comm, or NULL if it is not known.
+  const char* GetThreadNameByIndex(size_t index) const {
+    return index < thread_names_.size() ? thread_names_[index] : NULL;
+  }
+
   // These are only valid after a call to |Init|.
   const wasteful_vector<pid_t> &threads() { return threads_; }
   const wasteful_vector<MappingInfo*> &mappings() { return mappings_; }
@@ -221,6 +227,11 @@ class LinuxDumper {
 
   virtual bool EnumerateThreads() = 0;
 
+  // Reads the name of thread |tid| and appends it, or NULL if it can't be
+  // read, to |thread_names_|.  EnumerateThreads() calls this for each
+  // thread it appends to |threads_|, if it can find the threads' names.
+  void ReadThreadName(pid_t tid);
+
   // For the case where a running program has been deleted, it'll show up in
   // /proc/pid/maps as "/path/to/program (deleted)". If this is the case, then
   // see if '/path/to/program (deleted)' matches /proc/pid/exe and return
@@ -258,6 +269,10 @@ class LinuxDumper {
   // IDs of all the threads.
   wasteful_vector<pid_t> threads_;
 
+  // Names of the threads in |threads_|, in the same order.  This is empty
+  // if the threads' names are not known.
+  wasteful_vector<char*> thread_names_;
+
   // Info from /proc/<pid>/maps.
   wasteful_vector<MappingInfo*> mappings_;
 
@@ -321,8 +321,11 @@ bool LinuxPtraceDumper::ThreadsSuspend() {
       if (i < threads_.size() - 1) {
         my_memmove(&threads_[i], &threads_[i + 1],
                    (threads_.size() - i - 1) * sizeof(threads_[i]));
+        my_memmove(&thread_names_[i], &thread_names_[i + 1],
+                   (thread_names_.size() - i - 1) * sizeof(thread_names_[i]));
       }
       threads_.resize(threads_.size() - 1);
+      thread_names_.resize(thread_names_.size() - 1);
       --i;
     }
   }
@@ -341,7 +344,7 @@ bool LinuxPtraceDumper::ThreadsResume() {
 }
 
 // Parse /proc/$pid/task to list all the threads of the process identified by
-// pid.
+// pid, along with their names.
 bool LinuxPtraceDumper::EnumerateThreads() {
   char task_path[NAME_MAX];
   if (!BuildProcPath(task_path, pid_, "task"))
@@ -364,6 +367,7 @@ bool LinuxPtraceDumper::EnumerateThreads() {
           last_tid != tid) {
         last_tid = tid;
         threads_.push_back(tid);
+        ReadThreadName(tid);
       }
     }
     dir_reader->PopEntry();
@@ -210,6 +210,48 @@ TEST_F(LinuxPtraceDumperChildTest, ThreadList) {
   ASSERT_TRUE(found);
 }
 
+/* Fixture that names the test's thread before forking the child that
+ * dumps it. */
+class LinuxPtraceDumperThreadNameTest : public LinuxPtraceDumperChildTest {
+ protected:
+  virtual void SetUp() {
+    memset(old_name_, 0, sizeof(old_name_));
+    prctl(PR_GET_NAME, old_name_);
+    prctl(PR_SET_NAME, kThreadName);
+    LinuxPtraceDumperChildTest::SetUp();
+  }
+
+  virtual void TearDown() {
+    prctl(PR_SET_NAME, old_name_);
+  }
+
+  static const char kThreadName[];
+
+ private:
+  // PR_GET_NAME fills in up to 16 bytes.
+  char old_name_[16];
+};
+
+const char LinuxPtraceDumperThreadNameTest::kThreadName[] = "dumper-test";
+
+TEST_F(LinuxPtraceDumperThreadNameTest, ThreadNames) {
+  LinuxPtraceDumper dumper(getppid());
+  ASSERT_TRUE(dumper.Init());
+
+  bool found = false;
+  for (size_t i = 0; i < dumper.threads().size(); ++i) {
+    // Every thread's name can be read from /proc.
+    ASSERT_TRUE(dumper.GetThreadNameByIndex(i) != NULL);
+    if (dumper.threads()[i] == getppid()) {
+      // The name has no trailing newline.
+      EXPECT_STREQ(kThreadName, dumper.GetThreadNameByIndex(i));
+      found = true;
+    }
+  }
+  ASSERT_TRUE(found);
+  EXPECT_TRUE(dumper.GetThreadNameByIndex(dumper.threads().size()) == NULL);
+}
+
 // Helper stack class to close a file descriptor and unmap
 // a mmap'ed mapping.
 class StackHelper {
@@ -219,7 +219,7 @@ class MinidumpWriter {
   bool Dump() {
     // A minidump file contains a number of tagged streams. This is the number
     // of stream which we write.
-    unsigned kNumWriters = 13;
+    unsigned kNumWriters = 14;
 
     TypedMDRVA<MDRawDirectory> dir(&minidump_writer_);
     {
@@ -308,6 +308,10 @@ class MinidumpWriter {
       NullifyDirectoryEntry(&dirent);
     dir.CopyIndex(dir_index++, &dirent);
 
+    if (!WriteThreadNameListStream(&dirent))
+      NullifyDirectoryEntry(&dirent);
+    dir.CopyIndex(dir_index++, &dirent);
+
     // If you add more directory entries, don't forget to update kNumWriters,
     // above.
 
@@ -512,6 +516,47 @@ class MinidumpWriter {
     return true;
   }
 
+  // Write the names of the threads, for those threads whose names are known.
+  // Returns false if no names are known.
+  bool WriteThreadNameListStream(MDRawDirectory* dirent) {
+    const unsigned num_threads = dumper_->threads().size();
+    unsigned num_names = 0;
+    for (unsigned i = 0; i < num_threads; ++i) {
+      if (dumper_->GetThreadNameByIndex(i))
+        ++num_names;
+    }
+    if (num_names == 0)
+      return false;
+
+    TypedMDRVA<uint32_t> list(&minidump_writer_);
+    if (!list.AllocateObjectAndArray(num_names, sizeof(MDRawThreadName)))
+      return false;
+
+    dirent->stream_type = MD_THREAD_NAME_LIST_STREAM;
+    dirent->location = list.location();
+
+    *list.get() = num_names;
+
+    unsigned name_index = 0;
+    for (unsigned i = 0; i < num_threads; ++i) {
+      const char* name = dumper_->GetThreadNameByIndex(i);
+      if (!name)
+        continue;
+
+      MDLocationDescriptor location;
+      if (!minidump_writer_.WriteString(name, 0, &location))
+        return false;
+
+      MDRawThreadName thread_name;
+      thread_name.thread_id = dumper_->threads()[i];
+      thread_name.thread_name_rva = location.rva;
+      list.CopyIndexAfterObject(name_index++, &thread_name,
+                                sizeof(thread_name));
+    }
+
+    return true;
+  }
+
   // Write application-provided memory regions.
   bool WriteAppMemory() {
     for (AppMemoryList::const_iterator iter = app_memory_list_.begin();
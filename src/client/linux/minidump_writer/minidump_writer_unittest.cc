@@ -29,6 +29,7 @@
 
 #include <fcntl.h>
 #include <poll.h>
+#include <sys/prctl.h>
 #include <sys/stat.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
@@ -61,6 +62,18 @@ typedef testing::Test MinidumpWriterTest;
 
 const char kMDWriterUnitTestFileName[] = "/minidump-writer-unittest";
 
+// Names the calling thread "md-worker", tells the test so by writing to the
+// pipe whose write end |data| points to, and waits to be killed.
+void* NameThreadAndWait(void* data) {
+  prctl(PR_SET_NAME, "md-worker");
+  const int fd = *static_cast<int*>(data);
+  IGNORE_RET(HANDLE_EINTR(write(fd, "a", 1)));
+  sigset_t sigset;
+  sigemptyset(&sigset);
+  sigsuspend(&sigset);
+  return NULL;
+}
+
 TEST(MinidumpWriterTest, SetupWithPath) {
   int fds[2];
   ASSERT_NE(-1, pipe(fds));
@@ -676,6 +689,79 @@ TEST(MinidumpWriterTest, AdditionalMemory) {
   IGNORE_EINTR(waitpid(child, nullptr, 0));
 }
 
+// Test that the names of the threads are written to the minidump.
+TEST(MinidumpWriterTest, ThreadNames) {
+  int fds[2];
+  ASSERT_NE(-1, pipe(fds));
+  int ready_fds[2];
+  ASSERT_NE(-1, pipe(ready_fds));
+
+  const pid_t child = fork();
+  if (child == 0) {
+    close(fds[1]);
+    close(ready_fds[0]);
+    prctl(PR_SET_NAME, "md-main");
+
+    pthread_t thread;
+    pthread_attr_t thread_attributes;
+    pthread_attr_init(&thread_attributes);
+    pthread_attr_setdetachstate(&thread_attributes, PTHREAD_CREATE_DETACHED);
+    pthread_create(&thread, &thread_attributes, &NameThreadAndWait,
+                   &ready_fds[1]);
+
+    char b;
+    IGNORE_RET(HANDLE_EINTR(read(fds[0], &b, sizeof(b))));
+    close(fds[0]);
+    syscall(__NR_exit_group);
+  }
+  close(fds[0]);
+  close(ready_fds[1]);
+
+  // Wait until the child's second thread has named itself.
+  char b;
+  ASSERT_EQ(1, HANDLE_EINTR(read(ready_fds[0], &b, sizeof(b))));
+  close(ready_fds[0]);
+
+  ExceptionHandler::CrashContext context;
+  memset(&context, 0, sizeof(context));
+  ASSERT_EQ(0, getcontext(&context.context));
+  context.tid = child;
+
+  AutoTempDir temp_dir;
+  string templ = temp_dir.path() + kMDWriterUnitTestFileName;
+  ASSERT_TRUE(WriteMinidump(templ.c_str(), child, &context, sizeof(context)));
+
+  Minidump minidump(templ);
+  ASSERT_TRUE(minidump.Read());
+
+  MinidumpThreadList* threads = minidump.GetThreadList();
+  ASSERT_TRUE(threads);
+  MinidumpThreadNameList* thread_names = minidump.GetThreadNameList();
+  ASSERT_TRUE(thread_names);
+  // Every thread's name can be read from /proc.
+  EXPECT_EQ(threads->thread_count(), thread_names->thread_name_count());
+
+  string name;
+  ASSERT_TRUE(thread_names->GetThreadNameByID(child, &name));
+  EXPECT_EQ("md-main", name);
+
+  // The other thread's ID is only known from the minidump.
+  bool found_worker = false;
+  for (unsigned int i = 0; i < thread_names->thread_name_count(); ++i) {
+    uint32_t thread_id;
+    ASSERT_TRUE(thread_names->GetThreadNameAtIndex(i, &thread_id, &name));
+    EXPECT_TRUE(threads->GetThreadByID(thread_id));
+    if (name == "md-worker") {
+      EXPECT_NE(static_cast<uint32_t>(child), thread_id);
+      found_worker = true;
+    }
+  }
+  EXPECT_TRUE(found_worker);
+
+  close(fds[1]);
+  IGNORE_EINTR(waitpid(child, nullptr, 0));
+}
+
 // Test that an invalid thread stack pointer still results in a minidump.
 TEST(MinidumpWriterTest, InvalidStackPointer) {
   int fds[2];
@@ -126,6 +126,12 @@ struct DwarfCUToModule::FilePrivate {
   SpecificationByOffset specifications;
 
   AbstractOriginByOffset origins;
+
+  // A map from offsets of abstract origin DIEs to the Module's
+  // InlineOrigins for them. An inlined subroutine DIE may cite its origin
+  // before the origin's own DIE has been seen, so entries are created by
+  // whichever comes first, and named when the origin's DIE is finished.
+  map<uint64_t, Module::InlineOrigin *> inline_origins;
 };
 
 DwarfCUToModule::FileContext::FileContext(const string &filename,
@@ -134,6 +140,7 @@ DwarfCUToModule::FileContext::FileContext(const string &filename,
     : filename_(filename),
       module_(module),
       handle_inter_cu_refs_(handle_inter_cu_refs),
+      saw_inter_cu_reference_(false),
       file_private_(new FilePrivate()) {
 }
 
@@ -166,6 +173,40 @@ bool DwarfCUToModule::FileContext::IsUnhandledInterCUReference(
   return offset < compilation_unit_start;
 }
 
+void DwarfCUToModule::FileContext::NoteReference(
+    uint64_t offset, uint64_t compilation_unit_start,
+    uint64_t compilation_unit_end) {
+  if (offset < compilation_unit_start || offset >= compilation_unit_end)
+    saw_inter_cu_reference_ = true;
+}
+
+void DwarfCUToModule::FileContext::MergeFrom(FileContext *other) {
+  assert(!other->saw_inter_cu_reference_);
+  FilePrivate *mine = file_private_.get();
+  FilePrivate *theirs = other->file_private_.get();
+
+  // Specifications and abstract origins are only ever looked up by the
+  // compilation units that follow, so merely carry them over.
+  if (handle_inter_cu_refs_)
+    mine->specifications.insert(theirs->specifications.begin(),
+                                theirs->specifications.end());
+  mine->origins.insert(theirs->origins.begin(), theirs->origins.end());
+
+  // An inline origin this context has already created was cited by a
+  // compilation unit processed here before OTHER's own DIE for it could
+  // name it; give it the name OTHER found.
+  for (map<uint64_t, Module::InlineOrigin *>::iterator it =
+           theirs->inline_origins.begin();
+       it != theirs->inline_origins.end(); ++it) {
+    std::pair<map<uint64_t, Module::InlineOrigin *>::iterator, bool> ret =
+        mine->inline_origins.insert(*it);
+    if (!ret.second)
+      ret.first->second->name = it->second->name;
+  }
+
+  module_->TakeFunctions(other->module_);
+}
+
 // Information global to the particular compilation unit we're
 // parsing. This is for data shared across the CU's entire DIE tree,
 // and parameters from the code invoking the CU parser.
@@ -176,6 +217,7 @@ struct DwarfCUToModule::CUContext {
         reporter(reporter_arg),
         ranges_handler(ranges_handler_arg),
         language(Language::CPlusPlus),
+        end_offset(0),
         low_pc(0),
         high_pc(0),
         ranges(0) {}
@@ -199,6 +241,10 @@ struct DwarfCUToModule::CUContext {
   // The source language of this compilation unit.
   const Language *language;
 
+  // The offset in .debug_info just past the end of this compilation unit.
+  // The unit itself begins at reporter->cu_offset().
+  uint64_t end_offset;
+
   // Addresses covered by this CU. If high_pc_ is non-zero then the CU covers
   // low_pc to high_pc, otherwise ranges is non-zero and low_pc represents
   // the base address of the ranges covered by the CU.
@@ -216,6 +262,10 @@ struct DwarfCUToModule::CUContext {
   // Keep a list of forward references from DW_AT_abstract_origin and
   // DW_AT_specification attributes so names can be fixed up.
   std::map<uint64_t, Module::Function *> forward_ref_die_to_func;
+
+  // The file table of this compilation unit's line number program, for
+  // resolving DW_AT_call_file attributes.
+  map<uint32_t, Module::File *> files;
 };
 
 // Information about the context of a particular DIE. This is for
@@ -279,6 +329,24 @@ class DwarfCUToModule::GenericDIEHandler: public dwarf2reader::DIEHandler {
   // have been seen.
   string ComputeQualifiedName();
 
+  // Return the InlineOrigin for the abstract origin DIE at OFFSET,
+  // creating it if this is the first reference to that DIE.
+  Module::InlineOrigin *FindInlineOrigin(uint64_t offset);
+
+  // Tell our FileContext that this DIE refers to the DIE at OFFSET.
+  void NoteReference(uint64_t offset) {
+    cu_context_->file_context->NoteReference(
+        offset, cu_context_->reporter->cu_offset(), cu_context_->end_offset);
+  }
+
+  // Compute the address ranges covered by a DIE whose DW_AT_low_pc,
+  // DW_AT_high_pc and DW_AT_ranges attributes have the given values,
+  // and store them in RANGES. HAS_RANGES is false if the DIE has no
+  // DW_AT_ranges attribute.
+  void ReadRanges(uint64_t low_pc, uint64_t high_pc, DwarfForm high_pc_form,
+                  bool has_ranges, uint64_t ranges_offset,
+                  vector<Module::Range> *ranges);
+
   CUContext *cu_context_;
   DIEContext *parent_context_;
   uint64_t offset_;
@@ -341,6 +409,7 @@ void DwarfCUToModule::GenericDIEHandler::ProcessAttributeReference(
         cu_context_->reporter->UnhandledInterCUReference(offset_, data);
         break;
       }
+      NoteReference(data);
       // Find the Specification to which this attribute refers, and
       // set specification_ appropriately. We could do more processing
       // here, but it's better to leave the real work to our
@@ -463,6 +532,56 @@ string DwarfCUToModule::GenericDIEHandler::ComputeQualifiedName() {
   return return_value;
 }
 
+Module::InlineOrigin *DwarfCUToModule::GenericDIEHandler::FindInlineOrigin(
+    uint64_t offset) {
+  NoteReference(offset);
+  map<uint64_t, Module::InlineOrigin *> *origins =
+      &cu_context_->file_context->file_private_->inline_origins;
+  map<uint64_t, Module::InlineOrigin *>::iterator it = origins->find(offset);
+  if (it != origins->end())
+    return it->second;
+  Module::InlineOrigin *origin =
+      cu_context_->file_context->module_->AddInlineOrigin("<name omitted>");
+  (*origins)[offset] = origin;
+  return origin;
+}
+
+void DwarfCUToModule::GenericDIEHandler::ReadRanges(
+    uint64_t low_pc, uint64_t high_pc, DwarfForm high_pc_form,
+    bool has_ranges, uint64_t ranges_offset, vector<Module::Range> *ranges) {
+  if (!has_ranges) {
+    // Make high_pc an address, if it isn't already.
+    if (high_pc_form != dwarf2reader::DW_FORM_addr &&
+        high_pc_form != dwarf2reader::DW_FORM_GNU_addr_index) {
+      high_pc += low_pc;
+    }
+
+    Module::Range range(low_pc, high_pc - low_pc);
+    ranges->push_back(range);
+  } else {
+    RangesHandler *ranges_handler = cu_context_->ranges_handler;
+
+    if (ranges_handler) {
+      if (!ranges_handler->ReadRanges(ranges_offset, cu_context_->low_pc,
+                                      ranges)) {
+        ranges->clear();
+        cu_context_->reporter->MalformedRangeList(ranges_offset);
+      }
+    } else {
+      cu_context_->reporter->MissingRanges();
+    }
+  }
+}
+
+// Delete the Inlines in INLINES, and clear it.
+static void DeleteInlines(vector<Module::Inline *> *inlines) {
+  for (vector<Module::Inline *>::iterator it = inlines->begin();
+       it != inlines->end(); ++it) {
+    delete *it;
+  }
+  inlines->clear();
+}
+
 // A handler class for DW_TAG_subprogram DIEs.
 class DwarfCUToModule::FuncHandler: public GenericDIEHandler {
  public:
@@ -470,7 +589,8 @@ class DwarfCUToModule::FuncHandler: public GenericDIEHandler {
               uint64_t offset)
       : GenericDIEHandler(cu_context, parent_context, offset),
         low_pc_(0), high_pc_(0), high_pc_form_(dwarf2reader::DW_FORM_addr),
-        ranges_(0), abstract_origin_(NULL), inline_(false) { }
+        has_ranges_(false), ranges_(0), abstract_origin_(NULL),
+        inline_(false) { }
   void ProcessAttributeUnsigned(enum DwarfAttribute attr,
                                 enum DwarfForm form,
                                 uint64_t data);
@@ -482,6 +602,7 @@ class DwarfCUToModule::FuncHandler: public GenericDIEHandler {
                                  uint64_t data);
 
   bool EndAttributes();
+  DIEHandler *FindChildHandler(uint64_t offset, enum DwarfTag tag);
   void Finish();
 
  private:
@@ -490,9 +611,16 @@ class DwarfCUToModule::FuncHandler: public GenericDIEHandler {
   string name_;
   uint64_t low_pc_, high_pc_; // DW_AT_low_pc, DW_AT_high_pc
   DwarfForm high_pc_form_; // DW_AT_high_pc can be length or address.
-  uint64_t ranges_; // DW_AT_ranges
+  // DW_AT_ranges. A range list may start at offset zero in .debug_ranges,
+  // so note separately whether the attribute is present.
+  bool has_ranges_;
+  uint64_t ranges_;
   const AbstractOrigin* abstract_origin_;
   bool inline_;
+
+  // The functions inlined directly into this one, gathered by our
+  // children's handlers.
+  vector<Module::Inline *> inlines_;
 };
 
 void DwarfCUToModule::FuncHandler::ProcessAttributeUnsigned(
@@ -511,6 +639,7 @@ void DwarfCUToModule::FuncHandler::ProcessAttributeUnsigned(
       high_pc_ = data;
       break;
     case dwarf2reader::DW_AT_ranges:
+      has_ranges_ = true;
       ranges_ = data;
       break;
 
@@ -541,6 +670,7 @@ void DwarfCUToModule::FuncHandler::ProcessAttributeReference(
     uint64_t data) {
   switch (attr) {
     case dwarf2reader::DW_AT_abstract_origin: {
+      NoteReference(data);
       const AbstractOriginByOffset& origins =
           cu_context_->file_context->file_private_->origins;
       AbstractOriginByOffset::const_iterator origin = origins.find(data);
@@ -590,27 +720,8 @@ void DwarfCUToModule::FuncHandler::Finish() {
       iter->second->name = name_;
   }
 
-  if (!ranges_) {
-    // Make high_pc_ an address, if it isn't already.
-    if (high_pc_form_ != dwarf2reader::DW_FORM_addr &&
-        high_pc_form_ != dwarf2reader::DW_FORM_GNU_addr_index) {
-      high_pc_ += low_pc_;
-    }
-
-    Module::Range range(low_pc_, high_pc_ - low_pc_);
-    ranges.push_back(range);
-  } else {
-    RangesHandler *ranges_handler = cu_context_->ranges_handler;
-
-    if (ranges_handler) {
-      if (!ranges_handler->ReadRanges(ranges_, cu_context_->low_pc, &ranges)) {
-        ranges.clear();
-        cu_context_->reporter->MalformedRangeList(ranges_);
-      }
-    } else {
-      cu_context_->reporter->MissingRanges();
-    }
-  }
+  ReadRanges(low_pc_, high_pc_, high_pc_form_, has_ranges_, ranges_,
+             &ranges);
 
   // Did we collect the information we need?  Not all DWARF function
   // entries are non-empty (for example, inlined functions that were never
@@ -638,6 +749,7 @@ void DwarfCUToModule::FuncHandler::Finish() {
     scoped_ptr<Module::Function> func(new Module::Function(name, low_pc_));
     func->ranges = ranges;
     func->parameter_size = 0;
+    func->inlines.swap(inlines_);
     if (func->address) {
       // If the function address is zero this is a sign that this function
       // description is just empty debug data and should just be discarded.
@@ -656,6 +768,172 @@ void DwarfCUToModule::FuncHandler::Finish() {
   } else if (inline_) {
     AbstractOrigin origin(name_);
     cu_context_->file_context->file_private_->origins[offset_] = origin;
+    if (!name_.empty())
+      FindInlineOrigin(offset_)->name = name_;
+  }
+
+  // If this function was discarded, so are the functions inlined into it.
+  DeleteInlines(&inlines_);
+}
+
+// A handler class for DW_TAG_lexical_block DIEs within functions. We
+// don't record the blocks themselves, but they may contain inlined
+// subroutines, which belong to the enclosing function or inline.
+class DwarfCUToModule::LexicalBlockHandler: public GenericDIEHandler {
+ public:
+  LexicalBlockHandler(CUContext *cu_context, DIEContext *parent_context,
+                      uint64_t offset, vector<Module::Inline *> *inlines)
+      : GenericDIEHandler(cu_context, parent_context, offset),
+        inlines_(inlines) { }
+  bool EndAttributes() { return true; }
+  DIEHandler *FindChildHandler(uint64_t offset, enum DwarfTag tag);
+
+ private:
+  // The enclosing function's or inline's list of inlines.
+  vector<Module::Inline *> *inlines_;
+};
+
+// A handler class for DW_TAG_inlined_subroutine DIEs: a copy of an
+// inline function's body, placed at a particular call site.
+class DwarfCUToModule::InlineHandler: public GenericDIEHandler {
+ public:
+  // Create a handler for the inlined subroutine DIE at OFFSET, which
+  // will add the Module::Inline it builds to INLINES, the list of
+  // inlines belonging to the enclosing function or inline.
+  InlineHandler(CUContext *cu_context, DIEContext *parent_context,
+                uint64_t offset, vector<Module::Inline *> *inlines)
+      : GenericDIEHandler(cu_context, parent_context, offset),
+        low_pc_(0), high_pc_(0), high_pc_form_(dwarf2reader::DW_FORM_addr),
+        has_ranges_(false), ranges_(0), call_file_(0), call_line_(0),
+        origin_(NULL),
+        inlines_(inlines) { }
+  void ProcessAttributeUnsigned(enum DwarfAttribute attr,
+                                enum DwarfForm form,
+                                uint64_t data);
+  void ProcessAttributeReference(enum DwarfAttribute attr,
+                                 enum DwarfForm form,
+                                 uint64_t data);
+  bool EndAttributes() { return true; }
+  DIEHandler *FindChildHandler(uint64_t offset, enum DwarfTag tag);
+  void Finish();
+
+ private:
+  uint64_t low_pc_, high_pc_; // DW_AT_low_pc, DW_AT_high_pc
+  DwarfForm high_pc_form_; // DW_AT_high_pc can be length or address.
+  // DW_AT_ranges. A range list may start at offset zero in .debug_ranges,
+  // so note separately whether the attribute is present.
+  bool has_ranges_;
+  uint64_t ranges_;
+  uint64_t call_file_, call_line_; // DW_AT_call_file, DW_AT_call_line
+  Module::InlineOrigin *origin_; // DW_AT_abstract_origin
+
+  // The list to which we add our Module::Inline, and the functions
+  // inlined into this one, gathered by our children's handlers.
+  vector<Module::Inline *> *inlines_;
+  vector<Module::Inline *> child_inlines_;
+};
+
+void DwarfCUToModule::InlineHandler::ProcessAttributeUnsigned(
+    enum DwarfAttribute attr,
+    enum DwarfForm form,
+    uint64_t data) {
+  switch (attr) {
+    case dwarf2reader::DW_AT_low_pc:      low_pc_  = data; break;
+    case dwarf2reader::DW_AT_high_pc:
+      high_pc_form_ = form;
+      high_pc_ = data;
+      break;
+    case dwarf2reader::DW_AT_ranges:
+      has_ranges_ = true;
+      ranges_ = data;
+      break;
+    case dwarf2reader::DW_AT_call_file:   call_file_ = data; break;
+    case dwarf2reader::DW_AT_call_line:   call_line_ = data; break;
+    default:
+      GenericDIEHandler::ProcessAttributeUnsigned(attr, form, data);
+      break;
+  }
+}
+
+void DwarfCUToModule::InlineHandler::ProcessAttributeReference(
+    enum DwarfAttribute attr,
+    enum DwarfForm form,
+    uint64_t data) {
+  switch (attr) {
+    case dwarf2reader::DW_AT_abstract_origin:
+      origin_ = FindInlineOrigin(data);
+      break;
+    default:
+      GenericDIEHandler::ProcessAttributeReference(attr, form, data);
+      break;
+  }
+}
+
+dwarf2reader::DIEHandler *DwarfCUToModule::InlineHandler::FindChildHandler(
+    uint64_t offset,
+    enum DwarfTag tag) {
+  switch (tag) {
+    case dwarf2reader::DW_TAG_inlined_subroutine:
+      return new InlineHandler(cu_context_, parent_context_, offset,
+                               &child_inlines_);
+    case dwarf2reader::DW_TAG_lexical_block:
+      return new LexicalBlockHandler(cu_context_, parent_context_, offset,
+                                     &child_inlines_);
+    default:
+      return NULL;
+  }
+}
+
+void DwarfCUToModule::InlineHandler::Finish() {
+  vector<Module::Range> ranges;
+  ReadRanges(low_pc_, high_pc_, high_pc_form_, has_ranges_, ranges_,
+             &ranges);
+
+  // An inlined subroutine that was optimized away entirely covers no
+  // code, and neither do any inlined into it.
+  if (IsEmptyRange(ranges) || !origin_) {
+    DeleteInlines(&child_inlines_);
+    return;
+  }
+
+  Module::File *call_site_file = NULL;
+  map<uint32_t, Module::File *>::const_iterator file =
+      cu_context_->files.find(call_file_);
+  if (file != cu_context_->files.end())
+    call_site_file = file->second;
+
+  Module::Inline *in = new Module::Inline(origin_, ranges, call_line_,
+                                          call_site_file);
+  in->child_inlines.swap(child_inlines_);
+  inlines_->push_back(in);
+}
+
+dwarf2reader::DIEHandler *
+DwarfCUToModule::LexicalBlockHandler::FindChildHandler(uint64_t offset,
+                                                       enum DwarfTag tag) {
+  switch (tag) {
+    case dwarf2reader::DW_TAG_inlined_subroutine:
+      return new InlineHandler(cu_context_, parent_context_, offset, inlines_);
+    case dwarf2reader::DW_TAG_lexical_block:
+      return new LexicalBlockHandler(cu_context_, parent_context_, offset,
+                                     inlines_);
+    default:
+      return NULL;
+  }
+}
+
+dwarf2reader::DIEHandler *DwarfCUToModule::FuncHandler::FindChildHandler(
+    uint64_t offset,
+    enum DwarfTag tag) {
+  switch (tag) {
+    case dwarf2reader::DW_TAG_inlined_subroutine:
+      return new InlineHandler(cu_context_, parent_context_, offset,
+                               &inlines_);
+    case dwarf2reader::DW_TAG_lexical_block:
+      return new LexicalBlockHandler(cu_context_, parent_context_, offset,
+                                     &inlines_);
+    default:
+      return NULL;
   }
 }
 
@@ -697,7 +975,7 @@ dwarf2reader::DIEHandler *DwarfCUToModule::NamedScopeHandler::FindChildHandler(
 void DwarfCUToModule::WarningReporter::CUHeading() {
   if (printed_cu_header_)
     return;
-  fprintf(stderr, "%s: in compilation unit '%s' (offset 0x%" PRIx64 "):\n",
+  fprintf(output_, "%s: in compilation unit '%s' (offset 0x%" PRIx64 "):\n",
           filename_.c_str(), cu_name_.c_str(), cu_offset_);
   printed_cu_header_ = true;
 }
@@ -705,7 +983,7 @@ void DwarfCUToModule::WarningReporter::CUHeading() {
 void DwarfCUToModule::WarningReporter::UnknownSpecification(uint64_t offset,
                                                             uint64_t target) {
   CUHeading();
-  fprintf(stderr, "%s: the DIE at offset 0x%" PRIx64 " has a "
+  fprintf(output_, "%s: the DIE at offset 0x%" PRIx64 " has a "
           "DW_AT_specification attribute referring to the DIE at offset 0x%"
           PRIx64 ", which was not marked as a declaration\n",
           filename_.c_str(), offset, target);
@@ -714,7 +992,7 @@ void DwarfCUToModule::WarningReporter::UnknownSpecification(uint64_t offset,
 void DwarfCUToModule::WarningReporter::UnknownAbstractOrigin(uint64_t offset,
                                                              uint64_t target) {
   CUHeading();
-  fprintf(stderr, "%s: the DIE at offset 0x%" PRIx64 " has a "
+  fprintf(output_, "%s: the DIE at offset 0x%" PRIx64 " has a "
           "DW_AT_abstract_origin attribute referring to the DIE at offset 0x%"
           PRIx64 ", which was not marked as an inline\n",
           filename_.c_str(), offset, target);
@@ -722,13 +1000,13 @@ void DwarfCUToModule::WarningReporter::UnknownAbstractOrigin(uint64_t offset,
 
 void DwarfCUToModule::WarningReporter::MissingSection(const string &name) {
   CUHeading();
-  fprintf(stderr, "%s: warning: couldn't find DWARF '%s' section\n",
+  fprintf(output_, "%s: warning: couldn't find DWARF '%s' section\n",
           filename_.c_str(), name.c_str());
 }
 
 void DwarfCUToModule::WarningReporter::BadLineInfoOffset(uint64_t offset) {
   CUHeading();
-  fprintf(stderr, "%s: warning: line number data offset beyond end"
+  fprintf(output_, "%s: warning: line number data offset beyond end"
           " of '.debug_line' section\n",
           filename_.c_str());
 }
@@ -737,7 +1015,7 @@ void DwarfCUToModule::WarningReporter::UncoveredHeading() {
   if (printed_unpaired_header_)
     return;
   CUHeading();
-  fprintf(stderr, "%s: warning: skipping unpaired lines/functions:\n",
+  fprintf(output_, "%s: warning: skipping unpaired lines/functions:\n",
           filename_.c_str());
   printed_unpaired_header_ = true;
 }
@@ -747,7 +1025,7 @@ void DwarfCUToModule::WarningReporter::UncoveredFunction(
   if (!uncovered_warnings_enabled_)
     return;
   UncoveredHeading();
-  fprintf(stderr, "    function%s: %s\n",
+  fprintf(output_, "    function%s: %s\n",
           IsEmptyRange(function.ranges) ? " (zero-length)" : "",
           function.name.c_str());
 }
@@ -756,27 +1034,28 @@ void DwarfCUToModule::WarningReporter::UncoveredLine(const Module::Line &line) {
   if (!uncovered_warnings_enabled_)
     return;
   UncoveredHeading();
-  fprintf(stderr, "    line%s: %s:%d at 0x%" PRIx64 "\n",
+  fprintf(output_, "    line%s: %s:%d at 0x%" PRIx64 "\n",
           (line.size == 0 ? " (zero-length)" : ""),
           line.file->name.c_str(), line.number, line.address);
 }
 
 void DwarfCUToModule::WarningReporter::UnnamedFunction(uint64_t offset) {
   CUHeading();
-  fprintf(stderr, "%s: warning: function at offset 0x%" PRIx64 " has no name\n",
+  fprintf(output_,
+          "%s: warning: function at offset 0x%" PRIx64 " has no name\n",
           filename_.c_str(), offset);
 }
 
 void DwarfCUToModule::WarningReporter::DemangleError(const string &input) {
   CUHeading();
-  fprintf(stderr, "%s: warning: failed to demangle %s\n",
+  fprintf(output_, "%s: warning: failed to demangle %s\n",
           filename_.c_str(), input.c_str());
 }
 
 void DwarfCUToModule::WarningReporter::UnhandledInterCUReference(
     uint64_t offset, uint64_t target) {
   CUHeading();
-  fprintf(stderr, "%s: warning: the DIE at offset 0x%" PRIx64 " has a "
+  fprintf(output_, "%s: warning: the DIE at offset 0x%" PRIx64 " has a "
                   "DW_FORM_ref_addr attribute with an inter-CU reference to "
                   "0x%" PRIx64 ", but inter-CU reference handling is turned "
                   " off.\n", filename_.c_str(), offset, target);
@@ -784,14 +1063,14 @@ void DwarfCUToModule::WarningReporter::UnhandledInterCUReference(
 
 void DwarfCUToModule::WarningReporter::MalformedRangeList(uint64_t offset) {
   CUHeading();
-  fprintf(stderr, "%s: warning: the range list at offset 0x%" PRIx64 " falls "
+  fprintf(output_, "%s: warning: the range list at offset 0x%" PRIx64 " falls "
                   " out of the .debug_ranges section.\n",
                   filename_.c_str(), offset);
 }
 
 void DwarfCUToModule::WarningReporter::MissingRanges() {
   CUHeading();
-  fprintf(stderr, "%s: warning: A DW_AT_ranges attribute was encountered but "
+  fprintf(output_, "%s: warning: A DW_AT_ranges attribute was encountered but "
                   "the .debug_ranges section is missing.\n", filename_.c_str());
 }
 
@@ -862,6 +1141,12 @@ void DwarfCUToModule::ProcessAttributeString(enum DwarfAttribute attr,
 }
 
 bool DwarfCUToModule::EndAttributes() {
+  // Read source line info now, if we have any, so that the handlers for
+  // our children can resolve DW_AT_call_file attributes using its file
+  // table. Assembly language files have no function data, and so no use
+  // for their line numbers; see Finish.
+  if (has_source_line_info_ && cu_context_->language->HasFunctions())
+    ReadSourceLines(source_line_offset_);
   return true;
 }
 
@@ -946,7 +1231,8 @@ void DwarfCUToModule::ReadSourceLines(uint64_t offset) {
     return;
   }
   line_reader_->ReadProgram(section_start + offset, section_length - offset,
-                            cu_context_->file_context->module_, &lines_);
+                            cu_context_->file_context->module_, &lines_,
+                            &cu_context_->files);
 }
 
 namespace {
@@ -1206,10 +1492,6 @@ void DwarfCUToModule::Finish() {
   if (!cu_context_->language->HasFunctions())
     return;
 
-  // Read source line info, if we have any.
-  if (has_source_line_info_)
-    ReadSourceLines(source_line_offset_);
-
   vector<Module::Function *> *functions = &cu_context_->functions;
 
   // Dole out lines to the appropriate functions.
@@ -1232,6 +1514,8 @@ bool DwarfCUToModule::StartCompilationUnit(uint64_t offset,
                                            uint8_t offset_size,
                                            uint64_t cu_length,
                                            uint8_t dwarf_version) {
+  // CU_LENGTH doesn't include the initial length field itself.
+  cu_context_->end_offset = offset + cu_length + (offset_size == 8 ? 12 : 4);
   return dwarf_version >= 2;
 }
 
@@ -40,6 +40,7 @@
 #define COMMON_LINUX_DWARF_CU_TO_MODULE_H__
 
 #include <stdint.h>
+#include <stdio.h>
 
 #include <string>
 
@@ -94,9 +95,29 @@ class DwarfCUToModule: public dwarf2reader::RootDIEHandler {
 
     const dwarf2reader::SectionMap& section_map() const;
 
+    // Return true if a compilation unit incorporated into this file
+    // context referred to a DIE outside itself: a specification, an
+    // abstract origin, or the origin of an inlined subroutine in some
+    // other compilation unit.
+    bool saw_inter_cu_reference() const { return saw_inter_cu_reference_; }
+
+    // Incorporate the compilation units OTHER has processed into this
+    // file context, as if they had been processed here, after those this
+    // context has already processed. OTHER must be a context for the same
+    // file whose compilation units referred to nothing outside themselves;
+    // this moves the functions and inline origins of OTHER's module into
+    // this context's module. OTHER is left empty of both.
+    void MergeFrom(FileContext *other);
+
    private:
     friend class DwarfCUToModule;
 
+    // Note a reference to the DIE at OFFSET from the compilation unit
+    // occupying [COMPILATION_UNIT_START, COMPILATION_UNIT_END) of the
+    // .debug_info section.
+    void NoteReference(uint64_t offset, uint64_t compilation_unit_start,
+                       uint64_t compilation_unit_end);
+
     // Clears all the Specifications if HANDLE_INTER_CU_REFS_ is false.
     void ClearSpecifications();
 
@@ -119,6 +140,10 @@ class DwarfCUToModule: public dwarf2reader::RootDIEHandler {
     // True if we are handling references between compilation units.
     const bool handle_inter_cu_refs_;
 
+    // True if NoteReference has seen a reference between compilation
+    // units.
+    bool saw_inter_cu_reference_;
+
     // Inter-compilation unit data used internally by the handlers.
     scoped_ptr<FilePrivate> file_private_;
   };
@@ -157,28 +182,33 @@ class DwarfCUToModule: public dwarf2reader::RootDIEHandler {
     // Populate MODULE and LINES with source file names and code/line
     // mappings, given a pointer to some DWARF line number data
     // PROGRAM, and an overestimate of its size. Add no zero-length
-    // lines to LINES.
+    // lines to LINES. Populate FILES with the program's file table,
+    // mapping DWARF file numbers to the files added to MODULE.
     virtual void ReadProgram(const uint8_t *program, uint64_t length,
-                             Module *module, vector<Module::Line> *lines) = 0;
+                             Module *module, vector<Module::Line> *lines,
+                             map<uint32_t, Module::File *> *files) = 0;
   };
 
   // The interface DwarfCUToModule uses to report warnings. The member
-  // function definitions for this class write messages to stderr, but
-  // you can override them if you'd like to detect or report these
-  // conditions yourself.
+  // function definitions for this class write messages to stderr, or to
+  // the stream given to set_output, but you can override them if you'd
+  // like to detect or report these conditions yourself.
   class WarningReporter {
    public:
     // Warn about problems in the DWARF file FILENAME, in the
     // compilation unit at OFFSET.
     WarningReporter(const string &filename, uint64_t cu_offset)
-        : filename_(filename), cu_offset_(cu_offset), printed_cu_header_(false),
-          printed_unpaired_header_(false),
+        : filename_(filename), cu_offset_(cu_offset), output_(stderr),
+          printed_cu_header_(false), printed_unpaired_header_(false),
           uncovered_warnings_enabled_(false) { }
     virtual ~WarningReporter() { }
 
     // Set the name of the compilation unit we're processing to NAME.
     virtual void SetCUName(const string &name) { cu_name_ = name; }
 
+    // Write warnings to OUTPUT instead of stderr.
+    void set_output(FILE *output) { output_ = output; }
+
     // Accessor and setter for uncovered_warnings_enabled_.
     // UncoveredFunction and UncoveredLine only report a problem if that is
     // true. By default, these warnings are disabled, because those
@@ -239,6 +269,7 @@ class DwarfCUToModule: public dwarf2reader::RootDIEHandler {
    protected:
     const string filename_;
     const uint64_t cu_offset_;
+    FILE *output_;
     string cu_name_;
     bool printed_cu_header_;
     bool printed_unpaired_header_;
@@ -292,6 +323,8 @@ class DwarfCUToModule: public dwarf2reader::RootDIEHandler {
   struct Specification;
   class GenericDIEHandler;
   class FuncHandler;
+  class InlineHandler;
+  class LexicalBlockHandler;
   class NamedScopeHandler;
 
   // A map from section offsets to specifications.
@@ -42,6 +42,7 @@
 #include "common/using_std_string.h"
 
 using std::make_pair;
+using std::map;
 using std::vector;
 
 using dwarf2reader::DIEHandler;
@@ -55,8 +56,10 @@ using google_breakpad::Module;
 
 using ::testing::_;
 using ::testing::AtMost;
+using ::testing::DoAll;
 using ::testing::Invoke;
 using ::testing::Return;
+using ::testing::SetArgPointee;
 using ::testing::Test;
 using ::testing::TestWithParam;
 using ::testing::Values;
@@ -67,8 +70,15 @@ using ::testing::ValuesIn;
 class MockLineToModuleHandler: public DwarfCUToModule::LineToModuleHandler {
  public:
   MOCK_METHOD1(StartCompilationUnit, void(const string& compilation_dir));
-  MOCK_METHOD4(ReadProgram, void(const uint8_t *program, uint64_t length,
-                                 Module *module, vector<Module::Line> *lines));
+  MOCK_METHOD5(ReadProgram, void(const uint8_t *program, uint64_t length,
+                                 Module *module, vector<Module::Line> *lines,
+                                 map<uint32_t, Module::File *> *files));
+};
+
+class MockRangesHandler: public DwarfCUToModule::RangesHandler {
+ public:
+  MOCK_METHOD3(ReadRanges, bool(uint64_t offset, Module::Address base_address,
+                                vector<Module::Range> *ranges));
 };
 
 class MockWarningReporter: public DwarfCUToModule::WarningReporter {
@@ -99,26 +109,30 @@ class CUFixtureBase {
   //
   // then doing:
   //
-  //   appender(line_program, length, module, line_vector);
+  //   appender(line_program, length, module, line_vector, file_map);
   //
   // will append lines to the end of line_vector.  We can use this with
   // MockLineToModuleHandler like this:
   //
   //   MockLineToModuleHandler l2m;
-  //   EXPECT_CALL(l2m, ReadProgram(_,_,_,_))
+  //   EXPECT_CALL(l2m, ReadProgram(_,_,_,_,_))
   //       .WillOnce(DoAll(Invoke(appender), Return()));
   //
   // in which case calling l2m with some line vector will append lines.
   class AppendLinesFunctor {
    public:
-    explicit AppendLinesFunctor(
-        const vector<Module::Line> *lines) : lines_(lines) { }
+    AppendLinesFunctor(const vector<Module::Line> *lines,
+                       const map<uint32_t, Module::File *> *files)
+        : lines_(lines), files_(files) { }
     void operator()(const uint8_t *program, uint64_t length,
-                    Module *module, vector<Module::Line> *lines) {
+                    Module *module, vector<Module::Line> *lines,
+                    map<uint32_t, Module::File *> *files) {
       lines->insert(lines->end(), lines_->begin(), lines_->end());
+      *files = *files_;
     }
    private:
     const vector<Module::Line> *lines_;
+    const map<uint32_t, Module::File *> *files_;
   };
 
   CUFixtureBase()
@@ -126,10 +140,10 @@ class CUFixtureBase {
         file_context_("dwarf-filename", &module_, true),
         language_(dwarf2reader::DW_LANG_none),
         language_signed_(false),
-        appender_(&lines_),
+        appender_(&lines_, &line_files_),
         reporter_("dwarf-filename", 0xcf8f9bb6443d29b5LL),
-        root_handler_(&file_context_, &line_reader_,
-                      /* ranges_reader */ nullptr, &reporter_),
+        root_handler_(&file_context_, &line_reader_, &ranges_handler_,
+                      &reporter_),
         functions_filled_(false) {
     // By default, expect no warnings to be reported, and expect the
     // compilation unit's name to be provided. The test can override
@@ -147,7 +161,7 @@ class CUFixtureBase {
     // By default, expect the line program reader not to be invoked. We
     // may override this in StartCU.
     EXPECT_CALL(line_reader_, StartCompilationUnit(_)).Times(0);
-    EXPECT_CALL(line_reader_, ReadProgram(_,_,_,_)).Times(0);
+    EXPECT_CALL(line_reader_, ReadProgram(_,_,_,_,_)).Times(0);
 
     // The handler will consult this section map to decide what to
     // pass to our line reader.
@@ -285,12 +299,19 @@ class CUFixtureBase {
   // provided lines array.
   vector<Module::Line> lines_;
 
+  // The file table line_reader_ reports for the line program, mapping
+  // DWARF file numbers to files.
+  map<uint32_t, Module::File *> line_files_;
+
   // Mock line program reader.
   MockLineToModuleHandler line_reader_;
   AppendLinesFunctor appender_;
   static const uint8_t dummy_line_program_[];
   static const size_t dummy_line_size_;
 
+  // Mock range list reader.
+  MockRangesHandler ranges_handler_;
+
   MockWarningReporter reporter_;
   DwarfCUToModule root_handler_;
 
@@ -332,7 +353,7 @@ void CUFixtureBase::StartCU() {
   if (!lines_.empty())
     EXPECT_CALL(line_reader_,
                 ReadProgram(&dummy_line_program_[0], dummy_line_size_,
-                            &module_, _))
+                            &module_, _, _))
         .Times(AtMost(1))
         .WillOnce(DoAll(Invoke(appender_), Return()));
 
@@ -682,6 +703,34 @@ TEST_F(SimpleCU, OneFuncHighPcIsLength) {
            246571772);
 }
 
+// A function whose range list starts at the very beginning of
+// .debug_ranges has a DW_AT_ranges attribute of zero.
+TEST_F(SimpleCU, RangesAtOffsetZero) {
+  PushLine(0x4ce1d82ce9fa4c5fULL, 0x30, "line-file", 61234);
+
+  vector<Module::Range> ranges;
+  ranges.push_back(Module::Range(0x4ce1d82ce9fa4c5fULL, 0x30));
+  EXPECT_CALL(ranges_handler_, ReadRanges(0, _, _))
+      .WillOnce(DoAll(SetArgPointee<2>(ranges), Return(true)));
+
+  StartCU();
+  DIEHandler *func = root_handler_.FindChildHandler(
+      0x9d3ac73c92d1ff3aULL, dwarf2reader::DW_TAG_subprogram);
+  ASSERT_TRUE(func != NULL);
+  func->ProcessAttributeString(dwarf2reader::DW_AT_name,
+                               dwarf2reader::DW_FORM_strp, "function1");
+  func->ProcessAttributeUnsigned(dwarf2reader::DW_AT_ranges,
+                                 dwarf2reader::DW_FORM_sec_offset, 0);
+  EXPECT_TRUE(func->EndAttributes());
+  func->Finish();
+  delete func;
+  root_handler_.Finish();
+
+  TestFunctionCount(1);
+  TestFunction(0, "function1", 0x4ce1d82ce9fa4c5fULL, 0x30);
+  TestLineCount(0, 1);
+}
+
 TEST_F(SimpleCU, MangledName) {
   PushLine(0x938cf8c07def4d34ULL, 0x55592d727f6cd01fLL, "line-file", 246571772);
 
@@ -1509,7 +1558,7 @@ TEST_F(Specifications, InterCU) {
   DwarfCUToModule::FileContext fc("dwarf-filename", &m, true);
   EXPECT_CALL(reporter_, UncoveredFunction(_)).WillOnce(Return());
   MockLineToModuleHandler lr;
-  EXPECT_CALL(lr, ReadProgram(_,_,_,_)).Times(0);
+  EXPECT_CALL(lr, ReadProgram(_,_,_,_,_)).Times(0);
 
   // Kludge: satisfy reporter_'s expectation.
   reporter_.SetCUName("compilation-unit-name");
@@ -1568,7 +1617,7 @@ TEST_F(Specifications, UnhandledInterCU) {
   DwarfCUToModule::FileContext fc("dwarf-filename", &m, false);
   EXPECT_CALL(reporter_, UncoveredFunction(_)).WillOnce(Return());
   MockLineToModuleHandler lr;
-  EXPECT_CALL(lr, ReadProgram(_,_,_,_)).Times(0);
+  EXPECT_CALL(lr, ReadProgram(_,_,_,_,_)).Times(0);
 
   // Kludge: satisfy reporter_'s expectation.
   reporter_.SetCUName("compilation-unit-name");
@@ -1714,6 +1763,111 @@ TEST_F(Specifications, PreferSpecificationParents) {
                0xbbd9d54dce3b95b7ULL, 0x39188b7b52b0899fULL);
 }
 
+class Inlines: public CUFixtureBase, public Test {
+ public:
+  // Start a DW_TAG_inlined_subroutine DIE as a child of PARENT, covering
+  // SIZE bytes at ADDRESS, whose abstract origin is the DIE at ORIGIN and
+  // whose call site is line CALL_LINE of file number CALL_FILE. Leave the
+  // handler ready to hear about children.
+  DIEHandler *StartInlineDIE(DIEHandler *parent, uint64_t origin,
+                             Module::Address address, Module::Address size,
+                             uint64_t call_file, uint64_t call_line) {
+    DIEHandler *die = parent->FindChildHandler(
+        0x7d3a9e8c5b0f1d2eULL, dwarf2reader::DW_TAG_inlined_subroutine);
+    EXPECT_TRUE(die != NULL);
+    if (!die)
+      return NULL;
+    die->ProcessAttributeReference(dwarf2reader::DW_AT_abstract_origin,
+                                   dwarf2reader::DW_FORM_ref4, origin);
+    die->ProcessAttributeUnsigned(dwarf2reader::DW_AT_low_pc,
+                                  dwarf2reader::DW_FORM_addr, address);
+    die->ProcessAttributeUnsigned(dwarf2reader::DW_AT_high_pc,
+                                  dwarf2reader::DW_FORM_data4, size);
+    die->ProcessAttributeUnsigned(dwarf2reader::DW_AT_call_file,
+                                  dwarf2reader::DW_FORM_data1, call_file);
+    die->ProcessAttributeUnsigned(dwarf2reader::DW_AT_call_line,
+                                  dwarf2reader::DW_FORM_data1, call_line);
+    EXPECT_TRUE(die->EndAttributes());
+    return die;
+  }
+
+  // Finish and delete HANDLER.
+  void FinishDIE(DIEHandler *handler) {
+    handler->Finish();
+    delete handler;
+  }
+};
+
+TEST_F(Inlines, Nested) {
+  PushLine(0x1000, 0x100, "caller.cc", 10);
+  line_files_[1] = module_.FindFile("caller.cc");
+  line_files_[2] = module_.FindFile("inline.h");
+
+  StartCU();
+  // The outer inline's origin comes first; the inner one's is a forward
+  // reference, named only once its DIE has been seen.
+  AbstractInstanceDIE(&root_handler_, 0x100, dwarf2reader::DW_INL_inlined,
+                      0, "outer_inlinee");
+
+  DIEHandler *func = root_handler_.FindChildHandler(
+      0x200, dwarf2reader::DW_TAG_subprogram);
+  ASSERT_TRUE(func != NULL);
+  func->ProcessAttributeString(dwarf2reader::DW_AT_name,
+                               dwarf2reader::DW_FORM_strp, "caller");
+  func->ProcessAttributeUnsigned(dwarf2reader::DW_AT_low_pc,
+                                 dwarf2reader::DW_FORM_addr, 0x1000);
+  func->ProcessAttributeUnsigned(dwarf2reader::DW_AT_high_pc,
+                                 dwarf2reader::DW_FORM_addr, 0x1100);
+  ASSERT_TRUE(func->EndAttributes());
+  {
+    DIEHandler *outer = StartInlineDIE(func, 0x100, 0x1010, 0x40, 1, 42);
+    ASSERT_TRUE(outer != NULL);
+    {
+      // An inline nested within a lexical block belongs to the
+      // enclosing inline.
+      DIEHandler *block = outer->FindChildHandler(
+          0x300, dwarf2reader::DW_TAG_lexical_block);
+      ASSERT_TRUE(block != NULL);
+      ASSERT_TRUE(block->EndAttributes());
+      DIEHandler *inner = StartInlineDIE(block, 0x500, 0x1020, 0x8, 2, 7);
+      ASSERT_TRUE(inner != NULL);
+      FinishDIE(inner);
+      // An inline that was optimized away is dropped.
+      DIEHandler *empty = StartInlineDIE(block, 0x500, 0x1030, 0, 2, 8);
+      ASSERT_TRUE(empty != NULL);
+      FinishDIE(empty);
+      FinishDIE(block);
+    }
+    FinishDIE(outer);
+  }
+  FinishDIE(func);
+  AbstractInstanceDIE(&root_handler_, 0x500, dwarf2reader::DW_INL_inlined,
+                      0, "inner_inlinee");
+  root_handler_.Finish();
+
+  TestFunctionCount(1);
+  TestFunction(0, "caller", 0x1000, 0x100);
+  vector<Module::Function *> functions;
+  module_.GetFunctions(&functions, functions.end());
+  ASSERT_EQ(1U, functions[0]->inlines.size());
+  Module::Inline *outer = functions[0]->inlines[0];
+  EXPECT_EQ("outer_inlinee", outer->origin->name);
+  ASSERT_EQ(1U, outer->ranges.size());
+  EXPECT_EQ(0x1010U, outer->ranges[0].address);
+  EXPECT_EQ(0x40U, outer->ranges[0].size);
+  EXPECT_EQ(42, outer->call_site_line);
+  EXPECT_EQ(line_files_[1], outer->call_site_file);
+  ASSERT_EQ(1U, outer->child_inlines.size());
+  Module::Inline *inner = outer->child_inlines[0];
+  EXPECT_EQ("inner_inlinee", inner->origin->name);
+  ASSERT_EQ(1U, inner->ranges.size());
+  EXPECT_EQ(0x1020U, inner->ranges[0].address);
+  EXPECT_EQ(0x8U, inner->ranges[0].size);
+  EXPECT_EQ(7, inner->call_site_line);
+  EXPECT_EQ(line_files_[2], inner->call_site_file);
+  EXPECT_EQ(0U, inner->child_inlines.size());
+}
+
 class CUErrors: public CUFixtureBase, public Test { };
 
 TEST_F(CUErrors, BadStmtList) {
@@ -132,6 +132,15 @@ class DwarfLineToModule: public dwarf2reader::LineInfoHandler {
   
   ~DwarfLineToModule() { }
 
+  // A table mapping file numbers to Module::File pointers.
+  typedef std::map<uint32_t, Module::File *> FileTable;
+
+  // The table mapping the file numbers the line number program defined to
+  // the files added to MODULE.  Callers use this to resolve other DWARF
+  // references to file numbers, such as DW_AT_call_file attributes.
+  const FileTable &files() const { return files_; }
+
+
   void DefineDir(const string &name, uint32_t dir_num);
   void DefineFile(const string &name, int32_t file_num,
                   uint32_t dir_num, uint64_t mod_time,
@@ -142,7 +151,6 @@ class DwarfLineToModule: public dwarf2reader::LineInfoHandler {
  private:
 
   typedef std::map<uint32_t, string> DirectoryTable;
-  typedef std::map<uint32_t, Module::File *> FileTable;
 
   // The module we're contributing debugging info to. Owned by our
   // client.
@@ -47,10 +47,17 @@
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <zlib.h>
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <new>
 #include <set>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -62,6 +69,7 @@
 #include "common/dwarf_range_list_handler.h"
 #include "common/linux/crc32.h"
 #include "common/linux/eintr_wrapper.h"
+#include "common/linux/elf_gnu_compat.h"
 #include "common/linux/elfutils.h"
 #include "common/linux/elfutils-inl.h"
 #include "common/linux/elf_symbols_to_module.h"
@@ -199,6 +207,219 @@ vector<Module::Range> GetPtLoadSegmentRanges(
   return ranges;
 }
 
+// Inflate the zlib stream of IN_SIZE bytes at IN into the OUT_SIZE bytes
+// at OUT, which it must fill exactly. Return true on success. The data is
+// fed to zlib in pieces, as its lengths are only 32 bits wide.
+bool InflateZlibStream(const uint8_t* in, uint64_t in_size,
+                       uint8_t* out, uint64_t out_size) {
+  const uint64_t kMaxPiece = std::numeric_limits<uInt>::max();
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  if (inflateInit(&stream) != Z_OK)
+    return false;
+  stream.next_in = const_cast<Bytef*>(in);
+  stream.next_out = out;
+  int status = Z_OK;
+  while (status == Z_OK) {
+    if (stream.avail_in == 0) {
+      stream.avail_in = static_cast<uInt>(std::min(in_size, kMaxPiece));
+      in_size -= stream.avail_in;
+    }
+    if (stream.avail_out == 0) {
+      stream.avail_out = static_cast<uInt>(std::min(out_size, kMaxPiece));
+      out_size -= stream.avail_out;
+    }
+    status = inflate(&stream, Z_NO_FLUSH);
+  }
+  bool filled = stream.avail_out == 0 && out_size == 0;
+  inflateEnd(&stream);
+  return status == Z_STREAM_END && filled;
+}
+
+//
+// SectionContents
+//
+// Finds the contents of an ELF file's sections, inflating compressed
+// debugging sections. A section may be compressed in either of two ways:
+// it may have the SHF_COMPRESSED flag, and begin with an Elf_Chdr giving
+// the compression type and the contents' size; or, by the older GNU
+// convention, it may be named ".zdebug_*" instead of ".debug_*", and begin
+// with "ZLIB" and the contents' size as a big-endian 64-bit number. Only
+// zlib compression is supported.
+//
+// A compressed section is inflated when it is first asked for, and the
+// buffer kept until this object is destroyed.
+//
+template<typename ElfClass>
+class SectionContents {
+ public:
+  typedef typename ElfClass::Chdr Chdr;
+  typedef typename ElfClass::Ehdr Ehdr;
+  typedef typename ElfClass::Shdr Shdr;
+  typedef typename ElfClass::Word Word;
+
+  SectionContents(const string& obj_file, const Ehdr* elf_header)
+      : obj_file_(obj_file),
+        elf_header_(elf_header),
+        sections_(GetOffset<ElfClass, Shdr>(elf_header,
+                                            elf_header->e_shoff)),
+        names_(GetOffset<ElfClass, char>(
+            elf_header, sections_[elf_header->e_shstrndx].sh_offset)),
+        names_end_(names_ + sections_[elf_header->e_shstrndx].sh_size) { }
+
+  ~SectionContents() {
+    for (typename InflatedMap::iterator it = inflated_.begin();
+         it != inflated_.end(); ++it) {
+      delete[] it->second.contents;
+    }
+  }
+
+  // Return the name of SECTION, giving a ".zdebug_*" section the name of
+  // the ".debug_*" section it stands for.
+  string Name(const Shdr* section) const {
+    const char* name = names_ + section->sh_name;
+    if (IsZdebug(section))
+      return string(".") + (name + 2);
+    return name;
+  }
+
+  // Find the section named NAME of type SECTION_TYPE, or failing that, if
+  // NAME begins with ".debug_", the ".zdebug_" section standing for it.
+  // Return NULL if there is neither.
+  const Shdr* Find(const char* name, Word section_type) const {
+    const Shdr* section =
+        FindElfSectionByName<ElfClass>(name, section_type, sections_, names_,
+                                       names_end_, elf_header_->e_shnum);
+    if (!section && strncmp(name, ".debug_", 7) == 0) {
+      string zdebug_name = string(".z") + (name + 1);
+      section = FindElfSectionByName<ElfClass>(zdebug_name.c_str(),
+                                               section_type, sections_,
+                                               names_, names_end_,
+                                               elf_header_->e_shnum);
+    }
+    return section;
+  }
+
+  // Return true if SECTION's contents are compressed.
+  bool IsCompressed(const Shdr* section) const {
+    return (section->sh_flags & SHF_COMPRESSED) || IsZdebug(section);
+  }
+
+  // Set *CONTENTS and *SIZE to the contents of SECTION, inflating them if
+  // SECTION is compressed and hasn't been inflated already. Return false,
+  // having reported the problem, if they can't be inflated.
+  bool Get(const Shdr* section, const uint8_t** contents, uint64_t* size) {
+    if (!IsCompressed(section)) {
+      *contents = GetOffset<ElfClass, uint8_t>(elf_header_,
+                                               section->sh_offset);
+      *size = section->sh_size;
+      return true;
+    }
+    vector<const Shdr*> sections(1, section);
+    Inflate(sections, 1);
+    const Inflated& inflated = inflated_[section];
+    *contents = inflated.contents;
+    *size = inflated.size;
+    return inflated.contents != NULL;
+  }
+
+  // Inflate those of SECTIONS that are compressed and haven't been inflated
+  // already, on up to THREADS threads at once.
+  void Inflate(const vector<const Shdr*>& sections, int threads) {
+    vector<std::pair<const Shdr*, Inflated*> > pending;
+    for (size_t i = 0; i < sections.size(); ++i) {
+      if (!IsCompressed(sections[i]) || inflated_.count(sections[i]))
+        continue;
+      Inflated* inflated = &inflated_[sections[i]];
+      inflated->contents = NULL;
+      inflated->size = 0;
+      pending.push_back(std::make_pair(sections[i], inflated));
+    }
+
+    if (threads <= 1 || pending.size() <= 1) {
+      for (size_t i = 0; i < pending.size(); ++i)
+        InflateSection(pending[i].first, pending[i].second);
+    } else {
+      std::atomic<size_t> next(0);
+      vector<std::thread> workers;
+      for (int i = 0; i < threads && static_cast<size_t>(i) < pending.size();
+           ++i) {
+        workers.push_back(std::thread([&]() {
+          for (size_t j = next++; j < pending.size(); j = next++)
+            InflateSection(pending[j].first, pending[j].second);
+        }));
+      }
+      for (size_t i = 0; i < workers.size(); ++i)
+        workers[i].join();
+    }
+
+    for (size_t i = 0; i < pending.size(); ++i) {
+      if (!pending[i].second->contents) {
+        fprintf(stderr, "%s: failed to inflate compressed section %s\n",
+                obj_file_.c_str(), names_ + pending[i].first->sh_name);
+      }
+    }
+  }
+
+ private:
+  // An inflated section's contents, or NULL if they couldn't be inflated.
+  struct Inflated {
+    uint8_t* contents;
+    uint64_t size;
+  };
+  typedef std::map<const Shdr*, Inflated> InflatedMap;
+
+  bool IsZdebug(const Shdr* section) const {
+    return strncmp(names_ + section->sh_name, ".zdebug_", 8) == 0;
+  }
+
+  // Inflate SECTION's contents into INFLATED. This is called on worker
+  // threads, and so may touch nothing but INFLATED.
+  void InflateSection(const Shdr* section, Inflated* inflated) const {
+    const uint8_t* data =
+        GetOffset<ElfClass, uint8_t>(elf_header_, section->sh_offset);
+    uint64_t data_size = section->sh_size;
+    uint64_t size;
+    if (section->sh_flags & SHF_COMPRESSED) {
+      Chdr header;
+      if (data_size < sizeof(header))
+        return;
+      memcpy(&header, data, sizeof(header));
+      if (header.ch_type != ELFCOMPRESS_ZLIB)
+        return;
+      size = header.ch_size;
+      data += sizeof(header);
+      data_size -= sizeof(header);
+    } else {
+      const size_t kZdebugHeaderSize = 12;
+      if (data_size < kZdebugHeaderSize || memcmp(data, "ZLIB", 4) != 0)
+        return;
+      size = 0;
+      for (int i = 4; i < 12; i++)
+        size = (size << 8) | data[i];
+      data += kZdebugHeaderSize;
+      data_size -= kZdebugHeaderSize;
+    }
+
+    uint8_t* contents = new(std::nothrow) uint8_t[size];
+    if (!contents)
+      return;
+    if (!InflateZlibStream(data, data_size, contents, size)) {
+      delete[] contents;
+      return;
+    }
+    inflated->contents = contents;
+    inflated->size = size;
+  }
+
+  const string obj_file_;
+  const Ehdr* elf_header_;
+  const Shdr* sections_;
+  const char* names_;
+  const char* names_end_;
+  InflatedMap inflated_;
+};
+
 #ifndef NO_STABS_SUPPORT
 template<typename ElfClass>
 bool LoadStabs(const typename ElfClass::Ehdr* elf_header,
@@ -263,62 +484,153 @@ class DumperLineToModule: public DwarfCUToModule::LineToModuleHandler {
     compilation_dir_ = compilation_dir;
   }
   void ReadProgram(const uint8_t *program, uint64_t length,
-                   Module* module, std::vector<Module::Line>* lines) {
+                   Module* module, std::vector<Module::Line>* lines,
+                   std::map<uint32_t, Module::File*>* files) {
     DwarfLineToModule handler(module, compilation_dir_, lines);
     dwarf2reader::LineInfo parser(program, length, byte_reader_, &handler);
     parser.Start();
+    *files = handler.files();
   }
  private:
   string compilation_dir_;
   dwarf2reader::ByteReader *byte_reader_;
 };
 
+// Process the compilation unit at OFFSET in the .debug_info section of
+// FILE_CONTEXT's file, adding what it defines to FILE_CONTEXT's module and
+// writing any warnings to WARNINGS. Return the size of the compilation unit.
+uint64_t LoadDwarfCompilationUnit(const string& dwarf_filename,
+                                  DwarfCUToModule::FileContext* file_context,
+                                  dwarf2reader::Endianness endianness,
+                                  uint64_t offset,
+                                  FILE* warnings) {
+  dwarf2reader::ByteReader byte_reader(endianness);
+
+  // Optional .debug_ranges reader
+  scoped_ptr<DumperRangesHandler> ranges_handler;
+  dwarf2reader::SectionMap::const_iterator ranges_entry =
+      file_context->section_map().find(".debug_ranges");
+  if (ranges_entry != file_context->section_map().end()) {
+    const std::pair<const uint8_t *, uint64_t>& ranges_section =
+      ranges_entry->second;
+    ranges_handler.reset(
+      new DumperRangesHandler(ranges_section.first, ranges_section.second,
+                              &byte_reader));
+  }
+
+  DumperLineToModule line_to_module(&byte_reader);
+  // Make a handler for the root DIE that populates MODULE with the
+  // data that was found.
+  DwarfCUToModule::WarningReporter reporter(dwarf_filename, offset);
+  reporter.set_output(warnings);
+  DwarfCUToModule root_handler(file_context, &line_to_module,
+                               ranges_handler.get(), &reporter);
+  // Make a Dwarf2Handler that drives the DIEHandler.
+  dwarf2reader::DIEDispatcher die_dispatcher(&root_handler);
+  // Make a DWARF parser for the compilation unit at OFFSET.
+  dwarf2reader::CompilationUnit reader(dwarf_filename,
+                                       file_context->section_map(),
+                                       offset,
+                                       &byte_reader,
+                                       &die_dispatcher);
+  // Process the entire compilation unit.
+  return reader.Start();
+}
+
+// The work of processing one compilation unit concurrently with others:
+// the unit's offset, a module and file context of its own to process it
+// into, and the warnings it produced.
+struct DwarfCompilationUnitJob {
+  DwarfCompilationUnitJob(const string& dwarf_filename, const Module& module,
+                          const DwarfCUToModule::FileContext& file_context,
+                          bool handle_inter_cu_refs, uint64_t offset)
+      : offset(offset),
+        module(module.name(), module.os(), module.architecture(),
+               module.identifier()),
+        file_context(dwarf_filename, &this->module, handle_inter_cu_refs),
+        warnings(NULL),
+        warnings_size(0) {
+    for (dwarf2reader::SectionMap::const_iterator it =
+             file_context.section_map().begin();
+         it != file_context.section_map().end(); ++it) {
+      this->file_context.AddSectionToSectionMap(it->first, it->second.first,
+                                                it->second.second);
+    }
+  }
+  ~DwarfCompilationUnitJob() { free(warnings); }
+
+  uint64_t offset;
+  Module module;
+  DwarfCUToModule::FileContext file_context;
+  char* warnings;
+  size_t warnings_size;
+};
+
+// The DWARF sections dwarf2reader and DwarfCUToModule read, and so the
+// only ones LoadDwarf inflates if they are compressed.
+const char* const kDwarfSectionsRead[] = {
+  ".debug_abbrev",
+  ".debug_addr",
+  ".debug_info",
+  ".debug_line",
+  ".debug_ranges",
+  ".debug_str",
+  ".debug_str_offsets",
+};
+
 template<typename ElfClass>
 bool LoadDwarf(const string& dwarf_filename,
                const typename ElfClass::Ehdr* elf_header,
+               SectionContents<ElfClass>* section_contents,
                const bool big_endian,
                bool handle_inter_cu_refs,
+               int threads,
                Module* module) {
   typedef typename ElfClass::Shdr Shdr;
 
   const dwarf2reader::Endianness endianness = big_endian ?
       dwarf2reader::ENDIANNESS_BIG : dwarf2reader::ENDIANNESS_LITTLE;
-  dwarf2reader::ByteReader byte_reader(endianness);
 
   // Construct a context for this file.
   DwarfCUToModule::FileContext file_context(dwarf_filename,
                                             module,
                                             handle_inter_cu_refs);
 
-  // Build a map of the ELF file's sections.
+  // Inflate the compressed sections we'll read, concurrently if we may.
+  vector<const Shdr*> dwarf_sections;
+  for (size_t i = 0; i < sizeof(kDwarfSectionsRead) / sizeof(char*); i++) {
+    const Shdr* section =
+        section_contents->Find(kDwarfSectionsRead[i], SHT_PROGBITS);
+    if (!section && elf_header->e_machine == EM_MIPS)
+      section = section_contents->Find(kDwarfSectionsRead[i], SHT_MIPS_DWARF);
+    if (section)
+      dwarf_sections.push_back(section);
+  }
+  section_contents->Inflate(dwarf_sections, threads);
+
+  // Build a map of the ELF file's sections, leaving out compressed sections
+  // we won't read.
   const Shdr* sections =
       GetOffset<ElfClass, Shdr>(elf_header, elf_header->e_shoff);
   int num_sections = elf_header->e_shnum;
-  const Shdr* section_names = sections + elf_header->e_shstrndx;
   for (int i = 0; i < num_sections; i++) {
     const Shdr* section = &sections[i];
-    string name = GetOffset<ElfClass, char>(elf_header,
-                                            section_names->sh_offset) +
-                  section->sh_name;
-    const uint8_t *contents = GetOffset<ElfClass, uint8_t>(elf_header,
-                                                           section->sh_offset);
-    file_context.AddSectionToSectionMap(name, contents, section->sh_size);
-  }
-
-  // Optional .debug_ranges reader
-  scoped_ptr<DumperRangesHandler> ranges_handler;
-  dwarf2reader::SectionMap::const_iterator ranges_entry =
-      file_context.section_map().find(".debug_ranges");
-  if (ranges_entry != file_context.section_map().end()) {
-    const std::pair<const uint8_t *, uint64_t>& ranges_section =
-      ranges_entry->second;
-    ranges_handler.reset(
-      new DumperRangesHandler(ranges_section.first, ranges_section.second,
-                              &byte_reader));
+    if (section_contents->IsCompressed(section) &&
+        std::find(dwarf_sections.begin(), dwarf_sections.end(), section) ==
+        dwarf_sections.end()) {
+      continue;
+    }
+    const uint8_t *contents;
+    uint64_t size;
+    if (section_contents->Get(section, &contents, &size)) {
+      file_context.AddSectionToSectionMap(section_contents->Name(section),
+                                          contents, size);
+    }
   }
+  if (!file_context.section_map().count(".debug_info"))
+    return false;
 
   // Parse all the compilation units in the .debug_info section.
-  DumperLineToModule line_to_module(&byte_reader);
   dwarf2reader::SectionMap::const_iterator debug_info_entry =
       file_context.section_map().find(".debug_info");
   assert(debug_info_entry != file_context.section_map().end());
@@ -328,22 +640,63 @@ bool LoadDwarf(const string& dwarf_filename,
   // .debug_info section.
   assert(debug_info_section.first);
   uint64_t debug_info_length = debug_info_section.second;
+  if (threads <= 1) {
+    for (uint64_t offset = 0; offset < debug_info_length;) {
+      offset += LoadDwarfCompilationUnit(dwarf_filename, &file_context,
+                                         endianness, offset, stderr);
+    }
+    return true;
+  }
+
+  // Find where each compilation unit begins from the unit headers' initial
+  // length fields, and give each unit a module of its own to be processed
+  // into on one of THREADS worker threads.
+  dwarf2reader::ByteReader byte_reader(endianness);
+  vector<DwarfCompilationUnitJob*> jobs;
   for (uint64_t offset = 0; offset < debug_info_length;) {
-    // Make a handler for the root DIE that populates MODULE with the
-    // data that was found.
-    DwarfCUToModule::WarningReporter reporter(dwarf_filename, offset);
-    DwarfCUToModule root_handler(&file_context, &line_to_module,
-                                 ranges_handler.get(), &reporter);
-    // Make a Dwarf2Handler that drives the DIEHandler.
-    dwarf2reader::DIEDispatcher die_dispatcher(&root_handler);
-    // Make a DWARF parser for the compilation unit at OFFSET.
-    dwarf2reader::CompilationUnit reader(dwarf_filename,
-                                         file_context.section_map(),
-                                         offset,
-                                         &byte_reader,
-                                         &die_dispatcher);
-    // Process the entire compilation unit; get the offset of the next.
-    offset += reader.Start();
+    jobs.push_back(new DwarfCompilationUnitJob(dwarf_filename, *module,
+                                               file_context,
+                                               handle_inter_cu_refs, offset));
+    size_t initial_length_size;
+    uint64_t length = byte_reader.ReadInitialLength(
+        debug_info_section.first + offset, &initial_length_size);
+    offset += initial_length_size + length;
+  }
+
+  std::atomic<size_t> next_job(0);
+  vector<std::thread> workers;
+  for (int i = 0; i < threads && static_cast<size_t>(i) < jobs.size(); ++i) {
+    workers.push_back(std::thread([&]() {
+      for (size_t j = next_job++; j < jobs.size(); j = next_job++) {
+        DwarfCompilationUnitJob* job = jobs[j];
+        FILE* warnings = open_memstream(&job->warnings, &job->warnings_size);
+        LoadDwarfCompilationUnit(dwarf_filename, &job->file_context,
+                                 endianness, job->offset,
+                                 warnings ? warnings : stderr);
+        if (warnings)
+          fclose(warnings);
+      }
+    }));
+  }
+  for (size_t i = 0; i < workers.size(); ++i)
+    workers[i].join();
+
+  // Fold each unit's results into MODULE in order, so that the result is
+  // what processing them one after another would have produced. A unit
+  // that referred to DIEs in other units may have been missing information
+  // those units provide, so process it again, now that the units before it
+  // have been folded in.
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    DwarfCompilationUnitJob* job = jobs[i];
+    if (job->file_context.saw_inter_cu_reference()) {
+      LoadDwarfCompilationUnit(dwarf_filename, &file_context, endianness,
+                               job->offset, stderr);
+    } else {
+      file_context.MergeFrom(&job->file_context);
+      if (job->warnings_size)
+        fwrite(job->warnings, 1, job->warnings_size, stderr);
+    }
+    delete job;
   }
   return true;
 }
@@ -380,6 +733,7 @@ bool DwarfCFIRegisterNames(const typename ElfClass::Ehdr* elf_header,
 template<typename ElfClass>
 bool LoadDwarfCFI(const string& dwarf_filename,
                   const typename ElfClass::Ehdr* elf_header,
+                  SectionContents<ElfClass>* section_contents,
                   const char* section_name,
                   const typename ElfClass::Shdr* section,
                   const bool eh_frame,
@@ -401,9 +755,10 @@ bool LoadDwarfCFI(const string& dwarf_filename,
       dwarf2reader::ENDIANNESS_BIG : dwarf2reader::ENDIANNESS_LITTLE;
 
   // Find the call frame information and its size.
-  const uint8_t *cfi =
-      GetOffset<ElfClass, uint8_t>(elf_header, section->sh_offset);
-  size_t cfi_size = section->sh_size;
+  const uint8_t *cfi;
+  uint64_t cfi_size;
+  if (!section_contents->Get(section, &cfi, &cfi_size))
+    return false;
 
   // Plug together the parser, handler, and their entourages.
   DwarfCFIToModule::Reporter module_reporter(dwarf_filename, section_name);
@@ -682,6 +1037,7 @@ bool LoadSymbols(const string& obj_file,
   const char *names_end = names + section_names->sh_size;
   bool found_debug_info_section = false;
   bool found_usable_info = false;
+  SectionContents<ElfClass> section_contents(obj_file, elf_header);
 
   if (options.symbol_data != ONLY_CFI) {
 #ifndef NO_STABS_SUPPORT
@@ -707,25 +1063,21 @@ bool LoadSymbols(const string& obj_file,
 
     // Look for DWARF debugging information, and load it if present.
     const Shdr* dwarf_section =
-      FindElfSectionByName<ElfClass>(".debug_info", SHT_PROGBITS,
-                                     sections, names, names_end,
-                                     elf_header->e_shnum);
+        section_contents.Find(".debug_info", SHT_PROGBITS);
 
     // .debug_info section type is SHT_PROGBITS for mips on pnacl toolchains,
     // but MIPS_DWARF for regular gnu toolchains, so both need to be checked
-    if (elf_header->e_machine == EM_MIPS && !dwarf_section) {
-      dwarf_section =
-        FindElfSectionByName<ElfClass>(".debug_info", SHT_MIPS_DWARF,
-                                       sections, names, names_end,
-                                       elf_header->e_shnum);
-    }
+    if (elf_header->e_machine == EM_MIPS && !dwarf_section)
+      dwarf_section = section_contents.Find(".debug_info", SHT_MIPS_DWARF);
 
     if (dwarf_section) {
       found_debug_info_section = true;
       found_usable_info = true;
       info->LoadedSection(".debug_info");
-      if (!LoadDwarf<ElfClass>(obj_file, elf_header, big_endian,
-                               options.handle_inter_cu_refs, module)) {
+      if (!LoadDwarf<ElfClass>(obj_file, elf_header, &section_contents,
+                               big_endian,
+                               options.handle_inter_cu_refs, options.threads,
+                               module)) {
         fprintf(stderr, "%s: \".debug_info\" section found, but failed to load "
                 "DWARF debugging information\n", obj_file.c_str());
       }
@@ -794,17 +1146,13 @@ bool LoadSymbols(const string& obj_file,
     // Dwarf Call Frame Information (CFI) is actually independent from
     // the other DWARF debugging information, and can be used alone.
     const Shdr* dwarf_cfi_section =
-        FindElfSectionByName<ElfClass>(".debug_frame", SHT_PROGBITS,
-                                       sections, names, names_end,
-                                       elf_header->e_shnum);
+        section_contents.Find(".debug_frame", SHT_PROGBITS);
 
     // .debug_frame section type is SHT_PROGBITS for mips on pnacl toolchains,
     // but MIPS_DWARF for regular gnu toolchains, so both need to be checked
     if (elf_header->e_machine == EM_MIPS && !dwarf_cfi_section) {
       dwarf_cfi_section =
-          FindElfSectionByName<ElfClass>(".debug_frame", SHT_MIPS_DWARF,
-                                        sections, names, names_end,
-                                        elf_header->e_shnum);
+          section_contents.Find(".debug_frame", SHT_MIPS_DWARF);
     }
 
     if (dwarf_cfi_section) {
@@ -813,9 +1161,9 @@ bool LoadSymbols(const string& obj_file,
       // useful.
       info->LoadedSection(".debug_frame");
       bool result =
-          LoadDwarfCFI<ElfClass>(obj_file, elf_header, ".debug_frame",
-                                 dwarf_cfi_section, false, 0, 0, big_endian,
-                                 module);
+          LoadDwarfCFI<ElfClass>(obj_file, elf_header, &section_contents,
+                                 ".debug_frame", dwarf_cfi_section, false,
+                                 0, 0, big_endian, module);
       found_usable_info = found_usable_info || result;
     }
 
@@ -839,8 +1187,8 @@ bool LoadSymbols(const string& obj_file,
       info->LoadedSection(".eh_frame");
       // As above, ignore the return value of this function.
       bool result =
-          LoadDwarfCFI<ElfClass>(obj_file, elf_header, ".eh_frame",
-                                 eh_frame_section, true,
+          LoadDwarfCFI<ElfClass>(obj_file, elf_header, &section_contents,
+                                 ".eh_frame", eh_frame_section, true,
                                  got_section, text_section, big_endian, module);
       found_usable_info = found_usable_info || result;
     }
@@ -1077,7 +1425,8 @@ bool WriteSymbolFile(const string &load_path,
                       &module))
     return false;
 
-  bool result = module->Write(sym_stream, options.symbol_data);
+  bool result = module->Write(sym_stream, options.symbol_data,
+                              options.inlines);
   delete module;
   return result;
 }
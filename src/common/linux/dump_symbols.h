@@ -49,11 +49,21 @@ class Module;
 struct DumpOptions {
   DumpOptions(SymbolData symbol_data, bool handle_inter_cu_refs)
       : symbol_data(symbol_data),
-        handle_inter_cu_refs(handle_inter_cu_refs) {
+        handle_inter_cu_refs(handle_inter_cu_refs),
+        threads(1),
+        inlines(false) {
   }
 
   SymbolData symbol_data;
   bool handle_inter_cu_refs;
+  // The number of threads on which to process DWARF compilation units.
+  // The symbol file written is the same whatever the number.  Each unit
+  // gets a module of its own that is merged afterwards, so threads beyond
+  // the available CPUs only add that overhead.
+  int threads;
+  // Whether to write INLINE_ORIGIN and INLINE records, which older
+  // symbol file consumers don't understand.
+  bool inlines;
 };
 
 // Find all the debugging information in OBJ_FILE, an ELF executable
@@ -35,11 +35,13 @@
 #include <elf.h>
 #include <link.h>
 #include <stdio.h>
+#include <zlib.h>
 
 #include <sstream>
 #include <vector>
 
 #include "breakpad_googletest_includes.h"
+#include "common/dwarf/dwarf2reader_test_common.h"
 #include "common/linux/elf_gnu_compat.h"
 #include "common/linux/elfutils.h"
 #include "common/linux/dump_symbols.h"
@@ -60,6 +62,7 @@ using google_breakpad::synth_elf::ELF;
 using google_breakpad::synth_elf::Notes;
 using google_breakpad::synth_elf::StringTable;
 using google_breakpad::synth_elf::SymbolTable;
+using google_breakpad::test_assembler::Label;
 using google_breakpad::test_assembler::kLittleEndian;
 using google_breakpad::test_assembler::Section;
 using std::stringstream;
@@ -80,10 +83,101 @@ class DumpSymbols : public Test {
     elfdata = &elfdata_v[0];
   }
 
+  // Return the symbol file for an ELF file holding a compilation unit with
+  // one function, whose .debug_info and .debug_abbrev sections are stored
+  // as COMPRESSION says: "none", "SHF_COMPRESSED", or "zdebug".
+  string DumpCompressedDebugInfo(const string& compression);
+
   vector<uint8_t> elfdata_v;
   uint8_t* elfdata;
 };
 
+// Return the contents of SECTION compressed as COMPRESSION says, with
+// ELF_CLASS's Elf_Chdr, or a .zdebug header.
+static Section CompressSection(const string& compression, int elf_class,
+                               Section* section) {
+  string contents;
+  EXPECT_TRUE(section->GetContents(&contents));
+  Section result(kLittleEndian);
+  if (compression == "none") {
+    result.Append(contents);
+    return result;
+  }
+
+  uLongf compressed_size = compressBound(contents.size());
+  string compressed(compressed_size, '\0');
+  EXPECT_EQ(Z_OK, compress(reinterpret_cast<Bytef*>(&compressed[0]),
+                           &compressed_size,
+                           reinterpret_cast<const Bytef*>(contents.data()),
+                           contents.size()));
+  compressed.resize(compressed_size);
+
+  if (compression == "zdebug") {
+    result.Append("ZLIB").B64(contents.size());
+  } else if (elf_class == ELFCLASS32) {
+    result.D32(ELFCOMPRESS_ZLIB).D32(contents.size()).D32(1);
+  } else {
+    result.D32(ELFCOMPRESS_ZLIB).D32(0).D64(contents.size()).D64(1);
+  }
+  result.Append(compressed);
+  return result;
+}
+
+template<typename ElfClass>
+string DumpSymbols<ElfClass>::DumpCompressedDebugInfo(
+    const string& compression) {
+  ELF elf(ElfClass::kMachine, ElfClass::kClass, kLittleEndian);
+  Section text(kLittleEndian);
+  text.Append(4096, 0);
+  elf.AddSection(".text", text, SHT_PROGBITS);
+
+  TestAbbrevTable abbrevs;
+  abbrevs.set_endianness(kLittleEndian);
+  abbrevs
+      .Abbrev(1, dwarf2reader::DW_TAG_compile_unit,
+              dwarf2reader::DW_children_yes)
+      .Attribute(dwarf2reader::DW_AT_name, dwarf2reader::DW_FORM_string)
+      .EndAbbrev()
+      .Abbrev(2, dwarf2reader::DW_TAG_subprogram,
+              dwarf2reader::DW_children_no)
+      .Attribute(dwarf2reader::DW_AT_name, dwarf2reader::DW_FORM_string)
+      .Attribute(dwarf2reader::DW_AT_low_pc, dwarf2reader::DW_FORM_addr)
+      .Attribute(dwarf2reader::DW_AT_high_pc, dwarf2reader::DW_FORM_addr)
+      .EndAbbrev()
+      .EndTable();
+
+  TestCompilationUnit info;
+  info.set_endianness(kLittleEndian);
+  info.set_format_size(4);
+  info.Header(4, Label(0), ElfClass::kAddrSize);
+  info.ULEB128(1).AppendCString("compressed.cc");
+  info.ULEB128(2).AppendCString("compressed_function");
+  info.Append(kLittleEndian, ElfClass::kAddrSize, 0x1000)
+      .Append(kLittleEndian, ElfClass::kAddrSize, 0x1010);
+  info.D8(0);
+  info.Finish();
+
+  const char* prefix = compression == "zdebug" ? ".zdebug_" : ".debug_";
+  uint32_t flags = compression == "SHF_COMPRESSED" ? SHF_COMPRESSED : 0;
+  elf.AddSection(string(prefix) + "abbrev",
+                 CompressSection(compression, ElfClass::kClass, &abbrevs),
+                 SHT_PROGBITS, flags);
+  elf.AddSection(string(prefix) + "info",
+                 CompressSection(compression, ElfClass::kClass, &info),
+                 SHT_PROGBITS, flags);
+  elf.Finish();
+  GetElfContents(elf);
+
+  Module* module;
+  DumpOptions options(ALL_SYMBOL_DATA, true);
+  EXPECT_TRUE(ReadSymbolDataInternal(elfdata, "foo", "Linux",
+                                     vector<string>(), options, &module));
+  stringstream s;
+  module->Write(s, ALL_SYMBOL_DATA);
+  delete module;
+  return s.str();
+}
+
 typedef Types<ElfClass32, ElfClass64> ElfClasses;
 
 TYPED_TEST_SUITE(DumpSymbols, ElfClasses);
@@ -205,4 +299,12 @@ TYPED_TEST(DumpSymbols, SimpleBuildID) {
   delete module;
 }
 
+TYPED_TEST(DumpSymbols, CompressedDebugSections) {
+  string uncompressed = this->DumpCompressedDebugInfo("none");
+  EXPECT_NE(string::npos,
+            uncompressed.find("FUNC 1000 10 0 compressed_function\n"));
+  EXPECT_EQ(uncompressed, this->DumpCompressedDebugInfo("SHF_COMPRESSED"));
+  EXPECT_EQ(uncompressed, this->DumpCompressedDebugInfo("zdebug"));
+}
+
 }  // namespace google_breakpad
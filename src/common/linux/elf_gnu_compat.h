@@ -48,4 +48,13 @@
 #define NT_SIGINFO 0x53494749
 #endif
 
+// Compressed sections, and their compression type for zlib.
+#ifndef SHF_COMPRESSED
+#define SHF_COMPRESSED (1 << 11)
+#endif
+
+#ifndef ELFCOMPRESS_ZLIB
+#define ELFCOMPRESS_ZLIB 1
+#endif
+
 #endif  // COMMON_LINUX_ELF_GNU_COMPAT_H_
@@ -45,6 +45,7 @@ namespace google_breakpad {
 // with specific ELF bits.
 struct ElfClass32 {
   typedef Elf32_Addr Addr;
+  typedef Elf32_Chdr Chdr;
   typedef Elf32_Dyn Dyn;
   typedef Elf32_Ehdr Ehdr;
   typedef Elf32_Nhdr Nhdr;
@@ -63,6 +64,7 @@ struct ElfClass32 {
 
 struct ElfClass64 {
   typedef Elf64_Addr Addr;
+  typedef Elf64_Chdr Chdr;
   typedef Elf64_Dyn Dyn;
   typedef Elf64_Ehdr Ehdr;
   typedef Elf64_Nhdr Nhdr;
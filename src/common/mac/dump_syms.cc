@@ -345,10 +345,12 @@ class DumpSymbols::DumperLineToModule:
   }
 
   void ReadProgram(const uint8_t *program, uint64_t length,
-                   Module *module, vector<Module::Line> *lines) {
+                   Module *module, vector<Module::Line> *lines,
+                   std::map<uint32_t, Module::File *> *files) {
     DwarfLineToModule handler(module, compilation_dir_, lines);
     dwarf2reader::LineInfo parser(program, length, byte_reader_, &handler);
     parser.Start();
+    *files = handler.files();
   }
  private:
   string compilation_dir_;
@@ -38,6 +38,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
 #include <iostream>
 #include <utility>
 
@@ -47,6 +48,20 @@ using std::dec;
 using std::hex;
 
 
+Module::Inline::~Inline() {
+  for (vector<Inline *>::iterator it = child_inlines.begin();
+       it != child_inlines.end(); ++it) {
+    delete *it;
+  }
+}
+
+Module::Function::~Function() {
+  for (vector<Inline *>::iterator it = inlines.begin();
+       it != inlines.end(); ++it) {
+    delete *it;
+  }
+}
+
 Module::Module(const string &name, const string &os,
                const string &architecture, const string &id,
                const string &code_id /* = "" */) :
@@ -64,6 +79,10 @@ Module::~Module() {
        it != functions_.end(); ++it) {
     delete *it;
   }
+  for (vector<InlineOrigin *>::iterator it = inline_origins_.begin();
+       it != inline_origins_.end(); ++it) {
+    delete *it;
+  }
   for (vector<StackFrameEntry *>::iterator it = stack_frame_entries_.begin();
        it != stack_frame_entries_.end(); ++it) {
     delete *it;
@@ -151,6 +170,49 @@ void Module::AddExtern(Extern *ext) {
   }
 }
 
+Module::InlineOrigin *Module::AddInlineOrigin(const string &name) {
+  InlineOrigin *origin = new InlineOrigin(name);
+  inline_origins_.push_back(origin);
+  return origin;
+}
+
+// Make the call site files of INLINES, and of the inlines within them,
+// refer to the files FILE_MAP maps them to.
+static void RemapInlineFiles(const map<Module::File *, Module::File *> &file_map,
+                             const vector<Module::Inline *> &inlines) {
+  for (vector<Module::Inline *>::const_iterator it = inlines.begin();
+       it != inlines.end(); ++it) {
+    if ((*it)->call_site_file)
+      (*it)->call_site_file = file_map.find((*it)->call_site_file)->second;
+    RemapInlineFiles(file_map, (*it)->child_inlines);
+  }
+}
+
+void Module::TakeFunctions(Module *other) {
+  map<File *, File *> file_map;
+  for (FileByNameMap::iterator it = other->files_.begin();
+       it != other->files_.end(); ++it) {
+    file_map[it->second] = FindFile(it->second->name);
+  }
+
+  for (FunctionSet::iterator it = other->functions_.begin();
+       it != other->functions_.end(); ++it) {
+    Function *function = *it;
+    for (vector<Line>::iterator line = function->lines.begin();
+         line != function->lines.end(); ++line) {
+      line->file = file_map[line->file];
+    }
+    RemapInlineFiles(file_map, function->inlines);
+    AddFunction(function);
+  }
+  other->functions_.clear();
+
+  inline_origins_.insert(inline_origins_.end(),
+                         other->inline_origins_.begin(),
+                         other->inline_origins_.end());
+  other->inline_origins_.clear();
+}
+
 void Module::GetFunctions(vector<Function *> *vec,
                           vector<Function *>::iterator i) {
   vec->insert(i, functions_.begin(), functions_.end());
@@ -203,21 +265,41 @@ void Module::GetStackFrameEntries(vector<StackFrameEntry *> *vec) const {
   *vec = stack_frame_entries_;
 }
 
-void Module::AssignSourceIds() {
-  // First, give every source file an id of -1.
+// Mark the files and origins cited by INLINES and the inlines within
+// them, by setting their ids to zero.
+static void MarkInlines(const vector<Module::Inline *> &inlines) {
+  for (vector<Module::Inline *>::const_iterator it = inlines.begin();
+       it != inlines.end(); ++it) {
+    Module::Inline *in = *it;
+    in->origin->id = 0;
+    if (in->call_site_file)
+      in->call_site_file->source_id = 0;
+    MarkInlines(in->child_inlines);
+  }
+}
+
+void Module::AssignSourceIds(bool inlines) {
+  // First, give every source file and inline origin an id of -1.
   for (FileByNameMap::iterator file_it = files_.begin();
        file_it != files_.end(); ++file_it) {
     file_it->second->source_id = -1;
   }
+  for (vector<InlineOrigin *>::iterator origin_it = inline_origins_.begin();
+       origin_it != inline_origins_.end(); ++origin_it) {
+    (*origin_it)->id = -1;
+  }
 
   // Next, mark all files actually cited by our functions' line number
-  // info, by setting each one's source id to zero.
+  // info and inlines, and all origins cited by the inlines, by setting
+  // each one's id to zero.
   for (FunctionSet::const_iterator func_it = functions_.begin();
        func_it != functions_.end(); ++func_it) {
     Function *func = *func_it;
     for (vector<Line>::iterator line_it = func->lines.begin();
          line_it != func->lines.end(); ++line_it)
       line_it->file->source_id = 0;
+    if (inlines)
+      MarkInlines(func->inlines);
   }
 
   // Finally, assign source ids to those files that have been marked.
@@ -230,6 +312,26 @@ void Module::AssignSourceIds() {
     if (!file_it->second->source_id)
       file_it->second->source_id = next_source_id++;
   }
+
+  // Number the marked origins in order by name too, giving origins with
+  // the same name --- copies of one inline function's definition seen in
+  // different compilation units --- the same id.
+  vector<InlineOrigin *> marked_origins;
+  for (vector<InlineOrigin *>::iterator origin_it = inline_origins_.begin();
+       origin_it != inline_origins_.end(); ++origin_it) {
+    if (!(*origin_it)->id)
+      marked_origins.push_back(*origin_it);
+  }
+  std::sort(marked_origins.begin(), marked_origins.end(),
+            [](const InlineOrigin *x, const InlineOrigin *y) {
+              return x->name < y->name;
+            });
+  int next_origin_id = -1;
+  for (size_t i = 0; i < marked_origins.size(); ++i) {
+    if (i == 0 || marked_origins[i]->name != marked_origins[i - 1]->name)
+      ++next_origin_id;
+    marked_origins[i]->id = next_origin_id;
+  }
 }
 
 bool Module::ReportError() {
@@ -248,6 +350,42 @@ bool Module::WriteRuleMap(const RuleMap &rule_map, std::ostream &stream) {
   return stream.good();
 }
 
+bool Module::WriteInlines(const vector<Inline *> &inlines, int nest_level,
+                          const Range &range, std::ostream &stream) {
+  for (vector<Inline *>::const_iterator it = inlines.begin();
+       it != inlines.end(); ++it) {
+    Inline *in = *it;
+    // List only the parts of this inline that fall within RANGE.  An
+    // inline's children lie within it, so if none of it does, neither
+    // do they.
+    bool started = false;
+    for (vector<Range>::const_iterator range_it = in->ranges.begin();
+         range_it != in->ranges.end(); ++range_it) {
+      Address start = std::max(range_it->address, range.address);
+      Address end = std::min(range_it->address + range_it->size,
+                             range.address + range.size);
+      if (start >= end)
+        continue;
+      if (!started) {
+        stream << "INLINE " << nest_level << " " << in->call_site_line << " "
+               << (in->call_site_file ? in->call_site_file->source_id : -1)
+               << " " << in->origin->id;
+        started = true;
+      }
+      stream << " " << hex << (start - load_address_) << " " << (end - start)
+             << dec;
+    }
+    if (!started)
+      continue;
+    stream << "\n";
+    if (!stream.good())
+      return false;
+    if (!WriteInlines(in->child_inlines, nest_level + 1, range, stream))
+      return false;
+  }
+  return true;
+}
+
 bool Module::AddressIsInModule(Address address) const {
   if (address_ranges_.empty()) {
     return true;
@@ -261,7 +399,8 @@ bool Module::AddressIsInModule(Address address) const {
   return false;
 }
 
-bool Module::Write(std::ostream &stream, SymbolData symbol_data) {
+bool Module::Write(std::ostream &stream, SymbolData symbol_data,
+                   bool inlines) {
   stream << "MODULE " << os_ << " " << architecture_ << " "
          << id_ << " " << name_ << "\n";
   if (!stream.good())
@@ -272,7 +411,7 @@ bool Module::Write(std::ostream &stream, SymbolData symbol_data) {
   }
 
   if (symbol_data != ONLY_CFI) {
-    AssignSourceIds();
+    AssignSourceIds(inlines);
 
     // Write out files.
     for (FileByNameMap::iterator file_it = files_.begin();
@@ -285,7 +424,28 @@ bool Module::Write(std::ostream &stream, SymbolData symbol_data) {
       }
     }
 
-    // Write out functions and their lines.
+    // Write out inline origins, once per id.
+    vector<InlineOrigin *> origins;
+    for (vector<InlineOrigin *>::iterator origin_it = inline_origins_.begin();
+         origin_it != inline_origins_.end(); ++origin_it) {
+      if ((*origin_it)->id >= 0)
+        origins.push_back(*origin_it);
+    }
+    std::sort(origins.begin(), origins.end(),
+              [](const InlineOrigin *x, const InlineOrigin *y) {
+                return x->id < y->id;
+              });
+    for (vector<InlineOrigin *>::iterator origin_it = origins.begin();
+         origin_it != origins.end(); ++origin_it) {
+      InlineOrigin *origin = *origin_it;
+      if (origin_it != origins.begin() && origin->id == (*(origin_it - 1))->id)
+        continue;
+      stream << "INLINE_ORIGIN " << origin->id << " " << origin->name << "\n";
+      if (!stream.good())
+        return ReportError();
+    }
+
+    // Write out functions and their inlines and lines.
     for (FunctionSet::const_iterator func_it = functions_.begin();
          func_it != functions_.end(); ++func_it) {
       Function *func = *func_it;
@@ -301,6 +461,9 @@ bool Module::Write(std::ostream &stream, SymbolData symbol_data) {
         if (!stream.good())
           return ReportError();
 
+        if (inlines && !WriteInlines(func->inlines, 0, *range_it, stream))
+          return ReportError();
+
         while ((line_it != func->lines.end()) &&
                (line_it->address >= range_it->address) &&
                (line_it->address < (range_it->address + range_it->size))) {
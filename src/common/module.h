@@ -44,6 +44,7 @@
 #include <string>
 #include <vector>
 
+#include "common/basictypes.h"
 #include "common/symbol_data.h"
 #include "common/using_std_string.h"
 #include "google_breakpad/common/breakpad_types.h"
@@ -64,6 +65,8 @@ class Module {
   typedef uint64_t Address;
   struct File;
   struct Function;
+  struct InlineOrigin;
+  struct Inline;
   struct Line;
   struct Extern;
 
@@ -94,10 +97,55 @@ class Module {
     Address size;
   };
 
+  // The abstract definition of a function that has been inlined into
+  // other functions.  All the Inline structures for the inlined copies
+  // of a given function share one InlineOrigin.
+  struct InlineOrigin {
+    explicit InlineOrigin(const string &name_input) :
+        name(name_input), id(-1) {}
+
+    // The inlined function's name.
+    string name;
+
+    // The origin's id.  Like File::source_id, the Write member function
+    // assigns this afresh, giving origins with the same name the same id.
+    int id;
+  };
+
+  // A copy of a function inlined at a particular call site.
+  struct Inline {
+    Inline(InlineOrigin *origin_input, const vector<Range> &ranges_input,
+           int call_site_line_input, File *call_site_file_input) :
+        origin(origin_input), ranges(ranges_input),
+        call_site_line(call_site_line_input),
+        call_site_file(call_site_file_input) {}
+    ~Inline();
+
+    // The function that was inlined.
+    InlineOrigin *origin;
+
+    // The address ranges covered by the inlined code.
+    vector<Range> ranges;
+
+    // The source line and file of the call that was inlined.  The file
+    // may be NULL, if the debugging information doesn't say.
+    int call_site_line;
+    File *call_site_file;
+
+    // Functions inlined into this inlined copy.  Their ranges lie within
+    // this one's.  The Inline owns them.
+    vector<Inline *> child_inlines;
+
+   private:
+    // A copy would delete child_inlines a second time.
+    DISALLOW_COPY_AND_ASSIGN(Inline);
+  };
+
   // A function.
   struct Function {
     Function(const string &name_input, const Address &address_input) :
         name(name_input), address(address_input), parameter_size(0) {}
+    ~Function();
 
     // For sorting by address.  (Not style-guide compliant, but it's
     // stupid not to put this in the struct.)
@@ -118,6 +166,14 @@ class Module {
     // Source lines belonging to this function, sorted by increasing
     // address.
     vector<Line> lines;
+
+    // Functions inlined directly into this one; each may have further
+    // functions inlined into it.  The Function owns them.
+    vector<Inline *> inlines;
+
+   private:
+    // A copy would delete inlines a second time.
+    DISALLOW_COPY_AND_ASSIGN(Function);
   };
 
   // A source line.
@@ -245,6 +301,22 @@ class Module {
   // Otherwise, return NULL.
   File *FindExistingFile(const string &name);
 
+  // Create a new InlineOrigin named NAME and return a pointer to it.
+  // This module owns all InlineOrigin objects created using this
+  // function; destroying the module destroys them as well.  Origins are
+  // not shared by name: the Write member function merges origins with
+  // the same name when it assigns them ids.
+  InlineOrigin *AddInlineOrigin(const string &name);
+
+  // Move the functions of OTHER, a module describing the same object
+  // file, into this module, as AddFunctions would add them: a function
+  // with the same address and name as one this module already has is
+  // discarded.  The moved functions' lines and inlines are made to refer
+  // to this module's files of the same names, and the inline origins
+  // OTHER created move with them.  OTHER keeps its files, and is left
+  // with no functions or inline origins.
+  void TakeFunctions(Module *other);
+
   // Insert pointers to the functions added to this module at I in
   // VEC. The pointed-to Functions are still owned by this module.
   // (Since this is effectively a copy of the function list, this is
@@ -274,11 +346,14 @@ class Module {
   void GetStackFrameEntries(vector<StackFrameEntry *> *vec) const;
 
   // Find those files in this module that are actually referred to by
-  // functions' line number data, and assign them source id numbers.
-  // Set the source id numbers for all other files --- unused by the
-  // source line data --- to -1.  We do this before writing out the
-  // symbol file, at which point we omit any unused files.
-  void AssignSourceIds();
+  // functions' line number data or inlined call sites, and assign them
+  // source id numbers.  Set the source id numbers for all other files
+  // --- unused by the source line data --- to -1.  If INLINES is true,
+  // files cited only by inlined call sites count as used too, and the
+  // inline origins the functions' inlines refer to are assigned ids;
+  // all other origins get -1.  We do this before writing out the symbol
+  // file, at which point we omit any unused files and origins.
+  void AssignSourceIds(bool inlines = false);
 
   // Call AssignSourceIds, and write this module to STREAM in the
   // breakpad symbol format. Return true if all goes well, or false if
@@ -286,13 +361,17 @@ class Module {
   // - a header based on the values given to the constructor,
   // If symbol_data is not ONLY_CFI then:
   // - the source files added via FindFile,
-  // - the functions added via AddFunctions, each with its lines,
+  // - if INLINES is true, the inline origins added via AddInlineOrigin,
+  // - the functions added via AddFunctions, each with its lines and, if
+  //   INLINES is true, its inlines,
   // - all public records,
   // If symbol_data is not NO_CFI then:
   // - all CFI records.
   // Addresses in the output are all relative to the load address
-  // established by SetLoadAddress.
-  bool Write(std::ostream &stream, SymbolData symbol_data);
+  // established by SetLoadAddress.  INLINE_ORIGIN and INLINE records are
+  // only written on request, as older symbol file consumers reject them.
+  bool Write(std::ostream &stream, SymbolData symbol_data,
+             bool inlines = false);
 
   string name() const { return name_; }
   string os() const { return os_; }
@@ -310,6 +389,13 @@ class Module {
   // if an error occurs, return false, and leave errno set.
   static bool WriteRuleMap(const RuleMap &rule_map, std::ostream &stream);
 
+  // Write 'INLINE' records to STREAM for INLINES, nested NEST_LEVEL
+  // deep, and all the inlines within them, listing only their parts
+  // within RANGE.  Return true if all goes well; if an error occurs,
+  // return false, and leave errno set.
+  bool WriteInlines(const vector<Inline *> &inlines, int nest_level,
+                    const Range &range, std::ostream &stream);
+
   // Returns true of the specified address resides with an specified address
   // range, or if no ranges have been specified.
   bool AddressIsInModule(Address address) const;
@@ -348,6 +434,9 @@ class Module {
   FileByNameMap files_;    // This module's source files.
   FunctionSet functions_;  // This module's functions.
 
+  // The module owns all the inline origins that have been added to it.
+  vector<InlineOrigin *> inline_origins_;
+
   // The module owns all the call frame info entries that have been
   // added to it.
   vector<StackFrameEntry *> stack_frame_entries_;
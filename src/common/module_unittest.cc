@@ -219,6 +219,106 @@ TEST(Write, OmitUnusedFiles) {
                contents.c_str());
 }
 
+TEST(Write, Inlines) {
+  stringstream s;
+  Module m(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+
+  Module::File* file1 = m.FindFile("file1.cc");
+  Module::File* file2 = m.FindFile("file2.h");
+  m.FindFile("unused.cc");
+
+  // Two copies of one origin, as different compilation units would
+  // produce, an origin cited by nothing, and another that is used.
+  Module::InlineOrigin* origin1 = m.AddInlineOrigin("inlinee_a");
+  Module::InlineOrigin* origin1_copy = m.AddInlineOrigin("inlinee_a");
+  m.AddInlineOrigin("never_inlined");
+  Module::InlineOrigin* origin2 = m.AddInlineOrigin("inlinee_b");
+
+  // A function with two ranges, and an inline spanning both, with
+  // another inline nested in it that lies entirely in the first range.
+  Module::Function* function = new Module::Function("caller", 0x1000);
+  function->ranges.push_back(Module::Range(0x1000, 0x100));
+  function->ranges.push_back(Module::Range(0x2000, 0x40));
+  Module::Line line1 = { 0x1000, 0x100, file1, 10 };
+  Module::Line line2 = { 0x2000, 0x40, file2, 20 };
+  function->lines.push_back(line1);
+  function->lines.push_back(line2);
+
+  vector<Module::Range> outer_ranges;
+  outer_ranges.push_back(Module::Range(0x1010, 0x20));
+  outer_ranges.push_back(Module::Range(0x1080, 0x80));
+  outer_ranges.push_back(Module::Range(0x2000, 0x10));
+  Module::Inline* outer = new Module::Inline(origin2, outer_ranges, 12, file1);
+  vector<Module::Range> inner_ranges;
+  inner_ranges.push_back(Module::Range(0x1014, 0x8));
+  outer->child_inlines.push_back(
+      new Module::Inline(origin1, inner_ranges, 5, file2));
+  function->inlines.push_back(outer);
+
+  // A second inline of the first origin, with no call site file.
+  vector<Module::Range> sibling_ranges;
+  sibling_ranges.push_back(Module::Range(0x2020, 0x10));
+  function->inlines.push_back(
+      new Module::Inline(origin1_copy, sibling_ranges, 14, NULL));
+  m.AddFunction(function);
+
+  m.Write(s, ALL_SYMBOL_DATA, true);
+  string contents = s.str();
+  EXPECT_STREQ("MODULE os-name architecture id-string name with spaces\n"
+               "FILE 0 file1.cc\n"
+               "FILE 1 file2.h\n"
+               "INLINE_ORIGIN 0 inlinee_a\n"
+               "INLINE_ORIGIN 1 inlinee_b\n"
+               "FUNC 1000 100 0 caller\n"
+               "INLINE 0 12 0 1 1010 20 1080 80\n"
+               "INLINE 1 5 1 0 1014 8\n"
+               "1000 100 10 0\n"
+               "FUNC 2000 40 0 caller\n"
+               "INLINE 0 12 0 1 2000 10\n"
+               "INLINE 0 14 -1 0 2020 10\n"
+               "2000 40 20 1\n",
+               contents.c_str());
+}
+
+// Inline records are only written on request; by default the output is
+// what it was before they existed.
+TEST(Write, InlinesOffByDefault) {
+  stringstream s;
+  Module m(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+
+  Module::File* file1 = m.FindFile("file1.cc");
+  Module::File* file2 = m.FindFile("file2.h");
+  Module::InlineOrigin* origin = m.AddInlineOrigin("inlinee");
+
+  Module::Function* function = new Module::Function("caller", 0x1000);
+  function->ranges.push_back(Module::Range(0x1000, 0x100));
+  Module::Line line = { 0x1000, 0x100, file1, 10 };
+  function->lines.push_back(line);
+  vector<Module::Range> ranges;
+  ranges.push_back(Module::Range(0x1010, 0x20));
+  function->inlines.push_back(new Module::Inline(origin, ranges, 12, file2));
+  m.AddFunction(function);
+
+  // file2.h is only cited by the inline's call site.
+  m.Write(s, ALL_SYMBOL_DATA);
+  EXPECT_STREQ("MODULE os-name architecture id-string name with spaces\n"
+               "FILE 0 file1.cc\n"
+               "FUNC 1000 100 0 caller\n"
+               "1000 100 10 0\n",
+               s.str().c_str());
+
+  stringstream with_inlines;
+  m.Write(with_inlines, ALL_SYMBOL_DATA, true);
+  EXPECT_STREQ("MODULE os-name architecture id-string name with spaces\n"
+               "FILE 0 file1.cc\n"
+               "FILE 1 file2.h\n"
+               "INLINE_ORIGIN 0 inlinee\n"
+               "FUNC 1000 100 0 caller\n"
+               "INLINE 0 12 1 0 1010 20\n"
+               "1000 100 10 0\n",
+               with_inlines.str().c_str());
+}
+
 TEST(Write, NoCFI) {
   stringstream s;
   Module m(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
@@ -446,6 +546,54 @@ TEST(Construct, FunctionsWithSameAddress) {
                contents.c_str());
 }
 
+TEST(Construct, TakeFunctions) {
+  stringstream s;
+  Module m(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+  Module partial(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+
+  // A function the partial module duplicates.
+  Module::File* file1 = m.FindFile("file1.cc");
+  m.AddFunction(generate_duplicate_function("_without_form"));
+
+  // The partial module's files are its own, but must be replaced with the
+  // receiving module's files of the same name.
+  Module::File* partial_file1 = partial.FindFile("file1.cc");
+  Module::File* partial_file2 = partial.FindFile("file2.h");
+  Module::InlineOrigin* origin = partial.AddInlineOrigin("inlinee");
+  partial.AddFunction(generate_duplicate_function("_without_form"));
+  Module::Function* function = new Module::Function("taken", 0x1000);
+  function->ranges.push_back(Module::Range(0x1000, 0x100));
+  Module::Line line = { 0x1000, 0x100, partial_file1, 7 };
+  function->lines.push_back(line);
+  vector<Module::Range> inline_ranges;
+  inline_ranges.push_back(Module::Range(0x1010, 0x10));
+  function->inlines.push_back(
+      new Module::Inline(origin, inline_ranges, 3, partial_file2));
+  partial.AddFunction(function);
+
+  m.TakeFunctions(&partial);
+
+  vector<Module::Function*> partial_functions;
+  partial.GetFunctions(&partial_functions, partial_functions.end());
+  EXPECT_TRUE(partial_functions.empty());
+  EXPECT_EQ(file1, function->lines[0].file);
+  EXPECT_EQ(m.FindExistingFile("file2.h"),
+            function->inlines[0]->call_site_file);
+
+  m.Write(s, ALL_SYMBOL_DATA, true);
+  string contents = s.str();
+  EXPECT_STREQ("MODULE os-name architecture id-string name with spaces\n"
+               "FILE 0 file1.cc\n"
+               "FILE 1 file2.h\n"
+               "INLINE_ORIGIN 0 inlinee\n"
+               "FUNC 1000 100 0 taken\n"
+               "INLINE 0 3 1 0 1010 10\n"
+               "1000 100 7 0\n"
+               "FUNC d35402aac7a7ad5c 200b26e605f99071 f14ac4fed48c4a99"
+               " _without_form\n",
+               contents.c_str());
+}
+
 // Externs should be written out as PUBLIC records, sorted by
 // address.
 TEST(Construct, Externs) {
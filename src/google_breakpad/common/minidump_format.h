@@ -233,6 +233,7 @@ typedef struct {
 /* An MDRVA is an offset into the minidump file.  The beginning of the
  * MDRawHeader is at offset 0. */
 typedef uint32_t MDRVA;  /* RVA */
+typedef uint64_t MDRVA64;  /* RVA64 */
 
 typedef struct {
   uint32_t  data_size;
@@ -318,7 +319,7 @@ typedef enum {
   MD_EXCEPTION_STREAM            =  6,  /* MDRawExceptionStream */
   MD_SYSTEM_INFO_STREAM          =  7,  /* MDRawSystemInfo */
   MD_THREAD_EX_LIST_STREAM       =  8,
-  MD_MEMORY_64_LIST_STREAM       =  9,
+  MD_MEMORY_64_LIST_STREAM       =  9,  /* MDRawMemory64List */
   MD_COMMENT_STREAM_A            = 10,
   MD_COMMENT_STREAM_W            = 11,
   MD_HANDLE_DATA_STREAM          = 12,
@@ -332,6 +333,7 @@ typedef enum {
   MD_JAVASCRIPT_DATA_STREAM      = 20,
   MD_SYSTEM_MEMORY_INFO_STREAM   = 21,
   MD_PROCESS_VM_COUNTERS_STREAM  = 22,
+  MD_THREAD_NAME_LIST_STREAM     = 24,  /* MDRawThreadNameList */
   MD_LAST_RESERVED_STREAM        = 0x0000ffff,
 
   /* Breakpad extension types.  0x4767 = "Gg" */
@@ -383,6 +385,26 @@ static const size_t MDRawThreadList_minsize = offsetof(MDRawThreadList,
                                                        threads[0]);
 
 
+/* Windows packs MINIDUMP_THREAD_NAME to 32 bits, so that each entry takes
+ * 12 bytes.  Use the same alignment here. */
+#pragma pack(push, 4)
+
+typedef struct {
+  uint32_t thread_id;
+  MDRVA64  thread_name_rva;  /* MDString */
+} MDRawThreadName;  /* MINIDUMP_THREAD_NAME */
+
+typedef struct {
+  uint32_t        number_of_thread_names;
+  MDRawThreadName thread_names[1];
+} MDRawThreadNameList;  /* MINIDUMP_THREAD_NAME_LIST */
+
+#pragma pack(pop)
+
+static const size_t MDRawThreadNameList_minsize =
+    offsetof(MDRawThreadNameList, thread_names[0]);
+
+
 typedef struct {
   uint64_t             base_of_image;
   uint32_t             size_of_image;
@@ -529,6 +551,27 @@ static const size_t MDRawMemoryList_minsize = offsetof(MDRawMemoryList,
                                                        memory_ranges[0]);
 
 
+typedef struct {
+  /* The base address of the memory range on the host that produced the
+   * minidump. */
+  uint64_t start_of_memory_range;
+
+  uint64_t data_size;
+} MDMemoryDescriptor64;  /* MINIDUMP_MEMORY_DESCRIPTOR64 */
+
+typedef struct {
+  uint64_t             number_of_memory_ranges;
+
+  /* The contents of all of the memory ranges, stored contiguously in the
+   * order of memory_ranges, begin at base_rva. */
+  MDRVA64              base_rva;
+  MDMemoryDescriptor64 memory_ranges[1];
+} MDRawMemory64List;  /* MINIDUMP_MEMORY64_LIST */
+
+static const size_t MDRawMemory64List_minsize = offsetof(MDRawMemory64List,
+                                                         memory_ranges[0]);
+
+
 #define MD_EXCEPTION_MAXIMUM_PARAMETERS 15u
 
 typedef struct {
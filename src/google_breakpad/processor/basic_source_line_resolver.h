@@ -40,6 +40,8 @@
 
 #include <map>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/using_std_string.h"
 #include "google_breakpad/processor/source_line_resolver_base.h"
@@ -60,10 +62,27 @@ class BasicSourceLineResolver : public SourceLineResolverBase {
   using SourceLineResolverBase::UnloadModule;
   using SourceLineResolverBase::HasModule;
   using SourceLineResolverBase::IsModuleCorrupt;
+  using SourceLineResolverBase::PinModule;
+  using SourceLineResolverBase::UnpinModule;
   using SourceLineResolverBase::FillSourceLineInfo;
   using SourceLineResolverBase::FindWindowsFrameInfo;
   using SourceLineResolverBase::FindCFIFrameInfo;
 
+  // Sets whether modules loaded from now on are parsed lazily.  A lazy
+  // module only parses the FUNC records of its symbol file when it is
+  // loaded, and parses the line records of a function when an address in
+  // it is first looked up.  This makes loading a large symbol file much
+  // faster when only a few of its addresses are looked up, at the cost of
+  // keeping the symbol data in memory alongside the module.  The resolver
+  // keeps that data itself, copying buffers passed to
+  // LoadModuleUsingMemoryBuffer, and frees it when the module is unloaded.
+  // Lazy parsing is off by default.
+  void set_lazy_parsing(bool lazy);
+
+ protected:
+  // A lazy module's symbol data must stay alive as long as the module.
+  virtual bool ModulesKeepSymbolData();
+
  private:
   // friend declarations:
   friend class BasicModuleFactory;
@@ -73,6 +92,8 @@ class BasicSourceLineResolver : public SourceLineResolverBase {
 
   // Function derives from SourceLineResolverBase::Function.
   struct Function;
+  // A call inlined into a Function.
+  struct Inline;
   // Module implements SourceLineResolverBase::Module interface.
   class Module;
 
@@ -120,6 +141,31 @@ class SymbolParseHelper {
                         long *line_number,   // out
                         long *source_file);  // out
 
+  // Parses an |inline_origin_line| declaration.  Returns true on success.
+  // Format:  INLINE_ORIGIN <origin_id> <name>
+  // Notice, that this method modifies the input |inline_origin_line| which is
+  // why it can't be const.  On success, <origin_id> and <name> are stored in
+  // |*origin_id| and |*name|.  No allocation is done, |*name| simply points
+  // inside |inline_origin_line|.
+  static bool ParseInlineOrigin(char *inline_origin_line,  // in
+                                long *origin_id,           // out
+                                char **name);              // out
+
+  // Parses an |inline_line| declaration.  Returns true on success.
+  // Format:  INLINE <nest_level> <call_site_line> <call_site_file_id>
+  //          <origin_id> [<address> <size>]+
+  // Notice, that this method modifies the input |inline_line| which is why
+  // it can't be const.  On success, the fields are stored in |*nest_level|,
+  // |*call_site_line|, |*call_site_file_id|, |*origin_id| and |*ranges|.
+  // A <call_site_file_id> of -1 means the call site's file is unknown.
+  static bool ParseInline(
+      char *inline_line,                                  // in
+      long *nest_level,                                   // out
+      long *call_site_line,                               // out
+      long *call_site_file_id,                            // out
+      long *origin_id,                                    // out
+      std::vector<std::pair<uint64_t, uint64_t> > *ranges);  // out
+
   // Parses a |public_line| declaration.  Returns true on success.
   // Format:  PUBLIC [<multiple>] <address> <stack_param_size> <name>
   // Notice, that this method modifies the input |function_line| which is why
@@ -46,8 +46,11 @@
 #define GOOGLE_BREAKPAD_PROCESSOR_CALL_STACK_H__
 
 #include <cstdint>
+#include <string>
 #include <vector>
 
+#include "common/using_std_string.h"
+
 namespace google_breakpad {
 
 using std::vector;
@@ -55,6 +58,15 @@ using std::vector;
 struct StackFrame;
 template<typename T> class linked_ptr;
 
+// Why a CallStack holds less of its thread's stack than walking it fully
+// would have found.  See ProcessDeadline.
+enum CallStackTruncation {
+  CALL_STACK_NOT_TRUNCATED,     // The stack was walked as far as possible
+  CALL_STACK_DEADLINE_PASSED,   // Walking stopped at the processing deadline
+  CALL_STACK_CANCELLED          // Walking stopped when processing was
+                                // cancelled
+};
+
 class CallStack {
  public:
   CallStack() { Clear(); }
@@ -70,9 +82,28 @@ class CallStack {
 
   uint32_t tid() const { return tid_; }
 
+  // Set the name of the thread associated with this call stack.
+  void set_thread_name(const string &thread_name) {
+    thread_name_ = thread_name;
+  }
+
+  const string &thread_name() const { return thread_name_; }
+
+  // Records why the walk stopped early, if it did.  The frames found until
+  // then are kept.  A thread that was never walked has no frames.
+  void set_truncation(CallStackTruncation truncation) {
+    truncation_ = truncation;
+  }
+
+  CallStackTruncation truncation() const { return truncation_; }
+
+  bool truncated() const { return truncation_ != CALL_STACK_NOT_TRUNCATED; }
+
  private:
-  // Stackwalker is responsible for building the frames_ vector.
+  // Stackwalker is responsible for building the frames_ vector, and
+  // ProcessStateSerializer for rebuilding it from its serialized form.
   friend class Stackwalker;
+  friend class ProcessStateSerializer;
 
   // Storage for pushed frames.
   vector<StackFrame*> frames_;
@@ -80,6 +111,13 @@ class CallStack {
   // The TID associated with this call stack. Default to 0 if it's not
   // available.
   uint32_t tid_;
+
+  // The name of the thread associated with this call stack. Empty if it's
+  // not available.
+  string thread_name_;
+
+  // Why the stack was not walked to its end, if it wasn't.
+  CallStackTruncation truncation_;
 };
 
 }  // namespace google_breakpad
@@ -37,6 +37,10 @@
 // data.  Therefore loading a symbol in FastSourceLineResolver is much faster
 // and more memory-efficient than BasicSourceLineResolver.
 //
+// The serialized format carries no INLINE_ORIGIN or INLINE records, so
+// FastSourceLineResolver ignores them and FillSourceLineInfo never
+// returns inlined frames; use BasicSourceLineResolver to get them.
+//
 // See "source_line_resolver_base.h" and
 // "google_breakpad/source_line_resolver_interface.h" for more reference.
 //
@@ -57,17 +61,47 @@ using std::map;
 class FastSourceLineResolver : public SourceLineResolverBase {
  public:
   FastSourceLineResolver();
-  virtual ~FastSourceLineResolver() { }
+  virtual ~FastSourceLineResolver();
 
   using SourceLineResolverBase::FillSourceLineInfo;
   using SourceLineResolverBase::FindCFIFrameInfo;
   using SourceLineResolverBase::FindWindowsFrameInfo;
   using SourceLineResolverBase::HasModule;
   using SourceLineResolverBase::IsModuleCorrupt;
-  using SourceLineResolverBase::LoadModule;
-  using SourceLineResolverBase::LoadModuleUsingMapBuffer;
-  using SourceLineResolverBase::LoadModuleUsingMemoryBuffer;
+  using SourceLineResolverBase::PinModule;
+
+  // If map_file is a fast symbol file (see ModuleSerializer), maps it into
+  // memory read-only and uses it in place, so loading takes no parsing and
+  // the pages are shared by every process that maps the same file.  A fast
+  // symbol file that is truncated or of another version is rejected, as is
+  // one that fails its checksum if set_verify_checksums() is on.  Any other
+  // file is read into memory, as SourceLineResolverBase::LoadModule() does.
+  //
+  // The file is mapped shared, so it must not be truncated or rewritten in
+  // place while the module is loaded: the resolver would see the new
+  // contents, and touching a page past the new end of the file raises
+  // SIGBUS.  Replace a fast symbol file by writing a new one and renaming
+  // it over the old, as ModuleSerializer::ConvertSymbolFileToFastSymbolFile
+  // does; modules loaded from the old file keep using it.
+  virtual bool LoadModule(const CodeModule *module, const string &map_file);
+
+  // Load a fast symbol file image, or serialized module data without its
+  // header, from a buffer.  memory_buffer must outlive the module.
+  virtual bool LoadModuleUsingMapBuffer(const CodeModule *module,
+                                        const string &map_buffer);
+  virtual bool LoadModuleUsingMemoryBuffer(const CodeModule *module,
+                                           char *memory_buffer,
+                                           size_t memory_buffer_size);
+
+  // Sets whether fast symbol files loaded from now on have their checksum
+  // verified.  Off by default: verifying reads the whole file at load
+  // time, rather than only the pages lookups touch, and sym2fast already
+  // verifies each file it writes.  Turn it on if files may be damaged
+  // after they are written.
+  void set_verify_checksums(bool verify) { verify_checksums_ = verify; }
+
   using SourceLineResolverBase::UnloadModule;
+  using SourceLineResolverBase::UnpinModule;
 
  private:
   // Friend declarations.
@@ -90,6 +124,27 @@ class FastSourceLineResolver : public SourceLineResolverBase {
   // virtual method.
   virtual bool ShouldDeleteMemoryBufferAfterLoadModule();
 
+  // Returns false if set_verify_checksums() is on and buffer holds a fast
+  // symbol file whose data fails its checksum.
+  bool CheckBuffer(const CodeModule *module, const char *buffer,
+                   size_t buffer_size);
+
+  // Unmaps the fast symbol file the module was loaded from, if any.
+  virtual void ReleaseModuleData(const string &key);
+
+  // A fast symbol file mapped into memory by LoadModule().
+  struct MappedFile {
+    void *address;
+    size_t size;
+  };
+
+  // All of the fast symbol files mapped by LoadModule(), keyed by the
+  // module key of the module using them.  Guarded by modules_mutex_.
+  typedef map<string, MappedFile, CompareString> MappedFileMap;
+  MappedFileMap mapped_files_;
+
+  bool verify_checksums_;
+
   // Disallow unwanted copy ctor and assignment operator
   FastSourceLineResolver(const FastSourceLineResolver&);
   void operator=(const FastSourceLineResolver&);
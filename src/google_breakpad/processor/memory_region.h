@@ -38,6 +38,7 @@
 #ifndef GOOGLE_BREAKPAD_PROCESSOR_MEMORY_REGION_H__
 #define GOOGLE_BREAKPAD_PROCESSOR_MEMORY_REGION_H__
 
+#include <stddef.h>
 
 #include "google_breakpad/common/breakpad_types.h"
 
@@ -68,8 +69,35 @@ class MemoryRegion {
   virtual bool GetMemoryAtAddress(uint64_t address, uint32_t* value) const = 0;
   virtual bool GetMemoryAtAddress(uint64_t address, uint64_t* value) const = 0;
 
+  // Reads up to count consecutive values starting at address into values,
+  // as GetMemoryAtAddress does for each.  Returns the number of values
+  // read, which is less than count if the region ends first.  Subclasses
+  // that hold their contents in memory can read many values at once this
+  // way much faster than one at a time.
+  virtual size_t GetMemoryAtAddresses(uint64_t address, uint32_t* values,
+                                      size_t count) const {
+    return GetMemoryAtAddressesSlowly(address, values, count);
+  }
+  virtual size_t GetMemoryAtAddresses(uint64_t address, uint64_t* values,
+                                      size_t count) const {
+    return GetMemoryAtAddressesSlowly(address, values, count);
+  }
+
   // Print a human-readable representation of the object to stdout.
   virtual void Print() const = 0;
+
+ protected:
+  // Implementation for GetMemoryAtAddresses, reading one value at a time.
+  template<typename T>
+  size_t GetMemoryAtAddressesSlowly(uint64_t address, T* values,
+                                    size_t count) const {
+    size_t read = 0;
+    while (read < count &&
+           GetMemoryAtAddress(address + read * sizeof(T), &values[read])) {
+      ++read;
+    }
+    return read;
+  }
 };
 
 
@@ -108,6 +108,8 @@ using std::vector;
 
 
 class Minidump;
+class MinidumpDataSource;
+template<typename AddressType, typename EntryType> class FlatRangeMap;
 template<typename AddressType, typename EntryType> class RangeMap;
 
 
@@ -211,6 +213,9 @@ class MinidumpMemoryRegion : public MinidumpObject,
  public:
   virtual ~MinidumpMemoryRegion();
 
+  // The largest region that will be read from a minidump into memory.  The
+  // regions of a memory-mapped minidump are used in place, so this doesn't
+  // limit them.
   static void set_max_bytes(uint32_t max_bytes) { max_bytes_ = max_bytes; }
   static uint32_t max_bytes() { return max_bytes_; }
 
@@ -233,6 +238,10 @@ class MinidumpMemoryRegion : public MinidumpObject,
   bool GetMemoryAtAddress(uint64_t address, uint16_t* value) const;
   bool GetMemoryAtAddress(uint64_t address, uint32_t* value) const;
   bool GetMemoryAtAddress(uint64_t address, uint64_t* value) const;
+  size_t GetMemoryAtAddresses(uint64_t address, uint32_t* values,
+                              size_t count) const;
+  size_t GetMemoryAtAddresses(uint64_t address, uint64_t* values,
+                              size_t count) const;
 
   // Print a human-readable representation of the object to stdout.
   void Print() const;
@@ -244,15 +253,26 @@ class MinidumpMemoryRegion : public MinidumpObject,
  private:
   friend class MinidumpThread;
   friend class MinidumpMemoryList;
+  friend class MinidumpMemory64List;
 
   // Identify the base address and size of the memory region, and the
   // location it may be found in the minidump file.
   void SetDescriptor(MDMemoryDescriptor* descriptor);
 
+  // As above, but the region's contents are at location in the minidump
+  // file instead of at the descriptor's RVA, which can't hold the offsets
+  // of the memory in a MEMORY_64_LIST_STREAM.
+  void SetDescriptor(MDMemoryDescriptor* descriptor, off_t location);
+
   // Implementation for GetMemoryAtAddress
   template<typename T> bool GetMemoryAtAddressInternal(uint64_t address,
                                                        T*        value) const;
 
+  // Implementation for GetMemoryAtAddresses
+  template<typename T> size_t GetMemoryAtAddressesInternal(uint64_t address,
+                                                          T* values,
+                                                          size_t count) const;
+
   // Knobs for controlling display of memory printing.
   bool hexdump_;
   unsigned int hexdump_width_;
@@ -263,9 +283,13 @@ class MinidumpMemoryRegion : public MinidumpObject,
   // Base address and size of the memory region, and its position in the
   // minidump file.
   MDMemoryDescriptor* descriptor_;
+  off_t location_;
 
-  // Cached memory.
+  // Cached memory.  In a memory-mapped minidump, memory_view_ points at the
+  // region's contents where they lie in the mapping instead, and memory_
+  // is not used.
   mutable vector<uint8_t>* memory_;
+  mutable const uint8_t* memory_view_;
 };
 
 
@@ -371,6 +395,65 @@ class MinidumpThreadList : public MinidumpStream {
 };
 
 
+// MinidumpThreadNameList corresponds to a minidump's THREAD_NAME_LIST_STREAM
+// stream, which names some or all of the threads in the MinidumpThreadList
+// by thread ID.
+class MinidumpThreadNameList : public MinidumpStream {
+ public:
+  virtual ~MinidumpThreadNameList();
+
+  static void set_max_thread_names(uint32_t max_thread_names) {
+    max_thread_names_ = max_thread_names;
+  }
+  static uint32_t max_thread_names() { return max_thread_names_; }
+
+  unsigned int thread_name_count() const {
+    return valid_ ? thread_name_count_ : 0;
+  }
+
+  // Sequential access to thread names.  Returns false if index is out of
+  // range.
+  bool GetThreadNameAtIndex(unsigned int index,
+                            uint32_t* thread_id,
+                            string* thread_name) const;
+
+  // Random access to thread names.  Returns false if the thread identified
+  // by thread_id is not named.
+  bool GetThreadNameByID(uint32_t thread_id, string* thread_name) const;
+
+  // Print a human-readable representation of the object to stdout.
+  void Print();
+
+ private:
+  friend class Minidump;
+
+  typedef map<uint32_t, unsigned int> IDToIndexMap;
+  typedef vector<uint32_t> ThreadIDs;
+  typedef vector<string> ThreadNames;
+
+  static const uint32_t kStreamType = MD_THREAD_NAME_LIST_STREAM;
+
+  explicit MinidumpThreadNameList(Minidump* aMinidump);
+
+  bool Read(uint32_t aExpectedSize) override;
+
+  // The largest number of thread names that will be read from a minidump.
+  // The default is 4096.
+  static uint32_t max_thread_names_;
+
+  // Access to thread names using the thread ID as the key.
+  IDToIndexMap id_to_index_map_;
+
+  // The thread IDs and their names, in the order they appear in the
+  // stream.
+  ThreadIDs thread_ids_;
+  ThreadNames thread_names_;
+  uint32_t thread_name_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(MinidumpThreadNameList);
+};
+
+
 // MinidumpModule wraps MDRawModule, which contains information about loaded
 // code modules.  Access is provided to various data referenced indirectly
 // by MDRawModule, such as the module's name and a specification for where
@@ -585,6 +668,11 @@ class MinidumpMemoryList : public MinidumpStream {
   // the address identified by address.
   virtual MinidumpMemoryRegion* GetMemoryRegionForAddress(uint64_t address);
 
+  // Returns the region encompassing address or, if there is none, the
+  // lowest region above it, or NULL if every region lies below address.
+  // This allows walking the regions in address order.
+  MinidumpMemoryRegion* GetMemoryRegionAtOrAfterAddress(uint64_t address);
+
   // Print a human-readable representation of the object to stdout.
   void Print();
 
@@ -605,8 +693,10 @@ class MinidumpMemoryList : public MinidumpStream {
   // The default is 256.
   static uint32_t max_regions_;
 
-  // Access to memory regions using addresses as the key.
-  RangeMap<uint64_t, unsigned int> *range_map_;
+  // Access to memory regions using addresses as the key.  This is built
+  // once by Read, and then searched for every pointer a consumer follows,
+  // so it is kept in flat arrays.
+  FlatRangeMap<uint64_t, unsigned int> *range_map_;
 
   // The list of descriptors.  This is maintained separately from the list
   // of regions, because MemoryRegion doesn't own its MemoryDescriptor, it
@@ -622,6 +712,74 @@ class MinidumpMemoryList : public MinidumpStream {
 };
 
 
+// MinidumpMemory64List corresponds to a minidump's MEMORY_64_LIST_STREAM
+// stream, which full-memory minidumps use in place of a MEMORY_LIST_STREAM
+// to reference all of a process' mapped memory.  Its descriptors don't
+// carry RVAs: the regions' contents are stored one after another, in
+// descriptor order, beginning at a single 64-bit RVA.  A region larger than
+// a MinidumpMemoryRegion can describe is presented as several consecutive
+// regions.
+class MinidumpMemory64List : public MinidumpStream {
+ public:
+  virtual ~MinidumpMemory64List();
+
+  static void set_max_regions(uint32_t max_regions) {
+    max_regions_ = max_regions;
+  }
+  static uint32_t max_regions() { return max_regions_; }
+
+  unsigned int region_count() const { return valid_ ? region_count_ : 0; }
+
+  // Sequential access to memory regions.
+  MinidumpMemoryRegion* GetMemoryRegionAtIndex(unsigned int index);
+
+  // Random access to memory regions.  Returns the region encompassing
+  // the address identified by address.
+  virtual MinidumpMemoryRegion* GetMemoryRegionForAddress(uint64_t address);
+
+  // Returns the region encompassing address or, if there is none, the
+  // lowest region above it, or NULL if every region lies below address.
+  // This allows walking the regions in address order.
+  MinidumpMemoryRegion* GetMemoryRegionAtOrAfterAddress(uint64_t address);
+
+  // Print a human-readable representation of the object to stdout.
+  void Print();
+
+ private:
+  friend class Minidump;
+
+  typedef vector<MDMemoryDescriptor>   MemoryDescriptors;
+  typedef vector<off_t>                MemoryLocations;
+  typedef vector<MinidumpMemoryRegion> MemoryRegions;
+
+  static const uint32_t kStreamType = MD_MEMORY_64_LIST_STREAM;
+
+  explicit MinidumpMemory64List(Minidump* minidump);
+
+  bool Read(uint32_t expected_size) override;
+
+  // The largest number of memory ranges that will be read from a minidump.
+  // The default is 65536.
+  static uint32_t max_regions_;
+
+  // Access to memory regions using addresses as the key, as in
+  // MinidumpMemoryList.
+  FlatRangeMap<uint64_t, unsigned int> *range_map_;
+
+  // The base address and size of each region, in the form the regions
+  // refer to.  The descriptors' RVAs are unused; locations_ holds the
+  // position of each region's contents in the minidump file instead.
+  MemoryDescriptors *descriptors_;
+  MemoryLocations *locations_;
+
+  // The list of regions.
+  MemoryRegions *regions_;
+  uint32_t region_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(MinidumpMemory64List);
+};
+
+
 // MinidumpException wraps MDRawExceptionStream, which contains information
 // about the exception that caused the minidump to be generated, if the
 // minidump was generated in an exception handler called as a result of an
@@ -927,6 +1085,7 @@ class MinidumpBreakpadInfo : public MinidumpStream {
 
  private:
   friend class Minidump;
+  friend class TestMinidumpBreakpadInfo;
 
   static const uint32_t kStreamType = MD_BREAKPAD_INFO_STREAM;
 
@@ -1140,7 +1299,10 @@ class MinidumpCrashpadInfo : public MinidumpStream {
 // and provides access to the minidump's top-level stream directory.
 class Minidump {
  public:
-  // path is the pathname of a file containing the minidump.
+  // path is the pathname of a file containing the minidump.  Where the
+  // system supports it, the file is mapped into memory rather than read,
+  // so that the contents of memory regions are used in place instead of
+  // being copied.
   explicit Minidump(const string& path,
                     bool hexdump=false,
                     unsigned int hexdump_width=16);
@@ -1148,6 +1310,11 @@ class Minidump {
   // weak pointer to input, and the caller must ensure that the stream
   // is valid as long as the Minidump object is.
   explicit Minidump(std::istream& input);
+  // source supplies the minidump's data, possibly while it is still being
+  // received, in which case reads wait for the data they need to arrive.
+  // Minidump holds a weak pointer to source, and the caller must ensure
+  // that it is valid as long as the Minidump object is.
+  explicit Minidump(MinidumpDataSource* source);
 
   virtual ~Minidump();
 
@@ -1188,8 +1355,10 @@ class Minidump {
   // to avoid exposing an ugly API (GetStream needs to accept a garbage
   // parameter).
   virtual MinidumpThreadList* GetThreadList();
+  virtual MinidumpThreadNameList* GetThreadNameList();
   virtual MinidumpModuleList* GetModuleList();
   virtual MinidumpMemoryList* GetMemoryList();
+  virtual MinidumpMemory64List* GetMemory64List();
   virtual MinidumpException* GetException();
   virtual MinidumpAssertion* GetAssertion();
   virtual MinidumpSystemInfo* GetSystemInfo();
@@ -1212,7 +1381,8 @@ class Minidump {
   }
   const MDRawDirectory* GetDirectoryEntryAtIndex(unsigned int index) const;
 
-  // The next 2 methods are lower-level I/O routines.  They use fd_.
+  // The next methods are lower-level I/O routines.  They use the file
+  // mapping, or stream_ if the minidump is not memory-mapped.
 
   // Reads count bytes from the minidump at the current position into
   // the storage area pointed to by bytes.  bytes must be of sufficient
@@ -1225,6 +1395,22 @@ class Minidump {
   // Returns the current position of the minidump file.
   off_t Tell();
 
+  // Sets *size to the size of the minidump file, leaving its position
+  // unchanged.  Returns false if the size can't be determined.  For a
+  // minidump read from a data source, waits until all of it has arrived.
+  bool GetFileSize(uint64_t* size);
+
+  // Like GetFileSize, but returns false instead of waiting if the minidump
+  // is read from a data source and hasn't all arrived yet.
+  bool GetFileSizeIfKnown(uint64_t* size);
+
+  // Returns a pointer to the count bytes at offset in the minidump, without
+  // copying them, if the minidump is memory-mapped and holds that many
+  // bytes there.  The bytes stay valid as long as the Minidump does.
+  // Returns NULL otherwise, and the bytes must be read with ReadBytes.
+  // The file position is not changed.
+  const uint8_t* GetMappedBytes(off_t offset, size_t count) const;
+
   // Medium-level I/O routines.
 
   // ReadString returns a string which is owned by the caller!  offset
@@ -1294,6 +1480,14 @@ class Minidump {
   // Opens the minidump file, or if already open, seeks to the beginning.
   bool Open();
 
+  // Maps the minidump file at path_ into memory, returning false if that
+  // isn't possible, in which case Open falls back to reading the file
+  // through an ifstream.
+  bool MapFile();
+
+  // Unmaps the minidump file, if it is mapped.
+  void UnmapFile();
+
   // The largest number of top-level streams that will be read from a minidump.
   // Note that streams are only read (and only consume memory) as needed,
   // when directed by the caller.  The default is 128.
@@ -1321,6 +1515,19 @@ class Minidump {
   // Set based on the path in Open, or directly in the constructor.
   std::istream*             stream_;
 
+  // The data source supplying the minidump, set in the constructor, or
+  // NULL.  source_position_ is the file position used by ReadBytes and
+  // SeekSet.
+  MinidumpDataSource*       source_;
+  off_t                     source_position_;
+
+  // The minidump file, mapped into memory by Open, or NULL if it was not
+  // mapped, in which case stream_ is used instead.  mapped_position_ is
+  // the file position used by ReadBytes and SeekSet.
+  const uint8_t*            mapped_data_;
+  size_t                    mapped_size_;
+  off_t                     mapped_position_;
+
   // swap_ is true if the minidump file should be byte-swapped.  If the
   // minidump was produced by a CPU that is other-endian than the CPU
   // processing the minidump, this will be true.  If the two CPUs are
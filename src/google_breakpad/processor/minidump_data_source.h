@@ -0,0 +1,143 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// minidump_data_source.h: MinidumpDataSource supplies a minidump's bytes
+// to a Minidump that does not read them from a file or stream.
+//
+// Unlike an istream, a data source may be asked for bytes that have not
+// arrived yet, and waits for them.  GrowingMinidumpDataSource holds a
+// minidump that is still being received, so that a Minidump can be read
+// and processed while it arrives: the header, stream directory, exception,
+// module list and thread list are usually near the start of the file, and
+// can be used before the rest of it is available.  A read that waits for
+// bytes that never arrive waits until the data source's ProcessDeadline, if
+// it has one, passes.
+
+#ifndef GOOGLE_BREAKPAD_PROCESSOR_MINIDUMP_DATA_SOURCE_H__
+#define GOOGLE_BREAKPAD_PROCESSOR_MINIDUMP_DATA_SOURCE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+namespace google_breakpad {
+
+class ProcessDeadline;
+
+class MinidumpDataSource {
+ public:
+  virtual ~MinidumpDataSource() {}
+
+  // Copies the count bytes at offset into buffer, waiting for them to
+  // arrive if necessary.  Returns false if they never will, because they
+  // lie beyond the end of the minidump or it could not be received.
+  virtual bool Read(uint64_t offset, void* buffer, size_t count) = 0;
+
+  // Sets *size to the size of the whole minidump, waiting until it is
+  // known.  Returns false if it never will be.
+  virtual bool GetSize(uint64_t* size) = 0;
+
+  // Sets *size to the size of the whole minidump if it is already known,
+  // without waiting.  Returns false if it isn't known yet.  Readers that
+  // only use the size to check offsets can use this and otherwise rely on
+  // Read failing, so as not to wait for the whole minidump to arrive.
+  virtual bool GetSizeIfKnown(uint64_t* size) { return GetSize(size); }
+};
+
+// A data source to which a minidump's bytes are appended, in order, as they
+// are received.  Append, Finish and Abort may be called on one thread while
+// a Minidump reads the data source on another.
+class GrowingMinidumpDataSource : public MinidumpDataSource {
+ public:
+  GrowingMinidumpDataSource();
+  virtual ~GrowingMinidumpDataSource();
+
+  // Appends the next size bytes of the minidump, waking any reader waiting
+  // for them.  Does nothing after Finish or Abort.
+  void Append(const void* data, size_t size);
+
+  // Marks the minidump as complete.  Reads beyond its end then fail rather
+  // than wait.
+  void Finish();
+
+  // Marks the minidump as never being completed, for example because its
+  // upload failed.  Reads of bytes that have not arrived then fail rather
+  // than wait, while bytes that have arrived can still be read.
+  void Abort();
+
+  // Returns the number of bytes that have arrived so far.
+  uint64_t available() const;
+
+  // Makes Read and GetSize stop waiting, and fail, once |deadline| passes
+  // or is cancelled, so that a minidump whose upload stalls without Finish
+  // or Abort being called can't hold up its processing forever.  Bytes
+  // that have arrived can still be read.  deadline may be NULL, the
+  // default, to wait for as long as it takes.  Cancelling deadline wakes
+  // waiting readers at once.  Does not take ownership of deadline, which
+  // must outlive the data source unless it is replaced first.
+  void set_deadline(const ProcessDeadline* deadline);
+
+  virtual bool Read(uint64_t offset, void* buffer, size_t count);
+
+  // Waits for Finish, since the size isn't known until then.
+  virtual bool GetSize(uint64_t* size);
+
+  // Returns false, without waiting, until Finish has been called.
+  virtual bool GetSizeIfKnown(uint64_t* size);
+
+ private:
+  // Waits for changed_ to be signaled or deadline_ to pass, returning false
+  // without waiting if deadline_ has already passed or been cancelled.
+  // deadline_ signals changed_ when it is cancelled.  lock must hold
+  // mutex_.
+  bool WaitForChange(std::unique_lock<std::mutex>* lock);
+
+  // Protects the members below.
+  mutable std::mutex mutex_;
+
+  // Signaled when bytes arrive and when the data source is finished or
+  // aborted.
+  std::condition_variable changed_;
+
+  std::vector<uint8_t> data_;
+  bool finished_;
+  bool aborted_;
+  const ProcessDeadline* deadline_;
+
+  // Disallow copy constructor and assignment operator.
+  GrowingMinidumpDataSource(const GrowingMinidumpDataSource& that);
+  void operator=(const GrowingMinidumpDataSource& that);
+};
+
+}  // namespace google_breakpad
+
+#endif  // GOOGLE_BREAKPAD_PROCESSOR_MINIDUMP_DATA_SOURCE_H__
@@ -40,12 +40,34 @@
 namespace google_breakpad {
 
 class Minidump;
+class ProcessDeadline;
 class ProcessState;
 class StackFrameSymbolizer;
 class SourceLineResolverInterface;
 class SymbolSupplier;
 struct SystemInfo;
 
+// Selects how much of a minidump MinidumpProcessor::Process examines.  The
+// defaults examine all of it.  A triage pipeline that only needs the crash
+// reason and the crashing thread's stack can skip the rest, and with it the
+// cost of reading those parts of the minidump and walking their stacks.
+struct ProcessOptions {
+  ProcessOptions()
+      : walk_all_threads(true),
+        process_unloaded_modules(true) {}
+
+  // If false, only the requesting thread, which is the thread that crashed
+  // or that asked for the dump to be written, is walked and placed in the
+  // ProcessState.  The contexts and stacks of other threads are never read.
+  // No thread is walked if the minidump doesn't identify the requesting
+  // thread.
+  bool walk_all_threads;
+
+  // If false, the unloaded module list is not read, and frames are never
+  // attributed to unloaded modules.
+  bool process_unloaded_modules;
+};
+
 class MinidumpProcessor {
  public:
   // Initializes this MinidumpProcessor.  supplier should be an
@@ -75,8 +97,28 @@ class MinidumpProcessor {
 
   // Processes the minidump structure and fills process_state with the
   // result.
+  //
+  // Process may be called on several threads at once, for different
+  // minidumps, if the StackFrameSymbolizer is safe to use from several
+  // threads as described for set_stackwalk_threads.  The minidumps then
+  // share the symbols it loads.
   ProcessResult Process(Minidump* minidump,
                         ProcessState* process_state);
+
+  // As above, but stops walking stacks once |deadline| passes or is
+  // cancelled.  Processing then still succeeds, leaving process_state
+  // truncated(): the stacks being walked keep the frames found so far,
+  // and the threads not yet walked only their unsymbolized context
+  // frames.  Exploitability is not analyzed for a truncated ProcessState.
+  // deadline may be NULL, for no deadline.  Does not take ownership of
+  // deadline.
+  ProcessResult Process(const string &minidump_file,
+                        ProcessState* process_state,
+                        const ProcessDeadline* deadline);
+  ProcessResult Process(Minidump* minidump,
+                        ProcessState* process_state,
+                        const ProcessDeadline* deadline);
+
   // Populates the cpu_* fields of the |info| parameter with textual
   // representations of the CPU type that the minidump in |dump| was
   // produced on.  Returns false if this information is not available in
@@ -127,6 +169,24 @@ class MinidumpProcessor {
 
   void set_enable_objdump(bool enabled) { enable_objdump_ = enabled; }
 
+  // Sets the number of worker threads used to walk thread stacks.  With the
+  // default of 1, threads are walked one after another on the calling
+  // thread.  With more, the stacks of different threads are walked
+  // concurrently; the resulting ProcessState is identical, with threads in
+  // the same order.  The StackFrameSymbolizer (and the resolver and symbol
+  // supplier behind it) is then shared by all workers, so it must be safe
+  // to use from several threads, as StackFrameSymbolizer with a
+  // SourceLineResolverBase-derived resolver is.
+  void set_stackwalk_threads(int threads) {
+    stackwalk_threads_ = threads > 0 ? threads : 1;
+  }
+
+  // Sets which parts of each minidump Process examines.
+  void set_process_options(const ProcessOptions& options) {
+    process_options_ = options;
+  }
+  const ProcessOptions& process_options() const { return process_options_; }
+
  private:
   StackFrameSymbolizer* frame_symbolizer_;
   // Indicate whether resolver_helper_ is owned by this instance.
@@ -140,6 +200,12 @@ class MinidumpProcessor {
   // This flag permits the exploitability scanner to shell out to objdump
   // for purposes of disassembly.
   bool enable_objdump_;
+
+  // The number of threads used to walk thread stacks.
+  int stackwalk_threads_;
+
+  // Which parts of each minidump are examined.
+  ProcessOptions process_options_;
 };
 
 }  // namespace google_breakpad
@@ -0,0 +1,144 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// minidump_validator.h: MinidumpValidator checks that a minidump is
+// structurally sound before it is processed.
+//
+// MinidumpProcessor reads the minidump's streams into objects whose sizes
+// are determined by counts in the minidump, and only then discovers that
+// the counts don't match the data.  MinidumpValidator checks the stream
+// directory and the fixed-size parts of the streams MinidumpProcessor uses
+// against each other and the size of the file, reading each record once
+// and keeping none of them, so that it runs in bounded memory and in time
+// proportional to the number of records.  It is stricter than processing,
+// which salvages what it can from some malformed streams, and a minidump
+// that it accepts may still be rejected by processing.
+
+#ifndef GOOGLE_BREAKPAD_PROCESSOR_MINIDUMP_VALIDATOR_H__
+#define GOOGLE_BREAKPAD_PROCESSOR_MINIDUMP_VALIDATOR_H__
+
+#include <string>
+
+#include "common/using_std_string.h"
+#include "google_breakpad/common/breakpad_types.h"
+#include "google_breakpad/common/minidump_format.h"
+
+namespace google_breakpad {
+
+class Minidump;
+
+class MinidumpValidator {
+ public:
+  enum Result {
+    // No problems were found.
+    VALID = 0,
+
+    // The header or stream directory could not be read.
+    INVALID_HEADER,
+
+    // A stream lies outside the file or overlaps the header, the directory
+    // or another stream.
+    INVALID_STREAM_LOCATION,
+
+    // A stream's size doesn't agree with the number of records it claims to
+    // hold, or the records could not be read.
+    INVALID_STREAM_SIZE,
+
+    // A stream holds more records than Minidump will read.
+    TOO_MANY_RECORDS,
+
+    // Data referred to by a record, such as a thread's stack or a module's
+    // name, lies outside the file.
+    INVALID_DATA_LOCATION,
+
+    // A CPU context is not the size of any context Minidump can read.
+    INVALID_CONTEXT_SIZE
+  };
+
+  MinidumpValidator();
+
+  // Checks |dump|, which must not have been read yet, reading its header
+  // and directory with Minidump::Read.  Returns VALID if no problems were
+  // found, or the first problem found.  Every check is against the size of
+  // the file, so for a minidump read from a MinidumpDataSource this waits
+  // until all of it has arrived.
+  Result Validate(Minidump *dump);
+
+  // A description of the first problem found by the last call to
+  // Validate, for logging.  Empty if it returned VALID.
+  const string &error() const { return error_; }
+
+  // Returns a short name for |result|.
+  static const char *ResultString(Result result);
+
+ private:
+  // Each of these checks the stream with the given directory entry,
+  // positioned at its start, returning VALID or the problem found.
+  Result ValidateThreadList(Minidump *dump, const MDRawDirectory &entry);
+  Result ValidateThreadNameList(Minidump *dump, const MDRawDirectory &entry);
+  Result ValidateModuleList(Minidump *dump, const MDRawDirectory &entry);
+  Result ValidateMemoryList(Minidump *dump, const MDRawDirectory &entry);
+  Result ValidateMemory64List(Minidump *dump, const MDRawDirectory &entry);
+  Result ValidateException(Minidump *dump, const MDRawDirectory &entry);
+
+  // Reads the record count at the start of the list stream |entry|, and
+  // checks that the stream holds that many records of |record_size| bytes,
+  // allowing for the 4 bytes of padding some writers add after the count
+  // when |may_be_padded| is true.  The count must also be no more than
+  // |max_count|.  On success, sets *count and leaves the minidump
+  // positioned at the first record.
+  Result ReadListCount(Minidump *dump,
+                       const MDRawDirectory &entry,
+                       const char *stream_name,
+                       size_t record_size,
+                       bool may_be_padded,
+                       uint32_t max_count,
+                       uint32_t *count);
+
+  // Checks that |size| bytes at |rva| lie within the file.
+  Result CheckLocation(uint64_t rva, uint64_t size, const char *what,
+                       uint32_t index);
+
+  // Checks that |location| lies within the file and holds a CPU context of
+  // a size Minidump can read.
+  Result CheckContext(const MDLocationDescriptor &location, const char *what,
+                      uint32_t index);
+
+  // Records a description of a problem and returns |result|.
+  Result Fail(Result result, const string &error);
+
+  // The size of the minidump being validated.
+  uint64_t file_size_;
+
+  string error_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // GOOGLE_BREAKPAD_PROCESSOR_MINIDUMP_VALIDATOR_H__
@@ -0,0 +1,132 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// process_deadline.h: ProcessDeadline bounds the time MinidumpProcessor
+// spends on one minidump.
+//
+// When a ProcessDeadline passes, or is cancelled, MinidumpProcessor stops
+// walking stacks as soon as it can, keeping the frames found so far, and
+// marks each stack it stopped, and each thread it never walked, with the
+// reason.  See CallStack::truncation() and ProcessState::truncated().
+
+#ifndef GOOGLE_BREAKPAD_PROCESSOR_PROCESS_DEADLINE_H__
+#define GOOGLE_BREAKPAD_PROCESSOR_PROCESS_DEADLINE_H__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "google_breakpad/processor/call_stack.h"
+
+namespace google_breakpad {
+
+class ProcessDeadline {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  // A deadline that never passes.  Processing only stops early if the
+  // deadline is cancelled.
+  ProcessDeadline() : expiry_(Clock::time_point::max()), cancelled_(false) {}
+
+  // A deadline |budget| from now.
+  explicit ProcessDeadline(Clock::duration budget)
+      : expiry_(Clock::now() + budget), cancelled_(false) {}
+
+  // Stops processing as soon as possible, waking the threads waiting on
+  // the condition variables passed to AddWaiter().  May be called from any
+  // thread, while the minidump is being processed on another.
+  void Cancel() {
+    cancelled_.store(true, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(waiters_mutex_);
+    for (size_t i = 0; i < waiters_.size(); ++i) {
+      std::lock_guard<std::mutex> waiter_lock(*waiters_[i].first);
+      waiters_[i].second->notify_all();
+    }
+  }
+
+  // Makes Cancel() notify all threads waiting on |waiter|, with |mutex|
+  // held, until RemoveWaiter() is called for it.  A thread that waits on
+  // |waiter| for something else can then stop waiting when the deadline
+  // is cancelled, provided it checks Passed() with |mutex| held before
+  // each wait.  Must not be called with |mutex| held.
+  void AddWaiter(std::mutex* mutex, std::condition_variable* waiter) const {
+    std::lock_guard<std::mutex> lock(waiters_mutex_);
+    waiters_.push_back(std::make_pair(mutex, waiter));
+  }
+
+  // Undoes one AddWaiter() call for |waiter|.  Must not be called with its
+  // mutex held.
+  void RemoveWaiter(std::condition_variable* waiter) const {
+    std::lock_guard<std::mutex> lock(waiters_mutex_);
+    for (size_t i = 0; i < waiters_.size(); ++i) {
+      if (waiters_[i].second == waiter) {
+        waiters_.erase(waiters_.begin() + i);
+        return;
+      }
+    }
+  }
+
+  // Returns CALL_STACK_CANCELLED if Cancel() has been called,
+  // CALL_STACK_DEADLINE_PASSED if the deadline has passed, and
+  // CALL_STACK_NOT_TRUNCATED otherwise.  May be called from any thread.
+  CallStackTruncation Check() const {
+    if (cancelled_.load(std::memory_order_relaxed))
+      return CALL_STACK_CANCELLED;
+    if (expiry_ != Clock::time_point::max() && Clock::now() >= expiry_)
+      return CALL_STACK_DEADLINE_PASSED;
+    return CALL_STACK_NOT_TRUNCATED;
+  }
+
+  // Returns true if processing should stop.
+  bool Passed() const { return Check() != CALL_STACK_NOT_TRUNCATED; }
+
+  // Returns when the deadline passes, or Clock::time_point::max() if it
+  // never does.  Cancelling the deadline does not change this.
+  Clock::time_point expiry() const { return expiry_; }
+
+ private:
+  const Clock::time_point expiry_;
+  std::atomic<bool> cancelled_;
+
+  // The condition variables Cancel() notifies, each with its mutex.
+  mutable std::mutex waiters_mutex_;
+  mutable std::vector<std::pair<std::mutex*, std::condition_variable*> >
+      waiters_;
+
+  // Disallow copy constructor and assignment operator.
+  ProcessDeadline(const ProcessDeadline& that);
+  void operator=(const ProcessDeadline& that);
+};
+
+}  // namespace google_breakpad
+
+#endif  // GOOGLE_BREAKPAD_PROCESSOR_PROCESS_DEADLINE_H__
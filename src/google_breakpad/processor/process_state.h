@@ -125,11 +125,18 @@ class ProcessState {
   }
   ExploitabilityRating exploitability() const { return exploitability_; }
 
+  // Returns true if processing stopped at its deadline, or was cancelled,
+  // before every thread's stack had been walked.  The threads whose stacks
+  // are incomplete say so in their truncation().  See ProcessDeadline.
+  bool truncated() const;
+
  private:
   // MinidumpProcessor and MicrodumpProcessor are responsible for building
-  // ProcessState objects.
+  // ProcessState objects, and ProcessStateSerializer for rebuilding them
+  // from their serialized form.
   friend class MinidumpProcessor;
   friend class MicrodumpProcessor;
+  friend class ProcessStateSerializer;
 
   // The time-date stamp of the minidump (time_t format)
   uint32_t time_date_stamp_;
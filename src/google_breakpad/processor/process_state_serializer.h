@@ -0,0 +1,77 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// process_state_serializer.h: ProcessStateSerializer converts a
+// ProcessState to and from a compact binary form.
+//
+// A processed minidump serialized this way can be cached, passed between
+// processes and rendered again later without walking its stacks again.
+//
+// The serialized form holds everything in the ProcessState except the
+// memory of each thread's stack: a deserialized ProcessState's
+// thread_memory_regions() are all NULL.  Integers are written as LEB128
+// variable-length quantities, with signed values zigzag-encoded, so that
+// the form does not depend on the byte order of the machine writing it;
+// a string is its length followed by its bytes.  A frame's module is
+// written as a reference into the module lists.  Each frame's CPU context
+// is written as its context_validity followed by the registers it marks
+// valid; the rest of the raw MDRawContext* structure is not kept, and
+// reads back as zero.
+
+#ifndef GOOGLE_BREAKPAD_PROCESSOR_PROCESS_STATE_SERIALIZER_H__
+#define GOOGLE_BREAKPAD_PROCESSOR_PROCESS_STATE_SERIALIZER_H__
+
+#include <stddef.h>
+
+#include <string>
+
+#include "common/using_std_string.h"
+
+namespace google_breakpad {
+
+class ProcessState;
+
+class ProcessStateSerializer {
+ public:
+  // Returns true if the size bytes at data begin the way a serialized
+  // ProcessState does.
+  static bool IsSerializedProcessState(const char* data, size_t size);
+
+  // Sets *data to the serialized form of state.
+  static void Serialize(const ProcessState& state, string* data);
+
+  // Replaces the contents of state with the ProcessState serialized in the
+  // size bytes at data.  Returns false, leaving state cleared, if they do
+  // not hold a ProcessState serialized by this version of the format.
+  static bool Deserialize(const char* data, size_t size, ProcessState* state);
+};
+
+}  // namespace google_breakpad
+
+#endif  // GOOGLE_BREAKPAD_PROCESSOR_PROCESS_STATE_SERIALIZER_H__
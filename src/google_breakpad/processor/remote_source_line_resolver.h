@@ -0,0 +1,188 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// remote_source_line_resolver.h: RemoteSourceLineResolver forwards symbol
+// lookups to a breakpad_symbolizer server.
+//
+// The server loads symbols with its own symbol supplier and keeps them
+// loaded across the many processes that use it, so that each need not load
+// the same symbols again.  A MinidumpProcessor using this resolver needs no
+// symbol supplier of its own.
+//
+// Each request is a round trip to the server.  Requests from different
+// threads go over connections of their own, opened as needed and kept for
+// later requests, so that concurrent stack walks don't wait on each
+// other's round trips.
+
+#ifndef GOOGLE_BREAKPAD_PROCESSOR_REMOTE_SOURCE_LINE_RESOLVER_H__
+#define GOOGLE_BREAKPAD_PROCESSOR_REMOTE_SOURCE_LINE_RESOLVER_H__
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/source_line_resolver_interface.h"
+
+namespace google_breakpad {
+
+class SymbolizerMessageWriter;
+
+class RemoteSourceLineResolver : public SourceLineResolverInterface {
+ public:
+  // Uses the server listening on the Unix domain socket socket_path.  A
+  // connection the server closes, as when it restarts, is replaced by a
+  // new one.  After a failed attempt to connect, requests fail without
+  // trying again for a while, from kMinConnectDelayMs doubling up to
+  // kMaxConnectDelayMs as attempts keep failing.
+  explicit RemoteSourceLineResolver(const string &socket_path);
+
+  // Uses the server at the other end of the connected socket fd, which the
+  // resolver takes ownership of.  Requests from different threads take
+  // turns on it, and fail once it is closed.
+  explicit RemoteSourceLineResolver(int fd);
+
+  virtual ~RemoteSourceLineResolver();
+
+  static const int kMinConnectDelayMs = 100;
+  static const int kMaxConnectDelayMs = 10000;
+
+  // Connects to the server, returning false on failure.  Requests connect
+  // as needed, so this need only be called to find out early whether the
+  // server can be reached.
+  bool Connect();
+
+  // Sets the size beyond which address lookups are split over several
+  // requests.  The default, and the largest size the server accepts, is
+  // kSymbolizerMaxMessageSize.
+  void set_max_request_size(size_t size) { max_request_size_ = size; }
+
+  // The server loads symbols itself, so these do nothing and return false.
+  virtual bool LoadModule(const CodeModule *module, const string &map_file);
+  virtual bool LoadModuleUsingMapBuffer(const CodeModule *module,
+                                        const string &map_buffer);
+  virtual bool LoadModuleUsingMemoryBuffer(const CodeModule *module,
+                                           char *memory_buffer,
+                                           size_t memory_buffer_size);
+  virtual bool ShouldDeleteMemoryBufferAfterLoadModule() { return true; }
+
+  // Forgets whether the server has symbols for module; the server itself
+  // decides how long to keep them loaded.
+  virtual void UnloadModule(const CodeModule *module);
+
+  // Asks the server to load module's symbols, if it has not been asked
+  // already, and returns true if it has them.
+  virtual bool HasModule(const CodeModule *module);
+
+  virtual bool SuppliesOwnSymbols() { return true; }
+
+  virtual bool IsModuleCorrupt(const CodeModule *module);
+
+  virtual void FillSourceLineInfo(StackFrame *frame);
+  virtual void FillSourceLineInfo(StackFrame *frame,
+                                  std::vector<StackFrame*> *inlined_frames);
+
+  // Looks up every frame with as few requests to the server as the
+  // message size limit allows.
+  virtual void FillSourceLineInfo(
+      const CodeModule *module,
+      const std::vector<StackFrame*> &frames,
+      std::vector<std::vector<StackFrame*> > *inlined_frames);
+
+  virtual WindowsFrameInfo *FindWindowsFrameInfo(const StackFrame *frame);
+  virtual CFIFrameInfo *FindCFIFrameInfo(const StackFrame *frame);
+
+  // Keys modules by debug file and debug identifier, as the server does.
+  virtual string ModuleKey(const CodeModule *module) const;
+
+ private:
+  // What the server said about a module's symbols.
+  struct ModuleState {
+    bool loaded;
+    bool corrupt;
+  };
+
+  // Returns true if HasModule found that the server has module's symbols.
+  // As with the resolvers that load symbols themselves, lookups in a module
+  // find nothing until HasModule has been asked about it.
+  bool IsLoaded(const CodeModule *module);
+
+  // Sends the request in writer, which must begin with the operation and
+  // module, and receives the rest of the response, after the load status
+  // and corrupt flag, into *response.  Returns true if the server has
+  // module's symbols.
+  bool Exchange(const CodeModule *module,
+                const SymbolizerMessageWriter &writer,
+                string *response);
+
+  // Returns a connection for one request, opening one if none is idle, or
+  // -1 if there is none to be had.  Each connection returned must be
+  // handed back to ReleaseConnection().
+  int AcquireConnection();
+
+  // Makes fd idle again, or closes it if broken, along with the idle
+  // connections, which are likely broken too.
+  void ReleaseConnection(int fd, bool broken);
+
+  // Connects to socket_path_, returning the socket, or -1 on failure.
+  int OpenConnection() const;
+
+  string socket_path_;
+  size_t max_request_size_;
+
+  // Guards everything below.  It is not held during round trips.
+  std::mutex mutex_;
+
+  // The connections not in use, and the number open in all.
+  std::vector<int> idle_fds_;
+  int connections_;
+  // Signalled when a connection is released.
+  std::condition_variable connection_released_;
+
+  // No connection is attempted before next_connect_time_, which a failed
+  // attempt puts connect_delay_ms_ into the future.
+  std::chrono::steady_clock::time_point next_connect_time_;
+  int connect_delay_ms_;
+
+  // The modules the server has answered for, by ModuleKey.  A module is
+  // only absent if it was never asked about or its symbol supplier was
+  // interrupted, so that the question is asked again.
+  std::map<string, ModuleState> module_states_;
+
+  // Disallow copy constructor and assignment operator.
+  RemoteSourceLineResolver(const RemoteSourceLineResolver &that);
+  void operator=(const RemoteSourceLineResolver &that);
+};
+
+}  // namespace google_breakpad
+
+#endif  // GOOGLE_BREAKPAD_PROCESSOR_REMOTE_SOURCE_LINE_RESOLVER_H__
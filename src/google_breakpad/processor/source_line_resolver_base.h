@@ -41,9 +41,13 @@
 #ifndef GOOGLE_BREAKPAD_PROCESSOR_SOURCE_LINE_RESOLVER_BASE_H__
 #define GOOGLE_BREAKPAD_PROCESSOR_SOURCE_LINE_RESOLVER_BASE_H__
 
+#include <list>
 #include <map>
+#include <mutex>
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "google_breakpad/processor/source_line_resolver_interface.h"
 
@@ -68,6 +72,82 @@ class SourceLineResolverBase : public SourceLineResolverInterface {
                              char **symbol_data,
                              size_t *symbol_data_size);
 
+  // Counters describing the use of the loaded modules, as a cache of parsed
+  // symbols.  See set_symbol_data_budget().
+  struct ModuleCacheStats {
+    // Number of modules loaded, each from symbol data that had to be read
+    // for it.
+    uint64_t loads;
+    // Number of those loads that reloaded a module evicted to stay within
+    // the budget: the loads a larger budget would have saved.
+    uint64_t reloads;
+    // Number of modules unloaded to stay within the budget.
+    uint64_t evictions;
+    // Number of modules currently loaded.
+    size_t modules;
+    // Total size of the symbol data the loaded modules were loaded from.
+    // This is the size of the symbol files, not of the memory the parsed
+    // modules take up.
+    size_t symbol_data_bytes;
+  };
+
+  // Bounds the symbols kept loaded to |budget| bytes of symbol data,
+  // counting each module as the size of the symbol data it was loaded
+  // from rather than the memory its parsed form takes up.  Whenever
+  // loading a module takes the total over the budget, the least recently
+  // used modules are unloaded until it fits again.  The module just loaded,
+  // modules pinned with PinModule() and modules being looked up are never
+  // unloaded this way, so the budget may be exceeded while they are in use.
+  // The default budget, 0, means modules stay loaded until UnloadModule().
+  // A resolver kept across many dumps should also key its modules by
+  // debug identifier; see set_key_by_debug_identifier().
+  void set_symbol_data_budget(size_t budget);
+
+  // By default, modules are loaded under their code file, so two builds
+  // of a module with the same code file share whichever symbols were
+  // loaded first.  Enabling this loads them under their debug file and
+  // debug identifier instead (or under their code file, for modules
+  // without a debug identifier), which tells builds apart and lets copies
+  // of one build loaded from different paths share their symbols.  Any
+  // resolver that serves more than one dump should enable it.  The keying
+  // can only change while no module is loaded; otherwise this returns
+  // false and changes nothing.
+  bool set_key_by_debug_identifier(bool enabled);
+
+  ModuleCacheStats module_cache_stats();
+
+  // Counters describing the cache of CFI rule sets FindCFIFrameInfo()
+  // keeps.  See set_cfi_cache_capacity().
+  struct CFICacheStats {
+    // Number of FindCFIFrameInfo() calls answered from the cache.
+    uint64_t hits;
+    // Number of FindCFIFrameInfo() calls that built the rules from a
+    // loaded module's STACK CFI records.
+    uint64_t misses;
+    // Number of rule sets dropped to stay within the capacity.
+    uint64_t evictions;
+    // Number of rule sets currently cached.
+    size_t entries;
+  };
+
+  // Bounds the CFI rule sets FindCFIFrameInfo() keeps to |capacity|.
+  // Building the rules at an address means replaying the module's STACK
+  // CFI records up to it; once built, they are kept by module and
+  // module-relative address and reused, along with the program a stack
+  // walker compiles from them, by later lookups in any stack or dump.
+  // Addresses with no CFI are remembered too.  Whenever there are more
+  // than |capacity|, the least recently used are dropped.  A capacity of
+  // 0 disables the cache; the default is kDefaultCFICacheCapacity.
+  void set_cfi_cache_capacity(size_t capacity);
+
+  CFICacheStats cfi_cache_stats();
+
+  static const size_t kDefaultCFICacheCapacity = 4096;
+
+  // Returns the key |module|'s symbols are loaded under, as chosen by
+  // set_key_by_debug_identifier().
+  virtual string ModuleKey(const CodeModule *module) const;
+
  protected:
   // Users are not allowed create SourceLineResolverBase instance directly.
   SourceLineResolverBase(ModuleFactory *module_factory);
@@ -84,7 +164,15 @@ class SourceLineResolverBase : public SourceLineResolverInterface {
   virtual void UnloadModule(const CodeModule *module);
   virtual bool HasModule(const CodeModule *module);
   virtual bool IsModuleCorrupt(const CodeModule *module);
+  virtual void PinModule(const CodeModule *module);
+  virtual void UnpinModule(const CodeModule *module);
   virtual void FillSourceLineInfo(StackFrame *frame);
+  virtual void FillSourceLineInfo(StackFrame *frame,
+                                  std::vector<StackFrame*> *inlined_frames);
+  virtual void FillSourceLineInfo(
+      const CodeModule *module,
+      const std::vector<StackFrame*> &frames,
+      std::vector<std::vector<StackFrame*> > *inlined_frames);
   virtual WindowsFrameInfo *FindWindowsFrameInfo(const StackFrame *frame);
   virtual CFIFrameInfo *FindCFIFrameInfo(const StackFrame *frame);
 
@@ -99,6 +187,29 @@ class SourceLineResolverBase : public SourceLineResolverInterface {
   class Module;
   class AutoFileCloser;
 
+  // Returns true if a module is loaded under |key|, without marking it as
+  // recently used.
+  bool IsModuleLoaded(const string &key);
+
+  // Returns the module loaded under |key|, or NULL if there is none.  The
+  // module is held loaded until the matching ReleaseModule() call, so it
+  // may be used without holding modules_mutex_.  If |generation| is not
+  // NULL, it is set to the module's load generation, which tells this
+  // loading of the module apart from any other under the same key.
+  Module *AcquireModule(const string &key, uint64_t *generation = NULL);
+  void ReleaseModule(const string &key);
+
+  // Frees the symbol data the module loaded under |key| was loaded from,
+  // when it is unloaded.  Called with modules_mutex_ held.
+  virtual void ReleaseModuleData(const string &key);
+
+  // Returns true if loaded modules point into the symbol data they were
+  // loaded from, which must then live as long as they do.  If this is true
+  // while ShouldDeleteMemoryBufferAfterLoadModule() is also true, the
+  // resolver keeps its own copy of buffers passed to
+  // LoadModuleUsingMemoryBuffer().
+  virtual bool ModulesKeepSymbolData();
+
   // All of the modules that are loaded.
   typedef map<string, Module*, CompareString> ModuleMap;
   ModuleMap *modules_;
@@ -114,7 +225,99 @@ class SourceLineResolverBase : public SourceLineResolverInterface {
   // Creates a concrete module at run-time.
   ModuleFactory *module_factory_;
 
+  // Guards modules_, corrupt_modules_, memory_buffers_ and the module cache
+  // state below, so that several threads walking stacks concurrently can
+  // share one resolver.  A loaded Module is never modified, so lookups into
+  // it happen without the lock, with the module acquired.  Callers must not
+  // UnloadModule() a module while another thread may be using it.
+  std::mutex modules_mutex_;
+
  private:
+  // Module cache bookkeeping for one loaded module.
+  struct CacheEntry {
+    // Size of the symbol data the module was loaded from.
+    size_t size;
+    // Number of lookups currently using the module.
+    int lookups;
+    // Position of the module's key in lru_modules_.
+    std::list<string>::iterator lru_position;
+    // Sequence number of the load that loaded the module.
+    uint64_t generation;
+  };
+  typedef map<string, CacheEntry, CompareString> CacheEntryMap;
+  typedef map<string, int, CompareString> PinCountMap;
+
+  // Loads module from memory_buffer, which the resolver owns from now on:
+  // it is deleted once loaded, or kept as long as the module, as
+  // ModulesKeepSymbolData() requires.
+  bool LoadModuleUsingOwnedBuffer(const CodeModule *module,
+                                  const string &key,
+                                  char *memory_buffer,
+                                  size_t memory_buffer_size);
+
+  // Parses memory_buffer into a module and adds it under module's key.
+  // The caller keeps ownership of memory_buffer.
+  bool LoadModuleFromBuffer(const CodeModule *module,
+                            char *memory_buffer,
+                            size_t memory_buffer_size);
+
+  // Marks the module loaded under |key| as the most recently used.
+  void TouchModule(CacheEntry *entry);
+
+  // Unloads least recently used modules, other than the one loaded under
+  // |keep|, until the loaded modules fit in the budget.
+  void EvictModules(const string &keep);
+
+  // Unloads the module loaded under |key| and frees its symbol data.
+  void RemoveModule(const string &key);
+
+  CacheEntryMap cache_entries_;
+  // Keys of the loaded modules, most recently used first.
+  std::list<string> lru_modules_;
+  // Number of outstanding PinModule() calls for each key.
+  PinCountMap module_pins_;
+  size_t symbol_data_budget_;
+  size_t symbol_data_size_;
+  // True if modules are keyed by debug file and identifier rather than by
+  // code file.  See set_key_by_debug_identifier().
+  bool key_by_debug_identifier_;
+  uint64_t cache_loads_;
+  uint64_t cache_reloads_;
+  uint64_t cache_evictions_;
+  // Keys of the modules evicted and not loaded again since.
+  std::set<string> evicted_modules_;
+  // Generation to give the next module loaded.
+  uint64_t next_generation_;
+
+  // A rule set in the CFI cache, by module key and module-relative
+  // address.
+  typedef std::pair<string, MemAddr> CFICacheKey;
+  struct CFICacheEntry {
+    // The rules, or NULL if the module has none at the address.
+    CFIFrameInfo *frame_info;
+    // Position of the entry's key in lru_cfi_entries_.
+    std::list<CFICacheKey>::iterator lru_position;
+  };
+  typedef map<CFICacheKey, CFICacheEntry> CFICacheEntryMap;
+
+  // Drops the least recently used CFI rule sets until there are no more
+  // than cfi_cache_capacity_.  Called with cfi_cache_mutex_ held.
+  void EvictCFIEntries();
+
+  // Drops the CFI rule sets of the module loaded under |key|.
+  void RemoveCFIEntries(const string &key);
+
+  // Guards the CFI cache below.  When both are held, modules_mutex_ is
+  // taken first.
+  std::mutex cfi_cache_mutex_;
+  CFICacheEntryMap cfi_entries_;
+  // Keys of the cached rule sets, most recently used first.
+  std::list<CFICacheKey> lru_cfi_entries_;
+  size_t cfi_cache_capacity_;
+  uint64_t cfi_cache_hits_;
+  uint64_t cfi_cache_misses_;
+  uint64_t cfi_cache_evictions_;
+
   // ModuleFactory needs to have access to protected type Module.
   friend class ModuleFactory;
 
@@ -35,6 +35,7 @@
 #define GOOGLE_BREAKPAD_PROCESSOR_SOURCE_LINE_RESOLVER_INTERFACE_H__
 
 #include <string>
+#include <vector>
 
 #include "common/using_std_string.h"
 #include "google_breakpad/common/breakpad_types.h"
@@ -86,6 +87,26 @@ class SourceLineResolverInterface {
   // Returns true if the module has been loaded.
   virtual bool HasModule(const CodeModule *module) = 0;
 
+  // Marks the module as in use, for a resolver that may unload modules on
+  // its own to bound memory use: a pinned module stays loaded, or once
+  // loaded stays loaded, until every PinModule() call for it has been
+  // matched by UnpinModule().  The module need not be loaded yet.  A
+  // resolver that never unloads modules on its own may ignore these.
+  virtual void PinModule(const CodeModule *module) {}
+  virtual void UnpinModule(const CodeModule *module) {}
+
+  // Returns true if the resolver obtains modules' symbols itself, rather
+  // than being given them by a SymbolSupplier through the Load* methods.
+  virtual bool SuppliesOwnSymbols() { return false; }
+
+  // Returns the key the resolver keeps |module|'s symbols under.  Modules
+  // with the same key share one set of symbols, so anything kept about a
+  // module's symbols outside the resolver should be kept under this key.
+  // The default keys modules by code file.
+  virtual string ModuleKey(const CodeModule *module) const {
+    return module->code_file();
+  }
+
   // Returns true if the module has been loaded and it is corrupt.
   virtual bool IsModuleCorrupt(const CodeModule *module) = 0;
 
@@ -94,6 +115,37 @@ class SourceLineResolverInterface {
   // module_name fields must already be filled in.
   virtual void FillSourceLineInfo(StackFrame *frame) = 0;
 
+  // Fills in the StackFrame as FillSourceLineInfo above does.  If
+  // |inlined_frames| is not NULL and the instruction lies in code inlined
+  // into the frame's function, a frame for each inlined call is appended to
+  // it, innermost first, and the StackFrame's source_file_name and
+  // source_line describe the outermost call site instead.  The caller takes
+  // ownership of the appended frames.  Resolvers that know nothing of
+  // inlined code need not override this; by default no frames are
+  // appended.
+  virtual void FillSourceLineInfo(StackFrame *frame,
+                                  std::vector<StackFrame*> *inlined_frames) {
+    FillSourceLineInfo(frame);
+  }
+
+  // Fills in each of |frames|, whose instructions must all lie in |module|,
+  // as FillSourceLineInfo above does.  If |inlined_frames| is not NULL, it
+  // is resized to frames.size(), and the frames inlined into frames[i] are
+  // appended to (*inlined_frames)[i].  Resolvers may look up many
+  // addresses in one module much faster this way than one at a time,
+  // especially when |frames| are sorted by instruction address.
+  virtual void FillSourceLineInfo(
+      const CodeModule *module,
+      const std::vector<StackFrame*> &frames,
+      std::vector<std::vector<StackFrame*> > *inlined_frames) {
+    if (inlined_frames)
+      inlined_frames->resize(frames.size());
+    for (size_t i = 0; i < frames.size(); ++i) {
+      FillSourceLineInfo(frames[i],
+                         inlined_frames ? &(*inlined_frames)[i] : NULL);
+    }
+  }
+
   // If Windows stack walking information is available covering
   // FRAME's instruction address, return a WindowsFrameInfo structure
   // describing it. If the information is not available, returns NULL.
@@ -51,9 +51,16 @@ struct StackFrame {
     FRAME_TRUST_FP,        // Derived from frame pointer
     FRAME_TRUST_CFI,       // Derived from call frame info
     FRAME_TRUST_PREWALKED, // Explicitly provided by some external stack walker.
-    FRAME_TRUST_CONTEXT    // Given as instruction pointer in a context
+    FRAME_TRUST_CONTEXT,   // Given as instruction pointer in a context
+    FRAME_TRUST_INLINE     // Inlined into the physical frame that follows it
   };
 
+  // A frame with FRAME_TRUST_INLINE is always a plain StackFrame, never a
+  // CPU-specific subclass such as StackFrameX86: it has no registers of its
+  // own, and its instruction is that of the physical frame it belongs to.
+  // Code that casts a CallStack's frames to a CPU's frame type must check
+  // the trust first.
+
   StackFrame()
       : instruction(),
         module(NULL),
@@ -71,6 +78,8 @@ struct StackFrame {
     switch (trust) {
       case StackFrame::FRAME_TRUST_CONTEXT:
         return "given as instruction pointer in context";
+      case StackFrame::FRAME_TRUST_INLINE:
+        return "inlined";
       case StackFrame::FRAME_TRUST_PREWALKED:
         return "recovered by external stack walker";
       case StackFrame::FRAME_TRUST_CFI:
@@ -35,12 +35,18 @@
 #ifndef GOOGLE_BREAKPAD_PROCESSOR_STACK_FRAME_SYMBOLIZER_H__
 #define GOOGLE_BREAKPAD_PROCESSOR_STACK_FRAME_SYMBOLIZER_H__
 
+#include <list>
+#include <map>
+#include <mutex>
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/using_std_string.h"
 #include "google_breakpad/common/breakpad_types.h"
 #include "google_breakpad/processor/code_module.h"
+#include "processor/linked_ptr.h"
 
 namespace google_breakpad {
 class CFIFrameInfo;
@@ -71,16 +77,33 @@ class StackFrameSymbolizer {
   StackFrameSymbolizer(SymbolSupplier* supplier,
                        SourceLineResolverInterface* resolver);
 
-  virtual ~StackFrameSymbolizer() { }
+  virtual ~StackFrameSymbolizer();
 
   // Encapsulate the step of resolving source line info for a stack frame.
-  // "frame" must not be NULL.
+  // "frame" must not be NULL.  This may be called from several threads at
+  // once, provided the resolver supports concurrent lookups (as
+  // SourceLineResolverBase does).
   virtual SymbolizerResult FillSourceLineInfo(
       const CodeModules* modules,
       const CodeModules* unloaded_modules,
       const SystemInfo* system_info,
       StackFrame* stack_frame);
 
+  // As above, and if "inlined_frames" is not NULL, frames for the calls
+  // inlined at the frame's instruction are appended to it, innermost
+  // first; the caller owns them.  Stackwalker calls this form when it
+  // wants inlined frames, and the four-argument form otherwise.  This
+  // default calls the four-argument form, so a subclass that overrides
+  // only that one is used either way; the inlined frames are found if
+  // its override calls StackFrameSymbolizer::FillSourceLineInfo() for
+  // the frame.
+  virtual SymbolizerResult FillSourceLineInfo(
+      const CodeModules* modules,
+      const CodeModules* unloaded_modules,
+      const SystemInfo* system_info,
+      StackFrame* stack_frame,
+      std::vector<StackFrame*>* inlined_frames);
+
   virtual WindowsFrameInfo* FindWindowsFrameInfo(const StackFrame* frame);
 
   virtual CFIFrameInfo* FindCFIFrameInfo(const StackFrame* frame);
@@ -89,20 +112,188 @@ class StackFrameSymbolizer {
   // A typical case is to call Reset() after processing an individual report
   // before start to process next one, in order to reset internal information
   // about missing symbols found so far.
-  virtual void Reset() { no_symbol_modules_.clear(); }
+  virtual void Reset() {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    no_symbol_modules_.clear();
+  }
 
   // Returns true if there is valid implementation for stack symbolization.
-  virtual bool HasImplementation() { return resolver_ && supplier_; }
+  virtual bool HasImplementation();
+
+  // Counters describing the frame cache.  See set_frame_cache_capacity().
+  struct FrameCacheStats {
+    // Number of FillSourceLineInfo() calls answered from the cache.
+    uint64_t hits;
+    // Number of FillSourceLineInfo() calls that asked the resolver, for
+    // frames the cache could hold.
+    uint64_t misses;
+    // Number of frames dropped to stay within the capacity.
+    uint64_t evictions;
+    // Number of frames currently cached.
+    size_t entries;
+  };
+
+  // Keeps what FillSourceLineInfo() finds for up to |capacity| frames, by
+  // the resolver's ModuleKey() for the module and module-relative address,
+  // and fills later frames at the same address, in any minidump, from the
+  // cache, without asking the resolver to look them up.  The CFI and
+  // Windows frame information the stack walker then asks for are cached
+  // with the frame, and once they are, a cached frame's module is not
+  // loaded again if the resolver has unloaded it.  This pays off
+  // when processing many minidumps from the same builds, whose stacks
+  // share most of their frames.  The least recently used frames are
+  // dropped whenever there are more than |capacity|.  Only frames in
+  // modules with a debug identifier whose symbols were loaded are cached.
+  // Cached frames tell two builds of a module apart only if the resolver's
+  // keys do, so a resolver shared by dumps of different builds should key
+  // modules by debug identifier (see
+  // SourceLineResolverBase::set_key_by_debug_identifier()).  A capacity
+  // of 0, the default, disables the cache.  Reset() leaves the cache
+  // alone.
+  void set_frame_cache_capacity(size_t capacity);
+
+  FrameCacheStats frame_cache_stats();
 
   SourceLineResolverInterface* resolver() { return resolver_; }
   SymbolSupplier* supplier() { return supplier_; }
 
  protected:
+  // Loads |module|'s symbols into resolver_, unless they are loaded
+  // already or known to be missing.
+  SymbolizerResult EnsureModuleLoaded(const CodeModule* module,
+                                      const SystemInfo* system_info);
+
+  // Fetches the symbol file for |module| from supplier_ and loads it into
+  // resolver_.  Must be called with the load mutex for the module's code
+  // file held.
+  SymbolizerResult LoadModuleSymbols(const CodeModule* module,
+                                     const SystemInfo* system_info);
+
   SymbolSupplier* supplier_;
   SourceLineResolverInterface* resolver_;
-  // A list of modules known to have symbols missing. This helps avoid
-  // repeated lookups for the missing symbols within one minidump.
+  // A list of modules known to have symbols missing, by the resolver's
+  // ModuleKey(). This helps avoid repeated lookups for the missing symbols
+  // within one minidump.
   std::set<string> no_symbol_modules_;
+  // Guards no_symbol_modules_ and module_loads_.
+  std::mutex state_mutex_;
+  // Serializes calls into supplier_, which need not be thread-safe.
+  std::mutex supplier_mutex_;
+
+ private:
+  // Serializes the loading of modules with one code file, so that
+  // FillSourceLineInfo() may be called by several stackwalking threads at
+  // once, and loads each module only once, while other modules load and
+  // lookups into loaded modules go on concurrently.  Symbol suppliers
+  // keep the data they hand out by code file until it is freed, so two
+  // builds of a module with the same code file load one after the other.
+  struct ModuleLoad {
+    ModuleLoad() : users(0) {}
+    std::mutex mutex;
+    // Number of threads using this ModuleLoad.
+    int users;
+  };
+  typedef std::map<string, ModuleLoad*> ModuleLoadMap;
+
+  // Returns the ModuleLoad for |code_file|, creating it if need be.
+  // Every call must be matched by one to ReleaseModuleLoad().
+  ModuleLoad* AcquireModuleLoad(const string& code_file);
+  void ReleaseModuleLoad(const string& code_file);
+
+  // Fills in |frame| as the four-argument FillSourceLineInfo() does, and
+  // appends the frames inlined at it to |inlined_frames| if that is not
+  // NULL.
+  SymbolizerResult SymbolizeFrame(const CodeModules* modules,
+                                  const CodeModules* unloaded_modules,
+                                  const SystemInfo* system_info,
+                                  StackFrame* frame,
+                                  std::vector<StackFrame*>* inlined_frames);
+
+  // Returns true if |key| is in no_symbol_modules_.
+  bool IsMissingSymbols(const string& key);
+
+  // The modules being loaded, by code file.
+  ModuleLoadMap module_loads_;
+
+  // The fields of a StackFrame that resolving its source line fills in,
+  // with addresses relative to the module's base address.
+  struct CachedFrame {
+    string function_name;
+    bool has_function_base;
+    uint64_t function_base;
+    string source_file_name;
+    int source_line;
+    bool has_source_line_base;
+    uint64_t source_line_base;
+
+    // Records |frame|'s fields, for a module based at |module_base|.
+    void Save(const StackFrame& frame, uint64_t module_base);
+    // Sets |frame|'s fields, for a module based at |module_base|.
+    void Restore(uint64_t module_base, StackFrame* frame) const;
+  };
+
+  // A cached frame, by module key and module-relative address.
+  typedef std::pair<string, uint64_t> FrameCacheKey;
+  struct FrameCacheEntry {
+    FrameCacheEntry();
+    ~FrameCacheEntry();
+
+    SymbolizerResult result;
+    CachedFrame frame;
+    // True if the frames inlined at the address were looked up, and
+    // are in |inlined_frames|.
+    bool has_inlined_frames;
+    std::vector<CachedFrame> inlined_frames;
+    // True if FindWindowsFrameInfo() or FindCFIFrameInfo() were asked
+    // about the address, and what they found (NULL for nothing) is in
+    // |windows_frame_info| or |cfi_frame_info|.
+    bool has_windows_frame_info;
+    linked_ptr<WindowsFrameInfo> windows_frame_info;
+    bool has_cfi_frame_info;
+    linked_ptr<CFIFrameInfo> cfi_frame_info;
+    // Position of the entry's key in lru_frames_.
+    std::list<FrameCacheKey>::iterator lru_position;
+  };
+  typedef std::map<FrameCacheKey, FrameCacheEntry> FrameCacheEntryMap;
+
+  // Sets |key| to the frame cache key for |frame| and returns true, if
+  // the frame cache is enabled and could hold |frame|.
+  bool GetFrameCacheKey(const StackFrame& frame, FrameCacheKey* key);
+
+  // If the cache holds |key|, fills in |frame| and |inlined_frames| from
+  // it, sets |result| to the result FillSourceLineInfo() returned for it,
+  // sets |has_unwind_info| to true if the cache also holds the CFI or
+  // Windows frame information the stack walker unwinds the frame with,
+  // and returns true.
+  bool LookupCachedFrame(const FrameCacheKey& key,
+                         StackFrame* frame,
+                         std::vector<StackFrame*>* inlined_frames,
+                         SymbolizerResult* result,
+                         bool* has_unwind_info);
+
+  // Adds |frame|, whose source line FillSourceLineInfo() just found with
+  // |result|, to the cache under |key|.  The frames it found inlined at
+  // the address are those in |inlined_frames| from |first_inlined_frame|
+  // on; |inlined_frames| is NULL if it wasn't asked for them.
+  void CacheFrame(const FrameCacheKey& key,
+                  const StackFrame& frame,
+                  const std::vector<StackFrame*>* inlined_frames,
+                  size_t first_inlined_frame,
+                  SymbolizerResult result);
+
+  // Drops the least recently used frames until there are no more than
+  // frame_cache_capacity_.  Must be called with frame_cache_mutex_ held.
+  void EvictFrames();
+
+  // Guards the frame cache below.
+  std::mutex frame_cache_mutex_;
+  FrameCacheEntryMap frame_cache_;
+  // Keys of the cached frames, most recently used first.
+  std::list<FrameCacheKey> lru_frames_;
+  size_t frame_cache_capacity_;
+  uint64_t frame_cache_hits_;
+  uint64_t frame_cache_misses_;
+  uint64_t frame_cache_evictions_;
 };
 
 }  // namespace google_breakpad
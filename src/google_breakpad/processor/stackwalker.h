@@ -43,18 +43,20 @@
 
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "common/using_std_string.h"
 #include "google_breakpad/common/breakpad_types.h"
+#include "google_breakpad/processor/call_stack.h"
 #include "google_breakpad/processor/code_modules.h"
 #include "google_breakpad/processor/memory_region.h"
 #include "google_breakpad/processor/stack_frame_symbolizer.h"
 
 namespace google_breakpad {
 
-class CallStack;
 class DumpContext;
+class ProcessDeadline;
 class StackFrameSymbolizer;
 
 using std::set;
@@ -77,10 +79,23 @@ class Stackwalker {
   // CodeModules passed to the StackWalker constructor (which currently
   // happens to be the lifetime of the Breakpad's ProcessingState object).
   // There is a check for duplicate modules so no duplicates are expected.
+  //
+  // If a deadline has been set and it passes, or is cancelled, during the
+  // walk, the walk stops early and Walk returns true, with the frames
+  // found so far in |stack|, which records the reason in its
+  // truncation().
   bool Walk(CallStack* stack,
             vector<const CodeModule*>* modules_without_symbols,
             vector<const CodeModule*>* modules_with_corrupt_symbols);
 
+  // Stops Walk when |deadline| passes or is cancelled.  The deadline is
+  // checked before each frame is symbolized, which is when symbols are
+  // loaded, before unwinding to its caller, and while scanning the stack.
+  // The frame found last, and at least the context frame, is kept, left
+  // unsymbolized if time is already up.  deadline may be NULL, the
+  // default, for none.  Does not take ownership of deadline.
+  void set_deadline(const ProcessDeadline* deadline) { deadline_ = deadline; }
+
   // Returns a new concrete subclass suitable for the CPU that a stack was
   // generated on, according to the CPU type indicated by the context
   // argument.  If no suitable concrete subclass exists, returns NULL.
@@ -128,6 +143,11 @@ class Stackwalker {
   // Returns false otherwise.
   bool InstructionAddressSeemsValid(uint64_t address) const;
 
+  // Returns true if the deadline has passed or been cancelled, recording
+  // why in truncation_ the first time.  Once it has returned true it
+  // always does.
+  bool DeadlinePassed();
+
   // Checks whether we should stop the stack trace.
   // (either we reached the end-of-stack or we detected a
   //  broken callstack invariant)
@@ -140,6 +160,9 @@ class Stackwalker {
   // for a return address.
   static const int kRASearchWords;
 
+  // The number of stack words ScanForReturnAddress reads at once.
+  static const size_t kScanChunkWords = 64;
+
   template<typename InstructionType>
   bool ScanForReturnAddress(InstructionType location_start,
                             InstructionType* location_found,
@@ -164,24 +187,40 @@ class Stackwalker {
   // When returning true, sets location_found to the address at which
   // the value was found, and ip_found to the value contained at that
   // location in memory.
+  //
+  // The stack is read kScanChunkWords words at a time, and the words
+  // that lie outside every module are ruled out together by
+  // MarkWordsInModules before the rest are checked one by one.
   template<typename InstructionType>
   bool ScanForReturnAddress(InstructionType location_start,
                             InstructionType* location_found,
                             InstructionType* ip_found,
                             int searchwords) {
-    for (InstructionType location = location_start;
-         location <= location_start + searchwords * sizeof(InstructionType);
-         location += sizeof(InstructionType)) {
-      InstructionType ip;
-      if (!memory_->GetMemoryAtAddress(location, &ip))
-        break;
-
-      if (modules_ && modules_->GetModuleForAddress(ip) &&
-          InstructionAddressSeemsValid(ip)) {
-        *ip_found = ip;
-        *location_found = location;
-        return true;
+    if (!modules_ || searchwords < 0)
+      return false;
+
+    InstructionType words[kScanChunkWords];
+    uint8_t in_module[kScanChunkWords];
+    size_t remaining = static_cast<size_t>(searchwords) + 1;
+    InstructionType location = location_start;
+    while (remaining > 0) {
+      if (DeadlinePassed())
+        return false;
+      size_t chunk = remaining < kScanChunkWords ? remaining : kScanChunkWords;
+      size_t words_read = memory_->GetMemoryAtAddresses(location, words, chunk);
+      MarkWordsInModules(words, words_read, in_module);
+      for (size_t i = 0; i < words_read; ++i) {
+        if (in_module[i] && modules_->GetModuleForAddress(words[i]) &&
+            !DeadlinePassed() && InstructionAddressSeemsValid(words[i])) {
+          *ip_found = words[i];
+          *location_found = location + i * sizeof(InstructionType);
+          return true;
+        }
       }
+      if (words_read < chunk)
+        break;
+      remaining -= chunk;
+      location += chunk * sizeof(InstructionType);
     }
     // nothing found
     return false;
@@ -235,6 +274,37 @@ class Stackwalker {
   virtual StackFrame* GetCallerFrame(const CallStack* stack,
                                      bool stack_scan_allowed) = 0;
 
+  // Sets in_module[i] to 1 if words[i], for i < count, lies within the
+  // address range of any of modules_, and to 0 otherwise.  Words that
+  // are marked are not necessarily in a module, as the ranges of
+  // modules_ may have been trimmed to resolve overlaps, but those that
+  // aren't are certainly not.
+  void MarkWordsInModules(const uint32_t* words, size_t count,
+                          uint8_t* in_module);
+  void MarkWordsInModules(const uint64_t* words, size_t count,
+                          uint8_t* in_module);
+
+  // Implementation for MarkWordsInModules.
+  template<typename T>
+  void MarkWordsInModulesInternal(const T* words, size_t count,
+                                  uint8_t* in_module);
+
+  // Sets frame's module from its instruction address, as the frame
+  // symbolizer would, without loading any symbols.
+  void FillModule(StackFrame* frame) const;
+
+  // The address ranges, first and last address inclusive, of modules_,
+  // merged and sorted, for ruling out stack words quickly when scanning.
+  // They are gathered on the first scan.
+  vector<std::pair<uint64_t, uint64_t> > module_ranges_;
+  bool module_ranges_built_;
+
+  // When to stop walking, or NULL.  See set_deadline.
+  const ProcessDeadline* deadline_;
+
+  // Why the walk stopped early, once DeadlinePassed has returned true.
+  CallStackTruncation truncation_;
+
   // The maximum number of frames Stackwalker will walk through.
   // This defaults to 1024 to prevent infinite loops.
   static uint32_t max_frames_;
@@ -66,6 +66,18 @@ bool AddressMap<AddressType, EntryType>::Retrieve(
   BPLOG_IF(ERROR, !entry) << "AddressMap::Retrieve requires |entry|";
   assert(entry);
 
+  const EntryType *found;
+  if (!RetrievePtr(address, found, entry_address))
+    return false;
+
+  *entry = *found;
+  return true;
+}
+
+template<typename AddressType, typename EntryType>
+bool AddressMap<AddressType, EntryType>::RetrievePtr(
+    const AddressType &address,
+    const EntryType *&entry, AddressType *entry_address) const {
   // upper_bound gives the first element whose key is greater than address,
   // but we want the first element whose key is less than or equal to address.
   // Decrement the iterator to get there, but not if the upper_bound already
@@ -76,7 +88,7 @@ bool AddressMap<AddressType, EntryType>::Retrieve(
     return false;
   --iterator;
 
-  *entry = iterator->second;
+  entry = &iterator->second;
   if (entry_address)
     *entry_address = iterator->first;
 
@@ -63,6 +63,11 @@ class AddressMap {
   bool Retrieve(const AddressType &address,
                 EntryType *entry, AddressType *entry_address) const;
 
+  // As above, but points |entry| at the map's own copy of the entry, which
+  // remains valid until the map is next modified.
+  bool RetrievePtr(const AddressType &address,
+                   const EntryType *&entry, AddressType *entry_address) const;
+
   // Empties the address map, restoring it to the same state as when it was
   // initially created.
   void Clear();
@@ -105,14 +105,14 @@ unsigned int BasicCodeModules::module_count() const {
 
 const CodeModule* BasicCodeModules::GetModuleForAddress(
     uint64_t address) const {
-  linked_ptr<const CodeModule> module;
-  if (!map_.RetrieveRange(address, &module, NULL /* base */, NULL /* delta */,
-                          NULL /* size */)) {
+  const linked_ptr<const CodeModule> *module;
+  if (!map_.RetrieveRangePtr(address, module, NULL /* base */,
+                             NULL /* delta */, NULL /* size */)) {
     BPLOG(INFO) << "No module at " << HexString(address);
     return NULL;
   }
 
-  return module.get();
+  return module->get();
 }
 
 const CodeModule* BasicCodeModules::GetMainModule() const {
@@ -121,14 +121,14 @@ const CodeModule* BasicCodeModules::GetMainModule() const {
 
 const CodeModule* BasicCodeModules::GetModuleAtSequence(
     unsigned int sequence) const {
-  linked_ptr<const CodeModule> module;
-  if (!map_.RetrieveRangeAtIndex(sequence, &module, NULL /* base */,
-                                 NULL /* delta */, NULL /* size */)) {
+  const linked_ptr<const CodeModule> *module;
+  if (!map_.RetrieveRangeAtIndexPtr(sequence, module, NULL /* base */,
+                                    NULL /* delta */, NULL /* size */)) {
     BPLOG(ERROR) << "RetrieveRangeAtIndex failed for sequence " << sequence;
     return NULL;
   }
 
-  return module.get();
+  return module->get();
 }
 
 const CodeModule* BasicCodeModules::GetModuleAtIndex(
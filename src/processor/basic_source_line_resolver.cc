@@ -41,16 +41,12 @@
 #include <limits>
 #include <map>
 #include <utility>
-#include <vector>
 
 #include "google_breakpad/processor/basic_source_line_resolver.h"
 #include "processor/basic_source_line_resolver_types.h"
 #include "processor/module_factory.h"
 
-#include "processor/tokenize.h"
-
 using std::map;
-using std::vector;
 using std::make_pair;
 
 namespace google_breakpad {
@@ -64,38 +60,99 @@ namespace google_breakpad {
 
 namespace {
 
+// Splits line in place into at most max_tokens tokens, storing pointers to
+// them in tokens, which must have room for max_tokens entries.  This splits
+// exactly as Tokenize does, but without building a vector, so that parsing
+// a record performs no allocation.  Returns true if exactly max_tokens
+// tokens were found.
+bool TokenizeInPlace(char *line,
+                     const char *separators,
+                     int max_tokens,
+                     char **tokens) {
+  int count = 0;
+  char *cursor = line;
+
+  // Split all but the last token on the separator characters.
+  while (count < max_tokens - 1) {
+    cursor += strspn(cursor, separators);
+    if (*cursor == '\0')
+      return false;
+    tokens[count++] = cursor;
+    cursor += strcspn(cursor, separators);
+    if (*cursor == '\0')
+      return false;
+    *cursor++ = '\0';
+  }
+
+  // If there's anything left, just add it as a single token.
+  cursor += strspn(cursor, "\r\n");
+  if (*cursor == '\0')
+    return false;
+  tokens[count] = cursor;
+  cursor[strcspn(cursor, "\r\n")] = '\0';
+  return true;
+}
+
 // Utility function to tokenize given the presence of an optional initial
 // field. In this case, optional_field is the expected string for the optional
 // field, and max_tokens is the maximum number of tokens including the optional
-// field. Refer to the documentation for Tokenize for descriptions of the other
-// arguments.
+// field. Refer to the documentation for TokenizeInPlace for descriptions of
+// the other arguments.
 bool TokenizeWithOptionalField(char *line,
                                const char *optional_field,
                                const char *separators,
                                int max_tokens,
-                               vector<char*> *tokens) {
+                               char **tokens) {
   // First tokenize assuming the optional field is not present.  If we then see
   // the optional field, additionally tokenize the last token into two tokens.
-  if (!Tokenize(line, separators, max_tokens - 1, tokens)) {
+  if (!TokenizeInPlace(line, separators, max_tokens - 1, tokens)) {
     return false;
   }
 
-  if (strcmp(tokens->front(), optional_field) == 0) {
+  if (strcmp(tokens[0], optional_field) == 0) {
     // The optional field is present. Split the last token in two to recover the
     // field prior to the last.
-    vector<char*> last_tokens;
-    if (!Tokenize(tokens->back(), separators, 2, &last_tokens)) {
-      return false;
-    }
-    // Replace the previous last token with the two new tokens.
-    tokens->pop_back();
-    tokens->push_back(last_tokens[0]);
-    tokens->push_back(last_tokens[1]);
+    return TokenizeInPlace(tokens[max_tokens - 2], separators, 2,
+                           &tokens[max_tokens - 2]);
   }
 
   return true;
 }
 
+// Returns true if c may begin a line record, "<address> <size> <line>
+// <file>".  Every other record begins with an upper-case keyword, so this
+// lets the common case skip comparing keywords.
+inline bool IsLineRecordStart(char c) {
+  return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+}
+
+// Reads the address and size of the FUNC record |function_line|, without
+// modifying it or parsing the rest of it.  Returns false if either field
+// is one SymbolParseHelper::ParseFunction would reject.
+bool ParseFunctionRange(const char *function_line,
+                        uint64_t *address,
+                        uint64_t *size) {
+  // FUNC [<multiple>] <address> <size> <stack_param_size> <name>
+  const char *cursor = function_line + 5;  // skip prefix
+  cursor += strspn(cursor, " ");
+  if (cursor[0] == 'm' && cursor[1] == ' ')
+    cursor += 1 + strspn(cursor + 1, " ");
+
+  char *after_number;
+  *address = strtoull(cursor, &after_number, 16);
+  if (after_number == cursor || *after_number != ' ' ||
+      *address == std::numeric_limits<unsigned long long>::max()) {
+    return false;
+  }
+  cursor = after_number + strspn(after_number, " ");
+  *size = strtoull(cursor, &after_number, 16);
+  if (after_number == cursor || *after_number != ' ' ||
+      *size == std::numeric_limits<unsigned long long>::max()) {
+    return false;
+  }
+  return true;
+}
+
 }  // namespace
 
 static const char *kWhitespace = " \r\n";
@@ -105,6 +162,14 @@ static const int kMaxErrorsBeforeBailing = 100;
 BasicSourceLineResolver::BasicSourceLineResolver() :
     SourceLineResolverBase(new BasicModuleFactory) { }
 
+void BasicSourceLineResolver::set_lazy_parsing(bool lazy) {
+  static_cast<BasicModuleFactory*>(module_factory_)->set_lazy_parsing(lazy);
+}
+
+bool BasicSourceLineResolver::ModulesKeepSymbolData() {
+  return static_cast<BasicModuleFactory*>(module_factory_)->lazy_parsing();
+}
+
 // static
 void BasicSourceLineResolver::Module::LogParseError(
    const string &message,
@@ -123,9 +188,12 @@ bool BasicSourceLineResolver::Module::LoadMapFromMemory(
     char *memory_buffer,
     size_t memory_buffer_size) {
   linked_ptr<Function> cur_func;
+  // Whether records for cur_func are being deferred: in a lazy module, the
+  // INLINE and line records from its FUNC record up to the next record of
+  // any other kind.
+  bool defer_records = false;
   int line_number = 0;
   int num_errors = 0;
-  char *save_ptr;
 
   // If the length is 0, we can still pretend we have a symbol file. This is
   // for scenarios that want to test symbol lookup, but don't necessarily care
@@ -160,13 +228,32 @@ bool BasicSourceLineResolver::Module::LoadMapFromMemory(
        &num_errors);
   }
 
-  char *buffer;
-  buffer = strtok_r(memory_buffer, "\r\n", &save_ptr);
-
-  while (buffer != NULL) {
+  // Walk the buffer a line at a time, terminating each line in place.
+  // Empty lines, and the second character of "\r\n", are skipped.
+  char *cursor = memory_buffer;
+  while (*cursor != '\0') {
+    if (*cursor == '\r' || *cursor == '\n') {
+      ++cursor;
+      continue;
+    }
+    char *buffer = cursor;
+    cursor += strcspn(cursor, "\r\n");
+    if (*cursor != '\0')
+      *cursor++ = '\0';
     ++line_number;
 
-    if (strncmp(buffer, "FILE ", 5) == 0) {
+    if (defer_records &&
+        (IsLineRecordStart(*buffer) || strncmp(buffer, "INLINE ", 7) == 0)) {
+      // Leave the record where it is; ParseUnparsedRecords will find it.
+      ++cur_func->unparsed_record_count;
+      continue;
+    }
+    defer_records = false;
+
+    if (IsLineRecordStart(*buffer)) {
+      // Line records far outnumber all others, so check for them first.
+      ParseLineRecord(buffer, cur_func.get(), line_number, &num_errors);
+    } else if (strncmp(buffer, "FILE ", 5) == 0) {
       if (!ParseFile(buffer)) {
         LogParseError("ParseFile on buffer failed", line_number, &num_errors);
       }
@@ -174,15 +261,48 @@ bool BasicSourceLineResolver::Module::LoadMapFromMemory(
       if (!ParseStackInfo(buffer)) {
         LogParseError("ParseStackInfo failed", line_number, &num_errors);
       }
+    } else if (strncmp(buffer, "INLINE_ORIGIN ", 14) == 0) {
+      if (!ParseInlineOrigin(buffer)) {
+        LogParseError("ParseInlineOrigin failed", line_number, &num_errors);
+      }
+    } else if (strncmp(buffer, "INLINE ", 7) == 0) {
+      if (!cur_func.get()) {
+        LogParseError("Found INLINE record outside of a function",
+                      line_number, &num_errors);
+      } else {
+        // Records are parsed in the order they appear in the symbol file.
+        ParseDeferredRecords(cur_func.get());
+        if (!ParseInline(buffer, cur_func.get()))
+          LogParseError("ParseInline failed", line_number, &num_errors);
+      }
     } else if (strncmp(buffer, "FUNC ", 5) == 0) {
-      cur_func.reset(ParseFunction(buffer));
+      if (lazy_) {
+        // Index the function by its address range, and leave the rest of
+        // the record for ParseUnparsedRecords.
+        uint64_t address;
+        uint64_t size;
+        if (ParseFunctionRange(buffer, &address, &size)) {
+          cur_func.reset(new Function(string(), address, size, 0, false));
+          cur_func->unparsed_records = buffer;
+          cur_func->unparsed_record_count = 1;
+          cur_func->first_line_number = line_number;
+        } else {
+          cur_func.reset();
+        }
+      } else {
+        cur_func.reset(ParseFunction(buffer));
+      }
       if (!cur_func.get()) {
         LogParseError("ParseFunction failed", line_number, &num_errors);
       } else {
         // StoreRange will fail if the function has an invalid address or size.
         // We'll silently ignore this, the function and any corresponding lines
         // will be destroyed when cur_func is released.
-        functions_.StoreRange(cur_func->address, cur_func->size, cur_func);
+        if (functions_.StoreRange(cur_func->address, cur_func->size,
+                                  cur_func) && lazy_) {
+          unparsed_functions_.push_back(cur_func.get());
+          defer_records = true;
+        }
       }
     } else if (strncmp(buffer, "PUBLIC ", 7) == 0) {
       // Clear cur_func: public symbols don't contain line number information.
@@ -203,65 +323,141 @@ bool BasicSourceLineResolver::Module::LoadMapFromMemory(
       //
       // INFO CODE_ID <code id> <filename>
     } else {
-      if (!cur_func.get()) {
-        LogParseError("Found source line data without a function",
-                       line_number, &num_errors);
-      } else {
-        Line *line = ParseLine(buffer);
-        if (!line) {
-          LogParseError("ParseLine failed", line_number, &num_errors);
-        } else {
-          cur_func->lines.StoreRange(line->address, line->size,
-                                     linked_ptr<Line>(line));
-        }
-      }
+      ParseLineRecord(buffer, cur_func.get(), line_number, &num_errors);
     }
     if (num_errors > kMaxErrorsBeforeBailing) {
       break;
     }
-    buffer = strtok_r(NULL, "\r\n", &save_ptr);
   }
   is_corrupt_ = num_errors > 0;
   return true;
 }
 
-void BasicSourceLineResolver::Module::LookupAddress(StackFrame *frame) const {
+void BasicSourceLineResolver::Module::LookupAddress(
+    StackFrame *frame, std::vector<StackFrame*> *inlined_frames) const {
+  LookupCursor cursor;
+  LookupAddress(frame, inlined_frames, &cursor);
+}
+
+void BasicSourceLineResolver::Module::LookupAddresses(
+    const std::vector<StackFrame*> &frames,
+    std::vector<std::vector<StackFrame*> > *inlined_frames) const {
+  LookupCursor cursor;
+  for (size_t i = 0; i < frames.size(); ++i) {
+    LookupAddress(frames[i], inlined_frames ? &(*inlined_frames)[i] : NULL,
+                  &cursor);
+  }
+}
+
+void BasicSourceLineResolver::Module::LookupAddress(
+    StackFrame *frame, std::vector<StackFrame*> *inlined_frames,
+    LookupCursor *cursor) const {
   MemAddr address = frame->instruction - frame->module->base_address();
 
-  // First, look for a FUNC record that covers address. Use
-  // RetrieveNearestRange instead of RetrieveRange so that, if there
-  // is no such function, we can use the next function to bound the
-  // extent of the PUBLIC symbol we find, below. This does mean we
-  // need to check that address indeed falls within the function we
-  // find; do the range comparison in an overflow-friendly way.
-  linked_ptr<Function> func;
-  linked_ptr<PublicSymbol> public_symbol;
-  MemAddr function_base;
-  MemAddr function_size;
-  MemAddr public_address;
-  if (functions_.RetrieveNearestRange(address, &func, &function_base,
-                                      NULL /* delta */, &function_size) &&
-      address >= function_base && address - function_base < function_size) {
-    frame->function_name = func->name;
-    frame->function_base = frame->module->base_address() + function_base;
-
-    linked_ptr<Line> line;
-    MemAddr line_base;
-    if (func->lines.RetrieveRange(address, &line, &line_base, NULL /* delta */,
-                                  NULL /* size */)) {
-      FileMap::const_iterator it = files_.find(line->source_file_id);
-      if (it != files_.end()) {
-        frame->source_file_name = files_.find(line->source_file_id)->second;
+  if (!cursor->function_size || address < cursor->function_base ||
+      address - cursor->function_base >= cursor->function_size) {
+    cursor->function_size = 0;
+    cursor->line_size = 0;
+
+    // First, look for a FUNC record that covers address. Use
+    // RetrieveNearestRange instead of RetrieveRange so that, if there
+    // is no such function, we can use the next function to bound the
+    // extent of the PUBLIC symbol we find, below. This does mean we
+    // need to check that address indeed falls within the function we
+    // find; do the range comparison in an overflow-friendly way.
+    const linked_ptr<Function> *func = NULL;
+    const linked_ptr<PublicSymbol> *public_symbol;
+    MemAddr function_base;
+    MemAddr function_size;
+    MemAddr public_address;
+    if (functions_.RetrieveNearestRangePtr(address, func, &function_base,
+                                           NULL /* delta */, &function_size) &&
+        address >= function_base && address - function_base < function_size) {
+      ParseDeferredRecords(func->get());
+      cursor->function = func->get();
+      cursor->function_base = function_base;
+      cursor->function_size = function_size;
+    } else {
+      if (public_symbols_.RetrievePtr(address,
+                                      public_symbol, &public_address) &&
+          (!func || public_address > function_base)) {
+        frame->function_name = (*public_symbol)->name;
+        frame->function_base = frame->module->base_address() + public_address;
+      }
+      return;
+    }
+  }
+
+  const Function *func = cursor->function;
+  frame->function_name = func->name;
+  frame->function_base =
+      frame->module->base_address() + cursor->function_base;
+
+  if (!cursor->line_size || address < cursor->line_base ||
+      address - cursor->line_base >= cursor->line_size) {
+    cursor->line_size = 0;
+    func->lines.RetrieveRange(address, &cursor->line, &cursor->line_base,
+                              NULL /* delta */, &cursor->line_size);
+  }
+  if (cursor->line_size) {
+    FileMap::const_iterator it = files_.find(cursor->line.source_file_id);
+    if (it != files_.end()) {
+      frame->source_file_name = it->second;
+    }
+    frame->source_line = cursor->line.line;
+    frame->source_line_base = frame->module->base_address() +
+                              cursor->line_base;
+  }
+
+  if (inlined_frames)
+    AddInlinedFrames(func, address, frame, inlined_frames);
+}
+
+void BasicSourceLineResolver::Module::AddInlinedFrames(
+    const Function *function, MemAddr address, StackFrame *frame,
+    std::vector<StackFrame*> *inlined_frames) const {
+  std::vector<const linked_ptr<Inline>*> inlines;
+  if (!function->inlines.RetrieveRanges(address, &inlines))
+    return;
+
+  // The source position found for the address is in the innermost inlined
+  // call; each call's site is the source position in the code enclosing it.
+  const MemAddr module_base = frame->module->base_address();
+  string source_file_name = frame->source_file_name;
+  int source_line = frame->source_line;
+  uint64_t source_line_base = frame->source_line_base;
+  for (size_t i = 0; i < inlines.size(); ++i) {
+    const Inline *inlined = inlines[i]->get();
+    MemAddr inline_base = address;
+    for (size_t j = 0; j < inlined->ranges.size(); ++j) {
+      if (address >= inlined->ranges[j].first &&
+          address - inlined->ranges[j].first < inlined->ranges[j].second) {
+        inline_base = inlined->ranges[j].first;
+        break;
       }
-      frame->source_line = line->line;
-      frame->source_line_base = frame->module->base_address() + line_base;
     }
-  } else if (public_symbols_.Retrieve(address,
-                                      &public_symbol, &public_address) &&
-             (!func.get() || public_address > function_base)) {
-    frame->function_name = public_symbol->name;
-    frame->function_base = frame->module->base_address() + public_address;
+
+    StackFrame *inlined_frame = new StackFrame(*frame);
+    inlined_frame->trust = StackFrame::FRAME_TRUST_INLINE;
+    InlineOriginMap::const_iterator origin =
+        inline_origins_.find(inlined->origin_id);
+    inlined_frame->function_name =
+        origin != inline_origins_.end() ? origin->second : string();
+    inlined_frame->function_base = module_base + inline_base;
+    inlined_frame->source_file_name = source_file_name;
+    inlined_frame->source_line = source_line;
+    inlined_frame->source_line_base = source_line_base;
+    inlined_frames->push_back(inlined_frame);
+
+    FileMap::const_iterator file = files_.find(inlined->call_site_file_id);
+    source_file_name = file != files_.end() ? file->second : string();
+    source_line = inlined->call_site_line;
+    source_line_base = module_base + inline_base;
   }
+
+  frame->source_file_name = source_file_name;
+  frame->source_line = source_line;
+  frame->source_line_base = source_line_base;
 }
 
 WindowsFrameInfo *BasicSourceLineResolver::Module::FindWindowsFrameInfo(
@@ -275,12 +471,12 @@ WindowsFrameInfo *BasicSourceLineResolver::Module::FindWindowsFrameInfo(
   // includes its own program string.
   // WindowsFrameInfo::STACK_INFO_FPO is the older type
   // corresponding to the FPO_DATA struct. See stackwalker_x86.cc.
-  linked_ptr<WindowsFrameInfo> frame_info;
+  const linked_ptr<WindowsFrameInfo> *frame_info;
   if ((windows_frame_info_[WindowsFrameInfo::STACK_INFO_FRAME_DATA]
-       .RetrieveRange(address, &frame_info))
+       .RetrieveRangePtr(address, frame_info))
       || (windows_frame_info_[WindowsFrameInfo::STACK_INFO_FPO]
-          .RetrieveRange(address, &frame_info))) {
-    result->CopyFrom(*frame_info.get());
+          .RetrieveRangePtr(address, frame_info))) {
+    result->CopyFrom(*frame_info->get());
     return result.release();
   }
 
@@ -291,23 +487,24 @@ WindowsFrameInfo *BasicSourceLineResolver::Module::FindWindowsFrameInfo(
   // below. However, this does mean we need to check that ADDRESS
   // falls within the retrieved function's range; do the range
   // comparison in an overflow-friendly way.
-  linked_ptr<Function> function;
+  const linked_ptr<Function> *function = NULL;
   MemAddr function_base, function_size;
-  if (functions_.RetrieveNearestRange(address, &function, &function_base,
-                                      NULL /* delta */, &function_size) &&
+  if (functions_.RetrieveNearestRangePtr(address, function, &function_base,
+                                         NULL /* delta */, &function_size) &&
       address >= function_base && address - function_base < function_size) {
-    result->parameter_size = function->parameter_size;
+    ParseDeferredRecords(function->get());
+    result->parameter_size = (*function)->parameter_size;
     result->valid |= WindowsFrameInfo::VALID_PARAMETER_SIZE;
     return result.release();
   }
 
   // PUBLIC symbols might have a parameter size. Use the function we
   // found above to limit the range the public symbol covers.
-  linked_ptr<PublicSymbol> public_symbol;
+  const linked_ptr<PublicSymbol> *public_symbol;
   MemAddr public_address;
-  if (public_symbols_.Retrieve(address, &public_symbol, &public_address) &&
-      (!function.get() || public_address > function_base)) {
-    result->parameter_size = public_symbol->parameter_size;
+  if (public_symbols_.RetrievePtr(address, public_symbol, &public_address) &&
+      (!function || public_address > function_base)) {
+    result->parameter_size = (*public_symbol)->parameter_size;
   }
 
   return NULL;
@@ -316,15 +513,27 @@ WindowsFrameInfo *BasicSourceLineResolver::Module::FindWindowsFrameInfo(
 CFIFrameInfo *BasicSourceLineResolver::Module::FindCFIFrameInfo(
     const StackFrame *frame) const {
   MemAddr address = frame->instruction - frame->module->base_address();
+  if (lazy_) {
+    return FindCFIFrameInfo(lazy_cfi_initial_rules_, lazy_cfi_delta_rules_,
+                            address);
+  }
+  return FindCFIFrameInfo(cfi_initial_rules_, cfi_delta_rules_, address);
+}
+
+template<typename RuleText>
+CFIFrameInfo *BasicSourceLineResolver::Module::FindCFIFrameInfo(
+    const RangeMap<MemAddr, RuleText> &initial_rules_map,
+    const std::map<MemAddr, RuleText> &delta_rules,
+    MemAddr address) const {
   MemAddr initial_base, initial_size;
-  string initial_rules;
+  RuleText initial_rules;
 
   // Find the initial rule whose range covers this address. That
   // provides an initial set of register recovery rules. Then, walk
   // forward from the initial rule's starting address to frame's
   // instruction address, applying delta rules.
-  if (!cfi_initial_rules_.RetrieveRange(address, &initial_rules, &initial_base,
-                                        NULL /* delta */, &initial_size)) {
+  if (!initial_rules_map.RetrieveRange(address, &initial_rules, &initial_base,
+                                       NULL /* delta */, &initial_size)) {
     return NULL;
   }
 
@@ -335,11 +544,11 @@ CFIFrameInfo *BasicSourceLineResolver::Module::FindCFIFrameInfo(
     return NULL;
 
   // Find the first delta rule that falls within the initial rule's range.
-  map<MemAddr, string>::const_iterator delta =
-    cfi_delta_rules_.lower_bound(initial_base);
+  typename map<MemAddr, RuleText>::const_iterator delta =
+    delta_rules.lower_bound(initial_base);
 
   // Apply delta rules up to and including the frame's address.
-  while (delta != cfi_delta_rules_.end() && delta->first <= address) {
+  while (delta != delta_rules.end() && delta->first <= address) {
     ParseCFIRuleSet(delta->second, rules.get());
     delta++;
   }
@@ -357,6 +566,18 @@ bool BasicSourceLineResolver::Module::ParseFile(char *file_line) {
   return false;
 }
 
+bool BasicSourceLineResolver::Module::ParseInlineOrigin(
+    char *inline_origin_line) {
+  long origin_id;
+  char *name;
+  if (SymbolParseHelper::ParseInlineOrigin(inline_origin_line, &origin_id,
+                                           &name)) {
+    inline_origins_.insert(make_pair(origin_id, string(name)));
+    return true;
+  }
+  return false;
+}
+
 BasicSourceLineResolver::Function*
 BasicSourceLineResolver::Module::ParseFunction(char *function_line) {
   bool is_multiple;
@@ -371,8 +592,34 @@ BasicSourceLineResolver::Module::ParseFunction(char *function_line) {
   return NULL;
 }
 
-BasicSourceLineResolver::Line* BasicSourceLineResolver::Module::ParseLine(
-    char *line_line) {
+// static
+bool BasicSourceLineResolver::Module::ParseInline(char *inline_line,
+                                                  Function *function) {
+  long nest_level;
+  long call_site_line;
+  long call_site_file_id;
+  long origin_id;
+  linked_ptr<Inline> new_inline(new Inline());
+  if (!SymbolParseHelper::ParseInline(inline_line, &nest_level,
+                                      &call_site_line, &call_site_file_id,
+                                      &origin_id, &new_inline->ranges)) {
+    return false;
+  }
+  new_inline->call_site_line = call_site_line;
+  new_inline->call_site_file_id = call_site_file_id;
+  new_inline->origin_id = origin_id;
+
+  // As with functions, a range that can't be stored (because it overlaps
+  // another without nesting in it) is silently dropped.
+  for (size_t i = 0; i < new_inline->ranges.size(); ++i) {
+    function->inlines.StoreRange(new_inline->ranges[i].first,
+                                 new_inline->ranges[i].second, new_inline);
+  }
+  return true;
+}
+
+// static
+bool BasicSourceLineResolver::Module::ParseLine(char *line_line, Line *line) {
   uint64_t address;
   uint64_t size;
   long line_number;
@@ -380,9 +627,92 @@ BasicSourceLineResolver::Line* BasicSourceLineResolver::Module::ParseLine(
 
   if (SymbolParseHelper::ParseLine(line_line, &address, &size, &line_number,
                                    &source_file)) {
-    return new Line(address, size, source_file, line_number);
+    *line = Line(address, size, source_file, line_number);
+    return true;
   }
-  return NULL;
+  return false;
+}
+
+void BasicSourceLineResolver::Module::ParseLineRecord(char *line_line,
+                                                      Function *function,
+                                                      int line_number,
+                                                      int *num_errors) const {
+  if (!function) {
+    LogParseError("Found source line data without a function",
+                  line_number, num_errors);
+    return;
+  }
+  // Lines are stored in the order they appear in the symbol file, as that
+  // decides which of two overlapping lines is kept.
+  ParseDeferredRecords(function);
+  StoreLineRecord(line_line, function, line_number, num_errors);
+}
+
+// static
+void BasicSourceLineResolver::Module::StoreLineRecord(char *line_line,
+                                                      Function *function,
+                                                      int line_number,
+                                                      int *num_errors) {
+  Line line;
+  if (!ParseLine(line_line, &line)) {
+    LogParseError("ParseLine failed", line_number, num_errors);
+    return;
+  }
+  function->lines.StoreRange(line.address, line.size, line);
+}
+
+void BasicSourceLineResolver::Module::ParseDeferredRecords(
+    Function *function) const {
+  if (lazy_) {
+    std::call_once(function->parse_once, &Module::ParseUnparsedRecords, this,
+                   function);
+  }
+}
+
+void BasicSourceLineResolver::Module::ParseUnparsedRecords(
+    Function *function) const {
+  char *record = function->unparsed_records;
+  if (!record)
+    return;
+  function->unparsed_records = NULL;
+
+  int line_number = function->first_line_number;
+  int num_errors = 0;
+  for (int i = 0; i < function->unparsed_record_count; ++i, ++line_number) {
+    // The records were terminated in place when the module was loaded.
+    // Skip the terminator, and any line endings or empty lines after it.
+    while (*record == '\0' || *record == '\r' || *record == '\n')
+      ++record;
+    char *next = record + strlen(record);
+    if (i == 0) {
+      // The FUNC record, whose address and size are already known.
+      bool is_multiple;
+      uint64_t address;
+      uint64_t size;
+      long stack_param_size;
+      char *name;
+      if (SymbolParseHelper::ParseFunction(record, &is_multiple, &address,
+                                           &size, &stack_param_size, &name)) {
+        function->name = name;
+        function->parameter_size = stack_param_size;
+        function->is_multiple = is_multiple;
+      } else {
+        LogParseError("ParseFunction failed", line_number, &num_errors);
+      }
+    } else if (strncmp(record, "INLINE ", 7) == 0) {
+      if (!ParseInline(record, function))
+        LogParseError("ParseInline failed", line_number, &num_errors);
+    } else {
+      StoreLineRecord(record, function, line_number, &num_errors);
+    }
+    record = next;
+  }
+  function->unparsed_record_count = 0;
+}
+
+void BasicSourceLineResolver::Module::ParseAllDeferredRecords() const {
+  for (size_t i = 0; i < unparsed_functions_.size(); ++i)
+    ParseDeferredRecords(unparsed_functions_[i]);
 }
 
 bool BasicSourceLineResolver::Module::ParsePublicSymbol(char *public_line) {
@@ -489,7 +819,10 @@ bool BasicSourceLineResolver::Module::ParseCFIFrameInfo(
 
     MemAddr address = strtoul(address_field, NULL, 16);
     MemAddr size    = strtoul(size_field,    NULL, 16);
-    cfi_initial_rules_.StoreRange(address, size, initial_rules);
+    if (lazy_)
+      lazy_cfi_initial_rules_.StoreRange(address, size, initial_rules);
+    else
+      cfi_initial_rules_.StoreRange(address, size, initial_rules);
     return true;
   }
 
@@ -498,7 +831,10 @@ bool BasicSourceLineResolver::Module::ParseCFIFrameInfo(
   char *delta_rules = strtok_r(NULL, "\r\n", &cursor);
   if (!delta_rules) return false;
   MemAddr address = strtoul(address_field, NULL, 16);
-  cfi_delta_rules_[address] = delta_rules;
+  if (lazy_)
+    lazy_cfi_delta_rules_[address] = delta_rules;
+  else
+    cfi_delta_rules_[address] = delta_rules;
   return true;
 }
 
@@ -509,8 +845,8 @@ bool SymbolParseHelper::ParseFile(char *file_line, long *index,
   assert(strncmp(file_line, "FILE ", 5) == 0);
   file_line += 5;  // skip prefix
 
-  vector<char*> tokens;
-  if (!Tokenize(file_line, kWhitespace, 2, &tokens)) {
+  char *tokens[2];
+  if (!TokenizeInPlace(file_line, kWhitespace, 2, tokens)) {
     return false;
   }
 
@@ -537,8 +873,8 @@ bool SymbolParseHelper::ParseFunction(char *function_line, bool *is_multiple,
   assert(strncmp(function_line, "FUNC ", 5) == 0);
   function_line += 5;  // skip prefix
 
-  vector<char*> tokens;
-  if (!TokenizeWithOptionalField(function_line, "m", kWhitespace, 5, &tokens)) {
+  char *tokens[5];
+  if (!TokenizeWithOptionalField(function_line, "m", kWhitespace, 5, tokens)) {
     return false;
   }
 
@@ -572,8 +908,8 @@ bool SymbolParseHelper::ParseLine(char *line_line, uint64_t *address,
                                   uint64_t *size, long *line_number,
                                   long *source_file) {
   // <address> <size> <line number> <source file id>
-  vector<char*> tokens;
-  if (!Tokenize(line_line, kWhitespace, 4, &tokens)) {
+  char *tokens[4];
+  if (!TokenizeInPlace(line_line, kWhitespace, 4, tokens)) {
     return false;
   }
 
@@ -612,6 +948,88 @@ bool SymbolParseHelper::ParseLine(char *line_line, uint64_t *address,
   return true;
 }
 
+// static
+bool SymbolParseHelper::ParseInlineOrigin(char *inline_origin_line,
+                                          long *origin_id, char **name) {
+  // INLINE_ORIGIN <origin_id> <name>
+  assert(strncmp(inline_origin_line, "INLINE_ORIGIN ", 14) == 0);
+  inline_origin_line += 14;  // skip prefix
+
+  char *tokens[2];
+  if (!TokenizeInPlace(inline_origin_line, kWhitespace, 2, tokens)) {
+    return false;
+  }
+
+  char *after_number;
+  *origin_id = strtol(tokens[0], &after_number, 10);
+  if (!IsValidAfterNumber(after_number) || *origin_id < 0 ||
+      *origin_id == std::numeric_limits<long>::max()) {
+    return false;
+  }
+  *name = tokens[1];
+
+  return true;
+}
+
+// static
+bool SymbolParseHelper::ParseInline(
+    char *inline_line, long *nest_level, long *call_site_line,
+    long *call_site_file_id, long *origin_id,
+    std::vector<std::pair<uint64_t, uint64_t> > *ranges) {
+  // INLINE <nest_level> <call_site_line> <call_site_file_id> <origin_id>
+  // [<address> <size>]+
+  assert(strncmp(inline_line, "INLINE ", 7) == 0);
+  inline_line += 7;  // skip prefix
+
+  char *tokens[5];
+  if (!TokenizeInPlace(inline_line, kWhitespace, 5, tokens)) {
+    return false;
+  }
+
+  char *after_number;
+  *nest_level = strtol(tokens[0], &after_number, 10);
+  if (!IsValidAfterNumber(after_number) || *nest_level < 0 ||
+      *nest_level == std::numeric_limits<long>::max()) {
+    return false;
+  }
+  *call_site_line = strtol(tokens[1], &after_number, 10);
+  if (!IsValidAfterNumber(after_number) || *call_site_line < 0 ||
+      *call_site_line == std::numeric_limits<long>::max()) {
+    return false;
+  }
+  *call_site_file_id = strtol(tokens[2], &after_number, 10);
+  if (!IsValidAfterNumber(after_number) || *call_site_file_id < -1 ||
+      *call_site_file_id == std::numeric_limits<long>::max()) {
+    return false;
+  }
+  *origin_id = strtol(tokens[3], &after_number, 10);
+  if (!IsValidAfterNumber(after_number) || *origin_id < 0 ||
+      *origin_id == std::numeric_limits<long>::max()) {
+    return false;
+  }
+
+  // The remaining token holds one or more address and size pairs.
+  ranges->clear();
+  char *cursor = tokens[4];
+  while (*cursor != '\0') {
+    uint64_t address = strtoull(cursor, &after_number, 16);
+    if (!IsValidAfterNumber(after_number) ||
+        address == std::numeric_limits<unsigned long long>::max()) {
+      return false;
+    }
+    cursor = after_number + strspn(after_number, kWhitespace);
+    uint64_t size = strtoull(cursor, &after_number, 16);
+    if (after_number == cursor || !IsValidAfterNumber(after_number) ||
+        size == std::numeric_limits<unsigned long long>::max()) {
+      return false;
+    }
+    ranges->push_back(std::make_pair(address, size));
+    cursor = after_number + strspn(after_number, kWhitespace);
+  }
+
+  return !ranges->empty();
+}
+
 // static
 bool SymbolParseHelper::ParsePublicSymbol(char *public_line, bool *is_multiple,
                                           uint64_t *address,
@@ -621,8 +1039,8 @@ bool SymbolParseHelper::ParsePublicSymbol(char *public_line, bool *is_multiple,
   assert(strncmp(public_line, "PUBLIC ", 7) == 0);
   public_line += 7;  // skip prefix
 
-  vector<char*> tokens;
-  if (!TokenizeWithOptionalField(public_line, "m", kWhitespace, 4, &tokens)) {
+  char *tokens[4];
+  if (!TokenizeWithOptionalField(public_line, "m", kWhitespace, 4, tokens)) {
     return false;
   }
 
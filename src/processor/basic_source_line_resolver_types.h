@@ -38,7 +38,10 @@
 #define PROCESSOR_BASIC_SOURCE_LINE_RESOLVER_TYPES_H__
 
 #include <map>
+#include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/scoped_ptr.h"
 #include "google_breakpad/processor/basic_source_line_resolver.h"
@@ -55,6 +58,25 @@
 
 namespace google_breakpad {
 
+// A call inlined into a function, from an INLINE record.  The same Inline
+// is stored once for each of its address ranges.  The record's nesting
+// level is not kept: the ranges of nested calls lie within the ranges of
+// the calls enclosing them, which is how lookups find them.
+struct BasicSourceLineResolver::Inline {
+  typedef SourceLineResolverBase::MemAddr MemAddr;
+
+  // The line and file of the call site, in the function or inlined call
+  // enclosing this one.  call_site_file_id is -1 if the file is unknown.
+  int call_site_line;
+  int call_site_file_id;
+
+  // The INLINE_ORIGIN id of the inlined function.
+  int origin_id;
+
+  // The address ranges of the inlined code, relative to the module base.
+  std::vector<std::pair<MemAddr, MemAddr> > ranges;
+};
+
 struct
 BasicSourceLineResolver::Function : public SourceLineResolverBase::Function {
   Function(const string &function_name,
@@ -66,8 +88,34 @@ BasicSourceLineResolver::Function : public SourceLineResolverBase::Function {
                                    code_size,
                                    set_parameter_size,
                                    is_mutiple),
-                              lines() { }
-  RangeMap< MemAddr, linked_ptr<Line> > lines;
+                              lines(),
+                              inlines(true),
+                              unparsed_records(NULL),
+                              unparsed_record_count(0),
+                              first_line_number(0) { }
+  // Lines are stored by value: a function may have thousands of them, and
+  // a separate allocation for each would dominate the cost of loading.
+  RangeMap<MemAddr, Line> lines;
+
+  // The calls inlined into the function.  Inlined calls nest, and an
+  // inlined call may cover exactly the same range as the one enclosing it,
+  // so the map allows equal ranges; records arrive outermost first, so an
+  // equal range nests inside the one stored before it.
+  ContainedRangeMap<MemAddr, linked_ptr<Inline> > inlines;
+
+  // When the module is loaded lazily, only the address and size are read
+  // from the FUNC record.  The rest of it, and the INLINE and line records
+  // following it, are not parsed until the function is first looked up.
+  // Until then, unparsed_records points at the FUNC record, in the symbol
+  // data the module keeps, and unparsed_record_count says how many records
+  // there are, counting it.  first_line_number is the FUNC record's line
+  // number in the symbol file, for error messages.  The records are parsed
+  // once, under parse_once, as several threads may look up the function at
+  // the same time.
+  char *unparsed_records;
+  int unparsed_record_count;
+  int first_line_number;
+  std::once_flag parse_once;
  private:
   typedef SourceLineResolverBase::Function Base;
 };
@@ -75,14 +123,21 @@ BasicSourceLineResolver::Function : public SourceLineResolverBase::Function {
 
 class BasicSourceLineResolver::Module : public SourceLineResolverBase::Module {
  public:
-  explicit Module(const string &name) : name_(name), is_corrupt_(false) { }
+  // If |lazy| is true, each function's records are only parsed when the
+  // function is first looked up, and STACK CFI records are kept in the
+  // symbol data rather than copied.
+  explicit Module(const string &name, bool lazy = false)
+      : name_(name), is_corrupt_(false), lazy_(lazy) { }
   virtual ~Module() { }
 
   // Loads a map from the given buffer in char* type.
   // Does NOT have ownership of memory_buffer.
   // The passed in |memory buffer| is of size |memory_buffer_size|.  If it is
   // not null terminated, LoadMapFromMemory() will null terminate it by
-  // modifying the passed in buffer.
+  // modifying the passed in buffer.  A lazy module keeps pointers into
+  // |memory_buffer|, which must then outlive it.  Errors in the records a
+  // lazy module defers are logged when they are parsed, and do not make
+  // the module corrupt.
   virtual bool LoadMapFromMemory(char *memory_buffer,
                                  size_t memory_buffer_size);
 
@@ -92,7 +147,15 @@ class BasicSourceLineResolver::Module : public SourceLineResolverBase::Module {
 
   // Looks up the given relative address, and fills the StackFrame struct
   // with the result.
-  virtual void LookupAddress(StackFrame *frame) const;
+  virtual void LookupAddress(StackFrame *frame,
+                             std::vector<StackFrame*> *inlined_frames) const;
+
+  // Looks up the sorted |frames| in one pass, searching the functions and
+  // lines again only when an address leaves the ones the last address was
+  // found in.
+  virtual void LookupAddresses(
+      const std::vector<StackFrame*> &frames,
+      std::vector<std::vector<StackFrame*> > *inlined_frames) const;
 
   // If Windows stack walking information is available covering ADDRESS,
   // return a WindowsFrameInfo structure describing it. If the information
@@ -114,6 +177,27 @@ class BasicSourceLineResolver::Module : public SourceLineResolverBase::Module {
   friend class ModuleSerializer;
 
   typedef std::map<int, string> FileMap;
+  typedef std::map<int, string> InlineOriginMap;
+
+  // The function and line the last address looked up was found in, so that
+  // a lookup of an address within them needn't search for them again.  A
+  // size of 0 means there is no such function or line.
+  struct LookupCursor {
+    LookupCursor() : function(NULL), function_base(0), function_size(0),
+                     line_base(0), line_size(0) { }
+    const Function *function;
+    MemAddr function_base;
+    MemAddr function_size;
+    Line line;
+    MemAddr line_base;
+    MemAddr line_size;
+  };
+
+  // Looks up |frame| as LookupAddress does, starting from and updating
+  // |cursor|.
+  void LookupAddress(StackFrame *frame,
+                     std::vector<StackFrame*> *inlined_frames,
+                     LookupCursor *cursor) const;
 
   // Logs parse errors.  |*num_errors| is increased every time LogParseError is
   // called.
@@ -125,11 +209,50 @@ class BasicSourceLineResolver::Module : public SourceLineResolverBase::Module {
   // Parses a file declaration
   bool ParseFile(char *file_line);
 
+  // Parses an inline origin declaration, storing it in inline_origins_.
+  bool ParseInlineOrigin(char *inline_origin_line);
+
   // Parses a function declaration, returning a new Function object.
   Function* ParseFunction(char *function_line);
 
-  // Parses a line declaration, returning a new Line object.
-  Line* ParseLine(char *line_line);
+  // Parses an inlined call declaration and stores it in |function|'s
+  // inlines.  Returns false if an error occurs.
+  static bool ParseInline(char *inline_line, Function *function);
+
+  // Appends a frame to |inlined_frames| for each of the calls inlined at
+  // |address| in |function|, innermost first, and points |frame|'s source
+  // position at the call site of the outermost one.  |frame|'s source
+  // position must already describe |address|.
+  void AddInlinedFrames(const Function *function, MemAddr address,
+                        StackFrame *frame,
+                        std::vector<StackFrame*> *inlined_frames) const;
+
+  // Parses a line declaration into |*line|.  Returns false if an error
+  // occurs.
+  static bool ParseLine(char *line_line, Line *line);
+
+  // Parses a line declaration and stores it in |function|'s lines, logging
+  // an error if it can't be parsed or if |function| is NULL.
+  void ParseLineRecord(char *line_line, Function *function,
+                       int line_number, int *num_errors) const;
+
+  // Parses a line declaration and stores it in |function|'s lines, logging
+  // an error if it can't be parsed.  Unlike ParseLineRecord, this doesn't
+  // first parse the records a lazy module deferred for |function|.
+  static void StoreLineRecord(char *line_line, Function *function,
+                              int line_number, int *num_errors);
+
+  // Parses the records a lazy module deferred for |function|, if that
+  // hasn't been done yet.  Every use of a function other than its address
+  // and size must come after this.
+  void ParseDeferredRecords(Function *function) const;
+
+  // Does the work of ParseDeferredRecords, under |function|'s parse_once.
+  void ParseUnparsedRecords(Function *function) const;
+
+  // Parses the records of every function, so that the module is complete,
+  // as ModuleSerializer needs.
+  void ParseAllDeferredRecords() const;
 
   // Parses a PUBLIC symbol declaration, storing it in public_symbols_.
   // Returns false if an error occurs.
@@ -142,12 +265,27 @@ class BasicSourceLineResolver::Module : public SourceLineResolverBase::Module {
   // Parses a STACK CFI record, storing it in cfi_frame_info_.
   bool ParseCFIFrameInfo(char *stack_info_line);
 
+  // Returns the rules for |address| from the STACK CFI records in
+  // |initial_rules| and |delta_rules|, as FindCFIFrameInfo does.
+  template<typename RuleText>
+  CFIFrameInfo *FindCFIFrameInfo(
+      const RangeMap<MemAddr, RuleText> &initial_rules,
+      const std::map<MemAddr, RuleText> &delta_rules,
+      MemAddr address) const;
+
   string name_;
   FileMap files_;
+  InlineOriginMap inline_origins_;
   RangeMap< MemAddr, linked_ptr<Function> > functions_;
   AddressMap< MemAddr, linked_ptr<PublicSymbol> > public_symbols_;
   bool is_corrupt_;
 
+  // Whether functions are parsed on first lookup.
+  bool lazy_;
+
+  // The functions whose records a lazy module deferred.
+  std::vector<Function*> unparsed_functions_;
+
   // Each element in the array is a ContainedRangeMap for a type
   // listed in WindowsFrameInfoTypes. These are split by type because
   // there may be overlaps between maps of different types, but some
@@ -172,6 +310,12 @@ class BasicSourceLineResolver::Module : public SourceLineResolverBase::Module {
   // this map, or the end of the range as given by the cfi_initial_rules_
   // entry (which FindCFIFrameInfo looks up first).
   std::map<MemAddr, string> cfi_delta_rules_;
+
+  // A lazy module stores its STACK CFI records here instead, indexed by
+  // address like the maps above, but pointing at the rules in the symbol
+  // data the module keeps rather than copying them.
+  RangeMap<MemAddr, const char*> lazy_cfi_initial_rules_;
+  std::map<MemAddr, const char*> lazy_cfi_delta_rules_;
 };
 
 }  // namespace google_breakpad
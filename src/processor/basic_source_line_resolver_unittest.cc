@@ -30,7 +30,10 @@
 #include <assert.h>
 #include <stdio.h>
 
+#include <algorithm>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "breakpad_googletest_includes.h"
 #include "common/scoped_ptr.h"
@@ -43,13 +46,16 @@
 #include "processor/logging.h"
 #include "processor/windows_frame_info.h"
 #include "processor/cfi_frame_info.h"
+#include "processor/cfi_rule_program.h"
 
 namespace {
 
 using google_breakpad::BasicSourceLineResolver;
 using google_breakpad::CFIFrameInfo;
+using google_breakpad::CFIRuleProgram;
 using google_breakpad::CodeModule;
 using google_breakpad::MemoryRegion;
+using google_breakpad::SourceLineResolverBase;
 using google_breakpad::StackFrame;
 using google_breakpad::WindowsFrameInfo;
 using google_breakpad::linked_ptr;
@@ -58,18 +64,23 @@ using google_breakpad::SymbolParseHelper;
 
 class TestCodeModule : public CodeModule {
  public:
-  TestCodeModule(string code_file) : code_file_(code_file) {}
+  TestCodeModule(string code_file,
+                 string debug_file = "",
+                 string debug_identifier = "")
+      : code_file_(code_file),
+        debug_file_(debug_file),
+        debug_identifier_(debug_identifier) {}
   virtual ~TestCodeModule() {}
 
   virtual uint64_t base_address() const { return 0; }
   virtual uint64_t size() const { return 0xb000; }
   virtual string code_file() const { return code_file_; }
   virtual string code_identifier() const { return ""; }
-  virtual string debug_file() const { return ""; }
-  virtual string debug_identifier() const { return ""; }
+  virtual string debug_file() const { return debug_file_; }
+  virtual string debug_identifier() const { return debug_identifier_; }
   virtual string version() const { return ""; }
   virtual CodeModule* Copy() const {
-    return new TestCodeModule(code_file_);
+    return new TestCodeModule(code_file_, debug_file_, debug_identifier_);
   }
   virtual bool is_unloaded() const { return false; }
   virtual uint64_t shrink_down_delta() const { return 0; }
@@ -77,6 +88,8 @@ class TestCodeModule : public CodeModule {
 
  private:
   string code_file_;
+  string debug_file_;
+  string debug_identifier_;
 };
 
 // A mock memory region object, for use by the STACK CFI tests.
@@ -413,6 +426,473 @@ TEST_F(TestBasicSourceLineResolver, TestUnload)
   ASSERT_TRUE(resolver.HasModule(&module1));
 }
 
+TEST_F(TestBasicSourceLineResolver, TestModuleCache)
+{
+  // module1.out and module2.out are 1000 and 663 bytes long; each module
+  // counts for one more, for the null terminator.
+  resolver.set_symbol_data_budget(2100);
+
+  TestCodeModule module1("module1");
+  TestCodeModule module2("module2");
+  TestCodeModule module3("module3");
+  ASSERT_FALSE(resolver.HasModule(&module1));
+  ASSERT_TRUE(resolver.LoadModule(&module1, testdata_dir + "/module1.out"));
+  ASSERT_TRUE(resolver.LoadModule(&module2, testdata_dir + "/module2.out"));
+  SourceLineResolverBase::ModuleCacheStats stats =
+      resolver.module_cache_stats();
+  EXPECT_EQ(2U, stats.modules);
+  EXPECT_EQ(1665U, stats.symbol_data_bytes);
+  EXPECT_EQ(0U, stats.evictions);
+
+  // Using module1 makes module2 the least recently used, so loading module3
+  // evicts it.
+  ASSERT_TRUE(resolver.HasModule(&module1));
+  ASSERT_TRUE(resolver.LoadModule(&module3, testdata_dir + "/module1.out"));
+  EXPECT_TRUE(resolver.HasModule(&module1));
+  EXPECT_FALSE(resolver.HasModule(&module2));
+  EXPECT_TRUE(resolver.HasModule(&module3));
+  stats = resolver.module_cache_stats();
+  EXPECT_EQ(2U, stats.modules);
+  EXPECT_EQ(2002U, stats.symbol_data_bytes);
+  EXPECT_EQ(1U, stats.evictions);
+  EXPECT_EQ(3U, stats.loads);
+  EXPECT_EQ(0U, stats.reloads);
+
+  // A pinned module is passed over, even though it is the least recently
+  // used.  Loading module2 again counts as a reload, as it was evicted.
+  resolver.PinModule(&module1);
+  ASSERT_TRUE(resolver.LoadModule(&module2, testdata_dir + "/module2.out"));
+  EXPECT_TRUE(resolver.HasModule(&module1));
+  EXPECT_TRUE(resolver.HasModule(&module2));
+  EXPECT_FALSE(resolver.HasModule(&module3));
+  resolver.UnpinModule(&module1);
+  stats = resolver.module_cache_stats();
+  EXPECT_EQ(4U, stats.loads);
+  EXPECT_EQ(1U, stats.reloads);
+
+  // Lowering the budget evicts right away.
+  resolver.set_symbol_data_budget(700);
+  stats = resolver.module_cache_stats();
+  EXPECT_EQ(1U, stats.modules);
+  EXPECT_EQ(664U, stats.symbol_data_bytes);
+  EXPECT_EQ(3U, stats.evictions);
+  EXPECT_TRUE(resolver.HasModule(&module2));
+}
+
+TEST_F(TestBasicSourceLineResolver, TestModuleKeys)
+{
+  // By default, modules are loaded under their code file, whatever their
+  // budget.
+  TestCodeModule libc1("/lib/libc.so.6", "libc.so.6", "0123456789ABCDEF0");
+  TestCodeModule libc2("/other/libc.so.6", "libc.so.6", "0123456789ABCDEF0");
+  TestCodeModule libc3("/lib/libc.so.6", "libc.so.6", "FEDCBA9876543210F");
+  resolver.set_symbol_data_budget(10000);
+  ASSERT_TRUE(resolver.LoadModule(&libc1, testdata_dir + "/module2.out"));
+  EXPECT_FALSE(resolver.HasModule(&libc2));
+  EXPECT_TRUE(resolver.HasModule(&libc3));
+
+  // The keying can't change once modules are loaded.
+  EXPECT_FALSE(resolver.set_key_by_debug_identifier(true));
+  EXPECT_FALSE(resolver.HasModule(&libc2));
+  resolver.UnloadModule(&libc1);
+  EXPECT_TRUE(resolver.set_key_by_debug_identifier(true));
+
+  // Keyed by debug file and identifier, modules of the same build share
+  // their symbols, whatever their code file, and other builds don't.
+  ASSERT_TRUE(resolver.LoadModule(&libc1, testdata_dir + "/module2.out"));
+  EXPECT_TRUE(resolver.HasModule(&libc2));
+  EXPECT_FALSE(resolver.HasModule(&libc3));
+  ASSERT_TRUE(resolver.LoadModule(&libc3, testdata_dir + "/module1.out"));
+  EXPECT_TRUE(resolver.HasModule(&libc3));
+  EXPECT_EQ(2U, resolver.module_cache_stats().modules);
+}
+
+TEST_F(TestBasicSourceLineResolver, TestCFICache)
+{
+  TestCodeModule module1("module1");
+  ASSERT_TRUE(resolver.LoadModule(&module1, testdata_dir + "/module1.out"));
+  StackFrame frame;
+  frame.module = &module1;
+
+  // The first lookup at an address builds the rules; the second finds
+  // them in the cache.
+  frame.instruction = 0x3d54;
+  scoped_ptr<CFIFrameInfo> first(resolver.FindCFIFrameInfo(&frame));
+  scoped_ptr<CFIFrameInfo> second(resolver.FindCFIFrameInfo(&frame));
+  ASSERT_TRUE(first.get());
+  ASSERT_TRUE(second.get());
+  EXPECT_EQ(".cfa: $ebp 8 + .ra: .cfa 4 - ^ $ebp: .cfa 8 - ^ "
+            "$ebx: .cfa 20 - ^", second->Serialize());
+  SourceLineResolverBase::CFICacheStats stats = resolver.cfi_cache_stats();
+  EXPECT_EQ(1U, stats.hits);
+  EXPECT_EQ(1U, stats.misses);
+  EXPECT_EQ(1U, stats.entries);
+
+  // Copies of the cached rules share the program compiled from them.
+  int key;
+  CFIRuleProgram::Register registers[] = { { "$esp", ".cfa", false } };
+  const CFIRuleProgram *program = first->SetProgram(
+      new CFIRuleProgram(*first, registers, 1, 4, &key));
+  ASSERT_TRUE(program);
+  EXPECT_EQ(program, second->program(&key));
+  scoped_ptr<CFIFrameInfo> third(resolver.FindCFIFrameInfo(&frame));
+  EXPECT_EQ(program, third->program(&key));
+
+  // Addresses without CFI are remembered too.
+  frame.instruction = 0x3d3f;
+  EXPECT_FALSE(resolver.FindCFIFrameInfo(&frame));
+  EXPECT_FALSE(resolver.FindCFIFrameInfo(&frame));
+  stats = resolver.cfi_cache_stats();
+  EXPECT_EQ(3U, stats.hits);
+  EXPECT_EQ(2U, stats.misses);
+  EXPECT_EQ(2U, stats.entries);
+  EXPECT_EQ(0U, stats.evictions);
+
+  // Lowering the capacity drops the least recently used.
+  resolver.set_cfi_cache_capacity(1);
+  stats = resolver.cfi_cache_stats();
+  EXPECT_EQ(1U, stats.entries);
+  EXPECT_EQ(1U, stats.evictions);
+  frame.instruction = 0x3d54;
+  first.reset(resolver.FindCFIFrameInfo(&frame));
+  ASSERT_TRUE(first.get());
+  EXPECT_FALSE(first->program(&key));
+  stats = resolver.cfi_cache_stats();
+  EXPECT_EQ(3U, stats.misses);
+  EXPECT_EQ(2U, stats.evictions);
+
+  // Unloading a module drops its rules.
+  resolver.UnloadModule(&module1);
+  EXPECT_EQ(0U, resolver.cfi_cache_stats().entries);
+  EXPECT_FALSE(resolver.FindCFIFrameInfo(&frame));
+
+  // A capacity of 0 disables the cache.
+  resolver.set_cfi_cache_capacity(0);
+  ASSERT_TRUE(resolver.LoadModule(&module1, testdata_dir + "/module1.out"));
+  first.reset(resolver.FindCFIFrameInfo(&frame));
+  ASSERT_TRUE(first.get());
+  stats = resolver.cfi_cache_stats();
+  EXPECT_EQ(0U, stats.entries);
+  EXPECT_EQ(4U, stats.misses);
+}
+
+TEST_F(TestBasicSourceLineResolver, TestLineEndings)
+{
+  // Records may end in "\n" or "\r\n", and empty lines are ignored.
+  string symbols =
+      "MODULE Linux x86 0123456789ABCDEF0 module\r\n"
+      "FILE 1 file1.cc\r\n"
+      "\r\n"
+      "FUNC 1000 20 0 Function1\r\n"
+      "1000 10 7 1\r\n"
+      "\n"
+      "1010 10 9 1\n"
+      "FUNC m 2000 10 0 Function2\n"
+      "2000 10 12 1";
+  TestCodeModule module("module");
+  ASSERT_TRUE(resolver.LoadModuleUsingMapBuffer(&module, symbols));
+  ASSERT_FALSE(resolver.IsModuleCorrupt(&module));
+
+  StackFrame frame;
+  frame.instruction = 0x1014;
+  frame.module = &module;
+  resolver.FillSourceLineInfo(&frame);
+  EXPECT_EQ("Function1", frame.function_name);
+  EXPECT_EQ("file1.cc", frame.source_file_name);
+  EXPECT_EQ(9, frame.source_line);
+
+  frame.instruction = 0x2004;
+  resolver.FillSourceLineInfo(&frame);
+  EXPECT_EQ("Function2", frame.function_name);
+  EXPECT_EQ(12, frame.source_line);
+}
+
+TEST_F(TestBasicSourceLineResolver, TestLazyParsing)
+{
+  resolver.set_lazy_parsing(true);
+  ASSERT_TRUE(resolver.ShouldDeleteMemoryBufferAfterLoadModule());
+
+  TestCodeModule module1("module1");
+  ASSERT_TRUE(resolver.LoadModule(&module1, testdata_dir + "/module1.out"));
+  ASSERT_FALSE(resolver.IsModuleCorrupt(&module1));
+
+  StackFrame frame;
+  frame.instruction = 0x1104;
+  frame.module = &module1;
+  resolver.FillSourceLineInfo(&frame);
+  EXPECT_EQ("Function1_2", frame.function_name);
+  EXPECT_EQ("file1_2.cc", frame.source_file_name);
+  EXPECT_EQ(66, frame.source_line);
+  EXPECT_EQ(0x1104U, frame.source_line_base);
+
+  ClearSourceLineInfo(&frame);
+  frame.instruction = 0x1008;
+  frame.module = &module1;
+  resolver.FillSourceLineInfo(&frame);
+  EXPECT_EQ("Function1_1", frame.function_name);
+  EXPECT_EQ("file1_1.cc", frame.source_file_name);
+  EXPECT_EQ(46, frame.source_line);
+
+  // Line records are only checked when they are parsed, so a bad one
+  // doesn't make the module corrupt, and doesn't keep the other lines of
+  // its function from being found.
+  string symbols =
+      "FILE 1 file1.cc\n"
+      "FUNC 1000 20 0 Function1\n"
+      "1000 10 7 1\n"
+      "1010 bad\n"
+      "FUNC 2000 10 0 Function2\n"
+      "2000 10 12 1\n";
+  TestCodeModule module2("module2");
+  ASSERT_TRUE(resolver.LoadModuleUsingMapBuffer(&module2, symbols));
+  ASSERT_FALSE(resolver.IsModuleCorrupt(&module2));
+
+  ClearSourceLineInfo(&frame);
+  frame.instruction = 0x1004;
+  frame.module = &module2;
+  resolver.FillSourceLineInfo(&frame);
+  EXPECT_EQ("Function1", frame.function_name);
+  EXPECT_EQ(7, frame.source_line);
+
+  ClearSourceLineInfo(&frame);
+  frame.instruction = 0x1014;
+  frame.module = &module2;
+  resolver.FillSourceLineInfo(&frame);
+  EXPECT_EQ("Function1", frame.function_name);
+  EXPECT_EQ(0, frame.source_line);
+
+  // Unloading frees the symbol data the module kept.
+  resolver.UnloadModule(&module2);
+  EXPECT_FALSE(resolver.HasModule(&module2));
+
+  // The resolver keeps its own copy of a buffer it is given, so the
+  // caller may free it as usual.
+  char *buffer = new char[symbols.size() + 1];
+  memcpy(buffer, symbols.c_str(), symbols.size() + 1);
+  ASSERT_TRUE(resolver.LoadModuleUsingMemoryBuffer(&module2, buffer,
+                                                   symbols.size() + 1));
+  memset(buffer, 'x', symbols.size());
+  delete [] buffer;
+  ClearSourceLineInfo(&frame);
+  frame.instruction = 0x2004;
+  frame.module = &module2;
+  resolver.FillSourceLineInfo(&frame);
+  EXPECT_EQ("Function2", frame.function_name);
+  EXPECT_EQ(12, frame.source_line);
+}
+
+TEST_F(TestBasicSourceLineResolver, TestLazyParsingMatchesEager)
+{
+  // A lazy module finds the same functions, parameter sizes and CFI rules
+  // as one parsed in full.
+  BasicSourceLineResolver eager;
+  resolver.set_lazy_parsing(true);
+  TestCodeModule module1("module1");
+  ASSERT_TRUE(eager.LoadModule(&module1, testdata_dir + "/module1.out"));
+  ASSERT_TRUE(resolver.LoadModule(&module1, testdata_dir + "/module1.out"));
+
+  const uint64_t addresses[] = { 0x1000, 0x1104, 0x2170, 0x3d3f, 0x3d40,
+                                 0x3d54, 0x3e99, 0x3ea0 };
+  for (size_t i = 0; i < sizeof(addresses) / sizeof(addresses[0]); ++i) {
+    StackFrame eager_frame;
+    StackFrame lazy_frame;
+    eager_frame.instruction = lazy_frame.instruction = addresses[i];
+    eager_frame.module = lazy_frame.module = &module1;
+    eager.FillSourceLineInfo(&eager_frame);
+    resolver.FillSourceLineInfo(&lazy_frame);
+    EXPECT_EQ(eager_frame.function_name, lazy_frame.function_name);
+    EXPECT_EQ(eager_frame.function_base, lazy_frame.function_base);
+    EXPECT_EQ(eager_frame.source_file_name, lazy_frame.source_file_name);
+    EXPECT_EQ(eager_frame.source_line, lazy_frame.source_line);
+
+    scoped_ptr<WindowsFrameInfo> eager_wfi(
+        eager.FindWindowsFrameInfo(&eager_frame));
+    scoped_ptr<WindowsFrameInfo> lazy_wfi(
+        resolver.FindWindowsFrameInfo(&lazy_frame));
+    ASSERT_EQ(eager_wfi.get() == NULL, lazy_wfi.get() == NULL);
+    if (eager_wfi.get())
+      EXPECT_EQ(eager_wfi->parameter_size, lazy_wfi->parameter_size);
+
+    scoped_ptr<CFIFrameInfo> eager_cfi(eager.FindCFIFrameInfo(&eager_frame));
+    scoped_ptr<CFIFrameInfo> lazy_cfi(resolver.FindCFIFrameInfo(&lazy_frame));
+    ASSERT_EQ(eager_cfi.get() == NULL, lazy_cfi.get() == NULL);
+    if (eager_cfi.get())
+      EXPECT_EQ(eager_cfi->Serialize(), lazy_cfi->Serialize());
+  }
+}
+
+TEST_F(TestBasicSourceLineResolver, TestInlines)
+{
+  // inlinee_b is inlined into caller at file1.cc:12, and inlinee_a into
+  // inlinee_b at file2.h:5.
+  string symbols =
+      "FILE 0 file1.cc\n"
+      "FILE 1 file2.h\n"
+      "INLINE_ORIGIN 0 inlinee_a\n"
+      "INLINE_ORIGIN 1 inlinee_b\n"
+      "FUNC 1000 100 0 caller\n"
+      "INLINE 0 12 0 1 1010 20 1080 80\n"
+      "INLINE 1 5 1 0 1014 8\n"
+      "1000 14 10 0\n"
+      "1014 8 3 1\n"
+      "101c e4 20 1\n";
+
+  // Inline records are read the same way whether or not line records are
+  // parsed lazily.
+  for (int lazy = 0; lazy < 2; ++lazy) {
+    BasicSourceLineResolver resolver;
+    resolver.set_lazy_parsing(lazy);
+    TestCodeModule module("module");
+    ASSERT_TRUE(resolver.LoadModuleUsingMapBuffer(&module, symbols));
+    ASSERT_FALSE(resolver.IsModuleCorrupt(&module));
+
+    StackFrame frame;
+    std::vector<StackFrame*> inlined_frames;
+    frame.instruction = 0x1016;
+    frame.module = &module;
+    resolver.FillSourceLineInfo(&frame, &inlined_frames);
+    EXPECT_EQ("caller", frame.function_name);
+    EXPECT_EQ(0x1000U, frame.function_base);
+    EXPECT_EQ("file1.cc", frame.source_file_name);
+    EXPECT_EQ(12, frame.source_line);
+    ASSERT_EQ(2U, inlined_frames.size());
+    EXPECT_EQ(StackFrame::FRAME_TRUST_INLINE, inlined_frames[0]->trust);
+    EXPECT_EQ(0x1016U, inlined_frames[0]->instruction);
+    EXPECT_EQ("inlinee_a", inlined_frames[0]->function_name);
+    EXPECT_EQ(0x1014U, inlined_frames[0]->function_base);
+    EXPECT_EQ("file2.h", inlined_frames[0]->source_file_name);
+    EXPECT_EQ(3, inlined_frames[0]->source_line);
+    EXPECT_EQ(0x1014U, inlined_frames[0]->source_line_base);
+    EXPECT_EQ("inlinee_b", inlined_frames[1]->function_name);
+    EXPECT_EQ(0x1010U, inlined_frames[1]->function_base);
+    EXPECT_EQ("file2.h", inlined_frames[1]->source_file_name);
+    EXPECT_EQ(5, inlined_frames[1]->source_line);
+    for (size_t i = 0; i < inlined_frames.size(); ++i)
+      delete inlined_frames[i];
+    inlined_frames.clear();
+
+    // The second range of inlinee_b.
+    ClearSourceLineInfo(&frame);
+    frame.instruction = 0x1090;
+    frame.module = &module;
+    resolver.FillSourceLineInfo(&frame, &inlined_frames);
+    EXPECT_EQ("file1.cc", frame.source_file_name);
+    EXPECT_EQ(12, frame.source_line);
+    ASSERT_EQ(1U, inlined_frames.size());
+    EXPECT_EQ("inlinee_b", inlined_frames[0]->function_name);
+    EXPECT_EQ(0x1080U, inlined_frames[0]->function_base);
+    EXPECT_EQ("file2.h", inlined_frames[0]->source_file_name);
+    EXPECT_EQ(20, inlined_frames[0]->source_line);
+    delete inlined_frames[0];
+    inlined_frames.clear();
+
+    // Outside any inlined call.
+    ClearSourceLineInfo(&frame);
+    frame.instruction = 0x1004;
+    frame.module = &module;
+    resolver.FillSourceLineInfo(&frame, &inlined_frames);
+    EXPECT_EQ("file1.cc", frame.source_file_name);
+    EXPECT_EQ(10, frame.source_line);
+    EXPECT_TRUE(inlined_frames.empty());
+
+    // Without inlined_frames, the innermost source position is reported.
+    ClearSourceLineInfo(&frame);
+    frame.instruction = 0x1016;
+    frame.module = &module;
+    resolver.FillSourceLineInfo(&frame);
+    EXPECT_EQ("caller", frame.function_name);
+    EXPECT_EQ("file2.h", frame.source_file_name);
+    EXPECT_EQ(3, frame.source_line);
+  }
+}
+
+TEST_F(TestBasicSourceLineResolver, TestBatchLookup)
+{
+  // Unsorted, with repeats, gaps between lines and functions, a public
+  // symbol, an inlined call and nothing at all.
+  const uint64_t kAddresses[] = {
+    0x1104, 0x1000, 0x1004, 0x1004, 0x100c, 0x1100, 0x1250, 0x1fff, 0x2000,
+    0x2800, 0x2900, 0x3000, 0x5000, 0x9fff, 0xa000, 0x1016, 0x1090, 0x0
+  };
+  const size_t kAddressCount = sizeof(kAddresses) / sizeof(kAddresses[0]);
+  string inline_symbols =
+      "FILE 0 file1.cc\n"
+      "FILE 1 file2.h\n"
+      "INLINE_ORIGIN 0 inlinee_a\n"
+      "INLINE_ORIGIN 1 inlinee_b\n"
+      "FUNC 1000 100 0 caller\n"
+      "INLINE 0 12 0 1 1010 20 1080 80\n"
+      "INLINE 1 5 1 0 1014 8\n"
+      "1000 14 10 0\n"
+      "1014 8 3 1\n"
+      "101c e4 20 1\n";
+
+  for (int lazy = 0; lazy < 2; ++lazy) {
+    BasicSourceLineResolver resolver;
+    resolver.set_lazy_parsing(lazy);
+    TestCodeModule module1("module1");
+    ASSERT_TRUE(resolver.LoadModule(&module1, testdata_dir + "/module1.out"));
+    TestCodeModule module2("module2");
+    ASSERT_TRUE(resolver.LoadModuleUsingMapBuffer(&module2, inline_symbols));
+
+    const CodeModule *modules[] = { &module1, &module2 };
+    for (size_t m = 0; m < sizeof(modules) / sizeof(modules[0]); ++m) {
+      // Sorted addresses take the single sweep, unsorted ones are sorted
+      // first; both must match looking each address up on its own.
+      for (int sorted = 0; sorted < 2; ++sorted) {
+        std::vector<uint64_t> addresses(kAddresses,
+                                        kAddresses + kAddressCount);
+        if (sorted)
+          std::sort(addresses.begin(), addresses.end());
+
+        std::vector<StackFrame> frames(addresses.size());
+        std::vector<StackFrame*> frame_pointers;
+        for (size_t i = 0; i < addresses.size(); ++i) {
+          frames[i].instruction = addresses[i];
+          frames[i].module = modules[m];
+          frame_pointers.push_back(&frames[i]);
+        }
+        std::vector<std::vector<StackFrame*> > inlined_frames;
+        resolver.FillSourceLineInfo(modules[m], frame_pointers,
+                                    &inlined_frames);
+        ASSERT_EQ(addresses.size(), inlined_frames.size());
+
+        for (size_t i = 0; i < addresses.size(); ++i) {
+          StackFrame expected;
+          expected.instruction = addresses[i];
+          expected.module = modules[m];
+          std::vector<StackFrame*> expected_inlined_frames;
+          resolver.FillSourceLineInfo(&expected, &expected_inlined_frames);
+          EXPECT_EQ(expected.function_name, frames[i].function_name);
+          EXPECT_EQ(expected.function_base, frames[i].function_base);
+          EXPECT_EQ(expected.source_file_name, frames[i].source_file_name);
+          EXPECT_EQ(expected.source_line, frames[i].source_line);
+          EXPECT_EQ(expected.source_line_base, frames[i].source_line_base);
+          ASSERT_EQ(expected_inlined_frames.size(), inlined_frames[i].size());
+          for (size_t j = 0; j < inlined_frames[i].size(); ++j) {
+            EXPECT_EQ(expected_inlined_frames[j]->function_name,
+                      inlined_frames[i][j]->function_name);
+            EXPECT_EQ(expected_inlined_frames[j]->source_line,
+                      inlined_frames[i][j]->source_line);
+            delete expected_inlined_frames[j];
+            delete inlined_frames[i][j];
+          }
+        }
+      }
+    }
+
+    // Without inlined_frames, the frames are still filled in.
+    StackFrame frame;
+    frame.instruction = 0x1016;
+    frame.module = &module2;
+    std::vector<StackFrame*> frame_pointers(1, &frame);
+    resolver.FillSourceLineInfo(&module2, frame_pointers, NULL);
+    EXPECT_EQ("caller", frame.function_name);
+    EXPECT_EQ("file2.h", frame.source_file_name);
+    EXPECT_EQ(3, frame.source_line);
+  }
+}
+
 // Test parsing of valid FILE lines.  The format is:
 // FILE <id> <filename>
 TEST(SymbolParseHelper, ParseFileValid) {
@@ -736,6 +1216,113 @@ TEST(SymbolParseHelper, ParsePublicSymbolInvalid) {
                                                     &name));
 }
 
+// Test parsing of valid INLINE_ORIGIN lines.  The format is:
+// INLINE_ORIGIN <origin_id> <name>
+TEST(SymbolParseHelper, ParseInlineOriginValid) {
+  long origin_id;
+  char *name;
+
+  char kTestLine[] = "INLINE_ORIGIN 3 function name";
+  ASSERT_TRUE(SymbolParseHelper::ParseInlineOrigin(kTestLine, &origin_id,
+                                                   &name));
+  EXPECT_EQ(3, origin_id);
+  EXPECT_EQ("function name", string(name));
+}
+
+// Test parsing of invalid INLINE_ORIGIN lines.
+TEST(SymbolParseHelper, ParseInlineOriginInvalid) {
+  long origin_id;
+  char *name;
+
+  // Test missing name.
+  char kTestLine[] = "INLINE_ORIGIN 3 ";
+  ASSERT_FALSE(SymbolParseHelper::ParseInlineOrigin(kTestLine, &origin_id,
+                                                    &name));
+  // Test bad id.
+  char kTestLine1[] = "INLINE_ORIGIN x3 name";
+  ASSERT_FALSE(SymbolParseHelper::ParseInlineOrigin(kTestLine1, &origin_id,
+                                                    &name));
+  // Test negative id.
+  char kTestLine2[] = "INLINE_ORIGIN -3 name";
+  ASSERT_FALSE(SymbolParseHelper::ParseInlineOrigin(kTestLine2, &origin_id,
+                                                    &name));
+}
+
+// Test parsing of valid INLINE lines.  The format is:
+// INLINE <nest_level> <call_site_line> <call_site_file_id> <origin_id>
+// [<address> <size>]+
+TEST(SymbolParseHelper, ParseInlineValid) {
+  long nest_level;
+  long call_site_line;
+  long call_site_file_id;
+  long origin_id;
+  std::vector<std::pair<uint64_t, uint64_t> > ranges;
+
+  char kTestLine[] = "INLINE 1 12 3 4 a10 20 b80 8";
+  ASSERT_TRUE(SymbolParseHelper::ParseInline(kTestLine, &nest_level,
+                                             &call_site_line,
+                                             &call_site_file_id, &origin_id,
+                                             &ranges));
+  EXPECT_EQ(1, nest_level);
+  EXPECT_EQ(12, call_site_line);
+  EXPECT_EQ(3, call_site_file_id);
+  EXPECT_EQ(4, origin_id);
+  ASSERT_EQ(2U, ranges.size());
+  EXPECT_EQ(0xa10ULL, ranges[0].first);
+  EXPECT_EQ(0x20ULL, ranges[0].second);
+  EXPECT_EQ(0xb80ULL, ranges[1].first);
+  EXPECT_EQ(0x8ULL, ranges[1].second);
+
+  // A call site file of -1 is unknown, but valid.
+  char kTestLine1[] = "INLINE 0 12 -1 4 a10 20";
+  ASSERT_TRUE(SymbolParseHelper::ParseInline(kTestLine1, &nest_level,
+                                             &call_site_line,
+                                             &call_site_file_id, &origin_id,
+                                             &ranges));
+  EXPECT_EQ(-1, call_site_file_id);
+  EXPECT_EQ(1U, ranges.size());
+}
+
+// Test parsing of invalid INLINE lines.
+TEST(SymbolParseHelper, ParseInlineInvalid) {
+  long nest_level;
+  long call_site_line;
+  long call_site_file_id;
+  long origin_id;
+  std::vector<std::pair<uint64_t, uint64_t> > ranges;
+
+  // Test missing ranges.
+  char kTestLine[] = "INLINE 0 12 3 4";
+  ASSERT_FALSE(SymbolParseHelper::ParseInline(kTestLine, &nest_level,
+                                              &call_site_line,
+                                              &call_site_file_id, &origin_id,
+                                              &ranges));
+  // Test a range without a size.
+  char kTestLine1[] = "INLINE 0 12 3 4 a10 20 b80";
+  ASSERT_FALSE(SymbolParseHelper::ParseInline(kTestLine1, &nest_level,
+                                              &call_site_line,
+                                              &call_site_file_id, &origin_id,
+                                              &ranges));
+  // Test bad address.
+  char kTestLine2[] = "INLINE 0 12 3 4 a1z 20";
+  ASSERT_FALSE(SymbolParseHelper::ParseInline(kTestLine2, &nest_level,
+                                              &call_site_line,
+                                              &call_site_file_id, &origin_id,
+                                              &ranges));
+  // Test bad call site file.
+  char kTestLine3[] = "INLINE 0 12 -2 4 a10 20";
+  ASSERT_FALSE(SymbolParseHelper::ParseInline(kTestLine3, &nest_level,
+                                              &call_site_line,
+                                              &call_site_file_id, &origin_id,
+                                              &ranges));
+  // Test negative nest level.
+  char kTestLine4[] = "INLINE -1 12 3 4 a10 20";
+  ASSERT_FALSE(SymbolParseHelper::ParseInline(kTestLine4, &nest_level,
+                                              &call_site_line,
+                                              &call_site_file_id, &origin_id,
+                                              &ranges));
+}
+
 }  // namespace
 
 int main(int argc, char *argv[]) {
@@ -0,0 +1,212 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// breakpad_symbolizer.cc: Serve symbol lookups to RemoteSourceLineResolver
+// clients, such as minidump_stackwalk -r, over a Unix domain socket, from
+// symbols kept loaded for as long as the server runs.
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "common/path_helper.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "processor/logging.h"
+#include "processor/simple_symbol_supplier.h"
+#include "processor/symbolizer_server.h"
+
+namespace {
+
+using google_breakpad::BasicSourceLineResolver;
+using google_breakpad::SimpleSymbolSupplier;
+using google_breakpad::SymbolizerServer;
+
+struct Options {
+  size_t symbol_data_budget;
+  int max_connections;
+  int missing_symbols_ttl;
+
+  string socket_path;
+  std::vector<string> symbol_paths;
+};
+
+// Returns a socket listening on socket_path, or -1 on failure.  A socket
+// left behind by an earlier server is replaced, but no other kind of file.
+int Listen(const string &socket_path) {
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (socket_path.size() >= sizeof(address.sun_path)) {
+    fprintf(stderr, "Socket path too long: %s\n", socket_path.c_str());
+    return -1;
+  }
+  memcpy(address.sun_path, socket_path.data(), socket_path.size());
+
+  struct stat st;
+  if (lstat(socket_path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+    unlink(socket_path.c_str());
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    fprintf(stderr, "socket failed: %s\n", strerror(errno));
+    return -1;
+  }
+  if (bind(fd, reinterpret_cast<struct sockaddr*>(&address),
+           sizeof(address)) < 0 ||
+      listen(fd, SOMAXCONN) < 0) {
+    fprintf(stderr, "Could not listen on %s: %s\n", socket_path.c_str(),
+            strerror(errno));
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+}  // namespace
+
+static void Usage(int argc, const char *argv[], bool error) {
+  fprintf(error ? stderr : stdout,
+          "Usage: %s [options] <socket-path> <symbol-path> [symbol-path ...]\n"
+          "\n"
+          "Serve symbol lookups from the given symbol paths on the Unix\n"
+          "domain socket <socket-path>, keeping symbols loaded between\n"
+          "requests\n"
+          "\n"
+          "Options:\n"
+          "\n"
+          "  -c <bytes>  Keep at most <bytes> of symbol data loaded,\n"
+          "              unloading the least recently used modules beyond\n"
+          "              that\n"
+          "  -j <count>  Serve at most <count> connections at once\n"
+          "              (default %d)\n"
+          "  -n <secs>   Answer a module whose symbols are missing as\n"
+          "              missing for <secs> before looking again\n"
+          "              (default %d)\n",
+          google_breakpad::BaseName(argv[0]).c_str(),
+          SymbolizerServer::kDefaultMaxConnections,
+          SymbolizerServer::kDefaultMissingSymbolsTTL);
+}
+
+static void SetupOptions(int argc, const char *argv[], Options *options) {
+  int ch;
+
+  options->symbol_data_budget = 0;
+  options->max_connections = SymbolizerServer::kDefaultMaxConnections;
+  options->missing_symbols_ttl = SymbolizerServer::kDefaultMissingSymbolsTTL;
+
+  while ((ch = getopt(argc, (char * const *)argv, "c:hj:n:")) != -1) {
+    switch (ch) {
+      case 'h':
+        Usage(argc, argv, false);
+        exit(0);
+        break;
+
+      case 'c': {
+        char *end;
+        options->symbol_data_budget = strtoull(optarg, &end, 10);
+        if (*optarg == '\0' || *end != '\0') {
+          fprintf(stderr, "%s: Invalid cache size: %s\n", argv[0], optarg);
+          Usage(argc, argv, true);
+          exit(1);
+        }
+        break;
+      }
+
+      case 'j': {
+        char *end;
+        long value = strtol(optarg, &end, 10);
+        if (*optarg == '\0' || *end != '\0' || value < 1 || value > INT_MAX) {
+          fprintf(stderr, "%s: Invalid connection count: %s\n", argv[0],
+                  optarg);
+          Usage(argc, argv, true);
+          exit(1);
+        }
+        options->max_connections = value;
+        break;
+      }
+
+      case 'n': {
+        char *end;
+        long value = strtol(optarg, &end, 10);
+        if (*optarg == '\0' || *end != '\0' || value < 0 || value > INT_MAX) {
+          fprintf(stderr, "%s: Invalid time: %s\n", argv[0], optarg);
+          Usage(argc, argv, true);
+          exit(1);
+        }
+        options->missing_symbols_ttl = value;
+        break;
+      }
+
+      case '?':
+        Usage(argc, argv, true);
+        exit(1);
+        break;
+    }
+  }
+
+  if ((argc - optind) < 2) {
+    fprintf(stderr, "%s: Missing socket path or symbol path\n", argv[0]);
+    Usage(argc, argv, true);
+    exit(1);
+  }
+
+  options->socket_path = argv[optind];
+  for (int argi = optind + 1; argi < argc; ++argi)
+    options->symbol_paths.push_back(argv[argi]);
+}
+
+int main(int argc, const char *argv[]) {
+  Options options;
+  SetupOptions(argc, argv, &options);
+
+  SimpleSymbolSupplier supplier(options.symbol_paths);
+  BasicSourceLineResolver resolver;
+  // Clients bring dumps of every build of a module, so keep the builds
+  // apart even when no budget is set.
+  resolver.set_key_by_debug_identifier(true);
+  resolver.set_symbol_data_budget(options.symbol_data_budget);
+  SymbolizerServer server(&supplier, &resolver);
+  server.set_missing_symbols_ttl(options.missing_symbols_ttl);
+
+  int listen_fd = Listen(options.socket_path);
+  if (listen_fd < 0)
+    return 1;
+  return server.Serve(listen_fd, options.max_connections) ? 0 : 1;
+}
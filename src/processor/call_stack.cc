@@ -48,7 +48,10 @@ void CallStack::Clear() {
        ++iterator) {
     delete *iterator;
   }
+  frames_.clear();
   tid_ = 0;
+  thread_name_.clear();
+  truncation_ = CALL_STACK_NOT_TRUNCATED;
 }
 
 }  // namespace google_breakpad
@@ -38,6 +38,10 @@
 
 #include <string.h>
 
+#include <vector>
+
+#include "processor/cfi_rule_program.h"
+
 namespace google_breakpad {
 
 template <typename RegisterType, class RawContextType>
@@ -48,6 +52,51 @@ bool SimpleCFIWalker<RegisterType, RawContextType>::FindCallerRegisters(
     int callee_validity,
     RawContextType *caller_context,
     int *caller_validity) const {
+  // Use the rules compiled for this register set, compiling them the
+  // first time they are applied with it.
+  const CFIRuleProgram *program = cfi_frame_info.program(register_map_);
+  if (!program) {
+    std::vector<CFIRuleProgram::Register> registers(map_size_);
+    for (size_t i = 0; i < map_size_; i++) {
+      registers[i].name = register_map_[i].name;
+      registers[i].alternate_name = register_map_[i].alternate_name;
+      registers[i].callee_saves = register_map_[i].callee_saves;
+    }
+    program = cfi_frame_info.SetProgram(
+        new CFIRuleProgram(cfi_frame_info, registers.data(), map_size_,
+                           sizeof(RegisterType), register_map_));
+  }
+
+  if (program && program->compiled()) {
+    RegisterType callee_registers[CFIRuleProgram::kMaxRegisters];
+    RegisterType caller_registers[CFIRuleProgram::kMaxRegisters];
+    uint64_t callee_valid = 0;
+    uint64_t caller_valid;
+    for (size_t i = 0; i < map_size_; i++) {
+      const RegisterSet &r = register_map_[i];
+      if (callee_validity & r.validity_flag) {
+        callee_registers[i] = callee_context.*r.context_member;
+        callee_valid |= static_cast<uint64_t>(1) << i;
+      }
+    }
+
+    if (!program->Evaluate(callee_registers, callee_valid, memory,
+                           caller_registers, &caller_valid))
+      return false;
+
+    memset(caller_context, 0xda, sizeof(*caller_context));
+    *caller_validity = 0;
+    for (size_t i = 0; i < map_size_; i++) {
+      const RegisterSet &r = register_map_[i];
+      if (caller_valid & (static_cast<uint64_t>(1) << i)) {
+        caller_context->*r.context_member = caller_registers[i];
+        *caller_validity |= r.validity_flag;
+      }
+    }
+    return true;
+  }
+
+  // The rules couldn't be compiled; interpret them instead.
   typedef CFIFrameInfo::RegisterValueMap<RegisterType> ValueMap;
   ValueMap callee_registers;
   ValueMap caller_registers;
@@ -39,6 +39,7 @@
 #include <sstream>
 
 #include "common/scoped_ptr.h"
+#include "processor/cfi_rule_program.h"
 #include "processor/postfix_evaluator-inl.h"
 
 namespace google_breakpad {
@@ -53,7 +54,7 @@ bool CFIFrameInfo::FindCallerRegs(const RegisterValueMap<V> &registers,
                                   RegisterValueMap<V> *caller_registers) const {
   // If there are not rules for both .ra and .cfa in effect at this address,
   // don't use this CFI data for stack walking.
-  if (cfa_rule_.empty() || ra_rule_.empty())
+  if (rules_->cfa_rule.empty() || rules_->ra_rule.empty())
     return false;
 
   RegisterValueMap<V> working;
@@ -64,19 +65,19 @@ bool CFIFrameInfo::FindCallerRegs(const RegisterValueMap<V> &registers,
   // First, compute the CFA.
   V cfa;
   working = registers;
-  if (!evaluator.EvaluateForValue(cfa_rule_, &cfa))
+  if (!evaluator.EvaluateForValue(rules_->cfa_rule, &cfa))
     return false;
 
   // Then, compute the return address.
   V ra;
   working = registers;
   working[".cfa"] = cfa;
-  if (!evaluator.EvaluateForValue(ra_rule_, &ra))
+  if (!evaluator.EvaluateForValue(rules_->ra_rule, &ra))
     return false;
 
-  // Now, compute values for all the registers register_rules_ mentions.
-  for (RuleMap::const_iterator it = register_rules_.begin();
-       it != register_rules_.end(); it++) {
+  // Now, compute values for all the registers the register rules mention.
+  for (RuleMap::const_iterator it = rules_->register_rules.begin();
+       it != rules_->register_rules.end(); it++) {
     V value;
     working = registers;
     working[".cfa"] = cfa;
@@ -101,19 +102,51 @@ template bool CFIFrameInfo::FindCallerRegs<uint64_t>(
     const MemoryRegion &memory,
     RegisterValueMap<uint64_t> *caller_registers) const;
 
+CFIFrameInfo::Rules::~Rules() {
+  delete program.load();
+}
+
+const CFIRuleProgram *CFIFrameInfo::program(const void *key) const {
+  const CFIRuleProgram *program =
+      rules_->program.load(std::memory_order_acquire);
+  if (program && program->key() == key)
+    return program;
+  return NULL;
+}
+
+const CFIRuleProgram *CFIFrameInfo::SetProgram(CFIRuleProgram *program) const {
+  CFIRuleProgram *expected = NULL;
+  if (rules_->program.compare_exchange_strong(expected, program,
+                                              std::memory_order_acq_rel))
+    return program;
+
+  // Another program is already set; |expected| now holds it.
+  bool same_key = expected->key() == program->key();
+  delete program;
+  return same_key ? expected : NULL;
+}
+
+CFIFrameInfo::Rules *CFIFrameInfo::MutableRules() {
+  if (rules_.use_count() > 1)
+    rules_.reset(new Rules(*rules_));
+  else
+    delete rules_->program.exchange(NULL);
+  return rules_.get();
+}
+
 string CFIFrameInfo::Serialize() const {
   std::ostringstream stream;
 
-  if (!cfa_rule_.empty()) {
-    stream << ".cfa: " << cfa_rule_;
+  if (!rules_->cfa_rule.empty()) {
+    stream << ".cfa: " << rules_->cfa_rule;
   }
-  if (!ra_rule_.empty()) {
+  if (!rules_->ra_rule.empty()) {
     if (static_cast<std::streamoff>(stream.tellp()) != 0)
       stream << " ";
-    stream << ".ra: " << ra_rule_;
+    stream << ".ra: " << rules_->ra_rule;
   }
-  for (RuleMap::const_iterator iter = register_rules_.begin();
-       iter != register_rules_.end();
+  for (RuleMap::const_iterator iter = rules_->register_rules.begin();
+       iter != rules_->register_rules.end();
        ++iter) {
     if (static_cast<std::streamoff>(stream.tellp()) != 0)
       stream << " ";
@@ -38,7 +38,9 @@
 #ifndef PROCESSOR_CFI_FRAME_INFO_H_
 #define PROCESSOR_CFI_FRAME_INFO_H_
 
+#include <atomic>
 #include <map>
+#include <memory>
 #include <string>
 
 #include "common/using_std_string.h"
@@ -48,6 +50,7 @@ namespace google_breakpad {
 
 using std::map;
 
+class CFIRuleProgram;
 class MemoryRegion;
 
 // A set of rules for recovering the calling frame's registers'
@@ -69,13 +72,22 @@ class CFIFrameInfo {
   template<typename ValueType> class RegisterValueMap: 
     public map<string, ValueType> { };
 
+  // Copies share the rules, and the program compiled from them, if any,
+  // until their rules are changed, so that copying is cheap and a program
+  // compiled for one copy serves them all.
+  CFIFrameInfo() : rules_(new Rules) { }
+
   // Set the expression for computing a call frame address, return
   // address, or register's value. At least the CFA rule and the RA
   // rule must be set before calling FindCallerRegs.
-  void SetCFARule(const string &expression) { cfa_rule_ = expression; }
-  void SetRARule(const string &expression)  { ra_rule_ = expression; }
+  void SetCFARule(const string &expression) {
+    MutableRules()->cfa_rule = expression;
+  }
+  void SetRARule(const string &expression) {
+    MutableRules()->ra_rule = expression;
+  }
   void SetRegisterRule(const string &register_name, const string &expression) {
-    register_rules_[register_name] = expression;
+    MutableRules()->register_rules[register_name] = expression;
   }
 
   // Compute the values of the calling frame's registers, according to
@@ -104,34 +116,73 @@ class CFIFrameInfo {
   // of STACK CFI records.
   string Serialize() const;
 
+  // Return the CFIRuleProgram compiled from these rules whose key() is
+  // KEY, or NULL if none has been set.
+  const CFIRuleProgram *program(const void *key) const;
+
+  // Keep PROGRAM, which must have been compiled from these rules, for
+  // program() to return, taking ownership of it. If another thread has
+  // already set a program with the same key, delete PROGRAM and return
+  // that one instead; otherwise return PROGRAM. An instance holds one
+  // program: if it already holds one with a different key, delete
+  // PROGRAM and return NULL.
+  const CFIRuleProgram *SetProgram(CFIRuleProgram *program) const;
+
  private:
+  friend class CFIRuleProgram;
 
   // A map from register names onto evaluation rules. 
   typedef map<string, string> RuleMap;
 
   // In this type, a "postfix expression" is an expression of the sort
   // interpreted by google_breakpad::PostfixEvaluator.
+  struct Rules {
+    Rules() : program(NULL) { }
+    // Copies the rules, but not the program compiled from them.
+    Rules(const Rules &that)
+        : cfa_rule(that.cfa_rule),
+          ra_rule(that.ra_rule),
+          register_rules(that.register_rules),
+          program(NULL) { }
+    ~Rules();
+
+    // A postfix expression for computing the current frame's CFA (call
+    // frame address). The CFA is a reference address for the frame that
+    // remains unchanged throughout the frame's lifetime. You should
+    // evaluate this expression with a dictionary initially populated
+    // with the values of the current frame's known registers.
+    string cfa_rule;
+
+    // The following expressions should be evaluated with a dictionary
+    // initially populated with the values of the current frame's known
+    // registers, and with ".cfa" set to the result of evaluating the
+    // cfa_rule expression, above.
+
+    // A postfix expression for computing the current frame's return
+    // address. 
+    string ra_rule;
+
+    // For a register named REG, rules[REG] is a postfix expression
+    // which leaves the value of REG in the calling frame on the top of
+    // the stack. You should evaluate this expression
+    RuleMap register_rules;
+
+    // The program compiled from the rules for a stack walker's register
+    // set, if one has been set.  Walkers may share an instance, and
+    // copies of it, across threads, so the program is set atomically.
+    std::atomic<CFIRuleProgram*> program;
+
+   private:
+    void operator=(const Rules &that);
+  };
+
+  // Returns the rules for changing.  Rules shared with copies of this
+  // instance are never changed: this instance gets its own copy first.
+  // Either way, the program compiled from the rules is dropped.
+  Rules *MutableRules();
 
-  // A postfix expression for computing the current frame's CFA (call
-  // frame address). The CFA is a reference address for the frame that
-  // remains unchanged throughout the frame's lifetime. You should
-  // evaluate this expression with a dictionary initially populated
-  // with the values of the current frame's known registers.
-  string cfa_rule_;
-
-  // The following expressions should be evaluated with a dictionary
-  // initially populated with the values of the current frame's known
-  // registers, and with ".cfa" set to the result of evaluating the
-  // cfa_rule expression, above.
-
-  // A postfix expression for computing the current frame's return
-  // address. 
-  string ra_rule_;
-
-  // For a register named REG, rules[REG] is a postfix expression
-  // which leaves the value of REG in the calling frame on the top of
-  // the stack. You should evaluate this expression
-  RuleMap register_rules_;
+  // The rules, shared with copies of this instance.
+  std::shared_ptr<Rules> rules_;
 };
 
 // A parser for STACK CFI-style rule sets.
@@ -0,0 +1,375 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// cfi_rule_program.cc: Implementation of CFIRuleProgram.
+// See cfi_rule_program.h for details.
+
+#include "processor/cfi_rule_program.h"
+
+#include <string.h>
+
+#include <sstream>
+
+#include "google_breakpad/processor/memory_region.h"
+#include "processor/cfi_frame_info.h"
+
+namespace google_breakpad {
+
+namespace {
+
+// Returns true if |token| consists of decimal digits from position
+// |start| on.
+bool IsDigits(const string &token, size_t start) {
+  return token.find_first_not_of("0123456789", start) == string::npos;
+}
+
+// If |token| is a literal as PostfixEvaluator reads it, a run of decimal
+// digits with an optional leading '-', sets *value to it, truncated to
+// |value_size| bytes, and returns true.  A literal too large for
+// |value_size| bytes isn't one: PostfixEvaluator treats it as an
+// identifier.
+bool ParseLiteral(const string &token, size_t value_size, uint64_t *value) {
+  size_t i = 0;
+  bool negative = false;
+  if (token[0] == '-') {
+    negative = true;
+    i = 1;
+  }
+  if (i == token.size())
+    return false;
+
+  uint64_t limit = value_size >= sizeof(uint64_t) ?
+      ~static_cast<uint64_t>(0) : (static_cast<uint64_t>(1) <<
+                                    (value_size * 8)) - 1;
+  uint64_t literal = 0;
+  for (; i < token.size(); ++i) {
+    if (token[i] < '0' || token[i] > '9')
+      return false;
+    unsigned digit = token[i] - '0';
+    if (literal > (limit - digit) / 10)
+      return false;
+    literal = literal * 10 + digit;
+  }
+
+  *value = (negative ? -literal : literal) & limit;
+  return true;
+}
+
+}  // namespace
+
+CFIRuleProgram::CFIRuleProgram(const CFIFrameInfo &frame_info,
+                               const Register *registers,
+                               size_t register_count,
+                               size_t value_size,
+                               const void *key)
+    : key_(key), compiled_(false), value_size_(value_size) {
+  if (register_count > kMaxRegisters ||
+      frame_info.rules_->register_rules.size() > kMaxRegisters)
+    return;
+
+  for (size_t i = 0; i < register_count; ++i) {
+    // A register table naming a register twice would have one shadow
+    // the other in FindCallerRegs' maps.
+    if (FindRegister(registers[i].name) != -1)
+      return;
+    register_names_.push_back(registers[i].name);
+  }
+
+  // An empty CFA or RA rule compiles to an expression that always fails,
+  // just as FindCallerRegs refuses to use such rules.
+  if (!CompileExpression(frame_info.rules_->cfa_rule, true, &cfa_rule_) ||
+      !CompileExpression(frame_info.rules_->ra_rule, false, &ra_rule_))
+    return;
+
+  for (CFIFrameInfo::RuleMap::const_iterator it =
+           frame_info.rules_->register_rules.begin();
+       it != frame_info.rules_->register_rules.end(); ++it) {
+    Expression rule;
+    if (!CompileExpression(it->second, false, &rule))
+      return;
+    register_rule_names_.push_back(it->first);
+    register_rules_.push_back(rule);
+  }
+
+  for (size_t i = 0; i < register_count; ++i) {
+    const Register &r = registers[i];
+    Source source;
+    if (FindSource(r.name, &source) ||
+        (r.alternate_name && FindSource(r.alternate_name, &source))) {
+      sources_.push_back(source);
+      continue;
+    }
+    source.kind = r.callee_saves ? SOURCE_CALLEE : SOURCE_NONE;
+    source.rule = 0;
+    sources_.push_back(source);
+  }
+
+  compiled_ = true;
+}
+
+int CFIRuleProgram::FindRegister(const string &name) const {
+  for (size_t i = 0; i < register_names_.size(); ++i) {
+    if (register_names_[i] == name)
+      return static_cast<int>(i);
+  }
+  return -1;
+}
+
+bool CFIRuleProgram::FindSource(const char *name, Source *source) const {
+  source->rule = 0;
+  if (strcmp(name, ".cfa") == 0) {
+    source->kind = SOURCE_CFA;
+    return true;
+  }
+  if (strcmp(name, ".ra") == 0) {
+    source->kind = SOURCE_RA;
+    return true;
+  }
+  for (size_t i = 0; i < register_rule_names_.size(); ++i) {
+    if (register_rule_names_[i] == name) {
+      source->kind = SOURCE_RULE;
+      source->rule = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool CFIRuleProgram::CompileExpression(const string &expression,
+                                       bool is_cfa_rule,
+                                       Expression *compiled) {
+  compiled->begin = instructions_.size();
+
+  std::istringstream stream(expression);
+  string token;
+  size_t depth = 0;
+  bool fails = false;
+  while (stream >> token) {
+    // Assignments only make sense with variables that persist between
+    // tokens, which registers held in arrays don't.  Leave those to
+    // PostfixEvaluator, along with literals with a leading '+', or more
+    // than one '-', that istream's extraction operators happen to accept.
+    if (token[0] == '=' ||
+        (token.size() > 1 && (token[0] == '+' ||
+                              (token[0] == '-' && !IsDigits(token, 1)))))
+      return false;
+    if (fails)
+      continue;
+
+    Instruction instruction;
+    instruction.operand = 0;
+    int pops = 0;
+    if (token == "+") {
+      instruction.opcode = OP_ADD;
+      pops = 2;
+    } else if (token == "-") {
+      instruction.opcode = OP_SUBTRACT;
+      pops = 2;
+    } else if (token == "*") {
+      instruction.opcode = OP_MULTIPLY;
+      pops = 2;
+    } else if (token == "/") {
+      instruction.opcode = OP_DIVIDE;
+      pops = 2;
+    } else if (token == "%") {
+      instruction.opcode = OP_MODULUS;
+      pops = 2;
+    } else if (token == "@") {
+      instruction.opcode = OP_ALIGN;
+      pops = 2;
+    } else if (token == "^") {
+      instruction.opcode = OP_DEREFERENCE;
+      pops = 1;
+    } else if (ParseLiteral(token, value_size_, &instruction.operand)) {
+      instruction.opcode = OP_PUSH_CONSTANT;
+    } else if (token == ".cfa" && !is_cfa_rule) {
+      instruction.opcode = OP_PUSH_CFA;
+    } else {
+      int number = FindRegister(token);
+      if (number == -1) {
+        // PostfixEvaluator fails when it finds no value for an
+        // identifier, and every identifier is looked up before an
+        // expression yields its value.  Keep looking for assignments,
+        // which could give it one.
+        fails = true;
+        continue;
+      }
+      instruction.opcode = OP_PUSH_REGISTER;
+      instruction.operand = number;
+    }
+
+    if (depth < static_cast<size_t>(pops)) {
+      fails = true;
+      continue;
+    }
+    depth = depth - pops + 1;
+    if (depth > kMaxStackDepth)
+      return false;
+    instructions_.push_back(instruction);
+  }
+
+  // A successful evaluation leaves exactly one value on the stack.
+  if (fails || depth != 1) {
+    instructions_.resize(compiled->begin);
+    Instruction fail = { OP_FAIL, 0 };
+    instructions_.push_back(fail);
+  }
+  compiled->end = instructions_.size();
+  return true;
+}
+
+template<typename ValueType>
+bool CFIRuleProgram::EvaluateExpression(const Expression &expression,
+                                        const ValueType *callee_registers,
+                                        uint64_t callee_valid,
+                                        ValueType cfa,
+                                        const MemoryRegion &memory,
+                                        ValueType *value) const {
+  // CompileExpression has checked that the stack neither underflows nor
+  // grows deeper than this.
+  ValueType stack[kMaxStackDepth];
+  size_t depth = 0;
+  for (size_t i = expression.begin; i < expression.end; ++i) {
+    const Instruction &instruction = instructions_[i];
+    switch (instruction.opcode) {
+      case OP_PUSH_CONSTANT:
+        stack[depth++] = static_cast<ValueType>(instruction.operand);
+        break;
+      case OP_PUSH_REGISTER:
+        if (!(callee_valid & (static_cast<uint64_t>(1) << instruction.operand)))
+          return false;
+        stack[depth++] = callee_registers[instruction.operand];
+        break;
+      case OP_PUSH_CFA:
+        stack[depth++] = cfa;
+        break;
+      case OP_ADD:
+        --depth;
+        stack[depth - 1] = stack[depth - 1] + stack[depth];
+        break;
+      case OP_SUBTRACT:
+        --depth;
+        stack[depth - 1] = stack[depth - 1] - stack[depth];
+        break;
+      case OP_MULTIPLY:
+        --depth;
+        stack[depth - 1] = stack[depth - 1] * stack[depth];
+        break;
+      case OP_DIVIDE:
+        --depth;
+        if (stack[depth] == 0)
+          return false;
+        stack[depth - 1] = stack[depth - 1] / stack[depth];
+        break;
+      case OP_MODULUS:
+        --depth;
+        if (stack[depth] == 0)
+          return false;
+        stack[depth - 1] = stack[depth - 1] % stack[depth];
+        break;
+      case OP_ALIGN:
+        --depth;
+        stack[depth - 1] = stack[depth - 1] &
+            (static_cast<ValueType>(-1) ^ (stack[depth] - 1));
+        break;
+      case OP_DEREFERENCE:
+        if (!memory.GetMemoryAtAddress(stack[depth - 1], &stack[depth - 1]))
+          return false;
+        break;
+      case OP_FAIL:
+        return false;
+    }
+  }
+  *value = stack[0];
+  return true;
+}
+
+template<typename ValueType>
+bool CFIRuleProgram::Evaluate(const ValueType *callee_registers,
+                              uint64_t callee_valid,
+                              const MemoryRegion &memory,
+                              ValueType *caller_registers,
+                              uint64_t *caller_valid) const {
+  ValueType cfa, ra;
+  if (!EvaluateExpression(cfa_rule_, callee_registers, callee_valid,
+                          ValueType(), memory, &cfa) ||
+      !EvaluateExpression(ra_rule_, callee_registers, callee_valid,
+                          cfa, memory, &ra))
+    return false;
+
+  // FindCallerRegs fails if any rule does, even one for a register
+  // that isn't in the table.
+  ValueType rule_values[kMaxRegisters];
+  for (size_t i = 0; i < register_rules_.size(); ++i) {
+    if (!EvaluateExpression(register_rules_[i], callee_registers,
+                            callee_valid, cfa, memory, &rule_values[i]))
+      return false;
+  }
+
+  *caller_valid = 0;
+  for (size_t i = 0; i < sources_.size(); ++i) {
+    uint64_t bit = static_cast<uint64_t>(1) << i;
+    switch (sources_[i].kind) {
+      case SOURCE_NONE:
+        continue;
+      case SOURCE_CFA:
+        caller_registers[i] = cfa;
+        break;
+      case SOURCE_RA:
+        caller_registers[i] = ra;
+        break;
+      case SOURCE_RULE:
+        caller_registers[i] = rule_values[sources_[i].rule];
+        break;
+      case SOURCE_CALLEE:
+        if (!(callee_valid & bit))
+          continue;
+        caller_registers[i] = callee_registers[i];
+        break;
+    }
+    *caller_valid |= bit;
+  }
+  return true;
+}
+
+// Explicit instantiations for 32-bit and 64-bit architectures.
+template bool CFIRuleProgram::Evaluate<uint32_t>(
+    const uint32_t *callee_registers,
+    uint64_t callee_valid,
+    const MemoryRegion &memory,
+    uint32_t *caller_registers,
+    uint64_t *caller_valid) const;
+template bool CFIRuleProgram::Evaluate<uint64_t>(
+    const uint64_t *callee_registers,
+    uint64_t callee_valid,
+    const MemoryRegion &memory,
+    uint64_t *caller_registers,
+    uint64_t *caller_valid) const;
+
+}  // namespace google_breakpad
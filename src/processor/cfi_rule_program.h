@@ -0,0 +1,189 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// cfi_rule_program.h: Define the CFIRuleProgram class, which holds a
+// CFIFrameInfo's rules compiled for one architecture's register set.
+
+#ifndef PROCESSOR_CFI_RULE_PROGRAM_H_
+#define PROCESSOR_CFI_RULE_PROGRAM_H_
+
+#include <string>
+#include <vector>
+
+#include "common/using_std_string.h"
+#include "google_breakpad/common/breakpad_types.h"
+
+namespace google_breakpad {
+
+class CFIFrameInfo;
+class MemoryRegion;
+
+// CFIFrameInfo::FindCallerRegs interprets its postfix expressions anew
+// each time it is called, looking registers up by name in maps of
+// strings.  A CFIRuleProgram is the same rules translated, once, into
+// instructions that refer to registers by their position in an
+// architecture's register table, and that Evaluate runs over arrays of
+// register values.
+//
+// Evaluate yields the same registers, and succeeds and fails in the same
+// cases, as SimpleCFIWalker::FindCallerRegisters does using
+// FindCallerRegs, except that it fails where FindCallerRegs would divide
+// by zero.  A few unusual expressions, such as those assigning to
+// variables, are not compiled; compiled() is false for such rules, and
+// FindCallerRegs must be used instead.
+class CFIRuleProgram {
+ public:
+  // A register, as SimpleCFIWalker::RegisterSet describes it.
+  struct Register {
+    const char *name;
+    const char *alternate_name;
+    bool callee_saves;
+  };
+
+  // The most registers a program may be compiled for, and the deepest
+  // evaluation stack an expression in it may use.
+  static const size_t kMaxRegisters = 64;
+  static const size_t kMaxStackDepth = 16;
+
+  // Compiles |frame_info|'s rules for the |register_count| registers in
+  // |registers|, whose values are |value_size| bytes long.  |key| is
+  // returned by key(), to identify the register table the program was
+  // compiled for.
+  CFIRuleProgram(const CFIFrameInfo &frame_info,
+                 const Register *registers,
+                 size_t register_count,
+                 size_t value_size,
+                 const void *key);
+
+  // Returns true if the rules were compiled, and Evaluate may be used.
+  bool compiled() const { return compiled_; }
+
+  const void *key() const { return key_; }
+
+  // Computes the caller's registers from the callee's, given in
+  // |callee_registers| in register table order.  Bit i of
+  // |callee_valid| is set if callee_registers[i] is known.  On success,
+  // sets each caller_registers[i] that could be recovered, and the
+  // corresponding bit of *caller_valid, and returns true.  ValueType
+  // must be |value_size| bytes long.
+  template<typename ValueType>
+  bool Evaluate(const ValueType *callee_registers,
+                uint64_t callee_valid,
+                const MemoryRegion &memory,
+                ValueType *caller_registers,
+                uint64_t *caller_valid) const;
+
+ private:
+  enum Opcode {
+    OP_PUSH_CONSTANT,  // push operand
+    OP_PUSH_REGISTER,  // push callee register number operand
+    OP_PUSH_CFA,       // push the call frame address
+    OP_ADD,
+    OP_SUBTRACT,
+    OP_MULTIPLY,
+    OP_DIVIDE,
+    OP_MODULUS,
+    OP_ALIGN,
+    OP_DEREFERENCE,
+    OP_FAIL            // the expression cannot be evaluated
+  };
+
+  struct Instruction {
+    Opcode opcode;
+    uint64_t operand;
+  };
+
+  // An expression's instructions are instructions_[begin, end).
+  struct Expression {
+    size_t begin;
+    size_t end;
+  };
+
+  // Where the value of a caller's register comes from.
+  enum SourceKind {
+    SOURCE_NONE,    // it is unknown
+    SOURCE_CFA,     // it is the call frame address
+    SOURCE_RA,      // it is the return address
+    SOURCE_RULE,    // it is the value of register_rules_[source.rule]
+    SOURCE_CALLEE   // it is unchanged from the callee, if known there
+  };
+
+  struct Source {
+    SourceKind kind;
+    size_t rule;
+  };
+
+  // Appends the instructions for |expression| to instructions_, and
+  // stores their extent in |compiled|.  If |is_cfa_rule| is true, the
+  // expression may not refer to the call frame address.  Returns false
+  // if the expression cannot be compiled.
+  bool CompileExpression(const string &expression, bool is_cfa_rule,
+                         Expression *compiled);
+
+  // Returns the number of the register named |name|, or -1 if there is
+  // none.
+  int FindRegister(const string &name) const;
+
+  // Sets |source| to the source of the register that appears as |name|
+  // among the caller's registers FindCallerRegs yields.  Returns false
+  // if there is none.
+  bool FindSource(const char *name, Source *source) const;
+
+  // Leaves the value of |expression| in *value, returning false if it
+  // cannot be evaluated.
+  template<typename ValueType>
+  bool EvaluateExpression(const Expression &expression,
+                          const ValueType *callee_registers,
+                          uint64_t callee_valid,
+                          ValueType cfa,
+                          const MemoryRegion &memory,
+                          ValueType *value) const;
+
+  const void *key_;
+  bool compiled_;
+  size_t value_size_;
+
+  // The register table's names and alternate names.
+  std::vector<string> register_names_;
+
+  std::vector<Instruction> instructions_;
+  Expression cfa_rule_;
+  Expression ra_rule_;
+
+  // The rules for registers, in the order FindCallerRegs evaluates them.
+  std::vector<string> register_rule_names_;
+  std::vector<Expression> register_rules_;
+
+  // The source of each register in the table, by number.
+  std::vector<Source> sources_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_CFI_RULE_PROGRAM_H_
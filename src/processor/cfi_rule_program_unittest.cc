@@ -0,0 +1,288 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// cfi_rule_program_unittest.cc: Unit tests for CFIRuleProgram, and for
+// the programs CFIFrameInfo holds for stack walkers.
+
+#include <map>
+#include <string>
+
+#include "breakpad_googletest_includes.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/memory_region.h"
+#include "processor/cfi_frame_info.h"
+#include "processor/cfi_rule_program.h"
+
+namespace {
+
+using google_breakpad::CFIFrameInfo;
+using google_breakpad::CFIFrameInfoParseHandler;
+using google_breakpad::CFIRuleParser;
+using google_breakpad::CFIRuleProgram;
+using google_breakpad::MemoryRegion;
+using std::map;
+
+// A MemoryRegion holding a few words at arbitrary addresses.
+class FakeMemoryRegion : public MemoryRegion {
+ public:
+  void Set(uint64_t address, uint64_t value) { words_[address] = value; }
+
+  uint64_t GetBase() const { return 0; }
+  uint32_t GetSize() const { return 0; }
+  bool GetMemoryAtAddress(uint64_t address, uint8_t *value) const {
+    return Get(address, value);
+  }
+  bool GetMemoryAtAddress(uint64_t address, uint16_t *value) const {
+    return Get(address, value);
+  }
+  bool GetMemoryAtAddress(uint64_t address, uint32_t *value) const {
+    return Get(address, value);
+  }
+  bool GetMemoryAtAddress(uint64_t address, uint64_t *value) const {
+    return Get(address, value);
+  }
+  void Print() const { }
+
+ private:
+  template<typename T>
+  bool Get(uint64_t address, T *value) const {
+    map<uint64_t, uint64_t>::const_iterator it = words_.find(address);
+    if (it == words_.end())
+      return false;
+    *value = static_cast<T>(it->second);
+    return true;
+  }
+
+  map<uint64_t, uint64_t> words_;
+};
+
+const CFIRuleProgram::Register kRegisters[] = {
+  { "r0", NULL,   true  },
+  { "r1", NULL,   true  },
+  { "r2", NULL,   false },
+  { "r3", NULL,   false },
+  { "r4", NULL,   true  },
+  { "sp", ".cfa", true  },
+  { "pc", ".ra",  true  },
+};
+const size_t kRegisterCount = sizeof(kRegisters) / sizeof(kRegisters[0]);
+
+class CFIRuleProgramTest : public testing::Test {
+ public:
+  CFIRuleProgramTest() {
+    memory.Set(0x1000, 0xfeedf00dcafebeefULL);
+    memory.Set(0x1008, 0x1010);
+    memory.Set(0x1010, 0x400123);
+    memory.Set(0xfffffff8, 0x77);
+  }
+
+  void Parse(const string &rules, CFIFrameInfo *frame_info) {
+    CFIFrameInfoParseHandler handler(frame_info);
+    CFIRuleParser parser(&handler);
+    ASSERT_TRUE(parser.Parse(rules)) << rules;
+  }
+
+  // Compares the program compiled from |frame_info| with what
+  // SimpleCFIWalker finds interpreting the rules, for every combination
+  // of valid callee registers.
+  template<typename V>
+  void ExpectSameAsInterpreter(const CFIFrameInfo &frame_info) {
+    CFIRuleProgram program(frame_info, kRegisters, kRegisterCount,
+                           sizeof(V), NULL);
+    ASSERT_TRUE(program.compiled()) << frame_info.Serialize();
+
+    const V values[kRegisterCount] = {
+      0x10, 3, static_cast<V>(0x1000), 0x1008, static_cast<V>(-8),
+      0x1018, 0x401000
+    };
+    for (uint64_t valid = 0; valid < (1U << kRegisterCount); ++valid) {
+      CFIFrameInfo::RegisterValueMap<V> callee_map, caller_map;
+      for (size_t i = 0; i < kRegisterCount; ++i) {
+        if (valid & (1U << i))
+          callee_map[kRegisters[i].name] = values[i];
+      }
+      bool expected = frame_info.FindCallerRegs(callee_map, memory,
+                                                &caller_map);
+
+      V caller[kRegisterCount];
+      uint64_t caller_valid = 0;
+      ASSERT_EQ(expected, program.Evaluate(values, valid, memory, caller,
+                                           &caller_valid))
+          << frame_info.Serialize() << " valid " << valid;
+      if (!expected)
+        continue;
+
+      for (size_t i = 0; i < kRegisterCount; ++i) {
+        const CFIRuleProgram::Register &r = kRegisters[i];
+        typename CFIFrameInfo::RegisterValueMap<V>::const_iterator entry =
+            caller_map.find(r.name);
+        if (entry == caller_map.end() && r.alternate_name)
+          entry = caller_map.find(r.alternate_name);
+        bool known = entry != caller_map.end() ||
+                     (r.callee_saves && (valid & (1U << i)));
+        ASSERT_EQ(known, (caller_valid & (1U << i)) != 0)
+            << frame_info.Serialize() << " " << r.name;
+        if (!known)
+          continue;
+        V value = entry != caller_map.end() ? entry->second : values[i];
+        EXPECT_EQ(value, caller[i]) << frame_info.Serialize() << " " << r.name;
+      }
+    }
+  }
+
+  CFIFrameInfo frame_info;
+  FakeMemoryRegion memory;
+};
+
+TEST_F(CFIRuleProgramTest, SameAsInterpreter) {
+  const char *rule_sets[] = {
+    ".cfa: sp 8 + .ra: .cfa 8 - ^",
+    ".cfa: sp 8 + .ra: .cfa 8 - ^ r0: .cfa 24 - ^ r1: r2",
+    ".cfa: r0 r1 * 3 / .ra: r2 7 % r1: r3 16 @ r4: .cfa sp -",
+    ".cfa: r3 ^ .ra: .cfa ^ r2: r3 ^ ^",
+    ".cfa: sp .ra: pc r3: r4 -4 + r2: 4294967295 -4294967295 +",
+    ".cfa: sp 4294967296 + .ra: pc",
+    ".cfa: sp 18446744073709551615 + .ra: pc",
+    ".cfa: sp 18446744073709551616 + .ra: pc",
+    ".cfa: .cfa .ra: pc",
+    ".cfa: sp .ra: .ra",
+    ".cfa: sp .ra: pc r0: $T0",
+    ".cfa: sp .ra: pc r9: r4 ^",
+    ".cfa: sp .ra: pc r0: +",
+    ".cfa: sp .ra: pc r0: 1 2",
+    ".cfa: sp .ra: pc r0: r0 ^ ^ r1: 1 2 3 4 5 6 7 8 + + + + + + +",
+    ".cfa: sp .ra: pc sp: r1 pc: r0",
+    ".cfa: 12 3 - 2 * .ra: 10 0 @",
+  };
+  for (size_t i = 0; i < sizeof(rule_sets) / sizeof(rule_sets[0]); ++i) {
+    CFIFrameInfo info;
+    Parse(rule_sets[i], &info);
+    ExpectSameAsInterpreter<uint32_t>(info);
+    ExpectSameAsInterpreter<uint64_t>(info);
+  }
+}
+
+TEST_F(CFIRuleProgramTest, MissingRules) {
+  frame_info.SetCFARule("sp");
+  CFIRuleProgram no_ra(frame_info, kRegisters, kRegisterCount, 8, NULL);
+  ASSERT_TRUE(no_ra.compiled());
+  uint64_t values[kRegisterCount] = { 0 }, caller[kRegisterCount];
+  uint64_t caller_valid;
+  EXPECT_FALSE(no_ra.Evaluate(values, 0x7f, memory, caller, &caller_valid));
+}
+
+TEST_F(CFIRuleProgramTest, DivideByZero) {
+  frame_info.SetCFARule("sp r2 /");
+  frame_info.SetRARule(".cfa r2 %");
+  CFIRuleProgram program(frame_info, kRegisters, kRegisterCount, 8, NULL);
+  ASSERT_TRUE(program.compiled());
+  uint64_t values[kRegisterCount] = { 0, 0, 0, 0, 0, 0x20, 0 };
+  uint64_t caller[kRegisterCount];
+  uint64_t caller_valid;
+  EXPECT_FALSE(program.Evaluate(values, 0x7f, memory, caller, &caller_valid));
+  values[2] = 3;
+  EXPECT_TRUE(program.Evaluate(values, 0x7f, memory, caller, &caller_valid));
+  EXPECT_EQ(10U, caller[5]);
+  EXPECT_EQ(1U, caller[6]);
+}
+
+TEST_F(CFIRuleProgramTest, NotCompiled) {
+  const char *rules[] = {
+    "$T0 sp = $T0",
+    "$T0 sp =$T0",
+    "sp +8 +",
+    "sp --8 +",
+    "sp -x +",
+    "1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17",
+  };
+  for (size_t i = 0; i < sizeof(rules) / sizeof(rules[0]); ++i) {
+    CFIFrameInfo info;
+    info.SetCFARule("sp");
+    info.SetRARule(rules[i]);
+    CFIRuleProgram program(info, kRegisters, kRegisterCount, 8, NULL);
+    EXPECT_FALSE(program.compiled()) << rules[i];
+  }
+
+  frame_info.SetCFARule("sp");
+  frame_info.SetRARule("pc");
+  const CFIRuleProgram::Register duplicated[] = {
+    { "sp", NULL, false },
+    { "pc", NULL, false },
+    { "sp", NULL, false },
+  };
+  CFIRuleProgram program(frame_info, duplicated, 3, 8, NULL);
+  EXPECT_FALSE(program.compiled());
+}
+
+TEST_F(CFIRuleProgramTest, SetProgram) {
+  int key1, key2;
+  frame_info.SetCFARule("sp");
+  frame_info.SetRARule("pc");
+  EXPECT_TRUE(frame_info.program(&key1) == NULL);
+
+  CFIRuleProgram *program = new CFIRuleProgram(frame_info, kRegisters,
+                                               kRegisterCount, 8, &key1);
+  EXPECT_EQ(program, frame_info.SetProgram(program));
+  EXPECT_EQ(program, frame_info.program(&key1));
+  EXPECT_TRUE(frame_info.program(&key2) == NULL);
+
+  // A second program for the same key yields the first.
+  EXPECT_EQ(program, frame_info.SetProgram(
+      new CFIRuleProgram(frame_info, kRegisters, kRegisterCount, 8, &key1)));
+
+  // One for another key isn't kept.
+  EXPECT_TRUE(frame_info.SetProgram(
+      new CFIRuleProgram(frame_info, kRegisters, kRegisterCount, 8, &key2))
+      == NULL);
+  EXPECT_EQ(program, frame_info.program(&key1));
+
+  // Changing the rules discards the program.
+  frame_info.SetRegisterRule("r0", "sp ^");
+  EXPECT_TRUE(frame_info.program(&key1) == NULL);
+}
+
+TEST_F(CFIRuleProgramTest, CopiesShareProgram) {
+  int key;
+  frame_info.SetCFARule("sp");
+  frame_info.SetRARule("pc");
+  CFIFrameInfo copy(frame_info);
+  CFIRuleProgram *program = new CFIRuleProgram(frame_info, kRegisters,
+                                               kRegisterCount, 8, &key);
+  EXPECT_EQ(program, copy.SetProgram(program));
+  EXPECT_EQ(program, frame_info.program(&key));
+
+  // Changing a copy's rules leaves the original and its program alone.
+  copy.SetRegisterRule("r0", "sp ^");
+  EXPECT_TRUE(copy.program(&key) == NULL);
+  EXPECT_EQ(program, frame_info.program(&key));
+  EXPECT_EQ(".cfa: sp .ra: pc", frame_info.Serialize());
+  EXPECT_EQ(".cfa: sp .ra: pc r0: sp ^", copy.Serialize());
+}
+
+}  // namespace
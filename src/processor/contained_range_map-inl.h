@@ -82,9 +82,12 @@ bool ContainedRangeMap<AddressType, EntryType>::StoreRange(
 
     // If the new range's geometry is exactly equal to an existing child
     // range's, it violates the containment rules, and an attempt to store
-    // it must fail.  iterator_base->first contains the key, which was the
+    // it must fail, unless this map allows equal ranges, in which case the
+    // new range is stored within the existing one like any other range it
+    // contains.  iterator_base->first contains the key, which was the
     // containing child's high address.
-    if (iterator_base->second->base_ == base && iterator_base->first == high) {
+    if (!allow_equal_range_ &&
+        iterator_base->second->base_ == base && iterator_base->first == high) {
       // TODO(nealsid): See the TODO above on why this is commented out.
 //       BPLOG(INFO) << "StoreRange failed, identical range is already "
 //                      "present: " << HexString(base) << "+" << HexString(size);
@@ -142,7 +145,8 @@ bool ContainedRangeMap<AddressType, EntryType>::StoreRange(
   // are now this range's grandchildren.  Ownership of these is transferred
   // to the new child range.
   map_->insert(MapValue(high,
-                        new ContainedRangeMap(base, entry, child_map)));
+                        new ContainedRangeMap(base, entry, child_map,
+                                              allow_equal_range_)));
   return true;
 }
 
@@ -154,6 +158,18 @@ bool ContainedRangeMap<AddressType, EntryType>::RetrieveRange(
                              "|entry|";
   assert(entry);
 
+  const EntryType *found;
+  if (!RetrieveRangePtr(address, found))
+    return false;
+
+  *entry = *found;
+  return true;
+}
+
+
+template<typename AddressType, typename EntryType>
+bool ContainedRangeMap<AddressType, EntryType>::RetrieveRangePtr(
+    const AddressType &address, const EntryType *&entry) const {
   // If nothing was ever stored, then there's nothing to retrieve.
   if (!map_)
     return false;
@@ -171,9 +187,33 @@ bool ContainedRangeMap<AddressType, EntryType>::RetrieveRange(
   // The child in iterator->second contains the specified address.  Find out
   // if it has a more-specific descendant that also contains it.  If it does,
   // it will set |entry| appropriately.  If not, set |entry| to the child.
-  if (!iterator->second->RetrieveRange(address, entry))
-    *entry = iterator->second->entry_;
+  if (!iterator->second->RetrieveRangePtr(address, entry))
+    entry = &iterator->second->entry_;
+
+  return true;
+}
+
+
+template<typename AddressType, typename EntryType>
+bool ContainedRangeMap<AddressType, EntryType>::RetrieveRanges(
+    const AddressType &address,
+    std::vector<const EntryType*> *entries) const {
+  BPLOG_IF(ERROR, !entries) << "ContainedRangeMap::RetrieveRanges requires "
+                               "|entries|";
+  assert(entries);
+
+  if (!map_)
+    return false;
+
+  // As in RetrieveRange, find the child range containing address, if any.
+  MapConstIterator iterator = map_->lower_bound(address);
+  if (iterator == map_->end() || address < iterator->second->base_)
+    return false;
 
+  // Let the child add its more-specific descendants first, then add the
+  // child itself.
+  iterator->second->RetrieveRanges(address, entries);
+  entries->push_back(&iterator->second->entry_);
   return true;
 }
 
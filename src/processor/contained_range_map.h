@@ -41,11 +41,14 @@
 // objects located entirely within the parent's address space.  Attempts
 // to introduce objects (via StoreRange) that violate these rules will fail.
 // Retrieval (via RetrieveRange) always returns the most specific (smallest)
-// object that contains the address being queried.  Note that while it is
-// not possible to insert two objects into a map that have exactly the same
+// object that contains the address being queried; RetrieveRanges returns
+// all the objects containing it.  Note that while it is not ordinarily
+// possible to insert two objects into a map that have exactly the same
 // geometry (base address and size), it is possible to completely mask a
 // larger object by inserting smaller objects that entirely fill the larger
-// object's address space.
+// object's address space.  A map created with allow_equal_range set
+// accepts objects with the same geometry as an existing one, and treats
+// each as contained by the one inserted before it.
 //
 // Internally, contained range maps are implemented as a tree.  Each tree
 // node except for the root node describes an object in the map.  Each node
@@ -62,6 +65,7 @@
 
 
 #include <map>
+#include <vector>
 
 
 namespace google_breakpad {
@@ -75,7 +79,10 @@ class ContainedRangeMap {
   // The default constructor creates a ContainedRangeMap with no geometry
   // and no entry, and as such is only suitable for the root node of a
   // ContainedRangeMap tree.
-  ContainedRangeMap() : base_(), entry_(), map_(NULL) {}
+  // If allow_equal_range is true, StoreRange accepts a range with exactly
+  // the same geometry as an existing one, nesting it within that range.
+  explicit ContainedRangeMap(bool allow_equal_range = false)
+      : base_(), entry_(), map_(NULL), allow_equal_range_(allow_equal_range) {}
 
   ~ContainedRangeMap();
 
@@ -97,6 +104,20 @@ class ContainedRangeMap {
   // encompasses the address, returns false.
   bool RetrieveRange(const AddressType &address, EntryType *entry) const;
 
+  // As above, but points |entry| at the map's own copy of the entry, which
+  // remains valid until the map is next modified.
+  bool RetrieveRangePtr(const AddressType &address,
+                        const EntryType *&entry) const;
+
+  // Retrieves all the descendant ranges encompassing the specified
+  // address, appending pointers to their entries to |entries|, from the
+  // most specific (smallest) to the least.  The pointers remain valid until
+  // the map is next modified.  As with RetrieveRange, the entry contained
+  // by |this| is not included.  Returns false if no descendant range
+  // encompasses the address.
+  bool RetrieveRanges(const AddressType &address,
+                      std::vector<const EntryType*> *entries) const;
+
   // Removes all children.  Note that Clear only removes descendants,
   // leaving the node on which it is called intact.  Because the only
   // meaningful things contained by a root node are descendants, this
@@ -119,8 +140,9 @@ class ContainedRangeMap {
   // and initial child map, which may be NULL.  This is only used internally
   // by ContainedRangeMap when it creates a new child.
   ContainedRangeMap(const AddressType &base, const EntryType &entry,
-                    AddressToRangeMap *map)
-      : base_(base), entry_(entry), map_(map) {}
+                    AddressToRangeMap *map, bool allow_equal_range)
+      : base_(base), entry_(entry), map_(map),
+        allow_equal_range_(allow_equal_range) {}
 
   // The base address of this range.  The high address does not need to
   // be stored, because it is used as the key to an object in its parent's
@@ -141,6 +163,10 @@ class ContainedRangeMap {
   // address.  This is a pointer to avoid allocating map structures for
   // leaf nodes, where they are not needed.
   AddressToRangeMap *map_;
+
+  // Whether ranges with the same geometry as an existing range may be
+  // stored.  Children inherit this from their parent.
+  bool allow_equal_range_;
 };
 
 
@@ -249,6 +249,49 @@ static bool RunTests() {
   printf("  };\n");
 #endif  // GENERATE_TEST_DATA
 
+  // RetrieveRanges returns every range containing an address, most
+  // specific first.
+  std::vector<const int*> entries;
+  ASSERT_TRUE(crm.RetrieveRanges(87, &entries));
+  ASSERT_TRUE(entries.size() == 4);
+  ASSERT_TRUE(*entries[0] == 44);
+  ASSERT_TRUE(*entries[1] == 47);
+  ASSERT_TRUE(*entries[2] == 46);
+  ASSERT_TRUE(*entries[3] == 40);
+  entries.clear();
+  ASSERT_FALSE(crm.RetrieveRanges(91, &entries));
+  ASSERT_TRUE(entries.empty());
+
+  return true;
+}
+
+static bool RunEqualRangeTests() {
+  ContainedRangeMap<unsigned int, int> crm(true);
+
+  // With allow_equal_range, a range equal to an existing one is stored
+  // within it, however deeply ranges of that geometry are already nested.
+  ASSERT_TRUE (crm.StoreRange(10, 10,  1));
+  ASSERT_TRUE (crm.StoreRange(10, 10,  2));
+  ASSERT_TRUE (crm.StoreRange(12,  4,  3));
+  ASSERT_TRUE (crm.StoreRange(10, 10,  4));
+  ASSERT_TRUE (crm.StoreRange(12,  4,  5));
+  ASSERT_FALSE(crm.StoreRange(11, 10,  6));  // partial overlap still fails
+
+  int value;
+  ASSERT_TRUE(crm.RetrieveRange(10, &value));
+  ASSERT_TRUE(value == 4);
+  ASSERT_TRUE(crm.RetrieveRange(13, &value));
+  ASSERT_TRUE(value == 5);
+
+  std::vector<const int*> entries;
+  ASSERT_TRUE(crm.RetrieveRanges(13, &entries));
+  ASSERT_TRUE(entries.size() == 5);
+  ASSERT_TRUE(*entries[0] == 5);
+  ASSERT_TRUE(*entries[1] == 3);
+  ASSERT_TRUE(*entries[2] == 4);
+  ASSERT_TRUE(*entries[3] == 2);
+  ASSERT_TRUE(*entries[4] == 1);
+
   return true;
 }
 
@@ -259,5 +302,5 @@ static bool RunTests() {
 int main(int argc, char **argv) {
   BPLOG_INIT(&argc, &argv);
 
-  return RunTests() ? 0 : 1;
+  return RunTests() && RunEqualRangeTests() ? 0 : 1;
 }
@@ -40,12 +40,19 @@
 #include "google_breakpad/processor/fast_source_line_resolver.h"
 #include "processor/fast_source_line_resolver_types.h"
 
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <map>
 #include <string>
 #include <utility>
 
 #include "common/scoped_ptr.h"
 #include "common/using_std_string.h"
+#include "processor/logging.h"
 #include "processor/module_factory.h"
 #include "processor/simple_serializer-inl.h"
 
@@ -55,55 +62,225 @@ using std::make_pair;
 namespace google_breakpad {
 
 FastSourceLineResolver::FastSourceLineResolver()
-  : SourceLineResolverBase(new FastModuleFactory) { }
+  : SourceLineResolverBase(new FastModuleFactory),
+    verify_checksums_(false) { }
+
+FastSourceLineResolver::~FastSourceLineResolver() {
+  // Loaded modules point into the mapped files, but never dereference that
+  // memory when they are destroyed, so the files may be unmapped first.
+  MappedFileMap::iterator iter = mapped_files_.begin();
+  for (; iter != mapped_files_.end(); ++iter)
+    munmap(iter->second.address, iter->second.size);
+}
 
 bool FastSourceLineResolver::ShouldDeleteMemoryBufferAfterLoadModule() {
   return false;
 }
 
-void FastSourceLineResolver::Module::LookupAddress(StackFrame *frame) const {
+bool FastSourceLineResolver::LoadModule(const CodeModule *module,
+                                        const string &map_file) {
+  if (module == NULL)
+    return false;
+
+  int fd = open(map_file.c_str(), O_RDONLY);
+  if (fd == -1)
+    return SourceLineResolverBase::LoadModule(module, map_file);
+
+  struct stat buf;
+  FastSymbolFileHeader header;
+  bool is_fast_symbol_file =
+      fstat(fd, &buf) == 0 &&
+      static_cast<size_t>(buf.st_size) >= sizeof(header) &&
+      read(fd, &header, sizeof(header)) == sizeof(header) &&
+      FastSymbolFileHeader::HasMagic(reinterpret_cast<const char*>(&header),
+                                     sizeof(header));
+  if (!is_fast_symbol_file) {
+    close(fd);
+    return SourceLineResolverBase::LoadModule(module, map_file);
+  }
+
+  // Make sure we don't already have a module with the given name.
+  string key = ModuleKey(module);
+  if (IsModuleLoaded(key)) {
+    BPLOG(INFO) << "Symbols for module " << module->code_file()
+                << " already loaded";
+    close(fd);
+    return false;
+  }
+
+  BPLOG(INFO) << "Mapping fast symbol file " << map_file;
+
+  // Pages of the file are read in as the module touches them, and stay
+  // shared with the page cache.  See LoadModule() in the header for what
+  // this requires of the file.
+  size_t file_size = buf.st_size;
+  void *address = mmap(NULL, file_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (address == MAP_FAILED) {
+    BPLOG(ERROR) << "Could not map " << map_file;
+    return false;
+  }
+
+  // A truncated or damaged file is not loaded at all, rather than being
+  // loaded as a corrupt module.
+  const char *file_data = static_cast<const char*>(address);
+  if (!FastSymbolFileHeader::Validate(file_data, file_size,
+                                      verify_checksums_)) {
+    BPLOG(ERROR) << "Invalid fast symbol file " << map_file;
+    munmap(address, file_size);
+    return false;
+  }
+
+  // The mapping has to stay alive as long as the module.  It is recorded
+  // before the module is loaded, so that the module can't be evicted without
+  // the file being unmapped.
+  {
+    MappedFile mapped_file = { address, file_size };
+    std::lock_guard<std::mutex> lock(modules_mutex_);
+    if (!mapped_files_.insert(make_pair(key, mapped_file)).second) {
+      BPLOG(INFO) << "Symbols for module " << module->code_file()
+                  << " already loaded";
+      munmap(address, file_size);
+      return false;
+    }
+  }
+
+  // The module is loaded from the data following the header, which it only
+  // ever reads.
+  if (LoadModuleUsingMemoryBuffer(module,
+                                  const_cast<char*>(file_data) + sizeof(header),
+                                  file_size - sizeof(header))) {
+    return true;
+  }
+
+  std::lock_guard<std::mutex> lock(modules_mutex_);
+  MappedFileMap::iterator iter = mapped_files_.find(key);
+  if (iter != mapped_files_.end() && iter->second.address == address)
+    mapped_files_.erase(iter);
+  munmap(address, file_size);
+  return false;
+}
+
+bool FastSourceLineResolver::LoadModuleUsingMapBuffer(
+    const CodeModule *module, const string &map_buffer) {
+  if (!CheckBuffer(module, map_buffer.data(), map_buffer.size()))
+    return false;
+  return SourceLineResolverBase::LoadModuleUsingMapBuffer(module, map_buffer);
+}
+
+bool FastSourceLineResolver::LoadModuleUsingMemoryBuffer(
+    const CodeModule *module,
+    char *memory_buffer,
+    size_t memory_buffer_size) {
+  if (!CheckBuffer(module, memory_buffer, memory_buffer_size))
+    return false;
+  return SourceLineResolverBase::LoadModuleUsingMemoryBuffer(
+      module, memory_buffer, memory_buffer_size);
+}
+
+bool FastSourceLineResolver::CheckBuffer(const CodeModule *module,
+                                         const char *buffer,
+                                         size_t buffer_size) {
+  // The module checks the rest of the header itself when it loads.
+  if (!verify_checksums_ ||
+      !FastSymbolFileHeader::HasMagic(buffer, buffer_size) ||
+      FastSymbolFileHeader::Validate(buffer, buffer_size, true)) {
+    return true;
+  }
+  BPLOG(ERROR) << "Invalid fast symbol file for module "
+               << (module ? module->code_file() : string());
+  return false;
+}
+
+void FastSourceLineResolver::ReleaseModuleData(const string &key) {
+  SourceLineResolverBase::ReleaseModuleData(key);
+
+  MappedFileMap::iterator iter = mapped_files_.find(key);
+  if (iter != mapped_files_.end()) {
+    munmap(iter->second.address, iter->second.size);
+    mapped_files_.erase(iter);
+  }
+}
+
+void FastSourceLineResolver::Module::LookupAddress(
+    StackFrame *frame, std::vector<StackFrame*> *inlined_frames) const {
+  LookupCursor cursor;
+  LookupAddress(frame, &cursor);
+}
+
+void FastSourceLineResolver::Module::LookupAddresses(
+    const std::vector<StackFrame*> &frames,
+    std::vector<std::vector<StackFrame*> > *inlined_frames) const {
+  LookupCursor cursor;
+  for (size_t i = 0; i < frames.size(); ++i)
+    LookupAddress(frames[i], &cursor);
+}
+
+void FastSourceLineResolver::Module::LookupAddress(
+    StackFrame *frame, LookupCursor *cursor) const {
   MemAddr address = frame->instruction - frame->module->base_address();
 
-  // First, look for a FUNC record that covers address. Use
-  // RetrieveNearestRange instead of RetrieveRange so that, if there
-  // is no such function, we can use the next function to bound the
-  // extent of the PUBLIC symbol we find, below. This does mean we
-  // need to check that address indeed falls within the function we
-  // find; do the range comparison in an overflow-friendly way.
-  scoped_ptr<Function> func(new Function);
-  const Function* func_ptr = 0;
-  scoped_ptr<PublicSymbol> public_symbol(new PublicSymbol);
-  const PublicSymbol* public_symbol_ptr = 0;
-  MemAddr function_base;
-  MemAddr function_size;
-  MemAddr public_address;
+  if (!cursor->function_size || address < cursor->function_base ||
+      address - cursor->function_base >= cursor->function_size) {
+    cursor->function_size = 0;
+    cursor->line_size = 0;
+
+    // First, look for a FUNC record that covers address. Use
+    // RetrieveNearestRange instead of RetrieveRange so that, if there
+    // is no such function, we can use the next function to bound the
+    // extent of the PUBLIC symbol we find, below. This does mean we
+    // need to check that address indeed falls within the function we
+    // find; do the range comparison in an overflow-friendly way.
+    const Function* func_ptr = 0;
+    scoped_ptr<PublicSymbol> public_symbol(new PublicSymbol);
+    const PublicSymbol* public_symbol_ptr = 0;
+    MemAddr function_base;
+    MemAddr function_size;
+    MemAddr public_address;
+
+    if (functions_.RetrieveNearestRange(address, func_ptr,
+                                        &function_base, &function_size) &&
+        address >= function_base && address - function_base < function_size) {
+      cursor->function.CopyFrom(func_ptr);
+      cursor->function_base = function_base;
+      cursor->function_size = function_size;
+    } else {
+      if (public_symbols_.Retrieve(address,
+                                   public_symbol_ptr, &public_address) &&
+          (!func_ptr || public_address > function_base)) {
+        public_symbol.get()->CopyFrom(public_symbol_ptr);
+        frame->function_name = public_symbol->name;
+        frame->function_base = frame->module->base_address() + public_address;
+      }
+      return;
+    }
+  }
 
-  if (functions_.RetrieveNearestRange(address, func_ptr,
-                                      &function_base, &function_size) &&
-      address >= function_base && address - function_base < function_size) {
-    func.get()->CopyFrom(func_ptr);
-    frame->function_name = func->name;
-    frame->function_base = frame->module->base_address() + function_base;
+  frame->function_name = cursor->function.name;
+  frame->function_base =
+      frame->module->base_address() + cursor->function_base;
 
-    scoped_ptr<Line> line(new Line);
+  if (!cursor->line_size || address < cursor->line_base ||
+      address - cursor->line_base >= cursor->line_size) {
+    cursor->line_size = 0;
     const Line* line_ptr = 0;
     MemAddr line_base;
-    if (func->lines.RetrieveRange(address, line_ptr, &line_base, NULL)) {
-      line.get()->CopyFrom(line_ptr);
-      FileMap::iterator it = files_.find(line->source_file_id);
-      if (it != files_.end()) {
-        frame->source_file_name =
-            files_.find(line->source_file_id).GetValuePtr();
-      }
-      frame->source_line = line->line;
-      frame->source_line_base = frame->module->base_address() + line_base;
+    MemAddr line_size;
+    if (cursor->function.lines.RetrieveRange(address, line_ptr, &line_base,
+                                             &line_size)) {
+      cursor->line.CopyFrom(line_ptr);
+      cursor->line_base = line_base;
+      cursor->line_size = line_size;
     }
-  } else if (public_symbols_.Retrieve(address,
-                                      public_symbol_ptr, &public_address) &&
-             (!func_ptr || public_address > function_base)) {
-    public_symbol.get()->CopyFrom(public_symbol_ptr);
-    frame->function_name = public_symbol->name;
-    frame->function_base = frame->module->base_address() + public_address;
+  }
+  if (cursor->line_size) {
+    FileMap::iterator it = files_.find(cursor->line.source_file_id);
+    if (it != files_.end()) {
+      frame->source_file_name = it.GetValuePtr();
+    }
+    frame->source_line = cursor->line.line;
+    frame->source_line_base = frame->module->base_address() +
+                              cursor->line_base;
   }
 }
 
@@ -147,15 +324,45 @@ WindowsFrameInfo FastSourceLineResolver::CopyWFI(const char *raw) {
 bool FastSourceLineResolver::Module::LoadMapFromMemory(
     char *memory_buffer,
     size_t memory_buffer_size) {
-  if (!memory_buffer) return false;
+  if (!memory_buffer) {
+    is_corrupt_ = true;
+    return false;
+  }
 
-  // Read the "is_corrupt" flag.
+  // The buffer may hold a whole fast symbol file, as a SymbolSupplier reading
+  // one from disk would return; skip its header once it checks out.
   const char *mem_buffer = memory_buffer;
+  if (FastSymbolFileHeader::HasMagic(mem_buffer, memory_buffer_size)) {
+    if (!FastSymbolFileHeader::Validate(mem_buffer, memory_buffer_size,
+                                        false)) {
+      BPLOG(ERROR) << "Invalid fast symbol file header";
+      is_corrupt_ = true;
+      return false;
+    }
+    mem_buffer += sizeof(FastSymbolFileHeader);
+    memory_buffer_size -= sizeof(FastSymbolFileHeader);
+  }
+
+  unsigned int header_size = kNumberMaps_ * sizeof(unsigned int);
+  if (memory_buffer_size < sizeof(bool) + header_size) {
+    is_corrupt_ = true;
+    return false;
+  }
+
+  // Read the "is_corrupt" flag.
   mem_buffer = SimpleSerializer<bool>::Read(mem_buffer, &is_corrupt_);
 
   const uint32_t *map_sizes = reinterpret_cast<const uint32_t*>(mem_buffer);
 
-  unsigned int header_size = kNumberMaps_ * sizeof(unsigned int);
+  // Refuse maps that would extend past the end of the buffer.
+  uint64_t data_size = sizeof(bool) + header_size;
+  for (int i = 0; i < kNumberMaps_; ++i)
+    data_size += map_sizes[i];
+  if (data_size > memory_buffer_size) {
+    BPLOG(ERROR) << "Serialized module data is truncated";
+    is_corrupt_ = true;
+    return false;
+  }
 
   // offsets[]: an array of offset addresses (with respect to mem_buffer),
   // for each "Static***Map" component of Module.
@@ -272,4 +479,69 @@ CFIFrameInfo *FastSourceLineResolver::Module::FindCFIFrameInfo(
   return rules.release();
 }
 
+FastSymbolFileHeader FastSymbolFileHeader::ForData(const char *data,
+                                                   uint32_t data_size) {
+  FastSymbolFileHeader header;
+  header.magic = kMagic;
+  header.version = kVersion;
+  header.data_size = data_size;
+  header.checksum = Checksum(data, data_size);
+  return header;
+}
+
+bool FastSymbolFileHeader::HasMagic(const char *buffer, size_t buffer_size) {
+  uint32_t magic;
+  if (!buffer || buffer_size < sizeof(FastSymbolFileHeader))
+    return false;
+  memcpy(&magic, buffer, sizeof(magic));
+  return magic == kMagic;
+}
+
+bool FastSymbolFileHeader::Validate(const char *buffer, size_t buffer_size,
+                                    bool check_data) {
+  if (!HasMagic(buffer, buffer_size))
+    return false;
+
+  FastSymbolFileHeader header;
+  memcpy(&header, buffer, sizeof(header));
+  if (header.version != kVersion) {
+    BPLOG(ERROR) << "Fast symbol file version " << header.version
+                 << " is not supported, expected " << kVersion;
+    return false;
+  }
+  // Checked before the checksum, so that a truncated file costs nothing.
+  if (buffer_size - sizeof(header) < header.data_size) {
+    BPLOG(ERROR) << "Fast symbol file is truncated: " << header.data_size
+                 << " bytes of data expected, "
+                 << buffer_size - sizeof(header) << " present";
+    return false;
+  }
+  if (check_data &&
+      Checksum(buffer + sizeof(header), header.data_size) != header.checksum) {
+    BPLOG(ERROR) << "Fast symbol file checksum mismatch";
+    return false;
+  }
+  return true;
+}
+
+uint32_t FastSymbolFileHeader::Checksum(const char *data, size_t size) {
+  uint32_t sum1 = 0;
+  uint32_t sum2 = 0;
+  size_t i = 0;
+  for (; i + sizeof(uint32_t) <= size; i += sizeof(uint32_t)) {
+    uint32_t word;
+    memcpy(&word, data + i, sizeof(word));
+    sum1 += word;
+    sum2 += sum1;
+  }
+  // Fold in the trailing bytes, if any, as a zero-padded word.
+  if (i < size) {
+    uint32_t word = 0;
+    memcpy(&word, data + i, size - i);
+    sum1 += word;
+    sum2 += sum1;
+  }
+  return sum1 ^ ((sum2 << 16) | (sum2 >> 16));
+}
+
 }  // namespace google_breakpad
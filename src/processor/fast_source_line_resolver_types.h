@@ -116,8 +116,17 @@ class FastSourceLineResolver::Module: public SourceLineResolverBase::Module {
   virtual ~Module() { }
 
   // Looks up the given relative address, and fills the StackFrame struct
-  // with the result.
-  virtual void LookupAddress(StackFrame *frame) const;
+  // with the result.  The serialized format does not keep INLINE records,
+  // so no frames are ever appended to |inlined_frames|.
+  virtual void LookupAddress(StackFrame *frame,
+                             std::vector<StackFrame*> *inlined_frames) const;
+
+  // Looks up the sorted |frames| in one pass, searching the functions and
+  // lines again only when an address leaves the ones the last address was
+  // found in.
+  virtual void LookupAddresses(
+      const std::vector<StackFrame*> &frames,
+      std::vector<std::vector<StackFrame*> > *inlined_frames) const;
 
   // Loads a map from the given buffer in char* type.
   virtual bool LoadMapFromMemory(char *memory_buffer,
@@ -148,6 +157,24 @@ class FastSourceLineResolver::Module: public SourceLineResolverBase::Module {
   friend class ModuleComparer;
   typedef StaticMap<int, char> FileMap;
 
+  // The function and line the last address looked up was found in, so that
+  // a lookup of an address within them needn't search for them again.  A
+  // size of 0 means there is no such function or line.
+  struct LookupCursor {
+    LookupCursor() : function_base(0), function_size(0),
+                     line_base(0), line_size(0) { }
+    Function function;
+    MemAddr function_base;
+    MemAddr function_size;
+    Line line;
+    MemAddr line_base;
+    MemAddr line_size;
+  };
+
+  // Looks up |frame| as LookupAddress does, starting from and updating
+  // |cursor|.
+  void LookupAddress(StackFrame *frame, LookupCursor *cursor) const;
+
   string name_;
   StaticMap<int, char> files_;
   StaticRangeMap<MemAddr, Function> functions_;
@@ -180,6 +207,49 @@ class FastSourceLineResolver::Module: public SourceLineResolverBase::Module {
   StaticMap<MemAddr, char> cfi_delta_rules_;
 };
 
+// A fast symbol file is the on-disk form of a serialized Module: this header
+// followed by data_size bytes of the data ModuleSerializer::Serialize()
+// produces.  FastSourceLineResolver::LoadModule() maps such a file into
+// memory and uses it in place, without parsing or copying.  The header lets
+// a truncated, stale or damaged file be rejected before it is used.
+struct FastSymbolFileHeader {
+  // "BPFS" in little-endian byte order.  A serialized Module without a
+  // header begins with its is_corrupt flag, 0 or 1, so the two are never
+  // mistaken for each other.
+  static const uint32_t kMagic = 0x53465042;
+
+  // Must be bumped whenever the serialized Module layout changes.
+  static const uint32_t kVersion = 1;
+
+  uint32_t magic;
+  uint32_t version;
+  // Size of the serialized Module data following the header.  Being 32
+  // bits, it limits fast symbol files to 4 GB, as do the 32-bit offsets
+  // within the serialized Module.
+  uint32_t data_size;
+  // Checksum() of the serialized Module data.
+  uint32_t checksum;
+
+  // Returns a header describing the data_size bytes at data.
+  static FastSymbolFileHeader ForData(const char *data, uint32_t data_size);
+
+  // Returns true if buffer begins with a fast symbol file header, valid or
+  // not.
+  static bool HasMagic(const char *buffer, size_t buffer_size);
+
+  // Returns true if buffer holds a complete fast symbol file of the current
+  // version, whose data, if check_data is true, matches its checksum.
+  // buffer_size may exceed the size recorded in the header, but not fall
+  // short of it.  Checking the data reads all of it, so it is left to
+  // whoever writes the file unless the file may have been damaged since.
+  static bool Validate(const char *buffer, size_t buffer_size,
+                       bool check_data);
+
+  // A Fletcher-style checksum of size bytes at data, computed a word at a
+  // time.
+  static uint32_t Checksum(const char *data, size_t size);
+};
+
 }  // namespace google_breakpad
 
 #endif  // PROCESSOR_FAST_SOURCE_LINE_RESOLVER_TYPES_H__
@@ -38,12 +38,17 @@
 // Author: Siyang Xie (lambxsy@google.com)
 
 #include <assert.h>
+#include <stddef.h>
 #include <stdio.h>
+#include <string.h>
 
+#include <algorithm>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "breakpad_googletest_includes.h"
+#include "common/tests/auto_tempdir.h"
 #include "common/using_std_string.h"
 #include "google_breakpad/processor/code_module.h"
 #include "google_breakpad/processor/stack_frame.h"
@@ -54,6 +59,8 @@
 
 namespace {
 
+using google_breakpad::AutoTempDir;
+using google_breakpad::FastSymbolFileHeader;
 using google_breakpad::SourceLineResolverBase;
 using google_breakpad::BasicSourceLineResolver;
 using google_breakpad::FastSourceLineResolver;
@@ -166,6 +173,28 @@ static bool VerifyEmpty(const StackFrame &frame) {
   return false;
 }
 
+static bool ReadFile(const string &path, string *contents) {
+  FILE *f = fopen(path.c_str(), "rb");
+  if (!f)
+    return false;
+  char buffer[4096];
+  size_t size;
+  contents->clear();
+  while ((size = fread(buffer, 1, sizeof(buffer), f)) > 0)
+    contents->append(buffer, size);
+  fclose(f);
+  return true;
+}
+
+static bool WriteFile(const string &path, const string &contents) {
+  FILE *f = fopen(path.c_str(), "wb");
+  if (!f)
+    return false;
+  bool result = fwrite(contents.data(), 1, contents.size(), f) ==
+                contents.size();
+  return fclose(f) == 0 && result;
+}
+
 static void ClearSourceLineInfo(StackFrame *frame) {
   frame->function_name.clear();
   frame->module = NULL;
@@ -408,6 +437,51 @@ TEST_F(TestFastSourceLineResolver, TestLoadAndResolve) {
   ASSERT_EQ(frame.function_name, "Public2_2");
 }
 
+TEST_F(TestFastSourceLineResolver, TestBatchLookup) {
+  TestCodeModule module1("module1");
+  ASSERT_TRUE(basic_resolver.LoadModule(&module1, symbol_file(1)));
+  ASSERT_TRUE(serializer.ConvertOneModule(
+      module1.code_file(), &basic_resolver, &fast_resolver));
+
+  // Unsorted, with repeats, gaps between lines and functions, a public
+  // symbol and nothing at all.
+  const uint64_t kAddresses[] = {
+    0x1104, 0x1000, 0x1004, 0x1004, 0x100c, 0x1100, 0x1250, 0x1fff, 0x2000,
+    0x2800, 0x2900, 0x3000, 0x5000, 0x9fff, 0xa000, 0x0
+  };
+  const size_t kAddressCount = sizeof(kAddresses) / sizeof(kAddresses[0]);
+  for (int sorted = 0; sorted < 2; ++sorted) {
+    std::vector<uint64_t> addresses(kAddresses, kAddresses + kAddressCount);
+    if (sorted)
+      std::sort(addresses.begin(), addresses.end());
+
+    std::vector<StackFrame> frames(addresses.size());
+    std::vector<StackFrame*> frame_pointers;
+    for (size_t i = 0; i < addresses.size(); ++i) {
+      frames[i].instruction = addresses[i];
+      frames[i].module = &module1;
+      frame_pointers.push_back(&frames[i]);
+    }
+    std::vector<std::vector<StackFrame*> > inlined_frames;
+    fast_resolver.FillSourceLineInfo(&module1, frame_pointers,
+                                     &inlined_frames);
+    ASSERT_EQ(addresses.size(), inlined_frames.size());
+
+    for (size_t i = 0; i < addresses.size(); ++i) {
+      StackFrame expected;
+      expected.instruction = addresses[i];
+      expected.module = &module1;
+      basic_resolver.FillSourceLineInfo(&expected);
+      EXPECT_EQ(expected.function_name, frames[i].function_name);
+      EXPECT_EQ(expected.function_base, frames[i].function_base);
+      EXPECT_EQ(expected.source_file_name, frames[i].source_file_name);
+      EXPECT_EQ(expected.source_line, frames[i].source_line);
+      EXPECT_EQ(expected.source_line_base, frames[i].source_line_base);
+      EXPECT_TRUE(inlined_frames[i].empty());
+    }
+  }
+}
+
 TEST_F(TestFastSourceLineResolver, TestInvalidLoads) {
   TestCodeModule module3("module3");
   ASSERT_TRUE(basic_resolver.LoadModule(&module3,
@@ -466,6 +540,99 @@ TEST_F(TestFastSourceLineResolver, TestUnload) {
   ASSERT_TRUE(fast_resolver.HasModule(&module1));
 }
 
+TEST_F(TestFastSourceLineResolver, LoadFastSymbolFile) {
+  AutoTempDir temp_dir;
+  string fast_symbol_file = temp_dir.path() + "/module1.fast";
+  ASSERT_TRUE(serializer.ConvertSymbolFileToFastSymbolFile(symbol_file(1),
+                                                          fast_symbol_file));
+  struct stat st;
+  ASSERT_NE(0, stat((fast_symbol_file + ".tmp").c_str(), &st));
+
+  TestCodeModule module1("module1");
+  ASSERT_TRUE(fast_resolver.LoadModule(&module1, fast_symbol_file));
+  ASSERT_TRUE(fast_resolver.HasModule(&module1));
+  ASSERT_FALSE(fast_resolver.IsModuleCorrupt(&module1));
+
+  StackFrame frame;
+  frame.instruction = 0x1000;
+  frame.module = &module1;
+  fast_resolver.FillSourceLineInfo(&frame);
+  ASSERT_EQ(frame.function_name, "Function1_1");
+  ASSERT_EQ(frame.source_file_name, "file1_1.cc");
+  ASSERT_EQ(frame.source_line, 44);
+  scoped_ptr<WindowsFrameInfo> windows_frame_info(
+      fast_resolver.FindWindowsFrameInfo(&frame));
+  ASSERT_TRUE(windows_frame_info.get());
+
+  // The mapping goes away with the module, and can be made again.
+  fast_resolver.UnloadModule(&module1);
+  ASSERT_FALSE(fast_resolver.HasModule(&module1));
+  ASSERT_TRUE(fast_resolver.LoadModule(&module1, fast_symbol_file));
+  ASSERT_TRUE(fast_resolver.HasModule(&module1));
+
+  // A fast symbol file handed over in memory, as a SymbolSupplier returns
+  // it, is usable too.
+  string file_contents;
+  ASSERT_TRUE(ReadFile(fast_symbol_file, &file_contents));
+  TestCodeModule module2("module2");
+  ASSERT_TRUE(fast_resolver.LoadModuleUsingMapBuffer(&module2, file_contents));
+  ASSERT_FALSE(fast_resolver.IsModuleCorrupt(&module2));
+  ClearSourceLineInfo(&frame);
+  frame.instruction = 0x1000;
+  frame.module = &module2;
+  fast_resolver.FillSourceLineInfo(&frame);
+  ASSERT_EQ(frame.function_name, "Function1_1");
+}
+
+TEST_F(TestFastSourceLineResolver, InvalidFastSymbolFiles) {
+  AutoTempDir temp_dir;
+  string fast_symbol_file = temp_dir.path() + "/module1.fast";
+  ASSERT_TRUE(serializer.ConvertSymbolFileToFastSymbolFile(symbol_file(1),
+                                                          fast_symbol_file));
+  string file_contents;
+  ASSERT_TRUE(ReadFile(fast_symbol_file, &file_contents));
+  ASSERT_TRUE(FastSymbolFileHeader::Validate(file_contents.data(),
+                                             file_contents.size(), true));
+  TestCodeModule module1("module1");
+
+  // Truncated.
+  string bad_file = temp_dir.path() + "/truncated.fast";
+  ASSERT_TRUE(WriteFile(bad_file,
+                        file_contents.substr(0, file_contents.size() / 2)));
+  ASSERT_FALSE(fast_resolver.LoadModule(&module1, bad_file));
+  ASSERT_FALSE(fast_resolver.HasModule(&module1));
+
+  // Damaged data, which only the checksum reveals.
+  string damaged = file_contents;
+  damaged[damaged.size() / 2] ^= 0x20;
+  ASSERT_TRUE(FastSymbolFileHeader::Validate(damaged.data(), damaged.size(),
+                                             false));
+  ASSERT_FALSE(FastSymbolFileHeader::Validate(damaged.data(), damaged.size(),
+                                              true));
+  bad_file = temp_dir.path() + "/damaged.fast";
+  ASSERT_TRUE(WriteFile(bad_file, damaged));
+  fast_resolver.set_verify_checksums(true);
+  ASSERT_FALSE(fast_resolver.LoadModule(&module1, bad_file));
+  ASSERT_FALSE(fast_resolver.HasModule(&module1));
+  ASSERT_FALSE(fast_resolver.LoadModuleUsingMapBuffer(&module1, damaged));
+  ASSERT_FALSE(fast_resolver.HasModule(&module1));
+  fast_resolver.set_verify_checksums(false);
+
+  // Another version.
+  string other_version = file_contents;
+  uint32_t version = FastSymbolFileHeader::kVersion + 1;
+  memcpy(&other_version[offsetof(FastSymbolFileHeader, version)], &version,
+         sizeof(version));
+  bad_file = temp_dir.path() + "/version.fast";
+  ASSERT_TRUE(WriteFile(bad_file, other_version));
+  ASSERT_FALSE(fast_resolver.LoadModule(&module1, bad_file));
+  ASSERT_FALSE(fast_resolver.HasModule(&module1));
+
+  // The good file still loads.
+  ASSERT_TRUE(fast_resolver.LoadModule(&module1, fast_symbol_file));
+  ASSERT_TRUE(fast_resolver.HasModule(&module1));
+}
+
 TEST_F(TestFastSourceLineResolver, CompareModule) {
   char *symbol_data;
   size_t symbol_data_size;
@@ -484,6 +651,20 @@ TEST_F(TestFastSourceLineResolver, CompareModule) {
   }
 }
 
+TEST_F(TestFastSourceLineResolver, CompareLazyModuleFastSymbolFile) {
+  char *symbol_data;
+  size_t symbol_data_size;
+  string symbol_data_string;
+
+  for (int module_index = 0; module_index < 3; ++module_index) {
+    ASSERT_TRUE(SourceLineResolverBase::ReadSymbolFile(
+        symbol_file(module_index), &symbol_data, &symbol_data_size));
+    symbol_data_string.assign(symbol_data, symbol_data_size);
+    delete [] symbol_data;
+    ASSERT_TRUE(module_comparer.CompareFastSymbolFile(symbol_data_string));
+  }
+}
+
 }  // namespace
 
 int main(int argc, char *argv[]) {
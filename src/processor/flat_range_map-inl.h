@@ -0,0 +1,165 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// flat_range_map-inl.h: FlatRangeMap implementation.
+//
+// See flat_range_map.h for documentation.
+
+#ifndef PROCESSOR_FLAT_RANGE_MAP_INL_H__
+#define PROCESSOR_FLAT_RANGE_MAP_INL_H__
+
+#include <assert.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "processor/flat_range_map.h"
+#include "processor/logging.h"
+
+namespace google_breakpad {
+
+template<typename AddressType, typename EntryType>
+bool FlatRangeMap<AddressType, EntryType>::StoreRange(
+    const AddressType &base, const AddressType &size,
+    const EntryType &entry) {
+  AddressType high = base + (size - 1);
+
+  // Check for undersize or overflow.
+  if (size <= 0 || high < base) {
+    BPLOG(INFO) << "StoreRange failed, " << HexString(base) << "+" <<
+                   HexString(size) << ", " << HexString(high);
+    return false;
+  }
+
+  // Ranges stored in ascending order, as they usually are, need no sort.
+  if (!bases_.empty() && base <= bases_.back())
+    finalized_ = false;
+
+  Range range = { high, entry };
+  bases_.push_back(base);
+  ranges_.push_back(range);
+  return true;
+}
+
+template<typename AddressType, typename EntryType>
+bool FlatRangeMap<AddressType, EntryType>::Finalize() {
+  if (!finalized_) {
+    std::vector<std::pair<AddressType, size_t> > order(bases_.size());
+    for (size_t i = 0; i < bases_.size(); ++i)
+      order[i] = std::make_pair(bases_[i], i);
+    std::sort(order.begin(), order.end());
+
+    std::vector<AddressType> bases(bases_.size());
+    std::vector<Range> ranges(ranges_.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+      bases[i] = order[i].first;
+      ranges[i] = ranges_[order[i].second];
+    }
+    bases_.swap(bases);
+    ranges_.swap(ranges);
+    finalized_ = true;
+  }
+
+  for (size_t i = 1; i < bases_.size(); ++i) {
+    if (bases_[i] <= ranges_[i - 1].high) {
+      BPLOG(INFO) << "Finalize failed, " << HexString(bases_[i - 1]) << "-" <<
+                     HexString(ranges_[i - 1].high) << " overlaps " <<
+                     HexString(bases_[i]) << "-" << HexString(ranges_[i].high);
+      Clear();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+template<typename AddressType, typename EntryType>
+bool FlatRangeMap<AddressType, EntryType>::RetrieveRange(
+    const AddressType &address, EntryType *entry,
+    AddressType *entry_base, AddressType *entry_size) const {
+  BPLOG_IF(ERROR, !entry) << "FlatRangeMap::RetrieveRange requires |entry|";
+  assert(entry);
+  assert(finalized_);
+
+  // The range that could contain address is the last one based at or below
+  // it.
+  typename std::vector<AddressType>::const_iterator iterator =
+      std::upper_bound(bases_.begin(), bases_.end(), address);
+  if (iterator == bases_.begin())
+    return false;
+  size_t index = (iterator - bases_.begin()) - 1;
+  if (address > ranges_[index].high)
+    return false;
+
+  GetRangeAtIndex(index, entry, entry_base, entry_size);
+  return true;
+}
+
+template<typename AddressType, typename EntryType>
+bool FlatRangeMap<AddressType, EntryType>::RetrieveRangeAtOrAfter(
+    const AddressType &address, EntryType *entry,
+    AddressType *entry_base, AddressType *entry_size) const {
+  BPLOG_IF(ERROR, !entry) << "FlatRangeMap::RetrieveRangeAtOrAfter requires "
+                             "|entry|";
+  assert(entry);
+  assert(finalized_);
+
+  size_t index = std::upper_bound(bases_.begin(), bases_.end(), address) -
+                 bases_.begin();
+  // Prefer the range below, if it extends to address.
+  if (index > 0 && address <= ranges_[index - 1].high)
+    --index;
+  if (index == bases_.size())
+    return false;
+
+  GetRangeAtIndex(index, entry, entry_base, entry_size);
+  return true;
+}
+
+template<typename AddressType, typename EntryType>
+void FlatRangeMap<AddressType, EntryType>::Clear() {
+  bases_.clear();
+  ranges_.clear();
+  finalized_ = true;
+}
+
+template<typename AddressType, typename EntryType>
+void FlatRangeMap<AddressType, EntryType>::GetRangeAtIndex(
+    size_t index, EntryType *entry,
+    AddressType *entry_base, AddressType *entry_size) const {
+  *entry = ranges_[index].entry;
+  if (entry_base)
+    *entry_base = bases_[index];
+  if (entry_size)
+    *entry_size = ranges_[index].high - bases_[index] + 1;
+}
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_FLAT_RANGE_MAP_INL_H__
@@ -0,0 +1,106 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// flat_range_map.h: FlatRangeMap, an address range map in sorted arrays.
+//
+// FlatRangeMap answers the same point lookups as RangeMap, but keeps its
+// ranges in a sorted array instead of a std::map.  It is meant for maps
+// that are built once and then searched very many times, such as the
+// memory regions of a minidump: a lookup is a binary search over a
+// contiguous array of base addresses, with no pointers to chase.  It can
+// also find the first range at or above an address.
+//
+// Ranges may be stored in any order, but Finalize must be called after the
+// last of them, and before any lookup.
+
+#ifndef PROCESSOR_FLAT_RANGE_MAP_H__
+#define PROCESSOR_FLAT_RANGE_MAP_H__
+
+#include <vector>
+
+namespace google_breakpad {
+
+template<typename AddressType, typename EntryType>
+class FlatRangeMap {
+ public:
+  FlatRangeMap() : finalized_(true) {}
+
+  // Adds a range to the map.  Returns false if size is zero or the range
+  // extends past the end of the address space.  Ranges that overlap are
+  // only detected by Finalize.
+  bool StoreRange(const AddressType &base, const AddressType &size,
+                  const EntryType &entry);
+
+  // Sorts the ranges stored since the last call, if needed.  Returns false
+  // if any two ranges overlap, in which case the map is left empty.
+  bool Finalize();
+
+  // Locates the range encompassing address.  Returns false if there is no
+  // such range.  entry_base and entry_size, if non-NULL, are set to the
+  // base and size of the range.
+  bool RetrieveRange(const AddressType &address, EntryType *entry,
+                     AddressType *entry_base, AddressType *entry_size) const;
+
+  // Locates the range encompassing address or, if there is none, the
+  // lowest range above address.  Returns false if every range lies below
+  // address.  entry_base and entry_size are set as by RetrieveRange.
+  bool RetrieveRangeAtOrAfter(const AddressType &address, EntryType *entry,
+                              AddressType *entry_base,
+                              AddressType *entry_size) const;
+
+  // Returns the number of ranges stored.
+  int GetCount() const { return static_cast<int>(bases_.size()); }
+
+  // Empties the map.
+  void Clear();
+
+ private:
+  struct Range {
+    AddressType high;
+    EntryType entry;
+  };
+
+  // Fills in the results of a lookup that found the range at index.
+  void GetRangeAtIndex(size_t index, EntryType *entry,
+                       AddressType *entry_base, AddressType *entry_size) const;
+
+  // The base address of each range, in ascending order once finalized.
+  // Searches only touch this array.
+  std::vector<AddressType> bases_;
+
+  // The rest of each range, parallel to bases_.
+  std::vector<Range> ranges_;
+
+  // False if ranges have been stored out of order since the last Finalize.
+  bool finalized_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_FLAT_RANGE_MAP_H__
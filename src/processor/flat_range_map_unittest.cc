@@ -0,0 +1,163 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// flat_range_map_unittest.cc: Unit tests for FlatRangeMap.
+
+#include <stdint.h>
+
+#include "processor/flat_range_map-inl.h"
+
+#include "breakpad_googletest_includes.h"
+
+namespace {
+
+using google_breakpad::FlatRangeMap;
+
+typedef FlatRangeMap<uint64_t, int> TestMap;
+
+TEST(FlatRangeMapTest, Empty) {
+  TestMap map;
+  ASSERT_TRUE(map.Finalize());
+  EXPECT_EQ(0, map.GetCount());
+
+  int entry;
+  EXPECT_FALSE(map.RetrieveRange(0, &entry, NULL, NULL));
+  EXPECT_FALSE(map.RetrieveRangeAtOrAfter(0, &entry, NULL, NULL));
+}
+
+TEST(FlatRangeMapTest, RejectsBadRanges) {
+  TestMap map;
+  EXPECT_FALSE(map.StoreRange(0x1000, 0, 1));
+  EXPECT_FALSE(map.StoreRange(UINT64_MAX - 1, 3, 2));
+  EXPECT_TRUE(map.StoreRange(UINT64_MAX - 1, 2, 3));
+  ASSERT_TRUE(map.Finalize());
+  EXPECT_EQ(1, map.GetCount());
+
+  int entry;
+  uint64_t base, size;
+  ASSERT_TRUE(map.RetrieveRange(UINT64_MAX, &entry, &base, &size));
+  EXPECT_EQ(3, entry);
+  EXPECT_EQ(UINT64_MAX - 1, base);
+  EXPECT_EQ(2U, size);
+}
+
+// Ranges stored out of order are sorted by Finalize.
+TEST(FlatRangeMapTest, Unordered) {
+  TestMap map;
+  ASSERT_TRUE(map.StoreRange(0x3000, 0x100, 3));
+  ASSERT_TRUE(map.StoreRange(0x1000, 0x100, 1));
+  ASSERT_TRUE(map.StoreRange(0x2000, 0x1000, 2));
+  ASSERT_TRUE(map.Finalize());
+  EXPECT_EQ(3, map.GetCount());
+
+  int entry;
+  uint64_t base, size;
+  EXPECT_FALSE(map.RetrieveRange(0xfff, &entry, NULL, NULL));
+  ASSERT_TRUE(map.RetrieveRange(0x1000, &entry, &base, &size));
+  EXPECT_EQ(1, entry);
+  EXPECT_EQ(0x1000U, base);
+  EXPECT_EQ(0x100U, size);
+  ASSERT_TRUE(map.RetrieveRange(0x10ff, &entry, NULL, NULL));
+  EXPECT_EQ(1, entry);
+  EXPECT_FALSE(map.RetrieveRange(0x1100, &entry, NULL, NULL));
+  // 0x2000-0x2fff and 0x3000-0x30ff are adjacent.
+  ASSERT_TRUE(map.RetrieveRange(0x2fff, &entry, NULL, NULL));
+  EXPECT_EQ(2, entry);
+  ASSERT_TRUE(map.RetrieveRange(0x3000, &entry, NULL, NULL));
+  EXPECT_EQ(3, entry);
+  EXPECT_FALSE(map.RetrieveRange(0x3100, &entry, NULL, NULL));
+}
+
+TEST(FlatRangeMapTest, Overlap) {
+  TestMap map;
+  ASSERT_TRUE(map.StoreRange(0x1000, 0x100, 1));
+  ASSERT_TRUE(map.StoreRange(0x2000, 0x100, 2));
+  ASSERT_TRUE(map.StoreRange(0x10ff, 0x10, 3));
+  EXPECT_FALSE(map.Finalize());
+  EXPECT_EQ(0, map.GetCount());
+}
+
+TEST(FlatRangeMapTest, AtOrAfter) {
+  TestMap map;
+  ASSERT_TRUE(map.StoreRange(0x1000, 0x100, 1));
+  ASSERT_TRUE(map.StoreRange(0x2000, 0x100, 2));
+  ASSERT_TRUE(map.Finalize());
+
+  int entry;
+  uint64_t base;
+  ASSERT_TRUE(map.RetrieveRangeAtOrAfter(0, &entry, &base, NULL));
+  EXPECT_EQ(1, entry);
+  EXPECT_EQ(0x1000U, base);
+  ASSERT_TRUE(map.RetrieveRangeAtOrAfter(0x1080, &entry, NULL, NULL));
+  EXPECT_EQ(1, entry);
+  ASSERT_TRUE(map.RetrieveRangeAtOrAfter(0x1100, &entry, &base, NULL));
+  EXPECT_EQ(2, entry);
+  EXPECT_EQ(0x2000U, base);
+  ASSERT_TRUE(map.RetrieveRangeAtOrAfter(0x20ff, &entry, NULL, NULL));
+  EXPECT_EQ(2, entry);
+  EXPECT_FALSE(map.RetrieveRangeAtOrAfter(0x2100, &entry, NULL, NULL));
+}
+
+// Results match a linear scan over many ranges.
+TEST(FlatRangeMapTest, ManyRanges) {
+  const int kRangeCount = 1000;
+  TestMap map;
+  // Store in a scrambled order, with gaps between ranges.
+  for (int i = 0; i < kRangeCount; ++i) {
+    int index = (i * 7) % kRangeCount;
+    ASSERT_TRUE(map.StoreRange(index * 0x100, 0x80 + index % 0x80, index));
+  }
+  ASSERT_TRUE(map.Finalize());
+  ASSERT_EQ(kRangeCount, map.GetCount());
+
+  for (uint64_t address = 0; address < kRangeCount * 0x100 + 0x10;
+       address += 0x1f) {
+    int expected = -1;
+    int expected_after = -1;
+    for (int index = 0; index < kRangeCount && expected_after < 0; ++index) {
+      uint64_t base = index * 0x100;
+      uint64_t high = base + 0x80 + index % 0x80 - 1;
+      if (address >= base && address <= high)
+        expected = index;
+      if (address <= high)
+        expected_after = index;
+    }
+
+    int entry;
+    EXPECT_EQ(expected >= 0, map.RetrieveRange(address, &entry, NULL, NULL));
+    if (expected >= 0)
+      EXPECT_EQ(expected, entry);
+    EXPECT_EQ(expected_after >= 0,
+              map.RetrieveRangeAtOrAfter(address, &entry, NULL, NULL));
+    if (expected_after >= 0)
+      EXPECT_EQ(expected_after, entry);
+  }
+}
+
+}  // namespace
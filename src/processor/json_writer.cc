@@ -0,0 +1,207 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// json_writer.cc: Implementation of JSONWriter.  See json_writer.h.
+
+#include "processor/json_writer.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "common/stdio_wrapper.h"
+
+namespace google_breakpad {
+
+namespace {
+
+// Returns the length of the valid UTF-8 sequence beginning at data[0],
+// which must be at least 0x80, or 0 if the bytes there are not one.
+// Overlong encodings, surrogates and code points above U+10FFFF are
+// rejected as RFC 3629 requires.
+size_t UTF8SequenceLength(const unsigned char *data, size_t length) {
+  unsigned char lead = data[0];
+  size_t sequence_length;
+  unsigned char second_min = 0x80, second_max = 0xbf;
+  if (lead >= 0xc2 && lead <= 0xdf) {
+    sequence_length = 2;
+  } else if (lead >= 0xe0 && lead <= 0xef) {
+    sequence_length = 3;
+    if (lead == 0xe0)
+      second_min = 0xa0;
+    else if (lead == 0xed)
+      second_max = 0x9f;
+  } else if (lead >= 0xf0 && lead <= 0xf4) {
+    sequence_length = 4;
+    if (lead == 0xf0)
+      second_min = 0x90;
+    else if (lead == 0xf4)
+      second_max = 0x8f;
+  } else {
+    return 0;
+  }
+
+  if (length < sequence_length)
+    return 0;
+  if (data[1] < second_min || data[1] > second_max)
+    return 0;
+  for (size_t i = 2; i < sequence_length; ++i) {
+    if (data[i] < 0x80 || data[i] > 0xbf)
+      return 0;
+  }
+  return sequence_length;
+}
+
+}  // namespace
+
+JSONWriter::JSONWriter(FILE *file) : file_(file), after_key_(false) {}
+
+void JSONWriter::BeginObject() {
+  BeginValue();
+  putc('{', file_);
+  empty_.push_back(true);
+}
+
+void JSONWriter::EndObject() {
+  assert(!empty_.empty() && !after_key_);
+  empty_.pop_back();
+  putc('}', file_);
+}
+
+void JSONWriter::BeginArray() {
+  BeginValue();
+  putc('[', file_);
+  empty_.push_back(true);
+}
+
+void JSONWriter::EndArray() {
+  assert(!empty_.empty() && !after_key_);
+  empty_.pop_back();
+  putc(']', file_);
+}
+
+void JSONWriter::Key(const char *key) {
+  assert(!empty_.empty() && !after_key_);
+  String(key);
+  putc(':', file_);
+  after_key_ = true;
+}
+
+void JSONWriter::String(const string &value) {
+  BeginValue();
+  putc('"', file_);
+  WriteEscaped(value.data(), value.size());
+  putc('"', file_);
+}
+
+void JSONWriter::String(const char *value) {
+  BeginValue();
+  putc('"', file_);
+  WriteEscaped(value, strlen(value));
+  putc('"', file_);
+}
+
+void JSONWriter::Int(int64_t value) {
+  BeginValue();
+  fprintf(file_, "%" PRId64, value);
+}
+
+void JSONWriter::UInt(uint64_t value) {
+  BeginValue();
+  fprintf(file_, "%" PRIu64, value);
+}
+
+void JSONWriter::Bool(bool value) {
+  BeginValue();
+  fputs(value ? "true" : "false", file_);
+}
+
+void JSONWriter::Null() {
+  BeginValue();
+  fputs("null", file_);
+}
+
+void JSONWriter::Hex(uint64_t value, int min_digits) {
+  BeginValue();
+  fprintf(file_, "\"0x%0*" PRIx64 "\"", min_digits, value);
+}
+
+void JSONWriter::BeginValue() {
+  if (after_key_) {
+    after_key_ = false;
+    return;
+  }
+  if (!empty_.empty()) {
+    if (!empty_.back())
+      putc(',', file_);
+    empty_.back() = false;
+  }
+}
+
+void JSONWriter::WriteEscaped(const char *data, size_t length) {
+  const unsigned char *bytes = reinterpret_cast<const unsigned char*>(data);
+
+  // Bytes that need no escaping are written a run at a time.
+  size_t run_start = 0;
+  size_t i = 0;
+  while (i < length) {
+    unsigned char c = bytes[i];
+    if (c >= 0x20 && c != '"' && c != '\\' && c < 0x80) {
+      ++i;
+      continue;
+    }
+    if (c >= 0x80) {
+      size_t sequence_length = UTF8SequenceLength(bytes + i, length - i);
+      if (sequence_length) {
+        i += sequence_length;
+        continue;
+      }
+    }
+
+    fwrite(data + run_start, 1, i - run_start, file_);
+    switch (c) {
+      case '"':  fputs("\\\"", file_); break;
+      case '\\': fputs("\\\\", file_); break;
+      case '\b': fputs("\\b", file_); break;
+      case '\f': fputs("\\f", file_); break;
+      case '\n': fputs("\\n", file_); break;
+      case '\r': fputs("\\r", file_); break;
+      case '\t': fputs("\\t", file_); break;
+      default:
+        if (c < 0x20)
+          fprintf(file_, "\\u%04x", c);
+        else
+          fputs("\\ufffd", file_);
+        break;
+    }
+    run_start = ++i;
+  }
+  fwrite(data + run_start, 1, length - run_start, file_);
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,102 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// json_writer.h: JSONWriter writes JSON text to a stdio stream as it is
+// produced, without building the document in memory first.
+//
+// The caller is responsible for the document's structure: every Begin*()
+// must be matched by the corresponding End*(), and inside an object every
+// value must be preceded by Key().  JSONWriter inserts the separators
+// between members and elements itself.  Strings are written as UTF-8;
+// byte sequences in them that are not valid UTF-8 are replaced with
+// U+FFFD so that the output is always valid JSON.
+
+#ifndef PROCESSOR_JSON_WRITER_H__
+#define PROCESSOR_JSON_WRITER_H__
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "common/using_std_string.h"
+#include "google_breakpad/common/breakpad_types.h"
+
+namespace google_breakpad {
+
+class JSONWriter {
+ public:
+  // Writes to file, which the caller continues to own.
+  explicit JSONWriter(FILE *file);
+
+  void BeginObject();
+  void EndObject();
+  void BeginArray();
+  void EndArray();
+
+  // Writes the name of the next member of the current object.
+  void Key(const char *key);
+
+  void String(const string &value);
+  void String(const char *value);
+  void Int(int64_t value);
+  void UInt(uint64_t value);
+  void Bool(bool value);
+  void Null();
+
+  // Writes value as a string of hexadecimal digits preceded by "0x",
+  // zero-padded to at least min_digits digits.  JSON numbers cannot
+  // represent every 64-bit address exactly, so addresses and register
+  // values are written this way.
+  void Hex(uint64_t value, int min_digits);
+
+ private:
+  // Writes the separator due before the next value, if any.
+  void BeginValue();
+
+  // Writes data, of length bytes, as the contents of a JSON string.
+  void WriteEscaped(const char *data, size_t length);
+
+  FILE *file_;
+
+  // For each array or object being written, innermost last, whether it
+  // has no members or elements yet.
+  std::vector<bool> empty_;
+
+  // True if a Key() has been written and its value has not.
+  bool after_key_;
+
+  // Disallow copy constructor and assignment operator.
+  JSONWriter(const JSONWriter &that);
+  void operator=(const JSONWriter &that);
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_JSON_WRITER_H__
@@ -0,0 +1,137 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// json_writer_unittest.cc: Unit tests for JSONWriter.
+
+#include <stdio.h>
+
+#include <string>
+
+#include "breakpad_googletest_includes.h"
+#include "common/using_std_string.h"
+#include "processor/json_writer.h"
+
+namespace {
+
+using google_breakpad::JSONWriter;
+
+class JSONWriterTest : public ::testing::Test {
+ public:
+  JSONWriterTest() : file_(tmpfile()), writer_(file_) {}
+  ~JSONWriterTest() { fclose(file_); }
+
+  // Returns everything written so far.
+  string Output() {
+    fflush(file_);
+    string output;
+    rewind(file_);
+    char buffer[256];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file_)) > 0)
+      output.append(buffer, count);
+    return output;
+  }
+
+  FILE *file_;
+  JSONWriter writer_;
+};
+
+TEST_F(JSONWriterTest, Empty) {
+  writer_.BeginObject();
+  writer_.Key("array");
+  writer_.BeginArray();
+  writer_.EndArray();
+  writer_.Key("object");
+  writer_.BeginObject();
+  writer_.EndObject();
+  writer_.EndObject();
+  EXPECT_EQ("{\"array\":[],\"object\":{}}", Output());
+}
+
+TEST_F(JSONWriterTest, Values) {
+  writer_.BeginArray();
+  writer_.String("text");
+  writer_.Int(-42);
+  writer_.UInt(0xffffffffffffffffULL);
+  writer_.Bool(true);
+  writer_.Bool(false);
+  writer_.Null();
+  writer_.Hex(0x1234, 8);
+  writer_.Hex(0xfedcba9876543210ULL, 0);
+  writer_.EndArray();
+  EXPECT_EQ("[\"text\",-42,18446744073709551615,true,false,null,"
+            "\"0x00001234\",\"0xfedcba9876543210\"]", Output());
+}
+
+TEST_F(JSONWriterTest, Nesting) {
+  writer_.BeginObject();
+  writer_.Key("a");
+  writer_.BeginArray();
+  writer_.BeginObject();
+  writer_.Key("b");
+  writer_.Int(1);
+  writer_.Key("c");
+  writer_.Int(2);
+  writer_.EndObject();
+  writer_.BeginArray();
+  writer_.Int(3);
+  writer_.EndArray();
+  writer_.EndArray();
+  writer_.Key("d");
+  writer_.String(string());
+  writer_.EndObject();
+  EXPECT_EQ("{\"a\":[{\"b\":1,\"c\":2},[3]],\"d\":\"\"}", Output());
+}
+
+TEST_F(JSONWriterTest, Escapes) {
+  writer_.String(string("\"\\/\b\f\n\r\t\x01\x1f", 10) + string(1, '\0'));
+  EXPECT_EQ("\"\\\"\\\\/\\b\\f\\n\\r\\t\\u0001\\u001f\\u0000\"", Output());
+}
+
+TEST_F(JSONWriterTest, UTF8) {
+  // Two-, three- and four-byte sequences pass through unchanged.
+  writer_.String("\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80");
+  EXPECT_EQ("\"\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80\"", Output());
+}
+
+TEST_F(JSONWriterTest, InvalidUTF8) {
+  writer_.BeginArray();
+  // A lone continuation byte, and a truncated sequence.
+  writer_.String("a\x80" "b\xe2\x82");
+  // An overlong encoding of '/', and an encoded surrogate.
+  writer_.String("\xc0\xaf\xed\xa0\x80");
+  // A code point above U+10FFFF, and a byte that never appears.
+  writer_.String("\xf4\x90\x80\x80\xff");
+  writer_.EndArray();
+  EXPECT_EQ("[\"a\\ufffdb\\ufffd\\ufffd\","
+            "\"\\ufffd\\ufffd\\ufffd\\ufffd\\ufffd\","
+            "\"\\ufffd\\ufffd\\ufffd\\ufffd\\ufffd\"]", Output());
+}
+
+}  // namespace
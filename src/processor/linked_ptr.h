@@ -49,6 +49,16 @@
 // Note: If you use an incomplete type with linked_ptr<>, the class
 // *containing* linked_ptr<> must have a constructor and destructor (even
 // if they do nothing!).
+//
+// Thread Safety:
+//   linked_ptr<> is not thread-safe.  Copying or destroying a linked_ptr<>
+//   modifies the circular list shared by every other linked_ptr<> to the
+//   same object, so two threads must not do so at once for linked_ptr<>s
+//   to one object.  Threads that look entries up in a shared, otherwise
+//   read-only container of linked_ptr<>s, such as a loaded symbol module,
+//   must take pointers to the stored linked_ptr<>s (as the *Ptr retrieval
+//   methods of RangeMap, AddressMap and ContainedRangeMap do) rather than
+//   copies.
 
 #ifndef PROCESSOR_LINKED_PTR_H__
 #define PROCESSOR_LINKED_PTR_H__
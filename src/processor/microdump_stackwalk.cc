@@ -108,9 +108,10 @@ int PrintMicrodumpProcess(const Options& options) {
 
   if (res == google_breakpad::PROCESS_OK) {
     if (options.machine_readable) {
-      PrintProcessStateMachineReadable(process_state);
+      PrintProcessStateMachineReadable(process_state, stdout);
     } else {
-      PrintProcessState(process_state, options.output_stack_contents, &resolver);
+      PrintProcessState(process_state, options.output_stack_contents, &resolver,
+                        stdout);
     }
     return 0;
   }
@@ -44,6 +44,8 @@
 #ifdef _WIN32
 #include <io.h>
 #else  // _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #endif  // _WIN32
 
@@ -52,12 +54,14 @@
 #include <limits>
 #include <utility>
 
+#include "processor/flat_range_map-inl.h"
 #include "processor/range_map-inl.h"
 
 #include "common/macros.h"
 #include "common/scoped_ptr.h"
 #include "common/stdio_wrapper.h"
 #include "google_breakpad/processor/dump_context.h"
+#include "google_breakpad/processor/minidump_data_source.h"
 #include "processor/basic_code_module.h"
 #include "processor/basic_code_modules.h"
 #include "processor/convert_old_arm64_context.h"
@@ -130,13 +134,14 @@ inline void Swap(uint32_t* value) {
             (*value << 24);
 }
 
+// Swap the halves with shifts rather than through a uint32_t pointer, which
+// the compiler may assume does not alias *value.
 inline void Swap(uint64_t* value) {
-  uint32_t* value32 = reinterpret_cast<uint32_t*>(value);
-  Swap(&value32[0]);
-  Swap(&value32[1]);
-  uint32_t temp = value32[0];
-  value32[0] = value32[1];
-  value32[1] = temp;
+  uint32_t low = static_cast<uint32_t>(*value);
+  uint32_t high = static_cast<uint32_t>(*value >> 32);
+  Swap(&low);
+  Swap(&high);
+  *value = (static_cast<uint64_t>(low) << 32) | high;
 }
 
 
@@ -174,6 +179,11 @@ inline void Swap(MDMemoryDescriptor* memory_descriptor) {
   Swap(&memory_descriptor->memory);
 }
 
+inline void Swap(MDMemoryDescriptor64* memory_descriptor) {
+  Swap(&memory_descriptor->start_of_memory_range);
+  Swap(&memory_descriptor->data_size);
+}
+
 inline void Swap(MDGUID* guid) {
   Swap(&guid->data1);
   Swap(&guid->data2);
@@ -1272,7 +1282,9 @@ uint32_t MinidumpMemoryRegion::max_bytes_ = 64 * 1024 * 1024;  // 64MB
 MinidumpMemoryRegion::MinidumpMemoryRegion(Minidump* minidump)
     : MinidumpObject(minidump),
       descriptor_(NULL),
-      memory_(NULL) {
+      location_(0),
+      memory_(NULL),
+      memory_view_(NULL) {
   hexdump_width_ = minidump_ ? minidump_->HexdumpMode() : 0;
   hexdump_ = hexdump_width_ != 0;
 }
@@ -1284,7 +1296,14 @@ MinidumpMemoryRegion::~MinidumpMemoryRegion() {
 
 
 void MinidumpMemoryRegion::SetDescriptor(MDMemoryDescriptor* descriptor) {
+  SetDescriptor(descriptor, descriptor ? descriptor->memory.rva : 0);
+}
+
+
+void MinidumpMemoryRegion::SetDescriptor(MDMemoryDescriptor* descriptor,
+                                         off_t location) {
   descriptor_ = descriptor;
+  location_ = location;
   valid_ = descriptor &&
            descriptor_->memory.data_size <=
                numeric_limits<uint64_t>::max() -
@@ -1298,13 +1317,23 @@ const uint8_t* MinidumpMemoryRegion::GetMemory() const {
     return NULL;
   }
 
+  if (memory_view_)
+    return memory_view_;
+
   if (!memory_) {
     if (descriptor_->memory.data_size == 0) {
       BPLOG(ERROR) << "MinidumpMemoryRegion is empty";
       return NULL;
     }
 
-    if (!minidump_->SeekSet(descriptor_->memory.rva)) {
+    // Nothing needs to be allocated for a region of a memory-mapped
+    // minidump, so max_bytes_ doesn't apply.
+    memory_view_ = minidump_->GetMappedBytes(location_,
+                                             descriptor_->memory.data_size);
+    if (memory_view_)
+      return memory_view_;
+
+    if (!minidump_->SeekSet(location_)) {
       BPLOG(ERROR) << "MinidumpMemoryRegion could not seek to memory region";
       return NULL;
     }
@@ -1354,6 +1383,7 @@ uint32_t MinidumpMemoryRegion::GetSize() const {
 void MinidumpMemoryRegion::FreeMemory() {
   delete memory_;
   memory_ = NULL;
+  memory_view_ = NULL;
 }
 
 
@@ -1401,6 +1431,53 @@ bool MinidumpMemoryRegion::GetMemoryAtAddressInternal(uint64_t address,
 }
 
 
+template<typename T>
+size_t MinidumpMemoryRegion::GetMemoryAtAddressesInternal(
+    uint64_t address, T* values, size_t count) const {
+  if (!valid_) {
+    BPLOG(ERROR) << "Invalid MinidumpMemoryRegion for "
+                    "GetMemoryAtAddressesInternal";
+    return 0;
+  }
+
+  uint64_t start = descriptor_->start_of_memory_range;
+  uint64_t size = descriptor_->memory.data_size;
+  if (address < start || address - start >= size)
+    return 0;
+  count = std::min<uint64_t>(count, (size - (address - start)) / sizeof(T));
+  if (count == 0)
+    return 0;
+
+  const uint8_t* memory = GetMemory();
+  if (!memory) {
+    // GetMemory already logged a perfectly good message.
+    return 0;
+  }
+
+  memcpy(values, &memory[address - start], count * sizeof(T));
+  if (minidump_->swap()) {
+    for (size_t i = 0; i < count; ++i)
+      Swap(&values[i]);
+  }
+
+  return count;
+}
+
+
+size_t MinidumpMemoryRegion::GetMemoryAtAddresses(uint64_t  address,
+                                                  uint32_t* values,
+                                                  size_t    count) const {
+  return GetMemoryAtAddressesInternal(address, values, count);
+}
+
+
+size_t MinidumpMemoryRegion::GetMemoryAtAddresses(uint64_t  address,
+                                                  uint64_t* values,
+                                                  size_t    count) const {
+  return GetMemoryAtAddressesInternal(address, values, count);
+}
+
+
 bool MinidumpMemoryRegion::GetMemoryAtAddress(uint64_t  address,
                                               uint8_t*  value) const {
   return GetMemoryAtAddressInternal(address, value);
@@ -1832,6 +1909,193 @@ void MinidumpThreadList::Print() {
 }
 
 
+//
+// MinidumpThreadNameList
+//
+
+
+uint32_t MinidumpThreadNameList::max_thread_names_ = 4096;
+
+
+MinidumpThreadNameList::MinidumpThreadNameList(Minidump* minidump)
+    : MinidumpStream(minidump),
+      id_to_index_map_(),
+      thread_ids_(),
+      thread_names_(),
+      thread_name_count_(0) {
+}
+
+
+MinidumpThreadNameList::~MinidumpThreadNameList() {
+}
+
+
+bool MinidumpThreadNameList::Read(uint32_t expected_size) {
+  // Invalidate cached data.
+  id_to_index_map_.clear();
+  thread_ids_.clear();
+  thread_names_.clear();
+  thread_name_count_ = 0;
+
+  valid_ = false;
+
+  uint32_t thread_name_count;
+  if (expected_size < sizeof(thread_name_count)) {
+    BPLOG(ERROR) << "MinidumpThreadNameList count size mismatch, " <<
+                    expected_size << " < " << sizeof(thread_name_count);
+    return false;
+  }
+  if (!minidump_->ReadBytes(&thread_name_count, sizeof(thread_name_count))) {
+    BPLOG(ERROR) << "MinidumpThreadNameList cannot read thread name count";
+    return false;
+  }
+
+  if (minidump_->swap())
+    Swap(&thread_name_count);
+
+  if (thread_name_count > max_thread_names_) {
+    BPLOG(ERROR) << "MinidumpThreadNameList count " << thread_name_count <<
+                    " exceeds maximum " << max_thread_names_;
+    return false;
+  }
+
+  // thread_name_count is now small enough that this can't overflow.
+  if (expected_size != sizeof(thread_name_count) +
+                       thread_name_count * sizeof(MDRawThreadName)) {
+    BPLOG(ERROR) << "MinidumpThreadNameList size mismatch, " <<
+                    expected_size << " != " << sizeof(thread_name_count) +
+                    thread_name_count * sizeof(MDRawThreadName);
+    return false;
+  }
+
+  if (thread_name_count != 0) {
+    // Read the entire array in one fell swoop, instead of reading one entry
+    // at a time in the loop.  The names are read afterwards, since reading
+    // them moves the minidump's read position.
+    vector<MDRawThreadName> raw_names(thread_name_count);
+    if (!minidump_->ReadBytes(&raw_names[0],
+                              sizeof(MDRawThreadName) * thread_name_count)) {
+      BPLOG(ERROR) << "MinidumpThreadNameList cannot read thread name list";
+      return false;
+    }
+
+    ThreadIDs thread_ids;
+    ThreadNames thread_names;
+    thread_ids.reserve(thread_name_count);
+    thread_names.reserve(thread_name_count);
+
+    for (unsigned int name_index = 0;
+         name_index < thread_name_count;
+         ++name_index) {
+      MDRawThreadName* raw_name = &raw_names[name_index];
+
+      uint32_t thread_id = raw_name->thread_id;
+      MDRVA64 thread_name_rva = raw_name->thread_name_rva;
+      if (minidump_->swap()) {
+        Swap(&thread_id);
+        Swap(&thread_name_rva);
+      }
+
+      if (thread_name_rva >
+          static_cast<uint64_t>(numeric_limits<off_t>::max())) {
+        BPLOG(ERROR) << "MinidumpThreadNameList name " << name_index << "/" <<
+                        thread_name_count << " has an invalid rva " <<
+                        HexString(thread_name_rva);
+        return false;
+      }
+
+      scoped_ptr<string> thread_name(
+          minidump_->ReadString(static_cast<off_t>(thread_name_rva)));
+      if (!thread_name.get()) {
+        BPLOG(ERROR) << "MinidumpThreadNameList could not read name " <<
+                        name_index << "/" << thread_name_count;
+        return false;
+      }
+
+      // As with MinidumpThreadList, the first entry for an ID wins.
+      if (id_to_index_map_.find(thread_id) != id_to_index_map_.end()) {
+        BPLOG(INFO) << "MinidumpThreadNameList found multiple names for " <<
+                       "thread " << HexString(thread_id) << ", ignoring " <<
+                       name_index << "/" << thread_name_count;
+      } else {
+        id_to_index_map_[thread_id] = thread_ids.size();
+      }
+
+      thread_ids.push_back(thread_id);
+      thread_names.push_back(*thread_name);
+    }
+
+    thread_ids_.swap(thread_ids);
+    thread_names_.swap(thread_names);
+  }
+
+  thread_name_count_ = thread_name_count;
+
+  valid_ = true;
+  return true;
+}
+
+
+bool MinidumpThreadNameList::GetThreadNameAtIndex(unsigned int index,
+                                                  uint32_t* thread_id,
+                                                  string* thread_name) const {
+  if (!valid_) {
+    BPLOG(ERROR) << "Invalid MinidumpThreadNameList for GetThreadNameAtIndex";
+    return false;
+  }
+
+  if (index >= thread_name_count_) {
+    BPLOG(ERROR) << "MinidumpThreadNameList index out of range: " <<
+                    index << "/" << thread_name_count_;
+    return false;
+  }
+
+  if (thread_id)
+    *thread_id = thread_ids_[index];
+  if (thread_name)
+    *thread_name = thread_names_[index];
+  return true;
+}
+
+
+bool MinidumpThreadNameList::GetThreadNameByID(uint32_t thread_id,
+                                               string* thread_name) const {
+  if (!valid_) {
+    BPLOG(ERROR) << "Invalid MinidumpThreadNameList for GetThreadNameByID";
+    return false;
+  }
+
+  IDToIndexMap::const_iterator iterator = id_to_index_map_.find(thread_id);
+  if (iterator == id_to_index_map_.end())
+    return false;
+
+  if (thread_name)
+    *thread_name = thread_names_[iterator->second];
+  return true;
+}
+
+
+void MinidumpThreadNameList::Print() {
+  if (!valid_) {
+    BPLOG(ERROR) << "MinidumpThreadNameList cannot print invalid data";
+    return;
+  }
+
+  printf("MinidumpThreadNameList\n");
+  printf("  thread_name_count = %d\n", thread_name_count_);
+  printf("\n");
+
+  for (unsigned int name_index = 0;
+       name_index < thread_name_count_;
+       ++name_index) {
+    printf("thread_name[%d]\n", name_index);
+    printf("  thread_id   = 0x%x\n", thread_ids_[name_index]);
+    printf("  thread_name = \"%s\"\n", thread_names_[name_index].c_str());
+    printf("\n");
+  }
+}
+
+
 //
 // MinidumpModule
 //
@@ -2959,7 +3223,7 @@ uint32_t MinidumpMemoryList::max_regions_ = 4096;
 
 MinidumpMemoryList::MinidumpMemoryList(Minidump* minidump)
     : MinidumpStream(minidump),
-      range_map_(new RangeMap<uint64_t, unsigned int>()),
+      range_map_(new FlatRangeMap<uint64_t, unsigned int>()),
       descriptors_(NULL),
       regions_(NULL),
       region_count_(0) {
@@ -3077,6 +3341,11 @@ bool MinidumpMemoryList::Read(uint32_t expected_size) {
       (*regions)[region_index].SetDescriptor(descriptor);
     }
 
+    if (!range_map_->Finalize()) {
+      BPLOG(ERROR) << "MinidumpMemoryList has overlapping memory regions";
+      return false;
+    }
+
     descriptors_ = descriptors.release();
     regions_ = regions.release();
   }
@@ -3114,7 +3383,7 @@ MinidumpMemoryRegion* MinidumpMemoryList::GetMemoryRegionForAddress(
 
   unsigned int region_index;
   if (!range_map_->RetrieveRange(address, &region_index, NULL /* base */,
-                                 NULL /* delta */, NULL /* size */)) {
+                                 NULL /* size */)) {
     BPLOG(INFO) << "MinidumpMemoryList has no memory region at " <<
                    HexString(address);
     return NULL;
@@ -3124,6 +3393,24 @@ MinidumpMemoryRegion* MinidumpMemoryList::GetMemoryRegionForAddress(
 }
 
 
+MinidumpMemoryRegion* MinidumpMemoryList::GetMemoryRegionAtOrAfterAddress(
+    uint64_t address) {
+  if (!valid_) {
+    BPLOG(ERROR) << "Invalid MinidumpMemoryList for "
+                    "GetMemoryRegionAtOrAfterAddress";
+    return NULL;
+  }
+
+  unsigned int region_index;
+  if (!range_map_->RetrieveRangeAtOrAfter(address, &region_index,
+                                          NULL /* base */, NULL /* size */)) {
+    return NULL;
+  }
+
+  return GetMemoryRegionAtIndex(region_index);
+}
+
+
 void MinidumpMemoryList::Print() {
   if (!valid_) {
     BPLOG(ERROR) << "MinidumpMemoryList cannot print invalid data";
@@ -3156,6 +3443,293 @@ void MinidumpMemoryList::Print() {
 }
 
 
+//
+// MinidumpMemory64List
+//
+
+
+uint32_t MinidumpMemory64List::max_regions_ = 65536;
+
+
+MinidumpMemory64List::MinidumpMemory64List(Minidump* minidump)
+    : MinidumpStream(minidump),
+      range_map_(new FlatRangeMap<uint64_t, unsigned int>()),
+      descriptors_(NULL),
+      locations_(NULL),
+      regions_(NULL),
+      region_count_(0) {
+}
+
+
+MinidumpMemory64List::~MinidumpMemory64List() {
+  delete range_map_;
+  delete descriptors_;
+  delete locations_;
+  delete regions_;
+}
+
+
+bool MinidumpMemory64List::Read(uint32_t expected_size) {
+  // Invalidate cached data.
+  delete descriptors_;
+  descriptors_ = NULL;
+  delete locations_;
+  locations_ = NULL;
+  delete regions_;
+  regions_ = NULL;
+  range_map_->Clear();
+  region_count_ = 0;
+
+  valid_ = false;
+
+  if (expected_size < MDRawMemory64List_minsize) {
+    BPLOG(ERROR) << "MinidumpMemory64List header size mismatch, " <<
+                    expected_size << " < " << MDRawMemory64List_minsize;
+    return false;
+  }
+
+  uint64_t range_count;
+  MDRVA64 base_rva;
+  if (!minidump_->ReadBytes(&range_count, sizeof(range_count)) ||
+      !minidump_->ReadBytes(&base_rva, sizeof(base_rva))) {
+    BPLOG(ERROR) << "MinidumpMemory64List could not read header";
+    return false;
+  }
+
+  if (minidump_->swap()) {
+    Swap(&range_count);
+    Swap(&base_rva);
+  }
+
+  if (range_count > max_regions_) {
+    BPLOG(ERROR) << "MinidumpMemory64List count " << range_count <<
+                    " exceeds maximum " << max_regions_;
+    return false;
+  }
+
+  // range_count is now small enough that this can't overflow.
+  if (expected_size != MDRawMemory64List_minsize +
+                       range_count * sizeof(MDMemoryDescriptor64)) {
+    BPLOG(ERROR) << "MinidumpMemory64List size mismatch, " << expected_size <<
+                    " != " << MDRawMemory64List_minsize +
+                    range_count * sizeof(MDMemoryDescriptor64);
+    return false;
+  }
+
+  if (range_count != 0) {
+    // Read the entire array in one fell swoop, instead of reading one entry
+    // at a time in the loop.
+    vector<MDMemoryDescriptor64> ranges(range_count);
+    if (!minidump_->ReadBytes(&ranges[0],
+                              sizeof(MDMemoryDescriptor64) * range_count)) {
+      BPLOG(ERROR) << "MinidumpMemory64List could not read memory range list";
+      return false;
+    }
+
+    // Every range's contents must lie within the minidump.  This is checked
+    // before any range is split, so that a bogus size can't make the split
+    // produce an enormous number of regions.  A minidump still arriving
+    // from a data source has no size yet; its ranges are checked when
+    // their contents are read, and only a range large enough to be split
+    // waits for the size.
+    uint64_t file_size = 0;
+    bool have_file_size = minidump_->GetFileSizeIfKnown(&file_size);
+
+    scoped_ptr<MemoryDescriptors> descriptors(new MemoryDescriptors());
+    scoped_ptr<MemoryLocations> locations(new MemoryLocations());
+    descriptors->reserve(range_count);
+    locations->reserve(range_count);
+
+    // The contents of each range follow those of the one before it, so a
+    // range's location is base_rva plus the sizes of the ranges before it.
+    // Ranges too large for a MinidumpMemoryRegion are split.
+    const uint32_t kMaxRegionSize = 0x80000000;
+    uint64_t location = base_rva;
+    for (uint64_t range_index = 0; range_index < range_count; ++range_index) {
+      MDMemoryDescriptor64* range = &ranges[range_index];
+
+      if (minidump_->swap())
+        Swap(range);
+
+      // Check for base + size and location + size overflow.
+      if (range->data_size >
+              numeric_limits<uint64_t>::max() - range->start_of_memory_range ||
+          range->data_size >
+              static_cast<uint64_t>(numeric_limits<off_t>::max()) -
+              location) {
+        BPLOG(ERROR) << "MinidumpMemory64List has a memory range problem, " <<
+                        " range " << range_index << "/" << range_count <<
+                        ", " << HexString(range->start_of_memory_range) <<
+                        "+" << HexString(range->data_size) << " at " <<
+                        HexString(location);
+        return false;
+      }
+
+      if (!have_file_size && range->data_size > kMaxRegionSize) {
+        if (!minidump_->GetFileSize(&file_size)) {
+          BPLOG(ERROR) << "MinidumpMemory64List could not determine the " <<
+                          "minidump size";
+          return false;
+        }
+        have_file_size = true;
+      }
+
+      if (have_file_size &&
+          (location > file_size || range->data_size > file_size - location)) {
+        BPLOG(ERROR) << "MinidumpMemory64List range " << range_index << "/" <<
+                        range_count << ", " <<
+                        HexString(range->start_of_memory_range) << "+" <<
+                        HexString(range->data_size) << " at " <<
+                        HexString(location) << " lies outside the minidump " <<
+                        "of " << file_size << " bytes";
+        return false;
+      }
+
+      uint64_t offset = 0;
+      while (offset < range->data_size) {
+        uint32_t size = static_cast<uint32_t>(
+            std::min<uint64_t>(range->data_size - offset, kMaxRegionSize));
+        MDMemoryDescriptor descriptor = {};
+        descriptor.start_of_memory_range =
+            range->start_of_memory_range + offset;
+        descriptor.memory.data_size = size;
+        descriptors->push_back(descriptor);
+        locations->push_back(static_cast<off_t>(location + offset));
+        offset += size;
+      }
+
+      location += range->data_size;
+    }
+
+    if (descriptors->size() > numeric_limits<uint32_t>::max()) {
+      BPLOG(ERROR) << "MinidumpMemory64List has too many regions";
+      return false;
+    }
+
+    scoped_ptr<MemoryRegions> regions(
+        new MemoryRegions(descriptors->size(), MinidumpMemoryRegion(minidump_)));
+
+    for (unsigned int region_index = 0;
+         region_index < descriptors->size();
+         ++region_index) {
+      MDMemoryDescriptor* descriptor = &(*descriptors)[region_index];
+      if (!range_map_->StoreRange(descriptor->start_of_memory_range,
+                                  descriptor->memory.data_size,
+                                  region_index)) {
+        BPLOG(ERROR) << "MinidumpMemory64List could not store memory region " <<
+                        region_index << "/" << descriptors->size() << ", " <<
+                        HexString(descriptor->start_of_memory_range) << "+" <<
+                        HexString(descriptor->memory.data_size);
+        return false;
+      }
+
+      (*regions)[region_index].SetDescriptor(descriptor,
+                                             (*locations)[region_index]);
+    }
+
+    if (!range_map_->Finalize()) {
+      BPLOG(ERROR) << "MinidumpMemory64List has overlapping memory regions";
+      return false;
+    }
+
+    region_count_ = static_cast<uint32_t>(descriptors->size());
+    descriptors_ = descriptors.release();
+    locations_ = locations.release();
+    regions_ = regions.release();
+  }
+
+  valid_ = true;
+  return true;
+}
+
+
+MinidumpMemoryRegion* MinidumpMemory64List::GetMemoryRegionAtIndex(
+      unsigned int index) {
+  if (!valid_) {
+    BPLOG(ERROR) << "Invalid MinidumpMemory64List for GetMemoryRegionAtIndex";
+    return NULL;
+  }
+
+  if (index >= region_count_) {
+    BPLOG(ERROR) << "MinidumpMemory64List index out of range: " <<
+                    index << "/" << region_count_;
+    return NULL;
+  }
+
+  return &(*regions_)[index];
+}
+
+
+MinidumpMemoryRegion* MinidumpMemory64List::GetMemoryRegionForAddress(
+    uint64_t address) {
+  if (!valid_) {
+    BPLOG(ERROR) << "Invalid MinidumpMemory64List for "
+                    "GetMemoryRegionForAddress";
+    return NULL;
+  }
+
+  unsigned int region_index;
+  if (!range_map_->RetrieveRange(address, &region_index, NULL /* base */,
+                                 NULL /* size */)) {
+    BPLOG(INFO) << "MinidumpMemory64List has no memory region at " <<
+                   HexString(address);
+    return NULL;
+  }
+
+  return GetMemoryRegionAtIndex(region_index);
+}
+
+
+MinidumpMemoryRegion* MinidumpMemory64List::GetMemoryRegionAtOrAfterAddress(
+    uint64_t address) {
+  if (!valid_) {
+    BPLOG(ERROR) << "Invalid MinidumpMemory64List for "
+                    "GetMemoryRegionAtOrAfterAddress";
+    return NULL;
+  }
+
+  unsigned int region_index;
+  if (!range_map_->RetrieveRangeAtOrAfter(address, &region_index,
+                                          NULL /* base */, NULL /* size */)) {
+    return NULL;
+  }
+
+  return GetMemoryRegionAtIndex(region_index);
+}
+
+
+void MinidumpMemory64List::Print() {
+  if (!valid_) {
+    BPLOG(ERROR) << "MinidumpMemory64List cannot print invalid data";
+    return;
+  }
+
+  printf("MinidumpMemory64List\n");
+  printf("  region_count = %d\n", region_count_);
+  printf("\n");
+
+  for (unsigned int region_index = 0;
+       region_index < region_count_;
+       ++region_index) {
+    MDMemoryDescriptor* descriptor = &(*descriptors_)[region_index];
+    printf("region[%d]\n", region_index);
+    printf("  start_of_memory_range = 0x%" PRIx64 "\n",
+           descriptor->start_of_memory_range);
+    printf("  data_size             = 0x%x\n", descriptor->memory.data_size);
+    printf("  location              = 0x%" PRIx64 "\n",
+           static_cast<uint64_t>((*locations_)[region_index]));
+    MinidumpMemoryRegion* region = GetMemoryRegionAtIndex(region_index);
+    if (region) {
+      printf("Memory\n");
+      region->Print();
+    } else {
+      printf("No memory\n");
+    }
+    printf("\n");
+  }
+}
+
+
 //
 // MinidumpException
 //
@@ -5036,6 +5610,11 @@ Minidump::Minidump(const string& path, bool hexdump, unsigned int hexdump_width)
       stream_map_(new MinidumpStreamMap()),
       path_(path),
       stream_(NULL),
+      source_(NULL),
+      source_position_(0),
+      mapped_data_(NULL),
+      mapped_size_(0),
+      mapped_position_(0),
       swap_(false),
       is_big_endian_(false),
       valid_(false),
@@ -5049,6 +5628,29 @@ Minidump::Minidump(istream& stream)
       stream_map_(new MinidumpStreamMap()),
       path_(),
       stream_(&stream),
+      source_(NULL),
+      source_position_(0),
+      mapped_data_(NULL),
+      mapped_size_(0),
+      mapped_position_(0),
+      swap_(false),
+      is_big_endian_(false),
+      valid_(false),
+      hexdump_(false),
+      hexdump_width_(0) {
+}
+
+Minidump::Minidump(MinidumpDataSource* source)
+    : header_(),
+      directory_(NULL),
+      stream_map_(new MinidumpStreamMap()),
+      path_(),
+      stream_(NULL),
+      source_(source),
+      source_position_(0),
+      mapped_data_(NULL),
+      mapped_size_(0),
+      mapped_position_(0),
       swap_(false),
       is_big_endian_(false),
       valid_(false),
@@ -5057,19 +5659,20 @@ Minidump::Minidump(istream& stream)
 }
 
 Minidump::~Minidump() {
-  if (stream_) {
+  if (stream_ || source_ || mapped_data_) {
     BPLOG(INFO) << "Minidump closing minidump";
   }
   if (!path_.empty()) {
     delete stream_;
   }
+  UnmapFile();
   delete directory_;
   delete stream_map_;
 }
 
 
 bool Minidump::Open() {
-  if (stream_ != NULL) {
+  if (stream_ != NULL || source_ != NULL || mapped_data_ != NULL) {
     BPLOG(INFO) << "Minidump reopening minidump " << path_;
 
     // The file is already open.  Seek to the beginning, which is the position
@@ -5077,6 +5680,11 @@ bool Minidump::Open() {
     return SeekSet(0);
   }
 
+  if (MapFile()) {
+    BPLOG(INFO) << "Minidump mapped minidump " << path_;
+    return true;
+  }
+
   stream_ = new ifstream(path_.c_str(), std::ios::in | std::ios::binary);
   if (!stream_ || !stream_->good()) {
     string error_string;
@@ -5090,6 +5698,45 @@ bool Minidump::Open() {
   return true;
 }
 
+bool Minidump::MapFile() {
+#ifdef _WIN32
+  return false;
+#else  // _WIN32
+  int fd = open(path_.c_str(), O_RDONLY);
+  if (fd == -1)
+    return false;
+
+  // Only regular files can be mapped, and an empty one can't be, but it
+  // isn't a minidump anyway; reading it through a stream reports that.
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 ||
+      static_cast<uint64_t>(st.st_size) > numeric_limits<size_t>::max()) {
+    close(fd);
+    return false;
+  }
+
+  void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return false;
+
+  mapped_data_ = static_cast<const uint8_t*>(data);
+  mapped_size_ = st.st_size;
+  mapped_position_ = 0;
+  return true;
+#endif  // _WIN32
+}
+
+void Minidump::UnmapFile() {
+#ifndef _WIN32
+  if (mapped_data_) {
+    munmap(const_cast<uint8_t*>(mapped_data_), mapped_size_);
+    mapped_data_ = NULL;
+    mapped_size_ = 0;
+  }
+#endif  // _WIN32
+}
+
 bool Minidump::GetContextCPUFlagsFromSystemInfo(uint32_t *context_cpu_flags) {
   // Initialize output parameters
   *context_cpu_flags = 0;
@@ -5278,6 +5925,8 @@ bool Minidump::Read() {
         case MD_THREAD_LIST_STREAM:
         case MD_MODULE_LIST_STREAM:
         case MD_MEMORY_LIST_STREAM:
+        case MD_MEMORY_64_LIST_STREAM:
+        case MD_THREAD_NAME_LIST_STREAM:
         case MD_EXCEPTION_STREAM:
         case MD_SYSTEM_INFO_STREAM:
         case MD_MISC_INFO_STREAM:
@@ -5315,6 +5964,12 @@ MinidumpThreadList* Minidump::GetThreadList() {
 }
 
 
+MinidumpThreadNameList* Minidump::GetThreadNameList() {
+  MinidumpThreadNameList* thread_name_list;
+  return GetStream(&thread_name_list);
+}
+
+
 MinidumpModuleList* Minidump::GetModuleList() {
   MinidumpModuleList* module_list;
   return GetStream(&module_list);
@@ -5327,6 +5982,12 @@ MinidumpMemoryList* Minidump::GetMemoryList() {
 }
 
 
+MinidumpMemory64List* Minidump::GetMemory64List() {
+  MinidumpMemory64List* memory64_list;
+  return GetStream(&memory64_list);
+}
+
+
 MinidumpException* Minidump::GetException() {
   MinidumpException* exception;
   return GetStream(&exception);
@@ -5451,6 +6112,8 @@ static const char* get_stream_name(uint32_t stream_type) {
     return "MD_SYSTEM_MEMORY_INFO_STREAM";
   case MD_PROCESS_VM_COUNTERS_STREAM:
     return "MD_PROCESS_VM_COUNTERS_STREAM";
+  case MD_THREAD_NAME_LIST_STREAM:
+    return "MD_THREAD_NAME_LIST_STREAM";
   case MD_LAST_RESERVED_STREAM:
     return "MD_LAST_RESERVED_STREAM";
   case MD_BREAKPAD_INFO_STREAM:
@@ -5547,6 +6210,26 @@ const MDRawDirectory* Minidump::GetDirectoryEntryAtIndex(unsigned int index)
 bool Minidump::ReadBytes(void* bytes, size_t count) {
   // Can't check valid_ because Read needs to call this method before
   // validity can be determined.
+  if (mapped_data_) {
+    const uint8_t* data = GetMappedBytes(mapped_position_, count);
+    if (!data) {
+      BPLOG(ERROR) << "ReadBytes: read past end of minidump at " <<
+                      mapped_position_ << "+" << count << "/" << mapped_size_;
+      return false;
+    }
+    memcpy(bytes, data, count);
+    mapped_position_ += count;
+    return true;
+  }
+  if (source_) {
+    if (!source_->Read(source_position_, bytes, count)) {
+      BPLOG(ERROR) << "ReadBytes: could not read " << source_position_ <<
+                      "+" << count << " from data source";
+      return false;
+    }
+    source_position_ += count;
+    return true;
+  }
   if (!stream_) {
     return false;
   }
@@ -5579,6 +6262,24 @@ bool Minidump::ReadBytes(void* bytes, size_t count) {
 bool Minidump::SeekSet(off_t offset) {
   // Can't check valid_ because Read needs to call this method before
   // validity can be determined.
+  if (mapped_data_) {
+    // As with a stream, seeking past the end succeeds, but reading there
+    // won't.
+    if (offset < 0) {
+      BPLOG(ERROR) << "SeekSet: negative offset " << offset;
+      return false;
+    }
+    mapped_position_ = offset;
+    return true;
+  }
+  if (source_) {
+    if (offset < 0) {
+      BPLOG(ERROR) << "SeekSet: negative offset " << offset;
+      return false;
+    }
+    source_position_ = offset;
+    return true;
+  }
   if (!stream_) {
     return false;
   }
@@ -5593,6 +6294,12 @@ bool Minidump::SeekSet(off_t offset) {
 }
 
 off_t Minidump::Tell() {
+  if (valid_ && mapped_data_) {
+    return mapped_position_;
+  }
+  if (valid_ && source_) {
+    return source_position_;
+  }
   if (!valid_ || !stream_) {
     return (off_t)-1;
   }
@@ -5608,6 +6315,50 @@ off_t Minidump::Tell() {
   }
 }
 
+bool Minidump::GetFileSize(uint64_t* size) {
+  // Can't check valid_, so that this may be used before Read.
+  if (mapped_data_) {
+    *size = mapped_size_;
+    return true;
+  }
+  if (source_) {
+    return source_->GetSize(size);
+  }
+  if (!stream_) {
+    return false;
+  }
+
+  std::streampos position = stream_->tellg();
+  stream_->seekg(0, std::ios_base::end);
+  std::streampos end = stream_->tellg();
+  stream_->seekg(position);
+  if (position == std::streampos(-1) || end == std::streampos(-1) ||
+      !stream_->good()) {
+    BPLOG(ERROR) << "GetFileSize: could not determine the minidump size";
+    return false;
+  }
+  *size = static_cast<uint64_t>(static_cast<std::streamoff>(end));
+  return true;
+}
+
+bool Minidump::GetFileSizeIfKnown(uint64_t* size) {
+  if (source_) {
+    return source_->GetSizeIfKnown(size);
+  }
+  return GetFileSize(size);
+}
+
+
+const uint8_t* Minidump::GetMappedBytes(off_t offset, size_t count) const {
+  if (!mapped_data_ || offset < 0 ||
+      static_cast<uint64_t>(offset) > mapped_size_ ||
+      count > mapped_size_ - static_cast<size_t>(offset)) {
+    return NULL;
+  }
+  return mapped_data_ + offset;
+}
+
+
 
 string* Minidump::ReadString(off_t offset) {
   if (!valid_) {
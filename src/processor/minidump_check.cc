@@ -0,0 +1,106 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// minidump_check.cc: Check that minidump files are structurally sound
+// before they are processed.
+//
+// See minidump_validator.h for what is checked.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "google_breakpad/processor/minidump.h"
+#include "google_breakpad/processor/minidump_validator.h"
+#include "processor/logging.h"
+
+namespace {
+
+using google_breakpad::Minidump;
+using google_breakpad::MinidumpValidator;
+
+static void Usage(int argc, char *argv[], bool error) {
+  fprintf(error ? stderr : stdout,
+          "Usage: %s [options...] <minidump> [<minidump>...]\n"
+          "Check that minidumps are well-formed.\n"
+          "\n"
+          "Prints the problem found in each malformed minidump, and exits\n"
+          "with status 1 if any minidump is malformed.\n"
+          "\n"
+          "Options:\n"
+          "  -q:\t Don't print anything for well-formed minidumps\n"
+          "  -h:\t Usage\n",
+          argv[0]);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  BPLOG_INIT(&argc, &argv);
+
+  bool quiet = false;
+  int ch;
+  while ((ch = getopt(argc, argv, "qh")) != -1) {
+    switch (ch) {
+      case 'q':
+        quiet = true;
+        break;
+
+      case 'h':
+        Usage(argc, argv, false);
+        exit(0);
+
+      default:
+        Usage(argc, argv, true);
+        exit(1);
+    }
+  }
+
+  if (optind >= argc) {
+    Usage(argc, argv, true);
+    return 1;
+  }
+
+  int malformed = 0;
+  MinidumpValidator validator;
+  for (int index = optind; index < argc; ++index) {
+    Minidump dump(argv[index]);
+    MinidumpValidator::Result result = validator.Validate(&dump);
+    if (result != MinidumpValidator::VALID) {
+      ++malformed;
+      printf("%s: %s: %s\n", argv[index],
+             MinidumpValidator::ResultString(result),
+             validator.error().c_str());
+    } else if (!quiet) {
+      printf("%s: OK\n", argv[index]);
+    }
+  }
+
+  return malformed == 0 ? 0 : 1;
+}
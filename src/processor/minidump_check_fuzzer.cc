@@ -0,0 +1,95 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// minidump_check_fuzzer.cc: A libFuzzer harness for MinidumpValidator.
+//
+// Each input is validated as a minidump.  Inputs that MinidumpValidator
+// accepts are then read the way MinidumpProcessor reads them, so that the
+// fuzzer also reaches the stream readers with well-formed dumps.  Build it
+// against libbreakpad.a with a compiler that supports libFuzzer, for
+// example:
+//
+//   clang++ -g -O1 -fsanitize=fuzzer,address -I src \
+//     src/processor/minidump_check_fuzzer.cc src/libbreakpad.a \
+//     -o minidump_check_fuzzer
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <sstream>
+#include <string>
+
+#include "google_breakpad/processor/minidump.h"
+#include "google_breakpad/processor/minidump_validator.h"
+
+using google_breakpad::Minidump;
+using google_breakpad::MinidumpMemoryList;
+using google_breakpad::MinidumpMemory64List;
+using google_breakpad::MinidumpModuleList;
+using google_breakpad::MinidumpThread;
+using google_breakpad::MinidumpThreadList;
+using google_breakpad::MinidumpValidator;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  std::istringstream input(
+      std::string(reinterpret_cast<const char*>(data), size));
+  Minidump dump(input);
+  MinidumpValidator validator;
+  if (validator.Validate(&dump) != MinidumpValidator::VALID)
+    return 0;
+
+  MinidumpModuleList *modules = dump.GetModuleList();
+  if (modules) {
+    for (unsigned int i = 0; i < modules->module_count(); ++i)
+      modules->GetModuleAtSequence(i);
+  }
+  MinidumpMemoryList *memory = dump.GetMemoryList();
+  MinidumpMemory64List *memory64 = dump.GetMemory64List();
+  dump.GetThreadNameList();
+  dump.GetException();
+  dump.GetSystemInfo();
+
+  MinidumpThreadList *threads = dump.GetThreadList();
+  if (threads) {
+    for (unsigned int i = 0; i < threads->thread_count(); ++i) {
+      MinidumpThread *thread = threads->GetThreadAtIndex(i);
+      if (!thread)
+        continue;
+      thread->GetContext();
+      if (!thread->GetMemory()) {
+        uint64_t stack = thread->GetStartOfStackMemoryRange();
+        if (memory)
+          memory->GetMemoryRegionForAddress(stack);
+        if (memory64)
+          memory64->GetMemoryRegionForAddress(stack);
+      }
+    }
+  }
+  return 0;
+}
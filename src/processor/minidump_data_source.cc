@@ -0,0 +1,162 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// minidump_data_source.cc: A minidump's bytes, supplied as they arrive.
+//
+// See minidump_data_source.h for documentation.
+
+#include "google_breakpad/processor/minidump_data_source.h"
+
+#include <string.h>
+
+#include "google_breakpad/processor/process_deadline.h"
+#include "processor/logging.h"
+
+namespace google_breakpad {
+
+GrowingMinidumpDataSource::GrowingMinidumpDataSource()
+    : finished_(false),
+      aborted_(false),
+      deadline_(NULL) {
+}
+
+GrowingMinidumpDataSource::~GrowingMinidumpDataSource() {
+  if (deadline_)
+    deadline_->RemoveWaiter(&changed_);
+}
+
+void GrowingMinidumpDataSource::Append(const void* data, size_t size) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (finished_ || aborted_)
+      return;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    data_.insert(data_.end(), bytes, bytes + size);
+  }
+  changed_.notify_all();
+}
+
+void GrowingMinidumpDataSource::Finish() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (aborted_)
+      return;
+    finished_ = true;
+  }
+  changed_.notify_all();
+}
+
+void GrowingMinidumpDataSource::Abort() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (finished_)
+      return;
+    aborted_ = true;
+  }
+  changed_.notify_all();
+}
+
+uint64_t GrowingMinidumpDataSource::available() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return data_.size();
+}
+
+void GrowingMinidumpDataSource::set_deadline(
+    const ProcessDeadline* deadline) {
+  // Register with the new deadline before readers can see it, so that a
+  // Cancel() can't slip in between their check and their wait unnoticed.
+  if (deadline)
+    deadline->AddWaiter(&mutex_, &changed_);
+  const ProcessDeadline* old_deadline;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    old_deadline = deadline_;
+    deadline_ = deadline;
+  }
+  if (old_deadline)
+    old_deadline->RemoveWaiter(&changed_);
+  // Let waiting readers pick up the new deadline.
+  changed_.notify_all();
+}
+
+bool GrowingMinidumpDataSource::Read(uint64_t offset, void* buffer,
+                                     size_t count) {
+  // Written so as not to overflow, however large offset and count are.
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (offset > data_.size() || count > data_.size() - offset) {
+    if (finished_ || aborted_ || !WaitForChange(&lock))
+      return false;
+  }
+  if (count)
+    memcpy(buffer, &data_[offset], count);
+  return true;
+}
+
+bool GrowingMinidumpDataSource::GetSize(uint64_t* size) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!finished_) {
+    if (aborted_ || !WaitForChange(&lock))
+      return false;
+  }
+  *size = data_.size();
+  return true;
+}
+
+bool GrowingMinidumpDataSource::GetSizeIfKnown(uint64_t* size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!finished_)
+    return false;
+  *size = data_.size();
+  return true;
+}
+
+bool GrowingMinidumpDataSource::WaitForChange(
+    std::unique_lock<std::mutex>* lock) {
+  if (!deadline_) {
+    changed_.wait(*lock);
+    return true;
+  }
+
+  if (deadline_->Passed()) {
+    BPLOG(ERROR) << "GrowingMinidumpDataSource stopped waiting for data: " <<
+                    (deadline_->Check() == CALL_STACK_CANCELLED ?
+                     "cancelled" : "deadline passed");
+    return false;
+  }
+
+  // Cancel() signals changed_, with mutex_ held, so the check above can't
+  // miss it.
+  if (deadline_->expiry() == ProcessDeadline::Clock::time_point::max())
+    changed_.wait(*lock);
+  else
+    changed_.wait_until(*lock, deadline_->expiry());
+  return true;
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,319 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// minidump_data_source_unittest.cc: Unit tests for
+// GrowingMinidumpDataSource, and for reading a Minidump from it.
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "breakpad_googletest_includes.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/minidump.h"
+#include "google_breakpad/processor/minidump_data_source.h"
+#include "google_breakpad/processor/process_deadline.h"
+#include "processor/synth_minidump.h"
+
+namespace {
+
+using google_breakpad::GrowingMinidumpDataSource;
+using google_breakpad::Minidump;
+using google_breakpad::MinidumpMemory64List;
+using google_breakpad::MinidumpMemoryRegion;
+using google_breakpad::MinidumpModule;
+using google_breakpad::MinidumpModuleList;
+using google_breakpad::ProcessDeadline;
+using google_breakpad::SynthMinidump::Dump;
+using google_breakpad::SynthMinidump::Module;
+using google_breakpad::SynthMinidump::Stream;
+using google_breakpad::SynthMinidump::String;
+using google_breakpad::test_assembler::Label;
+using google_breakpad::test_assembler::kLittleEndian;
+
+TEST(GrowingMinidumpDataSource, ReadAvailable) {
+  GrowingMinidumpDataSource source;
+  source.Append("abcdef", 6);
+  EXPECT_EQ(6U, source.available());
+
+  char buffer[4] = {};
+  ASSERT_TRUE(source.Read(2, buffer, 3));
+  EXPECT_EQ(string("cde"), string(buffer, 3));
+  ASSERT_TRUE(source.Read(6, buffer, 0));
+}
+
+TEST(GrowingMinidumpDataSource, ReadWaitsForData) {
+  GrowingMinidumpDataSource source;
+  source.Append("abc", 3);
+
+  char buffer[4] = {};
+  bool read = false;
+  std::thread reader([&]() { read = source.Read(1, buffer, 4); });
+  source.Append("de", 2);
+  source.Append("fg", 2);
+  reader.join();
+  ASSERT_TRUE(read);
+  EXPECT_EQ(string("bcde"), string(buffer, 4));
+}
+
+TEST(GrowingMinidumpDataSource, Finish) {
+  GrowingMinidumpDataSource source;
+  source.Append("abc", 3);
+
+  char buffer[4];
+  bool read = true;
+  std::thread reader([&]() { read = source.Read(2, buffer, 2); });
+  source.Finish();
+  reader.join();
+  EXPECT_FALSE(read);
+
+  // Nothing may be appended once the data is complete.
+  source.Append("d", 1);
+  EXPECT_EQ(3U, source.available());
+  EXPECT_FALSE(source.Read(2, buffer, 2));
+  EXPECT_FALSE(source.Read(~0ULL, buffer, 2));
+
+  uint64_t size = 0;
+  ASSERT_TRUE(source.GetSize(&size));
+  EXPECT_EQ(3U, size);
+}
+
+TEST(GrowingMinidumpDataSource, GetSizeIfKnown) {
+  GrowingMinidumpDataSource source;
+  source.Append("abc", 3);
+
+  // The size isn't known until Finish, but asking doesn't wait for it.
+  uint64_t size = 0;
+  EXPECT_FALSE(source.GetSizeIfKnown(&size));
+  source.Append("d", 1);
+  source.Finish();
+  ASSERT_TRUE(source.GetSizeIfKnown(&size));
+  EXPECT_EQ(4U, size);
+}
+
+TEST(GrowingMinidumpDataSource, Abort) {
+  GrowingMinidumpDataSource source;
+  source.Append("abc", 3);
+
+  uint64_t size;
+  bool got_size = true;
+  std::thread waiter([&]() { got_size = source.GetSize(&size); });
+  source.Abort();
+  waiter.join();
+  EXPECT_FALSE(got_size);
+
+  // The bytes that arrived can still be read.
+  char buffer[3];
+  EXPECT_TRUE(source.Read(0, buffer, 3));
+  EXPECT_FALSE(source.Read(0, buffer, 4));
+}
+
+TEST(GrowingMinidumpDataSource, Deadline) {
+  GrowingMinidumpDataSource source;
+  source.Append("abc", 3);
+  ProcessDeadline deadline(std::chrono::milliseconds(20));
+  source.set_deadline(&deadline);
+
+  // Neither Finish nor Abort is ever called, but the waits end when the
+  // deadline passes.
+  char buffer[4];
+  EXPECT_FALSE(source.Read(0, buffer, 4));
+  EXPECT_TRUE(deadline.Passed());
+  uint64_t size;
+  EXPECT_FALSE(source.GetSize(&size));
+
+  // The bytes that arrived can still be read.
+  EXPECT_TRUE(source.Read(0, buffer, 3));
+}
+
+TEST(GrowingMinidumpDataSource, Cancel) {
+  GrowingMinidumpDataSource source;
+  source.Append("abc", 3);
+  ProcessDeadline deadline;
+  source.set_deadline(&deadline);
+
+  char buffer[4];
+  bool read = true;
+  std::thread reader([&]() { read = source.Read(0, buffer, 4); });
+  deadline.Cancel();
+  reader.join();
+  EXPECT_FALSE(read);
+}
+
+TEST(GrowingMinidumpDataSource, CancelBeforeExpiry) {
+  GrowingMinidumpDataSource source;
+  source.Append("abc", 3);
+  ProcessDeadline deadline(std::chrono::hours(1));
+  source.set_deadline(&deadline);
+
+  // Cancelling wakes the waiting readers at once, long before the
+  // deadline would pass.
+  ProcessDeadline::Clock::time_point start = ProcessDeadline::Clock::now();
+  uint64_t size;
+  bool got_size = true;
+  std::thread waiter([&]() { got_size = source.GetSize(&size); });
+  char buffer[4];
+  bool read = true;
+  std::thread reader([&]() { read = source.Read(0, buffer, 4); });
+  deadline.Cancel();
+  waiter.join();
+  reader.join();
+  EXPECT_FALSE(got_size);
+  EXPECT_FALSE(read);
+  EXPECT_LT(ProcessDeadline::Clock::now() - start, std::chrono::minutes(1));
+}
+
+class MinidumpFromDataSourceTest : public ::testing::Test {
+ public:
+  // Sets contents_ to a minidump holding a module list, followed by
+  // trailing_size bytes that no stream refers to.
+  void MakeMinidump(size_t trailing_size) {
+    Dump dump(0, kLittleEndian);
+    String name(dump, "module name");
+    Module module(dump, 0x400000, 0x1000, name);
+    dump.Add(&name);
+    dump.Add(&module);
+    dump.Finish();
+    dump.Append(trailing_size, 0);
+    ASSERT_TRUE(dump.GetContents(&contents_));
+  }
+
+  // Checks that minidump holds the module list MakeMinidump wrote.
+  void CheckModuleList(Minidump* minidump) {
+    MinidumpModuleList* module_list = minidump->GetModuleList();
+    ASSERT_TRUE(module_list != NULL);
+    ASSERT_EQ(1U, module_list->module_count());
+    const MinidumpModule* module = module_list->GetModuleAtIndex(0);
+    ASSERT_TRUE(module != NULL);
+    EXPECT_EQ(0x400000U, module->base_address());
+    EXPECT_EQ("module name", module->code_file());
+  }
+
+  string contents_;
+};
+
+TEST_F(MinidumpFromDataSourceTest, ReadWhileArriving) {
+  MakeMinidump(0);
+  GrowingMinidumpDataSource source;
+  std::thread uploader([&]() {
+    for (size_t offset = 0; offset < contents_.size(); offset += 7) {
+      source.Append(contents_.data() + offset,
+                    std::min<size_t>(7, contents_.size() - offset));
+    }
+    source.Finish();
+  });
+
+  Minidump minidump(&source);
+  bool read = minidump.Read();
+  uploader.join();
+  ASSERT_TRUE(read);
+  CheckModuleList(&minidump);
+}
+
+TEST_F(MinidumpFromDataSourceTest, ReadBeforeComplete) {
+  const size_t kTrailingSize = 0x1000;
+  MakeMinidump(kTrailingSize);
+  size_t leading_size = contents_.size() - kTrailingSize;
+
+  // Everything the module list needs has arrived, but the rest of the
+  // minidump has not.
+  GrowingMinidumpDataSource source;
+  source.Append(contents_.data(), leading_size);
+  Minidump minidump(&source);
+  ASSERT_TRUE(minidump.Read());
+  CheckModuleList(&minidump);
+  EXPECT_EQ(leading_size, source.available());
+
+  std::thread uploader([&]() {
+    source.Append(contents_.data() + leading_size, kTrailingSize);
+    source.Finish();
+  });
+  uint64_t size = 0;
+  bool got_size = minidump.GetFileSize(&size);
+  uploader.join();
+  ASSERT_TRUE(got_size);
+  EXPECT_EQ(contents_.size(), size);
+}
+
+TEST_F(MinidumpFromDataSourceTest, Memory64ListBeforeComplete) {
+  Dump dump(0, kLittleEndian);
+  Stream stream(dump, MD_MEMORY_64_LIST_STREAM);
+  Label contents_rva;
+  stream.D64(1)                // number_of_memory_ranges
+        .D64(contents_rva)     // base_rva
+        .D64(0x1000)           // start_of_memory_range
+        .D64(16);              // data_size
+  dump.Add(&stream);
+  dump.Finish();
+  contents_rva = dump.Size();
+  dump.Append(16, 0xcc);
+  ASSERT_TRUE(dump.GetContents(&contents_));
+
+  // The memory list can be read without waiting for the memory contents,
+  // which follow the stream directory.  The deadline only limits how long a regression
+  // would hang.
+  GrowingMinidumpDataSource source;
+  source.Append(contents_.data(), contents_.size() - 16);
+  ProcessDeadline deadline(std::chrono::seconds(30));
+  source.set_deadline(&deadline);
+  Minidump minidump(&source);
+  ASSERT_TRUE(minidump.Read());
+  MinidumpMemory64List* memory_list = minidump.GetMemory64List();
+  ASSERT_TRUE(memory_list != NULL);
+  ASSERT_EQ(1U, memory_list->region_count());
+  MinidumpMemoryRegion* region = memory_list->GetMemoryRegionAtIndex(0);
+  ASSERT_TRUE(region != NULL);
+  EXPECT_EQ(0x1000U, region->GetBase());
+  EXPECT_EQ(16U, region->GetSize());
+  EXPECT_FALSE(deadline.Passed());
+}
+
+TEST_F(MinidumpFromDataSourceTest, Stalled) {
+  MakeMinidump(0);
+  GrowingMinidumpDataSource source;
+  source.Append(contents_.data(), contents_.size() / 2);
+  ProcessDeadline deadline(std::chrono::milliseconds(20));
+  source.set_deadline(&deadline);
+  Minidump minidump(&source);
+  EXPECT_FALSE(minidump.Read());
+}
+
+TEST_F(MinidumpFromDataSourceTest, Truncated) {
+  MakeMinidump(0);
+  GrowingMinidumpDataSource source;
+  source.Append(contents_.data(), contents_.size() / 2);
+  source.Finish();
+  Minidump minidump(&source);
+  EXPECT_FALSE(minidump.Read());
+}
+
+}  // namespace
@@ -44,9 +44,11 @@ namespace {
 
 using google_breakpad::Minidump;
 using google_breakpad::MinidumpThreadList;
+using google_breakpad::MinidumpThreadNameList;
 using google_breakpad::MinidumpModuleList;
 using google_breakpad::MinidumpMemoryInfoList;
 using google_breakpad::MinidumpMemoryList;
+using google_breakpad::MinidumpMemory64List;
 using google_breakpad::MinidumpException;
 using google_breakpad::MinidumpAssertion;
 using google_breakpad::MinidumpSystemInfo;
@@ -121,6 +123,13 @@ static bool PrintMinidumpDump(const Options& options) {
     thread_list->Print();
   }
 
+  MinidumpThreadNameList *thread_name_list = minidump.GetThreadNameList();
+  if (!thread_name_list) {
+    BPLOG(INFO) << "minidump.GetThreadNameList() failed";
+  } else {
+    thread_name_list->Print();
+  }
+
   // It's useful to be able to see the full list of modules here even if it
   // would cause minidump_stackwalk to fail.
   MinidumpModuleList::set_max_modules(UINT32_MAX);
@@ -140,6 +149,14 @@ static bool PrintMinidumpDump(const Options& options) {
     memory_list->Print();
   }
 
+  MinidumpMemory64List::set_max_regions(UINT32_MAX);
+  MinidumpMemory64List *memory64_list = minidump.GetMemory64List();
+  if (!memory64_list) {
+    BPLOG(INFO) << "minidump.GetMemory64List() failed";
+  } else {
+    memory64_list->Print();
+  }
+
   MinidumpException *exception = minidump.GetException();
   if (!exception) {
     BPLOG(INFO) << "minidump.GetException() failed";
@@ -32,15 +32,21 @@
 #include <assert.h>
 
 #include <algorithm>
+#include <atomic>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "common/scoped_ptr.h"
 #include "common/stdio_wrapper.h"
 #include "common/using_std_string.h"
 #include "google_breakpad/processor/call_stack.h"
+#include "google_breakpad/processor/code_modules.h"
 #include "google_breakpad/processor/minidump.h"
+#include "google_breakpad/processor/process_deadline.h"
 #include "google_breakpad/processor/process_state.h"
 #include "google_breakpad/processor/exploitability.h"
+#include "google_breakpad/processor/source_line_resolver_interface.h"
 #include "google_breakpad/processor/stack_frame_symbolizer.h"
 #include "processor/logging.h"
 #include "processor/stackwalker_x86.h"
@@ -48,12 +54,152 @@
 
 namespace google_breakpad {
 
+namespace {
+
+// Everything needed to walk the stack of a single thread.  These are
+// gathered from the Minidump, which is not thread-safe, before any stack is
+// walked, so that the walks themselves may run concurrently.
+struct ThreadWalk {
+  ThreadWalk() : thread_id(0), context(NULL), memory(NULL),
+                 thread_memory(NULL), stack(NULL), interrupted(false) {}
+
+  string thread_string;
+  uint32_t thread_id;
+  string thread_name;
+  DumpContext* context;
+  // The memory handed to the stackwalker.
+  MemoryRegion* memory;
+  // The thread's memory region, as recorded in the ProcessState.
+  MinidumpMemoryRegion* thread_memory;
+
+  // Results of the walk.  Ownership of |stack| passes to the ProcessState.
+  CallStack* stack;
+  vector<const CodeModule*> modules_without_symbols;
+  vector<const CodeModule*> modules_with_corrupt_symbols;
+  bool interrupted;
+};
+
+// Walks the stack described by |walk|.  The code modules are taken from
+// |process_state|, which is not modified.  The walk stops when |deadline|,
+// which may be NULL, passes; if it already has, the stack holds only the
+// unsymbolized context frame.
+void WalkThread(const ProcessState& process_state,
+                StackFrameSymbolizer* frame_symbolizer,
+                const ProcessDeadline* deadline,
+                ThreadWalk* walk) {
+  walk->stack = new CallStack();
+
+  // Use process_state.modules_ instead of module_list, because the
+  // |modules| argument will be used to populate the |module| fields in
+  // the returned StackFrame objects, which will be placed into the
+  // returned ProcessState object.  module_list's lifetime is only as
+  // long as the Minidump object: it will be deleted when Process()
+  // returns.  process_state.modules_ is owned by the ProcessState object
+  // (just like the StackFrame objects), and is much more suitable for
+  // this task.
+  scoped_ptr<Stackwalker> stackwalker(
+      Stackwalker::StackwalkerForCPU(process_state.system_info(),
+                                     walk->context,
+                                     walk->memory,
+                                     process_state.modules(),
+                                     process_state.unloaded_modules(),
+                                     frame_symbolizer));
+
+  if (stackwalker.get()) {
+    stackwalker->set_deadline(deadline);
+    if (!stackwalker->Walk(walk->stack,
+                           &walk->modules_without_symbols,
+                           &walk->modules_with_corrupt_symbols)) {
+      BPLOG(INFO) << "Stackwalker interrupt (missing symbols?) at "
+                  << walk->thread_string;
+      walk->interrupted = true;
+    }
+  } else {
+    // Threads with missing CPU contexts will hit this, but
+    // don't abort processing the rest of the dump just for
+    // one bad thread.
+    BPLOG(ERROR) << "No stackwalker for " << walk->thread_string;
+  }
+  walk->stack->set_tid(walk->thread_id);
+  walk->stack->set_thread_name(walk->thread_name);
+}
+
+// Walks all of |walks| using up to |thread_count| worker threads.  Each walk
+// writes only to its own ThreadWalk, so the order of |walks| is preserved
+// no matter which worker handles which thread.
+void WalkThreadsConcurrently(const ProcessState& process_state,
+                             StackFrameSymbolizer* frame_symbolizer,
+                             const ProcessDeadline* deadline,
+                             int thread_count,
+                             vector<ThreadWalk>* walks) {
+  std::atomic<size_t> next_walk(0);
+  vector<std::thread> workers;
+  size_t worker_count =
+      std::min(static_cast<size_t>(thread_count), walks->size());
+  for (size_t i = 0; i < worker_count; ++i) {
+    workers.push_back(std::thread([&]() {
+      for (size_t index = next_walk++; index < walks->size();
+           index = next_walk++) {
+        WalkThread(process_state, frame_symbolizer, deadline,
+                   &(*walks)[index]);
+      }
+    }));
+  }
+  for (size_t i = 0; i < workers.size(); ++i) {
+    workers[i].join();
+  }
+}
+
+// Pins the symbols of every module in |modules| in |resolver| for the
+// lifetime of the object, so that a resolver bounding its memory use does
+// not unload them while the dump's stacks are being walked.
+class ScopedModulePins {
+ public:
+  ScopedModulePins(SourceLineResolverInterface* resolver,
+                   const CodeModules* modules)
+      : resolver_(resolver) {
+    if (!resolver_ || !modules)
+      return;
+    for (unsigned int i = 0; i < modules->module_count(); ++i) {
+      const CodeModule* module = modules->GetModuleAtIndex(i);
+      resolver_->PinModule(module);
+      modules_.push_back(module);
+    }
+  }
+
+  ~ScopedModulePins() {
+    for (size_t i = 0; i < modules_.size(); ++i) {
+      resolver_->UnpinModule(modules_[i]);
+    }
+  }
+
+ private:
+  SourceLineResolverInterface* resolver_;
+  vector<const CodeModule*> modules_;
+
+  ScopedModulePins(const ScopedModulePins&);
+  void operator=(const ScopedModulePins&);
+};
+
+// Appends the modules in |from| that are not yet in |to|, preserving order.
+void MergeSpecialAttentionModules(const vector<const CodeModule*>& from,
+                                  vector<const CodeModule*>* to) {
+  for (size_t i = 0; i < from.size(); ++i) {
+    if (std::find(to->begin(), to->end(), from[i]) == to->end()) {
+      to->push_back(from[i]);
+    }
+  }
+}
+
+}  // namespace
+
 MinidumpProcessor::MinidumpProcessor(SymbolSupplier *supplier,
                                      SourceLineResolverInterface *resolver)
     : frame_symbolizer_(new StackFrameSymbolizer(supplier, resolver)),
       own_frame_symbolizer_(true),
       enable_exploitability_(false),
-      enable_objdump_(false) {
+      enable_objdump_(false),
+      stackwalk_threads_(1) {
 }
 
 MinidumpProcessor::MinidumpProcessor(SymbolSupplier *supplier,
@@ -62,7 +208,8 @@ MinidumpProcessor::MinidumpProcessor(SymbolSupplier *supplier,
     : frame_symbolizer_(new StackFrameSymbolizer(supplier, resolver)),
       own_frame_symbolizer_(true),
       enable_exploitability_(enable_exploitability),
-      enable_objdump_(false) {
+      enable_objdump_(false),
+      stackwalk_threads_(1) {
 }
 
 MinidumpProcessor::MinidumpProcessor(StackFrameSymbolizer *frame_symbolizer,
@@ -70,7 +217,8 @@ MinidumpProcessor::MinidumpProcessor(StackFrameSymbolizer *frame_symbolizer,
     : frame_symbolizer_(frame_symbolizer),
       own_frame_symbolizer_(false),
       enable_exploitability_(enable_exploitability),
-      enable_objdump_(false) {
+      enable_objdump_(false),
+      stackwalk_threads_(1) {
   assert(frame_symbolizer_);
 }
 
@@ -80,6 +228,12 @@ MinidumpProcessor::~MinidumpProcessor() {
 
 ProcessResult MinidumpProcessor::Process(
     Minidump *dump, ProcessState *process_state) {
+  return Process(dump, process_state, NULL);
+}
+
+ProcessResult MinidumpProcessor::Process(
+    Minidump *dump, ProcessState *process_state,
+    const ProcessDeadline *deadline) {
   assert(dump);
   assert(process_state);
 
@@ -163,10 +317,12 @@ ProcessResult MinidumpProcessor::Process(
     }
   }
 
-  MinidumpUnloadedModuleList *unloaded_module_list =
-      dump->GetUnloadedModuleList();
-  if (unloaded_module_list) {
-    process_state->unloaded_modules_ = unloaded_module_list->Copy();
+  if (process_options_.process_unloaded_modules) {
+    MinidumpUnloadedModuleList *unloaded_module_list =
+        dump->GetUnloadedModuleList();
+    if (unloaded_module_list) {
+      process_state->unloaded_modules_ = unloaded_module_list->Copy();
+    }
   }
 
   MinidumpMemoryList *memory_list = dump->GetMemoryList();
@@ -175,12 +331,22 @@ ProcessResult MinidumpProcessor::Process(
                 << " memory regions.";
   }
 
+  // Full-memory minidumps hold their memory in a MEMORY_64_LIST_STREAM.
+  MinidumpMemory64List *memory64_list = dump->GetMemory64List();
+  if (memory64_list) {
+    BPLOG(INFO) << "Found " << memory64_list->region_count()
+                << " 64-bit memory regions.";
+  }
+
   MinidumpThreadList *threads = dump->GetThreadList();
   if (!threads) {
     BPLOG(ERROR) << "Minidump " << dump->path() << " has no thread list";
     return PROCESS_ERROR_NO_THREAD_LIST;
   }
 
+  // Thread names are optional, and are only found in some dumps.
+  MinidumpThreadNameList *thread_names = dump->GetThreadNameList();
+
   BPLOG(INFO) << "Minidump " << dump->path() << " has " <<
       (has_cpu_info            ? "" : "no ") << "CPU info, " <<
       (has_os_info             ? "" : "no ") << "OS info, " <<
@@ -199,6 +365,11 @@ ProcessResult MinidumpProcessor::Process(
   // Reset frame_symbolizer_ at the beginning of stackwalk for each minidump.
   frame_symbolizer_->Reset();
 
+  ScopedModulePins module_pins(frame_symbolizer_->resolver(),
+                               process_state->modules_);
+
+  vector<ThreadWalk> walks;
+  walks.reserve(thread_count);
   for (unsigned int thread_index = 0;
        thread_index < thread_count;
        ++thread_index) {
@@ -230,23 +401,28 @@ ProcessResult MinidumpProcessor::Process(
       continue;
     }
 
+    bool is_requesting_thread =
+        has_requesting_thread && thread_id == requesting_thread_id;
+    if (!process_options_.walk_all_threads && !is_requesting_thread) {
+      continue;
+    }
+
     MinidumpContext *context = thread->GetContext();
 
-    if (has_requesting_thread && thread_id == requesting_thread_id) {
+    if (is_requesting_thread) {
       if (found_requesting_thread) {
         // There can't be more than one requesting thread.
         BPLOG(ERROR) << "Duplicate requesting thread: " << thread_string;
         return PROCESS_ERROR_DUPLICATE_REQUESTING_THREADS;
       }
 
-      // Use processed_state->threads_.size() instead of thread_index.
-      // thread_index points to the thread index in the minidump, which
-      // might be greater than the thread index in the threads vector if
-      // any of the minidump's threads are skipped and not placed into the
-      // processed threads vector.  The thread vector's current size will
-      // be the index of the current thread when it's pushed into the
-      // vector.
-      process_state->requesting_thread_ = process_state->threads_.size();
+      // Use walks.size() instead of thread_index.  thread_index points to
+      // the thread index in the minidump, which might be greater than the
+      // thread index in the threads vector if any of the minidump's threads
+      // are skipped and not placed into the processed threads vector.  Each
+      // walk is pushed into process_state->threads_ in order below, so the
+      // number of walks so far will be the index of the current thread.
+      process_state->requesting_thread_ = walks.size();
 
       found_requesting_thread = true;
 
@@ -266,51 +442,61 @@ ProcessResult MinidumpProcessor::Process(
     // in the memory descriptor inside MINIDUMP_THREAD, try to locate and use
     // a memory region (containing the stack) from the minidump memory list.
     MinidumpMemoryRegion *thread_memory = thread->GetMemory();
-    if (!thread_memory && memory_list) {
+    if (!thread_memory && (memory_list || memory64_list)) {
       uint64_t start_stack_memory_range = thread->GetStartOfStackMemoryRange();
       if (start_stack_memory_range) {
-        thread_memory = memory_list->GetMemoryRegionForAddress(
-           start_stack_memory_range);
+        if (memory_list) {
+          thread_memory = memory_list->GetMemoryRegionForAddress(
+             start_stack_memory_range);
+        }
+        if (!thread_memory && memory64_list) {
+          thread_memory = memory64_list->GetMemoryRegionForAddress(
+             start_stack_memory_range);
+        }
       }
     }
     if (!thread_memory) {
       BPLOG(ERROR) << "No memory region for " << thread_string;
     }
 
-    // Use process_state->modules_ instead of module_list, because the
-    // |modules| argument will be used to populate the |module| fields in
-    // the returned StackFrame objects, which will be placed into the
-    // returned ProcessState object.  module_list's lifetime is only as
-    // long as the Minidump object: it will be deleted when this function
-    // returns.  process_state->modules_ is owned by the ProcessState object
-    // (just like the StackFrame objects), and is much more suitable for this
-    // task.
-    scoped_ptr<Stackwalker> stackwalker(
-        Stackwalker::StackwalkerForCPU(process_state->system_info(),
-                                       context,
-                                       thread_memory,
-                                       process_state->modules_,
-                                       process_state->unloaded_modules_,
-                                       frame_symbolizer_));
-
-    scoped_ptr<CallStack> stack(new CallStack());
-    if (stackwalker.get()) {
-      if (!stackwalker->Walk(stack.get(),
-                             &process_state->modules_without_symbols_,
-                             &process_state->modules_with_corrupt_symbols_)) {
-        BPLOG(INFO) << "Stackwalker interrupt (missing symbols?) at "
-                    << thread_string;
-        interrupted = true;
-      }
-    } else {
-      // Threads with missing CPU contexts will hit this, but
-      // don't abort processing the rest of the dump just for
-      // one bad thread.
-      BPLOG(ERROR) << "No stackwalker for " << thread_string;
+    walks.push_back(ThreadWalk());
+    ThreadWalk& walk = walks.back();
+    walk.thread_string = thread_string;
+    walk.thread_id = thread_id;
+    if (thread_names)
+      thread_names->GetThreadNameByID(thread_id, &walk.thread_name);
+    walk.context = context;
+    walk.memory = thread_memory;
+    walk.thread_memory = thread_memory;
+
+    // A MinidumpMemoryRegion reads its contents from the minidump on first
+    // use.  When stacks are walked concurrently, read them all up front so
+    // that the walks never touch the Minidump.  A region that can't be read
+    // wouldn't have yielded any memory to the stackwalker anyway.
+    if (stackwalk_threads_ > 1 && thread_memory &&
+        !thread_memory->GetMemory()) {
+      walk.memory = NULL;
+    }
+  }
+
+  if (stackwalk_threads_ > 1 && walks.size() > 1) {
+    WalkThreadsConcurrently(*process_state, frame_symbolizer_, deadline,
+                            stackwalk_threads_, &walks);
+  } else {
+    for (size_t i = 0; i < walks.size(); ++i) {
+      WalkThread(*process_state, frame_symbolizer_, deadline, &walks[i]);
     }
-    stack->set_tid(thread_id);
-    process_state->threads_.push_back(stack.release());
-    process_state->thread_memory_regions_.push_back(thread_memory);
+  }
+
+  for (size_t i = 0; i < walks.size(); ++i) {
+    ThreadWalk& walk = walks[i];
+    interrupted = interrupted || walk.interrupted;
+    MergeSpecialAttentionModules(walk.modules_without_symbols,
+                                 &process_state->modules_without_symbols_);
+    MergeSpecialAttentionModules(walk.modules_with_corrupt_symbols,
+                                 &process_state->modules_with_corrupt_symbols_);
+    process_state->threads_.push_back(walk.stack);
+    process_state->thread_memory_regions_.push_back(walk.thread_memory);
   }
 
   if (interrupted) {
@@ -327,12 +513,16 @@ ProcessResult MinidumpProcessor::Process(
     process_state->requesting_thread_ = -1;
   }
 
+  if (process_state->truncated()) {
+    BPLOG(INFO) << "Processing stopped early for " << dump->path();
+  }
+
   // Exploitability defaults to EXPLOITABILITY_NOT_ANALYZED
   process_state->exploitability_ = EXPLOITABILITY_NOT_ANALYZED;
 
   // If an exploitability run was requested we perform the platform specific
-  // rating.
-  if (enable_exploitability_) {
+  // rating, unless time is up.
+  if (enable_exploitability_ && !process_state->truncated()) {
     scoped_ptr<Exploitability> exploitability(
         Exploitability::ExploitabilityForPlatform(dump,
                                                   process_state,
@@ -351,6 +541,12 @@ ProcessResult MinidumpProcessor::Process(
 
 ProcessResult MinidumpProcessor::Process(
     const string &minidump_file, ProcessState *process_state) {
+  return Process(minidump_file, process_state, NULL);
+}
+
+ProcessResult MinidumpProcessor::Process(
+    const string &minidump_file, ProcessState *process_state,
+    const ProcessDeadline *deadline) {
   BPLOG(INFO) << "Processing minidump in file " << minidump_file;
 
   Minidump dump(minidump_file);
@@ -359,7 +555,7 @@ ProcessResult MinidumpProcessor::Process(
      return PROCESS_ERROR_MINIDUMP_NOT_FOUND;
   }
 
-  return Process(&dump, process_state);
+  return Process(&dump, process_state, deadline);
 }
 
 // Returns the MDRawSystemInfo from a minidump, or NULL if system info is
@@ -36,6 +36,7 @@
 #include <iostream>
 #include <fstream>
 #include <map>
+#include <sstream>
 #include <utility>
 
 #include "breakpad_googletest_includes.h"
@@ -47,8 +48,10 @@
 #include "google_breakpad/processor/code_modules.h"
 #include "google_breakpad/processor/minidump.h"
 #include "google_breakpad/processor/minidump_processor.h"
+#include "google_breakpad/processor/process_deadline.h"
 #include "google_breakpad/processor/process_state.h"
 #include "google_breakpad/processor/stack_frame.h"
+#include "google_breakpad/processor/stack_frame_symbolizer.h"
 #include "google_breakpad/processor/symbol_supplier.h"
 #include "processor/logging.h"
 #include "processor/stackwalker_unittest_utils.h"
@@ -154,6 +157,17 @@ class TestMinidumpMiscInfo : public MinidumpMiscInfo {
   }
 };
 
+// A test Breakpad information stream, just returns values from the
+// MDRawBreakpadInfo fed to it.
+class TestMinidumpBreakpadInfo : public MinidumpBreakpadInfo {
+ public:
+  explicit TestMinidumpBreakpadInfo(const MDRawBreakpadInfo& breakpad_info) :
+      MinidumpBreakpadInfo(NULL) {
+    valid_ = true;
+    breakpad_info_ = breakpad_info;
+  }
+};
+
 }  // namespace google_breakpad
 
 namespace {
@@ -162,6 +176,7 @@ using google_breakpad::BasicSourceLineResolver;
 using google_breakpad::CallStack;
 using google_breakpad::CodeModule;
 using google_breakpad::MinidumpContext;
+using google_breakpad::Minidump;
 using google_breakpad::MinidumpMemoryRegion;
 using google_breakpad::MinidumpMiscInfo;
 using google_breakpad::MinidumpProcessor;
@@ -175,10 +190,16 @@ using google_breakpad::MockMinidumpThread;
 using google_breakpad::MockMinidumpThreadList;
 using google_breakpad::MockMinidumpUnloadedModule;
 using google_breakpad::MockMinidumpUnloadedModuleList;
+using google_breakpad::ProcessDeadline;
+using google_breakpad::ProcessOptions;
 using google_breakpad::ProcessState;
+using google_breakpad::scoped_array;
 using google_breakpad::scoped_ptr;
+using google_breakpad::StackFrame;
+using google_breakpad::StackFrameSymbolizer;
 using google_breakpad::SymbolSupplier;
 using google_breakpad::SystemInfo;
+using google_breakpad::TestMinidumpBreakpadInfo;
 using ::testing::_;
 using ::testing::AnyNumber;
 using ::testing::DoAll;
@@ -583,6 +604,295 @@ TEST_F(MinidumpProcessorTest, TestBasicProcessing) {
             google_breakpad::PROCESS_SYMBOL_SUPPLIER_INTERRUPTED);
 }
 
+TEST_F(MinidumpProcessorTest, TestFrameCache) {
+  TestSymbolSupplier supplier;
+  BasicSourceLineResolver resolver;
+  StackFrameSymbolizer frame_symbolizer(&supplier, &resolver);
+  frame_symbolizer.set_frame_cache_capacity(100);
+  MinidumpProcessor processor(&frame_symbolizer, false);
+
+  string minidump_file = GetTestDataPath() + "minidump2.dmp";
+
+  // The frames in test_app.exe are cached, along with any addresses in it
+  // that the stack walker checked.  kernel32.dll has no symbols, so its
+  // frame is not.
+  ProcessState first_state;
+  ASSERT_EQ(processor.Process(minidump_file, &first_state),
+            google_breakpad::PROCESS_OK);
+  StackFrameSymbolizer::FrameCacheStats first_stats =
+      frame_symbolizer.frame_cache_stats();
+  EXPECT_EQ(0U, first_stats.hits);
+  EXPECT_GE(first_stats.misses, 3U);
+  EXPECT_EQ(first_stats.misses, first_stats.entries);
+
+  // Processing the minidump again finds them all in the cache, with the
+  // same results.
+  ProcessState second_state;
+  ASSERT_EQ(processor.Process(minidump_file, &second_state),
+            google_breakpad::PROCESS_OK);
+  StackFrameSymbolizer::FrameCacheStats stats =
+      frame_symbolizer.frame_cache_stats();
+  EXPECT_EQ(first_stats.misses, stats.hits);
+  EXPECT_EQ(first_stats.misses, stats.misses);
+  EXPECT_EQ(first_stats.entries, stats.entries);
+  EXPECT_EQ(0U, stats.evictions);
+
+  const std::vector<StackFrame*>* first_frames =
+      first_state.threads()->at(0)->frames();
+  const std::vector<StackFrame*>* second_frames =
+      second_state.threads()->at(0)->frames();
+  ASSERT_EQ(4U, first_frames->size());
+  ASSERT_EQ(first_frames->size(), second_frames->size());
+  for (size_t i = 0; i < first_frames->size(); ++i) {
+    const StackFrame* first = first_frames->at(i);
+    const StackFrame* second = second_frames->at(i);
+    EXPECT_EQ(first->instruction, second->instruction);
+    EXPECT_EQ(first->function_name, second->function_name);
+    EXPECT_EQ(first->function_base, second->function_base);
+    EXPECT_EQ(first->source_file_name, second->source_file_name);
+    EXPECT_EQ(first->source_line, second->source_line);
+    EXPECT_EQ(first->source_line_base, second->source_line_base);
+  }
+  EXPECT_EQ("`anonymous namespace'::CrashFunction",
+            second_frames->at(0)->function_name);
+  EXPECT_EQ(58, second_frames->at(0)->source_line);
+
+  // Shrinking the cache drops the least recently used frames.
+  frame_symbolizer.set_frame_cache_capacity(1);
+  stats = frame_symbolizer.frame_cache_stats();
+  EXPECT_EQ(1U, stats.entries);
+  EXPECT_EQ(first_stats.entries - 1, stats.evictions);
+}
+
+TEST_F(MinidumpProcessorTest, TestFrameCacheAfterEviction) {
+  TestSymbolSupplier supplier;
+  BasicSourceLineResolver resolver;
+  StackFrameSymbolizer frame_symbolizer(&supplier, &resolver);
+  frame_symbolizer.set_frame_cache_capacity(100);
+  MinidumpProcessor processor(&frame_symbolizer, false);
+
+  string minidump_file = GetTestDataPath() + "minidump2.dmp";
+  ProcessState first_state;
+  ASSERT_EQ(google_breakpad::PROCESS_OK,
+            processor.Process(minidump_file, &first_state));
+
+  // Shrinking the resolver's budget unloads test_app.exe's symbols.
+  resolver.set_symbol_data_budget(1);
+  BasicSourceLineResolver::ModuleCacheStats module_stats =
+      resolver.module_cache_stats();
+  EXPECT_EQ(1U, module_stats.evictions);
+  EXPECT_EQ(0U, module_stats.modules);
+
+  // The frame cache holds the frames' source lines along with the frame
+  // information the stack walker unwound them with, so the stack is walked
+  // as it was the first time without reloading the symbols.
+  ProcessState second_state;
+  ASSERT_EQ(google_breakpad::PROCESS_OK,
+            processor.Process(minidump_file, &second_state));
+  EXPECT_GT(frame_symbolizer.frame_cache_stats().hits, 0U);
+  module_stats = resolver.module_cache_stats();
+  EXPECT_EQ(0U, module_stats.modules);
+  EXPECT_EQ(1U, module_stats.loads);
+  EXPECT_EQ(0U, module_stats.reloads);
+
+  const std::vector<StackFrame*>* first_frames =
+      first_state.threads()->at(0)->frames();
+  const std::vector<StackFrame*>* second_frames =
+      second_state.threads()->at(0)->frames();
+  ASSERT_EQ(4U, first_frames->size());
+  ASSERT_EQ(first_frames->size(), second_frames->size());
+  for (size_t i = 0; i < first_frames->size(); ++i) {
+    const StackFrame* first = first_frames->at(i);
+    const StackFrame* second = second_frames->at(i);
+    EXPECT_EQ(first->instruction, second->instruction);
+    EXPECT_EQ(first->trust, second->trust);
+    EXPECT_EQ(first->function_name, second->function_name);
+    EXPECT_EQ(first->source_line, second->source_line);
+  }
+}
+
+// The debug identifier of a build of test_app.exe other than the one in
+// minidump2.dmp.  OtherBuildMinidump() returns a copy of minidump2.dmp
+// from that build, and OtherBuildSymbolSupplier supplies its symbols.
+const char kOtherBuildIdentifier[] = "5A9832E5287241C1838ED98914E9B7FE1";
+
+// Returns minidump2.dmp, with the last byte of test_app.exe's GUID changed
+// to give it kOtherBuildIdentifier.
+string OtherBuildMinidump() {
+  std::ifstream in((GetTestDataPath() + "minidump2.dmp").c_str(),
+                   std::ios::binary);
+  std::ostringstream contents;
+  contents << in.rdbuf();
+  string minidump = contents.str();
+  // test_app.exe's is the first CodeView record, "RSDS", then the GUID.
+  size_t record = minidump.find("RSDS");
+  if (record != string::npos)
+    minidump[record + 4 + 15] = '\xfe';
+  return minidump;
+}
+
+// A TestSymbolSupplier that also supplies the symbols of the build of
+// test_app.exe with kOtherBuildIdentifier, in which CrashFunction is
+// called CrashFunctionInOtherBuild.
+class OtherBuildSymbolSupplier : public TestSymbolSupplier {
+ public:
+  virtual SymbolResult GetCStringSymbolData(const CodeModule *module,
+                                            const SystemInfo *system_info,
+                                            string *symbol_file,
+                                            char **symbol_data,
+                                            size_t *symbol_data_size) {
+    if (module->debug_identifier() != kOtherBuildIdentifier) {
+      return TestSymbolSupplier::GetCStringSymbolData(
+          module, system_info, symbol_file, symbol_data, symbol_data_size);
+    }
+    *symbol_file = GetTestDataPath() +
+        "symbols/test_app.pdb/5A9832E5287241C1838ED98914E9B7FF1/test_app.sym";
+    std::ifstream in(symbol_file->c_str());
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    string symbols = contents.str();
+    string name = "::CrashFunction";
+    size_t position = symbols.find(name);
+    if (position != string::npos)
+      symbols.insert(position + name.size(), "InOtherBuild");
+    *symbol_data_size = symbols.size() + 1;
+    *symbol_data = new char[*symbol_data_size];
+    memcpy(*symbol_data, symbols.c_str(), *symbol_data_size);
+    other_build_data_.reset(*symbol_data);
+    return FOUND;
+  }
+
+  virtual void FreeSymbolData(const CodeModule *module) {
+    if (module->debug_identifier() == kOtherBuildIdentifier)
+      other_build_data_.reset();
+    else
+      TestSymbolSupplier::FreeSymbolData(module);
+  }
+
+ private:
+  scoped_array<char> other_build_data_;
+};
+
+TEST_F(MinidumpProcessorTest, TestFrameCacheAcrossBuilds) {
+  OtherBuildSymbolSupplier supplier;
+  BasicSourceLineResolver resolver;
+  ASSERT_TRUE(resolver.set_key_by_debug_identifier(true));
+  StackFrameSymbolizer frame_symbolizer(&supplier, &resolver);
+  frame_symbolizer.set_frame_cache_capacity(100);
+  MinidumpProcessor processor(&frame_symbolizer, false);
+
+  ProcessState first_state;
+  ASSERT_EQ(google_breakpad::PROCESS_OK,
+            processor.Process(GetTestDataPath() + "minidump2.dmp",
+                              &first_state));
+  StackFrameSymbolizer::FrameCacheStats first_stats =
+      frame_symbolizer.frame_cache_stats();
+
+  // The frames of the other build of test_app.exe, at the same addresses,
+  // are symbolized with its own symbols rather than found in the cache.
+  std::istringstream other_build(OtherBuildMinidump());
+  Minidump dump(other_build);
+  ASSERT_TRUE(dump.Read());
+  ProcessState second_state;
+  ASSERT_EQ(google_breakpad::PROCESS_OK,
+            processor.Process(&dump, &second_state));
+  EXPECT_EQ(2U, resolver.module_cache_stats().modules);
+  StackFrameSymbolizer::FrameCacheStats stats =
+      frame_symbolizer.frame_cache_stats();
+  EXPECT_EQ(0U, stats.hits);
+  EXPECT_EQ(2 * first_stats.entries, stats.entries);
+
+  const StackFrame* first = first_state.threads()->at(0)->frames()->at(0);
+  const StackFrame* second = second_state.threads()->at(0)->frames()->at(0);
+  EXPECT_EQ(first->instruction, second->instruction);
+  EXPECT_EQ(kOtherBuildIdentifier, second->module->debug_identifier());
+  EXPECT_EQ("`anonymous namespace'::CrashFunction", first->function_name);
+  EXPECT_EQ("`anonymous namespace'::CrashFunctionInOtherBuild",
+            second->function_name);
+  EXPECT_EQ(first->source_line, second->source_line);
+}
+
+// A TestSymbolSupplier that cancels a ProcessDeadline the first time it
+// is asked for symbols.
+class CancellingSymbolSupplier : public TestSymbolSupplier {
+ public:
+  explicit CancellingSymbolSupplier(ProcessDeadline* deadline)
+      : deadline_(deadline) {}
+
+  virtual SymbolResult GetCStringSymbolData(const CodeModule *module,
+                                            const SystemInfo *system_info,
+                                            string *symbol_file,
+                                            char **symbol_data,
+                                            size_t *symbol_data_size) {
+    deadline_->Cancel();
+    return TestSymbolSupplier::GetCStringSymbolData(
+        module, system_info, symbol_file, symbol_data, symbol_data_size);
+  }
+
+ private:
+  ProcessDeadline* deadline_;
+};
+
+TEST_F(MinidumpProcessorTest, TestDeadline) {
+  TestSymbolSupplier supplier;
+  BasicSourceLineResolver resolver;
+  MinidumpProcessor processor(&supplier, &resolver);
+  string minidump_file = GetTestDataPath() + "minidump2.dmp";
+
+  // A deadline that doesn't pass changes nothing.
+  ProcessDeadline unlimited;
+  ProcessState state;
+  ASSERT_EQ(google_breakpad::PROCESS_OK,
+            processor.Process(minidump_file, &state, &unlimited));
+  EXPECT_FALSE(state.truncated());
+  ASSERT_EQ(1U, state.threads()->size());
+  EXPECT_EQ(4U, state.threads()->at(0)->frames()->size());
+  EXPECT_EQ(google_breakpad::CALL_STACK_NOT_TRUNCATED,
+            state.threads()->at(0)->truncation());
+
+  // Once the deadline has passed, each thread's stack holds only its
+  // context frame, without symbols, but processing still succeeds.
+  ProcessDeadline passed(ProcessDeadline::Clock::duration::zero());
+  ASSERT_EQ(google_breakpad::PROCESS_OK,
+            processor.Process(minidump_file, &state, &passed));
+  EXPECT_TRUE(state.truncated());
+  ASSERT_EQ(1U, state.threads()->size());
+  const CallStack* stack = state.threads()->at(0);
+  EXPECT_EQ(google_breakpad::CALL_STACK_DEADLINE_PASSED, stack->truncation());
+  EXPECT_EQ(3060U, stack->tid());
+  ASSERT_EQ(1U, stack->frames()->size());
+  const StackFrame* frame = stack->frames()->at(0);
+  EXPECT_EQ(StackFrame::FRAME_TRUST_CONTEXT, frame->trust);
+  ASSERT_TRUE(frame->module);
+  EXPECT_EQ("c:\\test_app.exe", frame->module->code_file());
+  EXPECT_TRUE(frame->function_name.empty());
+  EXPECT_EQ(0, frame->source_line);
+  EXPECT_EQ(0, state.requesting_thread());
+  EXPECT_EQ("EXCEPTION_ACCESS_VIOLATION_WRITE", state.crash_reason());
+  EXPECT_EQ(13U, state.modules()->module_count());
+}
+
+TEST_F(MinidumpProcessorTest, TestCancelDuringWalk) {
+  // Cancelling while the first frame's symbols load stops the walk after
+  // that frame.
+  ProcessDeadline deadline;
+  CancellingSymbolSupplier supplier(&deadline);
+  BasicSourceLineResolver resolver;
+  MinidumpProcessor processor(&supplier, &resolver);
+
+  ProcessState state;
+  ASSERT_EQ(google_breakpad::PROCESS_OK,
+            processor.Process(GetTestDataPath() + "minidump2.dmp", &state,
+                              &deadline));
+  EXPECT_TRUE(state.truncated());
+  ASSERT_EQ(1U, state.threads()->size());
+  const CallStack* stack = state.threads()->at(0);
+  EXPECT_EQ(google_breakpad::CALL_STACK_CANCELLED, stack->truncation());
+  ASSERT_EQ(1U, stack->frames()->size());
+  EXPECT_EQ("`anonymous namespace'::CrashFunction",
+            stack->frames()->at(0)->function_name);
+}
+
 TEST_F(MinidumpProcessorTest, TestThreadMissingMemory) {
   MockMinidump dump;
   EXPECT_CALL(dump, path()).WillRepeatedly(Return("mock minidump"));
@@ -649,6 +959,154 @@ TEST_F(MinidumpProcessorTest, TestThreadMissingMemory) {
   ASSERT_EQ(kExpectedEIP, state.threads()->at(0)->frames()->at(0)->instruction);
 }
 
+TEST_F(MinidumpProcessorTest, TestConcurrentStackwalk) {
+  MockMinidump dump;
+  EXPECT_CALL(dump, path()).WillRepeatedly(Return("mock minidump"));
+  EXPECT_CALL(dump, Read()).WillRepeatedly(Return(true));
+
+  MDRawHeader fake_header;
+  fake_header.time_date_stamp = 0;
+  EXPECT_CALL(dump, header()).WillRepeatedly(Return(&fake_header));
+
+  MDRawSystemInfo raw_system_info;
+  memset(&raw_system_info, 0, sizeof(raw_system_info));
+  raw_system_info.processor_architecture = MD_CPU_ARCHITECTURE_X86;
+  raw_system_info.platform_id = MD_OS_WIN32_NT;
+  TestMinidumpSystemInfo dump_system_info(raw_system_info);
+
+  EXPECT_CALL(dump, GetSystemInfo()).
+      WillRepeatedly(Return(&dump_system_info));
+
+  MockMinidumpThreadList thread_list;
+  EXPECT_CALL(dump, GetThreadList()).
+      WillOnce(Return(&thread_list));
+
+  // Many more threads than workers, so that each worker walks several.
+  const unsigned int kThreadCount = 32;
+  const uint32_t kBaseEIP = 0xabcd0000;
+  MockMinidumpThread threads[kThreadCount];
+  scoped_ptr<TestMinidumpContext> contexts[kThreadCount];
+  for (unsigned int i = 0; i < kThreadCount; ++i) {
+    EXPECT_CALL(threads[i], GetThreadID(_)).
+      WillRepeatedly(DoAll(SetArgumentPointee<0>(100 + i),
+                           Return(true)));
+    EXPECT_CALL(threads[i], GetMemory()).
+      WillRepeatedly(Return(reinterpret_cast<MinidumpMemoryRegion*>(NULL)));
+    EXPECT_CALL(threads[i], GetStartOfStackMemoryRange()).
+      WillRepeatedly(Return(0));
+
+    MDRawContextX86 raw_context;
+    memset(&raw_context, 0, sizeof(raw_context));
+    raw_context.context_flags = MD_CONTEXT_X86_FULL;
+    raw_context.eip = kBaseEIP + i;
+    contexts[i].reset(new TestMinidumpContext(raw_context));
+    EXPECT_CALL(threads[i], GetContext()).
+      WillRepeatedly(Return(contexts[i].get()));
+
+    EXPECT_CALL(thread_list, GetThreadAtIndex(i)).
+      WillOnce(Return(&threads[i]));
+  }
+  EXPECT_CALL(thread_list, thread_count()).
+    WillRepeatedly(Return(kThreadCount));
+
+  MinidumpProcessor processor(reinterpret_cast<SymbolSupplier*>(NULL), NULL);
+  processor.set_stackwalk_threads(4);
+  ProcessState state;
+  EXPECT_EQ(processor.Process(&dump, &state),
+            google_breakpad::PROCESS_OK);
+
+  // Threads must come out in minidump order, each with its own context frame.
+  ASSERT_EQ(kThreadCount, state.threads()->size());
+  ASSERT_EQ(kThreadCount, state.thread_memory_regions()->size());
+  for (unsigned int i = 0; i < kThreadCount; ++i) {
+    CallStack *stack = state.threads()->at(i);
+    EXPECT_EQ(100 + i, stack->tid());
+    ASSERT_EQ(1U, stack->frames()->size());
+    EXPECT_EQ(kBaseEIP + i, stack->frames()->at(0)->instruction);
+  }
+}
+
+TEST_F(MinidumpProcessorTest, TestRequestingThreadOnly) {
+  MockMinidump dump;
+  EXPECT_CALL(dump, path()).WillRepeatedly(Return("mock minidump"));
+  EXPECT_CALL(dump, Read()).WillRepeatedly(Return(true));
+
+  MDRawHeader fake_header;
+  fake_header.time_date_stamp = 0;
+  EXPECT_CALL(dump, header()).WillRepeatedly(Return(&fake_header));
+
+  MDRawSystemInfo raw_system_info;
+  memset(&raw_system_info, 0, sizeof(raw_system_info));
+  raw_system_info.processor_architecture = MD_CPU_ARCHITECTURE_X86;
+  raw_system_info.platform_id = MD_OS_WIN32_NT;
+  TestMinidumpSystemInfo dump_system_info(raw_system_info);
+
+  EXPECT_CALL(dump, GetSystemInfo()).
+      WillRepeatedly(Return(&dump_system_info));
+
+  const uint32_t kRequestingThreadID = 101;
+  MDRawBreakpadInfo raw_breakpad_info;
+  memset(&raw_breakpad_info, 0, sizeof(raw_breakpad_info));
+  raw_breakpad_info.validity = MD_BREAKPAD_INFO_VALID_REQUESTING_THREAD_ID;
+  raw_breakpad_info.requesting_thread_id = kRequestingThreadID;
+  TestMinidumpBreakpadInfo breakpad_info(raw_breakpad_info);
+  EXPECT_CALL(dump, GetBreakpadInfo()).
+      WillRepeatedly(Return(&breakpad_info));
+
+  // The unloaded module list is never read.
+  EXPECT_CALL(dump, GetUnloadedModuleList()).Times(0);
+
+  MockMinidumpThreadList thread_list;
+  EXPECT_CALL(dump, GetThreadList()).
+      WillOnce(Return(&thread_list));
+
+  // Only the requesting thread's context and memory are read.
+  const unsigned int kThreadCount = 3;
+  const uint32_t kExpectedEIP = 0xabcd1234;
+  MockMinidumpThread threads[kThreadCount];
+  MDRawContextX86 raw_context;
+  memset(&raw_context, 0, sizeof(raw_context));
+  raw_context.context_flags = MD_CONTEXT_X86_FULL;
+  raw_context.eip = kExpectedEIP;
+  TestMinidumpContext context(raw_context);
+  for (unsigned int i = 0; i < kThreadCount; ++i) {
+    uint32_t thread_id = 100 + i;
+    EXPECT_CALL(threads[i], GetThreadID(_)).
+      WillRepeatedly(DoAll(SetArgumentPointee<0>(thread_id),
+                           Return(true)));
+    EXPECT_CALL(thread_list, GetThreadAtIndex(i)).
+      WillOnce(Return(&threads[i]));
+    if (thread_id == kRequestingThreadID) {
+      EXPECT_CALL(threads[i], GetContext()).
+        WillRepeatedly(Return(&context));
+      EXPECT_CALL(threads[i], GetMemory()).
+        WillRepeatedly(Return(reinterpret_cast<MinidumpMemoryRegion*>(NULL)));
+      EXPECT_CALL(threads[i], GetStartOfStackMemoryRange()).
+        WillRepeatedly(Return(0));
+    } else {
+      EXPECT_CALL(threads[i], GetContext()).Times(0);
+      EXPECT_CALL(threads[i], GetMemory()).Times(0);
+    }
+  }
+  EXPECT_CALL(thread_list, thread_count()).
+    WillRepeatedly(Return(kThreadCount));
+
+  MinidumpProcessor processor(reinterpret_cast<SymbolSupplier*>(NULL), NULL);
+  ProcessOptions options;
+  options.walk_all_threads = false;
+  options.process_unloaded_modules = false;
+  processor.set_process_options(options);
+  ProcessState state;
+  EXPECT_EQ(processor.Process(&dump, &state),
+            google_breakpad::PROCESS_OK);
+
+  ASSERT_EQ(1U, state.threads()->size());
+  ASSERT_EQ(0, state.requesting_thread());
+  EXPECT_EQ(kRequestingThreadID, state.threads()->at(0)->tid());
+  ASSERT_EQ(1U, state.threads()->at(0)->frames()->size());
+  EXPECT_EQ(kExpectedEIP, state.threads()->at(0)->frames()->at(0)->instruction);
+}
+
 TEST_F(MinidumpProcessorTest, GetProcessCreateTime) {
   const uint32_t kProcessCreateTime = 2000;
   const uint32_t kTimeDateStamp = 5000;
@@ -32,21 +32,36 @@
 //
 // Author: Mark Mentovai
 
+#include <dirent.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <limits>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "common/path_helper.h"
+#include "common/stdio_wrapper.h"
 #include "common/scoped_ptr.h"
 #include "common/using_std_string.h"
 #include "google_breakpad/processor/basic_source_line_resolver.h"
 #include "google_breakpad/processor/minidump.h"
 #include "google_breakpad/processor/minidump_processor.h"
+#include "google_breakpad/processor/process_deadline.h"
 #include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/process_state_serializer.h"
+#include "google_breakpad/processor/remote_source_line_resolver.h"
+#include "google_breakpad/processor/stack_frame_symbolizer.h"
 #include "processor/logging.h"
 #include "processor/simple_symbol_supplier.h"
 #include "processor/stackwalk_common.h"
@@ -56,67 +71,495 @@ namespace {
 
 struct Options {
   bool machine_readable;
+  bool json;
   bool output_stack_contents;
+  bool crashing_thread_only;
+  bool serialized_output;
+  bool serialized_input;
+  bool print_statistics;
+  int stackwalk_threads;
+  int time_budget_ms;
+  string symbolizer_socket;
+  string batch_source;
+  int batch_threads;
+  string output_directory;
 
   string minidump_file;
   std::vector<string> symbol_paths;
 };
 
+using std::vector;
+
 using google_breakpad::BasicSourceLineResolver;
 using google_breakpad::Minidump;
 using google_breakpad::MinidumpMemoryList;
+using google_breakpad::MinidumpMemory64List;
 using google_breakpad::MinidumpThreadList;
 using google_breakpad::MinidumpProcessor;
+using google_breakpad::ProcessDeadline;
+using google_breakpad::ProcessOptions;
 using google_breakpad::ProcessState;
+using google_breakpad::ProcessStateSerializer;
+using google_breakpad::RemoteSourceLineResolver;
 using google_breakpad::SimpleSymbolSupplier;
+using google_breakpad::SourceLineResolverInterface;
+using google_breakpad::StackFrameSymbolizer;
 using google_breakpad::scoped_ptr;
 
-// Processes |options.minidump_file| using MinidumpProcessor.
-// |options.symbol_path|, if non-empty, is the base directory of a
-// symbol storage area, laid out in the format required by
-// SimpleSymbolSupplier.  If such a storage area is specified, it is
-// made available for use by the MinidumpProcessor.
-//
-// Returns the value of MinidumpProcessor::Process.  If processing succeeds,
-// prints identifying OS and CPU information from the minidump, crash
-// information if the minidump was produced as a result of a crash, and
-// call stacks for each thread contained in the minidump.  All information
-// is printed to stdout.
-bool PrintMinidumpProcess(const Options& options) {
+// Prints |process_state| to |output|: serialized by ProcessStateSerializer
+// if |options.serialized_output| is set, as JSON if |options.json| is set,
+// and as text otherwise.  Returns false if it could not be written.
+bool OutputProcessState(const Options& options,
+                        const ProcessState& process_state,
+                        SourceLineResolverInterface* resolver,
+                        FILE* output) {
+  if (options.serialized_output) {
+    string serialized;
+    ProcessStateSerializer::Serialize(process_state, &serialized);
+    if (fwrite(serialized.data(), 1, serialized.size(), output) !=
+        serialized.size()) {
+      BPLOG(ERROR) << "Could not write the serialized process state";
+      return false;
+    }
+    return true;
+  }
+
+  if (options.json) {
+    PrintProcessStateJSON(process_state, output);
+  } else if (options.machine_readable) {
+    PrintProcessStateMachineReadable(process_state, output);
+  } else {
+    PrintProcessState(process_state, options.output_stack_contents,
+                      resolver, output);
+  }
+  return true;
+}
+
+// Reads the ProcessState that -b wrote to |path|, and prints it to
+// |output| as OutputProcessState does, without processing anything.
+bool PrintSerializedProcessState(const Options& options,
+                                 const string& path,
+                                 FILE* output) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (!file) {
+    BPLOG(ERROR) << "Could not open " << path;
+    return false;
+  }
+  string serialized;
+  char buffer[64 * 1024];
+  size_t bytes_read;
+  while ((bytes_read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    serialized.append(buffer, bytes_read);
+  bool read_error = ferror(file);
+  fclose(file);
+  if (read_error) {
+    BPLOG(ERROR) << "Could not read " << path;
+    return false;
+  }
+
+  ProcessState process_state;
+  if (!ProcessStateSerializer::Deserialize(serialized.data(),
+                                           serialized.size(),
+                                           &process_state)) {
+    BPLOG(ERROR) << path << " does not hold a serialized process state";
+    return false;
+  }
+
+  // The resolver is only used to look up the stack contents, and a
+  // serialized state has none.
+  return OutputProcessState(options, process_state, NULL, output);
+}
+
+// The number of symbolized frames kept for reuse by other threads and
+// minidumps.  Each takes a few hundred bytes.
+const size_t kFrameCacheCapacity = 1 << 16;
+
+// The symbol supplier, resolver, symbolizer and MinidumpProcessor that
+// every minidump is processed with.
+struct Stackwalker {
+  Stackwalker() : basic_resolver(NULL) {}
+
   scoped_ptr<SimpleSymbolSupplier> symbol_supplier;
-  if (!options.symbol_paths.empty()) {
-    // TODO(mmentovai): check existence of symbol_path if specified?
-    symbol_supplier.reset(new SimpleSymbolSupplier(options.symbol_paths));
+  scoped_ptr<SourceLineResolverInterface> resolver;
+  scoped_ptr<StackFrameSymbolizer> frame_symbolizer;
+  scoped_ptr<MinidumpProcessor> minidump_processor;
+  // |resolver|, if it loads symbols itself rather than using a server.
+  BasicSourceLineResolver* basic_resolver;
+};
+
+// Sets up |stackwalker| as |options| ask.  |options.symbol_paths|, if
+// non-empty, are the base directories of symbol storage areas, laid out
+// in the format required by SimpleSymbolSupplier.  If |options.
+// symbolizer_socket| is non-empty, symbols are instead looked up by the
+// breakpad_symbolizer server listening on that socket.  Returns false if
+// the server could not be reached.
+bool CreateStackwalker(const Options& options, Stackwalker* stackwalker) {
+  if (!options.symbolizer_socket.empty()) {
+    RemoteSourceLineResolver *remote_resolver =
+        new RemoteSourceLineResolver(options.symbolizer_socket);
+    stackwalker->resolver.reset(remote_resolver);
+    if (!remote_resolver->Connect())
+      return false;
+  } else {
+    if (!options.symbol_paths.empty()) {
+      // TODO(mmentovai): check existence of symbol_path if specified?
+      stackwalker->symbol_supplier.reset(
+          new SimpleSymbolSupplier(options.symbol_paths));
+    }
+    stackwalker->basic_resolver = new BasicSourceLineResolver;
+    stackwalker->resolver.reset(stackwalker->basic_resolver);
+    // The minidumps of a batch may come from different builds of a module
+    // with the same code file, whose symbols must be kept apart.
+    if (!options.batch_source.empty())
+      stackwalker->basic_resolver->set_key_by_debug_identifier(true);
   }
 
-  BasicSourceLineResolver resolver;
-  MinidumpProcessor minidump_processor(symbol_supplier.get(), &resolver);
+  stackwalker->frame_symbolizer.reset(
+      new StackFrameSymbolizer(stackwalker->symbol_supplier.get(),
+                               stackwalker->resolver.get()));
+  stackwalker->frame_symbolizer->set_frame_cache_capacity(
+      kFrameCacheCapacity);
+  MinidumpProcessor* minidump_processor =
+      new MinidumpProcessor(stackwalker->frame_symbolizer.get(), false);
+  stackwalker->minidump_processor.reset(minidump_processor);
+  minidump_processor->set_stackwalk_threads(options.stackwalk_threads);
+  if (options.crashing_thread_only) {
+    ProcessOptions process_options;
+    process_options.walk_all_threads = false;
+    process_options.process_unloaded_modules = false;
+    minidump_processor->set_process_options(process_options);
+  }
 
   // Increase the maximum number of threads and regions.
   MinidumpThreadList::set_max_threads(std::numeric_limits<uint32_t>::max());
   MinidumpMemoryList::set_max_regions(std::numeric_limits<uint32_t>::max());
-  // Process the minidump.
-  Minidump dump(options.minidump_file);
+  MinidumpMemory64List::set_max_regions(std::numeric_limits<uint32_t>::max());
+  return true;
+}
+
+// Prints statistics on the reuse of loaded symbols, symbolized frames and
+// CFI rules by |stackwalker| to stderr.
+void PrintCacheStatistics(const Stackwalker& stackwalker) {
+  if (stackwalker.frame_symbolizer.get()) {
+    StackFrameSymbolizer::FrameCacheStats stats =
+        stackwalker.frame_symbolizer->frame_cache_stats();
+    uint64_t lookups = stats.hits + stats.misses;
+    fprintf(stderr, "Frame cache: %" PRIu64 " of %" PRIu64
+            " frames hit (%.1f%%), %zu cached, %" PRIu64 " evicted\n",
+            stats.hits, lookups, lookups ? 100.0 * stats.hits / lookups : 0.0,
+            stats.entries, stats.evictions);
+  }
+  if (stackwalker.basic_resolver) {
+    BasicSourceLineResolver::ModuleCacheStats module_stats =
+        stackwalker.basic_resolver->module_cache_stats();
+    fprintf(stderr, "Symbols: %zu modules loaded from %zu bytes, %" PRIu64
+            " loads (%" PRIu64 " of evicted modules), %" PRIu64
+            " evicted\n", module_stats.modules,
+            module_stats.symbol_data_bytes, module_stats.loads,
+            module_stats.reloads, module_stats.evictions);
+    BasicSourceLineResolver::CFICacheStats stats =
+        stackwalker.basic_resolver->cfi_cache_stats();
+    uint64_t lookups = stats.hits + stats.misses;
+    fprintf(stderr, "CFI rule cache: %" PRIu64 " of %" PRIu64
+            " lookups hit (%.1f%%), %zu cached, %" PRIu64 " evicted\n",
+            stats.hits, lookups, lookups ? 100.0 * stats.hits / lookups : 0.0,
+            stats.entries, stats.evictions);
+  }
+}
+
+// Processes the minidump at |path| using |stackwalker|.
+//
+// Returns false if the minidump could not be processed.  If processing
+// succeeds, prints identifying OS and CPU information from the minidump,
+// crash information if the minidump was produced as a result of a crash,
+// and call stacks for each thread contained in the minidump, or the
+// serialized ProcessState holding them, to |output|.  If |options.
+// time_budget_ms| is set, stack walking stops that long after starting on
+// the minidump, and the stacks found until then are printed.
+bool PrintMinidumpProcess(const Options& options,
+                          const Stackwalker& stackwalker,
+                          const string& path,
+                          FILE* output) {
+  scoped_ptr<ProcessDeadline> deadline;
+  if (options.time_budget_ms > 0) {
+    deadline.reset(new ProcessDeadline(
+        std::chrono::milliseconds(options.time_budget_ms)));
+  }
+  Minidump dump(path);
   if (!dump.Read()) {
      BPLOG(ERROR) << "Minidump " << dump.path() << " could not be read";
      return false;
   }
   ProcessState process_state;
-  if (minidump_processor.Process(&dump, &process_state) !=
+  if (stackwalker.minidump_processor->Process(&dump, &process_state,
+                                              deadline.get()) !=
       google_breakpad::PROCESS_OK) {
     BPLOG(ERROR) << "MinidumpProcessor::Process failed";
     return false;
   }
 
-  if (options.machine_readable) {
-    PrintProcessStateMachineReadable(process_state);
-  } else {
-    PrintProcessState(process_state, options.output_stack_contents, &resolver);
+  return OutputProcessState(options, process_state,
+                            stackwalker.resolver.get(), output);
+}
+
+// Prints the result for |path|, a minidump, or a serialized ProcessState
+// if |options.serialized_input| is set, to |output|.  |stackwalker| is
+// only used for minidumps.
+bool PrintResult(const Options& options,
+                 const Stackwalker& stackwalker,
+                 const string& path,
+                 FILE* output) {
+  if (options.serialized_input)
+    return PrintSerializedProcessState(options, path, output);
+  return PrintMinidumpProcess(options, stackwalker, path, output);
+}
+
+// Appends the paths that |options.batch_source| names to |paths|.  It is
+// either a directory, all of whose regular files are named, in order; a
+// file listing one path per line; or "-", for such a list on stdin.
+// Returns false if it could not be read.
+bool ReadBatchPaths(const Options& options, vector<string>* paths) {
+  const string& source = options.batch_source;
+  struct stat source_stat;
+  if (source != "-" && stat(source.c_str(), &source_stat) == 0 &&
+      S_ISDIR(source_stat.st_mode)) {
+    DIR* directory = opendir(source.c_str());
+    if (!directory) {
+      BPLOG(ERROR) << "Could not open " << source;
+      return false;
+    }
+    size_t first = paths->size();
+    struct dirent* entry;
+    while ((entry = readdir(directory)) != NULL) {
+      string path = source + "/" + entry->d_name;
+      struct stat path_stat;
+      if (stat(path.c_str(), &path_stat) == 0 && S_ISREG(path_stat.st_mode))
+        paths->push_back(path);
+    }
+    closedir(directory);
+    std::sort(paths->begin() + first, paths->end());
+    return true;
   }
 
+  FILE* list = source == "-" ? stdin : fopen(source.c_str(), "r");
+  if (!list) {
+    BPLOG(ERROR) << "Could not open " << source;
+    return false;
+  }
+  string line;
+  int c;
+  while ((c = getc(list)) != EOF) {
+    if (c != '\n') {
+      line.push_back(c);
+      continue;
+    }
+    if (!line.empty() && line[line.size() - 1] == '\r')
+      line.resize(line.size() - 1);
+    if (!line.empty())
+      paths->push_back(line);
+    line.clear();
+  }
+  if (!line.empty())
+    paths->push_back(line);
+  bool read_error = ferror(list);
+  if (list != stdin)
+    fclose(list);
+  if (read_error) {
+    BPLOG(ERROR) << "Could not read " << source;
+    return false;
+  }
   return true;
 }
 
+// Returns the file in |options.output_directory| that the result for
+// |path| is written to.
+string BatchOutputPath(const Options& options, const string& path) {
+  const char* extension = options.serialized_output ? ".bin" :
+                          options.json ? ".json" : ".txt";
+  return options.output_directory + "/" + google_breakpad::BaseName(path) +
+         extension;
+}
+
+// The number of items of a batch that may be processed ahead of the
+// oldest whose result is not yet on stdout, each holding a temporary file
+// open for its result meanwhile.
+const size_t kMaxUnwrittenResults = 64;
+
+// The outcome of one item of a batch.
+struct BatchResult {
+  BatchResult() : done(false), succeeded(false), output(NULL), seconds(0) {}
+
+  bool done;
+  bool succeeded;
+  // The file the result was printed to, until it is copied to stdout;
+  // only used when there is no output directory.
+  FILE* output;
+  double seconds;
+};
+
+// Processes every item that |options.batch_source| names, on
+// |options.batch_threads| threads that share one Stackwalker, so that
+// each module's symbols are loaded only once.  The result for each item
+// is written to its own file in |options.output_directory| if there is
+// one, and otherwise to stdout, preceded by a line naming it and in the
+// order the items were named.  Frames symbolized for one item are cached
+// for the others.  Statistics on the time taken, and on the reuse of
+// symbolized frames, loaded symbols and CFI rules across items, are
+// printed to stderr at the end.
+// Returns false if any item failed.
+bool ProcessBatch(const Options& options) {
+  vector<string> paths;
+  if (!ReadBatchPaths(options, &paths))
+    return false;
+
+  if (!options.output_directory.empty()) {
+    std::set<string> output_paths;
+    for (size_t i = 0; i < paths.size(); ++i) {
+      if (!output_paths.insert(BatchOutputPath(options, paths[i])).second) {
+        BPLOG(ERROR) << "More than one result would be written to " <<
+                        BatchOutputPath(options, paths[i]);
+        return false;
+      }
+    }
+  }
+
+  Stackwalker stackwalker;
+  if (!options.serialized_input && !CreateStackwalker(options, &stackwalker))
+    return false;
+
+  typedef std::chrono::steady_clock Clock;
+  Clock::time_point batch_start = Clock::now();
+
+  int thread_count = options.batch_threads;
+  if (thread_count <= 0)
+    thread_count = std::max(1U, std::thread::hardware_concurrency());
+  if (static_cast<size_t>(thread_count) > paths.size())
+    thread_count = paths.size();
+
+  // Without an output directory, results wait in temporary files until
+  // those before them are copied to stdout, so workers stay within
+  // max_unwritten items of the oldest result not copied yet, rather than
+  // running out of file descriptors behind a slow item.
+  size_t max_unwritten = paths.size();
+  if (options.output_directory.empty()) {
+    max_unwritten = std::max(kMaxUnwrittenResults,
+                             static_cast<size_t>(thread_count));
+  }
+
+  vector<BatchResult> results(paths.size());
+  std::mutex results_mutex;
+  std::condition_variable result_done;
+  std::condition_variable result_written;
+  size_t next_item = 0;
+  size_t unwritten_item = 0;
+
+  vector<std::thread> workers;
+  for (int i = 0; i < thread_count; ++i) {
+    workers.push_back(std::thread([&]() {
+      while (true) {
+        size_t item;
+        {
+          std::unique_lock<std::mutex> lock(results_mutex);
+          while (next_item < paths.size() &&
+                 next_item - unwritten_item >= max_unwritten) {
+            result_written.wait(lock);
+          }
+          if (next_item == paths.size())
+            break;
+          item = next_item++;
+        }
+
+        Clock::time_point start = Clock::now();
+        bool succeeded = false;
+        FILE* output;
+        if (!options.output_directory.empty()) {
+          string output_path = BatchOutputPath(options, paths[item]);
+          output = fopen(output_path.c_str(), "wb");
+          if (!output)
+            BPLOG(ERROR) << "Could not create " << output_path;
+        } else {
+          output = tmpfile();
+          if (!output)
+            BPLOG(ERROR) << "Could not create a temporary file";
+        }
+        if (output) {
+          succeeded = PrintResult(options, stackwalker, paths[item], output);
+          if (!options.output_directory.empty()) {
+            if (fclose(output) != 0)
+              succeeded = false;
+            output = NULL;
+          }
+        }
+        double seconds =
+            std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(results_mutex);
+        BatchResult& result = results[item];
+        result.done = true;
+        result.succeeded = succeeded;
+        result.output = output;
+        result.seconds = seconds;
+        result_done.notify_all();
+      }
+    }));
+  }
+
+  // Copy each result to stdout as soon as it and every one before it are
+  // done, so that they come out in order.
+  for (size_t item = 0; item < paths.size(); ++item) {
+    FILE* output;
+    {
+      std::unique_lock<std::mutex> lock(results_mutex);
+      while (!results[item].done)
+        result_done.wait(lock);
+      output = results[item].output;
+    }
+    if (options.output_directory.empty()) {
+      printf("==> %s <==\n", paths[item].c_str());
+      if (output) {
+        rewind(output);
+        char buffer[64 * 1024];
+        size_t bytes_read;
+        while ((bytes_read = fread(buffer, 1, sizeof(buffer), output)) > 0)
+          fwrite(buffer, 1, bytes_read, stdout);
+        fclose(output);
+      }
+    }
+    std::lock_guard<std::mutex> lock(results_mutex);
+    unwritten_item = item + 1;
+    result_written.notify_all();
+  }
+
+  for (size_t i = 0; i < workers.size(); ++i)
+    workers[i].join();
+
+  double batch_seconds =
+      std::chrono::duration<double>(Clock::now() - batch_start).count();
+  size_t failed = 0;
+  double total_seconds = 0;
+  size_t slowest = 0;
+  for (size_t item = 0; item < results.size(); ++item) {
+    if (!results[item].succeeded) {
+      BPLOG(ERROR) << "Could not process " << paths[item];
+      ++failed;
+    }
+    total_seconds += results[item].seconds;
+    if (results[item].seconds > results[slowest].seconds)
+      slowest = item;
+  }
+  fflush(stdout);
+  fprintf(stderr, "Processed %zu items (%zu failed) in %.3f s on %d %s\n",
+          paths.size(), failed, batch_seconds, thread_count,
+          thread_count == 1 ? "thread" : "threads");
+  if (!paths.empty()) {
+    fprintf(stderr, "Per item: %.3f s on average, %.3f s at most (%s)\n",
+            total_seconds / paths.size(), results[slowest].seconds,
+            paths[slowest].c_str());
+  }
+  PrintCacheStatistics(stackwalker);
+  return failed == 0;
+}
+
 }  // namespace
 
 static void Usage(int argc, const char *argv[], bool error) {
@@ -128,7 +571,36 @@ static void Usage(int argc, const char *argv[], bool error) {
           "Options:\n"
           "\n"
           "  -m         Output in machine-readable format\n"
-          "  -s         Output stack contents\n",
+          "  -J         Output in JSON\n"
+          "  -s         Output stack contents\n"
+          "  -b         Output the processed state in binary, to be cached\n"
+          "             and printed later with -p\n"
+          "  -p         <minidump-file> holds a state written by -b; print it\n"
+          "             without processing the minidump again\n"
+          "  -c         Walk only the crashing or requesting thread, and\n"
+          "             ignore unloaded modules\n"
+          "  -j <n>     Walk thread stacks on <n> threads concurrently\n"
+          "  -t <ms>    Stop walking stacks <ms> milliseconds into each\n"
+          "             minidump, and print the stacks found so far\n"
+          "  -r <path>  Look up symbols with the breakpad_symbolizer server\n"
+          "             listening on the Unix domain socket <path>, instead\n"
+          "             of in the symbol paths\n"
+          "  -S         Print processing statistics to stderr: the time\n"
+          "             taken, and the reuse of symbolized frames, loaded\n"
+          "             symbols and CFI rules.  Batch mode always prints\n"
+          "             them\n"
+          "\n"
+          "Batch mode:\n"
+          "\n"
+          "  -B <list>  Process every minidump named in the file <list>, one\n"
+          "             per line, or on stdin if <list> is -, or every file\n"
+          "             in the directory <list>, sharing loaded symbols.  No\n"
+          "             <minidump-file> is given.  Each result is printed\n"
+          "             after a line naming its minidump\n"
+          "  -n <n>     Process <n> minidumps concurrently (default: one per\n"
+          "             CPU)\n"
+          "  -o <dir>   Write each result to a file in <dir> named after its\n"
+          "             minidump, instead of to stdout\n",
           google_breakpad::BaseName(argv[0]).c_str());
 }
 
@@ -136,21 +608,78 @@ static void SetupOptions(int argc, const char *argv[], Options* options) {
   int ch;
 
   options->machine_readable = false;
+  options->json = false;
   options->output_stack_contents = false;
+  options->crashing_thread_only = false;
+  options->serialized_output = false;
+  options->serialized_input = false;
+  options->print_statistics = false;
+  options->stackwalk_threads = 1;
+  options->time_budget_ms = 0;
+  options->batch_threads = 0;
 
-  while ((ch = getopt(argc, (char * const *)argv, "hms")) != -1) {
+  while ((ch = getopt(argc, (char * const *)argv, "B:bchj:Jmn:o:pr:Sst:")) != -1) {
     switch (ch) {
+      case 'B':
+        options->batch_source = optarg;
+        break;
+      case 'b':
+        options->serialized_output = true;
+        break;
+      case 'c':
+        options->crashing_thread_only = true;
+        break;
       case 'h':
         Usage(argc, argv, false);
         exit(0);
         break;
 
+      case 'J':
+        options->json = true;
+        break;
       case 'm':
         options->machine_readable = true;
         break;
+      case 'n':
+        options->batch_threads = atoi(optarg);
+        if (options->batch_threads < 1) {
+          fprintf(stderr, "%s: Invalid thread count: %s\n", argv[0], optarg);
+          Usage(argc, argv, true);
+          exit(1);
+        }
+        break;
+      case 'o':
+        options->output_directory = optarg;
+        break;
+      case 'p':
+        options->serialized_input = true;
+        break;
+      case 'r':
+        options->symbolizer_socket = optarg;
+        break;
+      case 'S':
+        options->print_statistics = true;
+        break;
       case 's':
         options->output_stack_contents = true;
         break;
+      case 't':
+        options->time_budget_ms = atoi(optarg);
+        if (options->time_budget_ms < 1) {
+          fprintf(stderr, "%s: Invalid time budget: %s\n", argv[0], optarg);
+          Usage(argc, argv, true);
+          exit(1);
+        }
+        break;
+
+      case 'j':
+        options->stackwalk_threads = atoi(optarg);
+        if (options->stackwalk_threads < 1) {
+          fprintf(stderr, "%s: Invalid thread count: %s\n", argv[0], optarg);
+          Usage(argc, argv, true);
+          exit(1);
+        }
+        break;
 
       case '?':
         Usage(argc, argv, true);
@@ -159,15 +688,27 @@ static void SetupOptions(int argc, const char *argv[], Options* options) {
     }
   }
 
-  if ((argc - optind) == 0) {
-    fprintf(stderr, "%s: Missing minidump file\n", argv[0]);
+  int argi = optind;
+  if (options->batch_source.empty()) {
+    if ((argc - optind) == 0) {
+      fprintf(stderr, "%s: Missing minidump file\n", argv[0]);
+      Usage(argc, argv, true);
+      exit(1);
+    }
+    if (!options->output_directory.empty()) {
+      fprintf(stderr, "%s: -o is only used with -B\n", argv[0]);
+      Usage(argc, argv, true);
+      exit(1);
+    }
+    options->minidump_file = argv[argi++];
+  } else if (options->serialized_output &&
+             options->output_directory.empty()) {
+    fprintf(stderr, "%s: -b with -B needs -o\n", argv[0]);
     Usage(argc, argv, true);
     exit(1);
   }
 
-  options->minidump_file = argv[optind];
-
-  for (int argi = optind + 1; argi < argc; ++argi)
+  for (; argi < argc; ++argi)
     options->symbol_paths.push_back(argv[argi]);
 }
 
@@ -175,5 +716,22 @@ int main(int argc, const char* argv[]) {
   Options options;
   SetupOptions(argc, argv, &options);
 
-  return PrintMinidumpProcess(options) ? 0 : 1;
+  if (!options.batch_source.empty())
+    return ProcessBatch(options) ? 0 : 1;
+
+  Stackwalker stackwalker;
+  if (!options.serialized_input && !CreateStackwalker(options, &stackwalker))
+    return 1;
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  bool succeeded =
+      PrintResult(options, stackwalker, options.minidump_file, stdout);
+  if (options.print_statistics) {
+    fflush(stdout);
+    fprintf(stderr, "Processed %s in %.3f s\n", options.minidump_file.c_str(),
+            std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count());
+    PrintCacheStatistics(stackwalker);
+  }
+  return succeeded ? 0 : 1;
 }
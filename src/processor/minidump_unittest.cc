@@ -32,12 +32,15 @@
 
 #include <iostream>
 #include <fstream>
+#include <iterator>
 #include <sstream>
 #include <stdlib.h>
+#include <string.h>
 #include <string>
 #include <vector>
 
 #include "breakpad_googletest_includes.h"
+#include "common/tests/auto_tempdir.h"
 #include "common/using_std_string.h"
 #include "google_breakpad/common/minidump_format.h"
 #include "google_breakpad/processor/minidump.h"
@@ -46,12 +49,14 @@
 
 namespace {
 
+using google_breakpad::AutoTempDir;
 using google_breakpad::Minidump;
 using google_breakpad::MinidumpContext;
 using google_breakpad::MinidumpException;
 using google_breakpad::MinidumpMemoryInfo;
 using google_breakpad::MinidumpMemoryInfoList;
 using google_breakpad::MinidumpMemoryList;
+using google_breakpad::MinidumpMemory64List;
 using google_breakpad::MinidumpMemoryRegion;
 using google_breakpad::MinidumpModule;
 using google_breakpad::MinidumpModuleList;
@@ -60,6 +65,7 @@ using google_breakpad::MinidumpUnloadedModule;
 using google_breakpad::MinidumpUnloadedModuleList;
 using google_breakpad::MinidumpThread;
 using google_breakpad::MinidumpThreadList;
+using google_breakpad::MinidumpThreadNameList;
 using google_breakpad::SynthMinidump::Context;
 using google_breakpad::SynthMinidump::Dump;
 using google_breakpad::SynthMinidump::Exception;
@@ -73,6 +79,7 @@ using google_breakpad::SynthMinidump::SystemInfo;
 using google_breakpad::SynthMinidump::Thread;
 using google_breakpad::test_assembler::kBigEndian;
 using google_breakpad::test_assembler::kLittleEndian;
+using google_breakpad::test_assembler::Label;
 using std::ifstream;
 using std::istringstream;
 using std::vector;
@@ -131,6 +138,88 @@ TEST_F(MinidumpTest, TestMinidumpFromStream) {
   //TODO: add more checks here
 }
 
+TEST_F(MinidumpTest, TestMappedMinidump) {
+  // A minidump opened from a file is memory-mapped, and its memory regions
+  // are used in place; one read from a stream is copied as before.  Both
+  // must see the same contents.
+  Minidump mapped(minidump_file_);
+  ASSERT_TRUE(mapped.Read());
+  ASSERT_TRUE(mapped.GetMappedBytes(0, sizeof(MDRawHeader)) != NULL);
+  ifstream file_stream(minidump_file_.c_str(), std::ios::in | std::ios::binary);
+  ASSERT_TRUE(file_stream.good());
+  Minidump streamed(file_stream);
+  ASSERT_TRUE(streamed.Read());
+  EXPECT_TRUE(streamed.GetMappedBytes(0, sizeof(MDRawHeader)) == NULL);
+
+  MinidumpThreadList* mapped_threads = mapped.GetThreadList();
+  MinidumpThreadList* streamed_threads = streamed.GetThreadList();
+  ASSERT_TRUE(mapped_threads != NULL);
+  ASSERT_TRUE(streamed_threads != NULL);
+  ASSERT_EQ(streamed_threads->thread_count(), mapped_threads->thread_count());
+  for (unsigned int i = 0; i < mapped_threads->thread_count(); ++i) {
+    MinidumpMemoryRegion* mapped_stack =
+        mapped_threads->GetThreadAtIndex(i)->GetMemory();
+    MinidumpMemoryRegion* streamed_stack =
+        streamed_threads->GetThreadAtIndex(i)->GetMemory();
+    ASSERT_TRUE(mapped_stack != NULL);
+    ASSERT_TRUE(streamed_stack != NULL);
+    ASSERT_EQ(streamed_stack->GetSize(), mapped_stack->GetSize());
+    const uint8_t* mapped_bytes = mapped_stack->GetMemory();
+    ASSERT_TRUE(mapped_bytes != NULL);
+    EXPECT_EQ(0, memcmp(streamed_stack->GetMemory(), mapped_bytes,
+                        mapped_stack->GetSize()));
+    uint32_t mapped_word, streamed_word;
+    EXPECT_TRUE(mapped_stack->GetMemoryAtAddress(mapped_stack->GetBase(),
+                                                 &mapped_word));
+    EXPECT_TRUE(streamed_stack->GetMemoryAtAddress(streamed_stack->GetBase(),
+                                                   &streamed_word));
+    EXPECT_EQ(streamed_word, mapped_word);
+  }
+
+  // Views must lie within the file.
+  off_t size = file_stream.seekg(0, std::ios_base::end).tellg();
+  EXPECT_TRUE(mapped.GetMappedBytes(size - 1, 1) != NULL);
+  EXPECT_TRUE(mapped.GetMappedBytes(size, 0) != NULL);
+  EXPECT_TRUE(mapped.GetMappedBytes(size, 1) == NULL);
+  EXPECT_TRUE(mapped.GetMappedBytes(size - 1, 2) == NULL);
+  EXPECT_TRUE(mapped.GetMappedBytes(-1, 1) == NULL);
+}
+
+TEST_F(MinidumpTest, TestTruncatedMappedMinidump) {
+  // Memory regions that lie past the end of a truncated minidump can't be
+  // read, whether the file is mapped or not.
+  ifstream file_stream(minidump_file_.c_str(), std::ios::in | std::ios::binary);
+  ASSERT_TRUE(file_stream.good());
+  string contents((std::istreambuf_iterator<char>(file_stream)),
+                  std::istreambuf_iterator<char>());
+
+  Minidump full(minidump_file_);
+  ASSERT_TRUE(full.Read());
+  MinidumpThreadList* threads = full.GetThreadList();
+  ASSERT_TRUE(threads != NULL);
+  ASSERT_GT(threads->thread_count(), 0U);
+  const MDRawThread* raw_thread = threads->GetThreadAtIndex(0)->thread();
+  ASSERT_TRUE(raw_thread != NULL);
+  uint32_t stack_rva = raw_thread->stack.memory.rva;
+  ASSERT_GT(raw_thread->stack.memory.data_size, 1U);
+
+  AutoTempDir temp_dir;
+  string truncated_file = temp_dir.path() + "/truncated.dmp";
+  std::ofstream out(truncated_file.c_str(), std::ios::out | std::ios::binary);
+  out.write(contents.data(), stack_rva + 1);
+  out.close();
+  ASSERT_TRUE(out.good());
+
+  Minidump truncated(truncated_file);
+  ASSERT_TRUE(truncated.Read());
+  MinidumpThreadList* truncated_threads = truncated.GetThreadList();
+  if (truncated_threads) {
+    MinidumpMemoryRegion* stack =
+        truncated_threads->GetThreadAtIndex(0)->GetMemory();
+    EXPECT_TRUE(stack == NULL || stack->GetMemory() == NULL);
+  }
+}
+
 TEST(Dump, ReadBackEmpty) {
   Dump dump(0);
   dump.Finish();
@@ -218,6 +307,197 @@ TEST(Dump, OneMemory) {
   ASSERT_TRUE(memcmp("memory contents", region1_bytes, 15) == 0);
 }
 
+TEST(Dump, MemoryAtAddresses) {
+  Dump dump(0, kBigEndian);
+  Memory memory(dump, 0x1000);
+  memory.D32(0x01020304).D32(0x05060708).D32(0x090a0b0c).D16(0x0d0e);
+  dump.Add(&memory);
+  dump.Finish();
+
+  string contents;
+  ASSERT_TRUE(dump.GetContents(&contents));
+  istringstream minidump_stream(contents);
+  Minidump minidump(minidump_stream);
+  ASSERT_TRUE(minidump.Read());
+  MinidumpMemoryList *memory_list = minidump.GetMemoryList();
+  ASSERT_TRUE(memory_list != NULL);
+  MinidumpMemoryRegion *region = memory_list->GetMemoryRegionAtIndex(0);
+  ASSERT_TRUE(region != NULL);
+
+  // Only as many values as fit in the region are read, byte-swapped as
+  // GetMemoryAtAddress swaps them.
+  uint32_t values32[4];
+  ASSERT_EQ(3U, region->GetMemoryAtAddresses(0x1000, values32, 4));
+  EXPECT_EQ(0x01020304U, values32[0]);
+  EXPECT_EQ(0x05060708U, values32[1]);
+  EXPECT_EQ(0x090a0b0cU, values32[2]);
+  ASSERT_EQ(2U, region->GetMemoryAtAddresses(0x1006, values32, 2));
+  EXPECT_EQ(0x0708090aU, values32[0]);
+  EXPECT_EQ(0x0b0c0d0eU, values32[1]);
+
+  uint64_t values64[2];
+  ASSERT_EQ(1U, region->GetMemoryAtAddresses(0x1000, values64, 2));
+  EXPECT_EQ(0x0102030405060708ULL, values64[0]);
+
+  // Nothing is read outside the region.
+  EXPECT_EQ(0U, region->GetMemoryAtAddresses(0x0ffc, values32, 4));
+  EXPECT_EQ(0U, region->GetMemoryAtAddresses(0x100c, values32, 4));
+  EXPECT_EQ(0U, region->GetMemoryAtAddresses(0x100e, values32, 4));
+}
+
+TEST(Dump, OneMemory64List) {
+  Dump dump(0, kBigEndian);
+  Stream stream(dump, MD_MEMORY_64_LIST_STREAM);
+  Label contents_rva;
+  stream.D64(3)                        // number_of_memory_ranges
+        .D64(contents_rva)             // base_rva
+        .D64(0x7fff00001000ULL)        // start_of_memory_range
+        .D64(15)                       // data_size
+        .D64(0x400000)
+        .D64(0)
+        .D64(0x12345000)
+        .D64(6);
+  dump.Add(&stream);
+
+  // The contents of the ranges, one after another.
+  Section contents(dump);
+  contents.Append("memory contents").Append("second");
+  contents_rva = dump.Size();
+  dump.Add(&contents);
+  dump.Finish();
+
+  string contents_string;
+  ASSERT_TRUE(dump.GetContents(&contents_string));
+  istringstream minidump_stream(contents_string);
+  Minidump minidump(minidump_stream);
+  ASSERT_TRUE(minidump.Read());
+  ASSERT_TRUE(minidump.GetMemoryList() == NULL);
+
+  MinidumpMemory64List *memory64_list = minidump.GetMemory64List();
+  ASSERT_TRUE(memory64_list != NULL);
+  // The empty range has no region.
+  ASSERT_EQ(2U, memory64_list->region_count());
+
+  MinidumpMemoryRegion *region1 = memory64_list->GetMemoryRegionAtIndex(0);
+  ASSERT_EQ(0x7fff00001000ULL, region1->GetBase());
+  ASSERT_EQ(15U, region1->GetSize());
+  ASSERT_TRUE(memcmp("memory contents", region1->GetMemory(), 15) == 0);
+
+  MinidumpMemoryRegion *region2 =
+      memory64_list->GetMemoryRegionForAddress(0x12345005);
+  ASSERT_TRUE(region2 == memory64_list->GetMemoryRegionAtIndex(1));
+  ASSERT_EQ(0x12345000U, region2->GetBase());
+  ASSERT_EQ(6U, region2->GetSize());
+  ASSERT_TRUE(memcmp("second", region2->GetMemory(), 6) == 0);
+
+  uint8_t value;
+  ASSERT_TRUE(region2->GetMemoryAtAddress(0x12345001, &value));
+  ASSERT_EQ('e', value);
+
+  ASSERT_TRUE(memory64_list->GetMemoryRegionForAddress(0x12345006) == NULL);
+  ASSERT_TRUE(memory64_list->GetMemoryRegionForAddress(0x400000) == NULL);
+
+  // Regions in address order.
+  ASSERT_TRUE(memory64_list->GetMemoryRegionAtOrAfterAddress(0) == region2);
+  ASSERT_TRUE(
+      memory64_list->GetMemoryRegionAtOrAfterAddress(0x12345005) == region2);
+  ASSERT_TRUE(
+      memory64_list->GetMemoryRegionAtOrAfterAddress(0x12345006) == region1);
+  ASSERT_TRUE(
+      memory64_list->GetMemoryRegionAtOrAfterAddress(0x7fff00001010ULL) ==
+      NULL);
+}
+
+TEST(Dump, Memory64ListSizeMismatch) {
+  Dump dump(0, kLittleEndian);
+  Stream stream(dump, MD_MEMORY_64_LIST_STREAM);
+  // Claims two ranges, but has a descriptor for only one.
+  stream.D64(2)
+        .D64(0)
+        .D64(0x1000)
+        .D64(0x10);
+  dump.Add(&stream);
+  dump.Finish();
+
+  string contents;
+  ASSERT_TRUE(dump.GetContents(&contents));
+  istringstream minidump_stream(contents);
+  Minidump minidump(minidump_stream);
+  ASSERT_TRUE(minidump.Read());
+  ASSERT_TRUE(minidump.GetMemory64List() == NULL);
+}
+
+TEST(Dump, Memory64ListRangeBeyondFile) {
+  // Ranges whose contents would extend past the end of the minidump are
+  // rejected, however they would be split into regions.
+  const uint64_t kSizes[] = { 0x1000, 1ULL << 40, 1ULL << 60 };
+  for (size_t i = 0; i < sizeof(kSizes) / sizeof(kSizes[0]); ++i) {
+    Dump dump(0, kLittleEndian);
+    Stream stream(dump, MD_MEMORY_64_LIST_STREAM);
+    Label contents_rva;
+    stream.D64(1)
+          .D64(contents_rva)
+          .D64(0x1000)
+          .D64(kSizes[i]);
+    dump.Add(&stream);
+    Section contents(dump);
+    contents.Append(16, 0xcc);
+    contents_rva = dump.Size();
+    dump.Add(&contents);
+    dump.Finish();
+
+    string contents_string;
+    ASSERT_TRUE(dump.GetContents(&contents_string));
+    istringstream minidump_stream(contents_string);
+    Minidump minidump(minidump_stream);
+    ASSERT_TRUE(minidump.Read());
+    EXPECT_TRUE(minidump.GetMemory64List() == NULL) << kSizes[i];
+  }
+}
+
+TEST(Dump, ThreadNameList) {
+  Dump dump(0, kBigEndian);
+  Stream stream(dump, MD_THREAD_NAME_LIST_STREAM);
+  Label name1_rva, name2_rva;
+  stream.D32(2)                        // number_of_thread_names
+        .D32(0x1234)                   // thread_id
+        .D64(name1_rva)                // thread_name_rva
+        .D32(0x5678)
+        .D64(name2_rva);
+  dump.Add(&stream);
+
+  String name1(dump, "io-poller");
+  name1_rva = dump.Size();
+  dump.Add(&name1);
+  String name2(dump, "worker");
+  name2_rva = dump.Size();
+  dump.Add(&name2);
+  dump.Finish();
+
+  string contents;
+  ASSERT_TRUE(dump.GetContents(&contents));
+  istringstream minidump_stream(contents);
+  Minidump minidump(minidump_stream);
+  ASSERT_TRUE(minidump.Read());
+
+  MinidumpThreadNameList *thread_name_list = minidump.GetThreadNameList();
+  ASSERT_TRUE(thread_name_list != NULL);
+  ASSERT_EQ(2U, thread_name_list->thread_name_count());
+
+  uint32_t thread_id;
+  string thread_name;
+  ASSERT_TRUE(thread_name_list->GetThreadNameAtIndex(1, &thread_id,
+                                                     &thread_name));
+  EXPECT_EQ(0x5678U, thread_id);
+  EXPECT_EQ("worker", thread_name);
+  ASSERT_FALSE(thread_name_list->GetThreadNameAtIndex(2, &thread_id,
+                                                      &thread_name));
+
+  ASSERT_TRUE(thread_name_list->GetThreadNameByID(0x1234, &thread_name));
+  EXPECT_EQ("io-poller", thread_name);
+  ASSERT_FALSE(thread_name_list->GetThreadNameByID(0x9abc, &thread_name));
+}
+
 // One thread --- and its requisite entourage.
 TEST(Dump, OneThread) {
   Dump dump(0, kLittleEndian);
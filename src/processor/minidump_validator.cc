@@ -0,0 +1,504 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// minidump_validator.cc: MinidumpValidator checks that a minidump is
+// structurally sound before it is processed.
+//
+// See minidump_validator.h for documentation.
+
+#include "google_breakpad/processor/minidump_validator.h"
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "google_breakpad/processor/minidump.h"
+#include "processor/logging.h"
+
+namespace google_breakpad {
+
+namespace {
+
+using std::numeric_limits;
+using std::pair;
+using std::vector;
+
+inline void Swap(uint32_t *value) {
+  *value = (*value >> 24) |
+           ((*value >> 8) & 0x0000ff00) |
+           ((*value << 8) & 0x00ff0000) |
+           (*value << 24);
+}
+
+inline void Swap(uint64_t *value) {
+  uint32_t low = static_cast<uint32_t>(*value);
+  uint32_t high = static_cast<uint32_t>(*value >> 32);
+  Swap(&low);
+  Swap(&high);
+  *value = (static_cast<uint64_t>(low) << 32) | high;
+}
+
+inline void Swap(MDLocationDescriptor *location) {
+  Swap(&location->data_size);
+  Swap(&location->rva);
+}
+
+// Returns true if |size| is the size of a CPU context that MinidumpContext
+// can read.
+bool IsContextSize(uint32_t size) {
+  return size == sizeof(MDRawContextX86) ||
+         size == sizeof(MDRawContextAMD64) ||
+         size == sizeof(MDRawContextPPC) ||
+         size == sizeof(MDRawContextPPC64) ||
+         size == sizeof(MDRawContextSPARC) ||
+         size == sizeof(MDRawContextARM) ||
+         size == sizeof(MDRawContextARM64) ||
+         size == sizeof(MDRawContextARM64_Old) ||
+         size == sizeof(MDRawContextMIPS);
+}
+
+}  // namespace
+
+MinidumpValidator::MinidumpValidator() : file_size_(0) {
+}
+
+MinidumpValidator::Result MinidumpValidator::Validate(Minidump *dump) {
+  error_.clear();
+  file_size_ = 0;
+
+  if (!dump->Read())
+    return Fail(INVALID_HEADER, "cannot read header and stream directory");
+
+  if (!dump->GetFileSize(&file_size_))
+    return Fail(INVALID_HEADER, "cannot determine file size");
+
+  // The header, the directory and every stream must lie within the file
+  // without overlapping.  Minidump::Read has already checked the count of
+  // streams against Minidump::max_streams, so this is bounded.
+  const MDRawHeader *header = dump->header();
+  unsigned int stream_count = dump->GetDirectoryEntryCount();
+  vector<pair<uint64_t, uint64_t> > extents;
+  extents.reserve(stream_count + 2);
+  extents.push_back(std::make_pair(0, sizeof(MDRawHeader)));
+  if (stream_count != 0) {
+    extents.push_back(std::make_pair(
+        header->stream_directory_rva,
+        static_cast<uint64_t>(stream_count) * sizeof(MDRawDirectory)));
+  }
+
+  for (unsigned int index = 0; index < stream_count; ++index) {
+    const MDRawDirectory *entry = dump->GetDirectoryEntryAtIndex(index);
+    if (!entry)
+      return Fail(INVALID_HEADER, "cannot read stream directory");
+    if (entry->stream_type == MD_UNUSED_STREAM ||
+        entry->location.data_size == 0) {
+      continue;
+    }
+    if (entry->location.rva > file_size_ ||
+        entry->location.data_size > file_size_ - entry->location.rva) {
+      std::ostringstream error;
+      error << "stream " << index << " at " << entry->location.rva << "+" <<
+               entry->location.data_size << " lies outside the file of " <<
+               file_size_ << " bytes";
+      return Fail(INVALID_STREAM_LOCATION, error.str());
+    }
+    extents.push_back(std::make_pair(entry->location.rva,
+                                     entry->location.data_size));
+  }
+
+  std::sort(extents.begin(), extents.end());
+  for (size_t index = 1; index < extents.size(); ++index) {
+    if (extents[index - 1].first + extents[index - 1].second >
+        extents[index].first) {
+      std::ostringstream error;
+      error << "data at " << extents[index].first << " overlaps " <<
+               extents[index - 1].first << "+" << extents[index - 1].second;
+      return Fail(INVALID_STREAM_LOCATION, error.str());
+    }
+  }
+
+  for (unsigned int index = 0; index < stream_count; ++index) {
+    const MDRawDirectory &entry = *dump->GetDirectoryEntryAtIndex(index);
+
+    Result (MinidumpValidator::*validate)(Minidump*, const MDRawDirectory&);
+    switch (entry.stream_type) {
+      case MD_THREAD_LIST_STREAM:
+        validate = &MinidumpValidator::ValidateThreadList;
+        break;
+      case MD_THREAD_NAME_LIST_STREAM:
+        validate = &MinidumpValidator::ValidateThreadNameList;
+        break;
+      case MD_MODULE_LIST_STREAM:
+        validate = &MinidumpValidator::ValidateModuleList;
+        break;
+      case MD_MEMORY_LIST_STREAM:
+        validate = &MinidumpValidator::ValidateMemoryList;
+        break;
+      case MD_MEMORY_64_LIST_STREAM:
+        validate = &MinidumpValidator::ValidateMemory64List;
+        break;
+      case MD_EXCEPTION_STREAM:
+        validate = &MinidumpValidator::ValidateException;
+        break;
+      default:
+        continue;
+    }
+
+    if (!dump->SeekSet(entry.location.rva))
+      return Fail(INVALID_STREAM_LOCATION, "cannot seek to stream");
+    Result result = (this->*validate)(dump, entry);
+    if (result != VALID)
+      return result;
+  }
+
+  return VALID;
+}
+
+// static
+const char *MinidumpValidator::ResultString(Result result) {
+  switch (result) {
+    case VALID:
+      return "valid";
+    case INVALID_HEADER:
+      return "invalid header";
+    case INVALID_STREAM_LOCATION:
+      return "invalid stream location";
+    case INVALID_STREAM_SIZE:
+      return "invalid stream size";
+    case TOO_MANY_RECORDS:
+      return "too many records";
+    case INVALID_DATA_LOCATION:
+      return "invalid data location";
+    case INVALID_CONTEXT_SIZE:
+      return "invalid context size";
+  }
+  return "unknown";
+}
+
+MinidumpValidator::Result MinidumpValidator::ValidateThreadList(
+    Minidump *dump, const MDRawDirectory &entry) {
+  uint32_t thread_count;
+  Result result = ReadListCount(dump, entry, "thread list",
+                                sizeof(MDRawThread), true,
+                                MinidumpThreadList::max_threads(),
+                                &thread_count);
+  if (result != VALID)
+    return result;
+
+  for (uint32_t index = 0; index < thread_count; ++index) {
+    MDRawThread thread;
+    if (!dump->ReadBytes(&thread, sizeof(thread)))
+      return Fail(INVALID_STREAM_SIZE, "cannot read thread");
+    if (dump->swap()) {
+      Swap(&thread.stack.start_of_memory_range);
+      Swap(&thread.stack.memory);
+      Swap(&thread.thread_context);
+    }
+
+    if (thread.stack.memory.data_size != 0) {
+      if (thread.stack.memory.data_size >
+          numeric_limits<uint64_t>::max() -
+          thread.stack.start_of_memory_range) {
+        return Fail(INVALID_DATA_LOCATION, "thread stack wraps around");
+      }
+      result = CheckLocation(thread.stack.memory.rva,
+                             thread.stack.memory.data_size,
+                             "thread stack", index);
+      if (result != VALID)
+        return result;
+    }
+
+    result = CheckContext(thread.thread_context, "thread context", index);
+    if (result != VALID)
+      return result;
+  }
+
+  return VALID;
+}
+
+MinidumpValidator::Result MinidumpValidator::ValidateThreadNameList(
+    Minidump *dump, const MDRawDirectory &entry) {
+  uint32_t name_count;
+  Result result = ReadListCount(dump, entry, "thread name list",
+                                sizeof(MDRawThreadName), false,
+                                MinidumpThreadNameList::max_thread_names(),
+                                &name_count);
+  if (result != VALID)
+    return result;
+
+  for (uint32_t index = 0; index < name_count; ++index) {
+    MDRawThreadName thread_name;
+    if (!dump->ReadBytes(&thread_name, sizeof(thread_name)))
+      return Fail(INVALID_STREAM_SIZE, "cannot read thread name");
+    uint64_t rva = thread_name.thread_name_rva;
+    if (dump->swap())
+      Swap(&rva);
+
+    result = CheckLocation(rva, MDString_minsize, "thread name", index);
+    if (result != VALID)
+      return result;
+  }
+
+  return VALID;
+}
+
+MinidumpValidator::Result MinidumpValidator::ValidateModuleList(
+    Minidump *dump, const MDRawDirectory &entry) {
+  uint32_t module_count;
+  Result result = ReadListCount(dump, entry, "module list", MD_MODULE_SIZE,
+                                true, MinidumpModuleList::max_modules(),
+                                &module_count);
+  if (result != VALID)
+    return result;
+
+  for (uint32_t index = 0; index < module_count; ++index) {
+    MDRawModule module;
+    if (!dump->ReadBytes(&module, MD_MODULE_SIZE))
+      return Fail(INVALID_STREAM_SIZE, "cannot read module");
+    if (dump->swap()) {
+      Swap(&module.base_of_image);
+      Swap(&module.size_of_image);
+      Swap(&module.module_name_rva);
+      Swap(&module.cv_record);
+      Swap(&module.misc_record);
+    }
+
+    if (module.size_of_image == 0 ||
+        module.size_of_image >
+        numeric_limits<uint64_t>::max() - module.base_of_image) {
+      std::ostringstream error;
+      error << "module " << index << " has an invalid size";
+      return Fail(INVALID_DATA_LOCATION, error.str());
+    }
+
+    result = CheckLocation(module.module_name_rva, MDString_minsize,
+                           "module name", index);
+    if (result == VALID) {
+      result = CheckLocation(module.cv_record.rva,
+                             module.cv_record.data_size,
+                             "module CodeView record", index);
+    }
+    if (result == VALID) {
+      result = CheckLocation(module.misc_record.rva,
+                             module.misc_record.data_size,
+                             "module misc record", index);
+    }
+    if (result != VALID)
+      return result;
+  }
+
+  return VALID;
+}
+
+MinidumpValidator::Result MinidumpValidator::ValidateMemoryList(
+    Minidump *dump, const MDRawDirectory &entry) {
+  uint32_t region_count;
+  Result result = ReadListCount(dump, entry, "memory list",
+                                sizeof(MDMemoryDescriptor), true,
+                                MinidumpMemoryList::max_regions(),
+                                &region_count);
+  if (result != VALID)
+    return result;
+
+  for (uint32_t index = 0; index < region_count; ++index) {
+    MDMemoryDescriptor descriptor;
+    if (!dump->ReadBytes(&descriptor, sizeof(descriptor)))
+      return Fail(INVALID_STREAM_SIZE, "cannot read memory descriptor");
+    if (dump->swap()) {
+      Swap(&descriptor.start_of_memory_range);
+      Swap(&descriptor.memory);
+    }
+
+    if (descriptor.memory.data_size == 0 ||
+        descriptor.memory.data_size >
+        numeric_limits<uint64_t>::max() - descriptor.start_of_memory_range) {
+      std::ostringstream error;
+      error << "memory region " << index << " has an invalid size";
+      return Fail(INVALID_DATA_LOCATION, error.str());
+    }
+
+    result = CheckLocation(descriptor.memory.rva, descriptor.memory.data_size,
+                           "memory region", index);
+    if (result != VALID)
+      return result;
+  }
+
+  return VALID;
+}
+
+MinidumpValidator::Result MinidumpValidator::ValidateMemory64List(
+    Minidump *dump, const MDRawDirectory &entry) {
+  uint64_t range_count;
+  MDRVA64 base_rva;
+  if (entry.location.data_size < MDRawMemory64List_minsize ||
+      !dump->ReadBytes(&range_count, sizeof(range_count)) ||
+      !dump->ReadBytes(&base_rva, sizeof(base_rva))) {
+    return Fail(INVALID_STREAM_SIZE, "cannot read 64-bit memory list header");
+  }
+  if (dump->swap()) {
+    Swap(&range_count);
+    Swap(&base_rva);
+  }
+
+  if (range_count > MinidumpMemory64List::max_regions()) {
+    std::ostringstream error;
+    error << "64-bit memory list count " << range_count <<
+             " exceeds maximum " << MinidumpMemory64List::max_regions();
+    return Fail(TOO_MANY_RECORDS, error.str());
+  }
+
+  // range_count is now small enough that this can't overflow.
+  if (entry.location.data_size != MDRawMemory64List_minsize +
+                                  range_count * sizeof(MDMemoryDescriptor64)) {
+    return Fail(INVALID_STREAM_SIZE,
+                "64-bit memory list size doesn't match its count");
+  }
+
+  // The ranges' contents lie one after another from base_rva.
+  uint64_t total_size = 0;
+  for (uint64_t index = 0; index < range_count; ++index) {
+    MDMemoryDescriptor64 descriptor;
+    if (!dump->ReadBytes(&descriptor, sizeof(descriptor)))
+      return Fail(INVALID_STREAM_SIZE, "cannot read 64-bit memory descriptor");
+    if (dump->swap()) {
+      Swap(&descriptor.start_of_memory_range);
+      Swap(&descriptor.data_size);
+    }
+
+    if (descriptor.data_size >
+        numeric_limits<uint64_t>::max() - descriptor.start_of_memory_range ||
+        descriptor.data_size > file_size_ - total_size) {
+      std::ostringstream error;
+      error << "64-bit memory region " << index << " has an invalid size";
+      return Fail(INVALID_DATA_LOCATION, error.str());
+    }
+    total_size += descriptor.data_size;
+  }
+
+  return CheckLocation(base_rva, total_size, "64-bit memory regions", 0);
+}
+
+MinidumpValidator::Result MinidumpValidator::ValidateException(
+    Minidump *dump, const MDRawDirectory &entry) {
+  MDRawExceptionStream exception;
+  if (entry.location.data_size != sizeof(exception) ||
+      !dump->ReadBytes(&exception, sizeof(exception))) {
+    return Fail(INVALID_STREAM_SIZE, "cannot read exception stream");
+  }
+  if (dump->swap())
+    Swap(&exception.thread_context);
+
+  return CheckContext(exception.thread_context, "exception context", 0);
+}
+
+MinidumpValidator::Result MinidumpValidator::ReadListCount(
+    Minidump *dump,
+    const MDRawDirectory &entry,
+    const char *stream_name,
+    size_t record_size,
+    bool may_be_padded,
+    uint32_t max_count,
+    uint32_t *count) {
+  uint32_t list_count;
+  if (entry.location.data_size < sizeof(list_count) ||
+      !dump->ReadBytes(&list_count, sizeof(list_count))) {
+    std::ostringstream error;
+    error << "cannot read " << stream_name << " count";
+    return Fail(INVALID_STREAM_SIZE, error.str());
+  }
+  if (dump->swap())
+    Swap(&list_count);
+
+  if (list_count > max_count) {
+    std::ostringstream error;
+    error << stream_name << " count " << list_count << " exceeds maximum " <<
+             max_count;
+    return Fail(TOO_MANY_RECORDS, error.str());
+  }
+
+  uint64_t size = sizeof(list_count) +
+                  static_cast<uint64_t>(list_count) * record_size;
+  if (may_be_padded && entry.location.data_size == size + 4) {
+    // Some writers align the records to 8 bytes.
+    uint32_t padding;
+    if (!dump->ReadBytes(&padding, sizeof(padding))) {
+      std::ostringstream error;
+      error << "cannot read " << stream_name << " padding";
+      return Fail(INVALID_STREAM_SIZE, error.str());
+    }
+  } else if (entry.location.data_size != size) {
+    std::ostringstream error;
+    error << stream_name << " size " << entry.location.data_size <<
+             " doesn't match count " << list_count;
+    return Fail(INVALID_STREAM_SIZE, error.str());
+  }
+
+  *count = list_count;
+  return VALID;
+}
+
+MinidumpValidator::Result MinidumpValidator::CheckLocation(
+    uint64_t rva, uint64_t size, const char *what, uint32_t index) {
+  if (rva > file_size_ || size > file_size_ - rva) {
+    std::ostringstream error;
+    error << what << " " << index << " at " << rva << "+" << size <<
+             " lies outside the file of " << file_size_ << " bytes";
+    return Fail(INVALID_DATA_LOCATION, error.str());
+  }
+  return VALID;
+}
+
+MinidumpValidator::Result MinidumpValidator::CheckContext(
+    const MDLocationDescriptor &location, const char *what, uint32_t index) {
+  // Processing copes with a missing context, but not a malformed one.
+  if (location.data_size == 0 && location.rva == 0)
+    return VALID;
+
+  if (!IsContextSize(location.data_size)) {
+    std::ostringstream error;
+    error << what << " " << index << " has unknown size " <<
+             location.data_size;
+    return Fail(INVALID_CONTEXT_SIZE, error.str());
+  }
+  return CheckLocation(location.rva, location.data_size, what, index);
+}
+
+MinidumpValidator::Result MinidumpValidator::Fail(Result result,
+                                                  const string &error) {
+  error_ = error;
+  BPLOG(INFO) << "MinidumpValidator: " << ResultString(result) << ": " <<
+                 error;
+  return result;
+}
+
+}  // namespace google_breakpad
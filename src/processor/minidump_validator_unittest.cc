@@ -0,0 +1,275 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// minidump_validator_unittest.cc: Unit tests for MinidumpValidator.
+
+#include <string.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "breakpad_googletest_includes.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/common/minidump_format.h"
+#include "google_breakpad/processor/minidump.h"
+#include "google_breakpad/processor/minidump_validator.h"
+#include "processor/synth_minidump.h"
+
+namespace {
+
+using google_breakpad::Minidump;
+using google_breakpad::MinidumpThreadList;
+using google_breakpad::MinidumpValidator;
+using google_breakpad::SynthMinidump::Context;
+using google_breakpad::SynthMinidump::Dump;
+using google_breakpad::SynthMinidump::Memory;
+using google_breakpad::SynthMinidump::Module;
+using google_breakpad::SynthMinidump::Section;
+using google_breakpad::SynthMinidump::Stream;
+using google_breakpad::SynthMinidump::String;
+using google_breakpad::SynthMinidump::Thread;
+using google_breakpad::test_assembler::kBigEndian;
+using google_breakpad::test_assembler::kLittleEndian;
+using google_breakpad::test_assembler::Endianness;
+using std::istringstream;
+
+class MinidumpValidatorTest : public ::testing::Test {
+ public:
+  // Returns the result of validating |contents|.
+  MinidumpValidator::Result Validate(const string &contents) {
+    istringstream minidump_stream(contents);
+    Minidump minidump(minidump_stream);
+    return validator_.Validate(&minidump);
+  }
+
+  // Adds a thread, its stack and its context, and a module to |dump|, and
+  // finishes it.
+  void AddThreadAndModule(Dump *dump) {
+    Memory *stack = new Memory(*dump, 0x2326a0fa);
+    stack->Append("stack for thread");
+    sections_.push_back(stack);
+
+    // The validator only checks the context's size.
+    Context *context = new Context(*dump);
+    context->Append(sizeof(MDRawContextAMD64), 0);
+    sections_.push_back(context);
+
+    Thread *thread = new Thread(*dump, 0xa898f11b, *stack, *context,
+                                0x9e39439f, 0x4abfc15f, 0xe499898a,
+                                0x0d43e939dcfd0372ULL);
+    sections_.push_back(thread);
+
+    String *name = new String(*dump, "module name");
+    sections_.push_back(name);
+    Module *module = new Module(*dump, 0x400000, 0x1000, *name);
+    sections_.push_back(module);
+
+    dump->Add(stack);
+    dump->Add(context);
+    dump->Add(thread);
+    dump->Add(name);
+    dump->Add(module);
+    dump->Finish();
+  }
+
+  // Returns the offset in the little-endian minidump |contents| of the
+  // directory entry for the stream of type |stream_type|, or 0 if there is
+  // none.
+  size_t FindDirectoryEntry(const string &contents, uint32_t stream_type) {
+    MDRawHeader header;
+    memcpy(&header, contents.data(), sizeof(header));
+    for (uint32_t index = 0; index < header.stream_count; ++index) {
+      size_t offset = header.stream_directory_rva +
+                      index * sizeof(MDRawDirectory);
+      MDRawDirectory entry;
+      memcpy(&entry, contents.data() + offset, sizeof(entry));
+      if (entry.stream_type == stream_type)
+        return offset;
+    }
+    return 0;
+  }
+
+  // Sets the location of the stream of type |stream_type| in the
+  // little-endian minidump |contents|.
+  void SetStreamLocation(string *contents, uint32_t stream_type,
+                         uint32_t data_size, uint32_t rva) {
+    size_t offset = FindDirectoryEntry(*contents, stream_type);
+    ASSERT_NE(0U, offset);
+    MDRawDirectory entry;
+    entry.stream_type = stream_type;
+    entry.location.data_size = data_size;
+    entry.location.rva = rva;
+    memcpy(&(*contents)[offset], &entry, sizeof(entry));
+  }
+
+  // Returns the location of the stream of type |stream_type| in the
+  // little-endian minidump |contents|.
+  MDLocationDescriptor GetStreamLocation(const string &contents,
+                                         uint32_t stream_type) {
+    MDRawDirectory entry = {};
+    size_t offset = FindDirectoryEntry(contents, stream_type);
+    if (offset != 0)
+      memcpy(&entry, contents.data() + offset, sizeof(entry));
+    return entry.location;
+  }
+
+  ~MinidumpValidatorTest() {
+    for (size_t i = 0; i < sections_.size(); ++i)
+      delete sections_[i];
+  }
+
+  MinidumpValidator validator_;
+  std::vector<Section*> sections_;
+};
+
+TEST_F(MinidumpValidatorTest, WellFormed) {
+  Endianness endiannesses[] = { kLittleEndian, kBigEndian };
+  for (size_t i = 0; i < sizeof(endiannesses) / sizeof(endiannesses[0]);
+       ++i) {
+    Dump dump(0, endiannesses[i]);
+    AddThreadAndModule(&dump);
+    string contents;
+    ASSERT_TRUE(dump.GetContents(&contents));
+    EXPECT_EQ(MinidumpValidator::VALID, Validate(contents));
+    EXPECT_EQ("", validator_.error());
+  }
+}
+
+TEST_F(MinidumpValidatorTest, NotAMinidump) {
+  EXPECT_EQ(MinidumpValidator::INVALID_HEADER,
+            Validate("This is not a minidump, though it's long enough."));
+  EXPECT_NE("", validator_.error());
+}
+
+TEST_F(MinidumpValidatorTest, StreamOutsideFile) {
+  Dump dump(0, kLittleEndian);
+  AddThreadAndModule(&dump);
+  string contents;
+  ASSERT_TRUE(dump.GetContents(&contents));
+
+  MDLocationDescriptor location =
+      GetStreamLocation(contents, MD_MODULE_LIST_STREAM);
+  SetStreamLocation(&contents, MD_MODULE_LIST_STREAM, location.data_size,
+                    contents.size() - location.data_size + 1);
+  EXPECT_EQ(MinidumpValidator::INVALID_STREAM_LOCATION, Validate(contents));
+}
+
+TEST_F(MinidumpValidatorTest, OverlappingStreams) {
+  Dump dump(0, kLittleEndian);
+  AddThreadAndModule(&dump);
+  string contents;
+  ASSERT_TRUE(dump.GetContents(&contents));
+
+  // Move the module list onto the end of the thread list.
+  MDLocationDescriptor threads =
+      GetStreamLocation(contents, MD_THREAD_LIST_STREAM);
+  MDLocationDescriptor modules =
+      GetStreamLocation(contents, MD_MODULE_LIST_STREAM);
+  SetStreamLocation(&contents, MD_MODULE_LIST_STREAM, modules.data_size,
+                    threads.rva + threads.data_size - 4);
+  EXPECT_EQ(MinidumpValidator::INVALID_STREAM_LOCATION, Validate(contents));
+}
+
+TEST_F(MinidumpValidatorTest, ThreadCountMismatch) {
+  Dump dump(0, kLittleEndian);
+  Stream threads(dump, MD_THREAD_LIST_STREAM);
+  threads.D32(2)                       // number_of_threads
+         .Append(sizeof(MDRawThread), 0);
+  dump.Add(&threads);
+  dump.Finish();
+  string contents;
+  ASSERT_TRUE(dump.GetContents(&contents));
+  EXPECT_EQ(MinidumpValidator::INVALID_STREAM_SIZE, Validate(contents));
+}
+
+TEST_F(MinidumpValidatorTest, TooManyThreads) {
+  Dump dump(0, kLittleEndian);
+  Stream threads(dump, MD_THREAD_LIST_STREAM);
+  threads.D32(2)                       // number_of_threads
+         .Append(2 * sizeof(MDRawThread), 0);
+  dump.Add(&threads);
+  dump.Finish();
+  string contents;
+  ASSERT_TRUE(dump.GetContents(&contents));
+  EXPECT_EQ(MinidumpValidator::VALID, Validate(contents));
+
+  uint32_t max_threads = MinidumpThreadList::max_threads();
+  MinidumpThreadList::set_max_threads(1);
+  EXPECT_EQ(MinidumpValidator::TOO_MANY_RECORDS, Validate(contents));
+  MinidumpThreadList::set_max_threads(max_threads);
+}
+
+TEST_F(MinidumpValidatorTest, BadContextSize) {
+  Dump dump(0, kLittleEndian);
+  Memory stack(dump, 0x2326a0fa);
+  stack.Append("stack for thread");
+  Context context(dump);
+  context.Append(10, 0);
+  Thread thread(dump, 0xa898f11b, stack, context);
+  dump.Add(&stack);
+  dump.Add(&context);
+  dump.Add(&thread);
+  dump.Finish();
+  string contents;
+  ASSERT_TRUE(dump.GetContents(&contents));
+  EXPECT_EQ(MinidumpValidator::INVALID_CONTEXT_SIZE, Validate(contents));
+}
+
+TEST_F(MinidumpValidatorTest, MemoryOutsideFile) {
+  Dump dump(0, kLittleEndian);
+  Stream memory(dump, MD_MEMORY_LIST_STREAM);
+  memory.D32(1)                        // number_of_memory_ranges
+        .D64(0x1000)                   // start_of_memory_range
+        .D32(16)                       // memory.data_size
+        .D32(0x100000);                // memory.rva
+  dump.Add(&memory);
+  dump.Finish();
+  string contents;
+  ASSERT_TRUE(dump.GetContents(&contents));
+  EXPECT_EQ(MinidumpValidator::INVALID_DATA_LOCATION, Validate(contents));
+}
+
+TEST_F(MinidumpValidatorTest, Memory64OutsideFile) {
+  Dump dump(0, kBigEndian);
+  Stream memory(dump, MD_MEMORY_64_LIST_STREAM);
+  memory.D64(2)                        // number_of_memory_ranges
+        .D64(0x20)                     // base_rva
+        .D64(0x1000)                   // start_of_memory_range
+        .D64(0x10)                     // data_size
+        .D64(0x2000)
+        .D64(0x100000);
+  dump.Add(&memory);
+  dump.Finish();
+  string contents;
+  ASSERT_TRUE(dump.GetContents(&contents));
+  EXPECT_EQ(MinidumpValidator::INVALID_DATA_LOCATION, Validate(contents));
+}
+
+}  // namespace
@@ -83,6 +83,41 @@ bool ModuleComparer::Compare(const string &symbol_data) {
   return true;
 }
 
+bool ModuleComparer::CompareFastSymbolFile(const string &symbol_data) {
+  scoped_ptr<BasicModule> basic_module(new BasicModule("test_module"));
+  scoped_ptr<BasicModule> lazy_module(new BasicModule("test_module", true));
+  scoped_ptr<FastModule> fast_module(new FastModule("test_module"));
+
+  // Load symbol data into basic_module, and into lazy_module, which keeps
+  // pointing into its buffer.
+  scoped_array<char> buffer(new char[symbol_data.size() + 1]);
+  memcpy(buffer.get(), symbol_data.c_str(), symbol_data.size());
+  buffer.get()[symbol_data.size()] = '\0';
+  scoped_array<char> lazy_buffer(new char[symbol_data.size() + 1]);
+  memcpy(lazy_buffer.get(), buffer.get(), symbol_data.size() + 1);
+  ASSERT_TRUE(basic_module->LoadMapFromMemory(buffer.get(),
+                                              symbol_data.size() + 1));
+  buffer.reset();
+  ASSERT_TRUE(lazy_module->LoadMapFromMemory(lazy_buffer.get(),
+                                             symbol_data.size() + 1));
+
+  // Serialize the lazy module as a fast symbol file.
+  unsigned int file_size = 0;
+  scoped_array<char> file_data(
+      serializer_.SerializeFastSymbolFile(*(lazy_module.get()), &file_size));
+  ASSERT_TRUE(file_data.get());
+  lazy_module.reset();
+  lazy_buffer.reset();
+
+  // Load FastSourceLineResolver::Module using the file image.
+  ASSERT_TRUE(fast_module->LoadMapFromMemory(file_data.get(), file_size));
+  ASSERT_TRUE(fast_module->IsCorrupt() == basic_module->IsCorrupt());
+
+  ASSERT_TRUE(CompareModule(basic_module.get(), fast_module.get()));
+
+  return true;
+}
+
 // Traversal the content of module and do comparison
 bool ModuleComparer::CompareModule(const BasicModule *basic_module,
                                   const FastModule *fast_module) const {
@@ -197,7 +232,7 @@ bool ModuleComparer::CompareFunction(const BasicFunc *basic_func,
   ASSERT_TRUE(basic_func->size == fast_func->size);
 
   // compare range map of lines:
-  RangeMap<MemAddr, linked_ptr<BasicLine> >::MapConstIterator iter1;
+  RangeMap<MemAddr, BasicLine>::MapConstIterator iter1;
   StaticRangeMap<MemAddr, FastLine>::MapConstIterator iter2;
   iter1 = basic_func->lines.map_.begin();
   iter2 = fast_func->lines.map_.begin();
@@ -205,8 +240,8 @@ bool ModuleComparer::CompareFunction(const BasicFunc *basic_func,
       && iter2 != fast_func->lines.map_.end()) {
     ASSERT_TRUE(iter1->first == iter2.GetKey());
     ASSERT_TRUE(iter1->second.base() == iter2.GetValuePtr()->base());
-    ASSERT_TRUE(CompareLine(iter1->second.entry().get(),
-                            iter2.GetValuePtr()->entryptr()));
+    BasicLine basic_line = iter1->second.entry();
+    ASSERT_TRUE(CompareLine(&basic_line, iter2.GetValuePtr()->entryptr()));
     ++iter1;
     ++iter2;
   }
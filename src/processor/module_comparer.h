@@ -66,6 +66,11 @@ class ModuleComparer {
   // return true if both modules contain exactly same data.
   bool Compare(const string &symbol_data);
 
+  // Like Compare(), but the module serialized is loaded lazily and written
+  // with ModuleSerializer::SerializeFastSymbolFile(), and compared with
+  // one loaded in full.
+  bool CompareFastSymbolFile(const string &symbol_data);
+
  private:
   typedef BasicSourceLineResolver::Module BasicModule;
   typedef FastSourceLineResolver::Module FastModule;
@@ -51,11 +51,18 @@ class ModuleFactory {
 
 class BasicModuleFactory : public ModuleFactory {
  public:
+  BasicModuleFactory() : lazy_parsing_(false) { }
   virtual ~BasicModuleFactory() { }
   virtual BasicSourceLineResolver::Module* CreateModule(
       const string &name) const {
-    return new BasicSourceLineResolver::Module(name);
+    return new BasicSourceLineResolver::Module(name, lazy_parsing_);
   }
+
+  void set_lazy_parsing(bool lazy) { lazy_parsing_ = lazy; }
+  bool lazy_parsing() const { return lazy_parsing_; }
+
+ private:
+  bool lazy_parsing_;
 };
 
 class FastModuleFactory : public ModuleFactory {
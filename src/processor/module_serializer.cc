@@ -35,6 +35,10 @@
 
 #include "processor/module_serializer.h"
 
+#include <stdio.h>
+#include <string.h>
+
+#include <limits>
 #include <map>
 #include <string>
 
@@ -45,10 +49,13 @@ namespace google_breakpad {
 
 // Definition of static member variable in SimplerSerializer<Funcion>, which
 // is declared in file "simple_serializer-inl.h"
-RangeMapSerializer< MemAddr, linked_ptr<BasicSourceLineResolver::Line> >
+RangeMapSerializer<MemAddr, BasicSourceLineResolver::Line>
 SimpleSerializer<BasicSourceLineResolver::Function>::range_map_serializer_;
 
 size_t ModuleSerializer::SizeOf(const BasicSourceLineResolver::Module &module) {
+  // A lazily loaded module may not have parsed all its functions yet.
+  module.ParseAllDeferredRecords();
+
   size_t total_size_alloc_ = 0;
 
   // Size of the "is_corrupt" flag.
@@ -62,10 +69,19 @@ size_t ModuleSerializer::SizeOf(const BasicSourceLineResolver::Module &module) {
   for (int i = 0; i < WindowsFrameInfo::STACK_INFO_LAST; ++i)
    map_sizes_[map_index++] =
        wfi_serializer_.SizeOf(&(module.windows_frame_info_[i]));
-  map_sizes_[map_index++] = cfi_init_rules_serializer_.SizeOf(
-     module.cfi_initial_rules_);
-  map_sizes_[map_index++] = cfi_delta_rules_serializer_.SizeOf(
-     module.cfi_delta_rules_);
+  // A lazy module's rules point into its symbol data; they serialize the
+  // same way.
+  if (module.lazy_) {
+    map_sizes_[map_index++] = lazy_cfi_init_rules_serializer_.SizeOf(
+       module.lazy_cfi_initial_rules_);
+    map_sizes_[map_index++] = lazy_cfi_delta_rules_serializer_.SizeOf(
+       module.lazy_cfi_delta_rules_);
+  } else {
+    map_sizes_[map_index++] = cfi_init_rules_serializer_.SizeOf(
+       module.cfi_initial_rules_);
+    map_sizes_[map_index++] = cfi_delta_rules_serializer_.SizeOf(
+       module.cfi_delta_rules_);
+  }
 
   // Header size.
   total_size_alloc_ += kNumberMaps_ * sizeof(uint32_t);
@@ -82,6 +98,9 @@ size_t ModuleSerializer::SizeOf(const BasicSourceLineResolver::Module &module) {
 
 char *ModuleSerializer::Write(const BasicSourceLineResolver::Module &module,
                               char *dest) {
+  // Normally done by SizeOf() already, in which case nothing is left.
+  module.ParseAllDeferredRecords();
+
   // Write the is_corrupt flag.
   dest = SimpleSerializer<bool>::Write(module.is_corrupt_, dest);
   // Write header.
@@ -93,8 +112,15 @@ char *ModuleSerializer::Write(const BasicSourceLineResolver::Module &module,
   dest = pubsym_serializer_.Write(module.public_symbols_, dest);
   for (int i = 0; i < WindowsFrameInfo::STACK_INFO_LAST; ++i)
     dest = wfi_serializer_.Write(&(module.windows_frame_info_[i]), dest);
-  dest = cfi_init_rules_serializer_.Write(module.cfi_initial_rules_, dest);
-  dest = cfi_delta_rules_serializer_.Write(module.cfi_delta_rules_, dest);
+  if (module.lazy_) {
+    dest = lazy_cfi_init_rules_serializer_.Write(
+        module.lazy_cfi_initial_rules_, dest);
+    dest = lazy_cfi_delta_rules_serializer_.Write(
+        module.lazy_cfi_delta_rules_, dest);
+  } else {
+    dest = cfi_init_rules_serializer_.Write(module.cfi_initial_rules_, dest);
+    dest = cfi_delta_rules_serializer_.Write(module.cfi_delta_rules_, dest);
+  }
   // Write a null terminator.
   dest = SimpleSerializer<char>::Write(0, dest);
   return dest;
@@ -130,6 +156,108 @@ char* ModuleSerializer::Serialize(
   return serialized_data;
 }
 
+char* ModuleSerializer::SerializeFastSymbolFile(
+    const BasicSourceLineResolver::Module &module, unsigned int *size) {
+  // Compute size of memory to allocate.  The header records it in 32 bits.
+  size_t module_size = SizeOf(module);
+  if (module_size > std::numeric_limits<uint32_t>::max() -
+                    sizeof(FastSymbolFileHeader)) {
+    BPLOG(ERROR) << "Module is too large for a fast symbol file: "
+                 << module_size << " bytes";
+    if (size)
+      *size = 0;
+    return NULL;
+  }
+  unsigned int data_size = static_cast<unsigned int>(module_size);
+  unsigned int size_to_alloc = sizeof(FastSymbolFileHeader) + data_size;
+
+  // Write serialized data after the room left for the header.
+  char *file_data = new char[size_to_alloc];
+  char *data = file_data + sizeof(FastSymbolFileHeader);
+  char *end_address = Write(module, data);
+  unsigned int size_written = static_cast<unsigned int>(end_address - data);
+  if (data_size != size_written) {
+    BPLOG(ERROR) << "data_size differs from size_written: "
+                 << data_size << " vs " << size_written;
+  }
+
+  // The header's checksum covers the data, so it is filled in last.
+  FastSymbolFileHeader header = FastSymbolFileHeader::ForData(data, data_size);
+  memcpy(file_data, &header, sizeof(header));
+
+  if (size)
+    *size = size_to_alloc;
+  return file_data;
+}
+
+bool ModuleSerializer::ConvertSymbolFileToFastSymbolFile(
+    const string &symbol_file, const string &fast_symbol_file) {
+  char *symbol_data;
+  size_t symbol_data_size;
+  if (!SourceLineResolverBase::ReadSymbolFile(symbol_file, &symbol_data,
+                                              &symbol_data_size)) {
+    return false;
+  }
+  scoped_array<char> buffer(symbol_data);
+
+  BasicSourceLineResolver::Module module(symbol_file);
+  if (!module.LoadMapFromMemory(buffer.get(), symbol_data_size)) {
+    BPLOG(ERROR) << "Could not parse symbol file " << symbol_file;
+    return false;
+  }
+  buffer.reset();
+
+  unsigned int size = 0;
+  scoped_array<char> file_data(SerializeFastSymbolFile(module, &size));
+  if (!file_data.get())
+    return false;
+
+  // The file is written under another name and renamed into place, so that
+  // a resolver that has the old file mapped never sees it truncated.
+  string temp_file = fast_symbol_file + ".tmp";
+  FILE *f = fopen(temp_file.c_str(), "wb");
+  if (!f) {
+    BPLOG(ERROR) << "Could not open " << temp_file << " for writing";
+    return false;
+  }
+  bool write_result = fwrite(file_data.get(), 1, size, f) == size;
+  if (fclose(f) != 0)
+    write_result = false;
+  if (!write_result) {
+    BPLOG(ERROR) << "Could not write " << temp_file;
+    remove(temp_file.c_str());
+    return false;
+  }
+
+  // FastSourceLineResolver doesn't verify checksums by default, so check
+  // what was written here instead.
+  bool verified = false;
+  f = fopen(temp_file.c_str(), "rb");
+  if (f) {
+    // Reading one byte more than expected catches a file that is too long.
+    scoped_array<char> written(new char[size + 1]);
+    size_t written_size = fread(written.get(), 1, size + 1, f);
+    verified = written_size == size &&
+               FastSymbolFileHeader::Validate(written.get(), written_size,
+                                              true);
+    fclose(f);
+  }
+  if (!verified) {
+    BPLOG(ERROR) << "Fast symbol file " << temp_file
+                 << " does not read back as written";
+    remove(temp_file.c_str());
+    return false;
+  }
+
+  if (rename(temp_file.c_str(), fast_symbol_file.c_str()) != 0) {
+    BPLOG(ERROR) << "Could not rename " << temp_file << " to "
+                 << fast_symbol_file;
+    remove(temp_file.c_str());
+    return false;
+  }
+  return true;
+}
+
 bool ModuleSerializer::SerializeModuleAndLoadIntoFastResolver(
     const BasicSourceLineResolver::ModuleMap::const_iterator &iter,
     FastSourceLineResolver *fast_resolver) {
@@ -60,7 +60,8 @@ namespace google_breakpad {
 class ModuleSerializer {
  public:
   // Compute the size of memory required to serialize a module.  Return the
-  // total size needed for serialization.
+  // total size needed for serialization.  A lazily loaded module parses
+  // whatever records it deferred first.
   size_t SizeOf(const BasicSourceLineResolver::Module &module);
 
   // Write a module into an allocated memory chunk with required size.
@@ -81,6 +82,26 @@ class ModuleSerializer {
   char* SerializeSymbolFileData(const string &symbol_data,
                                 unsigned int *size = NULL);
 
+  // Serializes a loaded Module object into a fast symbol file image: a
+  // FastSymbolFileHeader followed by the data Serialize() produces, or
+  // returns NULL if that is 4 GB or more.  Written to disk, the image can be
+  // mapped and used in place by FastSourceLineResolver::LoadModule().  If
+  // size != NULL, *size is set to the size of the image.  Caller takes
+  // ownership of the memory chunk (on heap), and owner should call delete []
+  // to free the memory after use.
+  char* SerializeFastSymbolFile(const BasicSourceLineResolver::Module &module,
+                                unsigned int *size = NULL);
+
+  // Reads the string format symbol file symbol_file and writes it to
+  // fast_symbol_file as a fast symbol file.  The file is written next to
+  // fast_symbol_file, read back and checked against its checksum, then
+  // renamed over fast_symbol_file, so a resolver using an older
+  // fast_symbol_file keeps a consistent mapping.  Returns false if
+  // symbol_file cannot be read or parsed, or fast_symbol_file cannot be
+  // written.
+  bool ConvertSymbolFileToFastSymbolFile(const string &symbol_file,
+                                         const string &fast_symbol_file);
+
   // Serializes one loaded module with given moduleid in the basic source line
   // resolver, and loads the serialized data into the fast source line resolver.
   // Return false if the basic source line doesn't have a module with the given
@@ -120,6 +141,8 @@ class ModuleSerializer {
                               linked_ptr<WindowsFrameInfo> > wfi_serializer_;
   RangeMapSerializer<MemAddr, string> cfi_init_rules_serializer_;
   StdMapSerializer<MemAddr, string> cfi_delta_rules_serializer_;
+  RangeMapSerializer<MemAddr, const char*> lazy_cfi_init_rules_serializer_;
+  StdMapSerializer<MemAddr, const char*> lazy_cfi_delta_rules_serializer_;
 };
 
 }  // namespace google_breakpad
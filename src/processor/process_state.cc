@@ -57,15 +57,27 @@ void ProcessState::Clear() {
     delete *iterator;
   }
   threads_.clear();
+  // thread_memory_regions_ DOES NOT own the underlying MemoryRegion
+  // pointers.  Just clear the vector.
+  thread_memory_regions_.clear();
   system_info_.Clear();
   // modules_without_symbols_ and modules_with_corrupt_symbols_ DO NOT own
   // the underlying CodeModule pointers.  Just clear the vectors.
   modules_without_symbols_.clear();
   modules_with_corrupt_symbols_.clear();
+  shrunk_range_modules_.clear();
   delete modules_;
   modules_ = NULL;
   delete unloaded_modules_;
   unloaded_modules_ = NULL;
 }
 
+bool ProcessState::truncated() const {
+  for (size_t i = 0; i < threads_.size(); ++i) {
+    if (threads_[i]->truncated())
+      return true;
+  }
+  return false;
+}
+
 }  // namespace google_breakpad
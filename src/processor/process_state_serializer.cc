@@ -0,0 +1,847 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// process_state_serializer.cc: Converts a ProcessState to and from a
+// compact binary form.
+//
+// See process_state_serializer.h for documentation.
+
+#include "google_breakpad/processor/process_state_serializer.h"
+
+#include <string.h>
+
+#include <limits>
+#include <map>
+#include <vector>
+
+#include "common/scoped_ptr.h"
+#include "google_breakpad/processor/call_stack.h"
+#include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/code_modules.h"
+#include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/stack_frame_cpu.h"
+#include "processor/basic_code_module.h"
+#include "processor/basic_code_modules.h"
+#include "processor/linked_ptr.h"
+#include "processor/logging.h"
+#include "processor/range_map-inl.h"
+
+namespace google_breakpad {
+
+namespace {
+
+using std::map;
+using std::vector;
+
+// The serialized form begins with kMagic and the format version.
+const char kMagic[4] = { 'B', 'P', 'P', 'S' };
+const uint64_t kVersion = 4;
+
+// Appends values to a serialized ProcessState.
+class Writer {
+ public:
+  explicit Writer(string* data) : data_(data) { }
+
+  void WriteUInt(uint64_t value) {
+    while (value >= 0x80) {
+      data_->push_back(static_cast<char>((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    data_->push_back(static_cast<char>(value));
+  }
+
+  void WriteInt(int64_t value) {
+    WriteUInt((static_cast<uint64_t>(value) << 1) ^
+              static_cast<uint64_t>(value >> 63));
+  }
+
+  void WriteString(const string& value) {
+    WriteUInt(value.size());
+    data_->append(value);
+  }
+
+  void WriteBytes(const void* bytes, size_t size) {
+    data_->append(static_cast<const char*>(bytes), size);
+  }
+
+ private:
+  string* data_;
+};
+
+// Takes values from a serialized ProcessState.  Each Read method returns
+// false if the rest of the data does not hold a value of that kind.
+class Reader {
+ public:
+  Reader(const char* data, size_t size)
+      : data_(data), size_(size), position_(0) { }
+
+  bool ReadUInt(uint64_t* value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (position_ == size_)
+        return false;
+      uint8_t byte = data_[position_++];
+      result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        *value = result;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool ReadInt(int64_t* value) {
+    uint64_t encoded;
+    if (!ReadUInt(&encoded))
+      return false;
+    *value = static_cast<int64_t>(encoded >> 1) ^
+             -static_cast<int64_t>(encoded & 1);
+    return true;
+  }
+
+  bool ReadBool(bool* value) {
+    uint64_t encoded;
+    if (!ReadUInt(&encoded) || encoded > 1)
+      return false;
+    *value = encoded != 0;
+    return true;
+  }
+
+  bool ReadString(string* value) {
+    uint64_t length;
+    if (!ReadUInt(&length) || length > size_ - position_)
+      return false;
+    value->assign(data_ + position_, length);
+    position_ += length;
+    return true;
+  }
+
+  bool ReadBytes(void* bytes, size_t size) {
+    if (size > size_ - position_)
+      return false;
+    memcpy(bytes, data_ + position_, size);
+    position_ += size;
+    return true;
+  }
+
+  // Reads the number of elements in a list, each of which takes at least
+  // one byte, so that a corrupt count can't cause a huge allocation.
+  bool ReadCount(uint64_t* count) {
+    return ReadUInt(count) && *count <= size_ - position_;
+  }
+
+  bool AtEnd() const { return position_ == size_; }
+
+ private:
+  const char* data_;
+  size_t size_;
+  size_t position_;
+};
+
+// A BasicCodeModules holding deserialized modules.
+class DeserializedCodeModules : public BasicCodeModules {
+ public:
+  DeserializedCodeModules() {
+    map_.SetMergeStrategy(MergeRangeStrategy::kTruncateUpper);
+  }
+
+  // Takes ownership of module, returning false, and deleting it, if its
+  // range can't be stored.
+  bool Add(const CodeModule* module) {
+    linked_ptr<const CodeModule> module_ptr(module);
+    return map_.StoreRange(module->base_address(), module->size(),
+                           module_ptr);
+  }
+
+  void set_main_address(uint64_t main_address) {
+    main_address_ = main_address;
+  }
+};
+
+// Modules are referred to by number: 0 for no module, then the loaded
+// modules in sequence, then the unloaded modules in sequence.
+typedef map<const CodeModule*, uint64_t> ModuleNumbers;
+
+void NumberModules(const CodeModules* modules, uint64_t* next_number,
+                   ModuleNumbers* numbers) {
+  if (!modules)
+    return;
+  for (unsigned int i = 0; i < modules->module_count(); ++i) {
+    const CodeModule* module = modules->GetModuleAtSequence(i);
+    if (module)
+      numbers->insert(std::make_pair(module, *next_number));
+    ++*next_number;
+  }
+}
+
+void WriteModuleNumber(const ModuleNumbers& numbers, const CodeModule* module,
+                       Writer* writer) {
+  ModuleNumbers::const_iterator iterator = numbers.find(module);
+  writer->WriteUInt(iterator == numbers.end() ? 0 : iterator->second);
+}
+
+bool ReadModuleNumber(const vector<const CodeModule*>& modules,
+                      Reader* reader, const CodeModule** module) {
+  uint64_t number;
+  if (!reader->ReadUInt(&number) || number > modules.size())
+    return false;
+  *module = number ? modules[number - 1] : NULL;
+  return true;
+}
+
+void WriteModule(const CodeModule& module, Writer* writer) {
+  writer->WriteUInt(module.base_address());
+  writer->WriteUInt(module.size());
+  writer->WriteUInt(module.shrink_down_delta());
+  writer->WriteString(module.code_file());
+  writer->WriteString(module.code_identifier());
+  writer->WriteString(module.debug_file());
+  writer->WriteString(module.debug_identifier());
+  writer->WriteString(module.version());
+  writer->WriteUInt(module.is_unloaded());
+}
+
+// Returns a new module owned by the caller, or NULL on error.
+BasicCodeModule* ReadModule(Reader* reader) {
+  uint64_t base_address, size, shrink_down_delta;
+  string code_file, code_identifier, debug_file, debug_identifier, version;
+  bool is_unloaded;
+  if (!reader->ReadUInt(&base_address) ||
+      !reader->ReadUInt(&size) ||
+      !reader->ReadUInt(&shrink_down_delta) ||
+      !reader->ReadString(&code_file) ||
+      !reader->ReadString(&code_identifier) ||
+      !reader->ReadString(&debug_file) ||
+      !reader->ReadString(&debug_identifier) ||
+      !reader->ReadString(&version) ||
+      !reader->ReadBool(&is_unloaded)) {
+    return NULL;
+  }
+  BasicCodeModule* module = new BasicCodeModule(
+      base_address, size, code_file, code_identifier, debug_file,
+      debug_identifier, version, is_unloaded);
+  module->SetShrinkDownDelta(shrink_down_delta);
+  return module;
+}
+
+void WriteModules(const CodeModules* modules, Writer* writer) {
+  writer->WriteUInt(modules != NULL);
+  if (!modules)
+    return;
+  const CodeModule* main_module = modules->GetMainModule();
+  writer->WriteUInt(main_module != NULL);
+  if (main_module)
+    writer->WriteUInt(main_module->base_address());
+  writer->WriteUInt(modules->module_count());
+  for (unsigned int i = 0; i < modules->module_count(); ++i) {
+    const CodeModule* module = modules->GetModuleAtSequence(i);
+    // Keep the numbering in step with NumberModules by writing a
+    // placeholder for a module that can't be retrieved.
+    if (module) {
+      WriteModule(*module, writer);
+    } else {
+      BasicCodeModule placeholder(0, 0, "", "", "", "", "");
+      WriteModule(placeholder, writer);
+    }
+  }
+}
+
+// Sets *modules to a new CodeModules owned by the caller, or to NULL if
+// none was serialized, and appends each module read to numbered, so that
+// ReadModuleNumber can refer to it.
+bool ReadModules(Reader* reader, const CodeModules** modules,
+                 vector<const CodeModule*>* numbered) {
+  *modules = NULL;
+  bool present;
+  if (!reader->ReadBool(&present))
+    return false;
+  if (!present)
+    return true;
+
+  scoped_ptr<DeserializedCodeModules> deserialized(
+      new DeserializedCodeModules());
+  bool has_main_module;
+  if (!reader->ReadBool(&has_main_module))
+    return false;
+  if (has_main_module) {
+    uint64_t main_address;
+    if (!reader->ReadUInt(&main_address))
+      return false;
+    deserialized->set_main_address(main_address);
+  }
+
+  uint64_t count;
+  if (!reader->ReadCount(&count))
+    return false;
+  for (uint64_t i = 0; i < count; ++i) {
+    BasicCodeModule* module = ReadModule(reader);
+    if (!module)
+      return false;
+    numbered->push_back(deserialized->Add(module) ? module : NULL);
+  }
+  *modules = deserialized.release();
+  return true;
+}
+
+// The registers of a frame's context that its context_validity can mark
+// valid, each with the flag or flags that do.  A register listed with
+// CONTEXT_VALID_ALL is only known in a frame whose context is complete.
+template<typename Register>
+struct ContextRegister {
+  ContextRegister(uint64_t flag, Register* value)
+      : flag(flag), value(value) { }
+  uint64_t flag;
+  Register* value;
+};
+
+void GetContextRegisters(StackFrameX86* frame,
+                         vector<ContextRegister<uint32_t> >* registers) {
+  typedef ContextRegister<uint32_t> R;
+  MDRawContextX86* context = &frame->context;
+  registers->push_back(R(StackFrameX86::CONTEXT_VALID_EIP, &context->eip));
+  registers->push_back(R(StackFrameX86::CONTEXT_VALID_ESP, &context->esp));
+  registers->push_back(R(StackFrameX86::CONTEXT_VALID_EBP, &context->ebp));
+  registers->push_back(R(StackFrameX86::CONTEXT_VALID_EAX, &context->eax));
+  registers->push_back(R(StackFrameX86::CONTEXT_VALID_EBX, &context->ebx));
+  registers->push_back(R(StackFrameX86::CONTEXT_VALID_ECX, &context->ecx));
+  registers->push_back(R(StackFrameX86::CONTEXT_VALID_EDX, &context->edx));
+  registers->push_back(R(StackFrameX86::CONTEXT_VALID_ESI, &context->esi));
+  registers->push_back(R(StackFrameX86::CONTEXT_VALID_EDI, &context->edi));
+  registers->push_back(R(static_cast<uint64_t>(
+      static_cast<int64_t>(StackFrameX86::CONTEXT_VALID_ALL)),
+      &context->eflags));
+}
+
+void GetContextRegisters(StackFrameAMD64* frame,
+                         vector<ContextRegister<uint64_t> >* registers) {
+  typedef ContextRegister<uint64_t> R;
+  MDRawContextAMD64* context = &frame->context;
+  registers->push_back(R(StackFrameAMD64::CONTEXT_VALID_RAX, &context->rax));
+  registers->push_back(R(StackFrameAMD64::CONTEXT_VALID_RDX, &context->rdx));
+  registers->push_back(R(StackFrameAMD64::CONTEXT_VALID_RCX, &context->rcx));
+  registers->push_back(R(StackFrameAMD64::CONTEXT_VALID_RBX, &context->rbx));
+  registers->push_back(R(StackFrameAMD64::CONTEXT_VALID_RSI, &context->rsi));
+  registers->push_back(R(StackFrameAMD64::CONTEXT_VALID_RDI, &context->rdi));
+  registers->push_back(R(StackFrameAMD64::CONTEXT_VALID_RBP, &context->rbp));
+  registers->push_back(R(StackFrameAMD64::CONTEXT_VALID_RSP, &context->rsp));
+  registers->push_back(R(StackFrameAMD64::CONTEXT_VALID_R8, &context->r8));
+  registers->push_back(R(StackFrameAMD64::CONTEXT_VALID_R9, &context->r9));
+  registers->push_back(R(StackFrameAMD64::CONTEXT_VALID_R10, &context->r10));
+  registers->push_back(R(StackFrameAMD64::CONTEXT_VALID_R11, &context->r11));
+  registers->push_back(R(StackFrameAMD64::CONTEXT_VALID_R12, &context->r12));
+  registers->push_back(R(StackFrameAMD64::CONTEXT_VALID_R13, &context->r13));
+  registers->push_back(R(StackFrameAMD64::CONTEXT_VALID_R14, &context->r14));
+  registers->push_back(R(StackFrameAMD64::CONTEXT_VALID_R15, &context->r15));
+  registers->push_back(R(StackFrameAMD64::CONTEXT_VALID_RIP, &context->rip));
+}
+
+void GetContextRegisters(StackFramePPC* frame,
+                         vector<ContextRegister<uint32_t> >* registers) {
+  typedef ContextRegister<uint32_t> R;
+  MDRawContextPPC* context = &frame->context;
+  registers->push_back(R(StackFramePPC::CONTEXT_VALID_SRR0, &context->srr0));
+  registers->push_back(R(StackFramePPC::CONTEXT_VALID_GPR1,
+                         &context->gpr[1]));
+}
+
+void GetContextRegisters(StackFramePPC64* frame,
+                         vector<ContextRegister<uint64_t> >* registers) {
+  typedef ContextRegister<uint64_t> R;
+  MDRawContextPPC64* context = &frame->context;
+  registers->push_back(R(StackFramePPC64::CONTEXT_VALID_SRR0,
+                         &context->srr0));
+  registers->push_back(R(StackFramePPC64::CONTEXT_VALID_GPR1,
+                         &context->gpr[1]));
+}
+
+void GetContextRegisters(StackFrameSPARC* frame,
+                         vector<ContextRegister<uint64_t> >* registers) {
+  typedef ContextRegister<uint64_t> R;
+  MDRawContextSPARC* context = &frame->context;
+  registers->push_back(R(StackFrameSPARC::CONTEXT_VALID_PC, &context->pc));
+  registers->push_back(R(StackFrameSPARC::CONTEXT_VALID_SP,
+                         &context->g_r[14]));
+  registers->push_back(R(StackFrameSPARC::CONTEXT_VALID_FP,
+                         &context->g_r[30]));
+}
+
+void GetContextRegisters(StackFrameARM* frame,
+                         vector<ContextRegister<uint32_t> >* registers) {
+  for (int i = 0; i < MD_CONTEXT_ARM_GPR_COUNT; ++i) {
+    registers->push_back(ContextRegister<uint32_t>(
+        StackFrameARM::RegisterValidFlag(i), &frame->context.iregs[i]));
+  }
+}
+
+void GetContextRegisters(StackFrameARM64* frame,
+                         vector<ContextRegister<uint64_t> >* registers) {
+  for (int i = 0; i < MD_CONTEXT_ARM64_GPR_COUNT; ++i) {
+    registers->push_back(ContextRegister<uint64_t>(
+        StackFrameARM64::RegisterValidFlag(i), &frame->context.iregs[i]));
+  }
+}
+
+void GetContextRegisters(StackFrameMIPS* frame,
+                         vector<ContextRegister<uint64_t> >* registers) {
+  for (int i = INDEX_MIPS_REG_S0; i <= INDEX_MIPS_REG_S7; ++i) {
+    registers->push_back(ContextRegister<uint64_t>(
+        StackFrameMIPS::RegisterValidFlag(i), &frame->context.iregs[i]));
+  }
+  for (int i = INDEX_MIPS_REG_GP; i <= INDEX_MIPS_REG_RA; ++i) {
+    registers->push_back(ContextRegister<uint64_t>(
+        StackFrameMIPS::RegisterValidFlag(i), &frame->context.iregs[i]));
+  }
+  registers->push_back(ContextRegister<uint64_t>(
+      StackFrameMIPS::CONTEXT_VALID_PC, &frame->context.epc));
+}
+
+// Writes the context of frame, if it is of the StackFrame subclass
+// FrameType, returning false otherwise: its context_validity, then each
+// register that marks valid.  The rest of the raw context, which the
+// stackwalkers neither fill in nor use past the first frame, is left out.
+template<typename FrameType, typename Register>
+bool WriteContext(const StackFrame& frame, Writer* writer) {
+  const FrameType* cpu_frame = dynamic_cast<const FrameType*>(&frame);
+  if (!cpu_frame)
+    return false;
+  uint64_t context_validity =
+      static_cast<uint64_t>(static_cast<int64_t>(cpu_frame->context_validity));
+  writer->WriteUInt(context_validity);
+  // GetContextRegisters needs a modifiable frame, but only reads here.
+  vector<ContextRegister<Register> > registers;
+  GetContextRegisters(const_cast<FrameType*>(cpu_frame), &registers);
+  for (size_t i = 0; i < registers.size(); ++i) {
+    if ((context_validity & registers[i].flag) == registers[i].flag)
+      writer->WriteUInt(*registers[i].value);
+  }
+  return true;
+}
+
+// Reads the context of frame, which must be of the StackFrame subclass
+// FrameType.
+template<typename FrameType, typename Register>
+bool ReadContext(StackFrame* frame, Reader* reader) {
+  FrameType* cpu_frame = static_cast<FrameType*>(frame);
+  uint64_t context_validity;
+  if (!reader->ReadUInt(&context_validity))
+    return false;
+  vector<ContextRegister<Register> > registers;
+  GetContextRegisters(cpu_frame, &registers);
+  for (size_t i = 0; i < registers.size(); ++i) {
+    if ((context_validity & registers[i].flag) != registers[i].flag)
+      continue;
+    uint64_t value;
+    if (!reader->ReadUInt(&value) ||
+        value > std::numeric_limits<Register>::max()) {
+      return false;
+    }
+    *registers[i].value = static_cast<Register>(value);
+  }
+  cpu_frame->context_validity = context_validity;
+  return true;
+}
+
+// The StackFrame subclasses that the stackwalkers produce, by the CPU name
+// in SystemInfo::cpu.  The stackwalkers for mips and mips64 both produce
+// StackFrameMIPS.
+bool WriteFrameContext(const string& cpu, const StackFrame& frame,
+                       Writer* writer) {
+  if (cpu == "x86")
+    return WriteContext<StackFrameX86, uint32_t>(frame, writer);
+  if (cpu == "amd64")
+    return WriteContext<StackFrameAMD64, uint64_t>(frame, writer);
+  if (cpu == "ppc")
+    return WriteContext<StackFramePPC, uint32_t>(frame, writer);
+  if (cpu == "ppc64")
+    return WriteContext<StackFramePPC64, uint64_t>(frame, writer);
+  if (cpu == "sparc")
+    return WriteContext<StackFrameSPARC, uint64_t>(frame, writer);
+  if (cpu == "arm")
+    return WriteContext<StackFrameARM, uint32_t>(frame, writer);
+  if (cpu == "arm64")
+    return WriteContext<StackFrameARM64, uint64_t>(frame, writer);
+  if (cpu == "mips" || cpu == "mips64")
+    return WriteContext<StackFrameMIPS, uint64_t>(frame, writer);
+  return false;
+}
+
+// Returns a new frame owned by the caller, of the subclass WriteFrameContext
+// writes the context of for cpu, or NULL if there is none.
+StackFrame* NewContextFrame(const string& cpu) {
+  if (cpu == "x86")
+    return new StackFrameX86();
+  if (cpu == "amd64")
+    return new StackFrameAMD64();
+  if (cpu == "ppc")
+    return new StackFramePPC();
+  if (cpu == "ppc64")
+    return new StackFramePPC64();
+  if (cpu == "sparc")
+    return new StackFrameSPARC();
+  if (cpu == "arm")
+    return new StackFrameARM();
+  if (cpu == "arm64")
+    return new StackFrameARM64();
+  if (cpu == "mips" || cpu == "mips64")
+    return new StackFrameMIPS();
+  return NULL;
+}
+
+// frame must have been returned by NewContextFrame(cpu).
+bool ReadFrameContext(const string& cpu, StackFrame* frame, Reader* reader) {
+  if (cpu == "x86")
+    return ReadContext<StackFrameX86, uint32_t>(frame, reader);
+  if (cpu == "amd64")
+    return ReadContext<StackFrameAMD64, uint64_t>(frame, reader);
+  if (cpu == "ppc")
+    return ReadContext<StackFramePPC, uint32_t>(frame, reader);
+  if (cpu == "ppc64")
+    return ReadContext<StackFramePPC64, uint64_t>(frame, reader);
+  if (cpu == "sparc")
+    return ReadContext<StackFrameSPARC, uint64_t>(frame, reader);
+  if (cpu == "arm")
+    return ReadContext<StackFrameARM, uint32_t>(frame, reader);
+  if (cpu == "arm64")
+    return ReadContext<StackFrameARM64, uint64_t>(frame, reader);
+  if (cpu == "mips" || cpu == "mips64")
+    return ReadContext<StackFrameMIPS, uint64_t>(frame, reader);
+  return false;
+}
+
+void WriteFrame(const string& cpu, const ModuleNumbers& numbers,
+                const StackFrame& frame, Writer* writer) {
+  string context;
+  Writer context_writer(&context);
+  bool has_context = WriteFrameContext(cpu, frame, &context_writer);
+
+  writer->WriteUInt(has_context);
+  writer->WriteUInt(frame.instruction);
+  WriteModuleNumber(numbers, frame.module, writer);
+  writer->WriteString(frame.function_name);
+  writer->WriteUInt(frame.function_base);
+  writer->WriteString(frame.source_file_name);
+  writer->WriteInt(frame.source_line);
+  writer->WriteUInt(frame.source_line_base);
+  writer->WriteUInt(frame.trust);
+  writer->WriteBytes(context.data(), context.size());
+}
+
+// Returns a new frame owned by the caller, or NULL on error.
+StackFrame* ReadFrame(const string& cpu,
+                      const vector<const CodeModule*>& numbered,
+                      Reader* reader) {
+  bool has_context;
+  if (!reader->ReadBool(&has_context))
+    return NULL;
+  scoped_ptr<StackFrame> frame(has_context ? NewContextFrame(cpu)
+                                           : new StackFrame());
+  if (!frame.get())
+    return NULL;
+
+  int64_t source_line;
+  uint64_t trust;
+  if (!reader->ReadUInt(&frame->instruction) ||
+      !ReadModuleNumber(numbered, reader, &frame->module) ||
+      !reader->ReadString(&frame->function_name) ||
+      !reader->ReadUInt(&frame->function_base) ||
+      !reader->ReadString(&frame->source_file_name) ||
+      !reader->ReadInt(&source_line) ||
+      !reader->ReadUInt(&frame->source_line_base) ||
+      !reader->ReadUInt(&trust) ||
+      trust > StackFrame::FRAME_TRUST_INLINE) {
+    return NULL;
+  }
+  frame->source_line = source_line;
+  frame->trust = static_cast<StackFrame::FrameTrust>(trust);
+  if (has_context && !ReadFrameContext(cpu, frame.get(), reader))
+    return NULL;
+  return frame.release();
+}
+
+void WriteModuleList(const ModuleNumbers& numbers,
+                     const vector<const CodeModule*>& modules,
+                     Writer* writer) {
+  writer->WriteUInt(modules.size());
+  for (size_t i = 0; i < modules.size(); ++i)
+    WriteModuleNumber(numbers, modules[i], writer);
+}
+
+bool ReadModuleList(const vector<const CodeModule*>& numbered, Reader* reader,
+                    vector<const CodeModule*>* modules) {
+  uint64_t count;
+  if (!reader->ReadCount(&count))
+    return false;
+  for (uint64_t i = 0; i < count; ++i) {
+    const CodeModule* module;
+    if (!ReadModuleNumber(numbered, reader, &module))
+      return false;
+    if (module)
+      modules->push_back(module);
+  }
+  return true;
+}
+
+}  // namespace
+
+// static
+bool ProcessStateSerializer::IsSerializedProcessState(const char* data,
+                                                      size_t size) {
+  return size >= sizeof(kMagic) && memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+// static
+void ProcessStateSerializer::Serialize(const ProcessState& state,
+                                       string* data) {
+  data->clear();
+  Writer writer(data);
+  writer.WriteBytes(kMagic, sizeof(kMagic));
+  writer.WriteUInt(kVersion);
+
+  writer.WriteUInt(state.time_date_stamp_);
+  writer.WriteUInt(state.process_create_time_);
+  writer.WriteUInt(state.crashed_);
+  writer.WriteString(state.crash_reason_);
+  writer.WriteUInt(state.crash_address_);
+  writer.WriteString(state.assertion_);
+  writer.WriteInt(state.requesting_thread_);
+
+  const ExceptionRecord& exception_record = state.exception_record_;
+  writer.WriteUInt(exception_record.code());
+  writer.WriteString(exception_record.code_description());
+  writer.WriteUInt(exception_record.flags());
+  writer.WriteString(exception_record.flags_description());
+  writer.WriteUInt(exception_record.nested_exception_record_address());
+  writer.WriteUInt(exception_record.address());
+  writer.WriteUInt(exception_record.parameters()->size());
+  for (size_t i = 0; i < exception_record.parameters()->size(); ++i) {
+    const ExceptionParameter& parameter = exception_record.parameters()->at(i);
+    writer.WriteUInt(parameter.value());
+    writer.WriteString(parameter.description());
+  }
+
+  const SystemInfo& system_info = state.system_info_;
+  writer.WriteString(system_info.os);
+  writer.WriteString(system_info.os_short);
+  writer.WriteString(system_info.os_version);
+  writer.WriteString(system_info.cpu);
+  writer.WriteString(system_info.cpu_info);
+  writer.WriteInt(system_info.cpu_count);
+  writer.WriteString(system_info.gl_version);
+  writer.WriteString(system_info.gl_vendor);
+  writer.WriteString(system_info.gl_renderer);
+
+  ModuleNumbers numbers;
+  uint64_t next_number = 1;
+  NumberModules(state.modules_, &next_number, &numbers);
+  NumberModules(state.unloaded_modules_, &next_number, &numbers);
+  WriteModules(state.modules_, &writer);
+  WriteModules(state.unloaded_modules_, &writer);
+  writer.WriteUInt(state.shrunk_range_modules_.size());
+  for (size_t i = 0; i < state.shrunk_range_modules_.size(); ++i)
+    WriteModule(*state.shrunk_range_modules_[i], &writer);
+  WriteModuleList(numbers, state.modules_without_symbols_, &writer);
+  WriteModuleList(numbers, state.modules_with_corrupt_symbols_, &writer);
+  writer.WriteUInt(state.exploitability_);
+
+  writer.WriteUInt(state.threads_.size());
+  for (size_t i = 0; i < state.threads_.size(); ++i) {
+    const CallStack* stack = state.threads_[i];
+    writer.WriteUInt(stack->tid());
+    writer.WriteString(stack->thread_name());
+    writer.WriteUInt(stack->truncation());
+    writer.WriteUInt(stack->frames()->size());
+    for (size_t j = 0; j < stack->frames()->size(); ++j) {
+      WriteFrame(system_info.cpu, numbers, *stack->frames()->at(j),
+                 &writer);
+    }
+  }
+}
+
+// static
+bool ProcessStateSerializer::Deserialize(const char* data, size_t size,
+                                         ProcessState* state) {
+  state->Clear();
+  state->exception_record_ = ExceptionRecord();
+  state->exploitability_ = EXPLOITABILITY_NOT_ANALYZED;
+
+  Reader reader(data, size);
+  char magic[sizeof(kMagic)];
+  uint64_t version;
+  if (!reader.ReadBytes(magic, sizeof(magic)) ||
+      memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+      !reader.ReadUInt(&version) || version != kVersion) {
+    BPLOG(ERROR) << "Deserialize: not a ProcessState serialized by this "
+                    "version";
+    return false;
+  }
+
+  uint64_t time_date_stamp, process_create_time, crash_address;
+  int64_t requesting_thread;
+  if (!reader.ReadUInt(&time_date_stamp) ||
+      !reader.ReadUInt(&process_create_time) ||
+      !reader.ReadBool(&state->crashed_) ||
+      !reader.ReadString(&state->crash_reason_) ||
+      !reader.ReadUInt(&crash_address) ||
+      !reader.ReadString(&state->assertion_) ||
+      !reader.ReadInt(&requesting_thread)) {
+    BPLOG(ERROR) << "Deserialize: truncated process information";
+    state->Clear();
+    return false;
+  }
+  state->time_date_stamp_ = time_date_stamp;
+  state->process_create_time_ = process_create_time;
+  state->crash_address_ = crash_address;
+
+  uint64_t code, flags, nested_address, address, parameter_count;
+  string code_description, flags_description;
+  if (!reader.ReadUInt(&code) ||
+      !reader.ReadString(&code_description) ||
+      !reader.ReadUInt(&flags) ||
+      !reader.ReadString(&flags_description) ||
+      !reader.ReadUInt(&nested_address) ||
+      !reader.ReadUInt(&address) ||
+      !reader.ReadCount(&parameter_count)) {
+    BPLOG(ERROR) << "Deserialize: truncated exception record";
+    state->Clear();
+    return false;
+  }
+  ExceptionRecord* exception_record = &state->exception_record_;
+  exception_record->set_code(code, code_description);
+  exception_record->set_flags(flags, flags_description);
+  exception_record->set_nested_exception_record_address(nested_address);
+  exception_record->set_address(address);
+  for (uint64_t i = 0; i < parameter_count; ++i) {
+    uint64_t value;
+    string description;
+    if (!reader.ReadUInt(&value) || !reader.ReadString(&description)) {
+      BPLOG(ERROR) << "Deserialize: truncated exception parameter";
+      state->Clear();
+      return false;
+    }
+    exception_record->add_parameter(value, description);
+  }
+
+  SystemInfo* system_info = &state->system_info_;
+  int64_t cpu_count;
+  if (!reader.ReadString(&system_info->os) ||
+      !reader.ReadString(&system_info->os_short) ||
+      !reader.ReadString(&system_info->os_version) ||
+      !reader.ReadString(&system_info->cpu) ||
+      !reader.ReadString(&system_info->cpu_info) ||
+      !reader.ReadInt(&cpu_count) ||
+      !reader.ReadString(&system_info->gl_version) ||
+      !reader.ReadString(&system_info->gl_vendor) ||
+      !reader.ReadString(&system_info->gl_renderer)) {
+    BPLOG(ERROR) << "Deserialize: truncated system information";
+    state->Clear();
+    return false;
+  }
+  system_info->cpu_count = cpu_count;
+
+  vector<const CodeModule*> numbered;
+  uint64_t shrunk_count;
+  if (!ReadModules(&reader, &state->modules_, &numbered) ||
+      !ReadModules(&reader, &state->unloaded_modules_, &numbered) ||
+      !reader.ReadCount(&shrunk_count)) {
+    BPLOG(ERROR) << "Deserialize: bad module list";
+    state->Clear();
+    return false;
+  }
+  for (uint64_t i = 0; i < shrunk_count; ++i) {
+    BasicCodeModule* module = ReadModule(&reader);
+    if (!module) {
+      BPLOG(ERROR) << "Deserialize: bad shrunk module";
+      state->Clear();
+      return false;
+    }
+    state->shrunk_range_modules_.push_back(
+        linked_ptr<const CodeModule>(module));
+  }
+
+  uint64_t exploitability;
+  if (!ReadModuleList(numbered, &reader,
+                      &state->modules_without_symbols_) ||
+      !ReadModuleList(numbered, &reader,
+                      &state->modules_with_corrupt_symbols_) ||
+      !reader.ReadUInt(&exploitability) ||
+      exploitability > EXPLOITABILITY_ERR_PROCESSING) {
+    BPLOG(ERROR) << "Deserialize: bad module references";
+    state->Clear();
+    return false;
+  }
+  state->exploitability_ = static_cast<ExploitabilityRating>(exploitability);
+
+  uint64_t thread_count;
+  if (!reader.ReadCount(&thread_count)) {
+    BPLOG(ERROR) << "Deserialize: bad thread count";
+    state->Clear();
+    return false;
+  }
+  for (uint64_t i = 0; i < thread_count; ++i) {
+    CallStack* stack = new CallStack();
+    state->threads_.push_back(stack);
+    state->thread_memory_regions_.push_back(NULL);
+
+    uint64_t tid, truncation, frame_count;
+    string thread_name;
+    if (!reader.ReadUInt(&tid) ||
+        !reader.ReadString(&thread_name) ||
+        !reader.ReadUInt(&truncation) ||
+        truncation > CALL_STACK_CANCELLED ||
+        !reader.ReadCount(&frame_count)) {
+      BPLOG(ERROR) << "Deserialize: truncated thread " << i;
+      state->Clear();
+      return false;
+    }
+    stack->set_tid(tid);
+    stack->set_thread_name(thread_name);
+    stack->set_truncation(static_cast<CallStackTruncation>(truncation));
+    for (uint64_t j = 0; j < frame_count; ++j) {
+      StackFrame* frame = ReadFrame(system_info->cpu, numbered, &reader);
+      if (!frame) {
+        BPLOG(ERROR) << "Deserialize: bad frame " << j << " of thread " << i;
+        state->Clear();
+        return false;
+      }
+      stack->frames_.push_back(frame);
+    }
+  }
+
+  if (requesting_thread < -1 ||
+      requesting_thread >= static_cast<int64_t>(thread_count) ||
+      !reader.AtEnd()) {
+    BPLOG(ERROR) << "Deserialize: bad requesting thread or trailing data";
+    state->Clear();
+    return false;
+  }
+  state->requesting_thread_ = requesting_thread;
+  return true;
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,280 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// process_state_serializer_unittest.cc: Unit tests for
+// ProcessStateSerializer.
+
+#include <stdlib.h>
+
+#include <string>
+
+#include "breakpad_googletest_includes.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "google_breakpad/processor/call_stack.h"
+#include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/code_modules.h"
+#include "google_breakpad/processor/minidump_processor.h"
+#include "google_breakpad/processor/process_deadline.h"
+#include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/process_state_serializer.h"
+#include "google_breakpad/processor/stack_frame_cpu.h"
+#include "processor/simple_symbol_supplier.h"
+
+namespace {
+
+using google_breakpad::BasicSourceLineResolver;
+using google_breakpad::CallStack;
+using google_breakpad::CodeModule;
+using google_breakpad::CodeModules;
+using google_breakpad::MinidumpProcessor;
+using google_breakpad::ProcessDeadline;
+using google_breakpad::ProcessState;
+using google_breakpad::ProcessStateSerializer;
+using google_breakpad::SimpleSymbolSupplier;
+using google_breakpad::StackFrame;
+using google_breakpad::StackFrameX86;
+
+string TestDataDir() {
+  return string(getenv("srcdir") ? getenv("srcdir") : ".") +
+      "/src/processor/testdata";
+}
+
+void ExpectSameModule(const CodeModule* expected, const CodeModule* actual) {
+  if (!expected) {
+    EXPECT_TRUE(actual == NULL);
+    return;
+  }
+  ASSERT_TRUE(actual != NULL);
+  EXPECT_EQ(expected->base_address(), actual->base_address());
+  EXPECT_EQ(expected->size(), actual->size());
+  EXPECT_EQ(expected->code_file(), actual->code_file());
+  EXPECT_EQ(expected->code_identifier(), actual->code_identifier());
+  EXPECT_EQ(expected->debug_file(), actual->debug_file());
+  EXPECT_EQ(expected->debug_identifier(), actual->debug_identifier());
+  EXPECT_EQ(expected->version(), actual->version());
+}
+
+void ExpectSameModules(const CodeModules* expected,
+                       const CodeModules* actual) {
+  if (!expected) {
+    EXPECT_TRUE(actual == NULL);
+    return;
+  }
+  ASSERT_TRUE(actual != NULL);
+  ASSERT_EQ(expected->module_count(), actual->module_count());
+  ExpectSameModule(expected->GetMainModule(), actual->GetMainModule());
+  for (unsigned int i = 0; i < expected->module_count(); ++i) {
+    ExpectSameModule(expected->GetModuleAtSequence(i),
+                     actual->GetModuleAtSequence(i));
+  }
+}
+
+class ProcessStateSerializerTest : public ::testing::Test {
+ public:
+  // Processes the minidump named filename in the test data directory into
+  // state_, stopping at deadline if it is not NULL.
+  void Process(const string& filename,
+               const ProcessDeadline* deadline = NULL) {
+    SimpleSymbolSupplier supplier(TestDataDir() + "/symbols");
+    BasicSourceLineResolver resolver;
+    MinidumpProcessor processor(&supplier, &resolver);
+    ASSERT_EQ(google_breakpad::PROCESS_OK,
+              processor.Process(TestDataDir() + "/" + filename, &state_,
+                                deadline));
+  }
+
+  // Serializes state_, deserializes it into restored_ and checks that the
+  // two are the same.
+  void RoundTrip() {
+    string serialized;
+    ProcessStateSerializer::Serialize(state_, &serialized);
+    EXPECT_TRUE(ProcessStateSerializer::IsSerializedProcessState(
+        serialized.data(), serialized.size()));
+    ASSERT_TRUE(ProcessStateSerializer::Deserialize(
+        serialized.data(), serialized.size(), &restored_));
+
+    EXPECT_EQ(state_.time_date_stamp(), restored_.time_date_stamp());
+    EXPECT_EQ(state_.process_create_time(), restored_.process_create_time());
+    EXPECT_EQ(state_.crashed(), restored_.crashed());
+    EXPECT_EQ(state_.crash_reason(), restored_.crash_reason());
+    EXPECT_EQ(state_.crash_address(), restored_.crash_address());
+    EXPECT_EQ(state_.assertion(), restored_.assertion());
+    EXPECT_EQ(state_.requesting_thread(), restored_.requesting_thread());
+    EXPECT_EQ(state_.exploitability(), restored_.exploitability());
+    EXPECT_EQ(state_.exception_record()->code(),
+              restored_.exception_record()->code());
+    EXPECT_EQ(state_.exception_record()->parameters()->size(),
+              restored_.exception_record()->parameters()->size());
+    EXPECT_EQ(state_.system_info()->os, restored_.system_info()->os);
+    EXPECT_EQ(state_.system_info()->os_version,
+              restored_.system_info()->os_version);
+    EXPECT_EQ(state_.system_info()->cpu, restored_.system_info()->cpu);
+    EXPECT_EQ(state_.system_info()->cpu_info,
+              restored_.system_info()->cpu_info);
+    EXPECT_EQ(state_.system_info()->cpu_count,
+              restored_.system_info()->cpu_count);
+    ExpectSameModules(state_.modules(), restored_.modules());
+    ExpectSameModules(state_.unloaded_modules(),
+                      restored_.unloaded_modules());
+    EXPECT_EQ(state_.modules_without_symbols()->size(),
+              restored_.modules_without_symbols()->size());
+
+    ASSERT_EQ(state_.threads()->size(), restored_.threads()->size());
+    EXPECT_EQ(restored_.threads()->size(),
+              restored_.thread_memory_regions()->size());
+    for (size_t i = 0; i < state_.threads()->size(); ++i) {
+      const CallStack* expected = state_.threads()->at(i);
+      const CallStack* actual = restored_.threads()->at(i);
+      EXPECT_EQ(expected->tid(), actual->tid());
+      EXPECT_EQ(expected->thread_name(), actual->thread_name());
+      EXPECT_EQ(expected->truncation(), actual->truncation());
+      ASSERT_EQ(expected->frames()->size(), actual->frames()->size());
+      for (size_t j = 0; j < expected->frames()->size(); ++j) {
+        const StackFrame* expected_frame = expected->frames()->at(j);
+        const StackFrame* actual_frame = actual->frames()->at(j);
+        EXPECT_EQ(expected_frame->instruction, actual_frame->instruction);
+        ExpectSameModule(expected_frame->module, actual_frame->module);
+        EXPECT_EQ(expected_frame->function_name,
+                  actual_frame->function_name);
+        EXPECT_EQ(expected_frame->function_base,
+                  actual_frame->function_base);
+        EXPECT_EQ(expected_frame->source_file_name,
+                  actual_frame->source_file_name);
+        EXPECT_EQ(expected_frame->source_line, actual_frame->source_line);
+        EXPECT_EQ(expected_frame->source_line_base,
+                  actual_frame->source_line_base);
+        EXPECT_EQ(expected_frame->trust, actual_frame->trust);
+      }
+    }
+
+    // Serializing the restored state gives the same result.
+    string reserialized;
+    ProcessStateSerializer::Serialize(restored_, &reserialized);
+    EXPECT_EQ(serialized, reserialized);
+  }
+
+  ProcessState state_;
+  ProcessState restored_;
+};
+
+TEST_F(ProcessStateSerializerTest, Empty) {
+  RoundTrip();
+  EXPECT_TRUE(restored_.modules() == NULL);
+  EXPECT_EQ(-1, restored_.requesting_thread());
+}
+
+TEST_F(ProcessStateSerializerTest, Minidump) {
+  Process("minidump2.dmp");
+  ASSERT_FALSE(state_.threads()->empty());
+  RoundTrip();
+
+  // The frames keep the registers their contexts mark valid, and refer to
+  // the restored modules.
+  const CallStack* stack =
+      restored_.threads()->at(restored_.requesting_thread());
+  const StackFrameX86* frame =
+      static_cast<const StackFrameX86*>(stack->frames()->at(0));
+  const StackFrameX86* original = static_cast<const StackFrameX86*>(
+      state_.threads()->at(state_.requesting_thread())->frames()->at(0));
+  EXPECT_EQ(original->context_validity, frame->context_validity);
+  EXPECT_EQ(StackFrameX86::CONTEXT_VALID_ALL, frame->context_validity);
+  EXPECT_EQ(original->context.eip, frame->context.eip);
+  EXPECT_EQ(original->context.esp, frame->context.esp);
+  EXPECT_EQ(original->context.ebp, frame->context.ebp);
+  EXPECT_EQ(original->context.eax, frame->context.eax);
+  EXPECT_EQ(original->context.ebx, frame->context.ebx);
+  EXPECT_EQ(original->context.ecx, frame->context.ecx);
+  EXPECT_EQ(original->context.edx, frame->context.edx);
+  EXPECT_EQ(original->context.esi, frame->context.esi);
+  EXPECT_EQ(original->context.edi, frame->context.edi);
+  EXPECT_EQ(original->context.eflags, frame->context.eflags);
+
+  // The caller's frame keeps only the registers recovered for it.
+  ASSERT_LT(1U, stack->frames()->size());
+  const StackFrameX86* caller =
+      static_cast<const StackFrameX86*>(stack->frames()->at(1));
+  const StackFrameX86* original_caller = static_cast<const StackFrameX86*>(
+      state_.threads()->at(state_.requesting_thread())->frames()->at(1));
+  EXPECT_EQ(original_caller->context_validity, caller->context_validity);
+  EXPECT_NE(StackFrameX86::CONTEXT_VALID_ALL, caller->context_validity);
+  EXPECT_EQ(original_caller->context.eip, caller->context.eip);
+  EXPECT_EQ(original_caller->context.esp, caller->context.esp);
+  EXPECT_EQ(0U, caller->context.eflags);
+  EXPECT_EQ(restored_.modules()->GetModuleForAddress(frame->instruction),
+            frame->module);
+}
+
+TEST_F(ProcessStateSerializerTest, Truncated) {
+  ProcessDeadline deadline;
+  deadline.Cancel();
+  Process("minidump2.dmp", &deadline);
+  ASSERT_TRUE(state_.truncated());
+  RoundTrip();
+
+  EXPECT_TRUE(restored_.truncated());
+  ASSERT_FALSE(restored_.threads()->empty());
+  EXPECT_EQ(google_breakpad::CALL_STACK_CANCELLED,
+            restored_.threads()->at(0)->truncation());
+}
+
+TEST_F(ProcessStateSerializerTest, Malformed) {
+  Process("minidump2.dmp");
+  string serialized;
+  ProcessStateSerializer::Serialize(state_, &serialized);
+
+  // Every truncation is rejected.
+  for (size_t size = 0; size < serialized.size(); ++size) {
+    EXPECT_FALSE(ProcessStateSerializer::Deserialize(serialized.data(),
+                                                     size, &restored_));
+    EXPECT_TRUE(restored_.threads()->empty());
+  }
+
+  // So is trailing data.
+  string extended = serialized + '\0';
+  EXPECT_FALSE(ProcessStateSerializer::Deserialize(
+      extended.data(), extended.size(), &restored_));
+
+  // As is another version of the format, which follows the four-byte magic.
+  string other_version = serialized;
+  ++other_version[4];
+  EXPECT_TRUE(ProcessStateSerializer::IsSerializedProcessState(
+      other_version.data(), other_version.size()));
+  EXPECT_FALSE(ProcessStateSerializer::Deserialize(
+      other_version.data(), other_version.size(), &restored_));
+
+  // And something that isn't a serialized ProcessState.
+  const char kNotSerialized[] = "MDMP";
+  EXPECT_FALSE(ProcessStateSerializer::IsSerializedProcessState(
+      kNotSerialized, sizeof(kNotSerialized)));
+  EXPECT_FALSE(ProcessStateSerializer::Deserialize(
+      kNotSerialized, sizeof(kNotSerialized), &restored_));
+}
+
+}  // namespace
@@ -186,6 +186,20 @@ bool RangeMap<AddressType, EntryType>::RetrieveRange(
   BPLOG_IF(ERROR, !entry) << "RangeMap::RetrieveRange requires |entry|";
   assert(entry);
 
+  const EntryType *found;
+  if (!RetrieveRangePtr(address, found, entry_base, entry_delta, entry_size))
+    return false;
+
+  *entry = *found;
+  return true;
+}
+
+
+template<typename AddressType, typename EntryType>
+bool RangeMap<AddressType, EntryType>::RetrieveRangePtr(
+    const AddressType &address, const EntryType *&entry,
+    AddressType *entry_base, AddressType *entry_delta,
+    AddressType *entry_size) const {
   MapConstIterator iterator = map_.lower_bound(address);
   if (iterator == map_.end())
     return false;
@@ -198,7 +212,7 @@ bool RangeMap<AddressType, EntryType>::RetrieveRange(
   if (address < iterator->second.base())
     return false;
 
-  *entry = iterator->second.entry();
+  entry = &iterator->second.entry();
   if (entry_base)
     *entry_base = iterator->second.base();
   if (entry_delta)
@@ -217,8 +231,23 @@ bool RangeMap<AddressType, EntryType>::RetrieveNearestRange(
   BPLOG_IF(ERROR, !entry) << "RangeMap::RetrieveNearestRange requires |entry|";
   assert(entry);
 
-  // If address is within a range, RetrieveRange can handle it.
-  if (RetrieveRange(address, entry, entry_base, entry_delta, entry_size))
+  const EntryType *found;
+  if (!RetrieveNearestRangePtr(address, found, entry_base, entry_delta,
+                               entry_size))
+    return false;
+
+  *entry = *found;
+  return true;
+}
+
+
+template<typename AddressType, typename EntryType>
+bool RangeMap<AddressType, EntryType>::RetrieveNearestRangePtr(
+    const AddressType &address, const EntryType *&entry,
+    AddressType *entry_base, AddressType *entry_delta,
+    AddressType *entry_size) const {
+  // If address is within a range, RetrieveRangePtr can handle it.
+  if (RetrieveRangePtr(address, entry, entry_base, entry_delta, entry_size))
     return true;
 
   // upper_bound gives the first element whose key is greater than address,
@@ -231,7 +260,7 @@ bool RangeMap<AddressType, EntryType>::RetrieveNearestRange(
     return false;
   --iterator;
 
-  *entry = iterator->second.entry();
+  entry = &iterator->second.entry();
   if (entry_base)
     *entry_base = iterator->second.base();
   if (entry_delta)
@@ -250,6 +279,20 @@ bool RangeMap<AddressType, EntryType>::RetrieveRangeAtIndex(
   BPLOG_IF(ERROR, !entry) << "RangeMap::RetrieveRangeAtIndex requires |entry|";
   assert(entry);
 
+  const EntryType *found;
+  if (!RetrieveRangeAtIndexPtr(index, found, entry_base, entry_delta,
+                               entry_size))
+    return false;
+
+  *entry = *found;
+  return true;
+}
+
+
+template<typename AddressType, typename EntryType>
+bool RangeMap<AddressType, EntryType>::RetrieveRangeAtIndexPtr(
+    int index, const EntryType *&entry, AddressType *entry_base,
+    AddressType *entry_delta, AddressType *entry_size) const {
   if (index >= GetCount()) {
     BPLOG(ERROR) << "Index out of range: " << index << "/" << GetCount();
     return false;
@@ -261,7 +304,7 @@ bool RangeMap<AddressType, EntryType>::RetrieveRangeAtIndex(
   for (int this_index = 0; this_index < index; ++this_index)
     ++iterator;
 
-  *entry = iterator->second.entry();
+  entry = &iterator->second.entry();
   if (entry_base)
     *entry_base = iterator->second.base();
   if (entry_delta)
@@ -90,6 +90,14 @@ class RangeMap {
                      AddressType *entry_base, AddressType *entry_delta,
                      AddressType *entry_size) const;
 
+  // As above, but points |entry| at the map's own copy of the entry, which
+  // remains valid until the map is next modified.  Copying a linked_ptr<>
+  // entry relinks the map's copy, so threads sharing a map must use this
+  // form to look it up.
+  bool RetrieveRangePtr(const AddressType &address, const EntryType *&entry,
+                     AddressType *entry_base, AddressType *entry_delta,
+                     AddressType *entry_size) const;
+
   // Locates the range encompassing the supplied address, if one exists.
   // If no range encompasses the supplied address, locates the nearest range
   // to the supplied address that is lower than the address.  Returns false
@@ -101,6 +109,13 @@ class RangeMap {
                             AddressType *entry_base, AddressType *entry_delta,
                             AddressType *entry_size) const;
 
+  // As above, but points |entry| at the map's own copy of the entry.
+  bool RetrieveNearestRangePtr(const AddressType &address,
+                               const EntryType *&entry,
+                               AddressType *entry_base,
+                               AddressType *entry_delta,
+                               AddressType *entry_size) const;
+
   // Treating all ranges as a list ordered by the address spaces that they
   // occupy, locates the range at the index specified by index.  Returns
   // false if index is larger than the number of ranges stored.  entry_base,
@@ -114,6 +129,12 @@ class RangeMap {
                             AddressType *entry_base, AddressType *entry_delta,
                             AddressType *entry_size) const;
 
+  // As above, but points |entry| at the map's own copy of the entry.
+  bool RetrieveRangeAtIndexPtr(int index, const EntryType *&entry,
+                               AddressType *entry_base,
+                               AddressType *entry_delta,
+                               AddressType *entry_size) const;
+
   // Returns the number of ranges stored in the RangeMap.
   int GetCount() const;
 
@@ -139,7 +160,7 @@ class RangeMap {
 
     AddressType base() const { return base_; }
     AddressType delta() const { return delta_; }
-    EntryType entry() const { return entry_; }
+    const EntryType &entry() const { return entry_; }
 
    private:
     // The base address of the range.  The high address does not need to
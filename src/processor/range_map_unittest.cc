@@ -369,6 +369,54 @@ static bool RetriveAtIndexTest2() {
 }
 
 
+// Checks that the forms of RetrieveRange, RetrieveNearestRange and
+// RetrieveRangeAtIndex that return a pointer point at the map's own entry,
+// so that looking an entry up does not copy, and so relink, its linked_ptr.
+static bool RetrievePointerTest() {
+  TestMap range_map;
+  for (int object_id = 0; object_id < 10; ++object_id) {
+    linked_ptr<CountedObject> object(new CountedObject(object_id));
+    range_map.StoreRange(10 * object_id, 5, object);
+  }
+
+  for (int object_id = 0; object_id < 10; ++object_id) {
+    const linked_ptr<CountedObject> *object;
+    const linked_ptr<CountedObject> *nearest;
+    const linked_ptr<CountedObject> *at_index;
+    AddressType base;
+    if (!range_map.RetrieveRangePtr(10 * object_id + 2, object, &base,
+                                    NULL /* delta */, NULL /* size */) ||
+        !range_map.RetrieveNearestRangePtr(10 * object_id + 7, nearest,
+                                           NULL /* base */, NULL /* delta */,
+                                           NULL /* size */) ||
+        !range_map.RetrieveRangeAtIndexPtr(object_id, at_index,
+                                           NULL /* base */, NULL /* delta */,
+                                           NULL /* size */)) {
+      fprintf(stderr, "FAILED: RetrievePointerTest id %d, "
+              "expected success, observed failure\n", object_id);
+      return false;
+    }
+
+    if ((*object)->id() != object_id || base != 10 * object_id ||
+        nearest != object || at_index != object) {
+      fprintf(stderr, "FAILED: RetrievePointerTest id %d, "
+              "observed id %d, base %d\n", object_id, (*object)->id(), base);
+      return false;
+    }
+  }
+
+  const linked_ptr<CountedObject> *object;
+  if (range_map.RetrieveRangePtr(5, object, NULL /* base */, NULL /* delta */,
+                                 NULL /* size */)) {
+    fprintf(stderr, "FAILED: RetrievePointerTest address 5, "
+            "expected failure, observed success\n");
+    return false;
+  }
+
+  return true;
+}
+
+
 // RunTests runs a series of test sets.
 static bool RunTests() {
   // These tests will be run sequentially.  The first set of tests exercises
@@ -545,6 +593,11 @@ static bool RunTests() {
     return false;
   }
 
+  if (!RetrievePointerTest()) {
+    fprintf(stderr, "FAILED: did not pass RetrievePointerTest()\n");
+    return false;
+  }
+
   return true;
 }
 
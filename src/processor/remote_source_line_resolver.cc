@@ -0,0 +1,488 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// remote_source_line_resolver.cc: RemoteSourceLineResolver forwards symbol
+// lookups to a breakpad_symbolizer server.
+//
+// See remote_source_line_resolver.h for documentation.
+
+#include "google_breakpad/processor/remote_source_line_resolver.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "common/scoped_ptr.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "processor/cfi_frame_info.h"
+#include "processor/logging.h"
+#include "processor/symbolizer_protocol.h"
+#include "processor/windows_frame_info.h"
+
+namespace google_breakpad {
+
+namespace {
+
+// Reads one result of a SYMBOLIZER_LOOKUP_ADDRESSES response into frame,
+// whose module is loaded at base, and appends the frames inlined into it
+// to inlined_frames if that is not NULL.  Returns false if the response
+// is malformed.
+bool ReadLookupResult(uint64_t base,
+                      SymbolizerMessageReader *reader,
+                      StackFrame *frame,
+                      std::vector<StackFrame*> *inlined_frames) {
+  // An inlined frame the resolver found no source line for carries the
+  // original frame's source position, as it would have locally.
+  const string source_file_name = frame->source_file_name;
+  const int source_line = frame->source_line;
+  const uint64_t source_line_base = frame->source_line_base;
+
+  uint8_t flags;
+  if (!reader->ReadUInt8(&flags))
+    return false;
+  if (flags & SYMBOLIZER_HAS_FUNCTION) {
+    uint64_t function_base;
+    if (!reader->ReadString(&frame->function_name) ||
+        !reader->ReadUInt64(&function_base)) {
+      return false;
+    }
+    frame->function_base = base + function_base;
+  }
+
+  if (flags & SYMBOLIZER_HAS_LINE) {
+    uint32_t line;
+    uint64_t line_base;
+    if (!reader->ReadString(&frame->source_file_name) ||
+        !reader->ReadUInt32(&line) ||
+        !reader->ReadUInt64(&line_base)) {
+      return false;
+    }
+    frame->source_line = line;
+    frame->source_line_base = base + line_base;
+  }
+  uint32_t count;
+  if (!reader->ReadUInt32(&count))
+    return false;
+  std::vector<StackFrame*> frames;
+  for (uint32_t i = 0; i < count; ++i) {
+    scoped_ptr<StackFrame> inlined_frame(new StackFrame(*frame));
+    uint32_t line;
+    uint64_t function_base, line_base;
+    if (!reader->ReadString(&inlined_frame->function_name) ||
+        !reader->ReadUInt64(&function_base) ||
+        !reader->ReadString(&inlined_frame->source_file_name) ||
+        !reader->ReadUInt32(&line) ||
+        !reader->ReadUInt64(&line_base)) {
+      for (size_t j = 0; j < frames.size(); ++j)
+        delete frames[j];
+      return false;
+    }
+    inlined_frame->trust = StackFrame::FRAME_TRUST_INLINE;
+    inlined_frame->function_base = base + function_base;
+    if (line_base == kSymbolizerNoAddress) {
+      inlined_frame->source_file_name = source_file_name;
+      inlined_frame->source_line = source_line;
+      inlined_frame->source_line_base = source_line_base;
+    } else {
+      inlined_frame->source_line = line;
+      inlined_frame->source_line_base = base + line_base;
+    }
+    frames.push_back(inlined_frame.release());
+  }
+
+  if (inlined_frames) {
+    inlined_frames->insert(inlined_frames->end(), frames.begin(), frames.end());
+  } else {
+    for (size_t i = 0; i < frames.size(); ++i)
+      delete frames[i];
+  }
+  return true;
+}
+
+}  // namespace
+
+const int RemoteSourceLineResolver::kMinConnectDelayMs;
+const int RemoteSourceLineResolver::kMaxConnectDelayMs;
+
+RemoteSourceLineResolver::RemoteSourceLineResolver(const string &socket_path)
+    : socket_path_(socket_path),
+      max_request_size_(kSymbolizerMaxMessageSize),
+      connections_(0),
+      connect_delay_ms_(0) { }
+
+RemoteSourceLineResolver::RemoteSourceLineResolver(int fd)
+    : max_request_size_(kSymbolizerMaxMessageSize),
+      idle_fds_(1, fd),
+      connections_(1),
+      connect_delay_ms_(0) { }
+
+RemoteSourceLineResolver::~RemoteSourceLineResolver() {
+  for (size_t i = 0; i < idle_fds_.size(); ++i)
+    close(idle_fds_[i]);
+}
+
+bool RemoteSourceLineResolver::Connect() {
+  int fd = AcquireConnection();
+  if (fd < 0)
+    return false;
+  ReleaseConnection(fd, false);
+  return true;
+}
+
+bool RemoteSourceLineResolver::LoadModule(const CodeModule *module,
+                                          const string &map_file) {
+  return false;
+}
+
+bool RemoteSourceLineResolver::LoadModuleUsingMapBuffer(
+    const CodeModule *module,
+    const string &map_buffer) {
+  return false;
+}
+
+bool RemoteSourceLineResolver::LoadModuleUsingMemoryBuffer(
+    const CodeModule *module,
+    char *memory_buffer,
+    size_t memory_buffer_size) {
+  return false;
+}
+
+void RemoteSourceLineResolver::UnloadModule(const CodeModule *module) {
+  if (!module)
+    return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  module_states_.erase(ModuleKey(module));
+}
+
+bool RemoteSourceLineResolver::HasModule(const CodeModule *module) {
+  if (!module)
+    return false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<string, ModuleState>::const_iterator iter =
+        module_states_.find(ModuleKey(module));
+    if (iter != module_states_.end())
+      return iter->second.loaded;
+  }
+
+  SymbolizerMessageWriter writer;
+  writer.WriteUInt8(SYMBOLIZER_LOAD_MODULE);
+  writer.WriteModule(*module);
+  string response;
+  return Exchange(module, writer, &response);
+}
+
+bool RemoteSourceLineResolver::IsModuleCorrupt(const CodeModule *module) {
+  if (!module)
+    return false;
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::map<string, ModuleState>::const_iterator iter =
+      module_states_.find(ModuleKey(module));
+  return iter != module_states_.end() && iter->second.corrupt;
+}
+
+void RemoteSourceLineResolver::FillSourceLineInfo(StackFrame *frame) {
+  FillSourceLineInfo(frame, NULL);
+}
+
+void RemoteSourceLineResolver::FillSourceLineInfo(
+    StackFrame *frame,
+    std::vector<StackFrame*> *inlined_frames) {
+  if (!frame || !frame->module)
+    return;
+  std::vector<StackFrame*> frames(1, frame);
+  std::vector<std::vector<StackFrame*> > frame_inlined_frames;
+  FillSourceLineInfo(frame->module, frames,
+                     inlined_frames ? &frame_inlined_frames : NULL);
+  if (inlined_frames) {
+    inlined_frames->insert(inlined_frames->end(),
+                           frame_inlined_frames[0].begin(),
+                           frame_inlined_frames[0].end());
+  }
+}
+
+void RemoteSourceLineResolver::FillSourceLineInfo(
+    const CodeModule *module,
+    const std::vector<StackFrame*> &frames,
+    std::vector<std::vector<StackFrame*> > *inlined_frames) {
+  if (inlined_frames)
+    inlined_frames->resize(frames.size());
+  if (!module || frames.empty())
+    return;
+
+  if (!IsLoaded(module))
+    return;
+
+  // The addresses go in as many requests as their size calls for, and
+  // each request again for those the server's response had no room for.
+  const uint64_t base = module->base_address();
+  size_t done = 0;
+  while (done < frames.size()) {
+    SymbolizerMessageWriter writer;
+    writer.WriteUInt8(SYMBOLIZER_LOOKUP_ADDRESSES);
+    writer.WriteModule(*module);
+    size_t header_size = writer.message().size() + sizeof(uint32_t);
+    if (header_size >= max_request_size_)
+      return;
+    size_t count = std::min(frames.size() - done,
+                            (max_request_size_ - header_size) /
+                                sizeof(uint64_t));
+    if (count == 0)
+      return;
+    writer.WriteUInt32(count);
+    for (size_t i = done; i < done + count; ++i)
+      writer.WriteUInt64(frames[i]->instruction - base);
+
+    string response;
+    if (!Exchange(module, writer, &response))
+      return;
+    SymbolizerMessageReader reader(response);
+    uint32_t answered;
+    if (!reader.ReadUInt32(&answered) || answered == 0 || answered > count) {
+      BPLOG(ERROR) << "Malformed symbolizer response";
+      return;
+    }
+    for (size_t i = done; i < done + answered; ++i) {
+      if (!ReadLookupResult(base, &reader, frames[i],
+                            inlined_frames ? &(*inlined_frames)[i] : NULL)) {
+        BPLOG(ERROR) << "Malformed symbolizer response";
+        return;
+      }
+    }
+    done += answered;
+  }
+}
+
+WindowsFrameInfo *RemoteSourceLineResolver::FindWindowsFrameInfo(
+    const StackFrame *frame) {
+  if (!frame || !frame->module)
+    return NULL;
+  SymbolizerMessageWriter writer;
+  writer.WriteUInt8(SYMBOLIZER_FIND_WINDOWS_FRAME_INFO);
+  writer.WriteModule(*frame->module);
+  writer.WriteUInt64(frame->instruction - frame->module->base_address());
+
+  string response;
+  if (!IsLoaded(frame->module) || !Exchange(frame->module, writer, &response))
+    return NULL;
+  SymbolizerMessageReader reader(response);
+  uint8_t found;
+  if (!reader.ReadUInt8(&found) || !found)
+    return NULL;
+
+  uint32_t type, valid, prolog_size, epilog_size, parameter_size,
+      saved_register_size, local_size, max_stack_size;
+  uint8_t allocates_base_pointer;
+  string program_string;
+  if (!reader.ReadUInt32(&type) ||
+      !reader.ReadUInt32(&valid) ||
+      !reader.ReadUInt32(&prolog_size) ||
+      !reader.ReadUInt32(&epilog_size) ||
+      !reader.ReadUInt32(&parameter_size) ||
+      !reader.ReadUInt32(&saved_register_size) ||
+      !reader.ReadUInt32(&local_size) ||
+      !reader.ReadUInt32(&max_stack_size) ||
+      !reader.ReadUInt8(&allocates_base_pointer) ||
+      !reader.ReadString(&program_string) ||
+      (static_cast<int32_t>(type) != WindowsFrameInfo::STACK_INFO_UNKNOWN &&
+       type >= WindowsFrameInfo::STACK_INFO_LAST)) {
+    BPLOG(ERROR) << "Malformed symbolizer response";
+    return NULL;
+  }
+  WindowsFrameInfo *frame_info = new WindowsFrameInfo(
+      static_cast<WindowsFrameInfo::StackInfoTypes>(
+          static_cast<int32_t>(type)),
+      prolog_size, epilog_size, parameter_size, saved_register_size,
+      local_size, max_stack_size, allocates_base_pointer, program_string);
+  frame_info->valid = valid;
+  return frame_info;
+}
+
+CFIFrameInfo *RemoteSourceLineResolver::FindCFIFrameInfo(
+    const StackFrame *frame) {
+  if (!frame || !frame->module)
+    return NULL;
+  SymbolizerMessageWriter writer;
+  writer.WriteUInt8(SYMBOLIZER_FIND_CFI_FRAME_INFO);
+  writer.WriteModule(*frame->module);
+  writer.WriteUInt64(frame->instruction - frame->module->base_address());
+
+  string response;
+  if (!IsLoaded(frame->module) || !Exchange(frame->module, writer, &response))
+    return NULL;
+  SymbolizerMessageReader reader(response);
+  uint8_t found;
+  string rules;
+  if (!reader.ReadUInt8(&found) || !found)
+    return NULL;
+  scoped_ptr<CFIFrameInfo> frame_info(new CFIFrameInfo);
+  CFIFrameInfoParseHandler handler(frame_info.get());
+  CFIRuleParser parser(&handler);
+  if (!reader.ReadString(&rules) ||
+      (!rules.empty() && !parser.Parse(rules))) {
+    BPLOG(ERROR) << "Malformed symbolizer response";
+    return NULL;
+  }
+  return frame_info.release();
+}
+
+string RemoteSourceLineResolver::ModuleKey(const CodeModule *module) const {
+  string debug_identifier = module->debug_identifier();
+  if (debug_identifier.empty())
+    return module->code_file();
+  return module->debug_file() + "|" + debug_identifier;
+}
+
+bool RemoteSourceLineResolver::IsLoaded(const CodeModule *module) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::map<string, ModuleState>::const_iterator iter =
+      module_states_.find(ModuleKey(module));
+  return iter != module_states_.end() && iter->second.loaded;
+}
+
+bool RemoteSourceLineResolver::Exchange(const CodeModule *module,
+                                        const SymbolizerMessageWriter &writer,
+                                        string *response) {
+  // A connection the server has closed is only found out by using it, so
+  // a request that fails is sent once more, on a new connection.  Requests
+  // can be repeated safely, as they only ask questions.
+  uint8_t status, corrupt;
+  bool well_formed = false;
+  for (int attempt = 0; attempt < 2 && !well_formed; ++attempt) {
+    int fd = AcquireConnection();
+    if (fd < 0)
+      return false;
+    if (WriteSymbolizerMessage(fd, writer.message()) &&
+        ReadSymbolizerMessage(fd, response)) {
+      SymbolizerMessageReader reader(*response);
+      well_formed = reader.ReadUInt8(&status) && reader.ReadUInt8(&corrupt) &&
+                    status <= SYMBOLIZER_INTERRUPTED;
+    }
+    if (!well_formed)
+      BPLOG(ERROR) << "Lost connection to symbolizer server";
+    ReleaseConnection(fd, !well_formed);
+  }
+  if (!well_formed)
+    return false;
+
+  string key = ModuleKey(module);
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (status == SYMBOLIZER_INTERRUPTED) {
+    module_states_.erase(key);
+    return false;
+  }
+  ModuleState &state = module_states_[key];
+  state.loaded = status == SYMBOLIZER_LOADED;
+  state.corrupt = corrupt != 0;
+  response->erase(0, 2 * sizeof(uint8_t));
+  return state.loaded;
+}
+
+int RemoteSourceLineResolver::AcquireConnection() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (idle_fds_.empty()) {
+    if (socket_path_.empty()) {
+      // The connection the resolver was given is the only one.
+      if (connections_ == 0)
+        return -1;
+      connection_released_.wait(lock);
+      continue;
+    }
+
+    std::chrono::steady_clock::time_point now =
+        std::chrono::steady_clock::now();
+    if (now < next_connect_time_)
+      return -1;
+    ++connections_;
+    lock.unlock();
+    int fd = OpenConnection();
+    lock.lock();
+    if (fd >= 0) {
+      connect_delay_ms_ = 0;
+      return fd;
+    }
+    --connections_;
+    connect_delay_ms_ = connect_delay_ms_ == 0 ?
+        kMinConnectDelayMs :
+        std::min(2 * connect_delay_ms_, kMaxConnectDelayMs);
+    next_connect_time_ = now + std::chrono::milliseconds(connect_delay_ms_);
+    return -1;
+  }
+  int fd = idle_fds_.back();
+  idle_fds_.pop_back();
+  return fd;
+}
+
+void RemoteSourceLineResolver::ReleaseConnection(int fd, bool broken) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!broken) {
+    idle_fds_.push_back(fd);
+    connection_released_.notify_one();
+    return;
+  }
+  close(fd);
+  --connections_;
+  for (size_t i = 0; i < idle_fds_.size(); ++i)
+    close(idle_fds_[i]);
+  connections_ -= idle_fds_.size();
+  idle_fds_.clear();
+  connection_released_.notify_all();
+}
+
+int RemoteSourceLineResolver::OpenConnection() const {
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (socket_path_.size() >= sizeof(address.sun_path)) {
+    BPLOG(ERROR) << "Socket path too long: " << socket_path_;
+    return -1;
+  }
+  memcpy(address.sun_path, socket_path_.data(), socket_path_.size());
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    BPLOG(ERROR) << "socket failed: " << strerror(errno);
+    return -1;
+  }
+  if (connect(fd, reinterpret_cast<struct sockaddr*>(&address),
+              sizeof(address)) < 0) {
+    BPLOG(ERROR) << "Could not connect to " << socket_path_ << ": "
+                 << strerror(errno);
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,532 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// remote_source_line_resolver_unittest.cc: Unit tests for
+// RemoteSourceLineResolver and SymbolizerServer.  Each test connects a
+// resolver to a server over a socket pair, and checks that what it
+// answers is what a BasicSourceLineResolver answers locally.
+
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "breakpad_googletest_includes.h"
+#include "common/scoped_ptr.h"
+#include "common/tests/auto_tempdir.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "google_breakpad/processor/remote_source_line_resolver.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "google_breakpad/processor/symbol_supplier.h"
+#include "processor/basic_code_module.h"
+#include "processor/cfi_frame_info.h"
+#include "processor/symbolizer_protocol.h"
+#include "processor/symbolizer_server.h"
+#include "processor/windows_frame_info.h"
+
+namespace {
+
+using google_breakpad::AutoTempDir;
+using google_breakpad::BasicCodeModule;
+using google_breakpad::BasicSourceLineResolver;
+using google_breakpad::CFIFrameInfo;
+using google_breakpad::CodeModule;
+using google_breakpad::RemoteSourceLineResolver;
+using google_breakpad::StackFrame;
+using google_breakpad::SymbolizerMessageReader;
+using google_breakpad::SymbolizerMessageWriter;
+using google_breakpad::SymbolizerServer;
+using google_breakpad::SymbolSupplier;
+using google_breakpad::SystemInfo;
+using google_breakpad::WindowsFrameInfo;
+using google_breakpad::scoped_ptr;
+
+// inlinee_b is inlined into caller at file1.cc:12, and inlinee_a into
+// inlinee_b at file2.h:5.
+const char kSymbols[] =
+    "MODULE Linux x86_64 0123ABCD module1.so\n"
+    "FILE 0 file1.cc\n"
+    "FILE 1 file2.h\n"
+    "INLINE_ORIGIN 0 inlinee_a\n"
+    "INLINE_ORIGIN 1 inlinee_b\n"
+    "FUNC 1000 100 0 caller\n"
+    "INLINE 0 12 0 1 1010 20 1080 80\n"
+    "INLINE 1 5 1 0 1014 8\n"
+    "1000 14 10 0\n"
+    "1014 8 3 1\n"
+    "101c e4 20 1\n"
+    "FUNC 2000 10 8 no_lines\n"
+    "PUBLIC 3000 0 public_symbol\n"
+    "STACK WIN 4 2000 10 3 0 8 0 e0 0 1 $T0 $ebp = $eip $T0 4 + ^ =\n"
+    "STACK WIN 0 3000 8 1 0 4 0 0 0 0 1\n"
+    "STACK CFI INIT 1000 100 .cfa: $rsp 8 + .ra: .cfa -8 + ^\n"
+    "STACK CFI 1004 .cfa: $rsp 16 + $rbx: .cfa -16 + ^\n";
+
+// Supplies kSymbols for module1.pdb and nothing else.
+class TestSymbolSupplier : public SymbolSupplier {
+ public:
+  TestSymbolSupplier() : interrupt_(false), requests_(0) { }
+
+  virtual SymbolResult GetSymbolFile(const CodeModule *module,
+                                     const SystemInfo *system_info,
+                                     string *symbol_file) {
+    return NOT_FOUND;
+  }
+
+  virtual SymbolResult GetSymbolFile(const CodeModule *module,
+                                     const SystemInfo *system_info,
+                                     string *symbol_file,
+                                     string *symbol_data) {
+    return NOT_FOUND;
+  }
+
+  virtual SymbolResult GetCStringSymbolData(const CodeModule *module,
+                                            const SystemInfo *system_info,
+                                            string *symbol_file,
+                                            char **symbol_data,
+                                            size_t *symbol_data_size) {
+    ++requests_;
+    if (interrupt_)
+      return INTERRUPT;
+    if (module->debug_file() != "module1.pdb")
+      return NOT_FOUND;
+    *symbol_data_size = sizeof(kSymbols);
+    *symbol_data = new char[*symbol_data_size];
+    memcpy(*symbol_data, kSymbols, *symbol_data_size);
+    memory_buffers_[module->debug_file()] = *symbol_data;
+    return FOUND;
+  }
+
+  virtual void FreeSymbolData(const CodeModule *module) {
+    std::map<string, char*>::iterator iter =
+        memory_buffers_.find(module->debug_file());
+    if (iter != memory_buffers_.end()) {
+      delete [] iter->second;
+      memory_buffers_.erase(iter);
+    }
+  }
+
+  // When set to true, causes the SymbolSupplier to return INTERRUPT.
+  void set_interrupt(bool interrupt) { interrupt_ = interrupt; }
+
+  // The number of times symbol data has been asked for.
+  int requests() const { return requests_; }
+
+ private:
+  bool interrupt_;
+  int requests_;
+  std::map<string, char*> memory_buffers_;
+};
+
+class RemoteSourceLineResolverTest : public ::testing::Test {
+ public:
+  RemoteSourceLineResolverTest()
+      : module_(0x400000, 0x10000, "module1.so", "code_id",
+                "module1.pdb", "0123ABCD", "1.0"),
+        missing_module_(0x500000, 0x10000, "module2.so", "code_id",
+                        "module2.pdb", "4567CDEF", "1.0"),
+        server_(&supplier_, &server_resolver_) { }
+
+  void SetUp() {
+    int fds[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    resolver_.reset(new RemoteSourceLineResolver(fds[0]));
+    server_thread_ = std::thread(&SymbolizerServer::ServeConnection,
+                                 &server_, fds[1]);
+    ASSERT_TRUE(local_resolver_.LoadModuleUsingMapBuffer(&module_, kSymbols));
+  }
+
+  void TearDown() {
+    // Closing the client's end lets ServeConnection return.
+    resolver_.reset();
+    server_thread_.join();
+  }
+
+  // Looks up the address offset bytes into module_ with resolver,
+  // returning the frame and filling *inlined_frames.
+  static StackFrame Lookup(google_breakpad::SourceLineResolverInterface
+                               *resolver,
+                           const CodeModule *module, uint64_t offset,
+                           std::vector<StackFrame*> *inlined_frames) {
+    StackFrame frame;
+    frame.instruction = module->base_address() + offset;
+    frame.module = module;
+    resolver->FillSourceLineInfo(&frame, inlined_frames);
+    return frame;
+  }
+
+  static void ExpectSameFrame(const StackFrame &expected,
+                              const StackFrame &actual) {
+    EXPECT_EQ(expected.instruction, actual.instruction);
+    EXPECT_EQ(expected.trust, actual.trust);
+    EXPECT_EQ(expected.function_name, actual.function_name);
+    EXPECT_EQ(expected.function_base, actual.function_base);
+    EXPECT_EQ(expected.source_file_name, actual.source_file_name);
+    EXPECT_EQ(expected.source_line, actual.source_line);
+    EXPECT_EQ(expected.source_line_base, actual.source_line_base);
+  }
+
+  static void DeleteFrames(std::vector<StackFrame*> *frames) {
+    for (size_t i = 0; i < frames->size(); ++i)
+      delete (*frames)[i];
+    frames->clear();
+  }
+
+  BasicCodeModule module_;
+  BasicCodeModule missing_module_;
+  TestSymbolSupplier supplier_;
+  BasicSourceLineResolver server_resolver_;
+  SymbolizerServer server_;
+  std::thread server_thread_;
+  scoped_ptr<RemoteSourceLineResolver> resolver_;
+  BasicSourceLineResolver local_resolver_;
+};
+
+// Addresses with inlined calls, lines, a function without lines, a public
+// symbol, and nothing at all.
+const uint64_t kOffsets[] = {
+  0x1000, 0x1004, 0x1016, 0x1090, 0x10f0, 0x2004, 0x3004, 0x5000
+};
+
+TEST_F(RemoteSourceLineResolverTest, HasModule) {
+  EXPECT_TRUE(resolver_->HasModule(&module_));
+  EXPECT_FALSE(resolver_->IsModuleCorrupt(&module_));
+  EXPECT_TRUE(server_resolver_.HasModule(&module_));
+  EXPECT_FALSE(resolver_->HasModule(&missing_module_));
+  EXPECT_FALSE(server_resolver_.HasModule(&missing_module_));
+
+  // Symbols are always loaded by the server.
+  EXPECT_FALSE(resolver_->LoadModuleUsingMapBuffer(&missing_module_,
+                                                   kSymbols));
+  EXPECT_FALSE(resolver_->HasModule(&missing_module_));
+}
+
+TEST_F(RemoteSourceLineResolverTest, Interrupted) {
+  supplier_.set_interrupt(true);
+  EXPECT_FALSE(resolver_->HasModule(&module_));
+
+  // An interrupted load is not remembered, so asking again succeeds.
+  supplier_.set_interrupt(false);
+  EXPECT_TRUE(resolver_->HasModule(&module_));
+}
+
+TEST_F(RemoteSourceLineResolverTest, FillSourceLineInfo) {
+  // Nothing is found in a module until HasModule has been asked about it.
+  StackFrame frame = Lookup(resolver_.get(), &module_, 0x1016, NULL);
+  EXPECT_EQ("", frame.function_name);
+
+  ASSERT_TRUE(resolver_->HasModule(&module_));
+  for (size_t i = 0; i < sizeof(kOffsets) / sizeof(kOffsets[0]); ++i) {
+    std::vector<StackFrame*> expected_inlined, actual_inlined;
+    StackFrame expected = Lookup(&local_resolver_, &module_, kOffsets[i],
+                                 &expected_inlined);
+    StackFrame actual = Lookup(resolver_.get(), &module_, kOffsets[i],
+                               &actual_inlined);
+    ExpectSameFrame(expected, actual);
+    ASSERT_EQ(expected_inlined.size(), actual_inlined.size());
+    for (size_t j = 0; j < expected_inlined.size(); ++j)
+      ExpectSameFrame(*expected_inlined[j], *actual_inlined[j]);
+    DeleteFrames(&expected_inlined);
+    DeleteFrames(&actual_inlined);
+  }
+
+  // The inlined frames are only reported when asked for.
+  frame = Lookup(resolver_.get(), &module_, 0x1016, NULL);
+  EXPECT_EQ("caller", frame.function_name);
+  EXPECT_EQ("file1.cc", frame.source_file_name);
+  EXPECT_EQ(12, frame.source_line);
+
+  // Frames in modules without symbols are left alone.
+  EXPECT_FALSE(resolver_->HasModule(&missing_module_));
+  frame = Lookup(resolver_.get(), &missing_module_, 0x1016, NULL);
+  EXPECT_EQ("", frame.function_name);
+  EXPECT_EQ(0U, frame.function_base);
+}
+
+TEST_F(RemoteSourceLineResolverTest, FillSourceLineInfoBatch) {
+  ASSERT_TRUE(resolver_->HasModule(&module_));
+  const size_t count = sizeof(kOffsets) / sizeof(kOffsets[0]);
+  std::vector<StackFrame*> frames;
+  for (size_t i = 0; i < count; ++i) {
+    frames.push_back(new StackFrame);
+    frames.back()->instruction = module_.base_address() + kOffsets[i];
+    frames.back()->module = &module_;
+  }
+  std::vector<std::vector<StackFrame*> > inlined_frames;
+  resolver_->FillSourceLineInfo(&module_, frames, &inlined_frames);
+  ASSERT_EQ(count, inlined_frames.size());
+
+  for (size_t i = 0; i < count; ++i) {
+    std::vector<StackFrame*> expected_inlined;
+    StackFrame expected = Lookup(&local_resolver_, &module_, kOffsets[i],
+                                 &expected_inlined);
+    ExpectSameFrame(expected, *frames[i]);
+    ASSERT_EQ(expected_inlined.size(), inlined_frames[i].size());
+    for (size_t j = 0; j < expected_inlined.size(); ++j)
+      ExpectSameFrame(*expected_inlined[j], *inlined_frames[i][j]);
+    DeleteFrames(&expected_inlined);
+    DeleteFrames(&inlined_frames[i]);
+  }
+  DeleteFrames(&frames);
+}
+
+TEST_F(RemoteSourceLineResolverTest, FillSourceLineInfoSplit) {
+  // Requests hold three addresses, and responses only room for one or two
+  // results, so the batch takes many round trips, with the same results.
+  resolver_->set_max_request_size(64 + 3 * sizeof(uint64_t));
+  server_.set_max_response_size(160);
+  ASSERT_TRUE(resolver_->HasModule(&module_));
+  const size_t count = sizeof(kOffsets) / sizeof(kOffsets[0]);
+  std::vector<StackFrame*> frames;
+  for (size_t i = 0; i < 3 * count; ++i) {
+    frames.push_back(new StackFrame);
+    frames.back()->instruction = module_.base_address() + kOffsets[i % count];
+    frames.back()->module = &module_;
+  }
+  std::vector<std::vector<StackFrame*> > inlined_frames;
+  resolver_->FillSourceLineInfo(&module_, frames, &inlined_frames);
+  ASSERT_EQ(frames.size(), inlined_frames.size());
+
+  for (size_t i = 0; i < frames.size(); ++i) {
+    std::vector<StackFrame*> expected_inlined;
+    StackFrame expected = Lookup(&local_resolver_, &module_,
+                                 kOffsets[i % count], &expected_inlined);
+    ExpectSameFrame(expected, *frames[i]);
+    ASSERT_EQ(expected_inlined.size(), inlined_frames[i].size());
+    for (size_t j = 0; j < expected_inlined.size(); ++j)
+      ExpectSameFrame(*expected_inlined[j], *inlined_frames[i][j]);
+    DeleteFrames(&expected_inlined);
+    DeleteFrames(&inlined_frames[i]);
+  }
+  DeleteFrames(&frames);
+}
+
+TEST_F(RemoteSourceLineResolverTest, OversizedLookupResult) {
+  // A result too large for any response is sent empty rather than not at
+  // all, and the rest wait for the next request.
+  server_.set_max_response_size(16);
+  SymbolizerMessageWriter lookup;
+  lookup.WriteUInt8(google_breakpad::SYMBOLIZER_LOOKUP_ADDRESSES);
+  lookup.WriteModule(module_);
+  lookup.WriteUInt32(2);
+  lookup.WriteUInt64(0x1016);
+  lookup.WriteUInt64(0x1016);
+  string response;
+  ASSERT_TRUE(server_.HandleRequest(lookup.message(), &response));
+  SymbolizerMessageReader reader(response);
+  uint8_t status, corrupt, flags;
+  uint32_t answered, inlined_count;
+  ASSERT_TRUE(reader.ReadUInt8(&status));
+  EXPECT_EQ(google_breakpad::SYMBOLIZER_LOADED, status);
+  ASSERT_TRUE(reader.ReadUInt8(&corrupt));
+  ASSERT_TRUE(reader.ReadUInt32(&answered));
+  EXPECT_EQ(1U, answered);
+  ASSERT_TRUE(reader.ReadUInt8(&flags));
+  EXPECT_EQ(0, flags);
+  ASSERT_TRUE(reader.ReadUInt32(&inlined_count));
+  EXPECT_EQ(0U, inlined_count);
+  EXPECT_TRUE(reader.AtEnd());
+}
+
+TEST_F(RemoteSourceLineResolverTest, FindCFIFrameInfo) {
+  ASSERT_TRUE(resolver_->HasModule(&module_));
+  for (size_t i = 0; i < sizeof(kOffsets) / sizeof(kOffsets[0]); ++i) {
+    StackFrame frame;
+    frame.instruction = module_.base_address() + kOffsets[i];
+    frame.module = &module_;
+    scoped_ptr<CFIFrameInfo> expected(local_resolver_.FindCFIFrameInfo(&frame));
+    scoped_ptr<CFIFrameInfo> actual(resolver_->FindCFIFrameInfo(&frame));
+    ASSERT_EQ(expected.get() != NULL, actual.get() != NULL);
+    if (expected.get())
+      EXPECT_EQ(expected->Serialize(), actual->Serialize());
+  }
+}
+
+TEST_F(RemoteSourceLineResolverTest, FindWindowsFrameInfo) {
+  ASSERT_TRUE(resolver_->HasModule(&module_));
+  for (size_t i = 0; i < sizeof(kOffsets) / sizeof(kOffsets[0]); ++i) {
+    StackFrame frame;
+    frame.instruction = module_.base_address() + kOffsets[i];
+    frame.module = &module_;
+    scoped_ptr<WindowsFrameInfo> expected(
+        local_resolver_.FindWindowsFrameInfo(&frame));
+    scoped_ptr<WindowsFrameInfo> actual(resolver_->FindWindowsFrameInfo(&frame));
+    ASSERT_EQ(expected.get() != NULL, actual.get() != NULL);
+    if (!expected.get())
+      continue;
+    EXPECT_EQ(expected->type_, actual->type_);
+    EXPECT_EQ(expected->valid, actual->valid);
+    EXPECT_EQ(expected->prolog_size, actual->prolog_size);
+    EXPECT_EQ(expected->epilog_size, actual->epilog_size);
+    EXPECT_EQ(expected->parameter_size, actual->parameter_size);
+    EXPECT_EQ(expected->saved_register_size, actual->saved_register_size);
+    EXPECT_EQ(expected->local_size, actual->local_size);
+    EXPECT_EQ(expected->max_stack_size, actual->max_stack_size);
+    EXPECT_EQ(expected->allocates_base_pointer,
+              actual->allocates_base_pointer);
+    EXPECT_EQ(expected->program_string, actual->program_string);
+  }
+}
+
+TEST_F(RemoteSourceLineResolverTest, MissingSymbols) {
+  SymbolizerMessageWriter load;
+  load.WriteUInt8(google_breakpad::SYMBOLIZER_LOAD_MODULE);
+  load.WriteModule(missing_module_);
+  string response;
+
+  // The supplier is asked about a missing module only once.
+  ASSERT_TRUE(server_.HandleRequest(load.message(), &response));
+  ASSERT_EQ(2U, response.size());
+  EXPECT_EQ(google_breakpad::SYMBOLIZER_NOT_FOUND, response[0]);
+  EXPECT_EQ(1, supplier_.requests());
+  ASSERT_TRUE(server_.HandleRequest(load.message(), &response));
+  EXPECT_EQ(google_breakpad::SYMBOLIZER_NOT_FOUND, response[0]);
+  EXPECT_EQ(1, supplier_.requests());
+
+  // Unless missing modules are not to be remembered.
+  server_.set_missing_symbols_ttl(0);
+  SymbolizerMessageWriter other_load;
+  other_load.WriteUInt8(google_breakpad::SYMBOLIZER_LOAD_MODULE);
+  BasicCodeModule other_module(0x600000, 0x10000, "module3.so", "code_id",
+                               "module3.pdb", "89ABCDEF", "1.0");
+  other_load.WriteModule(other_module);
+  ASSERT_TRUE(server_.HandleRequest(other_load.message(), &response));
+  ASSERT_TRUE(server_.HandleRequest(other_load.message(), &response));
+  EXPECT_EQ(3, supplier_.requests());
+
+  // Loaded modules are answered without asking the supplier again.
+  SymbolizerMessageWriter loaded;
+  loaded.WriteUInt8(google_breakpad::SYMBOLIZER_LOAD_MODULE);
+  loaded.WriteModule(module_);
+  ASSERT_TRUE(server_.HandleRequest(loaded.message(), &response));
+  EXPECT_EQ(google_breakpad::SYMBOLIZER_LOADED, response[0]);
+  ASSERT_TRUE(server_.HandleRequest(loaded.message(), &response));
+  EXPECT_EQ(4, supplier_.requests());
+}
+
+TEST_F(RemoteSourceLineResolverTest, MalformedRequests) {
+  string response;
+  EXPECT_FALSE(server_.HandleRequest("", &response));
+
+  SymbolizerMessageWriter unknown;
+  unknown.WriteUInt8(99);
+  unknown.WriteModule(module_);
+  EXPECT_FALSE(server_.HandleRequest(unknown.message(), &response));
+
+  SymbolizerMessageWriter truncated;
+  truncated.WriteUInt8(google_breakpad::SYMBOLIZER_LOOKUP_ADDRESSES);
+  truncated.WriteModule(module_);
+  truncated.WriteUInt32(2);
+  truncated.WriteUInt64(0x1000);
+  EXPECT_FALSE(server_.HandleRequest(truncated.message(), &response));
+
+  SymbolizerMessageWriter trailing;
+  trailing.WriteUInt8(google_breakpad::SYMBOLIZER_FIND_CFI_FRAME_INFO);
+  trailing.WriteModule(module_);
+  trailing.WriteUInt64(0x1000);
+  EXPECT_TRUE(server_.HandleRequest(trailing.message(), &response));
+  trailing.WriteUInt8(0);
+  EXPECT_FALSE(server_.HandleRequest(trailing.message(), &response));
+}
+
+// Accepts two connections on listen_fd, closing the first after answering
+// one request, as a server that restarts would, and serving the second
+// until the client disconnects.
+void ServeTwoConnections(SymbolizerServer *server, int listen_fd) {
+  int fd = accept(listen_fd, NULL, NULL);
+  ASSERT_GE(fd, 0);
+  string request, response;
+  ASSERT_TRUE(google_breakpad::ReadSymbolizerMessage(fd, &request));
+  ASSERT_TRUE(server->HandleRequest(request, &response));
+  ASSERT_TRUE(google_breakpad::WriteSymbolizerMessage(fd, response));
+  close(fd);
+
+  fd = accept(listen_fd, NULL, NULL);
+  ASSERT_GE(fd, 0);
+  server->ServeConnection(fd);
+}
+
+TEST(RemoteSourceLineResolverConnectionTest, Reconnect) {
+  TestSymbolSupplier supplier;
+  BasicSourceLineResolver server_resolver;
+  SymbolizerServer server(&supplier, &server_resolver);
+  BasicCodeModule module(0x400000, 0x10000, "module1.so", "code_id",
+                         "module1.pdb", "0123ABCD", "1.0");
+
+  AutoTempDir temp_dir;
+  string socket_path = temp_dir.path() + "/socket";
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  ASSERT_LT(socket_path.size(), sizeof(address.sun_path));
+  memcpy(address.sun_path, socket_path.data(), socket_path.size());
+
+  // Without a server, connecting fails, and is not tried again at once.
+  scoped_ptr<RemoteSourceLineResolver> resolver(
+      new RemoteSourceLineResolver(socket_path));
+  EXPECT_FALSE(resolver->Connect());
+  EXPECT_FALSE(resolver->HasModule(&module));
+
+  int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_GE(listen_fd, 0);
+  ASSERT_EQ(0, bind(listen_fd, reinterpret_cast<struct sockaddr*>(&address),
+                    sizeof(address)));
+  ASSERT_EQ(0, listen(listen_fd, 1));
+  std::thread server_thread(ServeTwoConnections, &server, listen_fd);
+
+  // Once the delay has passed, the resolver connects.  The server closes
+  // that connection after one request, and the next request is sent again
+  // on a new one.
+  std::this_thread::sleep_for(std::chrono::milliseconds(
+      RemoteSourceLineResolver::kMinConnectDelayMs));
+  EXPECT_TRUE(resolver->HasModule(&module));
+  StackFrame frame;
+  frame.instruction = module.base_address() + 0x1016;
+  frame.module = &module;
+  resolver->FillSourceLineInfo(&frame);
+  EXPECT_EQ("caller", frame.function_name);
+
+  resolver.reset();
+  server_thread.join();
+  close(listen_fd);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
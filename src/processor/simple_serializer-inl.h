@@ -165,22 +165,7 @@ class SimpleSerializer<WindowsFrameInfo> {
 };
 
 // Specializations of SimpleSerializer: Linked_ptr version of
-// Line, Function, PublicSymbol, WindowsFrameInfo.
-template<>
-class SimpleSerializer< linked_ptr<BasicSourceLineResolver::Line> > {
-  typedef BasicSourceLineResolver::Line Line;
- public:
-  static size_t SizeOf(const linked_ptr<Line> &lineptr) {
-    if (lineptr.get() == NULL) return 0;
-    return SimpleSerializer<Line>::SizeOf(*(lineptr.get()));
-  }
-  static char *Write(const linked_ptr<Line> &lineptr, char *dest) {
-    if (lineptr.get())
-      dest = SimpleSerializer<Line>::Write(*(lineptr.get()), dest);
-    return dest;
-  }
-};
-
+// Function, PublicSymbol, WindowsFrameInfo.
 template<>
 class SimpleSerializer<BasicSourceLineResolver::Function> {
   // Convenient type names.
@@ -207,7 +192,7 @@ class SimpleSerializer<BasicSourceLineResolver::Function> {
   }
  private:
   // This static member is defined in module_serializer.cc.
-  static RangeMapSerializer< MemAddr, linked_ptr<Line> > range_map_serializer_;
+  static RangeMapSerializer<MemAddr, Line> range_map_serializer_;
 };
 
 template<>
@@ -38,8 +38,11 @@
 #include <string.h>
 #include <sys/stat.h>
 
+#include <algorithm>
+#include <list>
 #include <map>
 #include <utility>
+#include <vector>
 
 #include "google_breakpad/processor/source_line_resolver_base.h"
 #include "processor/source_line_resolver_base_types.h"
@@ -47,6 +50,7 @@
 
 using std::map;
 using std::make_pair;
+using std::vector;
 
 namespace google_breakpad {
 
@@ -55,10 +59,25 @@ SourceLineResolverBase::SourceLineResolverBase(
   : modules_(new ModuleMap),
     corrupt_modules_(new ModuleSet),
     memory_buffers_(new MemoryMap),
-    module_factory_(module_factory) {
+    module_factory_(module_factory),
+    symbol_data_budget_(0),
+    symbol_data_size_(0),
+    key_by_debug_identifier_(false),
+    cache_loads_(0),
+    cache_reloads_(0),
+    cache_evictions_(0),
+    next_generation_(0),
+    cfi_cache_capacity_(kDefaultCFICacheCapacity),
+    cfi_cache_hits_(0),
+    cfi_cache_misses_(0),
+    cfi_cache_evictions_(0) {
 }
 
 SourceLineResolverBase::~SourceLineResolverBase() {
+  CFICacheEntryMap::iterator cfi_it;
+  for (cfi_it = cfi_entries_.begin(); cfi_it != cfi_entries_.end(); ++cfi_it)
+    delete cfi_it->second.frame_info;
+
   ModuleMap::iterator it;
   // Iterate through ModuleMap and delete all loaded modules.
   for (it = modules_->begin(); it != modules_->end(); ++it) {
@@ -154,7 +173,8 @@ bool SourceLineResolverBase::LoadModule(const CodeModule *module,
     return false;
 
   // Make sure we don't already have a module with the given name.
-  if (modules_->find(module->code_file()) != modules_->end()) {
+  string key = ModuleKey(module);
+  if (IsModuleLoaded(key)) {
     BPLOG(INFO) << "Symbols for module " << module->code_file()
                 << " already loaded";
     return false;
@@ -170,17 +190,8 @@ bool SourceLineResolverBase::LoadModule(const CodeModule *module,
 
   BPLOG(INFO) << "Read symbol file " << map_file << " succeeded";
 
-  bool load_result = LoadModuleUsingMemoryBuffer(module, memory_buffer,
-                                                 memory_buffer_size);
-
-  if (load_result && !ShouldDeleteMemoryBufferAfterLoadModule()) {
-    // memory_buffer has to stay alive as long as the module.
-    memory_buffers_->insert(make_pair(module->code_file(), memory_buffer));
-  } else {
-    delete [] memory_buffer;
-  }
-
-  return load_result;
+  return LoadModuleUsingOwnedBuffer(module, key, memory_buffer,
+                                    memory_buffer_size);
 }
 
 bool SourceLineResolverBase::LoadModuleUsingMapBuffer(
@@ -189,7 +200,8 @@ bool SourceLineResolverBase::LoadModuleUsingMapBuffer(
     return false;
 
   // Make sure we don't already have a module with the given name.
-  if (modules_->find(module->code_file()) != modules_->end()) {
+  string key = ModuleKey(module);
+  if (IsModuleLoaded(key)) {
     BPLOG(INFO) << "Symbols for module " << module->code_file()
                 << " already loaded";
     return false;
@@ -206,17 +218,44 @@ bool SourceLineResolverBase::LoadModuleUsingMapBuffer(
   memcpy(memory_buffer, map_buffer.c_str(), map_buffer.size());
   memory_buffer[map_buffer.size()] = '\0';
 
-  bool load_result = LoadModuleUsingMemoryBuffer(module, memory_buffer,
-                                                 memory_buffer_size);
+  return LoadModuleUsingOwnedBuffer(module, key, memory_buffer,
+                                    memory_buffer_size);
+}
 
-  if (load_result && !ShouldDeleteMemoryBufferAfterLoadModule()) {
-    // memory_buffer has to stay alive as long as the module.
-    memory_buffers_->insert(make_pair(module->code_file(), memory_buffer));
-  } else {
+bool SourceLineResolverBase::LoadModuleUsingOwnedBuffer(
+    const CodeModule *module,
+    const string &key,
+    char *memory_buffer,
+    size_t memory_buffer_size) {
+  if (!ModulesKeepSymbolData()) {
+    bool load_result = LoadModuleFromBuffer(module, memory_buffer,
+                                            memory_buffer_size);
     delete [] memory_buffer;
+    return load_result;
+  }
+
+  // memory_buffer has to stay alive as long as the module.  It is recorded
+  // before the module is loaded, so that the module can't be evicted
+  // without its buffer being freed.
+  {
+    std::lock_guard<std::mutex> lock(modules_mutex_);
+    if (!memory_buffers_->insert(make_pair(key, memory_buffer)).second) {
+      BPLOG(INFO) << "Symbols for module " << module->code_file()
+                  << " already loaded";
+      delete [] memory_buffer;
+      return false;
+    }
   }
 
-  return load_result;
+  if (LoadModuleFromBuffer(module, memory_buffer, memory_buffer_size))
+    return true;
+
+  std::lock_guard<std::mutex> lock(modules_mutex_);
+  MemoryMap::iterator iter = memory_buffers_->find(key);
+  if (iter != memory_buffers_->end() && iter->second == memory_buffer)
+    memory_buffers_->erase(iter);
+  delete [] memory_buffer;
+  return false;
 }
 
 bool SourceLineResolverBase::LoadModuleUsingMemoryBuffer(
@@ -226,8 +265,34 @@ bool SourceLineResolverBase::LoadModuleUsingMemoryBuffer(
   if (!module)
     return false;
 
+  if (!ShouldDeleteMemoryBufferAfterLoadModule() || !ModulesKeepSymbolData())
+    return LoadModuleFromBuffer(module, memory_buffer, memory_buffer_size);
+
+  // The caller frees memory_buffer once this returns, but the module needs
+  // its symbol data for as long as it is loaded.  Load it from a copy the
+  // resolver owns, which is freed when the module is unloaded or evicted.
+  string key = ModuleKey(module);
+  if (IsModuleLoaded(key)) {
+    BPLOG(INFO) << "Symbols for module " << module->code_file()
+                << " already loaded";
+    return false;
+  }
+  char *owned_buffer = new char[memory_buffer_size];
+  memcpy(owned_buffer, memory_buffer, memory_buffer_size);
+  return LoadModuleUsingOwnedBuffer(module, key, owned_buffer,
+                                    memory_buffer_size);
+}
+
+bool SourceLineResolverBase::LoadModuleFromBuffer(
+    const CodeModule *module,
+    char *memory_buffer,
+    size_t memory_buffer_size) {
+  if (!module)
+    return false;
+
   // Make sure we don't already have a module with the given name.
-  if (modules_->find(module->code_file()) != modules_->end()) {
+  string key = ModuleKey(module);
+  if (IsModuleLoaded(key)) {
     BPLOG(INFO) << "Symbols for module " << module->code_file()
                 << " already loaded";
     return false;
@@ -248,10 +313,30 @@ bool SourceLineResolverBase::LoadModuleUsingMemoryBuffer(
     assert(basic_module->IsCorrupt());
   }
 
-  modules_->insert(make_pair(module->code_file(), basic_module));
+  // The symbol data is parsed without holding modules_mutex_, so another
+  // thread may have loaded the same module in the meantime.
+  std::lock_guard<std::mutex> lock(modules_mutex_);
+  if (!modules_->insert(make_pair(key, basic_module)).second) {
+    BPLOG(INFO) << "Symbols for module " << module->code_file()
+                << " already loaded";
+    delete basic_module;
+    return false;
+  }
   if (basic_module->IsCorrupt()) {
-    corrupt_modules_->insert(module->code_file());
+    corrupt_modules_->insert(key);
   }
+
+  CacheEntry entry;
+  entry.size = memory_buffer_size;
+  entry.lookups = 0;
+  entry.lru_position = lru_modules_.insert(lru_modules_.begin(), key);
+  entry.generation = next_generation_++;
+  cache_entries_.insert(make_pair(key, entry));
+  symbol_data_size_ += memory_buffer_size;
+  ++cache_loads_;
+  if (evicted_modules_.erase(key))
+    ++cache_reloads_;
+  EvictModules(key);
   return true;
 }
 
@@ -259,71 +344,353 @@ bool SourceLineResolverBase::ShouldDeleteMemoryBufferAfterLoadModule() {
   return true;
 }
 
+bool SourceLineResolverBase::ModulesKeepSymbolData() {
+  return !ShouldDeleteMemoryBufferAfterLoadModule();
+}
+
 void SourceLineResolverBase::UnloadModule(const CodeModule *code_module) {
   if (!code_module)
     return;
 
-  ModuleMap::iterator mod_iter = modules_->find(code_module->code_file());
+  std::lock_guard<std::mutex> lock(modules_mutex_);
+  RemoveModule(ModuleKey(code_module));
+}
+
+bool SourceLineResolverBase::HasModule(const CodeModule *module) {
+  if (!module)
+    return false;
+  string key = ModuleKey(module);
+  std::lock_guard<std::mutex> lock(modules_mutex_);
+  CacheEntryMap::iterator it = cache_entries_.find(key);
+  if (it == cache_entries_.end())
+    return false;
+  TouchModule(&it->second);
+  return true;
+}
+
+bool SourceLineResolverBase::IsModuleCorrupt(const CodeModule *module) {
+  if (!module)
+    return false;
+  string key = ModuleKey(module);
+  std::lock_guard<std::mutex> lock(modules_mutex_);
+  return corrupt_modules_->find(key) != corrupt_modules_->end();
+}
+
+void SourceLineResolverBase::PinModule(const CodeModule *module) {
+  if (!module)
+    return;
+  string key = ModuleKey(module);
+  std::lock_guard<std::mutex> lock(modules_mutex_);
+  ++module_pins_[key];
+}
+
+void SourceLineResolverBase::UnpinModule(const CodeModule *module) {
+  if (!module)
+    return;
+  string key = ModuleKey(module);
+  std::lock_guard<std::mutex> lock(modules_mutex_);
+  PinCountMap::iterator it = module_pins_.find(key);
+  if (it != module_pins_.end() && --it->second == 0)
+    module_pins_.erase(it);
+}
+
+void SourceLineResolverBase::set_symbol_data_budget(size_t budget) {
+  std::lock_guard<std::mutex> lock(modules_mutex_);
+  symbol_data_budget_ = budget;
+  EvictModules(string());
+}
+
+bool SourceLineResolverBase::set_key_by_debug_identifier(bool enabled) {
+  std::lock_guard<std::mutex> lock(modules_mutex_);
+  if (enabled == key_by_debug_identifier_)
+    return true;
+  if (!modules_->empty() || !memory_buffers_->empty()) {
+    BPLOG(ERROR) << "Modules can't be rekeyed while any are loaded";
+    return false;
+  }
+  key_by_debug_identifier_ = enabled;
+  return true;
+}
+
+SourceLineResolverBase::ModuleCacheStats
+SourceLineResolverBase::module_cache_stats() {
+  std::lock_guard<std::mutex> lock(modules_mutex_);
+  ModuleCacheStats stats;
+  stats.loads = cache_loads_;
+  stats.reloads = cache_reloads_;
+  stats.evictions = cache_evictions_;
+  stats.modules = cache_entries_.size();
+  stats.symbol_data_bytes = symbol_data_size_;
+  return stats;
+}
+
+void SourceLineResolverBase::set_cfi_cache_capacity(size_t capacity) {
+  std::lock_guard<std::mutex> lock(cfi_cache_mutex_);
+  cfi_cache_capacity_ = capacity;
+  EvictCFIEntries();
+}
+
+SourceLineResolverBase::CFICacheStats
+SourceLineResolverBase::cfi_cache_stats() {
+  std::lock_guard<std::mutex> lock(cfi_cache_mutex_);
+  CFICacheStats stats;
+  stats.hits = cfi_cache_hits_;
+  stats.misses = cfi_cache_misses_;
+  stats.evictions = cfi_cache_evictions_;
+  stats.entries = cfi_entries_.size();
+  return stats;
+}
+
+string SourceLineResolverBase::ModuleKey(const CodeModule *module) const {
+  // The debug file and identifier name the symbols themselves, wherever
+  // the module was loaded from.
+  if (!key_by_debug_identifier_)
+    return module->code_file();
+  string debug_identifier = module->debug_identifier();
+  if (debug_identifier.empty())
+    return module->code_file();
+  return module->debug_file() + "|" + debug_identifier;
+}
+
+bool SourceLineResolverBase::IsModuleLoaded(const string &key) {
+  std::lock_guard<std::mutex> lock(modules_mutex_);
+  return modules_->find(key) != modules_->end();
+}
+
+SourceLineResolverBase::Module *SourceLineResolverBase::AcquireModule(
+    const string &key, uint64_t *generation) {
+  std::lock_guard<std::mutex> lock(modules_mutex_);
+  ModuleMap::const_iterator it = modules_->find(key);
+  if (it == modules_->end())
+    return NULL;
+  CacheEntryMap::iterator entry = cache_entries_.find(key);
+  if (entry != cache_entries_.end()) {
+    ++entry->second.lookups;
+    TouchModule(&entry->second);
+    if (generation)
+      *generation = entry->second.generation;
+  }
+  return it->second;
+}
+
+void SourceLineResolverBase::ReleaseModule(const string &key) {
+  std::lock_guard<std::mutex> lock(modules_mutex_);
+  CacheEntryMap::iterator entry = cache_entries_.find(key);
+  if (entry != cache_entries_.end())
+    --entry->second.lookups;
+}
+
+void SourceLineResolverBase::ReleaseModuleData(const string &key) {
+  MemoryMap::iterator iter = memory_buffers_->find(key);
+  if (iter != memory_buffers_->end()) {
+    delete [] iter->second;
+    memory_buffers_->erase(iter);
+  }
+}
+
+void SourceLineResolverBase::TouchModule(CacheEntry *entry) {
+  lru_modules_.splice(lru_modules_.begin(), lru_modules_,
+                      entry->lru_position);
+}
+
+void SourceLineResolverBase::EvictModules(const string &keep) {
+  if (symbol_data_budget_ == 0 || symbol_data_size_ <= symbol_data_budget_)
+    return;
+
+  // Pick victims first, as removing them invalidates the LRU iterators.
+  vector<string> victims;
+  size_t size = symbol_data_size_;
+  std::list<string>::reverse_iterator it = lru_modules_.rbegin();
+  for (; it != lru_modules_.rend() && size > symbol_data_budget_; ++it) {
+    const CacheEntry &entry = cache_entries_[*it];
+    if (*it == keep || entry.lookups > 0 ||
+        module_pins_.find(*it) != module_pins_.end()) {
+      continue;
+    }
+    victims.push_back(*it);
+    size -= entry.size;
+  }
+
+  for (size_t i = 0; i < victims.size(); ++i) {
+    BPLOG(INFO) << "Evicting symbols for module " << victims[i];
+    RemoveModule(victims[i]);
+    evicted_modules_.insert(victims[i]);
+    ++cache_evictions_;
+  }
+}
+
+void SourceLineResolverBase::RemoveModule(const string &key) {
+  ModuleMap::iterator mod_iter = modules_->find(key);
   if (mod_iter != modules_->end()) {
     Module *symbol_module = mod_iter->second;
     delete symbol_module;
-    corrupt_modules_->erase(mod_iter->first);
     modules_->erase(mod_iter);
   }
+  corrupt_modules_->erase(key);
 
-  if (ShouldDeleteMemoryBufferAfterLoadModule()) {
-    // No-op.  Because we never store any memory buffers.
-  } else {
-    // There may be a buffer stored locally, we need to find and delete it.
-    MemoryMap::iterator iter = memory_buffers_->find(code_module->code_file());
-    if (iter != memory_buffers_->end()) {
-      delete [] iter->second;
-      memory_buffers_->erase(iter);
-    }
+  CacheEntryMap::iterator entry = cache_entries_.find(key);
+  if (entry != cache_entries_.end()) {
+    symbol_data_size_ -= entry->second.size;
+    lru_modules_.erase(entry->second.lru_position);
+    cache_entries_.erase(entry);
   }
+
+  RemoveCFIEntries(key);
+
+  // There may be a buffer stored locally, we need to find and delete it.
+  ReleaseModuleData(key);
 }
 
-bool SourceLineResolverBase::HasModule(const CodeModule *module) {
-  if (!module)
-    return false;
-  return modules_->find(module->code_file()) != modules_->end();
+void SourceLineResolverBase::EvictCFIEntries() {
+  while (cfi_entries_.size() > cfi_cache_capacity_) {
+    CFICacheEntryMap::iterator entry =
+        cfi_entries_.find(lru_cfi_entries_.back());
+    delete entry->second.frame_info;
+    cfi_entries_.erase(entry);
+    lru_cfi_entries_.pop_back();
+    ++cfi_cache_evictions_;
+  }
 }
 
-bool SourceLineResolverBase::IsModuleCorrupt(const CodeModule *module) {
-  if (!module)
-    return false;
-  return corrupt_modules_->find(module->code_file()) != corrupt_modules_->end();
+void SourceLineResolverBase::RemoveCFIEntries(const string &key) {
+  std::lock_guard<std::mutex> lock(cfi_cache_mutex_);
+  CFICacheEntryMap::iterator entry =
+      cfi_entries_.lower_bound(CFICacheKey(key, 0));
+  while (entry != cfi_entries_.end() && entry->first.first == key) {
+    delete entry->second.frame_info;
+    lru_cfi_entries_.erase(entry->second.lru_position);
+    cfi_entries_.erase(entry++);
+  }
 }
 
 void SourceLineResolverBase::FillSourceLineInfo(StackFrame *frame) {
-  if (frame->module) {
-    ModuleMap::const_iterator it = modules_->find(frame->module->code_file());
-    if (it != modules_->end()) {
-      it->second->LookupAddress(frame);
+  FillSourceLineInfo(frame, NULL);
+}
+
+void SourceLineResolverBase::FillSourceLineInfo(
+    StackFrame *frame, std::vector<StackFrame*> *inlined_frames) {
+  if (!frame->module)
+    return;
+  string key = ModuleKey(frame->module);
+  Module *module = AcquireModule(key);
+  if (module) {
+    module->LookupAddress(frame, inlined_frames);
+    ReleaseModule(key);
+  }
+}
+
+void SourceLineResolverBase::FillSourceLineInfo(
+    const CodeModule *code_module,
+    const std::vector<StackFrame*> &frames,
+    std::vector<std::vector<StackFrame*> > *inlined_frames) {
+  if (inlined_frames)
+    inlined_frames->resize(frames.size());
+  if (!code_module || frames.empty())
+    return;
+  string key = ModuleKey(code_module);
+  Module *module = AcquireModule(key);
+  if (!module)
+    return;
+
+  bool sorted = true;
+  for (size_t i = 1; sorted && i < frames.size(); ++i)
+    sorted = frames[i - 1]->instruction <= frames[i]->instruction;
+  if (sorted) {
+    module->LookupAddresses(frames, inlined_frames);
+    ReleaseModule(key);
+    return;
+  }
+
+  // Look the frames up in address order, then hand each one's inlined
+  // frames back in the caller's order.
+  vector<std::pair<uint64_t, size_t> > order(frames.size());
+  for (size_t i = 0; i < frames.size(); ++i)
+    order[i] = make_pair(frames[i]->instruction, i);
+  std::sort(order.begin(), order.end());
+  vector<StackFrame*> sorted_frames(frames.size());
+  for (size_t i = 0; i < order.size(); ++i)
+    sorted_frames[i] = frames[order[i].second];
+  vector<vector<StackFrame*> > sorted_inlined_frames(
+      inlined_frames ? frames.size() : 0);
+  module->LookupAddresses(sorted_frames,
+                          inlined_frames ? &sorted_inlined_frames : NULL);
+  ReleaseModule(key);
+  if (inlined_frames) {
+    for (size_t i = 0; i < order.size(); ++i) {
+      vector<StackFrame*> &frame_inlined_frames =
+          (*inlined_frames)[order[i].second];
+      frame_inlined_frames.insert(frame_inlined_frames.end(),
+                                  sorted_inlined_frames[i].begin(),
+                                  sorted_inlined_frames[i].end());
     }
   }
 }
 
 WindowsFrameInfo *SourceLineResolverBase::FindWindowsFrameInfo(
     const StackFrame *frame) {
-  if (frame->module) {
-    ModuleMap::const_iterator it = modules_->find(frame->module->code_file());
-    if (it != modules_->end()) {
-      return it->second->FindWindowsFrameInfo(frame);
-    }
+  if (!frame->module)
+    return NULL;
+  string key = ModuleKey(frame->module);
+  Module *module = AcquireModule(key);
+  if (module) {
+    WindowsFrameInfo *frame_info = module->FindWindowsFrameInfo(frame);
+    ReleaseModule(key);
+    return frame_info;
   }
   return NULL;
 }
 
 CFIFrameInfo *SourceLineResolverBase::FindCFIFrameInfo(
     const StackFrame *frame) {
-  if (frame->module) {
-    ModuleMap::const_iterator it = modules_->find(frame->module->code_file());
-    if (it != modules_->end()) {
-      return it->second->FindCFIFrameInfo(frame);
+  if (!frame->module)
+    return NULL;
+  string key = ModuleKey(frame->module);
+  CFICacheKey cfi_key(key,
+                      frame->instruction - frame->module->base_address());
+
+  // A copy of a cached rule set shares its rules and any compiled
+  // program with it, rather than copying them.
+  {
+    std::lock_guard<std::mutex> lock(cfi_cache_mutex_);
+    CFICacheEntryMap::iterator entry = cfi_entries_.find(cfi_key);
+    if (entry != cfi_entries_.end()) {
+      ++cfi_cache_hits_;
+      lru_cfi_entries_.splice(lru_cfi_entries_.begin(), lru_cfi_entries_,
+                              entry->second.lru_position);
+      const CFIFrameInfo *frame_info = entry->second.frame_info;
+      return frame_info ? new CFIFrameInfo(*frame_info) : NULL;
     }
   }
-  return NULL;
+
+  uint64_t generation = 0;
+  Module *module = AcquireModule(key, &generation);
+  if (!module)
+    return NULL;
+  CFIFrameInfo *frame_info = module->FindCFIFrameInfo(frame);
+
+  // Cache the rules only if the module they came from is still the one
+  // loaded under |key|.  Otherwise RemoveCFIEntries() may already have
+  // run for it, and nothing would remove these rules once the module is
+  // gone.  Holding modules_mutex_ keeps the module loaded until they are
+  // cached, as RemoveModule() takes it first.
+  {
+    std::lock_guard<std::mutex> modules_lock(modules_mutex_);
+    std::lock_guard<std::mutex> lock(cfi_cache_mutex_);
+    ++cfi_cache_misses_;
+    CacheEntryMap::const_iterator resident = cache_entries_.find(key);
+    if (cfi_cache_capacity_ > 0 &&
+        resident != cache_entries_.end() &&
+        resident->second.generation == generation &&
+        cfi_entries_.find(cfi_key) == cfi_entries_.end()) {
+      CFICacheEntry &entry = cfi_entries_[cfi_key];
+      entry.frame_info = frame_info ? new CFIFrameInfo(*frame_info) : NULL;
+      lru_cfi_entries_.push_front(cfi_key);
+      entry.lru_position = lru_cfi_entries_.begin();
+      EvictCFIEntries();
+    }
+  }
+  ReleaseModule(key);
+  return frame_info;
 }
 
 bool SourceLineResolverBase::CompareString::operator()(
@@ -331,6 +698,13 @@ bool SourceLineResolverBase::CompareString::operator()(
   return strcmp(s1.c_str(), s2.c_str()) < 0;
 }
 
+void SourceLineResolverBase::Module::LookupAddresses(
+    const std::vector<StackFrame*> &frames,
+    std::vector<std::vector<StackFrame*> > *inlined_frames) const {
+  for (size_t i = 0; i < frames.size(); ++i)
+    LookupAddress(frames[i], inlined_frames ? &(*inlined_frames)[i] : NULL);
+}
+
 bool SourceLineResolverBase::Module::ParseCFIRuleSet(
     const string &rule_set, CFIFrameInfo *frame_info) const {
   CFIFrameInfoParseHandler handler(frame_info);
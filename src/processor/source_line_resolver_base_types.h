@@ -42,6 +42,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "google_breakpad/common/breakpad_types.h"
 #include "google_breakpad/processor/source_line_resolver_base.h"
@@ -141,8 +142,20 @@ class SourceLineResolverBase::Module {
   virtual bool IsCorrupt() const = 0;
 
   // Looks up the given relative address, and fills the StackFrame struct
-  // with the result.
-  virtual void LookupAddress(StackFrame *frame) const = 0;
+  // with the result.  If |inlined_frames| is not NULL, frames for any
+  // inlined calls at the address are appended to it, as described for
+  // SourceLineResolverInterface::FillSourceLineInfo.
+  virtual void LookupAddress(StackFrame *frame,
+                             std::vector<StackFrame*> *inlined_frames) const = 0;
+
+  // Looks up each of |frames|, which are sorted by instruction address, as
+  // LookupAddress does.  If |inlined_frames| is not NULL, it has an element
+  // for each frame, to which that frame's inlined frames are appended.
+  // Modules may override this to sweep through their symbols once, rather
+  // than searching them for every address.
+  virtual void LookupAddresses(
+      const std::vector<StackFrame*> &frames,
+      std::vector<std::vector<StackFrame*> > *inlined_frames) const;
 
   // If Windows stack walking information is available covering ADDRESS,
   // return a WindowsFrameInfo structure describing it. If the information
@@ -0,0 +1,398 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// source_line_resolver_benchmark.cc: Time loading a large synthetic
+// module into BasicSourceLineResolver and FastSourceLineResolver, and
+// looking up symbols in it, filling in frames one at a time and as a
+// batch.
+//
+// The module's symbols are generated in memory, so no symbol files are
+// needed.  Like symbols dumped from a large C++ binary, it has a FILE
+// record per 50 functions, a FUNC record with 4 line records per function,
+// a STACK CFI INIT record for every third function, and a PUBLIC record
+// in a gap after every 16th function.  The addresses looked up are
+// spread uniformly over the module.
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/path_helper.h"
+#include "common/scoped_ptr.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "google_breakpad/processor/fast_source_line_resolver.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "processor/basic_code_module.h"
+#include "processor/logging.h"
+#include "processor/module_serializer.h"
+
+namespace {
+
+using google_breakpad::BasicCodeModule;
+using google_breakpad::BasicSourceLineResolver;
+using google_breakpad::FastSourceLineResolver;
+using google_breakpad::ModuleSerializer;
+using google_breakpad::SourceLineResolverInterface;
+using google_breakpad::StackFrame;
+using google_breakpad::scoped_array;
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+  int function_count;
+  int address_count;
+  int runs;
+};
+
+// The module's load address.  Symbol addresses are relative to it.
+const uint64_t kModuleBase = 0x10000000;
+
+// Appends to symbol_data the symbols of a module with function_count
+// functions, as described at the top of this file, and returns the size
+// of the code they cover.
+uint64_t MakeSymbolData(int function_count, string* symbol_data) {
+  char record[256];
+  symbol_data->append("MODULE Linux x86_64 "
+                      "0123456789ABCDEF0123456789ABCDEF0 benchmark.so\n");
+  int file_count = function_count / 50 + 1;
+  for (int file = 0; file < file_count; ++file) {
+    snprintf(record, sizeof(record), "FILE %d src/dir%d/file%d.cc\n",
+             file, file, file);
+    symbol_data->append(record);
+  }
+
+  string cfi_data;
+  uint64_t address = 0x1000;
+  for (int function = 0; function < function_count; ++function) {
+    uint64_t size = 0x40 + (function % 8) * 0x10;
+    snprintf(record, sizeof(record),
+             "FUNC %llx %llx 0 namespace_%d::Class%d::Method%d"
+             "(int, char const*)\n",
+             static_cast<unsigned long long>(address),
+             static_cast<unsigned long long>(size),
+             function % 100, function, function);
+    symbol_data->append(record);
+    for (int line = 0; line < 4; ++line) {
+      snprintf(record, sizeof(record), "%llx %llx %d %d\n",
+               static_cast<unsigned long long>(address + line * size / 4),
+               static_cast<unsigned long long>(size / 4),
+               10 + line, function / 50);
+      symbol_data->append(record);
+    }
+    if (function % 3 == 0) {
+      snprintf(record, sizeof(record),
+               "STACK CFI INIT %llx %llx .cfa: $rsp 8 + .ra: .cfa -8 + ^\n",
+               static_cast<unsigned long long>(address),
+               static_cast<unsigned long long>(size));
+      cfi_data.append(record);
+    }
+    address += size;
+    if (function % 16 == 15) {
+      snprintf(record, sizeof(record), "PUBLIC %llx 0 stub_%d\n",
+               static_cast<unsigned long long>(address), function);
+      symbol_data->append(record);
+      address += 0x20;
+    }
+  }
+  symbol_data->append(cfi_data);
+  return address;
+}
+
+// Clears what FillSourceLineInfo fills in, so that every run starts from
+// the same frames.
+void ResetFrames(std::vector<StackFrame>* frames) {
+  for (size_t i = 0; i < frames->size(); ++i) {
+    StackFrame* frame = &(*frames)[i];
+    frame->function_name.clear();
+    frame->function_base = 0;
+    frame->source_file_name.clear();
+    frame->source_line = 0;
+    frame->source_line_base = 0;
+  }
+}
+
+double Milliseconds(Clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+double Median(std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  return values[values.size() / 2];
+}
+
+// Loads module from a copy of data options.runs times, and prints the
+// median time taken.  The module is unloaded between runs.
+void TimeLoading(SourceLineResolverInterface* resolver,
+                 const BasicCodeModule* module,
+                 const std::vector<char>& data,
+                 const char* description,
+                 const Options& options) {
+  std::vector<double> times;
+  for (int run = 0; run < options.runs; ++run) {
+    // Loading modifies the buffer, and a lazy module keeps it.
+    std::vector<char> buffer(data);
+    Clock::time_point start = Clock::now();
+    bool loaded = resolver->LoadModuleUsingMemoryBuffer(module, &buffer[0],
+                                                        buffer.size());
+    times.push_back(Milliseconds(Clock::now() - start));
+    if (!loaded) {
+      fprintf(stderr, "Could not load the synthetic module\n");
+      exit(1);
+    }
+    resolver->UnloadModule(module);
+  }
+  printf("  %-28s %9.1f ms\n", description, Median(times));
+}
+
+// Times loading module into each kind of resolver.  symbol_data holds the
+// module's symbols.
+void BenchmarkLoading(const string& symbol_data,
+                      const BasicCodeModule* module,
+                      const Options& options) {
+  printf("Loading:\n");
+  std::vector<char> data(symbol_data.begin(), symbol_data.end());
+  data.push_back('\0');
+  BasicSourceLineResolver eager_resolver;
+  TimeLoading(&eager_resolver, module, data, "BasicSourceLineResolver",
+              options);
+
+  BasicSourceLineResolver lazy_resolver;
+  lazy_resolver.set_lazy_parsing(true);
+  TimeLoading(&lazy_resolver, module, data, "BasicSourceLineResolver, lazy",
+              options);
+
+  ModuleSerializer serializer;
+  unsigned int fast_data_size;
+  scoped_array<char> fast_data(
+      serializer.SerializeSymbolFileData(symbol_data, &fast_data_size));
+  FastSourceLineResolver fast_resolver;
+  TimeLoading(&fast_resolver, module,
+              std::vector<char>(fast_data.get(),
+                                fast_data.get() + fast_data_size),
+              "FastSourceLineResolver", options);
+}
+
+// Fills in frame_pointers' frames options.runs times, one frame at a time
+// if batch is false, and all at once otherwise, and prints the median
+// time taken.
+void TimeLookups(SourceLineResolverInterface* resolver,
+                 const BasicCodeModule* module,
+                 const std::vector<StackFrame*>& frame_pointers,
+                 std::vector<StackFrame>* frames,
+                 bool batch,
+                 const char* description,
+                 const Options& options) {
+  std::vector<double> times;
+  for (int run = 0; run < options.runs; ++run) {
+    ResetFrames(frames);
+    Clock::time_point start = Clock::now();
+    if (batch) {
+      resolver->FillSourceLineInfo(module, frame_pointers, NULL);
+    } else {
+      for (size_t i = 0; i < frame_pointers.size(); ++i)
+        resolver->FillSourceLineInfo(frame_pointers[i]);
+    }
+    times.push_back(Milliseconds(Clock::now() - start));
+  }
+  double median = Median(times);
+  printf("  %-28s %9.1f ms %8.1f ns/address\n", description, median,
+         median * 1e6 / frame_pointers.size());
+}
+
+// Returns false if frames and expected differ in anything
+// FillSourceLineInfo fills in.
+bool SameResults(const std::vector<StackFrame>& frames,
+                 const std::vector<StackFrame>& expected) {
+  for (size_t i = 0; i < frames.size(); ++i) {
+    if (frames[i].function_name != expected[i].function_name ||
+        frames[i].function_base != expected[i].function_base ||
+        frames[i].source_file_name != expected[i].source_file_name ||
+        frames[i].source_line != expected[i].source_line ||
+        frames[i].source_line_base != expected[i].source_line_base) {
+      fprintf(stderr, "Batch lookup of 0x%llx differs from a single one\n",
+              static_cast<unsigned long long>(frames[i].instruction));
+      return false;
+    }
+  }
+  return true;
+}
+
+// Times lookups of every frame in frames with resolver, which has module
+// loaded, in address order and in a random order.
+bool BenchmarkLookups(const char* name,
+                      SourceLineResolverInterface* resolver,
+                      const BasicCodeModule* module,
+                      std::vector<StackFrame>* frames,
+                      const Options& options) {
+  printf("%s:\n", name);
+  std::vector<StackFrame*> sorted(frames->size());
+  for (size_t i = 0; i < frames->size(); ++i)
+    sorted[i] = &(*frames)[i];
+  std::vector<StackFrame*> shuffled(sorted);
+  std::mt19937 random(1);
+  std::shuffle(shuffled.begin(), shuffled.end(), random);
+
+  TimeLookups(resolver, module, sorted, frames, false,
+              "one at a time, sorted", options);
+  std::vector<StackFrame> expected(*frames);
+  TimeLookups(resolver, module, sorted, frames, true,
+              "batch, sorted", options);
+  if (!SameResults(*frames, expected))
+    return false;
+  TimeLookups(resolver, module, shuffled, frames, false,
+              "one at a time, shuffled", options);
+  TimeLookups(resolver, module, shuffled, frames, true,
+              "batch, shuffled", options);
+  return SameResults(*frames, expected);
+}
+
+void Usage(int argc, const char *argv[], bool error) {
+  fprintf(error ? stderr : stdout,
+          "Usage: %s [options]\n"
+          "\n"
+          "Time loading a synthetic module, and symbol lookups in it one\n"
+          "frame at a time and as a batch\n"
+          "\n"
+          "Options:\n"
+          "\n"
+          "  -a <count>  Look up <count> addresses (default 1000000)\n"
+          "  -f <count>  Give the module <count> functions (default 100000)\n"
+          "  -r <count>  Report the median of <count> runs (default 5)\n",
+          google_breakpad::BaseName(argv[0]).c_str());
+}
+
+// Parses a count of at least 1 for option ch, or exits.
+int ParseCount(int argc, const char *argv[], int ch, const char *value) {
+  char *end;
+  long count = strtol(value, &end, 10);
+  if (*value == '\0' || *end != '\0' || count < 1 || count > INT_MAX) {
+    fprintf(stderr, "%s: Invalid count for -%c: %s\n", argv[0], ch, value);
+    Usage(argc, argv, true);
+    exit(1);
+  }
+  return count;
+}
+
+void SetupOptions(int argc, const char *argv[], Options *options) {
+  int ch;
+
+  options->function_count = 100000;
+  options->address_count = 1000000;
+  options->runs = 5;
+
+  while ((ch = getopt(argc, (char * const *)argv, "a:f:hr:")) != -1) {
+    switch (ch) {
+      case 'h':
+        Usage(argc, argv, false);
+        exit(0);
+        break;
+
+      case 'a':
+        options->address_count = ParseCount(argc, argv, ch, optarg);
+        break;
+
+      case 'f':
+        options->function_count = ParseCount(argc, argv, ch, optarg);
+        break;
+
+      case 'r':
+        options->runs = ParseCount(argc, argv, ch, optarg);
+        break;
+
+      case '?':
+        Usage(argc, argv, true);
+        exit(1);
+        break;
+    }
+  }
+
+  if (optind != argc) {
+    Usage(argc, argv, true);
+    exit(1);
+  }
+}
+
+}  // namespace
+
+int main(int argc, const char *argv[]) {
+  Options options;
+  SetupOptions(argc, argv, &options);
+
+  string symbol_data;
+  uint64_t module_size = MakeSymbolData(options.function_count,
+                                        &symbol_data);
+  BasicCodeModule module(kModuleBase, module_size, "benchmark.so", "",
+                         "benchmark.so",
+                         "0123456789ABCDEF0123456789ABCDEF0", "");
+  printf("%d functions, %zu bytes of symbols, %d addresses\n",
+         options.function_count, symbol_data.size(), options.address_count);
+  BenchmarkLoading(symbol_data, &module, options);
+
+  BasicSourceLineResolver basic_resolver;
+  SourceLineResolverInterface* basic_interface = &basic_resolver;
+  if (!basic_interface->LoadModuleUsingMapBuffer(&module, symbol_data)) {
+    fprintf(stderr, "Could not load the synthetic module\n");
+    return 1;
+  }
+  FastSourceLineResolver fast_resolver;
+  ModuleSerializer serializer;
+  if (!serializer.ConvertOneModule(module.code_file(), &basic_resolver,
+                                   &fast_resolver)) {
+    fprintf(stderr, "Could not serialize the synthetic module\n");
+    return 1;
+  }
+
+  std::vector<StackFrame> frames(options.address_count);
+  std::mt19937_64 random(1);
+  std::uniform_int_distribution<uint64_t> offsets(0, module_size - 1);
+  std::vector<uint64_t> addresses(options.address_count);
+  for (size_t i = 0; i < addresses.size(); ++i)
+    addresses[i] = kModuleBase + offsets(random);
+  std::sort(addresses.begin(), addresses.end());
+  for (size_t i = 0; i < frames.size(); ++i) {
+    frames[i].instruction = addresses[i];
+    frames[i].module = &module;
+  }
+
+  if (!BenchmarkLookups("BasicSourceLineResolver", &basic_resolver, &module,
+                        &frames, options) ||
+      !BenchmarkLookups("FastSourceLineResolver", &fast_resolver, &module,
+                        &frames, options)) {
+    return 1;
+  }
+  return 0;
+}
@@ -43,21 +43,86 @@
 #include "google_breakpad/processor/stack_frame.h"
 #include "google_breakpad/processor/symbol_supplier.h"
 #include "google_breakpad/processor/system_info.h"
+#include "processor/cfi_frame_info.h"
 #include "processor/linked_ptr.h"
 #include "processor/logging.h"
+#include "processor/windows_frame_info.h"
 
 namespace google_breakpad {
 
+namespace {
+
+// Returns true if none of the fields that resolving |frame|'s source line
+// fills in have been set yet, as is the case for every frame the stack
+// walkers produce.
+bool IsUnresolved(const StackFrame& frame) {
+  return frame.function_name.empty() && frame.function_base == 0 &&
+         frame.source_file_name.empty() && frame.source_line == 0 &&
+         frame.source_line_base == 0;
+}
+
+// Where the five-argument FillSourceLineInfo() running on this thread
+// wants the frames inlined at |frame| put.  The five-argument form passes
+// this to the four-argument one here rather than as an argument, so that
+// a subclass overriding only the four-argument virtual is still called.
+struct InlinedFramesRequest {
+  const StackFrame* frame;
+  std::vector<StackFrame*>* inlined_frames;
+};
+thread_local InlinedFramesRequest* inlined_frames_request = NULL;
+
+}  // namespace
+
 StackFrameSymbolizer::StackFrameSymbolizer(
     SymbolSupplier* supplier,
-    SourceLineResolverInterface* resolver) : supplier_(supplier),
-                                             resolver_(resolver) { }
+    SourceLineResolverInterface* resolver)
+    : supplier_(supplier),
+      resolver_(resolver),
+      frame_cache_capacity_(0),
+      frame_cache_hits_(0),
+      frame_cache_misses_(0),
+      frame_cache_evictions_(0) { }
+
+StackFrameSymbolizer::~StackFrameSymbolizer() { }
 
 StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::FillSourceLineInfo(
     const CodeModules* modules,
     const CodeModules* unloaded_modules,
     const SystemInfo* system_info,
     StackFrame* frame) {
+  std::vector<StackFrame*>* inlined_frames = NULL;
+  if (inlined_frames_request && inlined_frames_request->frame == frame) {
+    inlined_frames = inlined_frames_request->inlined_frames;
+    inlined_frames_request = NULL;
+  }
+  return SymbolizeFrame(modules, unloaded_modules, system_info, frame,
+                        inlined_frames);
+}
+
+StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::FillSourceLineInfo(
+    const CodeModules* modules,
+    const CodeModules* unloaded_modules,
+    const SystemInfo* system_info,
+    StackFrame* frame,
+    std::vector<StackFrame*>* inlined_frames) {
+  if (!inlined_frames)
+    return FillSourceLineInfo(modules, unloaded_modules, system_info, frame);
+
+  InlinedFramesRequest request = { frame, inlined_frames };
+  InlinedFramesRequest* outer_request = inlined_frames_request;
+  inlined_frames_request = &request;
+  SymbolizerResult result =
+      FillSourceLineInfo(modules, unloaded_modules, system_info, frame);
+  inlined_frames_request = outer_request;
+  return result;
+}
+
+StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::SymbolizeFrame(
+    const CodeModules* modules,
+    const CodeModules* unloaded_modules,
+    const SystemInfo* system_info,
+    StackFrame* frame,
+    std::vector<StackFrame*>* inlined_frames) {
   assert(frame);
 
   const CodeModule* module = NULL;
@@ -72,55 +137,140 @@ StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::FillSourceLineInfo(
   frame->module = module;
 
   if (!resolver_) return kError;  // no resolver.
-  // If module is known to have missing symbol file, return.
-  if (no_symbol_modules_.find(module->code_file()) !=
-      no_symbol_modules_.end()) {
+
+  // Frames are only cached while they are in their initial state, so
+  // that the cached fields are exactly those the resolver filled in.
+  // When the stack walker symbolizes a frame it walks, asking for the
+  // inlined frames, it goes on to look up the frame's CFI or Windows frame
+  // information; unless those are cached too, the module is loaded for
+  // them even if the frame is found in the cache.  Checks that only need
+  // the source line, such as the stack scanner's of candidate return
+  // addresses, never load the module for a cached frame.
+  FrameCacheKey cache_key;
+  bool cacheable =
+      IsUnresolved(*frame) && GetFrameCacheKey(*frame, &cache_key);
+  if (cacheable) {
+    SymbolizerResult result;
+    bool has_unwind_info;
+    if (LookupCachedFrame(cache_key, frame, inlined_frames, &result,
+                          &has_unwind_info)) {
+      if (inlined_frames && !has_unwind_info) {
+        SymbolizerResult load_result = EnsureModuleLoaded(module, system_info);
+        if (load_result != kNoError)
+          return load_result;
+      }
+      return result;
+    }
+  }
+
+  SymbolizerResult load_result = EnsureModuleLoaded(module, system_info);
+  if (load_result != kNoError)
+    return load_result;
+
+  size_t first_inlined_frame = inlined_frames ? inlined_frames->size() : 0;
+  resolver_->FillSourceLineInfo(frame, inlined_frames);
+  SymbolizerResult result = resolver_->IsModuleCorrupt(frame->module) ?
+      kWarningCorruptSymbols : kNoError;
+  if (cacheable)
+    CacheFrame(cache_key, *frame, inlined_frames, first_inlined_frame, result);
+  return result;
+}
+
+StackFrameSymbolizer::SymbolizerResult
+StackFrameSymbolizer::EnsureModuleLoaded(const CodeModule* module,
+                                         const SystemInfo* system_info) {
+  string key = resolver_->ModuleKey(module);
+  if (IsMissingSymbols(key))
     return kError;
+  if (resolver_->HasModule(module))
+    return kNoError;
+
+  // Another thread may have loaded the module, or found its symbols
+  // missing, while this one waited for the load mutex.
+  const string& code_file = module->code_file();
+  ModuleLoad* load = AcquireModuleLoad(code_file);
+  SymbolizerResult result = kNoError;
+  {
+    std::lock_guard<std::mutex> lock(load->mutex);
+    if (IsMissingSymbols(key))
+      result = kError;
+    else if (!resolver_->HasModule(module))
+      result = LoadModuleSymbols(module, system_info);
   }
+  ReleaseModuleLoad(code_file);
+  return result;
+}
 
-  // If module is already loaded, go ahead to fill source line info and return.
-  if (resolver_->HasModule(frame->module)) {
-    resolver_->FillSourceLineInfo(frame);
-    return resolver_->IsModuleCorrupt(frame->module) ?
-        kWarningCorruptSymbols : kNoError;
+StackFrameSymbolizer::ModuleLoad* StackFrameSymbolizer::AcquireModuleLoad(
+    const string& code_file) {
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  ModuleLoad*& load = module_loads_[code_file];
+  if (!load)
+    load = new ModuleLoad();
+  ++load->users;
+  return load;
+}
+
+void StackFrameSymbolizer::ReleaseModuleLoad(const string& code_file) {
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  ModuleLoadMap::iterator it = module_loads_.find(code_file);
+  if (it != module_loads_.end() && --it->second->users == 0) {
+    delete it->second;
+    module_loads_.erase(it);
   }
+}
 
+bool StackFrameSymbolizer::IsMissingSymbols(const string& key) {
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  return no_symbol_modules_.find(key) != no_symbol_modules_.end();
+}
+
+StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::LoadModuleSymbols(
+    const CodeModule* module,
+    const SystemInfo* system_info) {
   // Module needs to fetch symbol file. First check to see if supplier exists.
   if (!supplier_) {
     return kError;
   }
 
-  // Start fetching symbol from supplier.
+  // Start fetching symbol from supplier.  The symbols are parsed without
+  // holding supplier_mutex_, so other modules can be fetched meanwhile.
   string symbol_file;
   char* symbol_data = NULL;
   size_t symbol_data_size;
-  SymbolSupplier::SymbolResult symbol_result = supplier_->GetCStringSymbolData(
-      module, system_info, &symbol_file, &symbol_data, &symbol_data_size);
+  SymbolSupplier::SymbolResult symbol_result;
+  {
+    std::lock_guard<std::mutex> lock(supplier_mutex_);
+    symbol_result = supplier_->GetCStringSymbolData(
+        module, system_info, &symbol_file, &symbol_data, &symbol_data_size);
+  }
 
   switch (symbol_result) {
     case SymbolSupplier::FOUND: {
       bool load_success = resolver_->LoadModuleUsingMemoryBuffer(
-          frame->module,
+          module,
           symbol_data,
           symbol_data_size);
       if (resolver_->ShouldDeleteMemoryBufferAfterLoadModule()) {
+        std::lock_guard<std::mutex> lock(supplier_mutex_);
         supplier_->FreeSymbolData(module);
       }
 
       if (load_success) {
-        resolver_->FillSourceLineInfo(frame);
-        return resolver_->IsModuleCorrupt(frame->module) ?
-            kWarningCorruptSymbols : kNoError;
+        return kNoError;
       } else {
         BPLOG(ERROR) << "Failed to load symbol file in resolver.";
-        no_symbol_modules_.insert(module->code_file());
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        no_symbol_modules_.insert(resolver_->ModuleKey(module));
         return kError;
       }
     }
 
-    case SymbolSupplier::NOT_FOUND:
-      no_symbol_modules_.insert(module->code_file());
+    case SymbolSupplier::NOT_FOUND: {
+      std::lock_guard<std::mutex> lock(state_mutex_);
+      no_symbol_modules_.insert(resolver_->ModuleKey(module));
       return kError;
+    }
 
     case SymbolSupplier::INTERRUPT:
       return kInterrupt;
@@ -132,14 +282,211 @@ StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::FillSourceLineInfo(
   return kError;
 }
 
+void StackFrameSymbolizer::set_frame_cache_capacity(size_t capacity) {
+  std::lock_guard<std::mutex> lock(frame_cache_mutex_);
+  frame_cache_capacity_ = capacity;
+  EvictFrames();
+}
+
+StackFrameSymbolizer::FrameCacheStats
+StackFrameSymbolizer::frame_cache_stats() {
+  std::lock_guard<std::mutex> lock(frame_cache_mutex_);
+  FrameCacheStats stats;
+  stats.hits = frame_cache_hits_;
+  stats.misses = frame_cache_misses_;
+  stats.evictions = frame_cache_evictions_;
+  stats.entries = frame_cache_.size();
+  return stats;
+}
+
+void StackFrameSymbolizer::CachedFrame::Save(const StackFrame& frame,
+                                             uint64_t module_base) {
+  function_name = frame.function_name;
+  has_function_base = frame.function_base != 0;
+  function_base = frame.function_base - module_base;
+  source_file_name = frame.source_file_name;
+  source_line = frame.source_line;
+  has_source_line_base = frame.source_line_base != 0;
+  source_line_base = frame.source_line_base - module_base;
+}
+
+void StackFrameSymbolizer::CachedFrame::Restore(uint64_t module_base,
+                                                StackFrame* frame) const {
+  frame->function_name = function_name;
+  if (has_function_base)
+    frame->function_base = module_base + function_base;
+  frame->source_file_name = source_file_name;
+  frame->source_line = source_line;
+  if (has_source_line_base)
+    frame->source_line_base = module_base + source_line_base;
+}
+
+StackFrameSymbolizer::FrameCacheEntry::FrameCacheEntry()
+    : has_inlined_frames(false),
+      has_windows_frame_info(false),
+      has_cfi_frame_info(false) { }
+
+StackFrameSymbolizer::FrameCacheEntry::~FrameCacheEntry() { }
+
+bool StackFrameSymbolizer::GetFrameCacheKey(const StackFrame& frame,
+                                            FrameCacheKey* key) {
+  if (!resolver_ || !frame.module || frame.module->debug_identifier().empty())
+    return false;
+  {
+    std::lock_guard<std::mutex> lock(frame_cache_mutex_);
+    if (frame_cache_capacity_ == 0)
+      return false;
+  }
+  *key = FrameCacheKey(resolver_->ModuleKey(frame.module),
+                       frame.instruction - frame.module->base_address());
+  return true;
+}
+
+bool StackFrameSymbolizer::LookupCachedFrame(
+    const FrameCacheKey& key,
+    StackFrame* frame,
+    std::vector<StackFrame*>* inlined_frames,
+    SymbolizerResult* result,
+    bool* has_unwind_info) {
+  std::lock_guard<std::mutex> lock(frame_cache_mutex_);
+  FrameCacheEntryMap::iterator it = frame_cache_.find(key);
+  if (it == frame_cache_.end())
+    return false;
+  const FrameCacheEntry& entry = it->second;
+  // A frame looked up without its inlined frames can't supply them.
+  if (inlined_frames && !entry.has_inlined_frames)
+    return false;
+
+  ++frame_cache_hits_;
+  lru_frames_.splice(lru_frames_.begin(), lru_frames_, entry.lru_position);
+  uint64_t module_base = frame->module->base_address();
+  entry.frame.Restore(module_base, frame);
+  if (inlined_frames) {
+    for (size_t i = 0; i < entry.inlined_frames.size(); ++i) {
+      StackFrame* inlined_frame = new StackFrame();
+      inlined_frame->instruction = frame->instruction;
+      inlined_frame->module = frame->module;
+      inlined_frame->trust = StackFrame::FRAME_TRUST_INLINE;
+      entry.inlined_frames[i].Restore(module_base, inlined_frame);
+      inlined_frames->push_back(inlined_frame);
+    }
+  }
+  *result = entry.result;
+  // The x86 stack walker only asks for CFI when there is no Windows frame
+  // information; the others always ask for CFI.
+  *has_unwind_info = entry.has_cfi_frame_info ||
+      (entry.has_windows_frame_info && entry.windows_frame_info.get());
+  return true;
+}
+
+void StackFrameSymbolizer::CacheFrame(
+    const FrameCacheKey& key,
+    const StackFrame& frame,
+    const std::vector<StackFrame*>* inlined_frames,
+    size_t first_inlined_frame,
+    SymbolizerResult result) {
+  std::lock_guard<std::mutex> lock(frame_cache_mutex_);
+  ++frame_cache_misses_;
+  if (frame_cache_capacity_ == 0)
+    return;
+
+  FrameCacheEntryMap::iterator it = frame_cache_.find(key);
+  if (it == frame_cache_.end()) {
+    it = frame_cache_.insert(std::make_pair(key, FrameCacheEntry())).first;
+    lru_frames_.push_front(key);
+    it->second.lru_position = lru_frames_.begin();
+  } else if (it->second.has_inlined_frames || !inlined_frames) {
+    // Another thread cached the frame meanwhile.
+    return;
+  }
+
+  FrameCacheEntry& entry = it->second;
+  uint64_t module_base = frame.module->base_address();
+  entry.result = result;
+  entry.frame.Save(frame, module_base);
+  entry.has_inlined_frames = inlined_frames != NULL;
+  entry.inlined_frames.clear();
+  if (inlined_frames) {
+    for (size_t i = first_inlined_frame; i < inlined_frames->size(); ++i) {
+      entry.inlined_frames.push_back(CachedFrame());
+      entry.inlined_frames.back().Save(*(*inlined_frames)[i], module_base);
+    }
+  }
+  EvictFrames();
+}
+
+void StackFrameSymbolizer::EvictFrames() {
+  while (frame_cache_.size() > frame_cache_capacity_) {
+    frame_cache_.erase(lru_frames_.back());
+    lru_frames_.pop_back();
+    ++frame_cache_evictions_;
+  }
+}
+
+bool StackFrameSymbolizer::HasImplementation() {
+  return resolver_ && (supplier_ || resolver_->SuppliesOwnSymbols());
+}
+
 WindowsFrameInfo* StackFrameSymbolizer::FindWindowsFrameInfo(
     const StackFrame* frame) {
-  return resolver_ ? resolver_->FindWindowsFrameInfo(frame) : NULL;
+  if (!resolver_)
+    return NULL;
+  FrameCacheKey key;
+  if (!GetFrameCacheKey(*frame, &key))
+    return resolver_->FindWindowsFrameInfo(frame);
+
+  {
+    std::lock_guard<std::mutex> lock(frame_cache_mutex_);
+    FrameCacheEntryMap::iterator it = frame_cache_.find(key);
+    if (it != frame_cache_.end() && it->second.has_windows_frame_info) {
+      const WindowsFrameInfo* frame_info = it->second.windows_frame_info.get();
+      return frame_info ? new WindowsFrameInfo(*frame_info) : NULL;
+    }
+  }
+
+  // A resolver that has unloaded the module finds nothing, which is not
+  // worth keeping.
+  WindowsFrameInfo* frame_info = resolver_->FindWindowsFrameInfo(frame);
+  if (frame_info || resolver_->HasModule(frame->module)) {
+    std::lock_guard<std::mutex> lock(frame_cache_mutex_);
+    FrameCacheEntryMap::iterator it = frame_cache_.find(key);
+    if (it != frame_cache_.end() && !it->second.has_windows_frame_info) {
+      it->second.has_windows_frame_info = true;
+      it->second.windows_frame_info.reset(
+          frame_info ? new WindowsFrameInfo(*frame_info) : NULL);
+    }
+  }
+  return frame_info;
 }
 
 CFIFrameInfo* StackFrameSymbolizer::FindCFIFrameInfo(
     const StackFrame* frame) {
-  return resolver_ ? resolver_->FindCFIFrameInfo(frame) : NULL;
+  if (!resolver_)
+    return NULL;
+  FrameCacheKey key;
+  if (!GetFrameCacheKey(*frame, &key))
+    return resolver_->FindCFIFrameInfo(frame);
+
+  {
+    std::lock_guard<std::mutex> lock(frame_cache_mutex_);
+    FrameCacheEntryMap::iterator it = frame_cache_.find(key);
+    if (it != frame_cache_.end() && it->second.has_cfi_frame_info) {
+      const CFIFrameInfo* frame_info = it->second.cfi_frame_info.get();
+      return frame_info ? new CFIFrameInfo(*frame_info) : NULL;
+    }
+  }
+
+  CFIFrameInfo* frame_info = resolver_->FindCFIFrameInfo(frame);
+  if (frame_info || resolver_->HasModule(frame->module)) {
+    std::lock_guard<std::mutex> lock(frame_cache_mutex_);
+    FrameCacheEntryMap::iterator it = frame_cache_.find(key);
+    if (it != frame_cache_.end() && !it->second.has_cfi_frame_info) {
+      it->second.has_cfi_frame_info = true;
+      it->second.cfi_frame_info.reset(
+          frame_info ? new CFIFrameInfo(*frame_info) : NULL);
+    }
+  }
+  return frame_info;
 }
 
 }  // namespace google_breakpad
@@ -49,6 +49,7 @@
 #include "google_breakpad/processor/process_state.h"
 #include "google_breakpad/processor/source_line_resolver_interface.h"
 #include "google_breakpad/processor/stack_frame_cpu.h"
+#include "processor/json_writer.h"
 #include "processor/logging.h"
 #include "processor/pathname_stripper.h"
 
@@ -61,7 +62,7 @@ using std::vector;
 // Separator character for machine readable output.
 static const char kOutputSeparator = '|';
 
-// PrintRegister prints a register's name and value to stdout.  It will
+// PrintRegister prints a register's name and value to |output|.  It will
 // print four registers on a line.  For the first register in a set,
 // pass 0 for |start_col|.  For registers in a set, pass the most recent
 // return value of PrintRegister.
@@ -69,29 +70,31 @@ static const char kOutputSeparator = '|';
 // of registers is completely printed, regardless of the number of calls
 // to PrintRegister.
 static const int kMaxWidth = 80;  // optimize for an 80-column terminal
-static int PrintRegister(const char *name, uint32_t value, int start_col) {
+static int PrintRegister(const char *name, uint32_t value, int start_col,
+                         FILE *output) {
   char buffer[64];
   snprintf(buffer, sizeof(buffer), " %5s = 0x%08x", name, value);
 
   if (start_col + static_cast<ssize_t>(strlen(buffer)) > kMaxWidth) {
     start_col = 0;
-    printf("\n ");
+    fprintf(output, "\n ");
   }
-  fputs(buffer, stdout);
+  fputs(buffer, output);
 
   return start_col + strlen(buffer);
 }
 
 // PrintRegister64 does the same thing, but for 64-bit registers.
-static int PrintRegister64(const char *name, uint64_t value, int start_col) {
+static int PrintRegister64(const char *name, uint64_t value, int start_col,
+                           FILE *output) {
   char buffer[64];
   snprintf(buffer, sizeof(buffer), " %5s = 0x%016" PRIx64 , name, value);
 
   if (start_col + static_cast<ssize_t>(strlen(buffer)) > kMaxWidth) {
     start_col = 0;
-    printf("\n ");
+    fprintf(output, "\n ");
   }
-  fputs(buffer, stdout);
+  fputs(buffer, output);
 
   return start_col + strlen(buffer);
 }
@@ -111,14 +114,16 @@ static string StripSeparator(const string &original) {
   return result;
 }
 
-// PrintStackContents prints the stack contents of the current frame to stdout.
+// PrintStackContents prints the stack contents of the current frame to
+// |output|.
 static void PrintStackContents(const string &indent,
                                const StackFrame *frame,
                                const StackFrame *prev_frame,
                                const string &cpu,
                                const MemoryRegion *memory,
                                const CodeModules* modules,
-                               SourceLineResolverInterface *resolver) {
+                               SourceLineResolverInterface *resolver,
+                               FILE *output) {
   // Find stack range.
   int word_length = 0;
   uint64_t stack_begin = 0, stack_end = 0;
@@ -167,17 +172,19 @@ static void PrintStackContents(const string &indent,
       stack_end = prev_frame_arm64->context.iregs[31];
     }
   }
-  if (!word_length || !stack_begin || !stack_end)
+  // A ProcessState restored by ProcessStateSerializer has no stack memory.
+  if (!word_length || !stack_begin || !stack_end || !memory)
     return;
 
   // Print stack contents.
-  printf("\n%sStack contents:", indent.c_str());
+  fprintf(output, "\n%sStack contents:", indent.c_str());
   for(uint64_t address = stack_begin; address < stack_end; ) {
     // Print the start address of this row.
     if (word_length == 4)
-      printf("\n%s %08x", indent.c_str(), static_cast<uint32_t>(address));
+      fprintf(output, "\n%s %08x", indent.c_str(),
+              static_cast<uint32_t>(address));
     else
-      printf("\n%s %016" PRIx64, indent.c_str(), address);
+      fprintf(output, "\n%s %016" PRIx64, indent.c_str(), address);
 
     // Print data in hex.
     const int kBytesPerRow = 16;
@@ -186,19 +193,19 @@ static void PrintStackContents(const string &indent,
       uint8_t value = 0;
       if (address < stack_end &&
           memory->GetMemoryAtAddress(address, &value)) {
-        printf(" %02x", value);
+        fprintf(output, " %02x", value);
         data_as_string.push_back(isprint(value) ? value : '.');
       } else {
-        printf("   ");
+        fprintf(output, "   ");
         data_as_string.push_back(' ');
       }
     }
     // Print data as string.
-    printf("  %s", data_as_string.c_str());
+    fprintf(output, "  %s", data_as_string.c_str());
   }
 
   // Try to find instruction pointers from stack.
-  printf("\n%sPossible instruction pointers:\n", indent.c_str());
+  fprintf(output, "\n%sPossible instruction pointers:\n", indent.c_str());
   for (uint64_t address = stack_begin; address < stack_end;
        address += word_length) {
     StackFrame pointee_frame;
@@ -223,24 +230,347 @@ static void PrintStackContents(const string &indent,
     // Print function name.
     if (!pointee_frame.function_name.empty()) {
       if (word_length == 4) {
-        printf("%s *(0x%08x) = 0x%08x", indent.c_str(),
-               static_cast<uint32_t>(address),
-               static_cast<uint32_t>(pointee_frame.instruction));
+        fprintf(output, "%s *(0x%08x) = 0x%08x", indent.c_str(),
+                static_cast<uint32_t>(address),
+                static_cast<uint32_t>(pointee_frame.instruction));
       } else {
-        printf("%s *(0x%016" PRIx64 ") = 0x%016" PRIx64,
-               indent.c_str(), address, pointee_frame.instruction);
+        fprintf(output, "%s *(0x%016" PRIx64 ") = 0x%016" PRIx64,
+                indent.c_str(), address, pointee_frame.instruction);
       }
-      printf(" <%s> [%s : %d + 0x%" PRIx64 "]\n",
-             pointee_frame.function_name.c_str(),
-             PathnameStripper::File(pointee_frame.source_file_name).c_str(),
-             pointee_frame.source_line,
-             pointee_frame.instruction - pointee_frame.source_line_base);
+      fprintf(output, " <%s> [%s : %d + 0x%" PRIx64 "]\n",
+              pointee_frame.function_name.c_str(),
+              PathnameStripper::File(pointee_frame.source_file_name).c_str(),
+              pointee_frame.source_line,
+              pointee_frame.instruction - pointee_frame.source_line_base);
     }
   }
-  printf("\n");
+  fprintf(output, "\n");
 }
 
-// PrintStack prints the call stack in |stack| to stdout, in a reasonably
+// Returns the name of the thread that |stack| belongs to, quoted and
+// preceded by a space for printing after the thread's number, or an empty
+// string if the thread has no name.
+static string ThreadNameSuffix(const CallStack *stack) {
+  if (stack->thread_name().empty())
+    return string();
+  return " \"" + stack->thread_name() + "\"";
+}
+
+// Returns why the walk of |stack| stopped early, for printing, or NULL if
+// it didn't.
+static const char *TruncationReason(const CallStack *stack) {
+  switch (stack->truncation()) {
+    case CALL_STACK_NOT_TRUNCATED:
+      return NULL;
+    case CALL_STACK_DEADLINE_PASSED:
+      return "deadline passed";
+    case CALL_STACK_CANCELLED:
+      return "cancelled";
+  }
+  return NULL;
+}
+
+// A register's name and value, as a frame's context gives it.
+struct FrameRegister {
+  FrameRegister(const char *name, uint64_t value, bool is_64_bit)
+      : name(name), value(value), is_64_bit(is_64_bit) {}
+
+  const char *name;
+  uint64_t value;
+  bool is_64_bit;
+};
+
+static void AddRegister(const char *name, uint32_t value,
+                        vector<FrameRegister> *registers) {
+  registers->push_back(FrameRegister(name, value, false));
+}
+
+static void AddRegister64(const char *name, uint64_t value,
+                          vector<FrameRegister> *registers) {
+  registers->push_back(FrameRegister(name, value, true));
+}
+
+// GetFrameRegisters appends the registers whose values |frame|'s context
+// holds to |registers|, in the order they are printed, if |cpu| is a
+// recognized CPU name.
+static void GetFrameRegisters(const StackFrame *frame,
+                              const string &cpu,
+                              vector<FrameRegister> *registers) {
+  if (frame->trust == StackFrame::FRAME_TRUST_INLINE) {
+    // An inlined frame has no registers of its own.
+  } else if (cpu == "x86") {
+    const StackFrameX86 *frame_x86 =
+      reinterpret_cast<const StackFrameX86*>(frame);
+
+    if (frame_x86->context_validity & StackFrameX86::CONTEXT_VALID_EIP)
+      AddRegister("eip", frame_x86->context.eip, registers);
+    if (frame_x86->context_validity & StackFrameX86::CONTEXT_VALID_ESP)
+      AddRegister("esp", frame_x86->context.esp, registers);
+    if (frame_x86->context_validity & StackFrameX86::CONTEXT_VALID_EBP)
+      AddRegister("ebp", frame_x86->context.ebp, registers);
+    if (frame_x86->context_validity & StackFrameX86::CONTEXT_VALID_EBX)
+      AddRegister("ebx", frame_x86->context.ebx, registers);
+    if (frame_x86->context_validity & StackFrameX86::CONTEXT_VALID_ESI)
+      AddRegister("esi", frame_x86->context.esi, registers);
+    if (frame_x86->context_validity & StackFrameX86::CONTEXT_VALID_EDI)
+      AddRegister("edi", frame_x86->context.edi, registers);
+    if (frame_x86->context_validity == StackFrameX86::CONTEXT_VALID_ALL) {
+      AddRegister("eax", frame_x86->context.eax, registers);
+      AddRegister("ecx", frame_x86->context.ecx, registers);
+      AddRegister("edx", frame_x86->context.edx, registers);
+      AddRegister("efl", frame_x86->context.eflags, registers);
+    }
+  } else if (cpu == "ppc") {
+    const StackFramePPC *frame_ppc =
+      reinterpret_cast<const StackFramePPC*>(frame);
+
+    if (frame_ppc->context_validity & StackFramePPC::CONTEXT_VALID_SRR0)
+      AddRegister("srr0", frame_ppc->context.srr0, registers);
+    if (frame_ppc->context_validity & StackFramePPC::CONTEXT_VALID_GPR1)
+      AddRegister("r1", frame_ppc->context.gpr[1], registers);
+  } else if (cpu == "amd64") {
+    const StackFrameAMD64 *frame_amd64 =
+      reinterpret_cast<const StackFrameAMD64*>(frame);
+
+    if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RAX)
+      AddRegister64("rax", frame_amd64->context.rax, registers);
+    if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RDX)
+      AddRegister64("rdx", frame_amd64->context.rdx, registers);
+    if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RCX)
+      AddRegister64("rcx", frame_amd64->context.rcx, registers);
+    if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RBX)
+      AddRegister64("rbx", frame_amd64->context.rbx, registers);
+    if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RSI)
+      AddRegister64("rsi", frame_amd64->context.rsi, registers);
+    if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RDI)
+      AddRegister64("rdi", frame_amd64->context.rdi, registers);
+    if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RBP)
+      AddRegister64("rbp", frame_amd64->context.rbp, registers);
+    if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RSP)
+      AddRegister64("rsp", frame_amd64->context.rsp, registers);
+    if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R8)
+      AddRegister64("r8", frame_amd64->context.r8, registers);
+    if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R9)
+      AddRegister64("r9", frame_amd64->context.r9, registers);
+    if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R10)
+      AddRegister64("r10", frame_amd64->context.r10, registers);
+    if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R11)
+      AddRegister64("r11", frame_amd64->context.r11, registers);
+    if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R12)
+      AddRegister64("r12", frame_amd64->context.r12, registers);
+    if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R13)
+      AddRegister64("r13", frame_amd64->context.r13, registers);
+    if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R14)
+      AddRegister64("r14", frame_amd64->context.r14, registers);
+    if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R15)
+      AddRegister64("r15", frame_amd64->context.r15, registers);
+    if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RIP)
+      AddRegister64("rip", frame_amd64->context.rip, registers);
+  } else if (cpu == "sparc") {
+    const StackFrameSPARC *frame_sparc =
+      reinterpret_cast<const StackFrameSPARC*>(frame);
+
+    if (frame_sparc->context_validity & StackFrameSPARC::CONTEXT_VALID_SP)
+      AddRegister("sp", frame_sparc->context.g_r[14], registers);
+    if (frame_sparc->context_validity & StackFrameSPARC::CONTEXT_VALID_FP)
+      AddRegister("fp", frame_sparc->context.g_r[30], registers);
+    if (frame_sparc->context_validity & StackFrameSPARC::CONTEXT_VALID_PC)
+      AddRegister("pc", frame_sparc->context.pc, registers);
+  } else if (cpu == "arm") {
+    const StackFrameARM *frame_arm =
+      reinterpret_cast<const StackFrameARM*>(frame);
+
+    // Argument registers (caller-saves), which will likely only be valid
+    // for the youngest frame.
+    if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R0)
+      AddRegister("r0", frame_arm->context.iregs[0], registers);
+    if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R1)
+      AddRegister("r1", frame_arm->context.iregs[1], registers);
+    if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R2)
+      AddRegister("r2", frame_arm->context.iregs[2], registers);
+    if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R3)
+      AddRegister("r3", frame_arm->context.iregs[3], registers);
+
+    // General-purpose callee-saves registers.
+    if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R4)
+      AddRegister("r4", frame_arm->context.iregs[4], registers);
+    if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R5)
+      AddRegister("r5", frame_arm->context.iregs[5], registers);
+    if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R6)
+      AddRegister("r6", frame_arm->context.iregs[6], registers);
+    if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R7)
+      AddRegister("r7", frame_arm->context.iregs[7], registers);
+    if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R8)
+      AddRegister("r8", frame_arm->context.iregs[8], registers);
+    if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R9)
+      AddRegister("r9", frame_arm->context.iregs[9], registers);
+    if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R10)
+      AddRegister("r10", frame_arm->context.iregs[10], registers);
+    if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R12)
+      AddRegister("r12", frame_arm->context.iregs[12], registers);
+
+    // Registers with a dedicated or conventional purpose.
+    if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_FP)
+      AddRegister("fp", frame_arm->context.iregs[11], registers);
+    if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_SP)
+      AddRegister("sp", frame_arm->context.iregs[13], registers);
+    if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_LR)
+      AddRegister("lr", frame_arm->context.iregs[14], registers);
+    if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_PC)
+      AddRegister("pc", frame_arm->context.iregs[15], registers);
+  } else if (cpu == "arm64") {
+    const StackFrameARM64 *frame_arm64 =
+      reinterpret_cast<const StackFrameARM64*>(frame);
+
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X0) {
+      AddRegister64("x0", frame_arm64->context.iregs[0], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X1) {
+      AddRegister64("x1", frame_arm64->context.iregs[1], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X2) {
+      AddRegister64("x2", frame_arm64->context.iregs[2], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X3) {
+      AddRegister64("x3", frame_arm64->context.iregs[3], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X4) {
+      AddRegister64("x4", frame_arm64->context.iregs[4], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X5) {
+      AddRegister64("x5", frame_arm64->context.iregs[5], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X6) {
+      AddRegister64("x6", frame_arm64->context.iregs[6], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X7) {
+      AddRegister64("x7", frame_arm64->context.iregs[7], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X8) {
+      AddRegister64("x8", frame_arm64->context.iregs[8], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X9) {
+      AddRegister64("x9", frame_arm64->context.iregs[9], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X10) {
+      AddRegister64("x10", frame_arm64->context.iregs[10], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X11) {
+      AddRegister64("x11", frame_arm64->context.iregs[11], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X12) {
+      AddRegister64("x12", frame_arm64->context.iregs[12], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X13) {
+      AddRegister64("x13", frame_arm64->context.iregs[13], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X14) {
+      AddRegister64("x14", frame_arm64->context.iregs[14], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X15) {
+      AddRegister64("x15", frame_arm64->context.iregs[15], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X16) {
+      AddRegister64("x16", frame_arm64->context.iregs[16], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X17) {
+      AddRegister64("x17", frame_arm64->context.iregs[17], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X18) {
+      AddRegister64("x18", frame_arm64->context.iregs[18], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X19) {
+      AddRegister64("x19", frame_arm64->context.iregs[19], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X20) {
+      AddRegister64("x20", frame_arm64->context.iregs[20], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X21) {
+      AddRegister64("x21", frame_arm64->context.iregs[21], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X22) {
+      AddRegister64("x22", frame_arm64->context.iregs[22], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X23) {
+      AddRegister64("x23", frame_arm64->context.iregs[23], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X24) {
+      AddRegister64("x24", frame_arm64->context.iregs[24], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X25) {
+      AddRegister64("x25", frame_arm64->context.iregs[25], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X26) {
+      AddRegister64("x26", frame_arm64->context.iregs[26], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X27) {
+      AddRegister64("x27", frame_arm64->context.iregs[27], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X28) {
+      AddRegister64("x28", frame_arm64->context.iregs[28], registers);
+    }
+
+    // Registers with a dedicated or conventional purpose.
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_FP) {
+      AddRegister64("fp", frame_arm64->context.iregs[29], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_LR) {
+      AddRegister64("lr", frame_arm64->context.iregs[30], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_SP) {
+      AddRegister64("sp", frame_arm64->context.iregs[31], registers);
+    }
+    if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_PC) {
+      AddRegister64("pc", frame_arm64->context.iregs[32], registers);
+    }
+  } else if ((cpu == "mips") || (cpu == "mips64")) {
+    const StackFrameMIPS* frame_mips =
+      reinterpret_cast<const StackFrameMIPS*>(frame);
+
+    if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_GP)
+      AddRegister64("gp", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_GP],
+                    registers);
+    if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_SP)
+      AddRegister64("sp", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_SP],
+                    registers);
+    if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_FP)
+      AddRegister64("fp", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_FP],
+                    registers);
+    if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_RA)
+      AddRegister64("ra", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_RA],
+                    registers);
+    if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_PC)
+      AddRegister64("pc", frame_mips->context.epc, registers);
+
+    // Save registers s0-s7
+    if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S0)
+      AddRegister64("s0", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S0],
+                    registers);
+    if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S1)
+      AddRegister64("s1", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S1],
+                    registers);
+    if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S2)
+      AddRegister64("s2", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S2],
+                    registers);
+    if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S3)
+      AddRegister64("s3", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S3],
+                    registers);
+    if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S4)
+      AddRegister64("s4", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S4],
+                    registers);
+    if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S5)
+      AddRegister64("s5", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S5],
+                    registers);
+    if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S6)
+      AddRegister64("s6", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S6],
+                    registers);
+    if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S7)
+      AddRegister64("s7", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S7],
+                    registers);
+  }
+}
+
+// PrintStack prints the call stack in |stack| to |output|, in a reasonably
 // useful form.  Module, function, and source file names are displayed if
 // they are available.  The code offset to the base code address of the
 // source line, function, or module is printed, preferring them in that
@@ -254,422 +584,137 @@ static void PrintStack(const CallStack *stack,
                        bool output_stack_contents,
                        const MemoryRegion* memory,
                        const CodeModules* modules,
-                       SourceLineResolverInterface* resolver) {
+                       SourceLineResolverInterface* resolver,
+                       FILE *output) {
   int frame_count = stack->frames()->size();
   if (frame_count == 0) {
-    printf(" <no frames>\n");
+    fprintf(output, " <no frames>\n");
   }
   for (int frame_index = 0; frame_index < frame_count; ++frame_index) {
     const StackFrame *frame = stack->frames()->at(frame_index);
-    printf("%2d  ", frame_index);
+    fprintf(output, "%2d  ", frame_index);
 
     uint64_t instruction_address = frame->ReturnAddress();
 
     if (frame->module) {
-      printf("%s", PathnameStripper::File(frame->module->code_file()).c_str());
+      fprintf(output, "%s",
+              PathnameStripper::File(frame->module->code_file()).c_str());
       if (!frame->function_name.empty()) {
-        printf("!%s", frame->function_name.c_str());
+        fprintf(output, "!%s", frame->function_name.c_str());
         if (!frame->source_file_name.empty()) {
           string source_file = PathnameStripper::File(frame->source_file_name);
-          printf(" [%s : %d + 0x%" PRIx64 "]",
-                 source_file.c_str(),
-                 frame->source_line,
-                 instruction_address - frame->source_line_base);
+          fprintf(output, " [%s : %d + 0x%" PRIx64 "]",
+                  source_file.c_str(),
+                  frame->source_line,
+                  instruction_address - frame->source_line_base);
         } else {
-          printf(" + 0x%" PRIx64, instruction_address - frame->function_base);
+          fprintf(output, " + 0x%" PRIx64,
+                  instruction_address - frame->function_base);
         }
       } else {
-        printf(" + 0x%" PRIx64,
-               instruction_address - frame->module->base_address());
+        fprintf(output, " + 0x%" PRIx64,
+                instruction_address - frame->module->base_address());
       }
     } else {
-      printf("0x%" PRIx64, instruction_address);
+      fprintf(output, "0x%" PRIx64, instruction_address);
     }
-    printf("\n ");
+    fprintf(output, "\n ");
 
+    vector<FrameRegister> registers;
+    GetFrameRegisters(frame, cpu, &registers);
     int sequence = 0;
-    if (cpu == "x86") {
-      const StackFrameX86 *frame_x86 =
-        reinterpret_cast<const StackFrameX86*>(frame);
-
-      if (frame_x86->context_validity & StackFrameX86::CONTEXT_VALID_EIP)
-        sequence = PrintRegister("eip", frame_x86->context.eip, sequence);
-      if (frame_x86->context_validity & StackFrameX86::CONTEXT_VALID_ESP)
-        sequence = PrintRegister("esp", frame_x86->context.esp, sequence);
-      if (frame_x86->context_validity & StackFrameX86::CONTEXT_VALID_EBP)
-        sequence = PrintRegister("ebp", frame_x86->context.ebp, sequence);
-      if (frame_x86->context_validity & StackFrameX86::CONTEXT_VALID_EBX)
-        sequence = PrintRegister("ebx", frame_x86->context.ebx, sequence);
-      if (frame_x86->context_validity & StackFrameX86::CONTEXT_VALID_ESI)
-        sequence = PrintRegister("esi", frame_x86->context.esi, sequence);
-      if (frame_x86->context_validity & StackFrameX86::CONTEXT_VALID_EDI)
-        sequence = PrintRegister("edi", frame_x86->context.edi, sequence);
-      if (frame_x86->context_validity == StackFrameX86::CONTEXT_VALID_ALL) {
-        sequence = PrintRegister("eax", frame_x86->context.eax, sequence);
-        sequence = PrintRegister("ecx", frame_x86->context.ecx, sequence);
-        sequence = PrintRegister("edx", frame_x86->context.edx, sequence);
-        sequence = PrintRegister("efl", frame_x86->context.eflags, sequence);
-      }
-    } else if (cpu == "ppc") {
-      const StackFramePPC *frame_ppc =
-        reinterpret_cast<const StackFramePPC*>(frame);
-
-      if (frame_ppc->context_validity & StackFramePPC::CONTEXT_VALID_SRR0)
-        sequence = PrintRegister("srr0", frame_ppc->context.srr0, sequence);
-      if (frame_ppc->context_validity & StackFramePPC::CONTEXT_VALID_GPR1)
-        sequence = PrintRegister("r1", frame_ppc->context.gpr[1], sequence);
-    } else if (cpu == "amd64") {
-      const StackFrameAMD64 *frame_amd64 =
-        reinterpret_cast<const StackFrameAMD64*>(frame);
-
-      if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RAX)
-        sequence = PrintRegister64("rax", frame_amd64->context.rax, sequence);
-      if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RDX)
-        sequence = PrintRegister64("rdx", frame_amd64->context.rdx, sequence);
-      if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RCX)
-        sequence = PrintRegister64("rcx", frame_amd64->context.rcx, sequence);
-      if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RBX)
-        sequence = PrintRegister64("rbx", frame_amd64->context.rbx, sequence);
-      if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RSI)
-        sequence = PrintRegister64("rsi", frame_amd64->context.rsi, sequence);
-      if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RDI)
-        sequence = PrintRegister64("rdi", frame_amd64->context.rdi, sequence);
-      if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RBP)
-        sequence = PrintRegister64("rbp", frame_amd64->context.rbp, sequence);
-      if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RSP)
-        sequence = PrintRegister64("rsp", frame_amd64->context.rsp, sequence);
-      if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R8)
-        sequence = PrintRegister64("r8", frame_amd64->context.r8, sequence);
-      if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R9)
-        sequence = PrintRegister64("r9", frame_amd64->context.r9, sequence);
-      if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R10)
-        sequence = PrintRegister64("r10", frame_amd64->context.r10, sequence);
-      if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R11)
-        sequence = PrintRegister64("r11", frame_amd64->context.r11, sequence);
-      if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R12)
-        sequence = PrintRegister64("r12", frame_amd64->context.r12, sequence);
-      if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R13)
-        sequence = PrintRegister64("r13", frame_amd64->context.r13, sequence);
-      if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R14)
-        sequence = PrintRegister64("r14", frame_amd64->context.r14, sequence);
-      if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R15)
-        sequence = PrintRegister64("r15", frame_amd64->context.r15, sequence);
-      if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RIP)
-        sequence = PrintRegister64("rip", frame_amd64->context.rip, sequence);
-    } else if (cpu == "sparc") {
-      const StackFrameSPARC *frame_sparc =
-        reinterpret_cast<const StackFrameSPARC*>(frame);
-
-      if (frame_sparc->context_validity & StackFrameSPARC::CONTEXT_VALID_SP)
-        sequence = PrintRegister("sp", frame_sparc->context.g_r[14], sequence);
-      if (frame_sparc->context_validity & StackFrameSPARC::CONTEXT_VALID_FP)
-        sequence = PrintRegister("fp", frame_sparc->context.g_r[30], sequence);
-      if (frame_sparc->context_validity & StackFrameSPARC::CONTEXT_VALID_PC)
-        sequence = PrintRegister("pc", frame_sparc->context.pc, sequence);
-    } else if (cpu == "arm") {
-      const StackFrameARM *frame_arm =
-        reinterpret_cast<const StackFrameARM*>(frame);
-
-      // Argument registers (caller-saves), which will likely only be valid
-      // for the youngest frame.
-      if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R0)
-        sequence = PrintRegister("r0", frame_arm->context.iregs[0], sequence);
-      if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R1)
-        sequence = PrintRegister("r1", frame_arm->context.iregs[1], sequence);
-      if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R2)
-        sequence = PrintRegister("r2", frame_arm->context.iregs[2], sequence);
-      if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R3)
-        sequence = PrintRegister("r3", frame_arm->context.iregs[3], sequence);
-
-      // General-purpose callee-saves registers.
-      if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R4)
-        sequence = PrintRegister("r4", frame_arm->context.iregs[4], sequence);
-      if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R5)
-        sequence = PrintRegister("r5", frame_arm->context.iregs[5], sequence);
-      if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R6)
-        sequence = PrintRegister("r6", frame_arm->context.iregs[6], sequence);
-      if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R7)
-        sequence = PrintRegister("r7", frame_arm->context.iregs[7], sequence);
-      if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R8)
-        sequence = PrintRegister("r8", frame_arm->context.iregs[8], sequence);
-      if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R9)
-        sequence = PrintRegister("r9", frame_arm->context.iregs[9], sequence);
-      if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R10)
-        sequence = PrintRegister("r10", frame_arm->context.iregs[10], sequence);
-      if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R12)
-        sequence = PrintRegister("r12", frame_arm->context.iregs[12], sequence);
-
-      // Registers with a dedicated or conventional purpose.
-      if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_FP)
-        sequence = PrintRegister("fp", frame_arm->context.iregs[11], sequence);
-      if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_SP)
-        sequence = PrintRegister("sp", frame_arm->context.iregs[13], sequence);
-      if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_LR)
-        sequence = PrintRegister("lr", frame_arm->context.iregs[14], sequence);
-      if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_PC)
-        sequence = PrintRegister("pc", frame_arm->context.iregs[15], sequence);
-    } else if (cpu == "arm64") {
-      const StackFrameARM64 *frame_arm64 =
-        reinterpret_cast<const StackFrameARM64*>(frame);
-
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X0) {
-        sequence =
-            PrintRegister64("x0", frame_arm64->context.iregs[0], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X1) {
-        sequence =
-            PrintRegister64("x1", frame_arm64->context.iregs[1], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X2) {
-        sequence =
-            PrintRegister64("x2", frame_arm64->context.iregs[2], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X3) {
-        sequence =
-            PrintRegister64("x3", frame_arm64->context.iregs[3], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X4) {
-        sequence =
-            PrintRegister64("x4", frame_arm64->context.iregs[4], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X5) {
-        sequence =
-            PrintRegister64("x5", frame_arm64->context.iregs[5], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X6) {
-        sequence =
-            PrintRegister64("x6", frame_arm64->context.iregs[6], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X7) {
-        sequence =
-            PrintRegister64("x7", frame_arm64->context.iregs[7], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X8) {
-        sequence =
-            PrintRegister64("x8", frame_arm64->context.iregs[8], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X9) {
-        sequence =
-            PrintRegister64("x9", frame_arm64->context.iregs[9], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X10) {
-        sequence =
-            PrintRegister64("x10", frame_arm64->context.iregs[10], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X11) {
-        sequence =
-            PrintRegister64("x11", frame_arm64->context.iregs[11], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X12) {
-        sequence =
-            PrintRegister64("x12", frame_arm64->context.iregs[12], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X13) {
-        sequence =
-            PrintRegister64("x13", frame_arm64->context.iregs[13], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X14) {
-        sequence =
-            PrintRegister64("x14", frame_arm64->context.iregs[14], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X15) {
-        sequence =
-            PrintRegister64("x15", frame_arm64->context.iregs[15], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X16) {
-        sequence =
-            PrintRegister64("x16", frame_arm64->context.iregs[16], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X17) {
-        sequence =
-            PrintRegister64("x17", frame_arm64->context.iregs[17], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X18) {
-        sequence =
-            PrintRegister64("x18", frame_arm64->context.iregs[18], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X19) {
-        sequence =
-            PrintRegister64("x19", frame_arm64->context.iregs[19], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X20) {
-        sequence =
-            PrintRegister64("x20", frame_arm64->context.iregs[20], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X21) {
-        sequence =
-            PrintRegister64("x21", frame_arm64->context.iregs[21], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X22) {
-        sequence =
-            PrintRegister64("x22", frame_arm64->context.iregs[22], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X23) {
-        sequence =
-            PrintRegister64("x23", frame_arm64->context.iregs[23], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X24) {
-        sequence =
-            PrintRegister64("x24", frame_arm64->context.iregs[24], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X25) {
-        sequence =
-            PrintRegister64("x25", frame_arm64->context.iregs[25], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X26) {
-        sequence =
-            PrintRegister64("x26", frame_arm64->context.iregs[26], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X27) {
-        sequence =
-            PrintRegister64("x27", frame_arm64->context.iregs[27], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X28) {
-        sequence =
-            PrintRegister64("x28", frame_arm64->context.iregs[28], sequence);
-      }
-
-      // Registers with a dedicated or conventional purpose.
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_FP) {
-        sequence =
-            PrintRegister64("fp", frame_arm64->context.iregs[29], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_LR) {
-        sequence =
-            PrintRegister64("lr", frame_arm64->context.iregs[30], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_SP) {
-        sequence =
-            PrintRegister64("sp", frame_arm64->context.iregs[31], sequence);
-      }
-      if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_PC) {
-        sequence =
-            PrintRegister64("pc", frame_arm64->context.iregs[32], sequence);
+    for (size_t i = 0; i < registers.size(); ++i) {
+      const FrameRegister &frame_register = registers[i];
+      if (frame_register.is_64_bit) {
+        sequence = PrintRegister64(frame_register.name, frame_register.value,
+                                   sequence, output);
+      } else {
+        sequence = PrintRegister(frame_register.name,
+                                 static_cast<uint32_t>(frame_register.value),
+                                 sequence, output);
       }
-    } else if ((cpu == "mips") || (cpu == "mips64")) {
-      const StackFrameMIPS* frame_mips =
-        reinterpret_cast<const StackFrameMIPS*>(frame);
-
-      if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_GP)
-        sequence = PrintRegister64("gp",
-                     frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_GP],
-                     sequence);
-      if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_SP)
-        sequence = PrintRegister64("sp",
-                     frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_SP],
-                     sequence);
-      if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_FP)
-        sequence = PrintRegister64("fp",
-                     frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_FP],
-                     sequence);
-      if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_RA)
-        sequence = PrintRegister64("ra",
-                     frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_RA],
-                     sequence);
-      if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_PC)
-        sequence = PrintRegister64("pc", frame_mips->context.epc, sequence);
-
-      // Save registers s0-s7
-      if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S0)
-        sequence = PrintRegister64("s0",
-                     frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S0],
-                     sequence);
-      if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S1)
-        sequence = PrintRegister64("s1",
-                     frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S1],
-                     sequence);
-      if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S2)
-        sequence = PrintRegister64("s2",
-                     frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S2],
-                     sequence);
-      if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S3)
-        sequence = PrintRegister64("s3",
-                     frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S3],
-                     sequence);
-      if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S4)
-        sequence = PrintRegister64("s4",
-                     frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S4],
-                     sequence);
-      if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S5)
-        sequence = PrintRegister64("s5",
-                     frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S5],
-                     sequence);
-      if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S6)
-        sequence = PrintRegister64("s6",
-                     frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S6],
-                     sequence);
-      if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S7)
-        sequence = PrintRegister64("s7",
-                     frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S7],
-                     sequence);
-    }
-    printf("\n    Found by: %s\n", frame->trust_description().c_str());
-
-    // Print stack contents.
-    if (output_stack_contents && frame_index + 1 < frame_count) {
+    }
+    fprintf(output, "\n    Found by: %s\n", frame->trust_description().c_str());
+
+    // Print stack contents, which lie between this frame and the next
+    // physical one.  Inlined frames share their physical frame's stack.
+    int next_index = frame_index + 1;
+    while (next_index < frame_count &&
+           stack->frames()->at(next_index)->trust ==
+               StackFrame::FRAME_TRUST_INLINE) {
+      ++next_index;
+    }
+    if (output_stack_contents &&
+        frame->trust != StackFrame::FRAME_TRUST_INLINE &&
+        next_index < frame_count) {
       const string indent("    ");
-      PrintStackContents(indent, frame, stack->frames()->at(frame_index + 1),
-                         cpu, memory, modules, resolver);
+      PrintStackContents(indent, frame, stack->frames()->at(next_index),
+                         cpu, memory, modules, resolver, output);
     }
   }
+  const char *truncation_reason = TruncationReason(stack);
+  if (truncation_reason) {
+    fprintf(output, " <stack walk stopped: %s>\n", truncation_reason);
+  }
 }
 
-// PrintStackMachineReadable prints the call stack in |stack| to stdout,
+// PrintStackMachineReadable prints the call stack in |stack| to |output|,
 // in the following machine readable pipe-delimited text format:
 // thread number|frame number|module|function|source file|line|offset
 //
 // Module, function, source file, and source line may all be empty
 // depending on availability.  The code offset follows the same rules as
 // PrintStack above.
-static void PrintStackMachineReadable(int thread_num, const CallStack *stack) {
+static void PrintStackMachineReadable(int thread_num, const CallStack *stack,
+                                      FILE *output) {
   int frame_count = stack->frames()->size();
   for (int frame_index = 0; frame_index < frame_count; ++frame_index) {
     const StackFrame *frame = stack->frames()->at(frame_index);
-    printf("%d%c%d%c", thread_num, kOutputSeparator, frame_index,
-           kOutputSeparator);
+    fprintf(output, "%d%c%d%c", thread_num, kOutputSeparator, frame_index,
+            kOutputSeparator);
 
     uint64_t instruction_address = frame->ReturnAddress();
 
     if (frame->module) {
       assert(!frame->module->code_file().empty());
-      printf("%s", StripSeparator(PathnameStripper::File(
+      fprintf(output, "%s", StripSeparator(PathnameStripper::File(
                      frame->module->code_file())).c_str());
       if (!frame->function_name.empty()) {
-        printf("%c%s", kOutputSeparator,
-               StripSeparator(frame->function_name).c_str());
+        fprintf(output, "%c%s", kOutputSeparator,
+                StripSeparator(frame->function_name).c_str());
         if (!frame->source_file_name.empty()) {
-          printf("%c%s%c%d%c0x%" PRIx64,
-                 kOutputSeparator,
-                 StripSeparator(frame->source_file_name).c_str(),
-                 kOutputSeparator,
-                 frame->source_line,
-                 kOutputSeparator,
-                 instruction_address - frame->source_line_base);
+          fprintf(output, "%c%s%c%d%c0x%" PRIx64,
+                  kOutputSeparator,
+                  StripSeparator(frame->source_file_name).c_str(),
+                  kOutputSeparator,
+                  frame->source_line,
+                  kOutputSeparator,
+                  instruction_address - frame->source_line_base);
         } else {
-          printf("%c%c%c0x%" PRIx64,
-                 kOutputSeparator,  // empty source file
-                 kOutputSeparator,  // empty source line
-                 kOutputSeparator,
-                 instruction_address - frame->function_base);
+          fprintf(output, "%c%c%c0x%" PRIx64,
+                  kOutputSeparator,  // empty source file
+                  kOutputSeparator,  // empty source line
+                  kOutputSeparator,
+                  instruction_address - frame->function_base);
         }
       } else {
-        printf("%c%c%c%c0x%" PRIx64,
-               kOutputSeparator,  // empty function name
-               kOutputSeparator,  // empty source file
-               kOutputSeparator,  // empty source line
-               kOutputSeparator,
-               instruction_address - frame->module->base_address());
+        fprintf(output, "%c%c%c%c0x%" PRIx64,
+                kOutputSeparator,  // empty function name
+                kOutputSeparator,  // empty source file
+                kOutputSeparator,  // empty source line
+                kOutputSeparator,
+                instruction_address - frame->module->base_address());
       }
     } else {
       // the printf before this prints a trailing separator for module name
-      printf("%c%c%c%c0x%" PRIx64,
-             kOutputSeparator,  // empty function name
-             kOutputSeparator,  // empty source file
-             kOutputSeparator,  // empty source line
-             kOutputSeparator,
-             instruction_address);
+      fprintf(output, "%c%c%c%c0x%" PRIx64,
+              kOutputSeparator,  // empty function name
+              kOutputSeparator,  // empty source file
+              kOutputSeparator,  // empty source line
+              kOutputSeparator,
+              instruction_address);
     }
-    printf("\n");
+    fprintf(output, "\n");
   }
 }
 
@@ -690,14 +735,15 @@ static bool ContainsModule(
   return false;
 }
 
-// PrintModule prints a single |module| to stdout.
+// PrintModule prints a single |module| to |output|.
 // |modules_without_symbols| should contain the list of modules that were
 // confirmed to be missing their symbols during the stack walk.
 static void PrintModule(
     const CodeModule *module,
     const vector<const CodeModule*> *modules_without_symbols,
     const vector<const CodeModule*> *modules_with_corrupt_symbols,
-    uint64_t main_address) {
+    uint64_t main_address,
+    FILE *output) {
   string symbol_issues;
   if (ContainsModule(modules_without_symbols, module)) {
     symbol_issues = "  (WARNING: No symbols, " +
@@ -709,26 +755,27 @@ static void PrintModule(
         module->debug_identifier() + ")";
   }
   uint64_t base_address = module->base_address();
-  printf("0x%08" PRIx64 " - 0x%08" PRIx64 "  %s  %s%s%s\n",
-         base_address, base_address + module->size() - 1,
-         PathnameStripper::File(module->code_file()).c_str(),
-         module->version().empty() ? "???" : module->version().c_str(),
-         main_address != 0 && base_address == main_address ? "  (main)" : "",
-         symbol_issues.c_str());
+  fprintf(output, "0x%08" PRIx64 " - 0x%08" PRIx64 "  %s  %s%s%s\n",
+          base_address, base_address + module->size() - 1,
+          PathnameStripper::File(module->code_file()).c_str(),
+          module->version().empty() ? "???" : module->version().c_str(),
+          main_address != 0 && base_address == main_address ? "  (main)" : "",
+          symbol_issues.c_str());
 }
 
-// PrintModules prints the list of all loaded |modules| to stdout.
+// PrintModules prints the list of all loaded |modules| to |output|.
 // |modules_without_symbols| should contain the list of modules that were
 // confirmed to be missing their symbols during the stack walk.
 static void PrintModules(
     const CodeModules *modules,
     const vector<const CodeModule*> *modules_without_symbols,
-    const vector<const CodeModule*> *modules_with_corrupt_symbols) {
+    const vector<const CodeModule*> *modules_with_corrupt_symbols,
+    FILE *output) {
   if (!modules)
     return;
 
-  printf("\n");
-  printf("Loaded modules:\n");
+  fprintf(output, "\n");
+  fprintf(output, "Loaded modules:\n");
 
   uint64_t main_address = 0;
   const CodeModule *main_module = modules->GetMainModule();
@@ -742,7 +789,7 @@ static void PrintModules(
        ++module_sequence) {
     const CodeModule *module = modules->GetModuleAtSequence(module_sequence);
     PrintModule(module, modules_without_symbols, modules_with_corrupt_symbols,
-                main_address);
+                main_address, output);
   }
 }
 
@@ -751,7 +798,8 @@ static void PrintModules(
 // text format:
 // Module|{Module Filename}|{Version}|{Debug Filename}|{Debug Identifier}|
 // {Base Address}|{Max Address}|{Main}
-static void PrintModulesMachineReadable(const CodeModules *modules) {
+static void PrintModulesMachineReadable(const CodeModules *modules,
+                                        FILE *output) {
   if (!modules)
     return;
 
@@ -767,67 +815,180 @@ static void PrintModulesMachineReadable(const CodeModules *modules) {
        ++module_sequence) {
     const CodeModule *module = modules->GetModuleAtSequence(module_sequence);
     uint64_t base_address = module->base_address();
-    printf("Module%c%s%c%s%c%s%c%s%c0x%08" PRIx64 "%c0x%08" PRIx64 "%c%d\n",
-           kOutputSeparator,
-           StripSeparator(PathnameStripper::File(module->code_file())).c_str(),
-           kOutputSeparator, StripSeparator(module->version()).c_str(),
-           kOutputSeparator,
-           StripSeparator(PathnameStripper::File(module->debug_file())).c_str(),
-           kOutputSeparator,
-           StripSeparator(module->debug_identifier()).c_str(),
-           kOutputSeparator, base_address,
-           kOutputSeparator, base_address + module->size() - 1,
-           kOutputSeparator,
-           main_module != NULL && base_address == main_address ? 1 : 0);
+    fprintf(output,
+            "Module%c%s%c%s%c%s%c%s%c0x%08" PRIx64 "%c0x%08" PRIx64 "%c%d\n",
+            kOutputSeparator,
+            StripSeparator(PathnameStripper::File(module->code_file())).c_str(),
+            kOutputSeparator, StripSeparator(module->version()).c_str(),
+            kOutputSeparator,
+            StripSeparator(
+                PathnameStripper::File(module->debug_file())).c_str(),
+            kOutputSeparator,
+            StripSeparator(module->debug_identifier()).c_str(),
+            kOutputSeparator, base_address,
+            kOutputSeparator, base_address + module->size() - 1,
+            kOutputSeparator,
+            main_module != NULL && base_address == main_address ? 1 : 0);
+  }
+}
+
+// FrameTrustName returns the name by which JSON output identifies
+// |trust|.
+static const char *FrameTrustName(StackFrame::FrameTrust trust) {
+  switch (trust) {
+    case StackFrame::FRAME_TRUST_CONTEXT:
+      return "context";
+    case StackFrame::FRAME_TRUST_INLINE:
+      return "inline";
+    case StackFrame::FRAME_TRUST_PREWALKED:
+      return "prewalked";
+    case StackFrame::FRAME_TRUST_CFI:
+      return "cfi";
+    case StackFrame::FRAME_TRUST_CFI_SCAN:
+      return "cfi_scan";
+    case StackFrame::FRAME_TRUST_FP:
+      return "frame_pointer";
+    case StackFrame::FRAME_TRUST_SCAN:
+      return "scan";
+    default:
+      return "none";
+  }
+}
+
+// WriteModuleJSON writes |module| as a JSON object.  The symbol status
+// members are only written if |modules_without_symbols| is not NULL.
+static void WriteModuleJSON(
+    JSONWriter *writer,
+    const CodeModule *module,
+    const vector<const CodeModule*> *modules_without_symbols,
+    const vector<const CodeModule*> *modules_with_corrupt_symbols) {
+  uint64_t base_address = module->base_address();
+  writer->BeginObject();
+  writer->Key("filename");
+  writer->String(PathnameStripper::File(module->code_file()));
+  writer->Key("version");
+  writer->String(module->version());
+  writer->Key("debug_file");
+  writer->String(PathnameStripper::File(module->debug_file()));
+  writer->Key("debug_id");
+  writer->String(module->debug_identifier());
+  writer->Key("code_id");
+  writer->String(module->code_identifier());
+  writer->Key("base_address");
+  writer->Hex(base_address, 8);
+  writer->Key("end_address");
+  writer->Hex(base_address + module->size() - 1, 8);
+  if (modules_without_symbols) {
+    writer->Key("missing_symbols");
+    writer->Bool(ContainsModule(modules_without_symbols, module));
+    writer->Key("corrupt_symbols");
+    writer->Bool(ContainsModule(modules_with_corrupt_symbols, module));
+  }
+  writer->EndObject();
+}
+
+// WriteFrameJSON writes |frame|, the |frame_index|th frame of its stack,
+// as a JSON object.  Members that PrintStack would leave out because the
+// information is unavailable are left out here too, and offsets follow
+// the same rules.  The registers are only written for the first frame.
+static void WriteFrameJSON(JSONWriter *writer,
+                           const StackFrame *frame,
+                           int frame_index,
+                           const string &cpu) {
+  uint64_t instruction_address = frame->ReturnAddress();
+
+  writer->BeginObject();
+  writer->Key("frame");
+  writer->Int(frame_index);
+  writer->Key("offset");
+  writer->Hex(instruction_address, 8);
+  if (frame->module) {
+    writer->Key("module");
+    writer->String(PathnameStripper::File(frame->module->code_file()));
+    writer->Key("module_offset");
+    writer->Hex(instruction_address - frame->module->base_address(), 0);
+    if (!frame->function_name.empty()) {
+      writer->Key("function");
+      writer->String(frame->function_name);
+      writer->Key("function_offset");
+      writer->Hex(instruction_address - frame->function_base, 0);
+      if (!frame->source_file_name.empty()) {
+        writer->Key("file");
+        writer->String(frame->source_file_name);
+        writer->Key("line");
+        writer->Int(frame->source_line);
+        writer->Key("line_offset");
+        writer->Hex(instruction_address - frame->source_line_base, 0);
+      }
+    }
   }
+  writer->Key("trust");
+  writer->String(FrameTrustName(frame->trust));
+
+  if (frame_index == 0) {
+    vector<FrameRegister> registers;
+    GetFrameRegisters(frame, cpu, &registers);
+    writer->Key("registers");
+    writer->BeginObject();
+    for (size_t i = 0; i < registers.size(); ++i) {
+      writer->Key(registers[i].name);
+      writer->Hex(registers[i].value, registers[i].is_64_bit ? 16 : 8);
+    }
+    writer->EndObject();
+  }
+  writer->EndObject();
 }
 
 }  // namespace
 
 void PrintProcessState(const ProcessState& process_state,
                        bool output_stack_contents,
-                       SourceLineResolverInterface* resolver) {
+                       SourceLineResolverInterface* resolver,
+                       FILE* output) {
   // Print OS and CPU information.
   string cpu = process_state.system_info()->cpu;
   string cpu_info = process_state.system_info()->cpu_info;
-  printf("Operating system: %s\n", process_state.system_info()->os.c_str());
-  printf("                  %s\n",
-         process_state.system_info()->os_version.c_str());
-  printf("CPU: %s\n", cpu.c_str());
+  fprintf(output, "Operating system: %s\n",
+          process_state.system_info()->os.c_str());
+  fprintf(output, "                  %s\n",
+          process_state.system_info()->os_version.c_str());
+  fprintf(output, "CPU: %s\n", cpu.c_str());
   if (!cpu_info.empty()) {
     // This field is optional.
-    printf("     %s\n", cpu_info.c_str());
+    fprintf(output, "     %s\n", cpu_info.c_str());
   }
-  printf("     %d CPU%s\n",
-         process_state.system_info()->cpu_count,
-         process_state.system_info()->cpu_count != 1 ? "s" : "");
-  printf("\n");
+  fprintf(output, "     %d CPU%s\n",
+          process_state.system_info()->cpu_count,
+          process_state.system_info()->cpu_count != 1 ? "s" : "");
+  fprintf(output, "\n");
 
   // Print GPU information
   string gl_version = process_state.system_info()->gl_version;
   string gl_vendor = process_state.system_info()->gl_vendor;
   string gl_renderer = process_state.system_info()->gl_renderer;
-  printf("GPU:");
+  fprintf(output, "GPU:");
   if (!gl_version.empty() || !gl_vendor.empty() || !gl_renderer.empty()) {
-    printf(" %s\n", gl_version.c_str());
-    printf("     %s\n", gl_vendor.c_str());
-    printf("     %s\n", gl_renderer.c_str());
+    fprintf(output, " %s\n", gl_version.c_str());
+    fprintf(output, "     %s\n", gl_vendor.c_str());
+    fprintf(output, "     %s\n", gl_renderer.c_str());
   } else {
-    printf(" UNKNOWN\n");
+    fprintf(output, " UNKNOWN\n");
   }
-  printf("\n");
+  fprintf(output, "\n");
 
   // Print crash information.
   if (process_state.crashed()) {
-    printf("Crash reason:  %s\n", process_state.crash_reason().c_str());
-    printf("Crash address: 0x%" PRIx64 "\n", process_state.crash_address());
+    fprintf(output, "Crash reason:  %s\n",
+            process_state.crash_reason().c_str());
+    fprintf(output, "Crash address: 0x%" PRIx64 "\n",
+            process_state.crash_address());
   } else {
-    printf("No crash\n");
+    fprintf(output, "No crash\n");
   }
 
   string assertion = process_state.assertion();
   if (!assertion.empty()) {
-    printf("Assertion: %s\n", assertion.c_str());
+    fprintf(output, "Assertion: %s\n", assertion.c_str());
   }
 
   // Compute process uptime if the process creation and crash times are
@@ -835,25 +996,27 @@ void PrintProcessState(const ProcessState& process_state,
   if (process_state.time_date_stamp() != 0 &&
       process_state.process_create_time() != 0 &&
       process_state.time_date_stamp() >= process_state.process_create_time()) {
-    printf("Process uptime: %d seconds\n",
-           process_state.time_date_stamp() -
+    fprintf(output, "Process uptime: %d seconds\n",
+            process_state.time_date_stamp() -
                process_state.process_create_time());
   } else {
-    printf("Process uptime: not available\n");
+    fprintf(output, "Process uptime: not available\n");
   }
 
   // If the thread that requested the dump is known, print it first.
   int requesting_thread = process_state.requesting_thread();
   if (requesting_thread != -1) {
-    printf("\n");
-    printf("Thread %d (%s)\n",
+    fprintf(output, "\n");
+    fprintf(output, "Thread %d%s (%s)\n",
           requesting_thread,
+          ThreadNameSuffix(
+              process_state.threads()->at(requesting_thread)).c_str(),
           process_state.crashed() ? "crashed" :
                                     "requested dump, did not crash");
     PrintStack(process_state.threads()->at(requesting_thread), cpu,
                output_stack_contents,
                process_state.thread_memory_regions()->at(requesting_thread),
-               process_state.modules(), resolver);
+               process_state.modules(), resolver, output);
   }
 
   // Print all of the threads in the dump.
@@ -861,79 +1024,83 @@ void PrintProcessState(const ProcessState& process_state,
   for (int thread_index = 0; thread_index < thread_count; ++thread_index) {
     if (thread_index != requesting_thread) {
       // Don't print the crash thread again, it was already printed.
-      printf("\n");
-      printf("Thread %d\n", thread_index);
+      fprintf(output, "\n");
+      fprintf(output, "Thread %d%s\n", thread_index,
+              ThreadNameSuffix(
+                 process_state.threads()->at(thread_index)).c_str());
       PrintStack(process_state.threads()->at(thread_index), cpu,
                  output_stack_contents,
                  process_state.thread_memory_regions()->at(thread_index),
-                 process_state.modules(), resolver);
+                 process_state.modules(), resolver, output);
     }
   }
 
   PrintModules(process_state.modules(),
                process_state.modules_without_symbols(),
-               process_state.modules_with_corrupt_symbols());
+               process_state.modules_with_corrupt_symbols(), output);
 }
 
-void PrintProcessStateMachineReadable(const ProcessState& process_state) {
+void PrintProcessStateMachineReadable(const ProcessState& process_state,
+                                      FILE* output) {
   // Print OS and CPU information.
   // OS|{OS Name}|{OS Version}
   // CPU|{CPU Name}|{CPU Info}|{Number of CPUs}
   // GPU|{GPU version}|{GPU vendor}|{GPU renderer}
-  printf("OS%c%s%c%s\n", kOutputSeparator,
-         StripSeparator(process_state.system_info()->os).c_str(),
-         kOutputSeparator,
-         StripSeparator(process_state.system_info()->os_version).c_str());
-  printf("CPU%c%s%c%s%c%d\n", kOutputSeparator,
-         StripSeparator(process_state.system_info()->cpu).c_str(),
-         kOutputSeparator,
-         // this may be empty
-         StripSeparator(process_state.system_info()->cpu_info).c_str(),
-         kOutputSeparator,
-         process_state.system_info()->cpu_count);
-  printf("GPU%c%s%c%s%c%s\n", kOutputSeparator,
-         StripSeparator(process_state.system_info()->gl_version).c_str(),
-         kOutputSeparator,
-         StripSeparator(process_state.system_info()->gl_vendor).c_str(),
-         kOutputSeparator,
-         StripSeparator(process_state.system_info()->gl_renderer).c_str());
+  fprintf(output, "OS%c%s%c%s\n", kOutputSeparator,
+          StripSeparator(process_state.system_info()->os).c_str(),
+          kOutputSeparator,
+          StripSeparator(process_state.system_info()->os_version).c_str());
+  fprintf(output, "CPU%c%s%c%s%c%d\n", kOutputSeparator,
+          StripSeparator(process_state.system_info()->cpu).c_str(),
+          kOutputSeparator,
+          // this may be empty
+          StripSeparator(process_state.system_info()->cpu_info).c_str(),
+          kOutputSeparator,
+          process_state.system_info()->cpu_count);
+  fprintf(output, "GPU%c%s%c%s%c%s\n", kOutputSeparator,
+          StripSeparator(process_state.system_info()->gl_version).c_str(),
+          kOutputSeparator,
+          StripSeparator(process_state.system_info()->gl_vendor).c_str(),
+          kOutputSeparator,
+          StripSeparator(process_state.system_info()->gl_renderer).c_str());
 
   int requesting_thread = process_state.requesting_thread();
 
   // Print crash information.
   // Crash|{Crash Reason}|{Crash Address}|{Crashed Thread}
-  printf("Crash%c", kOutputSeparator);
+  fprintf(output, "Crash%c", kOutputSeparator);
   if (process_state.crashed()) {
-    printf("%s%c0x%" PRIx64 "%c",
-           StripSeparator(process_state.crash_reason()).c_str(),
-           kOutputSeparator, process_state.crash_address(), kOutputSeparator);
+    fprintf(output, "%s%c0x%" PRIx64 "%c",
+            StripSeparator(process_state.crash_reason()).c_str(),
+            kOutputSeparator, process_state.crash_address(), kOutputSeparator);
   } else {
     // print assertion info, if available, in place of crash reason,
     // instead of the unhelpful "No crash"
     string assertion = process_state.assertion();
     if (!assertion.empty()) {
-      printf("%s%c%c", StripSeparator(assertion).c_str(),
-             kOutputSeparator, kOutputSeparator);
+      fprintf(output, "%s%c%c", StripSeparator(assertion).c_str(),
+              kOutputSeparator, kOutputSeparator);
     } else {
-      printf("No crash%c%c", kOutputSeparator, kOutputSeparator);
+      fprintf(output, "No crash%c%c", kOutputSeparator, kOutputSeparator);
     }
   }
 
   if (requesting_thread != -1) {
-    printf("%d\n", requesting_thread);
+    fprintf(output, "%d\n", requesting_thread);
   } else {
-    printf("\n");
+    fprintf(output, "\n");
   }
 
-  PrintModulesMachineReadable(process_state.modules());
+  PrintModulesMachineReadable(process_state.modules(), output);
 
   // blank line to indicate start of threads
-  printf("\n");
+  fprintf(output, "\n");
 
   // If the thread that requested the dump is known, print it first.
   if (requesting_thread != -1) {
     PrintStackMachineReadable(requesting_thread,
-                              process_state.threads()->at(requesting_thread));
+                              process_state.threads()->at(requesting_thread),
+                              output);
   }
 
   // Print all of the threads in the dump.
@@ -942,9 +1109,153 @@ void PrintProcessStateMachineReadable(const ProcessState& process_state) {
     if (thread_index != requesting_thread) {
       // Don't print the crash thread again, it was already printed.
       PrintStackMachineReadable(thread_index,
-                                process_state.threads()->at(thread_index));
+                                process_state.threads()->at(thread_index),
+                                output);
     }
   }
 }
 
+void PrintProcessStateJSON(const ProcessState& process_state, FILE* output) {
+  JSONWriter writer(output);
+  const SystemInfo *system_info = process_state.system_info();
+  const string &cpu = system_info->cpu;
+
+  writer.BeginObject();
+
+  writer.Key("system_info");
+  writer.BeginObject();
+  writer.Key("os");
+  writer.String(system_info->os);
+  writer.Key("os_version");
+  writer.String(system_info->os_version);
+  writer.Key("cpu");
+  writer.String(cpu);
+  writer.Key("cpu_info");
+  writer.String(system_info->cpu_info);
+  writer.Key("cpu_count");
+  writer.Int(system_info->cpu_count);
+  writer.Key("gl_version");
+  writer.String(system_info->gl_version);
+  writer.Key("gl_vendor");
+  writer.String(system_info->gl_vendor);
+  writer.Key("gl_renderer");
+  writer.String(system_info->gl_renderer);
+  writer.EndObject();
+
+  // The crash reason and address are null if the process did not crash,
+  // and crashing_thread is null if the thread that requested the dump is
+  // not known.
+  int requesting_thread = process_state.requesting_thread();
+  writer.Key("crash_info");
+  writer.BeginObject();
+  writer.Key("crashed");
+  writer.Bool(process_state.crashed());
+  writer.Key("reason");
+  if (process_state.crashed())
+    writer.String(process_state.crash_reason());
+  else
+    writer.Null();
+  writer.Key("address");
+  if (process_state.crashed())
+    writer.Hex(process_state.crash_address(), 0);
+  else
+    writer.Null();
+  writer.Key("assertion");
+  writer.String(process_state.assertion());
+  writer.Key("crashing_thread");
+  if (requesting_thread != -1)
+    writer.Int(requesting_thread);
+  else
+    writer.Null();
+  writer.EndObject();
+
+  writer.Key("process_uptime");
+  if (process_state.time_date_stamp() != 0 &&
+      process_state.process_create_time() != 0 &&
+      process_state.time_date_stamp() >= process_state.process_create_time()) {
+    writer.UInt(process_state.time_date_stamp() -
+                process_state.process_create_time());
+  } else {
+    writer.Null();
+  }
+
+  // main_module is the index of the main module in modules, or null.
+  const CodeModules *modules = process_state.modules();
+  writer.Key("main_module");
+  const CodeModule *main_module = modules ? modules->GetMainModule() : NULL;
+  int main_module_index = -1;
+  unsigned int module_count = modules ? modules->module_count() : 0;
+  for (unsigned int module_sequence = 0;
+       main_module && module_sequence < module_count;
+       ++module_sequence) {
+    if (modules->GetModuleAtSequence(module_sequence)->base_address() ==
+        main_module->base_address()) {
+      main_module_index = module_sequence;
+      break;
+    }
+  }
+  if (main_module_index != -1)
+    writer.Int(main_module_index);
+  else
+    writer.Null();
+
+  writer.Key("modules");
+  writer.BeginArray();
+  for (unsigned int module_sequence = 0;
+       module_sequence < module_count;
+       ++module_sequence) {
+    WriteModuleJSON(&writer, modules->GetModuleAtSequence(module_sequence),
+                    process_state.modules_without_symbols(),
+                    process_state.modules_with_corrupt_symbols());
+  }
+  writer.EndArray();
+
+  const CodeModules *unloaded_modules = process_state.unloaded_modules();
+  writer.Key("unloaded_modules");
+  writer.BeginArray();
+  unsigned int unloaded_module_count =
+      unloaded_modules ? unloaded_modules->module_count() : 0;
+  for (unsigned int module_sequence = 0;
+       module_sequence < unloaded_module_count;
+       ++module_sequence) {
+    WriteModuleJSON(&writer,
+                    unloaded_modules->GetModuleAtSequence(module_sequence),
+                    NULL, NULL);
+  }
+  writer.EndArray();
+
+  // Threads are written in the order they appear in the dump; the
+  // crashing thread is identified in crash_info.  A thread whose walk
+  // stopped early has a "truncated" member giving the reason.
+  writer.Key("threads");
+  writer.BeginArray();
+  int thread_count = process_state.threads()->size();
+  for (int thread_index = 0; thread_index < thread_count; ++thread_index) {
+    const CallStack *stack = process_state.threads()->at(thread_index);
+    writer.BeginObject();
+    writer.Key("tid");
+    writer.UInt(stack->tid());
+    writer.Key("thread_name");
+    writer.String(stack->thread_name());
+    const char *truncation_reason = TruncationReason(stack);
+    if (truncation_reason) {
+      writer.Key("truncated");
+      writer.String(truncation_reason);
+    }
+    writer.Key("frames");
+    writer.BeginArray();
+    int frame_count = stack->frames()->size();
+    for (int frame_index = 0; frame_index < frame_count; ++frame_index) {
+      WriteFrameJSON(&writer, stack->frames()->at(frame_index), frame_index,
+                     cpu);
+    }
+    writer.EndArray();
+    writer.EndObject();
+  }
+  writer.EndArray();
+
+  writer.EndObject();
+  fputc('\n', output);
+}
+
 }  // namespace google_breakpad
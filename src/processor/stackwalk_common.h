@@ -34,15 +34,22 @@
 #ifndef PROCESSOR_STACKWALK_COMMON_H__
 #define PROCESSOR_STACKWALK_COMMON_H__
 
+#include <stdio.h>
+
 namespace google_breakpad {
 
 class ProcessState;
 class SourceLineResolverInterface;
 
-void PrintProcessStateMachineReadable(const ProcessState& process_state);
+// Each of these prints the process state to |output|.
+void PrintProcessStateMachineReadable(const ProcessState& process_state,
+                                      FILE* output);
+// Prints the process state as a single JSON object on one line.
+void PrintProcessStateJSON(const ProcessState& process_state, FILE* output);
 void PrintProcessState(const ProcessState& process_state,
                        bool output_stack_contents,
-                       SourceLineResolverInterface* resolver);
+                       SourceLineResolverInterface* resolver,
+                       FILE* output);
 
 }  // namespace google_breakpad
 
@@ -36,12 +36,17 @@
 #include "google_breakpad/processor/stackwalker.h"
 
 #include <assert.h>
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
 
 #include "common/scoped_ptr.h"
 #include "google_breakpad/processor/call_stack.h"
 #include "google_breakpad/processor/code_module.h"
 #include "google_breakpad/processor/code_modules.h"
 #include "google_breakpad/processor/dump_context.h"
+#include "google_breakpad/processor/process_deadline.h"
 #include "google_breakpad/processor/stack_frame.h"
 #include "google_breakpad/processor/stack_frame_symbolizer.h"
 #include "google_breakpad/processor/system_info.h"
@@ -78,7 +83,10 @@ Stackwalker::Stackwalker(const SystemInfo* system_info,
       memory_(memory),
       modules_(modules),
       unloaded_modules_(NULL),
-      frame_symbolizer_(frame_symbolizer) {
+      frame_symbolizer_(frame_symbolizer),
+      module_ranges_built_(false),
+      deadline_(NULL),
+      truncation_(CALL_STACK_NOT_TRUNCATED) {
   assert(frame_symbolizer_);
 }
 
@@ -108,6 +116,22 @@ void InsertSpecialAttentionModule(
   }
 }
 
+// Moves the frames inlined into each frame of |frames| into |frames|,
+// ahead of the frame they were inlined into.  (*inlined_frames)[i] holds
+// the frames inlined into (*frames)[i], innermost first.
+static void InsertInlinedFrames(vector<vector<StackFrame*> >* inlined_frames,
+                                vector<StackFrame*>* frames) {
+  assert(inlined_frames->size() == frames->size());
+  vector<StackFrame*> merged;
+  for (size_t i = 0; i < frames->size(); ++i) {
+    vector<StackFrame*>& inlined = (*inlined_frames)[i];
+    merged.insert(merged.end(), inlined.begin(), inlined.end());
+    merged.push_back((*frames)[i]);
+  }
+  frames->swap(merged);
+  inlined_frames->clear();
+}
+
 bool Stackwalker::Walk(
     CallStack* stack,
     vector<const CodeModule*>* modules_without_symbols,
@@ -130,6 +154,12 @@ bool Stackwalker::Walk(
   // so far, as the caller may have set a limit.
   uint32_t scanned_frames = 0;
 
+  // Frames for calls inlined into each frame of the stack.  They are kept
+  // out of the stack until the walk is done, because the CPU-specific
+  // walkers unwind from the stack's last frame, which must be a physical
+  // one.  inlined_frames[i] belongs to stack->frames_[i].
+  vector<vector<StackFrame*> > inlined_frames;
+
   // Take ownership of the pointer returned by GetContextFrame.
   scoped_ptr<StackFrame> frame(GetContextFrame());
 
@@ -138,14 +168,29 @@ bool Stackwalker::Walk(
     // frame_pointer fields.  The frame structure comes from either the
     // context frame (above) or a caller frame (below).
 
-    // Resolve the module information, if a module map was provided.
+    // Symbolizing the frame may load symbols, which can take a while, so
+    // once time is up, frames are kept without symbols.  The only frame
+    // this applies to is the one found before time ran out: the context
+    // frame, which costs nothing to find, or the caller being unwound.
+    vector<StackFrame*> frame_inlined_frames;
     StackFrameSymbolizer::SymbolizerResult symbolizer_result =
-        frame_symbolizer_->FillSourceLineInfo(modules_, unloaded_modules_,
-                                              system_info_,
-                                              frame.get());
+        StackFrameSymbolizer::kNoError;
+    if (DeadlinePassed()) {
+      FillModule(frame.get());
+    } else {
+      // Resolve the module information, if a module map was provided.
+      symbolizer_result =
+          frame_symbolizer_->FillSourceLineInfo(modules_, unloaded_modules_,
+                                                system_info_,
+                                                frame.get(),
+                                                &frame_inlined_frames);
+    }
     switch (symbolizer_result) {
       case StackFrameSymbolizer::kInterrupt:
         BPLOG(INFO) << "Stack walk is interrupted.";
+        // Hand the inlined frames found so far to the stack, which owns
+        // and deletes them along with the rest.
+        InsertInlinedFrames(&inlined_frames, &stack->frames_);
         return false;
         break;
       case StackFrameSymbolizer::kError:
@@ -177,6 +222,8 @@ bool Stackwalker::Walk(
     // Add the frame to the call stack.  Relinquish the ownership claim
     // over the frame, because the stack now owns it.
     stack->frames_.push_back(frame.release());
+    inlined_frames.push_back(vector<StackFrame*>());
+    inlined_frames.back().swap(frame_inlined_frames);
     if (stack->frames_.size() > max_frames_) {
       // Only emit an error message in the case where the limit
       // reached is the default limit, not set by the user.
@@ -185,14 +232,41 @@ bool Stackwalker::Walk(
       break;
     }
 
+    // Unwinding further may scan the stack and look up CFI, so stop here
+    // if time is up.
+    if (DeadlinePassed())
+      break;
+
     // Get the next frame and take ownership.
     bool stack_scan_allowed = scanned_frames < max_frames_scanned_;
     frame.reset(GetCallerFrame(stack, stack_scan_allowed));
   }
 
+  if (truncation_ != CALL_STACK_NOT_TRUNCATED) {
+    BPLOG(INFO) << "Stack walk stopped after " << stack->frames_.size()
+                << " frames: " << (truncation_ == CALL_STACK_CANCELLED ?
+                                   "cancelled" : "deadline passed");
+  }
+  stack->set_truncation(truncation_);
+  InsertInlinedFrames(&inlined_frames, &stack->frames_);
   return true;
 }
 
+void Stackwalker::FillModule(StackFrame* frame) const {
+  const CodeModule* module = NULL;
+  if (modules_)
+    module = modules_->GetModuleForAddress(frame->instruction);
+  if (!module && unloaded_modules_)
+    module = unloaded_modules_->GetModuleForAddress(frame->instruction);
+  frame->module = module;
+}
+
+bool Stackwalker::DeadlinePassed() {
+  if (deadline_ && truncation_ == CALL_STACK_NOT_TRUNCATED)
+    truncation_ = deadline_->Check();
+  return truncation_ != CALL_STACK_NOT_TRUNCATED;
+}
+
 // static
 Stackwalker* Stackwalker::StackwalkerForCPU(
     const SystemInfo* system_info,
@@ -330,4 +404,78 @@ bool Stackwalker::InstructionAddressSeemsValid(uint64_t address) const {
   return !frame.function_name.empty();
 }
 
+void Stackwalker::MarkWordsInModules(const uint32_t* words, size_t count,
+                                     uint8_t* in_module) {
+  MarkWordsInModulesInternal(words, count, in_module);
+}
+
+void Stackwalker::MarkWordsInModules(const uint64_t* words, size_t count,
+                                     uint8_t* in_module) {
+  MarkWordsInModulesInternal(words, count, in_module);
+}
+
+template<typename T>
+void Stackwalker::MarkWordsInModulesInternal(const T* words, size_t count,
+                                             uint8_t* in_module) {
+  if (!module_ranges_built_) {
+    module_ranges_built_ = true;
+    vector<std::pair<uint64_t, uint64_t> > ranges;
+    unsigned int module_count = modules_ ? modules_->module_count() : 0;
+    for (unsigned int i = 0; i < module_count; ++i) {
+      const CodeModule* module = modules_->GetModuleAtIndex(i);
+      if (!module || module->size() == 0)
+        continue;
+      uint64_t first = module->base_address();
+      uint64_t last = module->size() - 1 >
+                      std::numeric_limits<uint64_t>::max() - first ?
+                      std::numeric_limits<uint64_t>::max() :
+                      first + module->size() - 1;
+      ranges.push_back(std::make_pair(first, last));
+    }
+    std::sort(ranges.begin(), ranges.end());
+    for (size_t i = 0; i < ranges.size(); ++i) {
+      // Merge ranges that overlap or adjoin.
+      if (!module_ranges_.empty() &&
+          (ranges[i].first <= module_ranges_.back().second ||
+           ranges[i].first - 1 == module_ranges_.back().second)) {
+        module_ranges_.back().second =
+            std::max(module_ranges_.back().second, ranges[i].second);
+      } else {
+        module_ranges_.push_back(ranges[i]);
+      }
+    }
+  }
+
+  if (module_ranges_.empty()) {
+    memset(in_module, 0, count);
+    return;
+  }
+
+  // Most stack words are nowhere near any module, so first rule out those
+  // outside the span of all of them.  This loop has no branches, and
+  // compilers vectorize it.
+  uint64_t lowest = module_ranges_.front().first;
+  uint64_t span = module_ranges_.back().second - lowest;
+  size_t candidates = 0;
+  for (size_t i = 0; i < count; ++i) {
+    in_module[i] = static_cast<uint64_t>(words[i]) - lowest <= span;
+    candidates += in_module[i];
+  }
+  if (candidates == 0 || module_ranges_.size() == 1)
+    return;
+
+  // Then look up the rest among the gaps between modules.
+  for (size_t i = 0; i < count; ++i) {
+    if (!in_module[i])
+      continue;
+    // The last range starting at or before the word.
+    vector<std::pair<uint64_t, uint64_t> >::const_iterator range =
+        std::upper_bound(module_ranges_.begin(), module_ranges_.end(),
+                         std::make_pair(static_cast<uint64_t>(words[i]),
+                                        std::numeric_limits<uint64_t>::max()));
+    --range;
+    in_module[i] = words[i] <= range->second;
+  }
+}
+
 }  // namespace google_breakpad
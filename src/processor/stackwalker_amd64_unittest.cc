@@ -42,6 +42,7 @@
 #include "google_breakpad/processor/basic_source_line_resolver.h"
 #include "google_breakpad/processor/call_stack.h"
 #include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/process_deadline.h"
 #include "google_breakpad/processor/source_line_resolver_interface.h"
 #include "google_breakpad/processor/stack_frame_cpu.h"
 #include "processor/stackwalker_unittest_utils.h"
@@ -50,11 +51,15 @@
 using google_breakpad::BasicSourceLineResolver;
 using google_breakpad::CallStack;
 using google_breakpad::CodeModule;
+using google_breakpad::CodeModules;
+using google_breakpad::ProcessDeadline;
+using google_breakpad::SourceLineResolverInterface;
 using google_breakpad::StackFrameSymbolizer;
 using google_breakpad::StackFrame;
 using google_breakpad::StackFrameAMD64;
 using google_breakpad::Stackwalker;
 using google_breakpad::StackwalkerAMD64;
+using google_breakpad::SymbolSupplier;
 using google_breakpad::SystemInfo;
 using google_breakpad::test_assembler::kLittleEndian;
 using google_breakpad::test_assembler::Label;
@@ -303,6 +308,85 @@ TEST_F(GetCallerFrame, ScanWithoutSymbols) {
   EXPECT_EQ(frame2_sp.Value(), frame2->context.rsp);
 }
 
+TEST_F(GetCallerFrame, ScanPastManyWords) {
+  // Stack scanning reads the stack many words at a time.  A return address
+  // far up the stack, past many words that are not in any module, whether
+  // outside all of them or between them, must still be found.
+  stack_section.start() = 0x8000000080000000ULL;
+  uint64_t return_address = 0x00007500b0000100ULL;
+  Label frame1_sp;
+  for (int i = 0; i < 33; ++i) {
+    stack_section
+      .D64(0x0000000000001234ULL)       // below every module
+      .D64(0x00007400d0000000ULL)       // between the modules
+      .D64(0x00007400c0010000ULL);      // just past the end of module1
+  }
+  stack_section
+    .D64(return_address)                // actual return address
+    // frame 1
+    .Mark(&frame1_sp)
+    .Append(32, 0);                     // end of stack
+
+  RegionFromSection();
+
+  raw_context.rip = 0x00007400c0000200ULL;
+  raw_context.rbp = 0;
+  raw_context.rsp = stack_section.start().Value();
+
+  StackFrameSymbolizer frame_symbolizer(&supplier, &resolver);
+  StackwalkerAMD64 walker(&system_info, &raw_context, &stack_region, &modules,
+                          &frame_symbolizer);
+  vector<const CodeModule*> modules_without_symbols;
+  vector<const CodeModule*> modules_with_corrupt_symbols;
+  ASSERT_TRUE(walker.Walk(&call_stack, &modules_without_symbols,
+                          &modules_with_corrupt_symbols));
+  frames = call_stack.frames();
+  ASSERT_EQ(2U, frames->size());
+
+  StackFrameAMD64 *frame1 = static_cast<StackFrameAMD64 *>(frames->at(1));
+  EXPECT_EQ(StackFrame::FRAME_TRUST_SCAN, frame1->trust);
+  EXPECT_EQ(return_address, frame1->context.rip);
+  EXPECT_EQ(frame1_sp.Value(), frame1->context.rsp);
+}
+
+TEST_F(GetCallerFrame, DeadlinePassed) {
+  // Once the deadline has passed, the walk keeps the context frame, which
+  // costs nothing to find, but neither symbolizes it nor unwinds further.
+  stack_section.start() = 0x8000000080000000ULL;
+  stack_section
+    .D64(0x00007500b0000100ULL)         // a return address to scan for
+    .Append(32, 0);                     // end of stack
+  RegionFromSection();
+
+  raw_context.rip = 0x00007400c0000200ULL;
+  raw_context.rbp = 0;
+  raw_context.rsp = stack_section.start().Value();
+
+  SetModuleSymbols(&module1, "FUNC 100 400 10 enchiridion\n");
+  EXPECT_CALL(supplier, GetCStringSymbolData(_, _, _, _, _)).Times(0);
+
+  ProcessDeadline deadline(ProcessDeadline::Clock::duration::zero());
+  StackFrameSymbolizer frame_symbolizer(&supplier, &resolver);
+  StackwalkerAMD64 walker(&system_info, &raw_context, &stack_region, &modules,
+                          &frame_symbolizer);
+  walker.set_deadline(&deadline);
+  vector<const CodeModule*> modules_without_symbols;
+  vector<const CodeModule*> modules_with_corrupt_symbols;
+  ASSERT_TRUE(walker.Walk(&call_stack, &modules_without_symbols,
+                          &modules_with_corrupt_symbols));
+  EXPECT_EQ(google_breakpad::CALL_STACK_DEADLINE_PASSED,
+            call_stack.truncation());
+  EXPECT_EQ(0U, modules_without_symbols.size());
+  frames = call_stack.frames();
+  ASSERT_EQ(1U, frames->size());
+
+  StackFrameAMD64 *frame0 = static_cast<StackFrameAMD64 *>(frames->at(0));
+  EXPECT_EQ(StackFrame::FRAME_TRUST_CONTEXT, frame0->trust);
+  EXPECT_EQ(0, memcmp(&raw_context, &frame0->context, sizeof(raw_context)));
+  EXPECT_EQ(&module1, frame0->module);
+  EXPECT_EQ("", frame0->function_name);
+}
+
 TEST_F(GetCallerFrame, ScanWithFunctionSymbols) {
   // During stack scanning, if a potential return address
   // is located within a loaded module that has symbols,
@@ -738,6 +822,144 @@ TEST_F(GetCallerFrame, CallerPushedRBP) {
   EXPECT_EQ(0x00007500b0000100ULL, frame1->function_base);
 }
 
+TEST_F(GetCallerFrame, InlinedFrames) {
+  // Frames for inlined calls precede the frame they were inlined into, and
+  // don't disturb unwinding from it.
+  stack_section.start() = 0x8000000080000000ULL;
+  uint64_t return_address = 0x00007500b0000110ULL;
+  Label frame0_rbp, frame1_sp, frame1_rbp;
+
+  stack_section
+    // frame 0
+    .Append(16, 0)                      // space
+    .Mark(&frame0_rbp)
+    .D64(frame1_rbp)                    // caller-pushed %rbp
+    .D64(return_address)                // actual return address
+    // frame 1
+    .Mark(&frame1_sp)
+    .Append(32, 0)                      // body of frame1
+    .Mark(&frame1_rbp)                  // end of stack
+    .D64(0);
+  RegionFromSection();
+
+  raw_context.rip = 0x00007400c0000200ULL;
+  raw_context.rbp = frame0_rbp.Value();
+  raw_context.rsp = stack_section.start().Value();
+
+  SetModuleSymbols(&module1,
+                   "FILE 0 sasquatch.cc\n"
+                   "INLINE_ORIGIN 0 bigfoot\n"
+                   "FUNC 100 400 10 sasquatch\n"
+                   "INLINE 0 7 0 0 1f0 20\n"
+                   "100 400 3 0\n");
+  SetModuleSymbols(&module2,
+                   "INLINE_ORIGIN 0 yowie\n"
+                   "FUNC 100 400 10 yeti\n"
+                   "INLINE 0 9 -1 0 100 20\n");
+
+  StackFrameSymbolizer frame_symbolizer(&supplier, &resolver);
+  StackwalkerAMD64 walker(&system_info, &raw_context, &stack_region, &modules,
+                          &frame_symbolizer);
+  vector<const CodeModule*> modules_without_symbols;
+  vector<const CodeModule*> modules_with_corrupt_symbols;
+  ASSERT_TRUE(walker.Walk(&call_stack, &modules_without_symbols,
+                          &modules_with_corrupt_symbols));
+  frames = call_stack.frames();
+  ASSERT_EQ(4U, frames->size());
+
+  EXPECT_EQ(StackFrame::FRAME_TRUST_INLINE, frames->at(0)->trust);
+  EXPECT_EQ("bigfoot", frames->at(0)->function_name);
+  EXPECT_EQ(0x00007400c00001f0ULL, frames->at(0)->function_base);
+  EXPECT_EQ(3, frames->at(0)->source_line);
+
+  StackFrameAMD64 *frame1 = static_cast<StackFrameAMD64 *>(frames->at(1));
+  EXPECT_EQ(StackFrame::FRAME_TRUST_CONTEXT, frame1->trust);
+  EXPECT_EQ("sasquatch", frame1->function_name);
+  EXPECT_EQ("sasquatch.cc", frame1->source_file_name);
+  EXPECT_EQ(7, frame1->source_line);
+
+  EXPECT_EQ(StackFrame::FRAME_TRUST_INLINE, frames->at(2)->trust);
+  EXPECT_EQ("yowie", frames->at(2)->function_name);
+
+  StackFrameAMD64 *frame3 = static_cast<StackFrameAMD64 *>(frames->at(3));
+  EXPECT_EQ(StackFrame::FRAME_TRUST_FP, frame3->trust);
+  EXPECT_EQ(return_address, frame3->context.rip);
+  EXPECT_EQ(frame1_sp.Value(), frame3->context.rsp);
+  EXPECT_EQ("yeti", frame3->function_name);
+  EXPECT_EQ(9, frame3->source_line);
+}
+
+// A symbolizer written against the four-argument FillSourceLineInfo(),
+// which counts the frames it is asked to fill in.
+class CountingFrameSymbolizer: public StackFrameSymbolizer {
+ public:
+  CountingFrameSymbolizer(SymbolSupplier* supplier,
+                          SourceLineResolverInterface* resolver)
+      : StackFrameSymbolizer(supplier, resolver), frames_filled(0) { }
+
+  using StackFrameSymbolizer::FillSourceLineInfo;
+  virtual SymbolizerResult FillSourceLineInfo(const CodeModules* modules,
+                                              const CodeModules* unloaded,
+                                              const SystemInfo* system_info,
+                                              StackFrame* stack_frame) {
+    ++frames_filled;
+    return StackFrameSymbolizer::FillSourceLineInfo(modules, unloaded,
+                                                    system_info, stack_frame);
+  }
+
+  int frames_filled;
+};
+
+TEST_F(GetCallerFrame, FourArgumentSymbolizerOverride) {
+  // The stack walker reaches a subclass that overrides only the
+  // four-argument FillSourceLineInfo(), and inlined frames are still
+  // found through it.
+  stack_section.start() = 0x8000000080000000ULL;
+  uint64_t return_address = 0x00007500b0000110ULL;
+  Label frame0_rbp, frame1_rbp;
+
+  stack_section
+    // frame 0
+    .Append(16, 0)                      // space
+    .Mark(&frame0_rbp)
+    .D64(frame1_rbp)                    // caller-pushed %rbp
+    .D64(return_address)                // actual return address
+    // frame 1
+    .Append(32, 0)                      // body of frame1
+    .Mark(&frame1_rbp)                  // end of stack
+    .D64(0);
+  RegionFromSection();
+
+  raw_context.rip = 0x00007400c0000200ULL;
+  raw_context.rbp = frame0_rbp.Value();
+  raw_context.rsp = stack_section.start().Value();
+
+  SetModuleSymbols(&module1,
+                   "INLINE_ORIGIN 0 bigfoot\n"
+                   "FUNC 100 400 10 sasquatch\n"
+                   "INLINE 0 7 -1 0 1f0 20\n");
+  SetModuleSymbols(&module2,
+                   "FUNC 100 400 10 yeti\n");
+
+  CountingFrameSymbolizer frame_symbolizer(&supplier, &resolver);
+  StackwalkerAMD64 walker(&system_info, &raw_context, &stack_region, &modules,
+                          &frame_symbolizer);
+  vector<const CodeModule*> modules_without_symbols;
+  vector<const CodeModule*> modules_with_corrupt_symbols;
+  ASSERT_TRUE(walker.Walk(&call_stack, &modules_without_symbols,
+                          &modules_with_corrupt_symbols));
+  frames = call_stack.frames();
+  ASSERT_EQ(3U, frames->size());
+  EXPECT_LE(2, frame_symbolizer.frames_filled);
+
+  EXPECT_EQ(StackFrame::FRAME_TRUST_INLINE, frames->at(0)->trust);
+  EXPECT_EQ("bigfoot", frames->at(0)->function_name);
+  EXPECT_EQ("sasquatch", frames->at(1)->function_name);
+  EXPECT_EQ(7, frames->at(1)->source_line);
+  EXPECT_EQ(StackFrame::FRAME_TRUST_FP, frames->at(2)->trust);
+  EXPECT_EQ("yeti", frames->at(2)->function_name);
+}
+
 struct CFIFixture: public StackwalkerAMD64Fixture {
   CFIFixture() {
     // Provide a bunch of STACK CFI records; we'll walk to the caller
@@ -0,0 +1,81 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// sym2fast.cc: Convert a string format symbol file into a fast symbol file,
+// which FastSourceLineResolver maps into memory and uses without parsing.
+//
+// See module_serializer.h and fast_source_line_resolver_types.h for the
+// format of fast symbol files.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "processor/logging.h"
+#include "processor/module_serializer.h"
+
+namespace {
+
+using google_breakpad::ModuleSerializer;
+
+static void Usage(int argc, char *argv[], bool error) {
+  fprintf(error ? stderr : stdout,
+          "Usage: %s <symbol-file> <fast-symbol-file>\n"
+          "Convert a symbol file into a fast symbol file.\n",
+          argv[0]);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  BPLOG_INIT(&argc, &argv);
+
+  int ch;
+  while ((ch = getopt(argc, argv, "h")) != -1) {
+    switch (ch) {
+      case 'h':
+        Usage(argc, argv, false);
+        exit(0);
+
+      default:
+        Usage(argc, argv, true);
+        exit(1);
+    }
+  }
+
+  if ((argc - optind) != 2) {
+    Usage(argc, argv, true);
+    return 1;
+  }
+
+  ModuleSerializer serializer;
+  return serializer.ConvertSymbolFileToFastSymbolFile(argv[optind],
+                                                      argv[optind + 1]) ?
+      0 : 1;
+}
@@ -0,0 +1,154 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// symbolizer_protocol.cc: encoding and framing of the messages
+// breakpad_symbolizer and RemoteSourceLineResolver exchange.
+//
+// See symbolizer_protocol.h for documentation.
+
+#include "processor/symbolizer_protocol.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "processor/basic_code_module.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace google_breakpad {
+
+namespace {
+
+// Sends all SIZE bytes at DATA on FD.  A peer that has gone away makes
+// this fail rather than raise SIGPIPE.
+bool SendAll(int fd, const char *data, size_t size) {
+  while (size > 0) {
+    ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    data += sent;
+    size -= sent;
+  }
+  return true;
+}
+
+// Receives exactly SIZE bytes from FD into DATA.
+bool ReceiveAll(int fd, char *data, size_t size) {
+  while (size > 0) {
+    ssize_t received = read(fd, data, size);
+    if (received < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    if (received == 0)
+      return false;
+    data += received;
+    size -= received;
+  }
+  return true;
+}
+
+}  // namespace
+
+void SymbolizerMessageWriter::WriteString(const string &value) {
+  WriteUInt32(value.size());
+  message_.append(value);
+}
+
+void SymbolizerMessageWriter::WriteModule(const CodeModule &module) {
+  WriteString(module.code_file());
+  WriteString(module.code_identifier());
+  WriteString(module.debug_file());
+  WriteString(module.debug_identifier());
+  WriteString(module.version());
+}
+
+bool SymbolizerMessageReader::ReadString(string *value) {
+  size_t start = position_;
+  uint32_t size;
+  if (!ReadUInt32(&size))
+    return false;
+  if (size > message_.size() - position_) {
+    position_ = start;
+    return false;
+  }
+  value->assign(message_, position_, size);
+  position_ += size;
+  return true;
+}
+
+BasicCodeModule *SymbolizerMessageReader::ReadModule() {
+  string code_file, code_identifier, debug_file, debug_identifier, version;
+  if (!ReadString(&code_file) ||
+      !ReadString(&code_identifier) ||
+      !ReadString(&debug_file) ||
+      !ReadString(&debug_identifier) ||
+      !ReadString(&version)) {
+    return NULL;
+  }
+  return new BasicCodeModule(0, 0, code_file, code_identifier,
+                             debug_file, debug_identifier, version);
+}
+
+bool SymbolizerMessageReader::Take(void *value, size_t size) {
+  if (size > message_.size() - position_)
+    return false;
+  memcpy(value, message_.data() + position_, size);
+  position_ += size;
+  return true;
+}
+
+bool WriteSymbolizerMessage(int fd, const string &message) {
+  if (message.size() > kSymbolizerMaxMessageSize)
+    return false;
+  uint32_t size = message.size();
+  return SendAll(fd, reinterpret_cast<const char*>(&size), sizeof(size)) &&
+         SendAll(fd, message.data(), message.size());
+}
+
+bool ReadSymbolizerMessage(int fd, string *message) {
+  uint32_t size;
+  if (!ReceiveAll(fd, reinterpret_cast<char*>(&size), sizeof(size)) ||
+      size > kSymbolizerMaxMessageSize) {
+    return false;
+  }
+  message->resize(size);
+  return size == 0 || ReceiveAll(fd, &(*message)[0], size);
+}
+
+}  // namespace google_breakpad
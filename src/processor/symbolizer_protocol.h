@@ -0,0 +1,174 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// symbolizer_protocol.h: the messages breakpad_symbolizer and
+// RemoteSourceLineResolver exchange.
+//
+// A client connects to the server's Unix domain socket and sends requests,
+// each of which the server answers with one response, in order.  Every
+// message is a uint32 byte count followed by that many bytes.  Integers
+// are in the host's byte order, since both ends run on the same machine;
+// a string is a uint32 length followed by its bytes.
+//
+// A request is a uint8 SymbolizerOperation followed by the module it is
+// about, as five strings: code file, code identifier, debug file, debug
+// identifier and version.  Addresses are offsets from the module's base
+// address, and so are the addresses in responses.
+//
+// A response begins with a uint8 SymbolizerLoadStatus and a uint8 that is
+// nonzero if the module's symbols are corrupt.  Unless the status is
+// SYMBOLIZER_LOADED, nothing follows.  Otherwise what follows depends on the
+// operation:
+//
+//   SYMBOLIZER_LOAD_MODULE: nothing; the request has nothing more either.
+//
+//   SYMBOLIZER_LOOKUP_ADDRESSES: the request continues with a uint32 count
+//   and that many uint64 offsets.  The response holds a uint32 count of the
+//   results that follow, for the first that many offsets, as many as fit
+//   in a message; the client asks again for the rest.  Each result is a
+//   uint8 of SymbolizerResultFlags; the function name and uint64 function
+//   base if SYMBOLIZER_HAS_FUNCTION is set; the source file name, uint32
+//   line and uint64 line base if SYMBOLIZER_HAS_LINE is set; and a uint32
+//   count of inlined frames, innermost first, each as function name,
+//   function base, source file name, line and line base.  A base of
+//   kSymbolizerNoAddress in an inlined frame means the field was not set.
+//
+//   SYMBOLIZER_FIND_CFI_FRAME_INFO: the request continues with a uint64
+//   offset.  The response holds a uint8 that is nonzero if CFI covers it,
+//   followed in that case by the rules, as CFIFrameInfo::Serialize() writes
+//   them.
+//
+//   SYMBOLIZER_FIND_WINDOWS_FRAME_INFO: the request continues with a uint64
+//   offset.  The response holds a uint8 that is nonzero if Windows frame
+//   information covers it, followed in that case by the WindowsFrameInfo's
+//   type, valid, prolog_size, epilog_size, parameter_size,
+//   saved_register_size, local_size and max_stack_size as uint32s, its
+//   allocates_base_pointer as a uint8 and its program_string.
+
+#ifndef PROCESSOR_SYMBOLIZER_PROTOCOL_H__
+#define PROCESSOR_SYMBOLIZER_PROTOCOL_H__
+
+#include <string>
+
+#include "common/using_std_string.h"
+#include "google_breakpad/common/breakpad_types.h"
+#include "google_breakpad/processor/code_module.h"
+
+namespace google_breakpad {
+
+class BasicCodeModule;
+
+enum SymbolizerOperation {
+  SYMBOLIZER_LOAD_MODULE = 1,
+  SYMBOLIZER_LOOKUP_ADDRESSES = 2,
+  SYMBOLIZER_FIND_CFI_FRAME_INFO = 3,
+  SYMBOLIZER_FIND_WINDOWS_FRAME_INFO = 4
+};
+
+enum SymbolizerLoadStatus {
+  SYMBOLIZER_LOADED = 0,
+  // The server has no symbols for the module, or could not load them.
+  SYMBOLIZER_NOT_FOUND = 1,
+  // The server's symbol supplier was interrupted; a retry may succeed.
+  SYMBOLIZER_INTERRUPTED = 2
+};
+
+enum SymbolizerResultFlags {
+  SYMBOLIZER_HAS_FUNCTION = 1 << 0,
+  SYMBOLIZER_HAS_LINE = 1 << 1
+};
+
+static const uint64_t kSymbolizerNoAddress = ~static_cast<uint64_t>(0);
+
+// The largest message either end accepts, and so the largest either
+// sends.
+static const uint32_t kSymbolizerMaxMessageSize = 64 * 1024 * 1024;
+
+// Builds up the body of a message.
+class SymbolizerMessageWriter {
+ public:
+  void WriteUInt8(uint8_t value) { Append(&value, sizeof(value)); }
+  void WriteUInt32(uint32_t value) { Append(&value, sizeof(value)); }
+  void WriteUInt64(uint64_t value) { Append(&value, sizeof(value)); }
+  void WriteString(const string &value);
+  void WriteModule(const CodeModule &module);
+  // Appends what another writer built up.
+  void WriteMessage(const SymbolizerMessageWriter &other) {
+    message_.append(other.message_);
+  }
+
+  const string &message() const { return message_; }
+
+ private:
+  void Append(const void *data, size_t size) {
+    message_.append(static_cast<const char*>(data), size);
+  }
+
+  string message_;
+};
+
+// Takes apart the body of a message.  Each Read method returns false,
+// leaving its argument unchanged, if the rest of the message is too short
+// to hold the value.
+class SymbolizerMessageReader {
+ public:
+  explicit SymbolizerMessageReader(const string &message)
+      : message_(message), position_(0) { }
+
+  bool ReadUInt8(uint8_t *value) { return Take(value, sizeof(*value)); }
+  bool ReadUInt32(uint32_t *value) { return Take(value, sizeof(*value)); }
+  bool ReadUInt64(uint64_t *value) { return Take(value, sizeof(*value)); }
+  bool ReadString(string *value);
+
+  // Reads a module as SymbolizerMessageWriter::WriteModule writes it,
+  // returning a new BasicCodeModule loaded at address zero, owned by the
+  // caller, or NULL if the message is too short.
+  BasicCodeModule *ReadModule();
+
+  // Returns true if every byte of the message has been read.
+  bool AtEnd() const { return position_ == message_.size(); }
+
+ private:
+  bool Take(void *value, size_t size);
+
+  const string &message_;
+  size_t position_;
+};
+
+// Sends MESSAGE on the connected socket FD, returning false on error.
+bool WriteSymbolizerMessage(int fd, const string &message);
+
+// Receives a message from the connected socket FD into MESSAGE, returning
+// false on error, at end of file, or if the message is larger than
+// kSymbolizerMaxMessageSize.
+bool ReadSymbolizerMessage(int fd, string *message);
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_SYMBOLIZER_PROTOCOL_H__
@@ -0,0 +1,412 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// symbolizer_server.cc: SymbolizerServer answers the requests of
+// RemoteSourceLineResolver clients.
+//
+// See symbolizer_server.h for documentation.
+
+#include "processor/symbolizer_server.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "common/scoped_ptr.h"
+#include "google_breakpad/processor/source_line_resolver_interface.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "google_breakpad/processor/symbol_supplier.h"
+#include "processor/basic_code_module.h"
+#include "processor/cfi_frame_info.h"
+#include "processor/logging.h"
+#include "processor/windows_frame_info.h"
+
+namespace google_breakpad {
+
+namespace {
+
+// The number of modules remembered as missing beyond which expired entries
+// are dropped.
+const size_t kMaxMissingSymbols = 1 << 16;
+
+// Writes the result of a SYMBOLIZER_LOOKUP_ADDRESSES request for frame, in
+// which the resolver found what inlined_frames holds inlined, to writer.
+// Unset bases in frame are kSymbolizerNoAddress.
+void WriteLookupResult(const StackFrame &frame,
+                       const std::vector<StackFrame*> &inlined_frames,
+                       SymbolizerMessageWriter *writer) {
+  uint8_t flags = 0;
+  if (frame.function_base != kSymbolizerNoAddress)
+    flags |= SYMBOLIZER_HAS_FUNCTION;
+  if (frame.source_line_base != kSymbolizerNoAddress)
+    flags |= SYMBOLIZER_HAS_LINE;
+  writer->WriteUInt8(flags);
+  if (flags & SYMBOLIZER_HAS_FUNCTION) {
+    writer->WriteString(frame.function_name);
+    writer->WriteUInt64(frame.function_base);
+  }
+  if (flags & SYMBOLIZER_HAS_LINE) {
+    writer->WriteString(frame.source_file_name);
+    writer->WriteUInt32(frame.source_line);
+    writer->WriteUInt64(frame.source_line_base);
+  }
+
+  writer->WriteUInt32(inlined_frames.size());
+  for (size_t i = 0; i < inlined_frames.size(); ++i) {
+    const StackFrame *inlined_frame = inlined_frames[i];
+    writer->WriteString(inlined_frame->function_name);
+    writer->WriteUInt64(inlined_frame->function_base);
+    writer->WriteString(inlined_frame->source_file_name);
+    writer->WriteUInt32(inlined_frame->source_line);
+    writer->WriteUInt64(inlined_frame->source_line_base);
+  }
+}
+
+}  // namespace
+
+SymbolizerServer::SymbolizerServer(SymbolSupplier *supplier,
+                                   SourceLineResolverInterface *resolver)
+    : supplier_(supplier),
+      resolver_(resolver),
+      missing_symbols_ttl_(kDefaultMissingSymbolsTTL),
+      max_response_size_(kSymbolizerMaxMessageSize),
+      connections_(0) { }
+
+bool SymbolizerServer::Serve(int listen_fd, int max_connections) {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(connection_mutex_);
+      while (connections_ >= max_connections)
+        connection_done_.wait(lock);
+    }
+    int fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      BPLOG(ERROR) << "accept failed: " << strerror(errno);
+      return false;
+    }
+    {
+      std::lock_guard<std::mutex> lock(connection_mutex_);
+      ++connections_;
+    }
+    std::thread(&SymbolizerServer::ServeCountedConnection, this, fd).detach();
+  }
+}
+
+void SymbolizerServer::ServeCountedConnection(int fd) {
+  ServeConnection(fd);
+  std::lock_guard<std::mutex> lock(connection_mutex_);
+  --connections_;
+  connection_done_.notify_one();
+}
+
+void SymbolizerServer::ServeConnection(int fd) {
+  string request, response;
+  while (ReadSymbolizerMessage(fd, &request)) {
+    if (!HandleRequest(request, &response)) {
+      BPLOG(ERROR) << "Malformed symbolizer request";
+      break;
+    }
+    if (!WriteSymbolizerMessage(fd, response))
+      break;
+  }
+  close(fd);
+}
+
+bool SymbolizerServer::HandleRequest(const string &request, string *response) {
+  SymbolizerMessageReader reader(request);
+  uint8_t operation;
+  if (!reader.ReadUInt8(&operation))
+    return false;
+  scoped_ptr<BasicCodeModule> module(reader.ReadModule());
+  if (!module.get())
+    return false;
+
+  // Keep the module loaded until its results are written, even if other
+  // connections load enough to exceed the resolver's cache budget.
+  resolver_->PinModule(module.get());
+  SymbolizerMessageWriter writer;
+  SymbolizerLoadStatus status = LoadModule(module.get());
+  writer.WriteUInt8(status);
+  writer.WriteUInt8(status == SYMBOLIZER_LOADED &&
+                    resolver_->IsModuleCorrupt(module.get()));
+
+  bool well_formed;
+  switch (operation) {
+    case SYMBOLIZER_LOAD_MODULE:
+      well_formed = true;
+      break;
+    case SYMBOLIZER_LOOKUP_ADDRESSES:
+      well_formed = status != SYMBOLIZER_LOADED ||
+                    LookupAddresses(module.get(), &reader, &writer);
+      break;
+    case SYMBOLIZER_FIND_CFI_FRAME_INFO:
+      well_formed = status != SYMBOLIZER_LOADED ||
+                    FindCFIFrameInfo(module.get(), &reader, &writer);
+      break;
+    case SYMBOLIZER_FIND_WINDOWS_FRAME_INFO:
+      well_formed = status != SYMBOLIZER_LOADED ||
+                    FindWindowsFrameInfo(module.get(), &reader, &writer);
+      break;
+    default:
+      well_formed = false;
+      break;
+  }
+  resolver_->UnpinModule(module.get());
+
+  // Without symbols, the rest of the request goes unread.
+  if (!well_formed || (status == SYMBOLIZER_LOADED && !reader.AtEnd()))
+    return false;
+  *response = writer.message();
+  return true;
+}
+
+SymbolizerLoadStatus SymbolizerServer::LoadModule(const CodeModule *module) {
+  if (resolver_->HasModule(module))
+    return SYMBOLIZER_LOADED;
+  if (!supplier_)
+    return SYMBOLIZER_NOT_FOUND;
+  string key = resolver_->ModuleKey(module);
+  if (IsMissingSymbols(key))
+    return SYMBOLIZER_NOT_FOUND;
+
+  const string &code_file = module->code_file();
+  ModuleLoad *load = AcquireModuleLoad(code_file);
+  SymbolizerLoadStatus status;
+  {
+    std::lock_guard<std::mutex> lock(load->mutex);
+    // Another connection may have loaded the module, or found it missing,
+    // while this one waited.
+    if (resolver_->HasModule(module))
+      status = SYMBOLIZER_LOADED;
+    else if (IsMissingSymbols(key))
+      status = SYMBOLIZER_NOT_FOUND;
+    else
+      status = LoadModuleSymbols(module);
+  }
+  ReleaseModuleLoad(code_file);
+  return status;
+}
+
+SymbolizerLoadStatus SymbolizerServer::LoadModuleSymbols(
+    const CodeModule *module) {
+  string symbol_file;
+  char *symbol_data = NULL;
+  size_t symbol_data_size;
+  SymbolSupplier::SymbolResult symbol_result;
+  {
+    std::lock_guard<std::mutex> lock(supplier_mutex_);
+    symbol_result = supplier_->GetCStringSymbolData(
+        module, NULL, &symbol_file, &symbol_data, &symbol_data_size);
+  }
+  switch (symbol_result) {
+    case SymbolSupplier::FOUND: {
+      bool load_success = resolver_->LoadModuleUsingMemoryBuffer(
+          module, symbol_data, symbol_data_size);
+      if (resolver_->ShouldDeleteMemoryBufferAfterLoadModule()) {
+        std::lock_guard<std::mutex> lock(supplier_mutex_);
+        supplier_->FreeSymbolData(module);
+      }
+      if (!load_success) {
+        BPLOG(ERROR) << "Failed to load symbol file " << symbol_file;
+        SetMissingSymbols(resolver_->ModuleKey(module));
+        return SYMBOLIZER_NOT_FOUND;
+      }
+      return SYMBOLIZER_LOADED;
+    }
+
+    case SymbolSupplier::NOT_FOUND:
+      SetMissingSymbols(resolver_->ModuleKey(module));
+      return SYMBOLIZER_NOT_FOUND;
+
+    case SymbolSupplier::INTERRUPT:
+      return SYMBOLIZER_INTERRUPTED;
+
+    default:
+      BPLOG(ERROR) << "Unknown SymbolResult enum: " << symbol_result;
+      return SYMBOLIZER_NOT_FOUND;
+  }
+}
+
+SymbolizerServer::ModuleLoad *SymbolizerServer::AcquireModuleLoad(
+    const string &code_file) {
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  ModuleLoad *&load = module_loads_[code_file];
+  if (!load)
+    load = new ModuleLoad();
+  ++load->users;
+  return load;
+}
+
+void SymbolizerServer::ReleaseModuleLoad(const string &code_file) {
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  ModuleLoadMap::iterator it = module_loads_.find(code_file);
+  if (it != module_loads_.end() && --it->second->users == 0) {
+    delete it->second;
+    module_loads_.erase(it);
+  }
+}
+
+bool SymbolizerServer::IsMissingSymbols(const string &key) {
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  std::map<string, std::chrono::steady_clock::time_point>::iterator it =
+      missing_symbols_.find(key);
+  if (it == missing_symbols_.end())
+    return false;
+  if (it->second > std::chrono::steady_clock::now())
+    return true;
+  missing_symbols_.erase(it);
+  return false;
+}
+
+void SymbolizerServer::SetMissingSymbols(const string &key) {
+  if (missing_symbols_ttl_ <= 0)
+    return;
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  if (missing_symbols_.size() >= kMaxMissingSymbols) {
+    std::map<string, std::chrono::steady_clock::time_point>::iterator it =
+        missing_symbols_.begin();
+    while (it != missing_symbols_.end()) {
+      if (it->second <= now)
+        missing_symbols_.erase(it++);
+      else
+        ++it;
+    }
+    if (missing_symbols_.size() >= kMaxMissingSymbols)
+      missing_symbols_.clear();
+  }
+  missing_symbols_[key] = now + std::chrono::seconds(missing_symbols_ttl_);
+}
+
+bool SymbolizerServer::LookupAddresses(const CodeModule *module,
+                                       SymbolizerMessageReader *reader,
+                                       SymbolizerMessageWriter *writer) {
+  uint32_t count;
+  if (!reader->ReadUInt32(&count))
+    return false;
+  // Each address takes 8 bytes of the request, which bounds count before
+  // frames are allocated for it.
+  if (count > kSymbolizerMaxMessageSize / sizeof(uint64_t))
+    return false;
+
+  // The bases tell whether the resolver found a function and a line.
+  std::vector<StackFrame> frames(count);
+  std::vector<StackFrame*> frame_pointers(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    if (!reader->ReadUInt64(&frames[i].instruction))
+      return false;
+    frames[i].module = module;
+    frames[i].function_base = kSymbolizerNoAddress;
+    frames[i].source_line_base = kSymbolizerNoAddress;
+    frame_pointers[i] = &frames[i];
+  }
+  std::vector<std::vector<StackFrame*> > inlined_frames;
+  resolver_->FillSourceLineInfo(module, frame_pointers, &inlined_frames);
+
+  // The results go in for as many addresses as fit.  The first always
+  // does, without its names if need be, so that the client gets on.
+  SymbolizerMessageWriter results;
+  uint32_t answered = 0;
+  bool full = false;
+  for (uint32_t i = 0; i < count; ++i) {
+    if (!full) {
+      SymbolizerMessageWriter result;
+      WriteLookupResult(frames[i], inlined_frames[i], &result);
+      if (writer->message().size() + sizeof(uint32_t) +
+              results.message().size() + result.message().size() >
+          max_response_size_) {
+        if (answered > 0) {
+          full = true;
+        } else {
+          result = SymbolizerMessageWriter();
+          result.WriteUInt8(0);
+          result.WriteUInt32(0);
+        }
+      }
+      if (!full) {
+        results.WriteMessage(result);
+        ++answered;
+      }
+    }
+    for (size_t j = 0; j < inlined_frames[i].size(); ++j)
+      delete inlined_frames[i][j];
+  }
+  writer->WriteUInt32(answered);
+  writer->WriteMessage(results);
+  return true;
+}
+
+bool SymbolizerServer::FindCFIFrameInfo(const CodeModule *module,
+                                        SymbolizerMessageReader *reader,
+                                        SymbolizerMessageWriter *writer) {
+  StackFrame frame;
+  if (!reader->ReadUInt64(&frame.instruction))
+    return false;
+  frame.module = module;
+  scoped_ptr<CFIFrameInfo> cfi_frame_info(resolver_->FindCFIFrameInfo(&frame));
+  writer->WriteUInt8(cfi_frame_info.get() != NULL);
+  if (cfi_frame_info.get())
+    writer->WriteString(cfi_frame_info->Serialize());
+  return true;
+}
+
+bool SymbolizerServer::FindWindowsFrameInfo(const CodeModule *module,
+                                            SymbolizerMessageReader *reader,
+                                            SymbolizerMessageWriter *writer) {
+  StackFrame frame;
+  if (!reader->ReadUInt64(&frame.instruction))
+    return false;
+  frame.module = module;
+  scoped_ptr<WindowsFrameInfo> frame_info(
+      resolver_->FindWindowsFrameInfo(&frame));
+  writer->WriteUInt8(frame_info.get() != NULL);
+  if (frame_info.get()) {
+    writer->WriteUInt32(frame_info->type_);
+    writer->WriteUInt32(frame_info->valid);
+    writer->WriteUInt32(frame_info->prolog_size);
+    writer->WriteUInt32(frame_info->epilog_size);
+    writer->WriteUInt32(frame_info->parameter_size);
+    writer->WriteUInt32(frame_info->saved_register_size);
+    writer->WriteUInt32(frame_info->local_size);
+    writer->WriteUInt32(frame_info->max_stack_size);
+    writer->WriteUInt8(frame_info->allocates_base_pointer);
+    writer->WriteString(frame_info->program_string);
+  }
+  return true;
+}
+
+}  // namespace google_breakpad
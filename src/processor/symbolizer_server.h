@@ -0,0 +1,174 @@
+// Copyright (c) 2024 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// symbolizer_server.h: SymbolizerServer answers the requests of
+// RemoteSourceLineResolver clients from one shared set of loaded symbols.
+//
+// Processing each minidump in a new process means loading the symbols of
+// every module it mentions again, which for large modules costs far more
+// than walking the stacks.  breakpad_symbolizer keeps a SymbolizerServer
+// running instead, so that symbols loaded for one dump serve every later
+// dump that needs them, within the resolver's module cache budget.
+
+#ifndef PROCESSOR_SYMBOLIZER_SERVER_H__
+#define PROCESSOR_SYMBOLIZER_SERVER_H__
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "common/using_std_string.h"
+#include "processor/symbolizer_protocol.h"
+
+namespace google_breakpad {
+
+class SourceLineResolverInterface;
+class SymbolizerMessageReader;
+class SymbolSupplier;
+
+class SymbolizerServer {
+ public:
+  // Answers requests from the symbols supplier provides, loaded into
+  // resolver.  supplier may be NULL if resolver already holds every module
+  // clients will ask about.  Neither is owned.  resolver must be safe to
+  // use from several threads, as SourceLineResolverBase-derived resolvers
+  // are, if more than one connection is served at a time.  Clients
+  // of different builds of a module get the right symbols only if
+  // resolver keys modules by debug identifier; see
+  // SourceLineResolverBase::set_key_by_debug_identifier.
+  SymbolizerServer(SymbolSupplier *supplier,
+                   SourceLineResolverInterface *resolver);
+
+  static const int kDefaultMaxConnections = 64;
+  static const int kDefaultMissingSymbolsTTL = 60;
+
+  // Accepts connections on the listening socket listen_fd, serving each on
+  // a thread of its own, until accepting fails.  Returns false then.  At
+  // most max_connections are served at once; further clients wait in the
+  // listen backlog until one disconnects.  The SymbolizerServer must
+  // outlive every connection.
+  bool Serve(int listen_fd, int max_connections = kDefaultMaxConnections);
+
+  // Sets how many seconds a module whose symbols could not be found is
+  // answered as missing without asking the supplier again.  Symbols added
+  // to the store meanwhile are found once that time has passed.  0 asks
+  // the supplier on every request.
+  void set_missing_symbols_ttl(int seconds) { missing_symbols_ttl_ = seconds; }
+
+  // Sets the size beyond which a response to an address lookup is cut
+  // short, leaving the client to ask again for the addresses it left out.
+  // The default, and the largest size clients accept, is
+  // kSymbolizerMaxMessageSize.
+  void set_max_response_size(size_t size) { max_response_size_ = size; }
+
+  // Answers requests arriving on the connected socket fd until the client
+  // disconnects or sends a malformed request, then closes fd.
+  void ServeConnection(int fd);
+
+  // Answers the single request message in request, setting *response.
+  // Returns false if the request is malformed.
+  bool HandleRequest(const string &request, string *response);
+
+ private:
+  // Loads module's symbols into the resolver if they are not loaded yet.
+  SymbolizerLoadStatus LoadModule(const CodeModule *module);
+
+  // Fetches module's symbols from the supplier and loads them.  Must be
+  // called with the load mutex for the module's code file held.
+  SymbolizerLoadStatus LoadModuleSymbols(const CodeModule *module);
+
+  // Serves fd as ServeConnection does, then lets Serve accept another
+  // connection.
+  void ServeCountedConnection(int fd);
+
+  // Read the rest of a request about the loaded module from reader and
+  // write the results to writer, returning false if it is malformed.
+  bool LookupAddresses(const CodeModule *module,
+                       SymbolizerMessageReader *reader,
+                       SymbolizerMessageWriter *writer);
+  bool FindCFIFrameInfo(const CodeModule *module,
+                        SymbolizerMessageReader *reader,
+                        SymbolizerMessageWriter *writer);
+  bool FindWindowsFrameInfo(const CodeModule *module,
+                            SymbolizerMessageReader *reader,
+                            SymbolizerMessageWriter *writer);
+
+  SymbolSupplier *supplier_;
+  SourceLineResolverInterface *resolver_;
+
+  // Each module is loaded by one connection while the others asking for
+  // it wait; lookups into loaded modules, and loads of other modules, go
+  // on meanwhile.  As in StackFrameSymbolizer, loads are serialized by
+  // code file, because symbol suppliers keep the data they hand out by
+  // code file until it is freed.
+  struct ModuleLoad {
+    ModuleLoad() : users(0) {}
+    std::mutex mutex;
+    // Number of connections using this ModuleLoad.
+    int users;
+  };
+  typedef std::map<string, ModuleLoad*> ModuleLoadMap;
+
+  // Returns the ModuleLoad for code_file, creating it if need be.  Every
+  // call must be matched by one to ReleaseModuleLoad().
+  ModuleLoad *AcquireModuleLoad(const string &code_file);
+  void ReleaseModuleLoad(const string &code_file);
+
+  // Returns true if key, a resolver ModuleKey(), was found to have no
+  // symbols less than missing_symbols_ttl_ seconds ago.
+  bool IsMissingSymbols(const string &key);
+  void SetMissingSymbols(const string &key);
+
+  // Guards module_loads_ and missing_symbols_.
+  std::mutex state_mutex_;
+  ModuleLoadMap module_loads_;
+  // The time after which each module found missing is asked for again.
+  std::map<string, std::chrono::steady_clock::time_point> missing_symbols_;
+  int missing_symbols_ttl_;
+
+  size_t max_response_size_;
+
+  // The symbol supplier is not assumed to be thread-safe.
+  std::mutex supplier_mutex_;
+
+  // Guards connections_, the number of connections being served.
+  std::mutex connection_mutex_;
+  std::condition_variable connection_done_;
+  int connections_;
+
+  // Disallow copy constructor and assignment operator.
+  SymbolizerServer(const SymbolizerServer &that);
+  void operator=(const SymbolizerServer &that);
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_SYMBOLIZER_SERVER_H__
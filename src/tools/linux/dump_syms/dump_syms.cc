@@ -29,6 +29,7 @@
 
 #include <paths.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 
 #include <cstring>
@@ -47,9 +48,12 @@ int usage(const char* self) {
   fprintf(stderr, "Options:\n");
   fprintf(stderr, "  -i:         Output module header information only.\n");
   fprintf(stderr, "  -c          Do not generate CFI section\n");
+  fprintf(stderr, "  -d          Generate INLINE and INLINE_ORIGIN records\n");
   fprintf(stderr, "  -r          Do not handle inter-compilation "
                                  "unit references\n");
   fprintf(stderr, "  -v          Print all warnings to stderr\n");
+  fprintf(stderr, "  -j <n>      Process compilation units on <n> "
+                                 "threads concurrently\n");
   fprintf(stderr, "  -n <name>   Use specified name for name of the object\n");
   fprintf(stderr, "  -o <os>     Use specified name for the "
                                  "operating system\n");
@@ -61,8 +65,10 @@ int main(int argc, char **argv) {
     return usage(argv[0]);
   bool header_only = false;
   bool cfi = true;
+  bool inlines = false;
   bool handle_inter_cu_refs = true;
   bool log_to_stderr = false;
+  int threads = 1;
   std::string obj_name;
   const char* obj_os = "Linux";
   int arg_index = 1;
@@ -72,6 +78,8 @@ int main(int argc, char **argv) {
       header_only = true;
     } else if (strcmp("-c", argv[arg_index]) == 0) {
       cfi = false;
+    } else if (strcmp("-d", argv[arg_index]) == 0) {
+      inlines = true;
     } else if (strcmp("-r", argv[arg_index]) == 0) {
       handle_inter_cu_refs = false;
     } else if (strcmp("-v", argv[arg_index]) == 0) {
@@ -90,6 +98,17 @@ int main(int argc, char **argv) {
       }
       obj_os = argv[arg_index + 1];
       ++arg_index;
+    } else if (strcmp("-j", argv[arg_index]) == 0) {
+      if (arg_index + 1 >= argc) {
+        fprintf(stderr, "Missing argument to -j\n");
+        return usage(argv[0]);
+      }
+      threads = atoi(argv[arg_index + 1]);
+      if (threads < 1) {
+        fprintf(stderr, "Invalid thread count: %s\n", argv[arg_index + 1]);
+        return usage(argv[0]);
+      }
+      ++arg_index;
     } else {
       printf("2.4 %s\n", argv[arg_index]);
       return usage(argv[0]);
@@ -126,6 +145,8 @@ int main(int argc, char **argv) {
   } else {
     SymbolData symbol_data = cfi ? ALL_SYMBOL_DATA : NO_CFI;
     google_breakpad::DumpOptions options(symbol_data, handle_inter_cu_refs);
+    options.threads = threads;
+    options.inlines = inlines;
     if (!WriteSymbolFile(binary, obj_name, obj_os, debug_dirs, options,
                          std::cout)) {
       fprintf(saved_stderr, "Failed to write symbol file.\n");